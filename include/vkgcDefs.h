@@ -47,7 +47,7 @@
 #define LLPC_INTERFACE_MAJOR_VERSION 52
 
 /// LLPC minor interface version.
-#define LLPC_INTERFACE_MINOR_VERSION 1
+#define LLPC_INTERFACE_MINOR_VERSION 17
 
 #ifndef LLPC_CLIENT_INTERFACE_MAJOR_VERSION
 #if VFX_INSIDE_SPVGEN
@@ -86,6 +86,22 @@
 //  %Version History
 //  | %Version | Change Description                                                                                    |
 //  | -------- | ----------------------------------------------------------------------------------------------------- |
+//  |    52.17 | Add useDeviceIndex to ShaderModuleUsage                                                               |
+//  |    52.16 | Add NggSubgroupSizingType::Adaptive, and add vertsPerPrimHint to NggState                             |
+//  |    52.15 | Add fastCompile to PipelineOptions                                                                    |
+//  |    52.14 | Add BuildComputePipelineWithLibraries to ICompiler, and isLibrary to SpirvModuleSummary               |
+//  |    52.13 | Add BuildGraphicsPipelineOptimizeLater to ICompiler                                                   |
+//  |    52.12 | Add BuildGraphicsPipelineLibrary and LinkGraphicsPipelineLibraries to ICompiler                      |
+//  |    52.11 | Add the priority parameter to BuildGraphicsPipelineAsync and BuildComputePipelineAsync               |
+//  |    52.10 | Add EstimatePipelineCost to ICompiler                                                                 |
+//  |     52.9 | Add peakMemoryGrowth to GraphicsPipelineBuildOut and ComputePipelineBuildOut                          |
+//  |     52.8 | Add groupWaterfallLoops to PipelineOptions                                                            |
+//  |     52.7 | Add mathPrecision to PipelineShaderOptions                                                            |
+//  |     52.6 | Add waveSizeHeuristic to PipelineOptions                                                              |
+//  |     52.5 | Add enableCullingHints, primsPerDrawHint and culledPrimPercentHint to NggState                        |
+//  |     52.4 | Add PrecompileGlueShaders to ICompiler                                                                |
+//  |     52.3 | Add GetEntries to ICache                                                                              |
+//  |     52.2 | Add BuildGraphicsPipelineAsync and BuildComputePipelineAsync to ICompiler                             |
 //  |     52.1 | Add pageMigrationEnabled to PipelineOptions                                                           |
 //  |     52.0 | Add the member word4 and word5 to SamplerYCbCrConversionMetaData                                      |
 //  |     50.2 | Add the member dsState to GraphicsPipelineBuildInfo                                                   |
@@ -155,6 +171,8 @@ static const unsigned MaxVertexAttribs = 64;
 static const unsigned MaxColorTargets = 8;
 static const unsigned FetchShaderInternalBufferBinding = 5;
 static const unsigned MaxFetchShaderInternalBufferSize = 16 * MaxVertexAttribs;
+static const unsigned ShaderProfileBufferBinding = 6; ///< Binding of the shader profile buffer (-shader-profile)
+static const unsigned MaxSpirvSummaryEntryPoints = 16;
 
 // Forward declarations
 class IShaderCache;
@@ -360,6 +378,14 @@ enum class ShadowDescriptorTableUsage : unsigned {
   Disable = 2,
 };
 
+/// Values for waveSizeHeuristic pipeline option.
+enum class WaveSizeHeuristic : unsigned {
+  Disable = 0, ///< Use the fixed per-stage default wave sizes
+  Auto,        ///< Pick wave sizes from shader analysis, with the tuning table of the target GFXIP
+  Gfx10,       ///< Pick wave sizes from shader analysis, with the GFX10.1 tuning table
+  Gfx103,      ///< Pick wave sizes from shader analysis, with the GFX10.3 tuning table
+};
+
 /// Represents the features of VK_EXT_robustness2
 struct ExtendedRobustness {
   bool robustBufferAccess; ///< Whether buffer accesses are tightly bounds-checked against the range of the descriptor.
@@ -403,6 +429,10 @@ struct PipelineOptions {
   bool reserved1f;                                       /// Reserved for future functionality
   bool enableInterpModePatch; ///< If set, per-sample interpolation for nonperspective and smooth input is enabled
   bool pageMigrationEnabled;  ///< If set, page migration is enabled
+  WaveSizeHeuristic waveSizeHeuristic; ///< Heuristic to pick the wave size of shaders without an explicit wave size
+  bool groupWaterfallLoops;            ///< Non-uniform descriptor accesses sharing an index share a waterfall loop
+  bool fastCompile;                    ///< If set, compile with the fast tier, which runs few optimization passes and
+                                       ///  does codegen at -O1, for a quick first build of the pipeline
 };
 
 /// Prototype of allocator for output data buffer, used in shader-specific operations.
@@ -445,6 +475,31 @@ struct ShaderModuleUsage {
   bool keepUnusedFunctions;    ///< Whether to keep unused function
   bool useIsNan;               ///< Whether IsNan is used
   bool useInvariant;           ///< Whether invariant variable is used
+  bool useDeviceIndex;         ///< Whether gl_DeviceIndex is used
+};
+
+/// Represents the information of one entry-point in SpirvModuleSummary
+struct SpirvEntryPointSummary {
+  ShaderStage stage;   ///< Shader stage
+  unsigned nameOffset; ///< Byte offset of the nul-terminated entry name in the binCode of ShaderModuleData
+};
+
+/// Represents the summary of a SPIR-V shader module, collected in the single scan of its binary when the shader module
+/// is built, so that pipeline builds using the module do not need to scan the binary again
+struct SpirvModuleSummary {
+  unsigned idBound;           ///< Bound of the SPIR-V ids, from the module header; 0 if there is no summary
+  unsigned stageMask;         ///< Mask of the shader stages of all entry-points
+  unsigned debugInfoSize;     ///< Byte size of the debug instructions in the original binary
+  bool specConstPlaceholders; ///< Whether the specialization constants can be translated as placeholders
+  unsigned entryPointCount;   ///< Count of entry-points, or UINT32_MAX if there are too many to record
+  /// Entry-points of the module
+  SpirvEntryPointSummary entryPoints[MaxSpirvSummaryEntryPoints];
+  unsigned instructionCount; ///< Count of the instructions in function bodies
+  unsigned functionCount;    ///< Count of the functions
+  unsigned loopCount;        ///< Count of the structured loops (loop merge instructions)
+  bool isLibrary;            ///< Whether the module is a library of functions for other shaders to call: it has the
+                             ///  Linkage capability and no entry-points
+  uint64_t descriptorSetMask; ///< Mask of the descriptor sets below 64 that variables of the module are decorated with
 };
 
 /// Represents common part of shader module data
@@ -466,11 +521,12 @@ struct FsOutInfo {
 
 /// Represents extended output of building a shader module (taking extra data info)
 struct ShaderModuleDataEx {
-  ShaderModuleData common;  ///< Shader module common data
-  unsigned codeOffset;      ///< Binary offset of binCode in ShaderModuleDataEx
-  unsigned entryOffset;     ///< Shader entry offset in ShaderModuleDataEx
-  unsigned resNodeOffset;   ///< Resource node offset in ShaderModuleDataEX
-  unsigned fsOutInfoOffset; ///< FsOutInfo offset in ShaderModuleDataEX
+  ShaderModuleData common;         ///< Shader module common data
+  unsigned codeOffset;             ///< Binary offset of binCode in ShaderModuleDataEx
+  unsigned entryOffset;            ///< Shader entry offset in ShaderModuleDataEx
+  unsigned resNodeOffset;          ///< Resource node offset in ShaderModuleDataEX
+  unsigned fsOutInfoOffset;        ///< FsOutInfo offset in ShaderModuleDataEX
+  SpirvModuleSummary spirvSummary; ///< Summary of the SPIR-V binary, if binType is BinaryType::Spirv
   struct {
     unsigned fsOutInfoCount;             ///< Count of fragment shader output
     const FsOutInfo *pFsOutInfos;        ///< Fragment output info array
@@ -486,6 +542,8 @@ struct PipelineDumpOptions {
   uint64_t filterPipelineDumpByHash; ///< Only dump the pipeline with this compiler hash if non-zero
   bool dumpDuplicatePipelines;       ///< If TRUE, duplicate pipelines will be dumped to a file with a
                                      ///  numeric suffix attached
+  bool dumpPipelineInfoBinary;       ///< If TRUE, the pipeline build info is also dumped, with its SPIR-V, in a
+                                     ///  binary encoding (.pipebin) that amdllpc reads without parsing
 };
 
 /// Enumerate denormal override modes.
@@ -495,6 +553,13 @@ enum class DenormalMode : unsigned {
   Preserve = 0x2,    ///< Denormals preserved
 };
 
+/// Enumerate precision tiers of the expansions of transcendental operations.
+enum class MathPrecision : unsigned {
+  Strict = 0, ///< The default expansions
+  Relaxed,    ///< Shorter polynomials, and native exp/log in place of the range handling of some expansions
+  Fast,       ///< Shortest approximations, and 16-bit math for operations decorated RelaxedPrecision
+};
+
 /// If next available quad falls outside tile aligned region of size defined by this enumeration the SC will force end
 /// of vector in the SC to shader wavefront.
 enum class WaveBreakSize : unsigned {
@@ -514,6 +579,8 @@ enum class NggSubgroupSizingType : unsigned {
   OptimizeForPrims, ///< Sub-group size is optimized for primitive thread utilization
   Explicit,         ///< Sub-group size is allocated based on explicitly-specified vertsPerSubgroup and
                     ///  primsPerSubgroup
+  Adaptive,         ///< Sub-group size is allocated from the measured vertex reuse given by vertsPerPrimHint, or as
+                    ///  Auto if that is not measured
 };
 
 /// Enumerates compaction modes after culling operations for NGG primitive shader.
@@ -550,6 +617,17 @@ struct NggState {
                              ///  sub-group
 
   unsigned vertsPerSubgroup; ///< Preferred number of vertices consumed by a primitive shader sub-group
+
+  /// Following fields are measured per-pipeline hints, used to turn off the cullers (and compaction) that do not
+  /// pay for themselves. They never enable a culler that is not enabled above. The measured values should be coarse
+  /// (e.g. rounded to a power of two or to 10%), as they are part of the pipeline cache hash.
+  bool enableCullingHints;        ///< Use the hints below to select the cullers and compaction
+  unsigned primsPerDrawHint;      ///< Measured average number of primitives per draw, 0 if not measured
+  unsigned culledPrimPercentHint; ///< Measured percentage of primitives that are culled (0 to 100), a value above
+                                  ///  100 if not measured
+  unsigned vertsPerPrimHint;      ///< Measured average number of distinct vertices per primitive, in hundredths (so
+                                  ///  50 for a mesh in which each vertex is shared by six triangles), 0 if not
+                                  ///  measured. Used by NggSubgroupSizingType::Adaptive.
 };
 
 /// ShaderHash represents a 128-bit client-specified hash key which uniquely identifies a shader program.
@@ -646,6 +724,9 @@ struct PipelineShaderOptions {
 
   ///< Whether fastmath contract could be disabled
   bool noContract;
+
+  /// Precision tier of the expansions of transcendental operations.
+  MathPrecision mathPrecision;
 };
 
 /// Represents YCbCr sampler meta data in resource descriptor
@@ -982,6 +1063,20 @@ public:
   ///   * ErrorXxx: some internal error has occurred, no handle is returned
   LLPC_NODISCARD virtual Result GetEntry(HashId hash, bool allocateOnMiss, EntryHandle *pHandle) = 0;
 
+  /// \brief Obtain the cache entries for a list of hashes in one request.
+  ///
+  /// The semantics are identical to calling \ref GetEntry for each hash in order, but an implementation that is
+  /// backed by a slow store (e.g. disk or network) can look all of the entries up in one round trip. LLPC uses this to
+  /// request all of the entries needed by a pipeline at once. The default implementation calls GetEntry for each hash.
+  ///
+  /// @param pHashes : The hash keys for the cache entries
+  /// @param hashCount : The number of hash keys
+  /// @param allocateOnMiss : If true, a new cache entry will be allocated for each hash for which none is found
+  /// @param pHandles : Array of hashCount handles, each filled as by GetEntry
+  /// @param pResults : Array of hashCount success codes, each set to what GetEntry would return
+  virtual void GetEntries(const HashId *pHashes, unsigned hashCount, bool allocateOnMiss, EntryHandle *pHandles,
+                          Result *pResults);
+
   /// \brief Release ownership of a handle to a cache entry.
   ///
   /// If the handle owner is responsible for populating the cache entry, it is an error to call this
@@ -1162,4 +1257,12 @@ private:
   bool m_mustPopulate = false;
 };
 
+// =====================================================================================================================
+// Default implementation of ICache::GetEntries, which looks the hashes up one at a time.
+inline void ICache::GetEntries(const HashId *pHashes, unsigned hashCount, bool allocateOnMiss, EntryHandle *pHandles,
+                               Result *pResults) {
+  for (unsigned i = 0; i < hashCount; ++i)
+    pResults[i] = GetEntry(pHashes[i], allocateOnMiss, &pHandles[i]);
+}
+
 } // namespace Vkgc
@@ -281,12 +281,21 @@ Value *ArithBuilder::CreateASin(Value *x, const Twine &instName) {
     x = CreateFPExt(x, extTy);
   }
 
-  // atan2(x, y), y = sqrt(1 - x * x)
-  Value *y = CreateFMul(x, x);
-  Value *one = ConstantFP::get(x->getType(), 1.0);
-  y = CreateFSub(one, y);
-  y = CreateUnaryIntrinsic(Intrinsic::sqrt, y);
-  Value *result = CreateATan2(x, y);
+  Value *result = nullptr;
+  if (getMathPrecision() == MathPrecision::Strict) {
+    // atan2(x, y), y = sqrt(1 - x * x)
+    Value *y = CreateFMul(x, x);
+    Value *one = ConstantFP::get(x->getType(), 1.0);
+    y = CreateFSub(one, y);
+    y = CreateUnaryIntrinsic(Intrinsic::sqrt, y);
+    result = CreateATan2(x, y);
+  } else {
+    // asin(x) = PI/2 - acos(x), using the acos coefficients in the common code, which saves the division and the
+    // polynomial of atan2.
+    auto coefP0 = getFpConstant(x->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FB4D1B0E0000000)));
+    auto coefP1 = getFpConstant(x->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0xBF98334BE0000000)));
+    result = aSinACosCommon(x, coefP0, coefP1);
+  }
 
   result = CreateFPTrunc(result, origTy);
   result->setName(instName);
@@ -320,6 +329,17 @@ Value *ArithBuilder::CreateACos(Value *x, const Twine &instName) {
   return result;
 }
 
+// =====================================================================================================================
+// Get the precision tier of transcendental expansions for the current shader stage. Outside a shader stage, this is
+// the strict tier.
+//
+// @returns : The precision tier from the shader options
+MathPrecision ArithBuilder::getMathPrecision() {
+  if (m_shaderStage == ShaderStageInvalid)
+    return MathPrecision::Strict;
+  return getPipelineState()->getShaderOptions(m_shaderStage).mathPrecision;
+}
+
 // =====================================================================================================================
 // Common code for asin and acos
 //
@@ -354,11 +374,51 @@ Value *ArithBuilder::CreateATan(Value *yOverX, const Twine &instName) {
   // x = min(1.0, x) / max(1.0, x), make |x| <= 1.0
   Constant *zero = Constant::getNullValue(yOverX->getType());
   Constant *one = ConstantFP::get(yOverX->getType(), 1.0);
+  const MathPrecision precision = getMathPrecision();
 
   Value *absX = CreateUnaryIntrinsic(Intrinsic::fabs, yOverX);
   Value *max = CreateBinaryIntrinsic(Intrinsic::maxnum, absX, one);
   Value *min = CreateBinaryIntrinsic(Intrinsic::minnum, absX, one);
-  Value *boundedX = CreateFMul(min, CreateFDiv(one, max));
+  Value *boundedX = precision == MathPrecision::Fast ? fDivFast(min, max) : CreateFMul(min, CreateFDiv(one, max));
+  Value *partialResult = nullptr;
+
+  auto getCoef = [&](uint64_t bits) {
+    return getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, bits)));
+  };
+  if (precision == MathPrecision::Relaxed) {
+    // atan(x) = x * (c1 + x^2 * (c3 + x^2 * (c5 + x^2 * (c7 + x^2 * c9)))), with an error of at most 1.2e-5
+    // c1 = 0.999866, c3 = -0.3302995, c5 = 0.180141, c7 = -0.085133, c9 = 0.0208351
+    Value *square = CreateFMul(boundedX, boundedX);
+    Value *result = getCoef(0x3F9555CBE0000000);
+    result = CreateFAdd(CreateFMul(result, square), getCoef(0xBFB5CB46C0000000));
+    result = CreateFAdd(CreateFMul(result, square), getCoef(0x3FC70EDC40000000));
+    result = CreateFAdd(CreateFMul(result, square), getCoef(0xBFD523A080000000));
+    result = CreateFAdd(CreateFMul(result, square), getCoef(0x3FEFFEE700000000));
+    partialResult = CreateFMul(result, boundedX);
+  } else if (precision == MathPrecision::Fast) {
+    // atan(x) = PI/4 * x - x * (x - 1) * (0.2447 + 0.0663 * x), 0 <= x <= 1, with an error of at most 1.6e-3
+    Value *result = CreateFAdd(CreateFMul(getCoef(0x3FB0F90960000000), boundedX), getCoef(0x3FCF525460000000));
+    result = CreateFMul(result, CreateFMul(boundedX, CreateFSub(boundedX, one)));
+    partialResult = CreateFSub(CreateFMul(boundedX, getCoef(0x3FE921FB60000000)), result);
+  } else {
+    partialResult = aTanPolynomial(boundedX);
+  }
+
+  Value *result = CreateFMul(partialResult, ConstantFP::get(yOverX->getType(), -2.0));
+  result = CreateFAdd(result, getPiByTwo(yOverX->getType()));
+  Value *outsideBound = CreateSelect(CreateFCmpOGT(absX, one), one, zero);
+  result = CreateFMul(outsideBound, result);
+  result = CreateFAdd(partialResult, result);
+  return CreateFMul(result, CreateFSign(yOverX));
+}
+
+// =====================================================================================================================
+// The polynomial of the strict precision tier of atan, for |x| <= 1.0.
+//
+// @param boundedX : Input value X, with |x| <= 1.0
+// @returns : atan(x)
+Value *ArithBuilder::aTanPolynomial(Value *boundedX) {
+  Type *ty = boundedX->getType();
   Value *square = CreateFMul(boundedX, boundedX);
   Value *cube = CreateFMul(square, boundedX);
   Value *pow5 = CreateFMul(cube, square);
@@ -367,17 +427,17 @@ Value *ArithBuilder::CreateATan(Value *yOverX, const Twine &instName) {
   Value *pow11 = CreateFMul(pow9, square);
 
   // coef1 = 0.99997932
-  auto coef1 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FEFFFD4A0000000)));
+  auto coef1 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FEFFFD4A0000000)));
   // coef3 = -0.33267564
-  auto coef3 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0xBFD54A8EC0000000)));
+  auto coef3 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0xBFD54A8EC0000000)));
   // coef5 = 0.19389249
-  auto coef5 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FC8D17820000000)));
+  auto coef5 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FC8D17820000000)));
   // coef7 = -0.11735032
-  auto coef7 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0xBFBE0AABA0000000)));
+  auto coef7 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0xBFBE0AABA0000000)));
   // coef9 = 0.05368138
-  auto coef9 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FAB7C2020000000)));
+  auto coef9 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0x3FAB7C2020000000)));
   // coef11 = -0.01213232
-  auto coef11 = getFpConstant(yOverX->getType(), APFloat(APFloat::IEEEdouble(), APInt(64, 0xBF88D8D4A0000000)));
+  auto coef11 = getFpConstant(ty, APFloat(APFloat::IEEEdouble(), APInt(64, 0xBF88D8D4A0000000)));
 
   Value *term1 = CreateFMul(boundedX, coef1);
   Value *term3 = CreateFMul(cube, coef3);
@@ -390,13 +450,7 @@ Value *ArithBuilder::CreateATan(Value *yOverX, const Twine &instName) {
   result = CreateFAdd(result, term5);
   result = CreateFAdd(result, term7);
   result = CreateFAdd(result, term9);
-  Value *partialResult = CreateFAdd(result, term11);
-  result = CreateFMul(partialResult, ConstantFP::get(yOverX->getType(), -2.0));
-  result = CreateFAdd(result, getPiByTwo(yOverX->getType()));
-  Value *outsideBound = CreateSelect(CreateFCmpOGT(absX, one), one, zero);
-  result = CreateFMul(outsideBound, result);
-  result = CreateFAdd(partialResult, result);
-  return CreateFMul(result, CreateFSign(yOverX));
+  return CreateFAdd(result, term11);
 }
 
 // =====================================================================================================================
@@ -460,9 +514,17 @@ Value *ArithBuilder::CreateSinh(Value *x, const Twine &instName) {
   Constant *zero = Constant::getNullValue(x->getType());
   Constant *half = ConstantFP::get(x->getType(), 0.5);
   Value *divLog2 = CreateFMul(x, getRecipLog2(x->getType()));
-  Value *negDivLog2 = CreateFSub(zero, divLog2);
-  Value *exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
-  Value *expNeg = CreateUnaryIntrinsic(Intrinsic::exp2, negDivLog2);
+  Value *exp = nullptr;
+  Value *expNeg = nullptr;
+  if (getMathPrecision() == MathPrecision::Strict) {
+    Value *negDivLog2 = CreateFSub(zero, divLog2);
+    exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
+    expNeg = CreateUnaryIntrinsic(Intrinsic::exp2, negDivLog2);
+  } else {
+    // e^(-x) = 1 / e^x
+    exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
+    expNeg = fDivFast(ConstantFP::get(x->getType(), 1.0), exp);
+  }
   Value *result = CreateFSub(exp, expNeg);
   return CreateFMul(result, half, instName);
 }
@@ -478,9 +540,17 @@ Value *ArithBuilder::CreateCosh(Value *x, const Twine &instName) {
   // 1/log(2) = 1.442695
   // e^x = 2^(x*(1/log(2))) = 2^(x*1.442695))
   Value *divLog2 = CreateFMul(x, getRecipLog2(x->getType()));
-  Value *negDivLog2 = CreateFSub(ConstantFP::get(x->getType(), 0.0), divLog2);
-  Value *exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
-  Value *expNeg = CreateUnaryIntrinsic(Intrinsic::exp2, negDivLog2);
+  Value *exp = nullptr;
+  Value *expNeg = nullptr;
+  if (getMathPrecision() == MathPrecision::Strict) {
+    Value *negDivLog2 = CreateFSub(ConstantFP::get(x->getType(), 0.0), divLog2);
+    exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
+    expNeg = CreateUnaryIntrinsic(Intrinsic::exp2, negDivLog2);
+  } else {
+    // e^(-x) = 1 / e^x
+    exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
+    expNeg = fDivFast(ConstantFP::get(x->getType(), 1.0), exp);
+  }
   Value *result = CreateFAdd(exp, expNeg);
   return CreateFMul(result, ConstantFP::get(x->getType(), 0.5), instName);
 }
@@ -495,6 +565,14 @@ Value *ArithBuilder::CreateTanh(Value *x, const Twine &instName) {
   // (e^x - e^(-x))/(e^x + e^(-x))
   // 1/log(2) = 1.442695
   // e^x = 2^(x*(1/log(2))) = 2^(x*1.442695))
+  if (getMathPrecision() != MathPrecision::Strict) {
+    // tanh(x) = 1 - 2 / (e^(2x) + 1), which takes one exp2 and saturates to +-1 for large |x|
+    Constant *one = ConstantFP::get(x->getType(), 1.0);
+    Value *doubleDivLog2 = CreateFMul(x, CreateFMul(getRecipLog2(x->getType()), ConstantFP::get(x->getType(), 2.0)));
+    Value *exp = CreateUnaryIntrinsic(Intrinsic::exp2, doubleDivLog2);
+    Value *result = fDivFast(ConstantFP::get(x->getType(), 2.0), CreateFAdd(exp, one));
+    return CreateFSub(one, result, instName);
+  }
   Value *divLog2 = CreateFMul(x, getRecipLog2(x->getType()));
   Value *negDivLog2 = CreateFSub(ConstantFP::get(x->getType(), 0.0), divLog2);
   Value *exp = CreateUnaryIntrinsic(Intrinsic::exp2, divLog2);
@@ -573,8 +651,9 @@ Value *ArithBuilder::CreatePower(Value *x, Value *y, const Twine &instName) {
   if (x == ConstantFP::get(x->getType(), 2.0))
     return CreateUnaryIntrinsic(Intrinsic::exp2, y, nullptr, instName);
 
-  // llvm.pow only works with (vector of) float.
-  if (x->getType()->getScalarType()->isFloatTy())
+  // llvm.pow only works with (vector of) float. The relaxed and fast precision tiers use the expansion below, which is
+  // the native v_log and v_exp without the range handling of llvm.pow.
+  if (x->getType()->getScalarType()->isFloatTy() && getMathPrecision() == MathPrecision::Strict)
     return CreateBinaryIntrinsic(Intrinsic::pow, x, y, nullptr, instName);
 
   // pow(x, y) = exp2(y * log2(x))
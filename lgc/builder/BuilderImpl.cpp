@@ -31,6 +31,7 @@
 #include "BuilderImpl.h"
 #include "lgc/state/PipelineState.h"
 #include "lgc/state/TargetInfo.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/IntrinsicsAMDGPU.h"
 
 using namespace lgc;
@@ -318,9 +319,58 @@ BranchInst *BuilderImplBase::createIf(Value *condition, bool wantElse, const Twi
   return branch;
 }
 
+#if defined(LLVM_HAVE_BRANCH_AMD_GFX)
+// =====================================================================================================================
+// Find a waterfall loop that an instruction can join: the last waterfall loop before the instruction in its block, if
+// it is over the same indices, and no convergent operation other than the waterfall intrinsics of the loop is between
+// them. Everything from the start of the loop to the instruction then runs inside the loop, once for each lane.
+//
+// @param nonUniformInst : The instruction to put in a waterfall loop
+// @param nonUniformIndices : The waterfall indices that the instruction needs
+// @returns : The token of the last waterfall.begin of the loop to join, or nullptr if there is none
+static Value *findWaterfallLoopToJoin(Instruction *nonUniformInst, ArrayRef<Value *> nonUniformIndices) {
+  for (Instruction *inst = nonUniformInst->getPrevNode(); inst; inst = inst->getPrevNode()) {
+    if (auto intrinsic = dyn_cast<IntrinsicInst>(inst)) {
+      switch (intrinsic->getIntrinsicID()) {
+      case Intrinsic::amdgcn_waterfall_readfirstlane:
+      case Intrinsic::amdgcn_waterfall_last_use:
+      case Intrinsic::amdgcn_waterfall_end:
+        continue;
+      case Intrinsic::amdgcn_waterfall_begin: {
+        // This is the last begin of the loop. Check the indices of the whole chain of begins, ignoring the truncation
+        // of 64-bit indices.
+        Value *token = intrinsic;
+        for (unsigned idx = nonUniformIndices.size(); idx != 0; --idx) {
+          auto begin = dyn_cast<IntrinsicInst>(token);
+          if (!begin || begin->getIntrinsicID() != Intrinsic::amdgcn_waterfall_begin)
+            return nullptr;
+          Value *beginIndex = begin->getArgOperand(1);
+          if (auto trunc = dyn_cast<TruncInst>(beginIndex))
+            beginIndex = trunc->getOperand(0);
+          if (beginIndex != nonUniformIndices[idx - 1])
+            return nullptr;
+          token = begin->getArgOperand(0);
+        }
+        return isa<ConstantInt>(token) ? intrinsic : nullptr;
+      }
+      default:
+        break;
+      }
+    }
+    if (auto call = dyn_cast<CallBase>(inst)) {
+      if (call->isConvergent())
+        return nullptr;
+    }
+  }
+  return nullptr;
+}
+#endif
+
 // =====================================================================================================================
 // Create a waterfall loop containing the specified instruction.
 // This does not use the current insert point; new code is inserted before and after pNonUniformInst.
+// With the groupWaterfallLoops option, the instruction joins an earlier waterfall loop over the same indices in the
+// same block where it can, so accesses that share a non-uniform descriptor index use one loop.
 //
 // @param nonUniformInst : The instruction to put in a waterfall loop
 // @param operandIdxs : The operand index/indices for non-uniform inputs that need to be uniform
@@ -446,19 +496,25 @@ Instruction *BuilderImplBase::createWaterfallLoop(Instruction *nonUniformInst, A
   auto savedInsertPoint = saveIP();
   SetInsertPoint(nonUniformInst);
 
-  // For any index that is 64 bit, change it back to 32 bit for comparison at the top of the
-  // waterfall loop.
-  for (Value *&nonUniformVal : nonUniformIndices) {
-    if (nonUniformVal->getType()->isIntegerTy(64))
-      nonUniformVal = CreateTrunc(nonUniformVal, getInt32Ty());
-  }
+  Value *waterfallBegin = nullptr;
+  if (getPipelineState()->getOptions().groupWaterfallLoops)
+    waterfallBegin = findWaterfallLoopToJoin(nonUniformInst, nonUniformIndices);
+
+  if (!waterfallBegin) {
+    // For any index that is 64 bit, change it back to 32 bit for comparison at the top of the
+    // waterfall loop.
+    for (Value *&nonUniformVal : nonUniformIndices) {
+      if (nonUniformVal->getType()->isIntegerTy(64))
+        nonUniformVal = CreateTrunc(nonUniformVal, getInt32Ty());
+    }
 
-  // The first begin contains a null token for the previous token argument
-  Value *waterfallBegin = ConstantInt::get(getInt32Ty(), 0);
-  for (auto nonUniformVal : nonUniformIndices) {
-    // Start the waterfall loop using the waterfall index.
-    waterfallBegin = CreateIntrinsic(Intrinsic::amdgcn_waterfall_begin, nonUniformVal->getType(),
-                                     {waterfallBegin, nonUniformVal}, nullptr, instName);
+    // The first begin contains a null token for the previous token argument
+    waterfallBegin = ConstantInt::get(getInt32Ty(), 0);
+    for (auto nonUniformVal : nonUniformIndices) {
+      // Start the waterfall loop using the waterfall index.
+      waterfallBegin = CreateIntrinsic(Intrinsic::amdgcn_waterfall_begin, nonUniformVal->getType(),
+                                       {waterfallBegin, nonUniformVal}, nullptr, instName);
+    }
   }
 
   // Scalarize each non-uniform operand of the instruction.
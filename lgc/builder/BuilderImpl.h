@@ -226,6 +226,12 @@ private:
   ArithBuilder(const ArithBuilder &) = delete;
   ArithBuilder &operator=(const ArithBuilder &) = delete;
 
+  // Get the precision tier of transcendental expansions for the current shader stage
+  MathPrecision getMathPrecision();
+
+  // The polynomial of the strict precision tier of atan
+  llvm::Value *aTanPolynomial(llvm::Value *boundedX);
+
   // Common code for asin and acos
   llvm::Value *aSinACosCommon(llvm::Value *x, llvm::Constant *coefP0, llvm::Constant *coefP1);
 
@@ -323,6 +329,9 @@ private:
   llvm::Value *getDescPtr(ResourceNodeType resType, unsigned descSet, unsigned binding, const ResourceNode *topNode,
                           const ResourceNode *node);
 
+  // Get a pointer to the all-zero fmask descriptor for a multisampled image without an fmask
+  llvm::Value *getNullFmaskDesc();
+
   llvm::Value *scalarizeIfUniform(llvm::Value *value, bool isNonUniform);
 
   // Calculate a buffer descriptor for an inline buffer
@@ -640,6 +649,10 @@ public:
   llvm::Value *CreateCooperativeMatrixConstruct(llvm::Value *coopMatRow, llvm::Value *constVal,
                                                 const llvm::Twine &instName = "") override final;
 
+  // Create cooperative matrix multiply-add operation
+  llvm::Value *CreateCooperativeMatrixMulAdd(llvm::Value *matrixA, llvm::Value *matrixB, llvm::Value *matrixC,
+                                             bool isSigned, const llvm::Twine &instName = "") override final;
+
 private:
   MatrixBuilder() = delete;
   MatrixBuilder(const MatrixBuilder &) = delete;
@@ -827,6 +840,8 @@ private:
   unsigned getShaderWaveSize();
   llvm::Value *createGroupArithmeticIdentity(GroupArithOp groupArithOp, llvm::Type *const type);
   llvm::Value *createGroupArithmeticOperation(GroupArithOp groupArithOp, llvm::Value *const x, llvm::Value *const y);
+  llvm::Value *createClusteredReduction(GroupArithOp groupArithOp, llvm::Value *const value, unsigned clusterSize,
+                                        const llvm::Twine &instName);
   llvm::Value *createInlineAsmSideEffect(llvm::Value *const value);
   llvm::Value *createDppMov(llvm::Value *const value, DppCtrl dppCtrl, unsigned rowMask, unsigned bankMask,
                             bool boundCtrl);
@@ -202,6 +202,8 @@ StringRef BuilderRecorder::getCallName(Opcode opcode) {
     return "cooperative.matrix.extract";
   case Opcode::CooperativeMatrixConstruct:
     return "cooperative.matrix.construct";
+  case Opcode::CooperativeMatrixMulAdd:
+    return "cooperative.matrix.muladd";
   case Opcode::EmitVertex:
     return "emit.vertex";
   case Opcode::EndPrimitive:
@@ -1979,6 +1981,20 @@ Value *BuilderRecorder::CreateCooperativeMatrixConstruct(Value *coopMatRow, Valu
   return record(Opcode::CooperativeMatrixConstruct, coopMatRow->getType(), {coopMatRow, constVal}, instName);
 }
 
+// =====================================================================================================================
+// Create cooperative matrix multiply-add.
+//
+// @param matrixA : The row of cooperative matrix A.
+// @param matrixB : The column of cooperative matrix B.
+// @param matrixC : The column of cooperative matrix C.
+// @param isSigned : Whether the integer components of matrix A and matrix B are signed.
+// @param instName : Name to give instruction(s).
+Value *BuilderRecorder::CreateCooperativeMatrixMulAdd(Value *matrixA, Value *matrixB, Value *matrixC, bool isSigned,
+                                                      const Twine &instName) {
+  return record(Opcode::CooperativeMatrixMulAdd, matrixC->getType(), {matrixA, matrixB, matrixC, getInt1(isSigned)},
+                instName);
+}
+
 // =====================================================================================================================
 // Record one Builder call
 //
@@ -1988,6 +2004,15 @@ Value *BuilderRecorder::CreateCooperativeMatrixConstruct(Value *coopMatRow, Valu
 // @param instName : Name to give instruction
 Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resultTy, ArrayRef<Value *> args,
                                      const Twine &instName) {
+  // Look for the declaration in the ones already used. The handle is cleared if the declaration is erased.
+  Module *const module = GetInsertBlock()->getModule();
+  WeakVH &callee = m_callees[std::make_tuple(module, static_cast<unsigned>(opcode), resultTy)];
+  Function *func = cast_or_null<Function>(callee);
+  if (func) {
+    // Create the call.
+    return CreateCall(func, args, instName);
+  }
+
   // Create mangled name of builder call. This only needs to be mangled on return type.
   std::string mangledName;
   {
@@ -2002,8 +2027,7 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
   }
 
   // See if the declaration already exists in the module.
-  Module *const module = GetInsertBlock()->getModule();
-  Function *func = dyn_cast_or_null<Function>(module->getFunction(mangledName));
+  func = dyn_cast_or_null<Function>(module->getFunction(mangledName));
   if (!func) {
     // Does not exist. Create it as a varargs function.
     auto funcTy = FunctionType::get(resultTy, {}, true);
@@ -2057,10 +2081,9 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
     case Opcode::FpTruncWithRounding:
     case Opcode::Fract:
     case Opcode::GetBufferDescLength:
-    case Opcode::GetDescPtr:
-    case Opcode::GetDescStride:
-    case Opcode::GetWaveSize:
-    case Opcode::GetSubgroupSize:
+    case Opcode::ImageQueryLevels:
+    case Opcode::ImageQuerySamples:
+    case Opcode::ImageQuerySize:
     case Opcode::InsertBitField:
     case Opcode::IsInf:
     case Opcode::IsNaN:
@@ -2080,12 +2103,6 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
     case Opcode::SmoothStep:
     case Opcode::TransposeMatrix:
     case Opcode::VectorTimesMatrix:
-    case Opcode::CooperativeMatrixLoad:
-    case Opcode::CooperativeMatrixStore:
-    case Opcode::CooperativeMatrixConvert:
-    case Opcode::CooperativeMatrixBinaryOp:
-    case Opcode::CooperativeMatrixExtract:
-    case Opcode::CooperativeMatrixConstruct:
     case Power:
     case Sinh:
     case Tan:
@@ -2098,14 +2115,41 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
     case Opcode::SubgroupBallotInclusiveBitCount:
       // Functions that don't access memory.
       func->addFnAttr(Attribute::ReadNone);
+      // Must be marked as returning for DCE.
+      func->addFnAttr(Attribute::WillReturn);
+      break;
+    case Opcode::GetDescPtr:
+    case Opcode::GetDescStride:
+    case Opcode::GetWaveSize:
+    case Opcode::GetSubgroupSize:
+      // Functions that don't access memory and are cheap to execute anywhere, so that LICM and GVN can hoist them
+      // before they are replayed.
+      func->addFnAttr(Attribute::ReadNone);
+      func->addFnAttr(Attribute::WillReturn);
+      func->addFnAttr(Attribute::Speculatable);
+      break;
+    case Opcode::LoadBufferDesc:
+    case Opcode::LoadPushConstantsPtr:
+      // Functions that only read memory that does not change during the pipeline (descriptor tables and user data),
+      // so they can be treated as not accessing memory, and CSE'd across writes.
+      func->addFnAttr(Attribute::ReadNone);
+      func->addFnAttr(Attribute::WillReturn);
+      break;
+    case Opcode::CooperativeMatrixLoad:
+    case Opcode::CooperativeMatrixStore:
+    case Opcode::CooperativeMatrixConvert:
+    case Opcode::CooperativeMatrixBinaryOp:
+    case Opcode::CooperativeMatrixExtract:
+    case Opcode::CooperativeMatrixConstruct:
+      // Functions that don't access memory.
+      // NOTE: These are not marked as returning, so that an unused CooperativeMatrixStore is not removed as dead.
+      func->addFnAttr(Attribute::ReadNone);
       break;
     case Opcode::ImageGather:
     case Opcode::ImageLoad:
     case Opcode::ImageLoadWithFmask:
     case Opcode::ImageSample:
     case Opcode::ImageSampleConvert:
-    case Opcode::LoadBufferDesc:
-    case Opcode::LoadPushConstantsPtr:
     case Opcode::ReadBuiltInInput:
     case Opcode::ReadBuiltInOutput:
     case Opcode::ReadGenericInput:
@@ -2148,6 +2192,7 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
     case Opcode::SubgroupShuffleXor:
     case Opcode::SubgroupSwizzleMask:
     case Opcode::SubgroupSwizzleQuad:
+    case Opcode::CooperativeMatrixMulAdd:
     case Opcode::Barrier:
       // TODO: we should mark these functions 'ReadNone' in theory, but that need to wait until we fix all convergent
       // issues in LLVM optimizations.
@@ -2158,9 +2203,6 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
     case Opcode::EmitVertex:
     case Opcode::EndPrimitive:
     case Opcode::ImageGetLod:
-    case Opcode::ImageQueryLevels:
-    case Opcode::ImageQuerySamples:
-    case Opcode::ImageQuerySize:
     case Opcode::IsHelperInvocation:
     case Opcode::Kill:
     case Opcode::ReadClock:
@@ -2173,6 +2215,7 @@ Instruction *BuilderRecorder::record(BuilderRecorder::Opcode opcode, Type *resul
       break;
     }
   }
+  callee = func;
 
   // Create the call.
   auto call = CreateCall(func, args, instName);
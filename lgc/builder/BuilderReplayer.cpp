@@ -33,6 +33,7 @@
 #include "lgc/builder/BuilderRecorder.h"
 #include "lgc/state/PipelineState.h"
 #include "lgc/util/Internal.h"
+#include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "lgc-builder-replayer"
@@ -194,10 +195,20 @@ void BuilderReplayer::replayCall(unsigned opcode, CallInst *call) {
   // Set the insert point on the Builder. Also sets debug location to that of pCall.
   m_builder->SetInsertPoint(call);
 
+  // Remember where the expansion of the call will start.
+  BasicBlock *block = call->getParent();
+  Instruction *prevInst = call->getPrevNode();
+
   // Process the builder call.
   LLVM_DEBUG(dbgs() << "Replaying " << *call << "\n");
   Value *newValue = processCall(opcode, call);
 
+  // If the call has only constant args, try to fold its expansion to a constant now, instead of leaving a long
+  // sequence of instructions for later passes to fold.
+  if (newValue && !isa<Constant>(newValue) && call->getParent() == block &&
+      all_of(call->args(), [](const Use &arg) { return isa<Constant>(arg); }))
+    newValue = foldExpansion(prevInst ? prevInst->getNextNode() : &block->front(), call, newValue);
+
   // Replace uses of the call with the new value, take the name, remove the old call.
   if (newValue) {
     LLVM_DEBUG(dbgs() << "  replacing with: " << *newValue << "\n");
@@ -210,6 +221,31 @@ void BuilderReplayer::replayCall(unsigned opcode, CallInst *call) {
   call->eraseFromParent();
 }
 
+// =====================================================================================================================
+// Constant-fold the instructions of the expansion of a builder call with constant args, in order, using the same
+// folding (including that of AMDGPU intrinsics such as the cube ones) as later LLVM passes would do, so the result is
+// unchanged. Instructions that fold are removed; an instruction that does not fold stays, together with the rest of
+// the expansion that uses it. Returns the replacement value for the call, which is a constant if it fully folded.
+//
+// @param begin : First instruction of the expansion
+// @param call : The builder call, which is just after the expansion
+// @param newValue : The replacement value for the call
+Value *BuilderReplayer::foldExpansion(Instruction *begin, CallInst *call, Value *newValue) {
+  const DataLayout &dataLayout = call->getModule()->getDataLayout();
+  SmallVector<Instruction *, 16> foldedInsts;
+  for (Instruction *inst = begin; inst != call; inst = inst->getNextNode()) {
+    if (Constant *folded = ConstantFoldInstruction(inst, dataLayout)) {
+      inst->replaceAllUsesWith(folded);
+      if (inst == newValue)
+        newValue = folded;
+      foldedInsts.push_back(inst);
+    }
+  }
+  for (Instruction *inst : foldedInsts)
+    inst->eraseFromParent();
+  return newValue;
+}
+
 // =====================================================================================================================
 // Process one recorder builder call.
 // Returns the replacement value, or nullptr in the case that we do not want the caller to replace uses of
@@ -768,6 +804,10 @@ Value *BuilderReplayer::processCall(unsigned opcode, CallInst *call) {
   case BuilderRecorder::Opcode::CooperativeMatrixConstruct: {
     return m_builder->CreateCooperativeMatrixConstruct(args[0], args[1]);
   }
+  case BuilderRecorder::Opcode::CooperativeMatrixMulAdd: {
+    return m_builder->CreateCooperativeMatrixMulAdd(args[0], args[1], args[2],
+                                                    cast<ConstantInt>(args[3])->getZExtValue() != 0);
+  }
   // Replayer implementations of SubgroupBuilder methods
   case BuilderRecorder::Opcode::GetSubgroupSize: {
     return m_builder->CreateGetSubgroupSize();
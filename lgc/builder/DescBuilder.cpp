@@ -147,7 +147,10 @@ Value *DescBuilder::CreateGetDescStride(ResourceNodeType descType, unsigned desc
   if (!m_pipelineState->isUnlinked() || !m_pipelineState->getUserDataNodes().empty()) {
     std::tie(topNode, node) = m_pipelineState->findResourceNode(descType, descSet, binding);
     if (!node) {
-      // We did not find the resource node. Return an undef value.
+      // We did not find the resource node. For an fmask, every array element uses the same null fmask descriptor
+      // (see CreateGetDescPtr). Otherwise return an undef value.
+      if (descType == ResourceNodeType::DescriptorFmask)
+        return getInt32(0);
       return UndefValue::get(getInt32Ty());
     }
   }
@@ -172,7 +175,12 @@ Value *DescBuilder::CreateGetDescPtr(ResourceNodeType descType, unsigned descSet
   if (!m_pipelineState->isUnlinked() || !m_pipelineState->getUserDataNodes().empty()) {
     std::tie(topNode, node) = m_pipelineState->findResourceNode(descType, descSet, binding);
     if (!node) {
-      // We did not find the resource node. Return an undef value.
+      // We did not find the resource node. For an fmask, that means the multisampled image has no fmask (and the
+      // shadow descriptor table is disabled), so return a pointer to an all-zero descriptor. Its invalid format
+      // makes the image load use the sample number as is, so the fmask load and all address computation for it
+      // are optimized away, and no descriptor table is needed. Otherwise return an undef value.
+      if (descType == ResourceNodeType::DescriptorFmask)
+        return CreateBitCast(getNullFmaskDesc(), getDescPtrTy(descType));
       return UndefValue::get(getDescPtrTy(descType));
     }
   }
@@ -213,6 +221,21 @@ Value *DescBuilder::CreateGetDescPtr(ResourceNodeType descType, unsigned descSet
   return CreateBitCast(descPtr, getDescPtrTy(descType));
 }
 
+// =====================================================================================================================
+// Get a pointer to the all-zero fmask descriptor used for a multisampled image that does not have an fmask, creating
+// it if it does not already exist.
+Value *DescBuilder::getNullFmaskDesc() {
+  Module *module = GetInsertPoint()->getModule();
+  GlobalVariable *global = module->getGlobalVariable(lgcName::NullFmaskGlobal, /*AllowInternal=*/true);
+  if (!global) {
+    Type *descTy = getDescTy(ResourceNodeType::DescriptorFmask);
+    global = new GlobalVariable(*module, descTy, /*isConstant=*/true, GlobalValue::InternalLinkage,
+                                Constant::getNullValue(descTy), lgcName::NullFmaskGlobal, nullptr,
+                                GlobalValue::NotThreadLocal, ADDR_SPACE_CONST);
+  }
+  return global;
+}
+
 // =====================================================================================================================
 // Create a load of the push constants table pointer.
 // This returns a pointer to the ResourceNodeType::PushConst resource in the top-level user data table.
@@ -256,7 +279,8 @@ Value *DescBuilder::getStride(ResourceNodeType descType, unsigned descSet, unsig
 
 // =====================================================================================================================
 // Returns the reloc string suffix for the given resource type.
-// This is used with `reloc::DescriptorOffset` and must match the parsing logic in RelocHandler.cpp.
+// This is used with `reloc::DescriptorOffset` and `reloc::DescriptorUseSpillTable`, and must match the parsing logic in
+// RelocHandler.cpp.
 //
 // @param type : Resource type
 static StringRef GetRelocTypeSuffix(ResourceNodeType type) {
@@ -290,8 +314,8 @@ Value *DescBuilder::getDescPtr(ResourceNodeType resType, unsigned descSet, unsig
   Value *descPtr = nullptr;
 
   auto GetSpillTablePtr = [this]() {
-    // The descriptor is in the top-level table. (This can only happen for a DescriptorBuffer.) Contrary
-    // to what used to happen, we just load from the spill table, so we can get a pointer to the descriptor.
+    // The descriptor is in the top-level table. Contrary to what used to happen, we just load from the spill
+    // table, so we can get a pointer to the descriptor.
     // The spill table gets returned as a pointer to array of i8.
     return CreateNamedCall(lgcName::SpillTable, getInt8Ty()->getPointerTo(ADDR_SPACE_CONST), {}, Attribute::ReadNone);
   };
@@ -342,12 +366,13 @@ Value *DescBuilder::getDescPtr(ResourceNodeType resType, unsigned descSet, unsig
     // Ensure we mark spill table usage.
     descPtr = GetSpillTablePtr();
     getPipelineState()->getPalMetadata()->setUserDataSpillUsage(node->offsetInDwords);
-  } else if (!node && !topNode && resType == ResourceNodeType::DescriptorBuffer) {
+  } else if (!node && !topNode && resType != ResourceNodeType::DescriptorFmask) {
     // If we do not have user data layout info (topNode and node are nullptr), then
-    // we do not know at compile time whether a DescriptorBuffer is in the root table or the table for its
+    // we do not know at compile time whether a descriptor is in the root table or the table for its
     // descriptor set, so we need to generate a select between the two, where the condition is a reloc.
     // If the descriptor ends up in the root table (top-level), a value from the spill table will be used.
-    // The linking code has to take care of marking PAL metadata for user spill usage.
+    // The linking code has to take care of marking PAL metadata for user spill usage. An fmask descriptor is
+    // never in the root table, as it is in the shadow descriptor table when that is used.
 
     // Since the descriptor pointers will be later formed by bitcasting v2i32 to i8* we bitcast them to v2i32
     // here. This enables the middle-end to eliminate i8* before doing the instruction selection and reason about high
@@ -362,7 +387,10 @@ Value *DescBuilder::getDescPtr(ResourceNodeType resType, unsigned descSet, unsig
     descriptorTableDescPtr = CreatePtrToInt(descriptorTableDescPtr, getInt64Ty());
     descriptorTableDescPtr = CreateBitCast(descriptorTableDescPtr, FixedVectorType::get(getInt32Ty(), 2));
 
-    Value *reloc = CreateRelocationConstant(reloc::DescriptorUseSpillTable + Twine(descSet) + "_" + Twine(binding));
+    // The reloc for a DescriptorBuffer has no type suffix, as it had before other types were handled.
+    StringRef typeSuffix = resType == ResourceNodeType::DescriptorBuffer ? "" : GetRelocTypeSuffix(resType);
+    Value *reloc = CreateRelocationConstant(reloc::DescriptorUseSpillTable + Twine(descSet) + "_" + Twine(binding) +
+                                            typeSuffix);
     Value *useSpillTable = CreateICmpNE(reloc, getInt32(0));
     descPtr = CreateSelect(useSpillTable, spillDescPtr, descriptorTableDescPtr);
     descPtr = CreateBitCast(descPtr, getInt64Ty());
@@ -29,6 +29,8 @@
  ***********************************************************************************************************************
  */
 #include "BuilderImpl.h"
+#include "lgc/state/TargetInfo.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
 
 #define DEBUG_TYPE "lgc-builder-impl-matrix"
 
@@ -650,6 +652,98 @@ Value *MatrixBuilder::CreateCooperativeMatrixConstruct(Value *coopMatRow, Value
   return coopMatRow;
 }
 
+// =====================================================================================================================
+// Create cooperative matrix multiply-add, returning A * B + C.
+// Each lane holds a row of A, and a column of B, of C and of the result, with lane 0-15 data replicated into the other
+// lanes as for a cooperative matrix load. So the element of the result for row m in a lane is the dot product of row m
+// of A, read from lane m, and the column of B in the lane, plus the element of C for row m.
+//
+// Where the hardware has a dot product instruction for the packed components, each packed 32-bit element of the rows
+// takes one instruction: v_dot2_f32_f16 for f16 matrices with an f32 accumulator, and v_dot4_i32_i8 or v_dot4_u32_u8
+// for i8 matrices with an i32 accumulator. Otherwise the components are unpacked and multiplied and added one by one.
+//
+// @param matrixA : The row of cooperative matrix A.
+// @param matrixB : The column of cooperative matrix B, with the same type as matrixA.
+// @param matrixC : The column of cooperative matrix C, which gives the type of the result.
+// @param isSigned : Whether the integer components of matrix A and matrix B are signed.
+// @param instName : Name to give instruction(s).
+Value *MatrixBuilder::CreateCooperativeMatrixMulAdd(Value *matrixA, Value *matrixB, Value *matrixC, bool isSigned,
+                                                    const Twine &instName) {
+  assert(matrixA->getType() == matrixB->getType());
+
+  CooperativeMatrixInfo coopMatInfoAB = {};
+  calcCooperativeMatrixInfo(coopMatInfoAB, matrixA);
+
+  CooperativeMatrixInfo coopMatInfoC = {};
+  calcCooperativeMatrixInfo(coopMatInfoC, matrixC);
+
+  const GpuProperty &gpuProperty = getPipelineState()->getTargetInfo().getGpuProperty();
+  const bool isHalf = coopMatInfoAB.subElemType->isHalfTy();
+  bool useDot = false;
+  if (coopMatInfoC.subElemCount == 1) {
+    if (isHalf)
+      useDot = coopMatInfoC.elemType->isFloatTy() && gpuProperty.supportFloatDot2;
+    else if (coopMatInfoAB.subElemType->isIntegerTy(8))
+      useDot = coopMatInfoC.elemType->isIntegerTy(32) && gpuProperty.supportIntegerDotFlag.compBitwidth8 &&
+               gpuProperty.supportIntegerDotFlag.sameSignedness;
+  }
+
+  // The size of a cooperative matrix is 16x16.
+  constexpr unsigned numOfData = 16;
+  Type *vecTyAB = FixedVectorType::get(coopMatInfoAB.subElemType, coopMatInfoAB.subElemCount);
+  Type *accTy = coopMatInfoC.subElemType;
+  SmallVector<Value *, numOfData> resultSubElems;
+  for (unsigned rowIdx = 0; rowIdx < numOfData; ++rowIdx) {
+    Value *rowA = CreateSubgroupBroadcast(matrixA, getInt32(rowIdx));
+    Value *acc = CreateCooperativeMatrixExtract(matrixC, getInt32(rowIdx));
+    if (useDot) {
+      for (unsigned elemIdx = 0; elemIdx < coopMatInfoAB.elemCount; ++elemIdx) {
+        Value *elemA = CreateExtractElement(rowA, elemIdx);
+        Value *elemB = CreateExtractElement(matrixB, elemIdx);
+        if (isHalf) {
+          acc = CreateIntrinsic(Intrinsic::amdgcn_fdot2, {},
+                                {CreateBitCast(elemA, vecTyAB), CreateBitCast(elemB, vecTyAB), acc, getFalse()});
+        } else {
+          auto intrinsicDot4 = isSigned ? Intrinsic::amdgcn_sdot4 : Intrinsic::amdgcn_udot4;
+          acc = CreateIntrinsic(intrinsicDot4, {}, {elemA, elemB, acc, getFalse()});
+        }
+      }
+    } else {
+      for (unsigned index = 0; index < numOfData; ++index) {
+        Value *subElemA = CreateCooperativeMatrixExtract(rowA, getInt32(index));
+        Value *subElemB = CreateCooperativeMatrixExtract(matrixB, getInt32(index));
+        if (accTy->isFloatingPointTy()) {
+          subElemA = CreateFPCast(subElemA, accTy);
+          subElemB = CreateFPCast(subElemB, accTy);
+          acc = CreateFAdd(CreateFMul(subElemA, subElemB), acc);
+        } else {
+          subElemA = CreateIntCast(subElemA, accTy, isSigned);
+          subElemB = CreateIntCast(subElemB, accTy, isSigned);
+          acc = CreateAdd(CreateMul(subElemA, subElemB), acc);
+        }
+      }
+    }
+    resultSubElems.push_back(acc);
+  }
+
+  // Pack the result into the layout of matrix C.
+  Value *result = UndefValue::get(matrixC->getType());
+  Type *vecTyC = FixedVectorType::get(coopMatInfoC.subElemType, coopMatInfoC.subElemCount);
+  for (unsigned elemIdx = 0; elemIdx < coopMatInfoC.elemCount; ++elemIdx) {
+    Value *elem = resultSubElems[elemIdx];
+    if (coopMatInfoC.subElemCount > 1) {
+      elem = UndefValue::get(vecTyC);
+      for (unsigned subIdx = 0; subIdx < coopMatInfoC.subElemCount; ++subIdx)
+        elem = CreateInsertElement(elem, resultSubElems[elemIdx * coopMatInfoC.subElemCount + subIdx], subIdx);
+      elem = CreateBitCast(elem, coopMatInfoC.elemType);
+    }
+    result = CreateInsertElement(result, elem, elemIdx);
+  }
+
+  result->setName(instName);
+  return result;
+}
+
 // =====================================================================================================================
 // Calculate the info of cooperative matrix
 //
@@ -326,6 +326,10 @@ Value *SubgroupBuilder::CreateSubgroupBallotFindMsb(Value *const value, const Tw
 // @param index : The index to shuffle from.
 // @param instName : Name to give final instruction.
 Value *SubgroupBuilder::CreateSubgroupShuffle(Value *const value, Value *const index, const Twine &instName) {
+  // All lanes read the same lane for a constant index, so use a readlane.
+  if (isa<ConstantInt>(index))
+    return CreateSubgroupBroadcast(value, index, instName);
+
   if (supportBPermute()) {
     auto mapFunc = [](BuilderBase &builder, ArrayRef<Value *> mappedArgs,
                       ArrayRef<Value *> passthroughArgs) -> Value * {
@@ -457,6 +461,10 @@ Value *SubgroupBuilder::CreateSubgroupShuffleXor(Value *const value, Value *cons
 // @param delta : The delta to shuffle from.
 // @param instName : Name to give final instruction.
 Value *SubgroupBuilder::CreateSubgroupShuffleUp(Value *const value, Value *const delta, const Twine &instName) {
+  // Before GFX10, a shift up by one lane is a DPP wave shift right, with all rows and banks enabled (0xF).
+  if (supportDpp() && !supportPermLaneDpp() && isa<ConstantInt>(delta) && cast<ConstantInt>(delta)->isOne())
+    return createDppMov(value, DppCtrl::DppWfSr1, 0xF, 0xF, false);
+
   Value *index = CreateSubgroupMbcnt(getInt64(UINT64_MAX), "");
   index = CreateSub(index, delta);
   return CreateSubgroupShuffle(value, index, instName);
@@ -469,6 +477,10 @@ Value *SubgroupBuilder::CreateSubgroupShuffleUp(Value *const value, Value *const
 // @param delta : The delta to shuffle from.
 // @param instName : Name to give final instruction.
 Value *SubgroupBuilder::CreateSubgroupShuffleDown(Value *const value, Value *const delta, const Twine &instName) {
+  // Before GFX10, a shift down by one lane is a DPP wave shift left, with all rows and banks enabled (0xF).
+  if (supportDpp() && !supportPermLaneDpp() && isa<ConstantInt>(delta) && cast<ConstantInt>(delta)->isOne())
+    return createDppMov(value, DppCtrl::DppWfSl1, 0xF, 0xF, false);
+
   Value *index = CreateSubgroupMbcnt(getInt64(UINT64_MAX), "");
   index = CreateAdd(index, delta);
   return CreateSubgroupShuffle(value, index, instName);
@@ -483,6 +495,10 @@ Value *SubgroupBuilder::CreateSubgroupShuffleDown(Value *const value, Value *con
 // @param instName : Name to give final instruction.
 Value *SubgroupBuilder::CreateSubgroupClusteredReduction(GroupArithOp groupArithOp, Value *const value,
                                                          Value *const inClusterSize, const Twine &instName) {
+  // The cluster size is a constant in SPIR-V, so emit only the steps needed for it.
+  if (auto constClusterSize = dyn_cast<ConstantInt>(inClusterSize))
+    return createClusteredReduction(groupArithOp, value, constClusterSize->getZExtValue(), instName);
+
   auto waveSize = getInt32(getShaderWaveSize());
   Value *clusterSize = CreateSelect(CreateICmpUGT(inClusterSize, waveSize), waveSize, inClusterSize);
   if (supportDpp()) {
@@ -627,6 +643,103 @@ Value *SubgroupBuilder::CreateSubgroupClusteredReduction(GroupArithOp groupArith
   }
 }
 
+// =====================================================================================================================
+// Create a subgroup clustered reduction for a constant cluster size. Small clusters use DPP quad permutes and row
+// mirrors only. A full-wave reduction on GFX10+ combines the rows with permute lanes and readlanes, which also makes
+// the result uniform.
+//
+// @param groupArithOp : The group arithmetic operation.
+// @param value : An LLVM value.
+// @param clusterSize : The cluster size.
+// @param instName : Name to give final instruction.
+Value *SubgroupBuilder::createClusteredReduction(GroupArithOp groupArithOp, Value *const value, unsigned clusterSize,
+                                                 const Twine &instName) {
+  const unsigned waveSize = getShaderWaveSize();
+  clusterSize = std::min(clusterSize, waveSize);
+  if (clusterSize <= 1)
+    return value;
+
+  // Start the WWM section by setting the inactive lanes.
+  Value *const identity = createGroupArithmeticIdentity(groupArithOp, value->getType());
+  Value *result = createSetInactive(value, identity);
+
+  if (supportDpp()) {
+    // Combine the lanes within each cluster of 16 with DPP operations, with all masks and rows enabled (0xF): quad
+    // permutes for N <-> N+1 and N <-> N+2, then a row half mirror and a row mirror.
+    result = createGroupArithmeticOperation(groupArithOp, result,
+                                            createDppUpdate(identity, result, DppCtrl::DppQuadPerm1032, 0xF, 0xF, 0));
+    if (clusterSize >= 4) {
+      result = createGroupArithmeticOperation(
+          groupArithOp, result, createDppUpdate(identity, result, DppCtrl::DppQuadPerm2301, 0xF, 0xF, 0));
+    }
+    if (clusterSize >= 8) {
+      result = createGroupArithmeticOperation(
+          groupArithOp, result, createDppUpdate(identity, result, DppCtrl::DppRowHalfMirror, 0xF, 0xF, 0));
+    }
+    if (clusterSize >= 16) {
+      result = createGroupArithmeticOperation(groupArithOp, result,
+                                              createDppUpdate(identity, result, DppCtrl::DppRowMirror, 0xF, 0xF, 0));
+    }
+    if (clusterSize < 32)
+      return createWwm(result);
+
+    if (supportPermLaneDpp()) {
+      if (waveSize == 32) {
+        // The whole wave is the cluster: combine the two rows by reading one lane from each.
+        result = createGroupArithmeticOperation(groupArithOp, CreateSubgroupBroadcast(result, getInt32(15), instName),
+                                                CreateSubgroupBroadcast(result, getInt32(31), instName));
+        return createWwm(result);
+      }
+
+      // Use a permute lane to cross rows (row 1 <-> row 0, row 3 <-> row 2).
+      result = createGroupArithmeticOperation(groupArithOp, result,
+                                              createPermLaneX16(result, result, UINT32_MAX, UINT32_MAX, true, false));
+      if (clusterSize == 64) {
+        // Combine the two halves of the wave by reading one lane from each.
+        result = createGroupArithmeticOperation(groupArithOp, CreateSubgroupBroadcast(result, getInt32(31), instName),
+                                                CreateSubgroupBroadcast(result, getInt32(63), instName));
+      }
+      return createWwm(result);
+    }
+
+    // Use a row broadcast to move the 15th element in each cluster of 16 to the next cluster. The row mask is set to
+    // 0xa (0b1010) so that only the 2nd and 4th clusters of 16 perform the calculation.
+    result = createGroupArithmeticOperation(groupArithOp, result,
+                                            createDppUpdate(identity, result, DppCtrl::DppRowBcast15, 0xA, 0xF, 0));
+    if (clusterSize == 64) {
+      // Use a row broadcast to move the 31st element from the lower cluster of 32 to the upper cluster, and read the
+      // value from the last invocation in the subgroup. The row mask is set to 0x8 (0b1000) so that only the upper
+      // cluster of 32 perform the calculation.
+      result = createGroupArithmeticOperation(groupArithOp, result,
+                                              createDppUpdate(identity, result, DppCtrl::DppRowBcast31, 0x8, 0xF, 0));
+      return createWwm(CreateSubgroupBroadcast(result, getInt32(63), instName));
+    }
+
+    // Use invocation 31 or 63's value, depending on which cluster of 32 our invocation is in.
+    Value *const laneIdLessThan32 = CreateICmpULT(CreateSubgroupMbcnt(getInt64(UINT64_MAX), ""), getInt32(32));
+    result = CreateSelect(laneIdLessThan32, CreateSubgroupBroadcast(result, getInt32(31), instName),
+                          CreateSubgroupBroadcast(result, getInt32(63), instName));
+    return createWwm(result);
+  }
+
+  // The DS swizzle mode is doing a xor of 1, 2, 4, 8 and 16 to swap values between N <-> N+1, N+2, N+4, N+8 and
+  // N+16. The and mask of 0x1f means all lanes do the same swap. After the swap by 16, all lanes of a cluster of 32
+  // have the result.
+  for (unsigned xorMask = 1; xorMask < clusterSize && xorMask < 32; xorMask *= 2) {
+    result = createGroupArithmeticOperation(groupArithOp, result,
+                                            createDsSwizzle(result, getDsSwizzleBitMode(xorMask, 0x00, 0x1F)));
+  }
+
+  // If the cluster size is 64 we compute the value by combining the two broadcasts.
+  if (clusterSize == 64) {
+    result = createGroupArithmeticOperation(groupArithOp, CreateSubgroupBroadcast(result, getInt32(31), instName),
+                                            CreateSubgroupBroadcast(result, getInt32(63), instName));
+  }
+
+  // Finish the WWM section by calling the intrinsic.
+  return createWwm(result);
+}
+
 // =====================================================================================================================
 // Create a subgroup clustered inclusive scan.
 //
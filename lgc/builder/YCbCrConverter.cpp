@@ -42,9 +42,6 @@ using namespace llvm;
 // @param wrapInfo : Wrapped YCbCr sample information
 Value *YCbCrConverter::wrappedSample(YCbCrWrappedSampleInfo &wrapInfo) {
   SmallVector<Value *, 4> coordsChroma;
-  YCbCrSampleInfo *sampleInfo = wrapInfo.ycbcrInfo;
-  sampleInfo->imageDesc = wrapInfo.imageDesc1;
-
   Value *chromaWidth = nullptr;
   Value *chromaHeight = nullptr;
 
@@ -72,6 +69,54 @@ Value *YCbCrConverter::wrappedSample(YCbCrWrappedSampleInfo &wrapInfo) {
   coordsChroma.push_back(m_builder->CreateFDiv(wrapInfo.coordI, chromaWidth));
   coordsChroma.push_back(m_builder->CreateFDiv(wrapInfo.coordJ, chromaHeight));
 
+  return sampleChromaPlanes(wrapInfo, coordsChroma);
+}
+
+// =====================================================================================================================
+// Implement wrapped YCbCr sample at the chroma coordinates of the implicit chroma reconstruction, which are the UV
+// coordinates of the luma sample adjusted for the chroma location in the downsampled dimensions.
+//
+// Unless the planes are padded, the ST coordinates of such a chroma sample are just the ST coordinates of the luma
+// sample, plus half a luma texel in a downsampled dimension whose chroma is cosited with the even luma samples. So
+// they are generated directly, instead of going through UV coordinates and back, which LLVM cannot fold.
+//
+// @param wrapInfo : Wrapped YCbCr sample information, with the UV coordinates of the luma sample
+Value *YCbCrConverter::implicitChromaSample(YCbCrWrappedSampleInfo &wrapInfo) {
+  const auto xChromaOffset = static_cast<ChromaLocation>(m_metaData.word1.xChromaOffset);
+  const auto yChromaOffset = static_cast<ChromaLocation>(m_metaData.word1.yChromaOffset);
+
+#if LLPC_CLIENT_INTERFACE_MAJOR_VERSION >= 52
+  if ((m_metaData.word5.lumaDepth > 1) && (m_metaData.word1.planes > 1)) {
+    // The chroma planes have their own padded size.
+    if (wrapInfo.subsampledX)
+      wrapInfo.coordI = calculateImplicitChromaUV(xChromaOffset, wrapInfo.coordI);
+    if (wrapInfo.subsampledY)
+      wrapInfo.coordJ = calculateImplicitChromaUV(yChromaOffset, wrapInfo.coordJ);
+    return wrappedSample(wrapInfo);
+  }
+#endif
+
+  Type *floatTy = m_builder->getFloatTy();
+  Value *coordS = m_coordS;
+  Value *coordT = m_coordT;
+  if (wrapInfo.subsampledX && xChromaOffset == ChromaLocation::CositedEven)
+    coordS = m_builder->CreateFAdd(coordS, m_builder->CreateFDiv(ConstantFP::get(floatTy, 0.5f), m_width));
+  if (wrapInfo.subsampledY && yChromaOffset == ChromaLocation::CositedEven)
+    coordT = m_builder->CreateFAdd(coordT, m_builder->CreateFDiv(ConstantFP::get(floatTy, 0.5f), m_height));
+
+  SmallVector<Value *, 4> coordsChroma = {coordS, coordT};
+  return sampleChromaPlanes(wrapInfo, coordsChroma);
+}
+
+// =====================================================================================================================
+// Sample the chroma planes at the given ST coordinates
+//
+// @param wrapInfo : Wrapped YCbCr sample information
+// @param coordsChroma : ST coordinates of the chroma sample
+Value *YCbCrConverter::sampleChromaPlanes(YCbCrWrappedSampleInfo &wrapInfo, SmallVectorImpl<Value *> &coordsChroma) {
+  YCbCrSampleInfo *sampleInfo = wrapInfo.ycbcrInfo;
+  sampleInfo->imageDesc = wrapInfo.imageDesc1;
+
   Value *result = nullptr;
 
   if (wrapInfo.planeCount == 1) {
@@ -659,7 +704,7 @@ void YCbCrConverter::sampleYCbCrData() {
         wrappedSampleInfo.subsampledX = false;
         wrappedSampleInfo.subsampledY = false;
 
-        imageOpChroma = wrappedSample(wrappedSampleInfo);
+        imageOpChroma = implicitChromaSample(wrappedSampleInfo);
       } else // SamplerFilter::Linear
       {
         if (m_metaData.word1.ySubSampled) {
@@ -669,17 +714,7 @@ void YCbCrConverter::sampleYCbCrData() {
         }
       }
     } else {
-      if (m_metaData.word1.xSubSampled) {
-        wrappedSampleInfo.coordI =
-            calculateImplicitChromaUV(static_cast<ChromaLocation>(m_metaData.word1.xChromaOffset), m_coordU);
-      }
-
-      if (m_metaData.word1.ySubSampled) {
-        wrappedSampleInfo.coordJ =
-            calculateImplicitChromaUV(static_cast<ChromaLocation>(m_metaData.word1.yChromaOffset), m_coordV);
-      }
-
-      imageOpChroma = wrappedSample(wrappedSampleInfo);
+      imageOpChroma = implicitChromaSample(wrappedSampleInfo);
     }
   } else // lumaFilter == SamplerFilter::Linear
   {
@@ -694,7 +729,7 @@ void YCbCrConverter::sampleYCbCrData() {
         if (!m_metaData.word1.xSubSampled) {
           wrappedSampleInfo.subsampledX = false;
           wrappedSampleInfo.subsampledY = false;
-          imageOpChroma = wrappedSample(wrappedSampleInfo);
+          imageOpChroma = implicitChromaSample(wrappedSampleInfo);
         } else {
           Value *subCoordI = m_coordI;
           Value *subCoordJ = m_coordJ;
@@ -756,17 +791,7 @@ void YCbCrConverter::sampleYCbCrData() {
         }
       }
     } else {
-      if (m_metaData.word1.xSubSampled) {
-        wrappedSampleInfo.coordI =
-            calculateImplicitChromaUV(static_cast<ChromaLocation>(m_metaData.word1.xChromaOffset), m_coordU);
-      }
-
-      if (m_metaData.word1.ySubSampled) {
-        wrappedSampleInfo.coordJ =
-            calculateImplicitChromaUV(static_cast<ChromaLocation>(m_metaData.word1.yChromaOffset), m_coordV);
-      }
-
-      imageOpChroma = wrappedSample(wrappedSampleInfo);
+      imageOpChroma = implicitChromaSample(wrappedSampleInfo);
     }
   }
 
@@ -793,20 +818,7 @@ void YCbCrConverter::sampleYCbCrData() {
 // @param imageOp : Results which need color conversion, in sequence => Cr, Y, Cb
 Value *YCbCrConverter::convertColor(Type *resultTy, SamplerYCbCrModelConversion colorModel, SamplerYCbCrRange range,
                                     unsigned *channelBits, Value *imageOp) {
-  Value *subImage = m_builder->CreateShuffleVector(imageOp, imageOp, ArrayRef<int>{0, 1, 2});
-
   Type *floatTy = m_builder->getFloatTy();
-
-  Value *minVec = UndefValue::get(FixedVectorType::get(floatTy, 3));
-  minVec = m_builder->CreateInsertElement(minVec, ConstantFP::get(floatTy, -0.5), uint64_t(0));
-  minVec = m_builder->CreateInsertElement(minVec, ConstantFP::get(floatTy, 0.0), uint64_t(1));
-  minVec = m_builder->CreateInsertElement(minVec, ConstantFP::get(floatTy, -0.5), uint64_t(2));
-
-  Value *maxVec = UndefValue::get(FixedVectorType::get(floatTy, 3));
-  maxVec = m_builder->CreateInsertElement(maxVec, ConstantFP::get(floatTy, 0.5), uint64_t(0));
-  maxVec = m_builder->CreateInsertElement(maxVec, ConstantFP::get(floatTy, 1.0), uint64_t(1));
-  maxVec = m_builder->CreateInsertElement(maxVec, ConstantFP::get(floatTy, 0.5), uint64_t(2));
-
   Value *result = UndefValue::get(resultTy);
 
   switch (colorModel) {
@@ -822,6 +834,12 @@ Value *YCbCrConverter::convertColor(Type *resultTy, SamplerYCbCrModelConversion
   case SamplerYCbCrModelConversion::YCbCr601:
   case SamplerYCbCrModelConversion::YCbCr709:
   case SamplerYCbCrModelConversion::YCbCr2020: {
+    Value *subImage = m_builder->CreateShuffleVector(imageOp, imageOp, ArrayRef<int>{0, 1, 2});
+    Value *minVec = ConstantVector::get(
+        {ConstantFP::get(floatTy, -0.5), ConstantFP::get(floatTy, 0.0), ConstantFP::get(floatTy, -0.5)});
+    Value *maxVec = ConstantVector::get(
+        {ConstantFP::get(floatTy, 0.5), ConstantFP::get(floatTy, 1.0), ConstantFP::get(floatTy, 0.5)});
+
     // inputVec = RangeExpaned(C'_rgba)
     Value *inputVec = m_builder->CreateFClamp(rangeExpand(range, channelBits, subImage), minVec, maxVec);
 
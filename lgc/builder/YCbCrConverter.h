@@ -274,6 +274,12 @@ private:
   // Implement wrapped YCbCr sample
   llvm::Value *wrappedSample(YCbCrWrappedSampleInfo &wrapInfo);
 
+  // Implement wrapped YCbCr sample at the chroma coordinates of the implicit chroma reconstruction
+  llvm::Value *implicitChromaSample(YCbCrWrappedSampleInfo &wrapInfo);
+
+  // Sample the chroma planes at the given ST coordinates
+  llvm::Value *sampleChromaPlanes(YCbCrWrappedSampleInfo &wrapInfo, llvm::SmallVectorImpl<llvm::Value *> &coordsChroma);
+
   // Implement reconstructed YCbCr sample operation for downsampled chroma channels in the X dimension
   llvm::Value *reconstructLinearXChromaSample(XChromaSampleInfo &xChromaInfo);
 
@@ -53,6 +53,10 @@
 #include "llvm/MC/TargetRegistry.h"
 #endif
 #include "llvm/Support/TargetSelect.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace llvm;
 using namespace object;
@@ -104,21 +108,87 @@ private:
 
 } // anonymous namespace
 
+// =====================================================================================================================
+// Initialize targets and assembly printers/parsers.
+static void initializeTargets() {
+  InitializeAllTargetInfos();
+  InitializeAllTargetMCs();
+  InitializeAllDisassemblers();
+}
+
 // =====================================================================================================================
 // Disassemble an ELF object into ostream. Does report_fatal_error on error.
 //
 // @param data : The object file contents
 // @param ostream : The stream to disassemble into
 void lgc::disassembleObject(MemoryBufferRef data, raw_ostream &ostream) {
-  // Initialize targets and assembly printers/parsers.
-  InitializeAllTargetInfos();
-  InitializeAllTargetMCs();
-  InitializeAllDisassemblers();
+  initializeTargets();
 
   // Do the disassembly.
   ObjDisassembler::disassembleObject(data, ostream);
 }
 
+// =====================================================================================================================
+// Disassemble ELF objects into ostream, in the order given. Each object has a disassembler of its own, so the objects
+// are disassembled on separate threads into buffers, which are output in order as they become ready. Does
+// report_fatal_error on error.
+//
+// @param objects : The object file contents
+// @param ostream : The stream to disassemble into
+// @param numThreads : Number of threads to disassemble with (0 for the number of hardware threads)
+void lgc::disassembleObjects(ArrayRef<MemoryBufferRef> objects, raw_ostream &ostream, unsigned numThreads) {
+  // The targets are registered before any thread starts, as registering them is not thread-safe.
+  initializeTargets();
+
+  if (numThreads == 0)
+    numThreads = std::max(std::thread::hardware_concurrency(), 1U);
+  numThreads = std::min(numThreads, static_cast<unsigned>(objects.size()));
+  if (numThreads <= 1) {
+    for (MemoryBufferRef object : objects)
+      ObjDisassembler::disassembleObject(object, ostream);
+    return;
+  }
+
+  std::vector<std::string> outputs(objects.size());
+  std::vector<bool> done(objects.size());
+  std::atomic<size_t> nextObject(0);
+  std::mutex mutex;
+  std::condition_variable doneCondition;
+
+  auto disassembleWorker = [&]() {
+    for (size_t objectIdx = nextObject++; objectIdx < objects.size(); objectIdx = nextObject++) {
+      std::string output;
+      raw_string_ostream outputStream(output);
+      ObjDisassembler::disassembleObject(objects[objectIdx], outputStream);
+      outputStream.flush();
+
+      std::lock_guard<std::mutex> lock(mutex);
+      outputs[objectIdx] = std::move(output);
+      done[objectIdx] = true;
+      doneCondition.notify_one();
+    }
+  };
+
+  SmallVector<std::thread, 8> threads;
+  for (unsigned threadIdx = 0; threadIdx != numThreads; ++threadIdx)
+    threads.emplace_back(disassembleWorker);
+
+  // Output each disassembly as soon as it is ready, freeing its buffer, so the output streams rather than waiting for
+  // all the objects.
+  for (size_t objectIdx = 0; objectIdx != objects.size(); ++objectIdx) {
+    std::string output;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      doneCondition.wait(lock, [&]() { return done[objectIdx]; });
+      output = std::move(outputs[objectIdx]);
+    }
+    ostream << output;
+  }
+
+  for (std::thread &thread : threads)
+    thread.join();
+}
+
 // =====================================================================================================================
 // Run the object disassembler to disassemble the object. Does report_fatal_error on error.
 void ObjDisassembler::run() {
@@ -51,12 +51,14 @@ ColorExportShader::ColorExportShader(PipelineState *pipelineState, ArrayRef<Colo
       continue;
     m_exportFormat[exp.hwColorTarget] =
         static_cast<ExportFormat>(pipelineState->computeExportFormat(exp.ty, exp.location));
+    m_channelMask[exp.hwColorTarget] = pipelineState->getColorExportChannelMask(exp.location);
   }
 
   PalMetadata *metadata = pipelineState->getPalMetadata();
   DB_SHADER_CONTROL shaderControl = {};
   shaderControl.u32All = metadata->getRegister(mmDB_SHADER_CONTROL);
   m_killEnabled = shaderControl.bits.KILL_ENABLE;
+  m_dummyExport = pipelineState->getTargetInfo().getGfxIpVersion().major < 10 || m_killEnabled;
 }
 
 // =====================================================================================================================
@@ -68,7 +70,8 @@ StringRef ColorExportShader::getString() {
     constexpr uint32_t estimatedTypeSize = 10;
     uint32_t sizeEstimate = (sizeof(ColorExportInfo) + estimatedTypeSize) * m_exports.size();
     sizeEstimate += sizeof(m_exportFormat);
-    sizeEstimate += sizeof(m_killEnabled);
+    sizeEstimate += sizeof(m_channelMask);
+    sizeEstimate += sizeof(m_dummyExport);
     m_shaderString.reserve(sizeEstimate);
 
     for (ColorExportInfo colorExportInfo : m_exports) {
@@ -81,7 +84,11 @@ StringRef ColorExportShader::getString() {
       m_shaderString += getTypeName(colorExportInfo.ty);
     }
     m_shaderString += StringRef(reinterpret_cast<const char *>(m_exportFormat), sizeof(m_exportFormat)).str();
-    m_shaderString += StringRef(reinterpret_cast<const char *>(&m_killEnabled), sizeof(m_killEnabled));
+    m_shaderString += StringRef(reinterpret_cast<const char *>(m_channelMask), sizeof(m_channelMask));
+    // Kill only matters to the code for whether it needs a dummy export, so this is encoded rather than kill itself,
+    // to let pipelines that differ only by kill share the color export shader where the code is the same. Kill is
+    // still set in the PAL metadata of each pipeline by updatePalMetadata at link time.
+    m_shaderString += StringRef(reinterpret_cast<const char *>(&m_dummyExport), sizeof(m_dummyExport));
   }
   return m_shaderString;
 }
@@ -108,8 +115,7 @@ Module *ColorExportShader::generate() {
     values[m_exports[idx].hwColorTarget] = colorExportFunc->getArg(idx);
   }
 
-  bool dummyExport = m_lgcContext->getTargetInfo().getGfxIpVersion().major < 10 || m_killEnabled;
-  fragColorExport->generateExportInstructions(m_exports, values, m_exportFormat, dummyExport, builder);
+  fragColorExport->generateExportInstructions(m_exports, values, m_exportFormat, m_dummyExport, builder);
   return colorExportFunc->getParent();
 }
 
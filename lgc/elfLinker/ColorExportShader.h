@@ -77,6 +77,8 @@ private:
   // key for a cache of glue shaders.
   llvm::SmallVector<ColorExportInfo, 8> m_exports;
   ExportFormat m_exportFormat[MaxColorTargets] = {}; // The export format for each hw color target.
+  unsigned m_channelMask[MaxColorTargets] = {};      // The channels exported for each hw color target.
+  bool m_dummyExport;                                // True if a dummy export is needed when nothing is exported.
   // The encoded or hashed (in some way) single string version of the above.
   std::string m_shaderString;
   PipelineState *m_pipelineState; // The pipeline state.  Used to set meta data information.
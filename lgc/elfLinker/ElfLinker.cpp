@@ -33,25 +33,55 @@
 #include "RelocHandler.h"
 #include "lgc/state/AbiMetadata.h"
 #include "lgc/state/PalMetadata.h"
+#include "lgc/LgcContext.h"
+#include "lgc/state/AbiUnlinked.h"
 #include "lgc/state/PipelineState.h"
+#include "lgc/state/ResourceUsage.h"
 #include "lgc/state/TargetInfo.h"
+#include "lgc/util/IsaStats.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/BinaryFormat/ELF.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#if LLVM_MAIN_REVISION && LLVM_MAIN_REVISION < 401324
+// Old version
+#include "llvm/Support/TargetRegistry.h"
+#else
+// New version (and unknown version)
+#include "llvm/MC/TargetRegistry.h"
+#endif
+#include "llvm/Target/TargetMachine.h"
 
 #define DEBUG_TYPE "lgc-elf-linker"
 
 using namespace lgc;
 using namespace llvm;
 
+// -prune-param-exports: when linking, remove the param exports that the fragment shader does not read
+static cl::opt<bool> PruneParamExports("prune-param-exports",
+                                       cl::desc("When linking, remove the vertex-processing stage param exports that "
+                                                "the fragment shader does not read"),
+                                       cl::init(false));
+
 namespace {
 
 class ElfLinkerImpl;
 
+// Length of the repeating patterns used for alignment padding in output sections
+const size_t PaddingUnit = 16;
+// Instruction cache line size, used for padding at the end of .text on GFX10+
+const uint64_t CacheLineSize = 64;
+
 // =====================================================================================================================
 // An ELF input to the linker
 struct ElfInput {
@@ -60,6 +90,15 @@ struct ElfInput {
   StringRef reduceAlign; // If non-empty, the name of a text section to reduce the alignment to 0x40
 };
 
+// =====================================================================================================================
+// A param export instruction to patch in the output ELF
+struct ParamExportPatch {
+  unsigned outputSectIdx; // Output section containing the export
+  unsigned withinSectIdx; // Input section within that output section
+  uint64_t inputOffset;   // Offset of the export within the input section
+  unsigned newParam;      // New param number, or UINT_MAX to remove the export
+};
+
 // =====================================================================================================================
 // A single input section
 struct InputSection {
@@ -77,6 +116,10 @@ public:
   OutputSection(ElfLinkerImpl *linker, StringRef name = "", unsigned type = 0)
       : m_linker(linker), m_name(name), m_type(type) {}
 
+  // Reset to an empty output section with the given name and optional SHT_* section type, keeping the buffer for
+  // input sections
+  void reset(StringRef name = "", unsigned type = 0);
+
   // Add an input section
   void addInputSection(ElfInput &elfInput, object::SectionRef inputSection, bool reduceAlign = false);
 
@@ -99,11 +142,17 @@ public:
   // Get the output file offset of a particular input section in the output section
   uint64_t getOutputOffset(unsigned inputIdx) { return m_offset + m_inputSections[inputIdx].offset; }
 
+  // Get the output file offset of the output section, after calling write().
+  uint64_t getOffset() const { return m_offset; }
+
   // Get the overall alignment requirement, after calling layout().
   uint64_t getAlignment() const { return m_alignment; }
 
+  // Get the size of the section contents in the output ELF, after calling layout().
+  uint64_t getSize();
+
   // Write the output section
-  void write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr);
+  void write(MutableArrayRef<char> outBuffer, ELF::Elf64_Shdr *shdr);
 
 private:
   // Flag that we want to reduce alignment on the given input section, for gluing code together.
@@ -125,6 +174,7 @@ private:
   uint64_t m_offset = 0;                        // File offset of this output section
   SmallVector<InputSection, 4> m_inputSections; // Input sections contributing to this output section
   uint64_t m_alignment = 0;                     // Overall alignment required for the section
+  uint64_t m_size = 0;                          // Size of contributions from input sections, including padding
   unsigned m_reduceAlign = 0;                   // Bitmap of input sections to reduce alignment for
 };
 
@@ -141,6 +191,9 @@ public:
   // -----------------------------------------------------------------------------------------------------------------
   // Implementations of ElfLinker methods exposed to the front-end
 
+  // Reset for another link using the given pipeline and ELFs, keeping buffers from earlier links.
+  void reset(Pipeline *pipeline, ArrayRef<MemoryBufferRef> elfs) override final;
+
   // Add another input ELF to the link, in addition to the ones that were added when the ElfLinker was constructed.
   // The default behavior of adding extra ones at the start of the list instead of the end is just so you
   // get the same order of code (VS then FS) when doing a part-pipeline compile as when doing a whole pipeline
@@ -162,8 +215,12 @@ public:
   // Compile a particular chunk of glue code and retrieve its blob
   StringRef compileGlue(unsigned glueIndex) override final;
 
+  // Compile a particular chunk of glue code in the given LgcContext and retrieve its blob
+  StringRef compileGlue(unsigned glueIndex, LgcContext *lgcContext) override final;
+
   // Link the unlinked shader/part-pipeline ELFs and the compiled glue code into a pipeline ELF
   bool link(raw_pwrite_stream &outStream) override final;
+  bool link(SmallVectorImpl<char> &outBuffer) override final;
 
   // Returns true if the fragment shader uses a builtin input that gets mapped.
   bool fragmentShaderUsesMappedBuiltInInputs() override final;
@@ -172,7 +229,9 @@ public:
   // Accessors
 
   PipelineState *getPipelineState() const { return m_pipelineState; }
-  ArrayRef<OutputSection> getOutputSections() { return m_outputSections; }
+  MutableArrayRef<OutputSection> getOutputSections() {
+    return MutableArrayRef<OutputSection>(m_outputSections).take_front(m_outputSectionCount);
+  }
   StringRef getStrings() { return m_strings; }
   SmallVectorImpl<ELF::Elf64_Sym> &getSymbols() { return m_symbols; }
   SmallVectorImpl<ELF::Elf64_Rel> &getRelocations() { return m_relocations; }
@@ -190,12 +249,18 @@ public:
   unsigned findSymbol(StringRef name);
 
 private:
+  // Add an output section, reusing one left from an earlier link if there is one.
+  unsigned addOutputSection(StringRef name = "", unsigned type = 0);
+
   // Processing when all inputs are done.
   void doneInputs();
 
   // Get the value of the symbol referenced in a reloc
   bool getRelocValue(object::RelocationRef reloc, uint64_t &value);
 
+  // Find the function in the output ELF that a PC-relative reloc refers to
+  unsigned findPcRelRelocTarget(object::RelocationRef reloc);
+
   // Find where an input section contributes to an output section
   std::pair<unsigned, unsigned> findInputSection(ElfInput &elfInput, object::SectionRef section);
 
@@ -211,6 +276,16 @@ private:
   // Insert glue shaders (if any).
   bool insertGlueShaders();
 
+  // Prune the param exports that the fragment shader does not read, updating the PAL metadata.
+  void pruneParamExports();
+
+  // Find the param exports in the code of a shader entry-point.
+  bool findParamExports(MCDisassembler &disassembler, const MCInstrInfo &instrInfo, ArrayRef<uint8_t> code,
+                        SmallVectorImpl<std::pair<uint64_t, unsigned>> &paramExports);
+
+  // Patch the param exports pruned by pruneParamExports in the written output ELF.
+  void applyParamExportPatches(SmallVectorImpl<char> &outBuffer);
+
   // Returns true of the given elf contains just 1 shader.
   bool containsASingleShader(ElfInput &elf);
 
@@ -220,13 +295,16 @@ private:
   SmallVector<std::unique_ptr<GlueShader>, 4> m_glueShaders; // Glue shaders needed for link
   SmallVector<StringRef, 5> m_glueStrings;                   // Strings to return for glue shader cache keys
   ELF::Elf64_Ehdr m_ehdr;                                    // Output ELF header, copied from first input
-  SmallVector<OutputSection, 4> m_outputSections;            // Output sections
+  SmallVector<OutputSection, 4> m_outputSections;            // Output sections, including ones kept from earlier links
+  unsigned m_outputSectionCount = 0;                         // Number of output sections used in this link
   SmallVector<ELF::Elf64_Sym, 8> m_symbols;                  // Symbol table
   SmallVector<ELF::Elf64_Rel, 8> m_relocations;              // Relocations
+  SmallVector<ParamExportPatch, 8> m_paramExportPatches;     // Param exports to patch after writing the code
   StringMap<unsigned> m_symbolMap;                           // Map from name to symbol index
   std::string m_strings;                                     // Strings for string table
-  StringMap<unsigned> m_stringMap;                           // Map from string to string table index
+  StringMap<unsigned, BumpPtrAllocator> m_stringMap;         // Map from string to string table index
   std::string m_notes;                                       // Notes to go in .note section
+  SmallVector<char, 0> m_outputBuffer;                       // Buffer for linking into a stream
   bool m_doneInputs = false;                                 // Set when caller has done adding inputs
 };
 
@@ -257,6 +335,38 @@ inline uint64_t cantFail(uint64_t value, const char *Msg = nullptr) {
 // @param elfs : Array of unlinked ELF modules to link
 ElfLinkerImpl::ElfLinkerImpl(PipelineState *pipelineState, ArrayRef<MemoryBufferRef> elfs)
     : m_pipelineState(pipelineState), m_relocHandler(pipelineState) {
+  reset(pipelineState, elfs);
+}
+
+// =====================================================================================================================
+// Destructor
+ElfLinkerImpl::~ElfLinkerImpl() {
+}
+
+// =====================================================================================================================
+// Reset for another link using the given pipeline and ELFs. The containers are cleared rather than freed, so their
+// buffers (and the string table arena) are reused by the next link.
+//
+// @param pipeline : Pipeline whose state is used for the link
+// @param elfs : Array of unlinked ELF modules to link
+void ElfLinkerImpl::reset(Pipeline *pipeline, ArrayRef<MemoryBufferRef> elfs) {
+  m_pipelineState = static_cast<PipelineState *>(pipeline);
+  m_relocHandler = RelocHandler(m_pipelineState);
+  m_elfInputs.clear();
+  m_glueShaders.clear();
+  m_glueStrings.clear();
+  m_ehdr = {};
+  m_outputSectionCount = 0;
+  m_symbols.clear();
+  m_relocations.clear();
+  m_paramExportPatches.clear();
+  m_symbolMap.clear();
+  m_strings.clear();
+  m_stringMap.clear();
+  m_stringMap.getAllocator().Reset();
+  m_notes.clear();
+  m_doneInputs = false;
+
   m_pipelineState->clearPalMetadata();
 
   // Add ELF inputs supplied here.
@@ -265,8 +375,16 @@ ElfLinkerImpl::ElfLinkerImpl(PipelineState *pipelineState, ArrayRef<MemoryBuffer
 }
 
 // =====================================================================================================================
-// Destructor
-ElfLinkerImpl::~ElfLinkerImpl() {
+// Add an output section, reusing one left from an earlier link if there is one.
+//
+// @param name : Section name; if empty, the name is taken from the first input section
+// @param type : SHT_* section type, or 0 for a section of input sections
+// @returns : Index of the new output section
+unsigned ElfLinkerImpl::addOutputSection(StringRef name, unsigned type) {
+  if (m_outputSectionCount == m_outputSections.size())
+    m_outputSections.push_back(OutputSection(this));
+  m_outputSections[m_outputSectionCount].reset(name, type);
+  return m_outputSectionCount++;
 }
 
 // =====================================================================================================================
@@ -374,7 +492,35 @@ StringRef ElfLinkerImpl::compileGlue(unsigned glueIndex) {
 }
 
 // =====================================================================================================================
-// Link the unlinked shader/part-pipeline ELFs and the compiled glue code into a pipeline ELF.
+// Compile a particular chunk of glue code in the given LgcContext and retrieve its blob. This only touches the
+// GlueShader object for glueIndex, so calls for different glue indices can run concurrently once getGlueInfo() has
+// been called, each with its own LgcContext.
+//
+// @param glueIndex : Index into the array that was returned by getGlueInfo()
+// @param lgcContext : LgcContext to compile the glue code in
+// @returns : The blob, as for compileGlue(unsigned)
+StringRef ElfLinkerImpl::compileGlue(unsigned glueIndex, LgcContext *lgcContext) {
+  assert(m_doneInputs && "Must call ElfLinker::getGlueInfo before compiling glue code in another LgcContext");
+  return m_glueShaders[glueIndex]->getElfBlob(lgcContext);
+}
+
+// =====================================================================================================================
+// Link the unlinked shader/part-pipeline ELFs and the compiled glue code into a pipeline ELF, written to a stream.
+// This links into a buffer kept by the ElfLinker, then writes the buffer to the stream. See the other link() for
+// the ways this can exit.
+//
+// @param [out] outStream : Stream to write linked ELF to
+// @returns : True for success, false if something about the pipeline state stops linking
+bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
+  bool result = link(m_outputBuffer);
+  outStream << StringRef(m_outputBuffer.data(), m_outputBuffer.size());
+  return result;
+}
+
+// =====================================================================================================================
+// Link the unlinked shader/part-pipeline ELFs and the compiled glue code into a pipeline ELF, written directly into
+// the caller's buffer. Everything that affects the size of the output is done first, so the buffer is resized just
+// once, then each section is written in place at its file offset.
 // Three ways this can exit:
 // 1. On success, returns true.
 // 2. Returns false on failure due to something in the shaders or pipeline state making separate
@@ -385,9 +531,10 @@ StringRef ElfLinkerImpl::compileGlue(unsigned glueIndex) {
 //    with LLVMContext::setDiagnosticHandler, although the usefulness of that is limited, as no attempt is
 //    made by LLVM to avoid memory leaks.
 //
-// @param [out] outStream : Stream to write linked ELF to
+// @param [out] outBuffer : Buffer to write linked ELF to
 // @returns : True for success, false if something about the pipeline state stops linking
-bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
+bool ElfLinkerImpl::link(SmallVectorImpl<char> &outBuffer) {
+  outBuffer.clear();
   doneInputs();
 
   // Insert glue shaders (if any).
@@ -396,7 +543,7 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
 
   // Initialize symbol table and string table
   m_symbols.push_back({});
-  m_strings = std::string("", 1);
+  m_strings.assign("", 1);
   m_stringMap[""] = 0;
   // Pre-create four fixed sections at the start:
   // 0: unused (per ELF spec)
@@ -405,14 +552,12 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
   // 3: .text
   // 4: .note
   // 5: .rel.text
-  m_outputSections.push_back(OutputSection(this, "", ELF::SHT_NULL));
-  m_outputSections.push_back(OutputSection(this, ".strtab", ELF::SHT_STRTAB));
-  m_outputSections.push_back(OutputSection(this, ".symtab", ELF::SHT_SYMTAB));
-  unsigned textSectionIdx = m_outputSections.size();
-  m_outputSections.push_back(OutputSection(this, ".text"));
-  unsigned noteSectionIdx = m_outputSections.size();
-  m_outputSections.push_back(OutputSection(this, ".note", ELF::SHT_NOTE));
-  m_outputSections.push_back(OutputSection(this, ".rel.text", ELF::SHT_REL));
+  addOutputSection("", ELF::SHT_NULL);
+  addOutputSection(".strtab", ELF::SHT_STRTAB);
+  addOutputSection(".symtab", ELF::SHT_SYMTAB);
+  unsigned textSectionIdx = addOutputSection(".text");
+  unsigned noteSectionIdx = addOutputSection(".note", ELF::SHT_NOTE);
+  addOutputSection(".rel.text", ELF::SHT_REL);
 
   // Allocate input sections to output sections.
   for (auto &elfInput : m_elfInputs) {
@@ -425,8 +570,8 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
         if (elfInput.reduceAlign != "")
           reduceAlign = name == elfInput.reduceAlign;
         for (unsigned idx = 1;; ++idx) {
-          if (idx == m_outputSections.size()) {
-            m_outputSections.push_back(OutputSection(this));
+          if (idx == m_outputSectionCount) {
+            addOutputSection();
             m_outputSections[idx].addInputSection(elfInput, section, reduceAlign);
             break;
           }
@@ -438,18 +583,10 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
       }
     }
   }
-
-  // Construct uninitialized section table, and write partly-initialized ELF header and uninitialized
-  // section table as a placeholder.
-  assert(outStream.tell() == 0);
-  SmallVector<ELF::Elf64_Shdr, 8> shdrs(m_outputSections.size());
-  m_ehdr.e_shoff = sizeof(m_ehdr);
-  m_ehdr.e_shnum = m_outputSections.size();
-  outStream << StringRef(reinterpret_cast<const char *>(&m_ehdr), sizeof(m_ehdr));
-  outStream << StringRef(reinterpret_cast<const char *>(shdrs.data()), sizeof(ELF::Elf64_Shdr) * shdrs.size());
+  MutableArrayRef<OutputSection> outputSections = getOutputSections();
 
   // Allow each output section to fix its layout. Also ensure that its name is in the string table.
-  for (OutputSection &outputSection : m_outputSections) {
+  for (OutputSection &outputSection : outputSections) {
     outputSection.layout();
     getStringIndex(outputSection.getName());
   }
@@ -463,7 +600,7 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
         if (containingSect != elfInput.objectFile->section_end()) {
           auto outputIndices = findInputSection(elfInput, *containingSect);
           if (outputIndices.first != UINT_MAX)
-            m_outputSections[outputIndices.first].addSymbol(elfSymRef, outputIndices.second);
+            outputSections[outputIndices.first].addSymbol(elfSymRef, outputIndices.second);
         }
       }
     }
@@ -504,7 +641,7 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
               findInputSection(elfInput, *cantFail(section.getRelocatedSection()));
           if (targetSectionIdx != UINT_MAX) {
             uint64_t value = 0;
-            if (getRelocValue(reloc, value)) {
+            if (getRelocValue(reloc, value) || findPcRelRelocTarget(reloc) != 0) {
               continue;
             }
             (void)(textSectionIdx);
@@ -514,31 +651,50 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
             unsigned relocSectionId = UINT_MAX;
             unsigned relocIdxInSection = UINT_MAX;
             std::tie(relocSectionId, relocIdxInSection) = findInputSection(elfInput, relocSection);
-            uint64_t relocSectionOffset = m_outputSections[relocSectionId].getOutputOffset(relocIdxInSection);
-            uint64_t targetSectionOffset = m_outputSections[targetSectionIdx].getOutputOffset(targetIdxInSection);
+            uint64_t relocSectionOffset = outputSections[relocSectionId].getOutputOffset(relocIdxInSection);
+            uint64_t targetSectionOffset = outputSections[targetSectionIdx].getOutputOffset(targetIdxInSection);
             StringRef id = sys::path::filename(elfInput.objectFile->getFileName());
-            m_outputSections[relocSectionId].addRelocation(reloc, id, relocSectionOffset, targetSectionOffset);
+            outputSections[relocSectionId].addRelocation(reloc, id, relocSectionOffset, targetSectionOffset);
           }
         }
       }
     }
   }
 
-  // Output each section, and let it set its section table entry.
+  // Prune the param exports that the fragment shader does not read. This changes the PAL metadata, so must be done
+  // before writing it; the export instructions themselves are patched once the code has been written.
+  pruneParamExports();
+
+  // Write the PAL metadata out into the .note section. The relocations can change the metadata, so we cannot write
+  // the PAL metadata any earlier. The loop above has got the value of every reloc that will be applied below.
+  writePalMetadata();
+
+  // Lay out the output ELF: the ELF header, the section table, then each section. The .note section goes last, as it
+  // always has.
   // Ensure each section is aligned in the file by the minimum of 4 and its address alignment requirement.
   // I am not sure if that is actually required by the ELF standard, but vkgcPipelineDumper.cpp relies on
   // it when dumping .note records.
-  // The .note section will be emitted later.  We must wait until after processing the relocation to have all of the
-  // metadata needed for the .note section.
-  for (unsigned sectionIndex = 0; sectionIndex != shdrs.size(); ++sectionIndex) {
-    if (sectionIndex == noteSectionIdx)
-      continue;
-    OutputSection &outputSection = m_outputSections[sectionIndex];
+  SmallVector<ELF::Elf64_Shdr, 8> shdrs(outputSections.size());
+  m_ehdr.e_shoff = sizeof(m_ehdr);
+  m_ehdr.e_shnum = outputSections.size();
+  uint64_t outputSize = sizeof(m_ehdr) + sizeof(ELF::Elf64_Shdr) * shdrs.size();
+  auto placeSection = [&](unsigned sectionIndex) {
+    OutputSection &outputSection = outputSections[sectionIndex];
     unsigned align = std::min(unsigned(outputSection.getAlignment()), 4U);
-    outStream << StringRef("\0\0\0", 3).slice(0, -outStream.tell() & align - 1);
-    shdrs[sectionIndex].sh_offset = outStream.tell();
-    outputSection.write(outStream, &shdrs[sectionIndex]);
+    outputSize += std::min(uint64_t(3), -outputSize & align - 1);
+    shdrs[sectionIndex].sh_offset = outputSize;
+    outputSize += outputSection.getSize();
+  };
+  for (unsigned sectionIndex = 0; sectionIndex != shdrs.size(); ++sectionIndex) {
+    if (sectionIndex != noteSectionIdx)
+      placeSection(sectionIndex);
   }
+  placeSection(noteSectionIdx);
+
+  // Output each section, and let it set the rest of its section table entry.
+  outBuffer.resize(outputSize);
+  for (unsigned sectionIndex = 0; sectionIndex != shdrs.size(); ++sectionIndex)
+    outputSections[sectionIndex].write(outBuffer, &shdrs[sectionIndex]);
 
   // Apply the relocs
   for (auto &elfInput : m_elfInputs) {
@@ -551,24 +707,49 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
           std::tie(outputSectIdx, withinSectIdx) = findInputSection(elfInput, *cantFail(section.getRelocatedSection()));
           if (outputSectIdx != UINT_MAX) {
             uint64_t value = 0;
-            if (!getRelocValue(reloc, value)) {
+            unsigned pcRelTarget = findPcRelRelocTarget(reloc);
+            if (pcRelTarget == 0 && !getRelocValue(reloc, value)) {
               continue;
             }
 
             uint64_t inputOffset = reloc.getOffset();
-            uint64_t outputOffset = m_outputSections[outputSectIdx].getOutputOffset(withinSectIdx) + inputOffset;
+            uint64_t outputOffset = outputSections[outputSectIdx].getOutputOffset(withinSectIdx) + inputOffset;
             uint64_t addend = 0;
             if (sectType == ELF::SHT_RELA)
               addend = cantFail(object::ELFRelocationRef(reloc).getAddend());
+            if (pcRelTarget != 0) {
+              // The value of a PC-relative reloc is the offset of the function from the relocated location.
+              const ELF::Elf64_Sym &sym = m_symbols[pcRelTarget];
+              value = outputSections[sym.st_shndx].getOffset() + sym.st_value - outputOffset;
+            }
             switch (reloc.getType()) {
 
+            case ELF::R_AMDGPU_REL32:
+            case ELF::R_AMDGPU_REL32_LO: {
+              uint32_t inst = addend + value;
+              memcpy(&outBuffer[outputOffset], &inst, sizeof(inst));
+              break;
+            }
+
+            case ELF::R_AMDGPU_REL32_HI: {
+              uint32_t inst = (addend + value) >> 32;
+              memcpy(&outBuffer[outputOffset], &inst, sizeof(inst));
+              break;
+            }
+
+            case ELF::R_AMDGPU_REL64: {
+              uint64_t data = addend + value;
+              memcpy(&outBuffer[outputOffset], &data, sizeof(data));
+              break;
+            }
+
             case ELF::R_AMDGPU_ABS32: {
               StringRef contents = cantFail(cantFail(section.getRelocatedSection())->getContents());
               assert(inputOffset + sizeof(uint32_t) <= contents.size() && "Out of range reloc offset");
               if (sectType == ELF::SHT_REL)
                 addend = *reinterpret_cast<const uint32_t *>(contents.data() + inputOffset);
               uint32_t inst = addend + value;
-              outStream.pwrite(reinterpret_cast<const char *>(&inst), sizeof(inst), outputOffset);
+              memcpy(&outBuffer[outputOffset], &inst, sizeof(inst));
               break;
             }
 
@@ -581,21 +762,15 @@ bool ElfLinkerImpl::link(raw_pwrite_stream &outStream) {
     }
   }
 
-  // Write the PAL metadata out into the .note section.  The relocations can change the metadata, so we cannot write the
-  // PAL metadata any earlier.
-  writePalMetadata();
+  // Patch the pruned param exports.
+  applyParamExportPatches(outBuffer);
 
-  // Output the note section now that the metadata has been finalized.
-  OutputSection &noteOutputSection = m_outputSections[noteSectionIdx];
-  unsigned align = std::min(unsigned(noteOutputSection.getAlignment()), 4U);
-  outStream << StringRef("\0\0\0", 3).slice(0, -outStream.tell() & align - 1);
-  shdrs[noteSectionIdx].sh_offset = outStream.tell();
-  noteOutputSection.write(outStream, &shdrs[noteSectionIdx]);
+  // Write the now-complete ELF header and section table.
+  memcpy(outBuffer.data(), &m_ehdr, sizeof(m_ehdr));
+  memcpy(outBuffer.data() + sizeof(m_ehdr), shdrs.data(), sizeof(ELF::Elf64_Shdr) * shdrs.size());
 
-  // Go back and write the now-complete ELF header and section table.
-  outStream.pwrite(reinterpret_cast<const char *>(&m_ehdr), sizeof(m_ehdr), 0);
-  outStream.pwrite(reinterpret_cast<const char *>(shdrs.data()), sizeof(ELF::Elf64_Shdr) * shdrs.size(),
-                   sizeof(m_ehdr));
+  if (isIsaStatsEnabled())
+    addIsaStatsToElf(outBuffer, *m_pipelineState->getLgcContext()->getTargetMachine(), LgcContext::getLgcOuts());
 
   return m_pipelineState->getLastError() == "";
 }
@@ -664,6 +839,30 @@ bool ElfLinkerImpl::getRelocValue(object::RelocationRef reloc, uint64_t &value)
   return false;
 }
 
+// =====================================================================================================================
+// Find the function in the output ELF that a PC-relative reloc refers to, such as a call from a compute shader to a
+// function of a compute library linked with it. Such a reloc is resolved by the link, as the offset between the
+// relocated location and the function is known once the code is laid out.
+//
+// @param reloc : The relocation
+// @returns : Index of the function in the output symbol table, or 0 if the reloc is not a PC-relative one to a function
+//            defined in one of the input ELFs
+unsigned ElfLinkerImpl::findPcRelRelocTarget(object::RelocationRef reloc) {
+  switch (reloc.getType()) {
+  case ELF::R_AMDGPU_REL32:
+  case ELF::R_AMDGPU_REL32_LO:
+  case ELF::R_AMDGPU_REL32_HI:
+  case ELF::R_AMDGPU_REL64:
+    break;
+  default:
+    return 0;
+  }
+  unsigned symIdx = findSymbol(cantFail(reloc.getSymbol()->getName()));
+  if (symIdx == 0 || m_symbols[symIdx].getType() != ELF::STT_FUNC)
+    return 0;
+  return symIdx;
+}
+
 // =====================================================================================================================
 // Find where an input section contributes to an output section
 //
@@ -822,6 +1021,204 @@ bool ElfLinkerImpl::containsASingleShader(ElfInput &elf) {
   return true;
 }
 
+// =====================================================================================================================
+// Prune the param exports of the vertex-processing stage that the fragment shader does not read, when linking shaders
+// that were compiled separately, and so without knowing which of its outputs the next stage reads. The FS input
+// mappings from the FS compile give the interpolant slots that the FS reads, and its SPI_PS_INPUT_CNTL registers give
+// the param that each slot reads. The params that are read are renumbered to be contiguous, which reduces the
+// parameter cache allocated for each vertex. This updates the PAL metadata now, and records the export instructions
+// to patch once the code has been written. Nothing is changed if any of the code cannot be decoded.
+void ElfLinkerImpl::pruneParamExports() {
+  PalMetadata *palMetadata = m_pipelineState->getPalMetadata();
+  if (!PruneParamExports || !m_pipelineState->isGraphics() || !palMetadata->haveFsInputMappings())
+    return;
+
+  // Leave alone a vertex-processing stage with no param exports or with per-primitive exports.
+  SPI_VS_OUT_CONFIG spiVsOutConfig;
+  spiVsOutConfig.u32All = palMetadata->getRegister(mmSPI_VS_OUT_CONFIG);
+  if (spiVsOutConfig.bits.NO_PC_EXPORT || spiVsOutConfig.bits.PRIM_EXPORT_COUNT != 0)
+    return;
+
+  // Find the interpolant slots that the FS reads.
+  SPI_PS_IN_CONTROL spiPsInControl;
+  spiPsInControl.u32All = palMetadata->getRegister(mmSPI_PS_IN_CONTROL);
+  const unsigned numInterp = spiPsInControl.bits.NUM_INTERP;
+  SmallVector<SPI_PS_INPUT_CNTL, 32> spiPsInputCntls(numInterp);
+  for (unsigned slot = 0; slot != numInterp; ++slot)
+    spiPsInputCntls[slot].u32All = palMetadata->getRegister(mmSPI_PS_INPUT_CNTL_0 + slot);
+
+  FsInputMappings fsInputMappings;
+  palMetadata->retrieveFragmentInputInfo(fsInputMappings);
+  BitVector usedSlots(numInterp + 1);
+  for (std::pair<unsigned, unsigned> mapping : fsInputMappings.locationInfo) {
+    unsigned slot = std::min(InOutLocationInfo(mapping.second).getLocation(), numInterp);
+    usedSlots.set(slot);
+    // A 64-bit input also reads the next slot, which is always flat shaded.
+    if (slot + 1 < numInterp && spiPsInputCntls[slot + 1].bits.FLAT_SHADE)
+      usedSlots.set(slot + 1);
+  }
+  for (std::pair<unsigned, unsigned> mapping : fsInputMappings.builtInLocationInfo) {
+    // A clip or cull distance array may read two slots.
+    usedSlots.set(std::min(mapping.second, numInterp));
+    usedSlots.set(std::min(mapping.second + 1, numInterp));
+  }
+
+  // Find the params that those slots read. An offset with the "use default value" bit set reads no param, unless
+  // it is flat shaded, which is how a custom interpolated input reads its param directly.
+  constexpr unsigned UseDefaultVal = 1 << 5;
+  constexpr unsigned MaxParams = UseDefaultVal;
+  BitVector usedParams(MaxParams);
+  for (unsigned slot = 0; slot != numInterp; ++slot) {
+    const SPI_PS_INPUT_CNTL &spiPsInputCntl = spiPsInputCntls[slot];
+    if (usedSlots[slot] && ((spiPsInputCntl.bits.OFFSET & UseDefaultVal) == 0 || spiPsInputCntl.bits.FLAT_SHADE))
+      usedParams.set(spiPsInputCntl.bits.OFFSET & (MaxParams - 1));
+  }
+
+  // Find the param exports in the vertex-processing stage: the hardware VS, or the hardware GS for NGG. The code
+  // for an entry-point that has a fetch shader glued on is still under its fetchless name in the inputs.
+  TargetMachine *targetMachine = m_pipelineState->getLgcContext()->getTargetMachine();
+  const MCSubtargetInfo &subtargetInfo = *targetMachine->getMCSubtargetInfo();
+  MCContext context(targetMachine->getTargetTriple(), targetMachine->getMCAsmInfo(),
+                    targetMachine->getMCRegisterInfo(), &subtargetInfo);
+  std::unique_ptr<MCDisassembler> disassembler(targetMachine->getTarget().createMCDisassembler(subtargetInfo, context));
+  if (!disassembler)
+    return;
+
+  SmallVector<ParamExportPatch, 8> patches;
+  SmallVector<std::pair<uint64_t, unsigned>, 8> paramExports;
+  for (auto &elfInput : m_elfInputs) {
+    for (object::SymbolRef symRef : elfInput.objectFile->symbols()) {
+      StringRef name = cantFail(symRef.getName());
+      if (name != Util::Abi::AmdGpuVsEntryName && name != Util::Abi::AmdGpuGsEntryName &&
+          name != FetchlessVsEntryName && name != FetchlessGsEntryName)
+        continue;
+      object::section_iterator containingSect = cantFail(symRef.getSection());
+      if (containingSect == elfInput.objectFile->section_end())
+        continue;
+      unsigned outputSectIdx = UINT_MAX;
+      unsigned withinSectIdx = UINT_MAX;
+      std::tie(outputSectIdx, withinSectIdx) = findInputSection(elfInput, *containingSect);
+      if (outputSectIdx == UINT_MAX)
+        continue;
+
+      StringRef contents = cantFail(containingSect->getContents());
+      uint64_t symValue = cantFail(symRef.getValue());
+      uint64_t symSize = object::ELFSymbolRef(symRef).getSize();
+      if (symValue + symSize > contents.size())
+        return;
+      ArrayRef<uint8_t> code(reinterpret_cast<const uint8_t *>(contents.data()) + symValue, symSize);
+      paramExports.clear();
+      if (!findParamExports(*disassembler, *targetMachine->getMCInstrInfo(), code, paramExports))
+        return;
+      for (std::pair<uint64_t, unsigned> paramExport : paramExports) {
+        if (paramExport.second >= MaxParams)
+          return;
+        patches.push_back({outputSectIdx, withinSectIdx, symValue + paramExport.first, paramExport.second});
+      }
+    }
+  }
+  if (patches.empty())
+    return;
+
+  // Renumber the used params to be contiguous, and remove the exports of the others.
+  SmallVector<unsigned, MaxParams> newParams(MaxParams, UINT_MAX);
+  unsigned newParamCount = 0;
+  for (unsigned param : usedParams.set_bits())
+    newParams[param] = newParamCount++;
+  unsigned newExportCount = 0;
+  bool changed = false;
+  for (ParamExportPatch &patch : patches) {
+    changed |= newParams[patch.newParam] != patch.newParam;
+    patch.newParam = newParams[patch.newParam];
+    if (patch.newParam != UINT_MAX)
+      newExportCount = std::max(newExportCount, patch.newParam + 1);
+  }
+  // Leave the code alone if none of the exports is still used, as the hardware may need at least one param export.
+  if (!changed || newExportCount == 0)
+    return;
+
+  // Update the PAL metadata. A slot that the FS does not read is set to use the default value, so it does not refer
+  // to a param that is no longer exported.
+  for (unsigned slot = 0; slot != numInterp; ++slot) {
+    SPI_PS_INPUT_CNTL spiPsInputCntl = spiPsInputCntls[slot];
+    if ((spiPsInputCntl.bits.OFFSET & UseDefaultVal) && !spiPsInputCntl.bits.FLAT_SHADE)
+      continue;
+    if (usedSlots[slot]) {
+      unsigned param = spiPsInputCntl.bits.OFFSET & (MaxParams - 1);
+      spiPsInputCntl.bits.OFFSET = (spiPsInputCntl.bits.OFFSET & UseDefaultVal) | newParams[param];
+    } else {
+      spiPsInputCntl.bits.OFFSET = UseDefaultVal;
+      spiPsInputCntl.bits.FLAT_SHADE = false;
+    }
+    palMetadata->setRegister(mmSPI_PS_INPUT_CNTL_0 + slot, spiPsInputCntl.u32All);
+  }
+  spiVsOutConfig.bits.VS_EXPORT_COUNT = std::min(unsigned(spiVsOutConfig.bits.VS_EXPORT_COUNT), newExportCount - 1);
+  palMetadata->setRegister(mmSPI_VS_OUT_CONFIG, spiVsOutConfig.u32All);
+
+  m_paramExportPatches = std::move(patches);
+}
+
+// =====================================================================================================================
+// Find the param exports in the code of a shader entry-point.
+//
+// @param disassembler : Disassembler for the target
+// @param instrInfo : Instruction info for the target
+// @param code : The code of the entry-point
+// @param [out] paramExports : {offset within code, param number} for each param export found
+// @returns : False if the code could not be decoded
+bool ElfLinkerImpl::findParamExports(MCDisassembler &disassembler, const MCInstrInfo &instrInfo, ArrayRef<uint8_t> code,
+                                     SmallVectorImpl<std::pair<uint64_t, unsigned>> &paramExports) {
+  // Export target field in the first dword of an export instruction, and the first param target.
+  constexpr unsigned ExpTargetShift = 4;
+  constexpr unsigned ExpTargetMask = 0x3F;
+  constexpr unsigned ExpDoneBit = 1 << 11;
+  constexpr unsigned ExpParam0 = 32;
+
+  for (uint64_t offset = 0; offset < code.size();) {
+    MCInst inst;
+    uint64_t size = 0;
+    if (disassembler.getInstruction(inst, size, code.slice(offset), offset, nulls()) != MCDisassembler::Success ||
+        size == 0)
+      return false;
+    if (instrInfo.getName(inst.getOpcode()).startswith("EXP")) {
+      uint32_t dword0 = support::endian::read32le(code.data() + offset);
+      unsigned target = (dword0 >> ExpTargetShift) & ExpTargetMask;
+      // Do not touch an export with the done bit set, as that would leave the shader without its final export.
+      if (target >= ExpParam0 && (dword0 & ExpDoneBit) == 0)
+        paramExports.push_back({offset, target - ExpParam0});
+    }
+    offset += size;
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Patch the param exports pruned by pruneParamExports in the written output ELF: a removed export is replaced by
+// two s_nop instructions, and a kept one has its target changed to the new param number.
+//
+// @param [in/out] outBuffer : Buffer containing output ELF
+void ElfLinkerImpl::applyParamExportPatches(SmallVectorImpl<char> &outBuffer) {
+  constexpr unsigned ExpTargetShift = 4;
+  constexpr unsigned ExpTargetMask = 0x3F;
+  constexpr unsigned ExpParam0 = 32;
+  constexpr uint32_t SNop = 0xBF800000;
+
+  MutableArrayRef<OutputSection> outputSections = getOutputSections();
+  for (const ParamExportPatch &patch : m_paramExportPatches) {
+    OutputSection &outputSection = outputSections[patch.outputSectIdx];
+    char *inst = &outBuffer[outputSection.getOutputOffset(patch.withinSectIdx) + patch.inputOffset];
+    if (patch.newParam == UINT_MAX) {
+      support::endian::write32le(inst, SNop);
+      support::endian::write32le(inst + 4, SNop);
+      continue;
+    }
+    uint32_t dword0 = support::endian::read32le(inst);
+    dword0 &= ~(ExpTargetMask << ExpTargetShift);
+    dword0 |= (ExpParam0 + patch.newParam) << ExpTargetShift;
+    support::endian::write32le(inst, dword0);
+  }
+}
+
 // =====================================================================================================================
 // Add an input section to this output section
 //
@@ -858,6 +1255,21 @@ unsigned OutputSection::getIndex() {
   return this - m_linker->getOutputSections().data();
 }
 
+// =====================================================================================================================
+// Reset to an empty output section, keeping the buffer for input sections for reuse by the next link
+//
+// @param name : Section name; if empty, the name is taken from the first input section
+// @param type : SHT_* section type, or 0 for a section of input sections
+void OutputSection::reset(StringRef name, unsigned type) {
+  m_name = name;
+  m_type = type;
+  m_offset = 0;
+  m_inputSections.clear();
+  m_alignment = 0;
+  m_size = 0;
+  m_reduceAlign = 0;
+}
+
 // =====================================================================================================================
 // Set the layout of this output section, allowing for alignment required by input sections.
 // Also copy global symbols for each input section to the output ELF's symbol table.
@@ -893,19 +1305,50 @@ void OutputSection::layout() {
   }
   if (m_type == ELF::SHT_NOTE)
     m_alignment = 4;
+
+  if (!m_inputSections.empty() &&
+      (object::ELFSectionRef(m_inputSections[0].sectionRef).getFlags() & ELF::SHF_EXECINSTR) &&
+      m_linker->getPipelineState()->getTargetInfo().getGfxIpVersion().major >= 10) {
+    // On GFX10 in .text, write() adds padding at the end of the section: align to an instruction cache line
+    // boundary, then add another 3 cache lines worth of padding.
+    size += (-size & (CacheLineSize - 1)) + 3 * CacheLineSize;
+  }
+  m_size = size;
+}
+
+// =====================================================================================================================
+// Get the size of the section contents in the output ELF, after calling layout(). For the string table, symbol
+// table, relocation and .note sections, this is only final once the linker has finished adding to them.
+uint64_t OutputSection::getSize() {
+  switch (m_type) {
+  case ELF::SHT_STRTAB:
+    return m_linker->getStrings().size();
+  case ELF::SHT_SYMTAB:
+    return m_linker->getSymbols().size() * sizeof(ELF::Elf64_Sym);
+  case ELF::SHT_NOTE:
+    return m_linker->getNotes().size();
+  case ELF::SHT_REL:
+    return m_linker->getRelocations().size() * sizeof(ELF::Elf64_Rel);
+  default:
+    return m_size;
+  }
 }
 
 // =====================================================================================================================
 // Get alignment for an input section. This takes into account the reduceAlign flag, reducing the alignment
-// from 0x100 to 0x40 when gluing code together.
+// from 0x100 to 0x40 when gluing code together. Code is always at least aligned to an instruction cache line, so that
+// a wave starting at an entry point, or running on into glue code, never fetches a cache line shared with the end of
+// the code before it.
 //
 // @param inputSection : InputSection
 uint64_t OutputSection::getAlignment(const InputSection &inputSection) {
   uint64_t alignment = inputSection.sectionRef.getAlignment();
   // Check if alignment is reduced for this section
   // for gluing code together.
-  if (alignment > 0x40 && getReduceAlign(inputSection))
-    alignment = 0x40;
+  if (alignment > CacheLineSize && getReduceAlign(inputSection))
+    alignment = CacheLineSize;
+  if (object::ELFSectionRef(inputSection.sectionRef).getFlags() & ELF::SHF_EXECINSTR)
+    alignment = std::max(alignment, CacheLineSize);
   return alignment;
 }
 
@@ -956,20 +1399,40 @@ void OutputSection::addRelocation(object::ELFRelocationRef relocRef, StringRef i
 }
 
 // =====================================================================================================================
-// Write the output section
+// Write alignment padding into an output section, repeating a pattern such that it stays aligned to PaddingUnit
+// within the section.
 //
-// @param [in/out] outStream : Stream to write the section to
+// @param [out] sectionData : Start of the output section's contents
+// @param pattern : Padding pattern, PaddingUnit bytes long
+// @param start : Offset within the section at which to start the padding
+// @param length : Number of bytes of padding
+static void writePadding(char *sectionData, const char *pattern, uint64_t start, uint64_t length) {
+  for (uint64_t offset = start, end = start + length; offset != end;) {
+    size_t thisSize = std::min(end - offset, PaddingUnit - (offset & (PaddingUnit - 1)));
+    memcpy(sectionData + offset, &pattern[offset & (PaddingUnit - 1)], thisSize);
+    offset += thisSize;
+  }
+}
+
+// =====================================================================================================================
+// Write the output section into the output ELF at its file offset, as already set in the section header. This must
+// be called after layout(), and after the linker has finished adding to the string table, symbol table, relocations
+// and notes.
+//
+// @param [in/out] outBuffer : Output ELF, already sized to hold all sections
 // @param [in/out] shdr : ELF section header to write to (but not sh_offset)
-void OutputSection::write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr) {
+void OutputSection::write(MutableArrayRef<char> outBuffer, ELF::Elf64_Shdr *shdr) {
   shdr->sh_name = m_linker->getStringIndex(getName());
-  m_offset = outStream.tell();
+  m_offset = shdr->sh_offset;
+  assert(m_offset + getSize() <= outBuffer.size());
+  char *sectionData = outBuffer.data() + m_offset;
 
   if (m_type == ELF::SHT_STRTAB) {
     StringRef strings = m_linker->getStrings();
     shdr->sh_type = m_type;
     shdr->sh_size = strings.size();
     m_linker->setStringTableIndex(getIndex());
-    outStream << strings;
+    memcpy(sectionData, strings.data(), strings.size());
     return;
   }
 
@@ -979,7 +1442,7 @@ void OutputSection::write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr) {
     shdr->sh_size = symbols.size() * sizeof(ELF::Elf64_Sym);
     shdr->sh_entsize = sizeof(ELF::Elf64_Sym);
     shdr->sh_link = 1; // Section index of string table
-    outStream << StringRef(reinterpret_cast<const char *>(symbols.data()), symbols.size() * sizeof(ELF::Elf64_Sym));
+    memcpy(sectionData, symbols.data(), shdr->sh_size);
     return;
   }
 
@@ -987,7 +1450,7 @@ void OutputSection::write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr) {
     StringRef notes = m_linker->getNotes();
     shdr->sh_type = m_type;
     shdr->sh_size = notes.size();
-    outStream << notes;
+    memcpy(sectionData, notes.data(), notes.size());
     return;
   }
 
@@ -998,8 +1461,7 @@ void OutputSection::write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr) {
     shdr->sh_entsize = sizeof(ELF::Elf64_Rel);
     shdr->sh_link = 2; // Section index of symbol table
     shdr->sh_info = 3; // Section index of the .text section
-    outStream << StringRef(reinterpret_cast<const char *>(relocations.data()),
-                           relocations.size() * sizeof(ELF::Elf64_Sym));
+    memcpy(sectionData, relocations.data(), shdr->sh_size);
     return;
   }
 
@@ -1011,47 +1473,29 @@ void OutputSection::write(raw_pwrite_stream &outStream, ELF::Elf64_Shdr *shdr) {
   shdr->sh_flags = object::ELFSectionRef(m_inputSections[0].sectionRef).getFlags();
 
   // Set up the pattern we will use for alignment padding.
-  const size_t paddingUnit = 16;
   const char *padding = "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
-  const char *endPadding = nullptr;
+  const char *endPadding = "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
   if (shdr->sh_flags & ELF::SHF_EXECINSTR) {
-    padding = "\0\0\x80\xBF\0\0\x80\xBF\0\0\x80\xBF\0\0\x80\xBF"; // s_nop
-    if (m_linker->getPipelineState()->getTargetInfo().getGfxIpVersion().major >= 10)
-      endPadding = "\0\0\x9F\xBF\0\0\x9F\xBF\0\0\x9F\xBF\0\0\x9F\xBF"; // s_code_end
+    padding = "\0\0\x80\xBF\0\0\x80\xBF\0\0\x80\xBF\0\0\x80\xBF";    // s_nop
+    endPadding = "\0\0\x9F\xBF\0\0\x9F\xBF\0\0\x9F\xBF\0\0\x9F\xBF"; // s_code_end
   }
 
-  // Output the contributions from the input sections.
+  // Output the contributions from the input sections, at the offsets chosen by layout().
   uint64_t size = 0;
   for (InputSection &inputSection : m_inputSections) {
     assert(m_alignment >= getAlignment(inputSection));
     // Gain alignment as required for the next input section.
-    uint64_t alignmentGap = -size & (getAlignment(inputSection) - 1);
-    while (alignmentGap != 0) {
-      size_t thisSize = std::min(alignmentGap, paddingUnit - (size & (paddingUnit - 1)));
-      outStream << StringRef(&padding[size & (paddingUnit - 1)], thisSize);
-      alignmentGap -= thisSize;
-      size += thisSize;
-    }
+    writePadding(sectionData, padding, size, inputSection.offset - size);
 
     // Write the input section
     StringRef contents = cantFail(inputSection.sectionRef.getContents());
-    outStream << contents.slice(0, inputSection.size);
-    size += inputSection.size;
+    memcpy(sectionData + inputSection.offset, contents.data(), inputSection.size);
+    size = inputSection.offset + inputSection.size;
   }
 
-  if (endPadding) {
-    // On GFX10 in .text, also add padding at the end of the section: align to an instruction cache line
-    // boundary, then add another 3 cache lines worth of padding.
-    uint64_t cacheLineSize = 64;
-    uint64_t alignmentGap = (-size & (cacheLineSize - 1)) + 3 * cacheLineSize;
-    while (alignmentGap != 0) {
-      size_t thisSize = std::min(alignmentGap, paddingUnit - (size & (paddingUnit - 1)));
-      outStream << StringRef(&endPadding[size & (paddingUnit - 1)], thisSize);
-      alignmentGap -= thisSize;
-      size += thisSize;
-    }
-  }
+  // On GFX10 in .text, layout() also allowed for padding at the end of the section.
+  writePadding(sectionData, endPadding, size, m_size - size);
 
-  shdr->sh_size = size;
+  shdr->sh_size = m_size;
   shdr->sh_addralign = m_alignment;
 }
@@ -86,6 +86,7 @@ Module *FetchShader::generate() {
 
   // Process each vertex input.
   std::unique_ptr<VertexFetch> vertexFetch(VertexFetch::create(m_lgcContext));
+  vertexFetch->coalesceFetches(m_fetchDescriptions);
   auto ret = cast<ReturnInst>(fetchFunc->back().getTerminator());
   Value *result = ret->getOperand(0);
   BuilderBase builder(ret);
@@ -39,10 +39,16 @@ using namespace lgc;
 using namespace llvm;
 
 // =====================================================================================================================
-// Compile the glue shader
+// Compile the glue shader. Generating a glue shader does not use the pipeline state or the pipeline's LLVMContext, so
+// it can be done in some other LgcContext for the same target, which lets a client compile the glue shaders of a link
+// concurrently, each on a thread with its own LgcContext.
 //
 // @param [in/out] outStream : Stream to write ELF to
-void GlueShader::compile(raw_pwrite_stream &outStream) {
+// @param lgcContext : LgcContext to compile in, whose PassManagerCache is used
+void GlueShader::compile(raw_pwrite_stream &outStream, LgcContext *lgcContext) {
+  LgcContext *pipelineLgcContext = m_lgcContext;
+  m_lgcContext = lgcContext;
+
   // Generate the glue shader IR module.
   std::unique_ptr<Module> module(generate());
 
@@ -55,6 +61,7 @@ void GlueShader::compile(raw_pwrite_stream &outStream) {
   LegacyPassManager &passManager = m_lgcContext->getPassManagerCache()->getGlueShaderPassManager(outStream);
   passManager.run(*module);
   m_lgcContext->getPassManagerCache()->resetStream();
+  m_lgcContext = pipelineLgcContext;
 }
 
 // =====================================================================================================================
@@ -60,11 +60,12 @@ public:
   // that the front-end client can use as a cache key to avoid compiling the same glue shader more than once.
   virtual llvm::StringRef getString() = 0;
 
-  // Get the ELF blob for this glue shader, compiling if not already compiled.
-  llvm::StringRef getElfBlob() {
+  // Get the ELF blob for this glue shader, compiling if not already compiled. It is compiled in the given
+  // LgcContext if one is supplied, otherwise in the pipeline's one.
+  llvm::StringRef getElfBlob(LgcContext *lgcContext = nullptr) {
     if (m_elfBlob.empty()) {
       llvm::raw_svector_ostream outStream(m_elfBlob);
-      compile(outStream);
+      compile(outStream, lgcContext ? lgcContext : m_lgcContext);
     }
     return m_elfBlob;
   }
@@ -91,15 +92,15 @@ public:
 protected:
   GlueShader(LgcContext *lgcContext) : m_lgcContext(lgcContext) {}
 
-  // Compile the glue shader
-  void compile(llvm::raw_pwrite_stream &outStream);
+  // Compile the glue shader in the given LgcContext
+  void compile(llvm::raw_pwrite_stream &outStream, LgcContext *lgcContext);
 
   // Generate the IR module for the glue shader
   virtual llvm::Module *generate() = 0;
 
   llvm::LLVMContext &getContext() const { return m_lgcContext->getContext(); }
 
-  LgcContext *m_lgcContext;
+  LgcContext *m_lgcContext; // LgcContext to generate the glue shader in; the pipeline's one except during compile()
 
 private:
   llvm::SmallString<0> m_elfBlob;
@@ -136,23 +136,22 @@ bool RelocHandler::getValue(StringRef name, uint64_t &value) {
   }
 
   if (name.startswith(reloc::DescriptorUseSpillTable)) {
-    // If the corresponding node is a root node and the type is DescriptorBuffer, use the spill table to get the
-    // descriptor pointer.
+    // If the corresponding node is a root node, use the spill table to get the descriptor pointer.
     unsigned descSet = 0;
     unsigned binding = 0;
-    // We don't care about typeLetter. This should always be 'b' for DescriptorBuffers.
     ResourceNodeType type = ResourceNodeType::Unknown;
     StringRef suffix = name.drop_front(strlen(reloc::DescriptorUseSpillTable));
     if (parseDescSetBinding(suffix, descSet, binding, type)) {
+      // The reloc for a DescriptorBuffer has no type letter.
+      if (type == ResourceNodeType::Unknown)
+        type = ResourceNodeType::DescriptorBuffer;
       const ResourceNode *outerNode = nullptr;
       const ResourceNode *node = nullptr;
-      std::tie(outerNode, node) =
-          getPipelineState()->findResourceNode(ResourceNodeType::DescriptorBuffer, descSet, binding);
+      std::tie(outerNode, node) = getPipelineState()->findResourceNode(type, descSet, binding);
 
       if (!node)
         report_fatal_error("No resource node for " + name);
 
-      assert(node->type == ResourceNodeType::DescriptorBuffer);
       // Check if this is a top-level node.
       value = (node == outerNode) ? 1 : 0;
 
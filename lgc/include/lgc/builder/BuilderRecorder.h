@@ -31,9 +31,9 @@
 #pragma once
 
 #include "lgc/Builder.h"
-#ifndef NDEBUG
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/ValueHandle.h"
-#endif
+#include <tuple>
 
 namespace llvm {
 
@@ -180,6 +180,7 @@ public:
     CooperativeMatrixBinaryOp,
     CooperativeMatrixExtract,
     CooperativeMatrixConstruct,
+    CooperativeMatrixMulAdd,
 
     // Misc.
     EmitVertex,
@@ -524,6 +525,8 @@ public:
                                               const llvm::Twine &instName = "") override final;
   llvm::Value *CreateCooperativeMatrixConstruct(llvm::Value *coopMatRow, llvm::Value *constVal,
                                                 const llvm::Twine &instName = "") override final;
+  llvm::Value *CreateCooperativeMatrixMulAdd(llvm::Value *matrixA, llvm::Value *matrixB, llvm::Value *matrixC,
+                                             bool isSigned, const llvm::Twine &instName = "") override final;
 
   // -----------------------------------------------------------------------------------------------------------------
   // Subgroup operations
@@ -591,6 +594,9 @@ private:
   PipelineState *m_pipelineState;             // PipelineState; nullptr for shader compile
   std::unique_ptr<ShaderModes> m_shaderModes; // ShaderModes for a shader compile
   bool m_omitOpcodes;                         // Omit opcodes on lgc.create.* function declarations
+  // lgc.create.* function declarations already used, by module, opcode and return type, so that recording a call
+  // does not need to mangle its name and look it up
+  llvm::DenseMap<std::tuple<llvm::Module *, unsigned, llvm::Type *>, llvm::WeakVH> m_callees;
 };
 
 // Create BuilderReplayer pass
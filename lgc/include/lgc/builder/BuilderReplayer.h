@@ -52,6 +52,8 @@ private:
 
   llvm::Value *processCall(unsigned opcode, llvm::CallInst *call);
 
+  llvm::Value *foldExpansion(llvm::Instruction *begin, llvm::CallInst *call, llvm::Value *newValue);
+
   std::unique_ptr<Builder> m_builder;                       // The LLPC builder that the builder
                                                             //  calls are being replayed on.
   std::map<llvm::Function *, ShaderStage> m_shaderStageMap; // Map function -> shader stage
@@ -62,7 +62,7 @@ public:
   FragColorExport(llvm::LLVMContext *context, PipelineState *pipelineState);
 
   llvm::Value *handleColorExportInstructions(llvm::Value *output, unsigned int hwColorTarget, BuilderBase &builder,
-                                             ExportFormat expFmt, const bool signedness);
+                                             ExportFormat expFmt, const bool signedness, unsigned channelMask = 0xF);
 
   void generateExportInstructions(llvm::ArrayRef<lgc::ColorExportInfo> info, llvm::ArrayRef<llvm::Value *> values,
                                   llvm::ArrayRef<ExportFormat> exportFormat, bool dummyExport, BuilderBase &builder);
@@ -129,6 +129,7 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override {
     analysisUsage.addRequired<LegacyPipelineStateWrapper>();
     analysisUsage.addRequired<LegacyPipelineShaders>();
+    analysisUsage.addPreserved<LegacyPipelineShaders>();
   }
 
   virtual bool runOnModule(llvm::Module &module) override;
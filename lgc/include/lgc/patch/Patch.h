@@ -46,23 +46,31 @@ class PassManager;
 
 void initializeLegacyLowerFragColorExportPass(PassRegistry &);
 void initializeLegacyLowerVertexFetchPass(PassRegistry &);
-void initializePatchBufferOpPass(PassRegistry &);
+void initializeLegacyPatchBufferOpPass(PassRegistry &);
 void initializeLegacyPatchCheckShaderCachePass(PassRegistry &);
 void initializeLegacyPatchCopyShaderPass(PassRegistry &);
 void initializeLegacyPatchEntryPointMutatePass(PassRegistry &);
 void initializeLegacyPatchInOutImportExportPass(PassRegistry &);
-void initializePatchLlvmIrInclusionPass(PassRegistry &);
+void initializeLegacyPatchLlvmIrInclusionPass(PassRegistry &);
 void initializeLegacyPatchLoadScalarizerPass(PassRegistry &);
 void initializeLegacyPatchLoopMetadataPass(PassRegistry &);
 void initializeLegacyPatchNullFragShaderPass(PassRegistry &);
 void initializeLegacyPatchPeepholeOptPass(PassRegistry &);
 void initializeLegacyPatchPreparePipelineAbiPass(PassRegistry &);
 void initializeLegacyPatchResourceCollectPass(PassRegistry &);
-void initializePatchSetupTargetFeaturesPass(PassRegistry &);
+void initializeLegacyPatchSetupTargetFeaturesPass(PassRegistry &);
 void initializeLegacyPatchWorkaroundsPass(PassRegistry &);
 void initializeLegacyPatchReadFirstLanePass(PassRegistry &);
+void initializeLegacyPatchHoistDescLoadsPass(PassRegistry &);
+void initializeLegacyPatchHoistGetPcPass(PassRegistry &);
+void initializeLegacyPatchHoistUniformOpsPass(PassRegistry &);
+void initializeLegacyPatchBufferLoadCombinePass(PassRegistry &);
+void initializeLegacyPatchAtomicAggregatePass(PassRegistry &);
+void initializeLegacyPatchImageOpCombinePass(PassRegistry &);
+void initializeLegacyPatchRelaxedPrecisionPass(PassRegistry &);
 void initializeLegacyPatchWaveSizeAdjustPass(PassRegistry &);
 void initializeLegacyPatchInitializeWorkgroupMemoryPass(PassRegistry &);
+void initializeLegacyPatchShaderProfilePass(PassRegistry &);
 
 } // namespace llvm
 
@@ -76,44 +84,60 @@ class LegacyPatchCheckShaderCache;
 inline static void initializePatchPasses(llvm::PassRegistry &passRegistry) {
   initializeLegacyLowerFragColorExportPass(passRegistry);
   initializeLegacyLowerVertexFetchPass(passRegistry);
-  initializePatchBufferOpPass(passRegistry);
+  initializeLegacyPatchBufferOpPass(passRegistry);
   initializeLegacyPatchCheckShaderCachePass(passRegistry);
   initializeLegacyPatchCopyShaderPass(passRegistry);
   initializeLegacyPatchEntryPointMutatePass(passRegistry);
   initializeLegacyPatchInOutImportExportPass(passRegistry);
-  initializePatchLlvmIrInclusionPass(passRegistry);
+  initializeLegacyPatchLlvmIrInclusionPass(passRegistry);
   initializeLegacyPatchLoadScalarizerPass(passRegistry);
   initializeLegacyPatchLoopMetadataPass(passRegistry);
   initializeLegacyPatchNullFragShaderPass(passRegistry);
   initializeLegacyPatchPeepholeOptPass(passRegistry);
   initializeLegacyPatchPreparePipelineAbiPass(passRegistry);
   initializeLegacyPatchResourceCollectPass(passRegistry);
-  initializePatchSetupTargetFeaturesPass(passRegistry);
+  initializeLegacyPatchSetupTargetFeaturesPass(passRegistry);
   initializeLegacyPatchWorkaroundsPass(passRegistry);
   initializeLegacyPatchReadFirstLanePass(passRegistry);
+  initializeLegacyPatchHoistDescLoadsPass(passRegistry);
+  initializeLegacyPatchHoistGetPcPass(passRegistry);
+  initializeLegacyPatchHoistUniformOpsPass(passRegistry);
+  initializeLegacyPatchBufferLoadCombinePass(passRegistry);
+  initializeLegacyPatchAtomicAggregatePass(passRegistry);
+  initializeLegacyPatchImageOpCombinePass(passRegistry);
+  initializeLegacyPatchRelaxedPrecisionPass(passRegistry);
   initializeLegacyPatchWaveSizeAdjustPass(passRegistry);
   initializeLegacyPatchInitializeWorkgroupMemoryPass(passRegistry);
+  initializeLegacyPatchShaderProfilePass(passRegistry);
 }
 
 llvm::ModulePass *createLegacyLowerFragColorExport();
 llvm::ModulePass *createLegacyLowerVertexFetch();
-llvm::FunctionPass *createPatchBufferOp();
+llvm::FunctionPass *createLegacyPatchBufferOp();
 LegacyPatchCheckShaderCache *createLegacyPatchCheckShaderCache();
 llvm::ModulePass *createLegacyPatchCopyShader();
 llvm::ModulePass *createLegacyPatchEntryPointMutate();
 llvm::ModulePass *createLegacyPatchInOutImportExport();
-llvm::ModulePass *createPatchLlvmIrInclusion();
+llvm::ModulePass *createLegacyPatchLlvmIrInclusion();
 llvm::FunctionPass *createLegacyPatchLoadScalarizer();
 llvm::LoopPass *createLegacyPatchLoopMetadata();
 llvm::ModulePass *createLegacyPatchNullFragShader();
 llvm::FunctionPass *createLegacyPatchPeepholeOpt();
 llvm::ModulePass *createLegacyPatchPreparePipelineAbi(bool onlySetCallingConvs);
 llvm::ModulePass *createLegacyPatchResourceCollect();
-llvm::ModulePass *createPatchSetupTargetFeatures();
+llvm::ModulePass *createLegacyPatchSetupTargetFeatures();
 llvm::ModulePass *createLegacyPatchWorkarounds();
 llvm::FunctionPass *createLegacyPatchReadFirstLane();
+llvm::FunctionPass *createLegacyPatchHoistDescLoads();
+llvm::FunctionPass *createLegacyPatchHoistGetPc();
+llvm::FunctionPass *createLegacyPatchHoistUniformOps();
+llvm::FunctionPass *createLegacyPatchBufferLoadCombine();
+llvm::FunctionPass *createLegacyPatchAtomicAggregate();
+llvm::FunctionPass *createLegacyPatchImageOpCombine();
+llvm::FunctionPass *createLegacyPatchRelaxedPrecision();
 llvm::ModulePass *createLegacyPatchWaveSizeAdjust();
 llvm::ModulePass *createLegacyPatchInitializeWorkgroupMemory();
+llvm::ModulePass *createLegacyPatchShaderProfile();
 
 class PipelineState;
 class PassManager;
@@ -132,7 +156,7 @@ public:
   static llvm::GlobalVariable *getLdsVariable(PipelineState *pipelineState, llvm::Module *module);
 
 protected:
-  static void addOptimizationPasses(lgc::PassManager &passMgr);
+  static void addOptimizationPasses(lgc::PassManager &passMgr, bool fastCompile);
 
   void init(llvm::Module *module);
 
@@ -154,7 +178,7 @@ public:
                         Pipeline::CheckShaderCacheFunc checkShaderCacheFunc);
 
 private:
-  static void addOptimizationPasses(llvm::legacy::PassManager &passMgr);
+  static void addOptimizationPasses(llvm::legacy::PassManager &passMgr, bool fastCompile);
 
   LegacyPatch() = delete;
   LegacyPatch(const LegacyPatch &) = delete;
@@ -0,0 +1,70 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2017-2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchAtomicAggregate.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchAtomicAggregate.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+class CallInst;
+
+} // namespace llvm
+
+namespace lgc {
+
+class Builder;
+class PipelineState;
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for aggregating atomics across the wave.
+//
+// PatchBufferOp and ImageBuilder lower each buffer or image atomic to an atomic done by every lane, so a counter or
+// histogram that many lanes of a wave update at the same address or texel costs one atomic per lane. This pass rewrites
+// the raw buffer, struct buffer and image atomics of a compute shader whose result is unused into a loop over the
+// distinct addresses: the lanes with the address of the first remaining lane combine their values with a subgroup
+// reduction, and one lane does the atomic for all of them. The loop is limited to a few iterations, after which the
+// remaining lanes do their own atomics, so that accesses to mostly distinct addresses are not slowed down much. Buffer
+// atomics at a constant offset are left to the AMDGPU atomic optimizer.
+class PatchAtomicAggregate final : public llvm::PassInfoMixin<PatchAtomicAggregate> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, PipelineState *pipelineState);
+
+  static llvm::StringRef name() { return "Patch LLVM for buffer atomic aggregation"; }
+
+private:
+  void aggregateAtomic(llvm::CallInst *atomic, unsigned groupArithOp, llvm::ArrayRef<unsigned> addressOperandIdxs,
+                       unsigned maxIterations, Builder &builder);
+};
+
+} // namespace lgc
@@ -0,0 +1,56 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2017-2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchBufferLoadCombine.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchBufferLoadCombine.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+
+namespace lgc {
+
+class PipelineState;
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for combining buffer loads.
+//
+// PatchBufferOp lowers each buffer load on its own, so a struct whose members are loaded one by one ends up as a run
+// of dword buffer loads at consecutive offsets. This pass merges the raw buffer loads (and the scalar buffer loads)
+// in a block that use the same descriptor, the same variable offset and the same cache policy, and whose constant
+// offsets are contiguous, into dwordx2, dwordx3 or dwordx4 loads. It is skipped when buffer accesses need tight
+// bounds checking, since a wide load that crosses the end of the buffer can return zero for its in-bounds dwords.
+class PatchBufferLoadCombine final : public llvm::PassInfoMixin<PatchBufferLoadCombine> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, PipelineState *pipelineState);
+
+  static llvm::StringRef name() { return "Patch LLVM for buffer load combining"; }
+};
+
+} // namespace lgc
@@ -63,12 +63,14 @@ private:
     unsigned argDwordSize;  // Size of argument in dwords
     unsigned userDataValue; // PAL metadata user data value, ~0U (UserDataMapping::Invalid) for none
     unsigned *argIndex;     // Where to store arg index once it is allocated, nullptr for none
+    uint64_t usageWeight;   // Loop-depth-weighted static use count, used to choose which args to unspill
   };
 
   // User data usage for one user data node
   struct UserDataNodeUsage {
     unsigned entryArgIdx = 0;
-    unsigned dwordSize = 0; // Only used in pushConstOffsets
+    unsigned dwordSize = 0;   // Only used in pushConstOffsets
+    uint64_t usageWeight = 0; // Static use count, with each use weighted by the loop depth it is at
     llvm::SmallVector<llvm::Instruction *, 4> users;
   };
 
@@ -109,6 +111,9 @@ private:
   // Gather user data usage in all shaders.
   void gatherUserDataUsage(llvm::Module *module);
 
+  // Weight the gathered user data usage by static use count and loop depth.
+  void weightUserDataUsage();
+
   // Fix up user data uses.
   void fixupUserDataUses(llvm::Module &module);
 
@@ -117,6 +122,8 @@ private:
   void processCalls(llvm::Function &func, llvm::SmallVectorImpl<llvm::Type *> &shaderInputTys,
                     llvm::SmallVectorImpl<std::string> &shaderInputNames, uint64_t inRegMask, unsigned argOffset);
   void setFuncAttrs(llvm::Function *entryPoint);
+  unsigned getOccupancyWaves(unsigned minWavesPerSimd);
+  unsigned getVgprLimitForWaves(unsigned wavesPerSimd);
 
   uint64_t generateEntryPointArgTys(ShaderInputs *shaderInputs, llvm::SmallVectorImpl<llvm::Type *> &argTys,
                                     llvm::SmallVectorImpl<std::string> &argNames, unsigned argOffset);
@@ -125,7 +132,7 @@ private:
                               llvm::SmallVectorImpl<UserDataArg> &specialUserDataArgs, llvm::IRBuilder<> &builder);
   void addUserDataArgs(llvm::SmallVectorImpl<UserDataArg> &userDataArgs, llvm::IRBuilder<> &builder);
   void addUserDataArg(llvm::SmallVectorImpl<UserDataArg> &userDataArgs, unsigned userDataValue, unsigned sizeInDwords,
-                      const llvm::Twine &name, unsigned *argIndex, llvm::IRBuilder<> &builder);
+                      const llvm::Twine &name, unsigned *argIndex, uint64_t usageWeight, llvm::IRBuilder<> &builder);
 
   void determineUnspilledUserDataArgs(llvm::ArrayRef<UserDataArg> userDataArgs,
                                       llvm::ArrayRef<UserDataArg> specialUserDataArgs, llvm::IRBuilder<> &builder,
@@ -0,0 +1,62 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistDescLoads.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchHoistDescLoads.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+#include <functional>
+
+namespace llvm {
+class DominatorTree;
+class LoopInfo;
+} // namespace llvm
+
+namespace lgc {
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for hoisting uniform descriptor loads.
+//
+// Descriptors (and spilled user data) are loaded from constant memory at a constant offset from a descriptor table or
+// spill table pointer that is computed at the start of the function. LICM cannot hoist such a load out of a loop
+// when it is in a conditionally executed block, and loads of the same descriptor in different blocks are not
+// combined. Since the offset is within the table laid out by the driver, the load is safe to execute anywhere the
+// table pointer is available. This pass gathers the loads with the same uniform table pointer and offset, and
+// replaces them with a single load at their nearest common dominator, hoisted out of any loops.
+class PatchHoistDescLoads final : public llvm::PassInfoMixin<PatchHoistDescLoads> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, std::function<bool(const llvm::Value &)> isDivergent,
+               llvm::DominatorTree &dominatorTree, llvm::LoopInfo &loopInfo);
+
+  static llvm::StringRef name() { return "Patch LLVM for hoisting uniform descriptor loads"; }
+};
+
+} // namespace lgc
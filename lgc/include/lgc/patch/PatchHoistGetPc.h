@@ -0,0 +1,60 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistGetPc.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchHoistGetPc.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+class DemandedBits;
+} // namespace llvm
+
+namespace lgc {
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for sharing one PC read in a function.
+//
+// AddressExtender reads PC once at the start of each function to supply the high half of the 32-bit addresses it
+// extends. Once the functions of a merged or NGG primitive shader, and its copy shader, have been inlined into it,
+// their PC reads are in blocks that do not dominate each other, so no CSE pass combines them. All of them only use the
+// high half, which is the same anywhere in the code object, so this pass replaces them with a single PC read at the
+// start of the function. PC reads whose low half is demanded are left alone.
+class PatchHoistGetPc final : public llvm::PassInfoMixin<PatchHoistGetPc> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, llvm::DemandedBits &demandedBits);
+
+  static llvm::StringRef name() { return "Patch LLVM for sharing one PC read in a function"; }
+};
+
+} // namespace lgc
@@ -0,0 +1,59 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistUniformOps.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchHoistUniformOps.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+#include <functional>
+
+namespace llvm {
+class LoopInfo;
+} // namespace llvm
+
+namespace lgc {
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for hoisting uniform loop-invariant operations out of loops.
+//
+// Uniform math on values such as push constants and descriptors is often only loop-invariant once late passes have
+// run, for example once PatchHoistDescLoads has moved the descriptor loads it depends on out of a loop, so LICM does
+// not see it. This pass moves the uniform operations that are safe to speculate, and whose operands are all defined
+// outside the loop, to the loop preheader, so that they are computed once rather than on every iteration.
+class PatchHoistUniformOps final : public llvm::PassInfoMixin<PatchHoistUniformOps> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, std::function<bool(const llvm::Value &)> isDivergent,
+               llvm::LoopInfo &loopInfo);
+
+  static llvm::StringRef name() { return "Patch LLVM for hoisting uniform operations out of loops"; }
+};
+
+} // namespace lgc
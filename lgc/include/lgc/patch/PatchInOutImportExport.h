@@ -192,11 +192,12 @@ private:
                                      llvm::Instruction *insertPos);
   void addExportInstForBuiltInOutput(llvm::Value *output, unsigned builtInId, llvm::Instruction *insertPos);
 
+  std::pair<llvm::Value *, llvm::Value *> getFsInterpCoords(unsigned interpMode, unsigned interpLoc);
   llvm::Value *adjustCentroidIj(llvm::Value *centroidIj, llvm::Value *centerIj, llvm::Instruction *insertPos);
 
   llvm::Value *getSubgroupLocalInvocationId(llvm::Instruction *insertPos);
 
-  WorkgroupLayout calculateWorkgroupLayout();
+  WorkgroupLayout calculateWorkgroupLayout(bool imageCoordsFromId);
   llvm::Value *reconfigWorkgroup(llvm::Value *localInvocationId, llvm::Instruction *insertPos);
 
   void exportShadingRate(llvm::Value *shadingRate, llvm::Instruction *insertPos);
@@ -205,6 +206,9 @@ private:
   void recordVertexAttribExport(unsigned location, llvm::ArrayRef<llvm::Value *> attribValues);
   void exportVertexAttribs(llvm::Instruction *insertPos);
 
+  void collectConstantTessFactors(llvm::Module &module);
+  llvm::Value *getConstantTessLevel(llvm::Type *inputTy, llvm::Value *elemIdx,
+                                    llvm::ArrayRef<llvm::Constant *> constTessLevel, llvm::Instruction *insertPos);
   void storeTessFactors();
   void doTessFactorBufferStore(llvm::ArrayRef<llvm::Value *> outerTessFactors,
                                llvm::ArrayRef<llvm::Value *> innerTessFactors, llvm::Instruction *insertPos);
@@ -235,7 +239,9 @@ private:
   std::vector<llvm::CallInst *> m_importCalls; // List of "call" instructions to import inputs
   std::vector<llvm::CallInst *> m_exportCalls; // List of "call" instructions to export outputs
   llvm::SmallDenseMap<unsigned, std::array<llvm::Value *, 4>>
-      m_attribExports;                      // Export info of vertex attributes: <attrib loc, attrib values>
+      m_attribExports; // Export info of vertex attributes: <attrib loc, attrib values>
+  // I/J coordinates provided by hardware, by interp mode and location
+  llvm::SmallDenseMap<unsigned, std::pair<llvm::Value *, llvm::Value *>, 4> m_fsInterpCoords;
   PipelineState *m_pipelineState = nullptr; // Pipeline state from PipelineStateWrapper pass
 
   std::set<unsigned> m_expLocs; // The locations that already have an export instruction for the vertex shader.
@@ -243,6 +249,10 @@ private:
 
   llvm::SmallVector<llvm::Instruction *, 4> m_tessLevelOuterInsts; // Collect the instructions of TessLevelOuter
   llvm::SmallVector<llvm::Instruction *, 2> m_tessLevelInnerInsts; // Collect the instructions of TessLevelInner
+  // Constant elements of TessLevelOuter/TessLevelInner written by TCS (null if not written), empty if not constant
+  llvm::SmallVector<llvm::Constant *, 4> m_constTessLevelOuter;
+  llvm::SmallVector<llvm::Constant *, 4> m_constTessLevelInner;
+  bool m_tessPatchAlwaysCulled = false; // Whether the constant outer tessellation factors cull every patch
 };
 
 // =====================================================================================================================
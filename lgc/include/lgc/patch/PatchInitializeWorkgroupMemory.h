@@ -48,7 +48,7 @@ public:
   static llvm::StringRef name() { return "Patch for initialize workgroup memory"; }
 
 private:
-  void initializeWithZero(llvm::GlobalVariable *lds, BuilderBase &builder);
+  void initializeWithZero(llvm::GlobalVariable *lds, unsigned initDwordSize, BuilderBase &builder);
   unsigned getTypeSizeInDwords(llvm::Type *inputTy);
 
   llvm::DenseMap<llvm::GlobalVariable *, llvm::Value *> m_globalLdsOffsetMap;
@@ -64,6 +64,7 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override {
     analysisUsage.addRequired<LegacyPipelineShaders>();
     analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+    analysisUsage.addPreserved<LegacyPipelineShaders>();
   }
 
   virtual bool runOnModule(llvm::Module &module) override;
@@ -53,6 +53,8 @@ public:
                                llvm::Metadata *addMetadata, bool conditional);
 
 private:
+  unsigned getOccupancyUnrollThreshold(llvm::Loop &loop, unsigned waveSize);
+
   llvm::LLVMContext *m_context;       // Associated LLVM context of the LLVM module that passes run on
   unsigned m_forceLoopUnrollCount;    // Force loop unroll count
   bool m_disableLoopUnroll;           // Forcibly disable loop unroll
@@ -62,6 +62,8 @@ private:
 
   void addAbiMetadata(llvm::Module &module);
 
+  void refineFragmentShaderUsage();
+
   PipelineState *m_pipelineState;           // Pipeline state
   PipelineShadersResult *m_pipelineShaders; // API shaders in the pipeline
 
@@ -51,6 +51,8 @@ public:
 private:
   bool promoteEqualUniformOps(llvm::Function &function);
   bool liftReadFirstLane(llvm::Function &function);
+  bool lowerUniformPermutes(llvm::Function &function);
+  bool promoteUniformBranches(llvm::Function &function);
   void collectAssumeUniforms(llvm::BasicBlock *block,
                              const llvm::SmallVectorImpl<llvm::Instruction *> &initialReadFirstLanes);
   void findBestInsertLocation(const llvm::SmallVectorImpl<llvm::Instruction *> &initialReadFirstLanes);
@@ -0,0 +1,57 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchRelaxedPrecision.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchRelaxedPrecision.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+
+namespace lgc {
+
+class PipelineState;
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for doing relaxed precision math in 16-bit floats.
+//
+// The front-end marks the 32-bit float arithmetic that only needs relaxed precision with RelaxedPrecisionMetadataName.
+// This pass gathers the chains of such fadd, fsub, fmul, fneg, fma, fmuladd, minnum and maxnum operations that are
+// connected through their operands, and redoes each chain in 16-bit floats when that saves more operations than the
+// conversions to and from 16 bits cost. The SLP vectorizer run after this pass then pairs the independent 16-bit
+// operations into packed math. Only done on targets with packed math, and only when the float modes of the shader do
+// not ask for a rounding or denormal behavior that the 16-bit operations would not keep.
+class PatchRelaxedPrecision final : public llvm::PassInfoMixin<PatchRelaxedPrecision> {
+public:
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Function &function, PipelineState *pipelineState);
+
+  static llvm::StringRef name() { return "Patch LLVM for relaxed precision math in 16-bit floats"; }
+};
+
+} // namespace lgc
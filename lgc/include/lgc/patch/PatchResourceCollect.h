@@ -158,6 +158,14 @@ public:
   bool findMap(const InOutLocationInfo &origLocInfo, InOutLocationInfoMap::const_iterator &mapIt);
   InOutLocationInfoMap &getMap() { return m_locationInfoMap; }
 
+  // Cost of the packing in the map built by createMap
+  struct PackingCost {
+    unsigned locationCount;   // Number of packed locations
+    unsigned componentCount;  // Number of 32-bit components of the packed locations that hold data
+    unsigned interpInstCount; // Estimated number of interpolation instructions to read them in FS
+  };
+  const PackingCost &getPackingCost() const { return m_packingCost; }
+
   struct LocationSpan {
     uint16_t getCompatibilityKey() const { return compatibilityInfo.u16All; }
 
@@ -187,6 +195,7 @@ private:
 
   std::vector<LocationSpan> m_locationSpans; // Tracks spans of contiguous components in the generic input space
   InOutLocationInfoMap m_locationInfoMap;    // The map between original location and new location
+  PackingCost m_packingCost = {};            // Cost of the packing in m_locationInfoMap
 };
 
 } // namespace lgc
@@ -0,0 +1,77 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchShaderProfile.h
+ * @brief LLPC header file: contains declaration of class lgc::PatchShaderProfile.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "lgc/state/PipelineShaders.h"
+#include "llvm/IR/PassManager.h"
+
+namespace lgc {
+
+class BuilderBase;
+class PipelineState;
+struct ResourceNode;
+
+// Byte size of the section of the shader profile buffer for each shader stage, at (stage * ShaderProfileStageSize)
+static const unsigned ShaderProfileStageSize = 256;
+// Byte size of each region of a section: the accumulated counter ticks and the number of waves, both as uint64
+static const unsigned ShaderProfileRegionSize = 16;
+
+// =====================================================================================================================
+// Represents the pass of LLVM patching operations for instrumenting shaders with performance counters (option
+// -shader-profile).
+//
+// Each shader reads the hardware time counter at its start and at each return, and the first active lane of each wave
+// adds the difference, and 1 to the wave count, to the first region of the section of the shader profile buffer for
+// its stage. With -shader-profile-loops, each outermost loop that has a preheader and dedicated exits gets a region
+// of its own, following the shader region in the order that the loops appear in the function. The buffer is the
+// DescriptorBuffer node at ShaderProfileDescSet/ShaderProfileBinding of the user data layout; a pipeline without that
+// node is not instrumented. The section offset, loop count and counter of each instrumented shader are recorded in its
+// .shader_profile entry of the PAL metadata, so that tools can decode the buffer.
+class PatchShaderProfile final : public llvm::PassInfoMixin<PatchShaderProfile> {
+public:
+  llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
+
+  bool runImpl(llvm::Module &module, PipelineShadersResult &pipelineShaders, PipelineState *pipelineState);
+
+  static llvm::StringRef name() { return "Patch LLVM for instrumenting shaders with performance counters"; }
+
+private:
+  void instrumentShader(llvm::Function *entryPoint, ShaderStage stage);
+  llvm::Value *readCounter(BuilderBase &builder);
+  void accumulate(llvm::Instruction *insertPos, llvm::Value *startTime, ShaderStage stage, unsigned byteOffset);
+
+  PipelineState *m_pipelineState = nullptr; // Pipeline state
+  const ResourceNode *m_topNode = nullptr;  // Top-level node of the shader profile buffer
+  const ResourceNode *m_node = nullptr;     // Node of the shader profile buffer
+  bool m_realTime = false;                  // Whether to read the constant-rate real time counter
+};
+
+} // namespace lgc
@@ -32,7 +32,9 @@
 
 #include "lgc/state/PipelineShaders.h"
 #include "lgc/state/PipelineState.h"
+#include "llvm/Analysis/LegacyDivergenceAnalysis.h"
 #include "llvm/Pass.h"
+#include <functional>
 
 namespace lgc {
 
@@ -40,9 +42,12 @@ namespace lgc {
 // Pass to adjust wave size per shader stage heuristically.
 class PatchWaveSizeAdjust final : public llvm::PassInfoMixin<PatchWaveSizeAdjust> {
 public:
+  // Callback that gets a function telling whether a value of the given function is divergent
+  using GetIsDivergent = std::function<std::function<bool(const llvm::Value &)>(llvm::Function &)>;
+
   llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
 
-  bool runImpl(llvm::Module &module, PipelineState *pipelineState);
+  bool runImpl(llvm::Module &module, PipelineState *pipelineState, const GetIsDivergent &getIsDivergent);
 
   static llvm::StringRef name() { return "Patch LLVM for per-shader wave size adjustment"; }
 
@@ -58,6 +63,7 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override {
     analysisUsage.addRequired<LegacyPipelineShaders>();
     analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+    analysisUsage.addRequired<llvm::LegacyDivergenceAnalysis>();
     analysisUsage.setPreservesAll();
   }
 
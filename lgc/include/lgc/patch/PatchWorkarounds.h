@@ -52,6 +52,8 @@ public:
 
   bool runImpl(llvm::Module &module, PipelineState *pipelineState);
 
+  static bool isNeeded(PipelineState *pipelineState);
+
   static llvm::StringRef name() { return "Patch LLVM for workarounds"; }
 
 private:
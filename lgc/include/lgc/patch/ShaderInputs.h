@@ -200,7 +200,7 @@ public:
   // Get argument types for shader inputs
   uint64_t getShaderArgTys(PipelineState *pipelineState, ShaderStage shaderStage,
                            llvm::SmallVectorImpl<llvm::Type *> &argTys, llvm::SmallVectorImpl<std::string> &argNames,
-                           unsigned argOffset);
+                           unsigned argOffset, bool computeWithCalls);
 
 private:
   // Usage for one system shader input in one shader stage
@@ -31,6 +31,7 @@
 #pragma once
 
 #include "lgc/Pipeline.h"
+#include "lgc/state/PipelineShaders.h"
 #include "lgc/state/PipelineState.h"
 
 namespace lgc {
@@ -43,8 +44,13 @@ class VertexFetch {
 public:
   virtual ~VertexFetch() {}
 
-  // Create a VertexFetch
-  static VertexFetch *create(LgcContext *lgcContext);
+  // Create a VertexFetch. If uniformFetchesToSgprs is set, the values of inputs with a zero divisor, which are the same
+  // in all lanes, are moved to SGPRs so that code using them is scalar.
+  static VertexFetch *create(LgcContext *lgcContext, bool uniformFetchesToSgprs = false);
+
+  // Set the vertex inputs that are going to be fetched, so that the fetches of adjacent inputs in the same binding
+  // can be coalesced
+  virtual void coalesceFetches(llvm::ArrayRef<const VertexInputDescription *> descriptions) = 0;
 
   // Generate code to fetch a vertex value
   virtual llvm::Value *fetchVertex(llvm::Type *inputTy, const VertexInputDescription *description, unsigned location,
@@ -72,6 +78,7 @@ public:
 
   void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override {
     analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+    analysisUsage.addPreserved<LegacyPipelineShaders>();
   }
 
   virtual bool runOnModule(llvm::Module &module) override;
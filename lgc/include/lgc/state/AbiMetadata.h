@@ -243,11 +243,13 @@ constexpr unsigned mmSPI_SHADER_COL_FORMAT = 0xA1C5;
 constexpr unsigned mmDB_SHADER_CONTROL = 0xA203;
 constexpr unsigned mmSPI_SHADER_Z_FORMAT = 0xA1C4;
 constexpr unsigned mmCB_SHADER_MASK = 0xA08F;
+constexpr unsigned mmSPI_VS_OUT_CONFIG = 0xA1B1;
 
 // PS register numbers in PAL metadata
 constexpr unsigned mmSPI_PS_INPUT_ENA = 0xA1B3;
 constexpr unsigned mmSPI_PS_INPUT_ADDR = 0xA1B4;
 constexpr unsigned mmSPI_PS_IN_CONTROL = 0xA1B6;
+constexpr unsigned mmSPI_PS_INPUT_CNTL_0 = 0xA191;
 constexpr unsigned mmPA_SC_SHADER_CONTROL = 0xA310;
 constexpr unsigned mmPA_SC_AA_CONFIG = 0xA2F8;
 
@@ -317,6 +319,39 @@ union VGT_SHADER_STAGES_EN {
   unsigned int u32All;
 };
 
+// SPI_VS_OUT_CONFIG register
+union SPI_VS_OUT_CONFIG {
+  struct {
+    unsigned int : 1;
+    unsigned int VS_EXPORT_COUNT : 5;
+    unsigned int : 1;
+    unsigned int NO_PC_EXPORT : 1;      // GFX10+
+    unsigned int PRIM_EXPORT_COUNT : 5; // GFX10.3+
+    unsigned int : 19;
+  } bits, bitfields;
+  unsigned int u32All;
+};
+
+// SPI_PS_IN_CONTROL register (just the interpolant count)
+union SPI_PS_IN_CONTROL {
+  struct {
+    unsigned int NUM_INTERP : 6;
+    unsigned int : 26;
+  } bits, bitfields;
+  unsigned int u32All;
+};
+
+// SPI_PS_INPUT_CNTL_* register (just the param cache location fields)
+union SPI_PS_INPUT_CNTL {
+  struct {
+    unsigned int OFFSET : 6;
+    unsigned int : 4;
+    unsigned int FLAT_SHADE : 1;
+    unsigned int : 21;
+  } bits, bitfields;
+  unsigned int u32All;
+};
+
 // The DB_SHADER_CONTROL register.
 union DB_SHADER_CONTROL {
   struct {
@@ -92,6 +92,7 @@ const static char LateBufferPtrDiff[] = "lgc.late.buffer.ptrdiff";
 // Names of global variables
 const static char ImmutableSamplerGlobal[] = "lgc.immutable.sampler";
 const static char ImmutableConvertingSamplerGlobal[] = "lgc.immutable.converting.sampler";
+const static char NullFmaskGlobal[] = "lgc.null.fmask";
 
 // Names of entry-points for merged shader
 const static char EsGsEntryPoint[] = "lgc.shader.ESGS.main";
@@ -147,4 +148,9 @@ static_assert(MaxGsStreams == MaxTransformFeedbackBuffers, "Unexpected value!");
 static const unsigned InternalResourceTable = 0x10000000;
 static const unsigned InternalPerShaderTable = 0x10000001;
 
+// Descriptor set and binding of the buffer that -shader-profile accumulates the time of each shader in. These match
+// Vkgc::InternalDescriptorSetId and Vkgc::ShaderProfileBufferBinding.
+static const unsigned ShaderProfileDescSet = 0xFFFFFFFF;
+static const unsigned ShaderProfileBinding = 6;
+
 } // namespace lgc
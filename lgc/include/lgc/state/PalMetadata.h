@@ -113,8 +113,13 @@ public:
   // Record the PAL metadata into IR metadata in the specified module.
   void record(llvm::Module *module);
 
-  // Get the MsgPack document for explicit manipulation. Only ConfigBuilder* uses this.
-  llvm::msgpack::Document *getDocument() { return m_document; }
+  // Get the MsgPack document for explicit manipulation. Only ConfigBuilder* uses this. Registers set through this
+  // object are written into the document first, so the document must not be changed directly while registers are
+  // also being set through this object.
+  llvm::msgpack::Document *getDocument() {
+    flushRegisters();
+    return m_document;
+  }
 
   // Set the PAL metadata SPI register for one user data entry
   void setUserDataEntry(ShaderStage stage, unsigned userDataIndex, unsigned userDataValue, unsigned dwordCount = 1);
@@ -161,6 +166,9 @@ public:
   // Erase the color export info
   void eraseColorExportInfo();
 
+  // Store the layout of the shader profile buffer section of a shader instrumented by -shader-profile
+  void setShaderProfileInfo(ShaderStage stage, unsigned offset, unsigned loopCount, llvm::StringRef counter);
+
   // Finalize PAL metadata for pipeline, part-pipeline or shader compilation.
   void finalizePipeline(bool isWholePipeline);
 
@@ -200,6 +208,12 @@ private:
   // Initialize the PalMetadata object after reading in already-existing PAL metadata if any
   void initialize();
 
+  // Get the pending value of a register, starting from its value in the MsgPack document if it has none yet.
+  unsigned &getPendingRegister(unsigned regNum);
+
+  // Write the pending register values into the MsgPack document.
+  void flushRegisters();
+
   // Get the first user data register number for the given shader stage.
   unsigned getUserDataReg0(ShaderStage stage);
 
@@ -237,6 +251,9 @@ private:
   llvm::msgpack::Document *m_document;        // The MsgPack document
   llvm::msgpack::MapDocNode m_pipelineNode;   // MsgPack map node for amdpal.pipelines[0]
   llvm::msgpack::MapDocNode m_registers;      // MsgPack map node for amdpal.pipelines[0].registers
+  // Register values set since the registers were last written into m_registers, sorted by register number. Each is
+  // the whole value of the register, including the value it had in m_registers.
+  llvm::SmallVector<std::pair<unsigned, unsigned>, 32> m_pendingRegisters;
   llvm::msgpack::ArrayDocNode m_vertexInputs; // MsgPack map node for amdpal.pipelines[0].vertexInputs
   llvm::msgpack::DocNode m_colorExports;      // MsgPack map node for amdpal.pipelines[0].colorExports
   // Mapping from ShaderStage to SPI user data register start, allowing for merged shaders and NGG.
@@ -36,10 +36,12 @@
 #include "lgc/state/ResourceUsage.h"
 #include "lgc/state/ShaderModes.h"
 #include "lgc/state/ShaderStage.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
 #include <map>
 
 namespace llvm {
@@ -111,6 +113,9 @@ struct NggControl {
 
   unsigned vertsPerSubgroup; // Preferred number of vertices consumed by a primitive shader sub-group
 
+  unsigned vertsPerPrimHint; // Measured average number of distinct vertices per primitive, in hundredths, or 0 if
+                             // not measured
+
   bool passthroughMode;                          // Whether NGG passthrough mode is enabled
   Util::Abi::PrimShaderCbLayout primShaderTable; // Primitive shader table (only some registers are used)
 };
@@ -169,6 +174,14 @@ public:
                 CheckShaderCacheFunc checkShaderCacheFunc, llvm::ArrayRef<llvm::Timer *> timers,
                 bool newPassManager) override final;
 
+  // Generate pipeline module into the caller's buffer
+  bool generate(std::unique_ptr<llvm::Module> pipelineModule, llvm::SmallVectorImpl<char> &outBuffer,
+                CheckShaderCacheFunc checkShaderCacheFunc, llvm::ArrayRef<llvm::Timer *> timers,
+                bool newPassManager) override final;
+
+  // Write the pipeline module as a serialized recorded module for generating in a different process
+  void writeRecordedModule(llvm::Module *pipelineModule, llvm::raw_ostream &outStream) override final;
+
   // Create an ELF linker object for linking unlinked shader/part-pipeline ELFs into a pipeline ELF using the
   // pipeline state
   ElfLinker *createElfLinker(llvm::ArrayRef<llvm::MemoryBufferRef> elfs) override final;
@@ -257,6 +270,7 @@ public:
 
   // Accessors for color export state
   const ColorExportFormat &getColorExportFormat(unsigned location);
+  unsigned getColorExportChannelMask(unsigned location);
   const bool hasColorExportFormats() { return !m_colorExportFormats.empty(); }
   const ColorExportState &getColorExportState() { return m_colorExportState; }
 
@@ -286,7 +300,10 @@ public:
   unsigned getShaderSubgroupSize(ShaderStage stage);
 
   // Set the default wave size for the specified shader stage
-  void setShaderDefaultWaveSize(ShaderStage stage);
+  void setShaderDefaultWaveSize(ShaderStage stage, unsigned preferredWaveSize = 0);
+
+  // Check whether the wave size of the specified shader stage has already been fixed
+  bool isShaderWaveSizeSet(ShaderStage stage) const { return m_waveSize[stage] != 0; }
 
   // Set the wave size for the specified shader stage
   void setShaderWaveSize(ShaderStage stage, unsigned waveSize) {
@@ -435,10 +452,19 @@ private:
   // Generate pipeline module
   void generateWithLegacyPassManager(std::unique_ptr<llvm::Module> pipelineModule, llvm::raw_pwrite_stream &outStream,
                                      CheckShaderCacheFunc checkShaderCacheFunc, llvm::ArrayRef<llvm::Timer *> timers);
+  // Test whether to do the codegen of each hardware shader stage on its own thread
+  bool useParallelCodeGen() const;
+  // Do codegen of a patched whole pipeline module with each hardware shader stage on its own thread
+  void generateHwStagesInParallel(llvm::Module &pipelineModule, llvm::raw_pwrite_stream &outStream,
+                                  llvm::Timer *codeGenTimer);
 
   // Read shaderStageMask from IR
   void readShaderStageMask(llvm::Module *module);
 
+  // Binary blob form of options, user data nodes, vertex input descriptions and color export state
+  void recordStateBlob(llvm::Module *module);
+  bool readStateBlob(llvm::Module *module);
+
   // Options handling
   void recordOptions(llvm::Module *module);
   void readOptions(llvm::Module *module);
@@ -449,10 +475,18 @@ private:
   void recordUserDataNodes(llvm::Module *module);
   void recordUserDataTable(llvm::ArrayRef<ResourceNode> nodes, llvm::NamedMDNode *userDataMetaNode);
   void readUserDataNodes(llvm::Module *module);
+  ResourceNode *allocateUserDataNodes(unsigned nodeCount);
+  uint32_t *allocateImmutableValue(unsigned sizeInDwords);
   llvm::ArrayRef<llvm::MDString *> getResourceTypeNames();
   llvm::MDString *getResourceTypeName(ResourceNodeType type);
   ResourceNodeType getResourceTypeFromName(llvm::MDString *typeName);
   bool matchResourceNode(const ResourceNode &node, ResourceNodeType nodeType, unsigned descSet, unsigned binding) const;
+  void buildResourceNodeIndex() const;
+  void invalidateResourceNodeIndex() {
+    m_resourceNodeIndex.clear();
+    m_descTableNodeIndex.clear();
+    m_resourceNodeIndexValid = false;
+  }
 
   // Device index handling
   void recordDeviceIndex(llvm::Module *module);
@@ -473,6 +507,7 @@ private:
   std::string m_lastError;                              // Error to be reported by getLastError()
   bool m_noReplayer = false;                            // True if no BuilderReplayer needed
   bool m_emitLgc = false;                               // Whether -emit-lgc is on
+  llvm::SmallVectorImpl<char> *m_outBuffer = nullptr;   // Caller's buffer that generate() is writing into, if any
   // Whether generating pipeline or unlinked part-pipeline
   PipelineLink m_pipelineLink = PipelineLink::WholePipeline;
   unsigned m_stageMask = 0;                             // Mask of active shader stages
@@ -480,12 +515,19 @@ private:
   std::string m_client;                                 // Client name for PAL metadata
   Options m_options = {};                               // Per-pipeline options
   std::vector<ShaderOptions> m_shaderOptions;           // Per-shader options
-  std::unique_ptr<ResourceNode[]> m_allocUserDataNodes; // Allocated buffer for user data
+  // Allocator for the user data node tables and immutable sampler data, which are freed in bulk with the pipeline
+  // state at the end of the build
+  llvm::BumpPtrAllocator m_allocator;
   llvm::ArrayRef<ResourceNode> m_userDataNodes;         // Top-level user data node table
+  // Index of the user data nodes that have a binding, by {set,binding}: the {topNode, node} pairs in table order
+  mutable llvm::DenseMap<std::pair<unsigned, unsigned>,
+                         llvm::SmallVector<std::pair<const ResourceNode *, const ResourceNode *>, 1>>
+      m_resourceNodeIndex;
+  // Index of the top-level DescriptorTableVaPtr nodes, by the set of their first child
+  mutable llvm::DenseMap<unsigned, const ResourceNode *> m_descTableNodeIndex;
+  mutable bool m_resourceNodeIndexValid = false; // Whether the above indices are built
   // Cached MDString for each resource node type
   llvm::MDString *m_resourceNodeTypeNames[unsigned(ResourceNodeType::Count)] = {};
-  // Allocated buffers for immutable sampler data
-  llvm::SmallVector<std::unique_ptr<uint32_t[]>, 4> m_immutableValueAllocs;
 
   bool m_gsOnChip = false;                                                     // Whether to use GS on-chip mode
   NggControl m_nggControl = {};                                                // NGG control settings
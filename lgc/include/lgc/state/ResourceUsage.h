@@ -139,7 +139,8 @@ enum class WorkgroupLayout : unsigned {
   Unknown = 0,   // ?x?
   Linear,        // 4x1
   Quads,         // 2x2
-  SexagintiQuads // 8x8
+  SexagintiQuads, // 8x8
+  ZOrder          // Power-of-2 tiles in Morton order
 };
 
 // Represents the usage info of shader resources.
@@ -291,7 +292,7 @@ struct ResourceUsage {
       // Compute shader
       struct {
         // Workgroup layout
-        unsigned workgroupLayout : 2; // The layout of the workgroup
+        unsigned workgroupLayout : 3; // The layout of the workgroup
       } cs;
     };
 
@@ -331,6 +332,12 @@ struct ResourceUsage {
 
     unsigned expCount = 0; // Export count (number of "exp" instructions) for generic outputs
 
+    // Cost of the packing of FS generic inputs, from PatchResourceCollect. The params are the entries each vertex
+    // takes in the parameter cache.
+    unsigned packedParamCount = 0;          // Number of params the packed inputs occupy
+    unsigned packedParamComponentCount = 0; // Number of 32-bit param components that hold data
+    unsigned packedInterpInstCount = 0;     // Estimated number of interpolation instructions to read them
+
     struct {
       struct {
         unsigned inVertexStride;           // Stride of vertices of input patch (in dword, correspond to
@@ -392,6 +399,7 @@ struct ResourceUsage {
         unsigned inputVertices;      // Number of GS input vertices
         unsigned primAmpFactor;      // GS primitive amplification factor
         bool enableMaxVertOut;       // Whether to allow each GS instance to emit maximum vertices (NGG)
+        bool gsOutputsInRegs;        // Whether the GS outputs are kept in registers rather than GS-VS ring (NGG)
       } calcFactor = {};
 
       unsigned outLocCount[MaxGsStreams] = {};
@@ -537,6 +545,8 @@ struct InterfaceData {
 
       // Compute shader
       struct {
+        unsigned workgroupId;       // Workgroup ID
+        unsigned multiDispatchInfo; // Multiple dispatch info
         unsigned localInvocationId; // Local invocation ID
       } cs;
     };
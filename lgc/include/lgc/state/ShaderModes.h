@@ -82,7 +82,8 @@ public:
 
   // Read shader modes (common and specific) from a shader IR module, but only if no modes have been set
   // in this ShaderModes. This is used to handle the case that the shader module comes from an earlier
-  // shader compile, and it had its ShaderModes recorded into IR then.
+  // shader compile, and it had its ShaderModes recorded into IR then. The shader mode metadata is removed
+  // from the shader module.
   void readModesFromShader(llvm::Module *module, ShaderStage stage);
 
   // Read shader modes from IR metadata in a pipeline
@@ -70,6 +70,7 @@ struct GpuProperty {
   unsigned tessFactorBufferSizePerSe; // Size of the tessellation-factor buffer per SE, in dwords.
   bool supportShaderPowerProfiling;   // Hardware supports Shader Profiling for Power
   bool supportSpiPrefPriority;        // Hardware supports SPI shader preference priority
+  bool supportFloatDot2;              // Hardware supports the f16 dot product with f32 accumulator (v_dot2_f32_f16)
   struct {
     unsigned compBitwidth16 : 1; // Whether the vector is 16-bit component
     unsigned compBitwidth8 : 1;  // Whether the vector is 8-bit component
@@ -78,6 +79,14 @@ struct GpuProperty {
     unsigned diffSignedness : 1; // Whether the components of two vectors have the diff signedness
   } supportIntegerDotFlag;       // The flag indicates the HW supports integer dot product
   unsigned supportsXnack;        // GPU supports XNACK
+  struct {
+    // Whether a typed fetch of a signed 2_10_10_10 format returns the 2-bit alpha channel sign-extended, so that it
+    // does not need patching after the fetch
+    unsigned signedA2 : 1;
+    // Whether a typed fetch of an 8_8, 8_8_8_8, 16_16 or 16_16_16_16 format returns the right data from a vertex
+    // buffer that is not aligned on the vertex size, so that it does not need splitting into per-component fetches
+    unsigned unaligned8And16 : 1;
+  } typedVertexFetch; // Capabilities of typed buffer loads for vertex fetch
 };
 
 // Contains flags for all of the hardware workarounds which affect pipeline compilation.
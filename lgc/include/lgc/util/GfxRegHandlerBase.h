@@ -39,6 +39,9 @@ struct BitsInfo {
   unsigned index;
   unsigned offset;
   unsigned count;
+
+  // Get the mask of the bits in the dword
+  constexpr unsigned getMask() const { return (count == 32 ? ~0U : (1U << count) - 1) << offset; }
 };
 
 // =====================================================================================================================
@@ -59,7 +62,7 @@ protected:
   }
 
   // Return new dword with replacing the specific range of bits in old dword
-  llvm::Value *replaceBits(llvm::Value *dword, unsigned offset, unsigned count, llvm::Value *newBits);
+  llvm::Value *replaceBits(llvm::Value *dword, const BitsInfo &bitsInfo, llvm::Value *newBits);
 
   // Return the size of registered dwords
   inline unsigned getDwordsCount() { return m_dwords.size(); }
@@ -1345,6 +1345,17 @@ public:
   virtual llvm::Value *CreateCooperativeMatrixConstruct(llvm::Value *coopMatRow, llvm::Value *constVal,
                                                         const llvm::Twine &instName = "") = 0;
 
+  // Create cooperative matrix multiply-add, returning A * B + C. Each lane holds a row of matrix A, and a column of
+  // matrix B, of matrix C and of the result.
+  //
+  // @param matrixA : The row of cooperative matrix A.
+  // @param matrixB : The column of cooperative matrix B, with the same type as matrixA.
+  // @param matrixC : The column of cooperative matrix C, which gives the type of the result.
+  // @param isSigned : Whether the integer components of matrix A and matrix B are signed.
+  // @param instName : Name to give instruction(s).
+  virtual llvm::Value *CreateCooperativeMatrixMulAdd(llvm::Value *matrixA, llvm::Value *matrixB, llvm::Value *matrixC,
+                                                     bool isSigned, const llvm::Twine &instName = "") = 0;
+
   // -----------------------------------------------------------------------------------------------------------------
   // Miscellaneous operations
 
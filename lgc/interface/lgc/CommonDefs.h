@@ -39,6 +39,10 @@ namespace lgc {
 // Type used to hold a 128-bit hash value in LGC and LLPC.
 using Hash128 = std::array<uint64_t, 2>;
 
+// Name of the metadata that a front-end attaches to a 32-bit floating point arithmetic instruction whose result only
+// needs relaxed precision, such as one decorated RelaxedPrecision in SPIR-V.
+static const char RelaxedPrecisionMetadataName[] = "lgc.relaxed.precision";
+
 /// Enumerates LGC shader stages.
 enum ShaderStage : unsigned {
   ShaderStageTask = 0,                                  ///< Task shader
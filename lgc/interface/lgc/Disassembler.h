@@ -30,6 +30,7 @@
  */
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/MemoryBuffer.h"
 
 namespace lgc {
@@ -40,4 +41,14 @@ namespace lgc {
 // @param ostream : The stream to disassemble into
 void disassembleObject(llvm::MemoryBufferRef data, llvm::raw_ostream &ostream);
 
+// Disassemble objects into ostream, in the order given, using up to numThreads threads to disassemble them meanwhile.
+// The disassembly of each object is output as soon as it and those of the objects before it are done. Does
+// report_fatal_error on error.
+//
+// @param objects : The object file contents
+// @param ostream : The stream to disassemble into
+// @param numThreads : Number of threads to disassemble with (0 for the number of hardware threads)
+void disassembleObjects(llvm::ArrayRef<llvm::MemoryBufferRef> objects, llvm::raw_ostream &ostream,
+                        unsigned numThreads);
+
 } // namespace lgc
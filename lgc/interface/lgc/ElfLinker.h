@@ -37,10 +37,14 @@
 
 namespace llvm {
 class raw_pwrite_stream;
+template <typename T> class SmallVectorImpl;
 } // namespace llvm
 
 namespace lgc {
 
+class LgcContext;
+class Pipeline;
+
 // =====================================================================================================================
 // The public API of the LGC interface for ELF linking.
 // The ElfLinker object is created by calling Pipeline::getElfLinker(). The ElfLinker internally refers back to
@@ -50,6 +54,14 @@ class ElfLinker {
 public:
   virtual ~ElfLinker() {}
 
+  // Reset the ElfLinker for another link using the given pipeline and ELFs, as if it had just been created by
+  // Pipeline::createElfLinker. Buffers from earlier links are kept, so a client that links many pipelines can keep one
+  // ElfLinker (for example per thread) and avoid reallocating them for each link.
+  //
+  // @param pipeline : Pipeline whose state is used for the link; must have been created by the same LgcContext
+  // @param elfs : Array of unlinked ELF modules to link
+  virtual void reset(Pipeline *pipeline, llvm::ArrayRef<llvm::MemoryBufferRef> elfs) = 0;
+
   // Add another input ELF to the link, in addition to the ones that were added when the ElfLinker was constructed.
   virtual void addInputElf(llvm::MemoryBufferRef inputElf) = 0;
 
@@ -88,8 +100,25 @@ public:
   //           and empty ELF blob.
   virtual llvm::StringRef compileGlue(unsigned glueIndex) = 0;
 
+  // Compile a particular chunk of glue code in the given LgcContext, and retrieve its blob, as compileGlue above.
+  // Compiling glue code does not use the ElfLinker's LLVMContext, so the client can compile different chunks of glue
+  // code for the same link concurrently, each on its own thread with its own LgcContext for the same target. The
+  // client must call getGlueInfo() before doing that, and must not call other ElfLinker methods until those
+  // compileGlue calls have returned.
+  //
+  // @param glueIndex : Index into the array that was returned by getGlueInfo()
+  // @param lgcContext : LgcContext to compile the glue code in, not in use by any other thread
+  // @returns : The blob, as for compileGlue above
+  virtual llvm::StringRef compileGlue(unsigned glueIndex, LgcContext *lgcContext) = 0;
+
   // Link the unlinked shader or part-pipeline ELFs and the compiled glue code into a pipeline ELF.
   //
+  // The linked ELF depends only on the input ELFs, in the order they were added, the glue code and the pipeline
+  // state: sections, symbols and relocations are output in input order, and the PAL metadata is written from MsgPack
+  // maps that are ordered by key. So the ELF is byte-identical however many threads compiled its inputs and glue code,
+  // and in whatever order they finished, as long as the client adds the inputs in a fixed order. Each input ELF must
+  // have a buffer identifier that is unique in the link, as it is used to name the local symbols made for relocations.
+  //
   // Like other LGC and LLVM library functions, an internal compiler error could cause an assert or report_fatal_error.
   //
   // @param [out] outStream : Stream to write linked ELF to
@@ -100,6 +129,14 @@ public:
   //           reporting in a command-line utility.
   virtual bool link(llvm::raw_pwrite_stream &outStream) = 0;
 
+  // Link the unlinked shader or part-pipeline ELFs and the compiled glue code into a pipeline ELF, writing it directly
+  // into the caller's buffer. The buffer is resized once to the size of the linked ELF, so a buffer whose capacity is
+  // kept from an earlier link is written without reallocation or an intermediate stream.
+  //
+  // @param [out] outBuffer : Buffer to write linked ELF to; previous contents are discarded
+  // @returns : True for success; false as for link(raw_pwrite_stream &)
+  virtual bool link(llvm::SmallVectorImpl<char> &outBuffer) = 0;
+
   // Returns true if the fragment input info has an entry for a builtin.
   virtual bool fragmentShaderUsesMappedBuiltInInputs() = 0;
 };
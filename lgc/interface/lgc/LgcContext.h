@@ -75,14 +75,25 @@ public:
   // allowed to call it again after that. It must also be called before LLVM command-line processing, so
   // that you can use a pass name in an option such as -print-after. If multiple concurrent compiles are
   // possible, this should be called in a thread-safe way.
-  static void initialize();
+  //
+  // In lazy mode, only what the default compile path needs is initialized: the LLVM pass groups that are only
+  // registered so that a pass name can be used in an option are skipped, and so are the AMDGPU asm parser and
+  // disassembler, which are instead initialized by LgcContext::Create and by the users of the disassembler. A later
+  // call that is not in lazy mode initializes the rest.
+  //
+  // @param lazy : Whether to initialize lazily
+  static void initialize(bool lazy = false);
 
   // Create the LgcContext. Returns nullptr on failure to recognize the AMDGPU target whose name is specified
   //
   // @param context : LLVM context to use on all compiles
   // @param gpuName : LLVM GPU name (e.g. "gfx900"); empty to use -mcpu option setting
   // @param palAbiVersion : PAL pipeline ABI version to compile for
-  static LgcContext *Create(llvm::LLVMContext &context, llvm::StringRef gpuName, unsigned palAbiVersion);
+  // @param targetMachine : Optional target machine taken from an earlier LgcContext with takeTargetMachine(), to use
+  //                        instead of creating a new one if it is for the same target and options. The LgcContext
+  //                        takes ownership of it in either case.
+  static LgcContext *Create(llvm::LLVMContext &context, llvm::StringRef gpuName, unsigned palAbiVersion,
+                            llvm::TargetMachine *targetMachine = nullptr);
 
   ~LgcContext();
 
@@ -98,6 +109,11 @@ public:
   // Get the target machine.
   llvm::TargetMachine *getTargetMachine() const { return m_targetMachine; }
 
+  // Take the target machine out of this LgcContext, so it can be given to a new LgcContext (with a new LLVMContext)
+  // that replaces this one, saving the cost of creating a new one. The caller takes ownership of it. The LgcContext
+  // must not be used other than to destroy it after this.
+  llvm::TargetMachine *takeTargetMachine();
+
   // Get targetinfo
   const TargetInfo &getTargetInfo() const { return *m_targetInfo; }
 
@@ -129,6 +145,9 @@ public:
   // Adds target passes to pass manager, depending on "-filetype" and "-emit-llvm" options
   void addTargetPasses(lgc::LegacyPassManager &passMgr, llvm::Timer *codeGenTimer, llvm::raw_pwrite_stream &outStream);
 
+  // Test whether addTargetPasses emits an ELF object, rather than LLVM IR or ISA assembly
+  static bool emitsElf();
+
   // Utility method to create a start/stop timer pass
   static llvm::ModulePass *createStartStopTimer(llvm::Timer *timer, bool starting);
 
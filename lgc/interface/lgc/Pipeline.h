@@ -35,6 +35,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <string>
 
 namespace llvm {
 
@@ -76,6 +77,8 @@ enum class NggSubgroupSizing : unsigned {
   OptimizeForPrims, ///< Sub-group size is optimized for primitive thread utilization
   Explicit,         ///< Sub-group size is allocated based on explicitly-specified vertsPerSubgroup and
                     ///  primsPerSubgroup
+  Adaptive,         ///< Sub-group size is allocated from the measured vertex reuse given by nggVertsPerPrimHint, or
+                    ///  as Auto if that is not measured
 };
 
 /// Enumerate denormal override modes.
@@ -95,6 +98,23 @@ enum class WaveBreak : unsigned {
   _32x32 = 0x3,   ///< Outside a 32x32 pixel region
 };
 
+// Enumerates the precision tiers of the expansions of transcendental operations, such as atan, asin, sinh, cosh, tanh
+// and pow.
+enum class MathPrecision : unsigned {
+  Strict,  ///< The default expansions
+  Relaxed, ///< Shorter polynomials, and native exp/log in place of the range handling of some expansions
+  Fast,    ///< Shortest approximations
+};
+
+// Enumerates the tuning tables of the wave size heuristic, which picks the wave size of shaders that have no explicit
+// wave size from analysis of their IR.
+enum class WaveSizeHeuristic : unsigned {
+  Disable, ///< Use the fixed per-stage default wave sizes
+  Auto,    ///< Use the tuning table of the target GFXIP
+  Gfx10,   ///< Use the GFX10.1 tuning table
+  Gfx103,  ///< Use the GFX10.3 tuning table
+};
+
 // Value for shadowDescriptorTable pipeline option.
 static const unsigned ShadowDescriptorTableDisable = ~0U;
 
@@ -118,6 +138,8 @@ struct Options {
   bool fullSubgroups;                  // Use full subgroup lanes
   unsigned nggVertsPerSubgroup;        // How to determine NGG verts per subgroup
   unsigned nggPrimsPerSubgroup;        // How to determine NGG prims per subgroup
+  unsigned nggVertsPerPrimHint;        // Measured average number of distinct vertices per primitive, in hundredths,
+                                       //   or 0 if not measured (for NggSubgroupSizing::Adaptive)
   unsigned shadowDescriptorTable;      // High dword of shadow descriptor table address, or
                                        //   ShadowDescriptorTableDisable to disable shadow descriptor tables
   unsigned allowNullDescriptor;        // Allow and give defined behavior for null descriptor
@@ -127,6 +149,11 @@ struct Options {
   unsigned reserved1f;                 // Reserved for future functionality
   unsigned enableInterpModePatch; // Enable to do per-sample interpolation for nonperspective and smooth input
   unsigned pageMigrationEnabled;  // Enable page migration
+  WaveSizeHeuristic waveSizeHeuristic; // Heuristic to pick the wave size of shaders without an explicit wave size
+  unsigned robustBufferAccess2;        // Buffer accesses are tightly bounds-checked against the descriptor range
+                                       //   (robustBufferAccess of VK_EXT_robustness2)
+  unsigned groupWaterfallLoops;        // Non-uniform descriptor accesses sharing an index share a waterfall loop
+  unsigned fastCompile;                // Compile with the fast tier: few optimization passes and -O1 codegen
 };
 
 // Middle-end per-shader options to pass to SetShaderOptions.
@@ -195,6 +222,14 @@ struct ShaderOptions {
   // Threshold to use for loops with DontUnroll hint. 0 to use llvm.loop.unroll.disable metadata.
   unsigned dontUnrollHintThreshold;
 
+  // Precision tier of the expansions of transcendental operations.
+  MathPrecision mathPrecision;
+
+  // Minimum number of waves per SIMD that this shader must be able to run with. LGC derives the VGPR limit from it, the
+  // wave size and the LDS that the shader uses, and asks the back-end for that occupancy. The tighter of this and
+  // vgprLimit is used. 0 means no occupancy target.
+  unsigned minWavesPerSimd;
+
   ShaderOptions() {
     // The memory representation of this struct gets written into LLVM metadata. To prevent uninitialized values from
     // being written, we force everything to 0, including alignment gaps.
@@ -347,6 +382,8 @@ struct ColorExportFormat {
   unsigned blendEnable;          // Blend will be enabled for this target at draw time
   unsigned blendSrcAlphaToColor; // Whether source alpha is blended to color channels for this target
                                  //  at draw time
+  unsigned channelWriteMask;     // Mask of the channels (RGBA from bit 0) written to this target at draw time,
+                                 //  0 meaning that all channels are written
 };
 
 // Struct to pass to SetColorExportState
@@ -520,6 +557,12 @@ enum class PipelineLink : unsigned {
                  //  pass its packed input mapping to the compile of the rest of the pipeline.
 };
 
+// Target that a serialized recorded module was written for, as returned by Pipeline::readRecordedModule().
+struct RecordedModuleTarget {
+  std::string gpuName;    // GPU name, as passed to LgcContext::Create()
+  unsigned palAbiVersion; // PAL pipeline ABI version, as passed to LgcContext::Create()
+};
+
 // =====================================================================================================================
 // The public API of the middle-end pipeline state exposed to the front-end for setting state and linking and
 // generating the pipeline
@@ -682,6 +725,44 @@ public:
                         CheckShaderCacheFunc checkShaderCacheFunc, llvm::ArrayRef<llvm::Timer *> timers,
                         bool newPassManager) = 0;
 
+  // Generate as above, writing the output directly into the caller's buffer. The steps that finish the ELF after
+  // codegen (adding -isa-stats statistics, linking the stages of -parallel-codegen) then work on that buffer in place,
+  // rather than in a buffer of their own that is copied to the output stream at the end.
+  //
+  // @param pipelineModule : IR pipeline module
+  // @param [out] outBuffer : Buffer to write ELF or IR disassembly output to; previous contents are discarded
+  // @param checkShaderCacheFunc : Function to check shader cache in graphics pipeline
+  // @param timers : Optional timers, as for the other generate()
+  // @param newPassManager : Whether to use the new pass manager or not
+  // @returns : As for the other generate()
+  virtual bool generate(std::unique_ptr<llvm::Module> pipelineModule, llvm::SmallVectorImpl<char> &outBuffer,
+                        CheckShaderCacheFunc checkShaderCacheFunc, llvm::ArrayRef<llvm::Timer *> timers,
+                        bool newPassManager) = 0;
+
+  // Write the pipeline module returned by irLink() as a serialized recorded module, so the rest of the compile
+  // (the same as generate() does) can be run by a different process, possibly with a different build of LGC.
+  // The serialized form is LLVM bitcode, with the pipeline state recorded in IR metadata along with the target,
+  // and with each lgc.create.* call identified by its name rather than by its Builder opcode number, which is not
+  // stable between LGC versions. This can only be used if the front-end used a BuilderRecorder. The module is
+  // modified, but can still be passed to generate() afterwards.
+  //
+  // @param pipelineModule : IR pipeline module returned by irLink()
+  // @param [out] outStream : Stream to write the serialized module to
+  virtual void writeRecordedModule(llvm::Module *pipelineModule, llvm::raw_ostream &outStream) = 0;
+
+  // Read a serialized recorded module written by writeRecordedModule(). This is a static method in Pipeline, as
+  // the client needs the target returned by it to create the LgcContext (and thus the Pipeline) that compiles
+  // the module. To compile it, the client creates a Pipeline, calls setStateFromModule() on the module, then
+  // passes the module to generate().
+  //
+  // @param blob : Serialized recorded module
+  // @param context : LLVMContext to read the module into
+  // @param [out] target : Target that the module was recorded for
+  // @returns : The module, or nullptr if the blob is not a recorded module in a format version that this LGC can
+  //           read
+  static std::unique_ptr<llvm::Module> readRecordedModule(llvm::MemoryBufferRef blob, llvm::LLVMContext &context,
+                                                          RecordedModuleTarget *target);
+
   // Create an ELF linker object for linking unlinked shader or part-pipeline ELFs into a pipeline ELF using
   // the pipeline state. This needs to be deleted after use.
   virtual ElfLinker *createElfLinker(llvm::ArrayRef<llvm::MemoryBufferRef> elfs) = 0;
@@ -63,6 +63,7 @@ ConfigBuilderBase::ConfigBuilderBase(Module *module, PipelineState *pipelineStat
 
   m_pipelineNode =
       m_document->getRoot().getMap(true)[Util::Abi::PalCodeObjectMetadataKey::Pipelines].getArray(true)[0].getMap(true);
+  m_registers = m_pipelineNode[Util::Abi::PipelineMetadataKey::Registers].getMap(true);
 
   setApiName(pipelineState->getClient());
 }
@@ -289,32 +290,31 @@ void ConfigBuilderBase::setNggSubgroupSize(unsigned value) {
 /// @param [in] value : The metadata value.
 void ConfigBuilderBase::appendConfig(unsigned key, unsigned value) {
   assert(key != InvalidMetadataKey);
-
-  PalMetadataNoteEntry entry;
-  entry.key = key;
-  entry.value = value;
-  m_config.push_back(entry);
+  writeRegister(key, value);
 }
 
 // =====================================================================================================================
-/// Append an array of entries to the PAL register metadata. Invalid keys are filtered out.
+/// Append an array of entries to the PAL register metadata. Invalid keys are filtered out. The entries are written
+/// straight into the MsgPack document, without being collected first.
 ///
 /// @param [in] config : The array of register metadata entries.
 void ConfigBuilderBase::appendConfig(ArrayRef<PalMetadataNoteEntry> config) {
-  unsigned count = 0;
-
   for (const auto &entry : config) {
     if (entry.key != InvalidMetadataKey)
-      ++count;
+      writeRegister(entry.key, entry.value);
   }
+}
 
-  unsigned idx = m_config.size();
-  m_config.resize(idx + count);
-
-  for (const auto &entry : config) {
-    if (entry.key != InvalidMetadataKey)
-      m_config[idx++] = entry;
-  }
+// =====================================================================================================================
+// Write a register value into the ".registers" map of the PAL metadata. An earlier pass may have already set the
+// register, in which case that value is kept, as is the first value set by the config builder for a register.
+//
+// @param key : The register address
+// @param value : The register value
+void ConfigBuilderBase::writeRegister(unsigned key, unsigned value) {
+  auto &regEntry = m_registers[key];
+  if (regEntry.getKind() != msgpack::Type::UInt)
+    regEntry = value;
 }
 
 // =====================================================================================================================
@@ -326,24 +326,6 @@ bool ConfigBuilderBase::usesViewportArrayIndex() {
   return m_pipelineNode[Util::Abi::PipelineMetadataKey::UsesViewportArrayIndex].getBool();
 }
 
-// =====================================================================================================================
-// Finish ConfigBuilder processing by writing into the PalMetadata document
-void ConfigBuilderBase::writePalMetadata() {
-  // Generating MsgPack metadata.
-  // Add the register values to the MsgPack document. The value is ORed in because an earlier pass may have
-  // already set some bits in the same register.
-  msgpack::MapDocNode registers = m_pipelineNode[".registers"].getMap(true);
-  for (const auto &entry : m_config) {
-    assert(entry.key != InvalidMetadataKey);
-    auto key = entry.key;
-    auto &regEntry = registers[key];
-    unsigned oredValue = entry.value;
-    if (regEntry.getKind() == msgpack::Type::UInt)
-      oredValue = regEntry.getUInt();
-    regEntry = oredValue;
-  }
-}
-
 // =====================================================================================================================
 // Sets up floating point mode from the specified floating point control flags.
 //
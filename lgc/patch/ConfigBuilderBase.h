@@ -56,14 +56,14 @@ struct PalMetadataNoteEntry {
 };
 
 // =====================================================================================================================
-// Register configuration builder base class.
+// Register configuration builder base class. The Gfx6 and Gfx9 builders fill in register tables of their own layouts,
+// and everything that writes the PAL metadata, including the registers of the tables, goes through this class, so that
+// both generations share how it is written.
 class ConfigBuilderBase {
 public:
   ConfigBuilderBase(llvm::Module *module, PipelineState *pipelineState);
   ~ConfigBuilderBase();
 
-  void writePalMetadata();
-
 protected:
   void addApiHwShaderMapping(ShaderStage apiStage, unsigned hwStages);
 
@@ -111,17 +111,18 @@ private:
   llvm::msgpack::MapDocNode getApiShaderNode(unsigned apiStage);
   // Get the MsgPack map node for the specified HW shader in the ".hardware_stages" map
   llvm::msgpack::MapDocNode getHwShaderNode(Util::Abi::HardwareStage hwStage);
+  // Write a register value into the ".registers" map, unless an earlier pass has already set the register
+  void writeRegister(unsigned key, unsigned value);
 
   llvm::msgpack::Document *m_document;                 // The MsgPack document
   llvm::msgpack::MapDocNode m_pipelineNode;            // MsgPack map node for amdpal.pipelines[0]
+  llvm::msgpack::MapDocNode m_registers;               // MsgPack map node for amdpal.pipelines[0].registers
   llvm::msgpack::MapDocNode m_apiShaderNodes[ShaderStageNativeStageCount];
   // MsgPack map node for each API shader's node in
   //  ".shaders"
   llvm::msgpack::MapDocNode m_hwShaderNodes[unsigned(Util::Abi::HardwareStage::Count)];
   // MsgPack map node for each HW shader's node in
   //  ".hardware_stages"
-
-  llvm::SmallVector<PalMetadataNoteEntry, 128> m_config; // Register/metadata configuration
 };
 
 } // namespace lgc
@@ -96,8 +96,10 @@ static void extractElements(Value *input, BuilderBase &builder, SmallVectorImpl<
 // @param builder : The IR builder for inserting instructions
 // @param expFmt: The format for the given render target
 // @param signedness: If output should be interpreted as a signed integer
+// @param channelMask: Mask of the channels (RGBA from bit 0) that need exporting; the others are left out
 Value *FragColorExport::handleColorExportInstructions(Value *output, unsigned hwColorTarget, BuilderBase &builder,
-                                                      ExportFormat expFmt, const bool signedness) {
+                                                      ExportFormat expFmt, const bool signedness,
+                                                      unsigned channelMask) {
   Type *outputTy = output->getType();
   const unsigned bitWidth = outputTy->getScalarSizeInBits();
   unsigned compCount = outputTy->isVectorTy() ? cast<FixedVectorType>(outputTy)->getNumElements() : 1;
@@ -240,15 +242,37 @@ Value *FragColorExport::handleColorExportInstructions(Value *output, unsigned hw
   }
   }
 
+  // Work out which export slots hold channels that need exporting. The slots of 32_GR are red and green, and those of
+  // 32_AR are red and alpha. A compressed export enables its slots in pairs, each pair holding two channels.
+  unsigned exportMask = (1 << compCount) - 1;
+  if (exportTy->isHalfTy()) {
+    exportMask = compCount > 2 ? 0xF : 0x3;
+    if ((channelMask & 0x3) == 0)
+      exportMask &= ~0x3;
+    if ((channelMask & 0xC) == 0)
+      exportMask &= ~0xC;
+  } else if (expFmt == EXP_FORMAT_32_AR) {
+    exportMask &= (channelMask & 0x1) | ((channelMask >> 2) & 0x2);
+  } else {
+    exportMask &= channelMask;
+  }
+  // The export must still enable something, as the export format says there is an export for this target.
+  if (exportMask == 0)
+    exportMask = exportTy->isHalfTy() ? 0x3 : 0x1;
+
   Value *exportCall = nullptr;
 
   if (exportTy->isHalfTy()) {
     // 16-bit export (compressed)
     if (compCount <= 2)
       comps[1] = undefFloat16x2;
+    for (unsigned i = 0; i < 2; ++i) {
+      if ((exportMask & (0x3 << (2 * i))) == 0)
+        comps[i] = undefFloat16x2;
+    }
     Value *args[] = {
         builder.getInt32(EXP_TARGET_MRT_0 + hwColorTarget), // tgt
-        builder.getInt32(compCount > 2 ? 0xF : 0x3),        // en
+        builder.getInt32(exportMask),                       // en
         comps[0],                                           // src0
         comps[1],                                           // src1
         builder.getFalse(),                                 // done
@@ -258,12 +282,14 @@ Value *FragColorExport::handleColorExportInstructions(Value *output, unsigned hw
     exportCall = builder.CreateNamedCall("llvm.amdgcn.exp.compr.v2f16", Type::getVoidTy(*m_context), args, {});
   } else {
     // 32-bit export
-    for (unsigned i = compCount; i < 4; i++)
-      comps[i] = undefFloat;
+    for (unsigned i = 0; i < 4; i++) {
+      if ((exportMask & (1 << i)) == 0)
+        comps[i] = undefFloat;
+    }
 
     Value *args[] = {
         builder.getInt32(EXP_TARGET_MRT_0 + hwColorTarget), // tgt
-        builder.getInt32((1 << compCount) - 1),             // en
+        builder.getInt32(exportMask),                       // en
         comps[0],                                           // src0
         comps[1],                                           // src1
         comps[2],                                           // src2
@@ -428,8 +454,11 @@ bool LegacyLowerFragColorExport::runOnModule(Module &module) {
 PreservedAnalyses LowerFragColorExport::run(Module &module, ModuleAnalysisManager &analysisManager) {
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
   PipelineShadersResult &pipelineShaders = analysisManager.getResult<PipelineShaders>(module);
-  if (runImpl(module, pipelineShaders, pipelineState))
-    return PreservedAnalyses::none();
+  if (runImpl(module, pipelineShaders, pipelineState)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
   return PreservedAnalyses::all();
 }
 
@@ -823,7 +852,8 @@ void FragColorExport::generateExportInstructions(ArrayRef<lgc::ColorExportInfo>
     Value *output = values[exp.hwColorTarget];
     if (exp.hwColorTarget != MaxColorTargets) {
       ExportFormat expFmt = exportFormat[exp.hwColorTarget];
-      Value *currentExport = handleColorExportInstructions(output, exp.hwColorTarget, builder, expFmt, exp.isSigned);
+      Value *currentExport = handleColorExportInstructions(output, exp.hwColorTarget, builder, expFmt, exp.isSigned,
+                                                           m_pipelineState->getColorExportChannelMask(exp.location));
       if (currentExport) {
         lastExport = currentExport;
       }
@@ -846,8 +876,6 @@ void FragColorExport::generateExportInstructions(ArrayRef<lgc::ColorExportInfo>
     }
   }
 
-  (void(m_pipelineState)); // Unused
-
   if (!lastExport && dummyExport) {
     lastExport = FragColorExport::addDummyExport(builder);
   }
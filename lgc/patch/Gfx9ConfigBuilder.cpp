@@ -84,8 +84,6 @@ void ConfigBuilder::buildPalMetadata() {
         buildPipelineVsTsGsFsRegConfig();
     }
   }
-
-  writePalMetadata();
 }
 
 // =====================================================================================================================
@@ -1990,6 +1988,7 @@ void ConfigBuilder::buildCsRegConfig(ShaderStage shaderStage, CsRegConfig *confi
     break;
   case WorkgroupLayout::Quads:
   case WorkgroupLayout::SexagintiQuads:
+  case WorkgroupLayout::ZOrder:
     workgroupSizes[0] = computeMode.workgroupSizeX * computeMode.workgroupSizeY;
     workgroupSizes[1] = computeMode.workgroupSizeZ;
     workgroupSizes[2] = 1;
@@ -2015,10 +2014,12 @@ void ConfigBuilder::buildCsRegConfig(ShaderStage shaderStage, CsRegConfig *confi
   // Set registers based on shader interface data
   SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TRAP_PRESENT, shaderOptions.trapPresent);
   SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, USER_SGPR, intfData->userDataCount);
-  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_X_EN, true);
-  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_Y_EN, true);
-  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_Z_EN, true);
-  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TG_SIZE_EN, true);
+  // The workgroup ID and TG_SIZE SGPRs are only set up if the shader has arguments for them.
+  const bool workgroupIdEn = intfData->entryArgIdxs.cs.workgroupId != 0;
+  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_X_EN, workgroupIdEn);
+  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_Y_EN, workgroupIdEn);
+  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TGID_Z_EN, workgroupIdEn);
+  SET_REG_FIELD(config, COMPUTE_PGM_RSRC2, TG_SIZE_EN, intfData->entryArgIdxs.cs.multiDispatchInfo != 0);
 
   // 0 = X, 1 = XY, 2 = XYZ
   unsigned tidigCompCnt = 0;
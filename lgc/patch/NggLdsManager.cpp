@@ -107,6 +107,35 @@ const char *NggLdsManager::m_ldsRegionNames[LdsRegionCount] = {
     // clang-format on
 };
 
+// =====================================================================================================================
+// Initialize static members
+const std::pair<NggLdsPhase, NggLdsPhase> NggLdsManager::LdsRegionLifetimes[LdsRegionCount] = {
+    // clang-format off
+    //
+    // LDS region lifetime for ES-only (not used to plan the layout)
+    //
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionDistribPrimId
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionVertPosData
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionVertCullInfo
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionVertCountInWaves
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionVertThreadIdMap
+
+    //
+    // LDS region lifetime for ES-GS
+    //
+    // Written by ES, read by GS
+    {NggLdsPhaseEs, NggLdsPhaseGs},          // LdsRegionEsGsRing
+    // Initialized once ES is done, written by GS, read by culling and primitive export
+    {NggLdsPhaseEs, NggLdsPhaseExport},      // LdsRegionOutPrimData
+    // Initialized once GS is done (while other waves may still run GS), accumulated and read by compaction
+    {NggLdsPhaseGs, NggLdsPhaseCompact},     // LdsRegionOutVertCountInWaves
+    // Written by compaction, read by vertex export
+    {NggLdsPhaseCompact, NggLdsPhaseExport}, // LdsRegionOutVertThreadIdMap
+    // Written by GS, read by culling and vertex export
+    {NggLdsPhaseGs, NggLdsPhaseExport},      // LdsRegionGsVsRing
+    // clang-format on
+};
+
 // =====================================================================================================================
 //
 // @param module : LLVM module
@@ -139,24 +168,25 @@ NggLdsManager::NggLdsManager(Module *module, PipelineState *pipelineState, IRBui
 
   if (hasGs) {
     //
-    // The LDS layout is something like this:
+    // The LDS layout is planned from the lifetimes of the regions, and is something like this:
     //
     // +------------+-----------------------+------------------------------+-----------------------------+------------+
     // | ES-GS ring | GS out primitive data | GS out vertex counts (waves) | GS out vertex thread ID map | GS-VS ring |
     // +------------+-----------------------+------------------------------+-----------------------------+------------+
     //
+    // except that the GS out vertex thread ID map, which is only live once the ES-GS ring is dead, is placed over the
+    // start of the ES-GS ring if that is big enough.
+    //
 
     // NOTE: We round ES-GS LDS size to 4-dword alignment. This is for later LDS read/write operations of mutilple
     // dwords (such as DS128).
     const unsigned esGsRingLdsSize = alignTo(calcFactor.esGsLdsSize, 4u) * SizeOfDword;
-    const unsigned gsVsRingLdsSize =
-        calcFactor.gsOnChipLdsSize * SizeOfDword - esGsRingLdsSize - calcGsExtraLdsSize(m_pipelineState);
-
-    unsigned ldsRegionStart = 0;
+    const unsigned gsVsRingLdsStart = planGsLdsLayout(m_pipelineState, esGsRingLdsSize, m_ldsRegionStart);
+    const unsigned gsVsRingLdsSize = calcFactor.gsOnChipLdsSize * SizeOfDword - gsVsRingLdsStart;
 
     for (unsigned region = LdsRegionGsBeginRange; region <= LdsRegionGsEndRange; ++region) {
-      // NOTE: For vertex compactionless mode, this region is unnecessary
-      if (region == LdsRegionOutVertThreadIdMap && nggControl->compactMode == NggCompactDisable)
+      // NOTE: For vertex compactionless mode, the GS out vertex thread ID map is unnecessary
+      if (m_ldsRegionStart[region] == InvalidValue)
         continue;
 
       unsigned ldsRegionSize = LdsRegionSizes[region];
@@ -169,10 +199,7 @@ NggLdsManager::NggLdsManager(Module *module, PipelineState *pipelineState, IRBui
       if (region == LdsRegionGsVsRing)
         ldsRegionSize = gsVsRingLdsSize;
 
-      m_ldsRegionStart[region] = ldsRegionStart;
       assert(ldsRegionSize != InvalidValue);
-      ldsRegionStart += ldsRegionSize;
-
       LLPC_OUTS(format("%-40s : offset = 0x%04" PRIX32 ", size = 0x%04" PRIX32, m_ldsRegionNames[region],
                        m_ldsRegionStart[region], ldsRegionSize)
                 << "\n");
@@ -303,6 +330,65 @@ unsigned NggLdsManager::calcGsExtraLdsSize(PipelineState *pipelineState) {
          (nggControl->compactMode == NggCompactDisable ? 0 : LdsRegionSizes[LdsRegionOutVertThreadIdMap]);
 }
 
+// =====================================================================================================================
+// Plans the LDS layout of NGG with API GS. Each region is placed at the lowest 16-byte aligned offset at which it does
+// not overlap any already placed region whose lifetime intersects its own, so regions that are never live in the same
+// phase share LDS. The ES-GS ring is placed first, at offset 0, as the ES-GS vertex offsets given to the GS are
+// relative to the start of LDS. The GS-VS ring is placed after all other regions, and takes the rest of the LDS
+// allocation.
+//
+// @param pipelineState : Pipeline state
+// @param esGsRingLdsSize : LDS size of the ES-GS ring (in bytes)
+// @param [out] regionStarts : If not null, array of LdsRegionCount entries to set the start LDS offsets of the used
+//                             GS LDS regions in (in bytes)
+// @returns : Start LDS offset of the GS-VS ring, which is the LDS size needed by all other regions (in bytes)
+unsigned NggLdsManager::planGsLdsLayout(PipelineState *pipelineState, unsigned esGsRingLdsSize,
+                                        unsigned *regionStarts) {
+  const auto nggControl = pipelineState->getNggControl();
+  auto getRegionSize = [&](unsigned region) {
+    return region == LdsRegionEsGsRing ? esGsRingLdsSize : LdsRegionSizes[region];
+  };
+  auto lifetimesIntersect = [](unsigned region1, unsigned region2) {
+    return LdsRegionLifetimes[region1].first <= LdsRegionLifetimes[region2].second &&
+           LdsRegionLifetimes[region2].first <= LdsRegionLifetimes[region1].second;
+  };
+
+  SmallVector<std::pair<unsigned, unsigned>, LdsRegionCount> placedRegions; // {region, start offset}
+  unsigned gsVsRingLdsStart = 0;
+  for (unsigned region = LdsRegionGsBeginRange; region != LdsRegionGsVsRing; ++region) {
+    // NOTE: For vertex compactionless mode, this region is unnecessary
+    if (region == LdsRegionOutVertThreadIdMap && nggControl->compactMode == NggCompactDisable)
+      continue;
+
+    // Gather the LDS ranges of the placed regions that are live at the same time as this one, in order of start
+    // offset, then find the first gap that this region fits in.
+    SmallVector<std::pair<unsigned, unsigned>, LdsRegionCount> liveRanges; // {start offset, end offset}
+    for (std::pair<unsigned, unsigned> placedRegion : placedRegions) {
+      if (lifetimesIntersect(region, placedRegion.first))
+        liveRanges.push_back({placedRegion.second, placedRegion.second + getRegionSize(placedRegion.first)});
+    }
+    llvm::sort(liveRanges);
+
+    const unsigned regionSize = getRegionSize(region);
+    assert(regionSize != InvalidValue);
+    unsigned regionStart = 0;
+    for (std::pair<unsigned, unsigned> liveRange : liveRanges) {
+      if (regionStart + regionSize <= liveRange.first)
+        break;
+      regionStart = std::max<unsigned>(regionStart, alignTo(liveRange.second, SizeOfVec4));
+    }
+
+    placedRegions.push_back({region, regionStart});
+    gsVsRingLdsStart = std::max<unsigned>(gsVsRingLdsStart, alignTo(regionStart + regionSize, SizeOfVec4));
+    if (regionStarts)
+      regionStarts[region] = regionStart;
+  }
+
+  if (regionStarts)
+    regionStarts[LdsRegionGsVsRing] = gsVsRingLdsStart;
+  return gsVsRingLdsStart;
+}
+
 // =====================================================================================================================
 // Reads value from LDS.
 //
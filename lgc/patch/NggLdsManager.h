@@ -71,6 +71,15 @@ enum NggLdsRegionType {
   // clang-format on
 };
 
+// Enumerates the phases of the NGG primitive shader with API GS, used as the lifetimes of the LDS regions. Each phase
+// is separated from the next by a barrier, so regions that are not live in a common phase can share LDS.
+enum NggLdsPhase {
+  NggLdsPhaseEs,      // ES, and the initialization of GS output primitive data
+  NggLdsPhaseGs,      // GS, and the initialization of GS output vertex counts
+  NggLdsPhaseCompact, // Culling, and the counting and compaction of GS output vertices
+  NggLdsPhaseExport,  // Primitive and vertex export
+};
+
 // Size of a dword
 static const unsigned SizeOfDword = sizeof(unsigned);
 
@@ -83,6 +92,8 @@ public:
   static bool needsLds(PipelineState *pipelineState);
   static unsigned calcEsExtraLdsSize(PipelineState *pipelineState);
   static unsigned calcGsExtraLdsSize(PipelineState *pipelineState);
+  static unsigned planGsLdsLayout(PipelineState *pipelineState, unsigned esGsRingLdsSize,
+                                  unsigned *regionStarts = nullptr);
 
   // Gets the LDS starting offset for the specified region
   unsigned getLdsRegionStart(NggLdsRegionType region) const {
@@ -103,6 +114,8 @@ private:
 
   static const unsigned LdsRegionSizes[LdsRegionCount]; // LDS sizes for all LDS region types (in bytes)
   static const char *m_ldsRegionNames[LdsRegionCount];  // Name strings for all LDS region types
+  static const std::pair<NggLdsPhase, NggLdsPhase>
+      LdsRegionLifetimes[LdsRegionCount]; // First and last phases of NGG GS LDS regions
 
   PipelineState *m_pipelineState; // Pipeline state
   llvm::LLVMContext *m_context;   // LLVM context
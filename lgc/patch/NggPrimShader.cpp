@@ -793,7 +793,7 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
   //   if (!runtimePassthrough) {
   //     if (threadIdInSubgroup < vertCountInSubgroup)
   //       Initialize vertex draw flag
-  //     if (threadIdInSubgroup < waveCount + 1)
+  //     if (!singleWave && threadIdInSubgroup < waveCount + 1)
   //       Initialize per-wave and per-subgroup count of output vertices
   //
   //     if (threadIdInWave < vertCountInWave)
@@ -810,9 +810,12 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
   //     if (threadIdInSubgroup < vertCountInSubgroup)
   //       Check draw flags of vertices and compute draw mask
   //
-  //     if (threadIdInWave < waveCount - waveId)
-  //       Accumulate per-wave and per-subgroup count of output vertices
-  //     Barrier
+  //     if (!singleWave) {
+  //       if (threadIdInWave < waveCount - waveId)
+  //         Accumulate per-wave and per-subgroup count of output vertices
+  //       Barrier
+  //       Read per-wave and per-subgroup count of output vertices
+  //     }
   //
   //     if (vertex compacted && vertex drawed) {
   //       Compact vertex thread ID (map: compacted -> uncompacted)
@@ -899,6 +902,9 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
   auto accumVertCountBlock = createBlock(entryPoint, ".accumVertCount");
   auto endAccumVertCountBlock = createBlock(entryPoint, ".endAccumVertCount");
 
+  auto readVertCountBlock = createBlock(entryPoint, ".readVertCount");
+  auto endReadVertCountBlock = createBlock(entryPoint, ".endReadVertCount");
+
   auto compactVertBlock = disableCompact ? nullptr : createBlock(entryPoint, ".compactVert"); // Conditionally created
   auto endCompactVertBlock = createBlock(entryPoint, ".endCompactVert");
 
@@ -1062,9 +1068,18 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
   }
 
   // Construct ".noRuntimePassthrough" block
+  Value *singleWave = nullptr;
   {
     m_builder->SetInsertPoint(noRuntimePassthroughBlock);
 
+    // NOTE: If both vertices and primitives of this sub-group fit in one wave, the sub-group has one wave only. The
+    // count of output vertices is then known from the draw mask of this wave, so we can skip accumulating per-wave
+    // counts in LDS and the barrier that is required before reading them back.
+    singleWave = m_builder->CreateAnd(
+        m_builder->CreateICmpULE(m_nggFactor.vertCountInSubgroup, m_builder->getInt32(waveSize)),
+        m_builder->CreateICmpULE(m_nggFactor.primCountInSubgroup, m_builder->getInt32(waveSize)));
+    singleWave->setName("singleWave");
+
     auto vertValid = m_builder->CreateICmpULT(m_nggFactor.threadIdInSubgroup, m_nggFactor.vertCountInSubgroup);
     m_builder->CreateCondBr(vertValid, initVertDrawFlagBlock, endInitVertDrawFlagBlock);
   }
@@ -1084,6 +1099,7 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
 
     auto waveValid =
         m_builder->CreateICmpULT(m_nggFactor.threadIdInSubgroup, m_builder->getInt32(waveCountInSubgroup + 1));
+    waveValid = m_builder->CreateAnd(waveValid, m_builder->CreateNot(singleWave));
     m_builder->CreateCondBr(waveValid, initVertCountBlock, endInitVertCountBlock);
   }
 
@@ -1219,6 +1235,7 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
 
     auto threadIdUpbound = m_builder->CreateSub(m_builder->getInt32(waveCountInSubgroup), m_nggFactor.waveIdInSubgroup);
     auto threadValid = m_builder->CreateICmpULT(m_nggFactor.threadIdInWave, threadIdUpbound);
+    threadValid = m_builder->CreateAnd(threadValid, m_builder->CreateNot(singleWave));
 
     m_builder->CreateCondBr(threadValid, accumVertCountBlock, endAccumVertCountBlock);
   }
@@ -1240,11 +1257,17 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
   }
 
   // Construct ".endAccumVertCount" block
+  {
+    m_builder->SetInsertPoint(endAccumVertCountBlock);
+
+    m_builder->CreateCondBr(singleWave, endReadVertCountBlock, readVertCountBlock);
+  }
+
+  // Construct ".readVertCount" block
   Value *vertCountInPrevWaves = nullptr;
   Value *vertCountInSubgroup = nullptr;
-  Value *vertCompacted = nullptr;
   {
-    m_builder->SetInsertPoint(endAccumVertCountBlock);
+    m_builder->SetInsertPoint(readVertCountBlock);
 
     m_builder->CreateIntrinsic(Intrinsic::amdgcn_s_barrier, {}, {});
 
@@ -1256,12 +1279,32 @@ void NggPrimShader::constructPrimShaderWithoutGs(Module *module) {
     vertCountInSubgroup = m_builder->CreateIntrinsic(Intrinsic::amdgcn_readlane, {},
                                                      {vertCountInWaves, m_builder->getInt32(waveCountInSubgroup)});
 
+    // Get vertex count for all waves prior to this wave
+    vertCountInPrevWaves =
+        m_builder->CreateIntrinsic(Intrinsic::amdgcn_readlane, {}, {vertCountInWaves, m_nggFactor.waveIdInSubgroup});
+
+    m_builder->CreateBr(endReadVertCountBlock);
+  }
+
+  // Construct ".endReadVertCount" block
+  Value *vertCompacted = nullptr;
+  {
+    m_builder->SetInsertPoint(endReadVertCountBlock);
+
+    // In a single-wave sub-group, the vertex count of this wave is that of the entire sub-group and there are no
+    // prior waves
+    auto vertCountInSubgroupPhi = m_builder->CreatePHI(m_builder->getInt32Ty(), 2);
+    vertCountInSubgroupPhi->addIncoming(vertCountInWave, endAccumVertCountBlock);
+    vertCountInSubgroupPhi->addIncoming(vertCountInSubgroup, readVertCountBlock);
+    vertCountInSubgroup = vertCountInSubgroupPhi;
+
     if (disableCompact) {
       m_builder->CreateBr(endCompactVertBlock);
     } else {
-      // Get vertex count for all waves prior to this wave
-      vertCountInPrevWaves =
-          m_builder->CreateIntrinsic(Intrinsic::amdgcn_readlane, {}, {vertCountInWaves, m_nggFactor.waveIdInSubgroup});
+      auto vertCountInPrevWavesPhi = m_builder->CreatePHI(m_builder->getInt32Ty(), 2);
+      vertCountInPrevWavesPhi->addIncoming(m_builder->getInt32(0), endAccumVertCountBlock);
+      vertCountInPrevWavesPhi->addIncoming(vertCountInPrevWaves, readVertCountBlock);
+      vertCountInPrevWaves = vertCountInPrevWavesPhi;
 
       vertCompacted = m_builder->CreateICmpULT(vertCountInSubgroup, m_nggFactor.vertCountInSubgroup);
       m_builder->CreateCondBr(m_builder->CreateAnd(drawFlag, vertCompacted), compactVertBlock, endCompactVertBlock);
@@ -1677,6 +1720,15 @@ void NggPrimShader::constructPrimShaderWithGs(Module *module) {
   {
     m_builder->SetInsertPoint(entryBlock);
 
+    // If the GS outputs are kept in registers, create the per-dword storage that the GS writes them to and the copy
+    // shader reads them from (see NggPrimShader::exportGsOutput).
+    if (inOutUsage.calcFactor.gsOutputsInRegs) {
+      const unsigned outputDwordCount =
+          4 * std::max(1u, m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->inOutUsage.outputMapLocCount);
+      for (unsigned i = 0; i < outputDwordCount; ++i)
+        m_gsOutputRegs.push_back(m_builder->CreateAlloca(m_builder->getInt32Ty()));
+    }
+
     initWaveThreadInfo(mergedGroupInfo, mergedWaveInfo);
 
     // Record primitive shader table address info
@@ -2127,11 +2179,31 @@ Value *NggPrimShader::doCulling(Module *module, Value *vertexId0, Value *vertexI
   if (!enableCulling())
     return m_builder->getFalse();
 
+  Value *vertices[] = {fetchVertexPositionData(vertexId0), fetchVertexPositionData(vertexId1),
+                       fetchVertexPositionData(vertexId2)};
+  SmallVector<Value *, 3> signMasks;
+  if (m_nggControl->enableCullDistanceCulling) {
+    signMasks.push_back(fetchCullDistanceSignMask(vertexId0));
+    signMasks.push_back(fetchCullDistanceSignMask(vertexId1));
+    signMasks.push_back(fetchCullDistanceSignMask(vertexId2));
+  }
+  return cullPrimitive(module, vertices, signMasks);
+}
+
+// =====================================================================================================================
+// Runs the enabled cullers on a triangle whose vertex data has already been fetched, so that an output path that keeps
+// the vertex positions in its own storage can cull its primitives without the ES-GS ring layout of the vertices.
+//
+// @param module : LLVM module
+// @param vertices : Positions of the three vertices of the triangle
+// @param signMasks : Cull distance sign masks of the three vertices (empty if cull distance culling is disabled)
+Value *NggPrimShader::cullPrimitive(Module *module, ArrayRef<Value *> vertices, ArrayRef<Value *> signMasks) {
+  assert(vertices.size() == 3);
   Value *cullFlag = m_builder->getFalse();
 
-  Value *vertex0 = fetchVertexPositionData(vertexId0);
-  Value *vertex1 = fetchVertexPositionData(vertexId1);
-  Value *vertex2 = fetchVertexPositionData(vertexId2);
+  Value *vertex0 = vertices[0];
+  Value *vertex1 = vertices[1];
+  Value *vertex2 = vertices[2];
 
   // Handle backface culling
   if (m_nggControl->enableBackfaceCulling)
@@ -2155,10 +2227,8 @@ Value *NggPrimShader::doCulling(Module *module, Value *vertexId0, Value *vertexI
 
   // Handle cull distance culling
   if (m_nggControl->enableCullDistanceCulling) {
-    Value *signMask0 = fetchCullDistanceSignMask(vertexId0);
-    Value *signMask1 = fetchCullDistanceSignMask(vertexId1);
-    Value *signMask2 = fetchCullDistanceSignMask(vertexId2);
-    cullFlag = doCullDistanceCulling(module, cullFlag, signMask0, signMask1, signMask2);
+    assert(signMasks.size() == 3);
+    cullFlag = doCullDistanceCulling(module, cullFlag, signMasks[0], signMasks[1], signMasks[2]);
   }
 
   return cullFlag;
@@ -2414,31 +2484,16 @@ void NggPrimShader::doEarlyExit(unsigned fullyCulledExportCount) {
       unsigned posExpCount = 1;
       if (m_hasGs) {
         const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->builtInUsage.gs;
-
-        bool miscExport = builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex;
-        miscExport |= builtInUsage.primitiveShadingRate;
-        if (miscExport)
-          ++posExpCount;
-
         posExpCount += (builtInUsage.clipDistance + builtInUsage.cullDistance) / 4;
       } else if (m_hasTcs || m_hasTes) {
-        const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->builtInUsage.tes;
-
-        bool miscExport = builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex;
-        if (miscExport)
-          ++posExpCount;
-
+        const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageTessEval)->builtInUsage.tes;
         posExpCount += (builtInUsage.clipDistance + builtInUsage.cullDistance) / 4;
       } else {
-        const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->builtInUsage.vs;
-
-        bool miscExport = builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex;
-        miscExport |= builtInUsage.primitiveShadingRate;
-        if (miscExport)
-          ++posExpCount;
-
+        const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageVertex)->builtInUsage.vs;
         posExpCount += (builtInUsage.clipDistance + builtInUsage.cullDistance) / 4;
       }
+      if (hasMiscExport())
+        ++posExpCount;
 
       undef = UndefValue::get(m_builder->getFloatTy());
 
@@ -2873,16 +2928,13 @@ void NggPrimShader::splitEs(Module *module) {
     if (hasTs) {
       const auto &builtInUsage = resUsage->builtInUsage.tes;
 
-      bool miscExport = builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex;
-      clipCullPos = miscExport ? EXP_TARGET_POS_2 : EXP_TARGET_POS_1;
+      clipCullPos = hasMiscExport() ? EXP_TARGET_POS_2 : EXP_TARGET_POS_1;
       clipDistanceCount = builtInUsage.clipDistance;
       cullDistanceCount = builtInUsage.cullDistance;
     } else {
       const auto &builtInUsage = resUsage->builtInUsage.vs;
 
-      bool miscExport = builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex;
-      miscExport |= builtInUsage.primitiveShadingRate;
-      clipCullPos = miscExport ? EXP_TARGET_POS_2 : EXP_TARGET_POS_1;
+      clipCullPos = hasMiscExport() ? EXP_TARGET_POS_2 : EXP_TARGET_POS_1;
       clipDistanceCount = builtInUsage.clipDistance;
       cullDistanceCount = builtInUsage.cullDistance;
     }
@@ -3123,6 +3175,9 @@ void NggPrimShader::runGs(Module *module, Argument *sysValueStart) {
   args.push_back(m_nggFactor.esGsOffset5);
   args.push_back(invocationId);
 
+  // Set up the storage of GS outputs kept in registers
+  args.insert(args.end(), m_gsOutputRegs.begin(), m_gsOutputRegs.end());
+
   assert(args.size() == gsArgCount); // Must have visit all arguments of ES entry point
 
   m_builder->CreateCall(gsEntry, args);
@@ -3138,6 +3193,11 @@ Function *NggPrimShader::mutateGs(Module *module) {
   auto gsEntryPoint = module->getFunction(lgcName::NggGsEntryPoint);
   assert(gsEntryPoint);
 
+  // If the GS outputs are kept in registers, GS gets the pointers to their storage as extra arguments.
+  SmallVector<Value *, 16> outputRegs;
+  if (!m_gsOutputRegs.empty())
+    gsEntryPoint = addGsOutputRegsArgs(gsEntryPoint, outputRegs);
+
   auto savedInsertPos = m_builder->saveIP();
 
   std::vector<Instruction *> removeCalls;
@@ -3194,7 +3254,7 @@ Function *NggPrimShader::mutateGs(Module *module) {
         Value *output = call->getOperand(3);
 
         auto emitVerts = m_builder->CreateLoad(m_builder->getInt32Ty(), emitVertsPtrs[streamId]);
-        exportGsOutput(output, location, compIdx, streamId, threadIdInSubgroup, emitVerts);
+        exportGsOutput(output, location, compIdx, streamId, threadIdInSubgroup, emitVerts, outputRegs);
 
         removeCalls.push_back(call);
       }
@@ -3299,6 +3359,9 @@ void NggPrimShader::runCopyShader(Module *module, Argument *sysValueStart) {
   // Vertex ID in sub-group
   args.push_back(vertexId);
 
+  // Storage of GS outputs kept in registers
+  args.insert(args.end(), m_gsOutputRegs.begin(), m_gsOutputRegs.end());
+
   m_builder->CreateCall(copyShaderEntry, args);
 }
 
@@ -3312,8 +3375,12 @@ Function *NggPrimShader::mutateCopyShader(Module *module) {
 
   auto savedInsertPos = m_builder->saveIP();
 
-  // Vertex ID is always the last argument
-  auto vertexId = getFunctionArgument(copyShaderEntryPoint, copyShaderEntryPoint->arg_size() - 1);
+  // Vertex ID is always the last argument, followed by the storage of GS outputs if they are kept in registers
+  const unsigned vertexIdArgIdx = copyShaderEntryPoint->arg_size() - 1;
+  SmallVector<Value *, 16> outputRegs;
+  if (!m_gsOutputRegs.empty())
+    copyShaderEntryPoint = addGsOutputRegsArgs(copyShaderEntryPoint, outputRegs);
+  auto vertexId = getFunctionArgument(copyShaderEntryPoint, vertexIdArgIdx);
   const unsigned rasterStream =
       m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->inOutUsage.gs.rasterStream;
 
@@ -3338,8 +3405,8 @@ Function *NggPrimShader::mutateCopyShader(Module *module) {
 
         // Only lower the GS output import calls if they belong to the rasterization stream.
         if (streamId == rasterStream) {
-          auto vertexOffset = calcVertexItemOffset(streamId, vertexId);
-          auto output = importGsOutput(call->getType(), location, streamId, vertexOffset);
+          auto vertexOffset = outputRegs.empty() ? calcVertexItemOffset(streamId, vertexId) : nullptr;
+          auto output = importGsOutput(call->getType(), location, streamId, vertexOffset, outputRegs);
           call->replaceAllUsesWith(output);
         }
 
@@ -3359,6 +3426,25 @@ Function *NggPrimShader::mutateCopyShader(Module *module) {
   return copyShaderEntryPoint;
 }
 
+// =====================================================================================================================
+// Appends to the GS or the copy shader the arguments that point to the storage of the GS outputs kept in registers.
+// The old function is erased, so it must not have been called yet.
+//
+// @param func : GS or copy shader function
+// @param [out] outputRegs : The new arguments, one for each dword of the storage
+// @returns : The new function
+Function *NggPrimShader::addGsOutputRegsArgs(Function *func, SmallVectorImpl<Value *> &outputRegs) {
+  assert(func->use_empty());
+  SmallVector<Type *, 16> argTys(m_gsOutputRegs.size(), m_gsOutputRegs.front()->getType());
+  SmallVector<std::string, 16> argNames(m_gsOutputRegs.size(), "gsOutputReg");
+  Function *newFunc = addFunctionArgs(func, nullptr, argTys, argNames, 0, /*append=*/true);
+  func->eraseFromParent();
+
+  for (unsigned i = newFunc->arg_size() - m_gsOutputRegs.size(); i < newFunc->arg_size(); ++i)
+    outputRegs.push_back(newFunc->getArg(i));
+  return newFunc;
+}
+
 // =====================================================================================================================
 // Exports outputs of geometry shader to GS-VS ring.
 //
@@ -3394,14 +3480,19 @@ Function *NggPrimShader::mutateCopyShader(Module *module) {
 //   +-------------+----+-------------+
 //   |<--------- GS-VS ring --------->|
 //
+// If the GS emits at most one vertex and output vertices are not compacted, the vertex emitted by a thread is exported
+// by the same thread. PatchResourceCollect then chooses to keep the GS outputs of a small vertex in registers instead
+// of the GS-VS ring, which avoids the LDS writes and reads.
+//
 // @param output : Output value
 // @param location : Location of the output
 // @param compIdx : Index used for vector element indexing
 // @param streamId : ID of output vertex stream
 // @param threadIdInSubgroup : Thread ID in sub-group
 // @param emitVerts : Counter of GS emitted vertices for this stream
+// @param outputRegs : Per-dword storage of the GS outputs kept in registers (empty if they are in the GS-VS ring)
 void NggPrimShader::exportGsOutput(Value *output, unsigned location, unsigned compIdx, unsigned streamId,
-                                   Value *threadIdInSubgroup, Value *emitVerts) {
+                                   Value *threadIdInSubgroup, Value *emitVerts, ArrayRef<Value *> outputRegs) {
   auto resUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry);
   if (resUsage->inOutUsage.gs.rasterStream != streamId) {
     // NOTE: Only export those outputs that belong to the rasterization stream.
@@ -3447,6 +3538,26 @@ void NggPrimShader::exportGsOutput(Value *output, unsigned location, unsigned co
   } else
     assert(bitWidth == 32 || bitWidth == 64);
 
+  const unsigned attribOffset = (location * 4) + compIdx;
+  if (!outputRegs.empty()) {
+    // Store the output dwords to the registers, at the dword offset of the output in the vertex item. Only the
+    // outputs of the first emitted vertex are kept, as there are no others to export.
+    const unsigned dwordCount = output->getType()->getPrimitiveSizeInBits() / 32;
+    assert(attribOffset + dwordCount <= outputRegs.size());
+    Type *dwordsTy = m_builder->getInt32Ty();
+    if (dwordCount > 1)
+      dwordsTy = FixedVectorType::get(dwordsTy, dwordCount);
+    Value *outputDwords = m_builder->CreateBitCast(output, dwordsTy);
+    Value *firstVertex = m_builder->CreateICmpEQ(emitVerts, m_builder->getInt32(0));
+    for (unsigned i = 0; i < dwordCount; ++i) {
+      Value *outputDword = dwordCount == 1 ? outputDwords : m_builder->CreateExtractElement(outputDwords, i);
+      Value *oldOutputDword = m_builder->CreateLoad(m_builder->getInt32Ty(), outputRegs[attribOffset + i]);
+      m_builder->CreateStore(m_builder->CreateSelect(firstVertex, outputDword, oldOutputDword),
+                             outputRegs[attribOffset + i]);
+    }
+    return;
+  }
+
   // vertexId = threadIdInSubgroup * outputVertices + emitVerts
   const auto &geometryMode = m_pipelineState->getShaderModes()->getGeometryShaderMode();
   auto vertexId = m_builder->CreateMul(threadIdInSubgroup, m_builder->getInt32(geometryMode.outputVertices));
@@ -3454,7 +3565,6 @@ void NggPrimShader::exportGsOutput(Value *output, unsigned location, unsigned co
 
   // ldsOffset = vertexOffset + (location * 4 + compIdx) * 4 (in bytes)
   auto vertexOffset = calcVertexItemOffset(streamId, vertexId);
-  const unsigned attribOffset = (location * 4) + compIdx;
   auto ldsOffset = m_builder->CreateAdd(vertexOffset, m_builder->getInt32(attribOffset * 4));
 
   m_ldsManager->writeValueToLds(output, ldsOffset);
@@ -3466,8 +3576,10 @@ void NggPrimShader::exportGsOutput(Value *output, unsigned location, unsigned co
 // @param outputTy : Type of the output
 // @param location : Location of the output
 // @param streamId : ID of output vertex stream
-// @param vertexOffset : Start offset of vertex item in GS-VS ring (in bytes)
-Value *NggPrimShader::importGsOutput(Type *outputTy, unsigned location, unsigned streamId, Value *vertexOffset) {
+// @param vertexOffset : Start offset of vertex item in GS-VS ring (in bytes), unused if outputRegs is not empty
+// @param outputRegs : Per-dword storage of the GS outputs kept in registers (empty if they are in the GS-VS ring)
+Value *NggPrimShader::importGsOutput(Type *outputTy, unsigned location, unsigned streamId, Value *vertexOffset,
+                                     ArrayRef<Value *> outputRegs) {
   auto resUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry);
   if (resUsage->inOutUsage.gs.rasterStream != streamId) {
     // NOTE: Only import those outputs that belong to the rasterization stream.
@@ -3486,11 +3598,25 @@ Value *NggPrimShader::importGsOutput(Type *outputTy, unsigned location, unsigned
     outputTy = FixedVectorType::get(outputElemTy, elemCount);
   }
 
-  // ldsOffset = vertexOffset + location * 4 * 4 (in bytes)
   const unsigned attribOffset = location * 4;
-  auto ldsOffset = m_builder->CreateAdd(vertexOffset, m_builder->getInt32(attribOffset * 4));
-
-  auto output = m_ldsManager->readValueFromLds(outputTy, ldsOffset);
+  Value *output = nullptr;
+  if (!outputRegs.empty()) {
+    // Load the output dwords from the registers, at the dword offset of the output in the vertex item
+    const unsigned dwordCount = outputTy->getPrimitiveSizeInBits() / 32;
+    assert(attribOffset + dwordCount <= outputRegs.size());
+    Value *outputDwords = UndefValue::get(FixedVectorType::get(m_builder->getInt32Ty(), dwordCount));
+    for (unsigned i = 0; i < dwordCount; ++i) {
+      Value *outputDword = m_builder->CreateLoad(m_builder->getInt32Ty(), outputRegs[attribOffset + i]);
+      outputDwords = m_builder->CreateInsertElement(outputDwords, outputDword, i);
+    }
+    if (dwordCount == 1)
+      outputDwords = m_builder->CreateExtractElement(outputDwords, static_cast<uint64_t>(0));
+    output = m_builder->CreateBitCast(outputDwords, outputTy);
+  } else {
+    // ldsOffset = vertexOffset + location * 4 * 4 (in bytes)
+    auto ldsOffset = m_builder->CreateAdd(vertexOffset, m_builder->getInt32(attribOffset * 4));
+    output = m_ldsManager->readValueFromLds(outputTy, ldsOffset);
+  }
 
   if (origOutputTy != outputTy) {
     assert(origOutputTy->isArrayTy() && outputTy->isVectorTy() &&
@@ -3983,6 +4109,28 @@ Value *NggPrimShader::doCullDistanceCulling(Module *module, Value *cullFlag, Val
   return m_builder->CreateCall(cullDistanceCuller, {cullFlag, signMask0, signMask1, signMask2});
 }
 
+// =====================================================================================================================
+// Checks whether the hardware vertex shader exports the misc vector (point size, layer, viewport index, shading rate)
+// to POS_1, before the clip/cull distances.
+//
+// NOTE: With multi-view, the layer is always exported, with the value of the view index from user data, whether or not
+// the shader writes gl_Layer.
+bool NggPrimShader::hasMiscExport() const {
+  const bool enableMultiView = m_pipelineState->getInputAssemblyState().enableMultiView;
+  if (m_hasGs) {
+    const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageGeometry)->builtInUsage.gs;
+    return builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex ||
+           builtInUsage.primitiveShadingRate || enableMultiView;
+  }
+  if (m_hasTcs || m_hasTes) {
+    const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageTessEval)->builtInUsage.tes;
+    return builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex || enableMultiView;
+  }
+  const auto &builtInUsage = m_pipelineState->getShaderResourceUsage(ShaderStageVertex)->builtInUsage.vs;
+  return builtInUsage.pointSize || builtInUsage.layer || builtInUsage.viewportIndex ||
+         builtInUsage.primitiveShadingRate || enableMultiView;
+}
+
 // =====================================================================================================================
 // Fetches culling-control register from primitive shader table.
 //
@@ -171,6 +171,8 @@ private:
   void initWaveThreadInfo(llvm::Value *mergedGroupInfo, llvm::Value *mergedWaveInfo);
 
   llvm::Value *doCulling(llvm::Module *module, llvm::Value *vertexId0, llvm::Value *vertexId1, llvm::Value *vertexId2);
+  llvm::Value *cullPrimitive(llvm::Module *module, llvm::ArrayRef<llvm::Value *> vertices,
+                             llvm::ArrayRef<llvm::Value *> signMasks);
   void doParamCacheAllocRequest();
   void doPrimitiveExportWithoutGs(llvm::Value *cullFlag = nullptr);
   void doPrimitiveExportWithGs(llvm::Value *vertexId);
@@ -190,10 +192,14 @@ private:
 
   llvm::Function *mutateCopyShader(llvm::Module *module);
 
+  llvm::Function *addGsOutputRegsArgs(llvm::Function *func, llvm::SmallVectorImpl<llvm::Value *> &outputRegs);
+
   void exportGsOutput(llvm::Value *output, unsigned location, unsigned compIdx, unsigned streamId,
-                      llvm::Value *threadIdInSubgroup, llvm::Value *emitVerts);
+                      llvm::Value *threadIdInSubgroup, llvm::Value *emitVerts,
+                      llvm::ArrayRef<llvm::Value *> outputRegs);
 
-  llvm::Value *importGsOutput(llvm::Type *outputTy, unsigned location, unsigned streamId, llvm::Value *vertexOffset);
+  llvm::Value *importGsOutput(llvm::Type *outputTy, unsigned location, unsigned streamId, llvm::Value *vertexOffset,
+                              llvm::ArrayRef<llvm::Value *> outputRegs = {});
 
   void processGsEmit(llvm::Module *module, unsigned streamId, llvm::Value *threadIdInSubgroup,
                      llvm::Value *emitVertsPtr, llvm::Value *outVertsPtr);
@@ -230,6 +236,7 @@ private:
                                      llvm::Value *signMask1, llvm::Value *signMask2);
 
   llvm::Value *fetchCullingControlRegister(llvm::Module *module, unsigned regOffset);
+  bool hasMiscExport() const;
 
   llvm::Function *createBackfaceCuller(llvm::Module *module);
   llvm::Function *createFrustumCuller(llvm::Module *module);
@@ -308,6 +315,10 @@ private:
   // Base offsets (in dwords) of GS output vertex streams in GS-VS ring
   unsigned m_gsStreamBases[MaxGsStreams];
 
+  // Per-dword storage of the GS outputs of the vertex emitted by this thread, if they are kept in registers rather
+  // than the GS-VS ring
+  llvm::SmallVector<llvm::Value *, 16> m_gsOutputRegs;
+
   PrimShaderCbLayoutLookupTable m_cbLayoutTable; // Layout lookup table of primitive shader constant buffer
   VertexCullInfoOffsets m_vertCullInfoOffsets;   // A collection of offsets within an item of vertex cull info
 
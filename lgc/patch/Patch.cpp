@@ -29,14 +29,23 @@
  ***********************************************************************************************************************
  */
 #include "lgc/patch/Patch.h"
+#include "PatchBufferOp.h"
+#include "PatchLlvmIrInclusion.h"
 #include "PatchNullFragShader.h"
+#include "PatchSetupTargetFeatures.h"
 #include "lgc/LgcContext.h"
 #include "lgc/PassManager.h"
 #include "lgc/builder/BuilderReplayer.h"
 #include "lgc/patch/FragColorExport.h"
+#include "lgc/patch/PatchAtomicAggregate.h"
+#include "lgc/patch/PatchBufferLoadCombine.h"
 #include "lgc/patch/PatchCheckShaderCache.h"
 #include "lgc/patch/PatchCopyShader.h"
 #include "lgc/patch/PatchEntryPointMutate.h"
+#include "lgc/patch/PatchHoistDescLoads.h"
+#include "lgc/patch/PatchHoistGetPc.h"
+#include "lgc/patch/PatchHoistUniformOps.h"
+#include "lgc/patch/PatchImageOpCombine.h"
 #include "lgc/patch/PatchInOutImportExport.h"
 #include "lgc/patch/PatchInitializeWorkgroupMemory.h"
 #include "lgc/patch/PatchLoadScalarizer.h"
@@ -44,7 +53,9 @@
 #include "lgc/patch/PatchPeepholeOpt.h"
 #include "lgc/patch/PatchPreparePipelineAbi.h"
 #include "lgc/patch/PatchReadFirstLane.h"
+#include "lgc/patch/PatchRelaxedPrecision.h"
 #include "lgc/patch/PatchResourceCollect.h"
+#include "lgc/patch/PatchShaderProfile.h"
 #include "lgc/patch/PatchWaveSizeAdjust.h"
 #include "lgc/patch/PatchWorkarounds.h"
 #include "lgc/patch/VertexFetch.h"
@@ -54,6 +65,8 @@
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/PassInfo.h"
+#include "llvm/PassRegistry.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/AggressiveInstCombine/AggressiveInstCombine.h"
 #include "llvm/Transforms/IPO.h"
@@ -86,6 +99,9 @@
 #include "llvm/Transforms/Scalar/SimplifyCFG.h"
 #include "llvm/Transforms/Scalar/SpeculativeExecution.h"
 #include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Utils/Mem2Reg.h"
+#include "llvm/Transforms/Vectorize.h"
+#include "llvm/Transforms/Vectorize/SLPVectorizer.h"
 
 #define DEBUG_TYPE "lgc-patch"
 
@@ -106,6 +122,17 @@ opt<CodeGenOpt::Level> OptLevel("opt", desc("Set the optimization level:"), init
 
 } // namespace llvm
 
+// -pack-relaxed-precision: do relaxed precision 32-bit float math in packed 16-bit floats
+static cl::opt<bool> PackRelaxedPrecision("pack-relaxed-precision",
+                                          cl::desc("Do relaxed precision 32-bit float math in packed 16-bit floats"),
+                                          cl::init(false));
+
+// -lgc-pass-pipeline: run the given passes in place of the standard optimization passes
+static cl::list<std::string> LgcPassPipeline("lgc-pass-pipeline",
+                                             cl::desc("Comma-separated list of legacy pass names to run in place "
+                                                      "of the standard LGC optimization passes"),
+                                             cl::value_desc("passes"), cl::CommaSeparated);
+
 namespace lgc {
 
 // =====================================================================================================================
@@ -141,8 +168,9 @@ void Patch::addPasses(PipelineState *pipelineState, lgc::PassManager &passMgr, b
   // Patch wave size adjusting heuristic
   passMgr.addPass(PatchWaveSizeAdjust());
 
-  // Patch workarounds
-  passMgr.addPass(PatchWorkarounds());
+  // Patch workarounds, if any applies to the target
+  if (PatchWorkarounds::isNeeded(pipelineState))
+    passMgr.addPass(PatchWorkarounds());
 
   // Generate copy shader if necessary.
   passMgr.addPass(PatchCopyShader());
@@ -156,6 +184,10 @@ void Patch::addPasses(PipelineState *pipelineState, lgc::PassManager &passMgr, b
   // Run IPSCCP before EntryPointMutate to avoid adding unnecessary arguments to an entry point.
   passMgr.addPass(IPSCCPPass());
 
+  // Instrument shaders with performance counters if -shader-profile (must be before PatchEntryPointMutate, which
+  // lowers the shader profile buffer descriptor loads)
+  passMgr.addPass(PatchShaderProfile());
+
   // Patch entry-point mutation (should be done before external library link)
   passMgr.addPass(PatchEntryPointMutate());
 
@@ -185,7 +217,7 @@ void Patch::addPasses(PipelineState *pipelineState, lgc::PassManager &passMgr, b
   passMgr.addPass(PatchPreparePipelineAbi(/* onlySetCallingConvs = */ true));
 
   // Add some optimization passes
-  addOptimizationPasses(passMgr);
+  addOptimizationPasses(passMgr, pipelineState->getOptions().fastCompile);
 
   // Stop timer for optimization passes and restart timer for patching passes.
   if (patchTimer) {
@@ -193,8 +225,67 @@ void Patch::addPasses(PipelineState *pipelineState, lgc::PassManager &passMgr, b
     LgcContext::createAndAddStartStopTimer(passMgr, patchTimer, true);
   }
 
-  // NOTE: The new pass manager is not fully implemented yet. We should add all
-  // the other patching passes here.
+  // Patch buffer operations (must be after optimizations)
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchBufferOp()));
+
+  // Aggregate the buffer and image atomics of the lanes of a wave (must be after PatchBufferOp, which makes the
+  // per-lane buffer atomics)
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchAtomicAggregate()));
+  passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass(2)));
+
+  // Combine the buffer loads of adjacent dwords (must be after InstCombine has folded the buffer offsets)
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchBufferLoadCombine()));
+
+  // Fully prepare the pipeline ABI (must be after optimizations)
+  passMgr.addPass(PatchPreparePipelineAbi(/* onlySetCallingConvs = */ false));
+
+  const bool canUseNgg = pipelineState->isGraphics() && pipelineState->getTargetInfo().getGfxIpVersion().major == 10 &&
+                         (pipelineState->getOptions().nggFlags & NggFlagDisable) == 0;
+  if (canUseNgg) {
+    // Stop timer for patching passes and restart timer for optimization passes.
+    if (patchTimer) {
+      LgcContext::createAndAddStartStopTimer(passMgr, patchTimer, false);
+      LgcContext::createAndAddStartStopTimer(passMgr, optTimer, true);
+    }
+
+    // Extra optimizations after NGG primitive shader creation
+    passMgr.addPass(AlwaysInlinerPass());
+    passMgr.addPass(GlobalDCEPass());
+    passMgr.addPass(createModuleToFunctionPassAdaptor(PromotePass()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(ADCEPass()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
+
+    // Stop timer for optimization passes and restart timer for patching passes.
+    if (patchTimer) {
+      LgcContext::createAndAddStartStopTimer(passMgr, optTimer, false);
+      LgcContext::createAndAddStartStopTimer(passMgr, patchTimer, true);
+    }
+  }
+
+  // Share one PC read in each function, now that the merged shaders have been inlined (must be after the inlining)
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchHoistGetPc()));
+
+  // Set up target features in shader entry-points.
+  // NOTE: Needs to be done after post-NGG function inlining, because LLVM refuses to inline something
+  // with conflicting attributes. Attributes could conflict on GFX10 because PatchSetupTargetFeatures
+  // adds a target feature to determine wave32 or wave64.
+  passMgr.addPass(PatchSetupTargetFeatures());
+
+  // Include LLVM IR as a separate section in the ELF binary
+  if (pipelineState->getOptions().includeIr)
+    passMgr.addPass(PatchLlvmIrInclusion());
+
+  // Stop timer for patching passes.
+  if (patchTimer)
+    LgcContext::createAndAddStartStopTimer(passMgr, patchTimer, false);
+
+  // Dump the result
+  if (raw_ostream *outs = getLgcOuts()) {
+    passMgr.addPass(PrintModulePass(*outs,
+                                    "===============================================================================\n"
+                                    "// LLPC pipeline patching results\n"));
+  }
 }
 
 // =====================================================================================================================
@@ -232,8 +323,9 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
   // Patch wave size adjusting heuristic
   passMgr.add(createLegacyPatchWaveSizeAdjust());
 
-  // Patch workarounds
-  passMgr.add(createLegacyPatchWorkarounds());
+  // Patch workarounds, if any applies to the target
+  if (PatchWorkarounds::isNeeded(pipelineState))
+    passMgr.add(createLegacyPatchWorkarounds());
 
   // Generate copy shader if necessary.
   passMgr.add(createLegacyPatchCopyShader());
@@ -247,6 +339,10 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
   // Run IPSCCP before EntryPointMutate to avoid adding unnecessary arguments to an entry point.
   passMgr.add(createIPSCCPPass());
 
+  // Instrument shaders with performance counters if -shader-profile (must be before PatchEntryPointMutate, which
+  // lowers the shader profile buffer descriptor loads)
+  passMgr.add(createLegacyPatchShaderProfile());
+
   // Patch entry-point mutation (should be done before external library link)
   passMgr.add(createLegacyPatchEntryPointMutate());
 
@@ -278,7 +374,7 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
   passMgr.add(createLegacyPatchPreparePipelineAbi(/* onlySetCallingConvs = */ true));
 
   // Add some optimization passes
-  addOptimizationPasses(passMgr);
+  addOptimizationPasses(passMgr, pipelineState->getOptions().fastCompile);
 
   // Stop timer for optimization passes and restart timer for patching passes.
   if (patchTimer) {
@@ -287,9 +383,16 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
   }
 
   // Patch buffer operations (must be after optimizations)
-  passMgr.add(createPatchBufferOp());
+  passMgr.add(createLegacyPatchBufferOp());
+
+  // Aggregate the buffer and image atomics of the lanes of a wave (must be after PatchBufferOp, which makes the
+  // per-lane buffer atomics)
+  passMgr.add(createLegacyPatchAtomicAggregate());
   passMgr.add(createInstructionCombiningPass(2));
 
+  // Combine the buffer loads of adjacent dwords (must be after InstCombine has folded the buffer offsets)
+  passMgr.add(createLegacyPatchBufferLoadCombine());
+
   // Fully prepare the pipeline ABI (must be after optimizations)
   passMgr.add(createLegacyPatchPreparePipelineAbi(/* onlySetCallingConvs = */ false));
 
@@ -317,15 +420,18 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
     }
   }
 
+  // Share one PC read in each function, now that the merged shaders have been inlined (must be after the inlining)
+  passMgr.add(createLegacyPatchHoistGetPc());
+
   // Set up target features in shader entry-points.
   // NOTE: Needs to be done after post-NGG function inlining, because LLVM refuses to inline something
   // with conflicting attributes. Attributes could conflict on GFX10 because PatchSetupTargetFeatures
   // adds a target feature to determine wave32 or wave64.
-  passMgr.add(createPatchSetupTargetFeatures());
+  passMgr.add(createLegacyPatchSetupTargetFeatures());
 
   // Include LLVM IR as a separate section in the ELF binary
   if (pipelineState->getOptions().includeIr)
-    passMgr.add(createPatchLlvmIrInclusion());
+    passMgr.add(createLegacyPatchLlvmIrInclusion());
 
   // Stop timer for patching passes.
   if (patchTimer)
@@ -343,10 +449,23 @@ void LegacyPatch::addPasses(PipelineState *pipelineState, legacy::PassManager &p
 // Add optimization passes to pass manager
 //
 // @param [in/out] passMgr : Pass manager to add passes to
-void Patch::addOptimizationPasses(lgc::PassManager &passMgr) {
-  LLPC_OUTS("PassManager optimization level = " << cl::OptLevel << "\n");
+// @param fastCompile : Whether to add just the few passes of the fast compile tier
+void Patch::addOptimizationPasses(lgc::PassManager &passMgr, bool fastCompile) {
+  LLPC_OUTS("PassManager optimization level = " << cl::OptLevel << (fastCompile ? " (fast compile tier)" : "")
+                                                << "\n");
+  if (!LgcPassPipeline.empty())
+    report_fatal_error("-lgc-pass-pipeline cannot be used with the new pass manager yet.");
 
   passMgr.addPass(ForceFunctionAttrsPass());
+  if (fastCompile) {
+    // The fast compile tier only promotes allocas and removes redundant and dead code, leaving out the loop passes,
+    // GVN and the repeated combining that make up most of the optimization time.
+    passMgr.addPass(createModuleToFunctionPassAdaptor(SROAPass()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(EarlyCSEPass()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass(1)));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
+    return;
+  }
   passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass(1)));
   passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(SROAPass()));
@@ -356,6 +475,7 @@ void Patch::addOptimizationPasses(lgc::PassManager &passMgr) {
   passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(AggressiveInstCombinePass()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass(1)));
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchImageOpCombine()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(PatchPeepholeOpt()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(ReassociatePass()));
@@ -385,8 +505,17 @@ void Patch::addOptimizationPasses(lgc::PassManager &passMgr) {
                                                                         .sinkCommonInsts(true))));
   passMgr.addPass(createModuleToFunctionPassAdaptor(LoopUnrollPass(
       LoopUnrollOptions(cl::OptLevel).setPartial(true).setRuntime(true).setPeeling(true).setUpperBound(true))));
+  if (PackRelaxedPrecision) {
+    // Demote relaxed precision math to 16-bit floats, and pair the 16-bit operations into packed math
+    passMgr.addPass(createModuleToFunctionPassAdaptor(PatchRelaxedPrecision()));
+    passMgr.addPass(createModuleToFunctionPassAdaptor(SLPVectorizerPass()));
+  }
   // uses DivergenceAnalysis
   passMgr.addPass(createModuleToFunctionPassAdaptor(PatchReadFirstLane()));
+  // uses DivergenceAnalysis
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchHoistDescLoads()));
+  // uses DivergenceAnalysis
+  passMgr.addPass(createModuleToFunctionPassAdaptor(PatchHoistUniformOps()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(InstCombinePass(1)));
   passMgr.addPass(ConstantMergePass());
   passMgr.addPass(createModuleToFunctionPassAdaptor(DivRemPairsPass()));
@@ -397,10 +526,34 @@ void Patch::addOptimizationPasses(lgc::PassManager &passMgr) {
 // Add optimization passes to pass manager
 //
 // @param [in/out] passMgr : Pass manager to add passes to
-void LegacyPatch::addOptimizationPasses(legacy::PassManager &passMgr) {
-  LLPC_OUTS("PassManager optimization level = " << cl::OptLevel << "\n");
+// @param fastCompile : Whether to add just the few passes of the fast compile tier
+void LegacyPatch::addOptimizationPasses(legacy::PassManager &passMgr, bool fastCompile) {
+  LLPC_OUTS("PassManager optimization level = " << cl::OptLevel << (fastCompile ? " (fast compile tier)" : "")
+                                                << "\n");
+
+  if (!LgcPassPipeline.empty()) {
+    // -lgc-pass-pipeline replaces the whole list, so that another one can be timed (with -time-passes) and its
+    // output compared without rebuilding.
+    const PassRegistry &passRegistry = *PassRegistry::getPassRegistry();
+    for (const std::string &passName : LgcPassPipeline) {
+      const PassInfo *passInfo = passRegistry.getPassInfo(passName);
+      if (!passInfo || !passInfo->getNormalCtor())
+        report_fatal_error(Twine("-lgc-pass-pipeline: \"") + passName + "\" is not a pass that can be created.");
+      passMgr.add(passInfo->createPass());
+    }
+    return;
+  }
 
   passMgr.add(createForceFunctionAttrsLegacyPass());
+  if (fastCompile) {
+    // The fast compile tier only promotes allocas and removes redundant and dead code, leaving out the loop passes,
+    // GVN and the repeated combining that make up most of the optimization time.
+    passMgr.add(createSROAPass());
+    passMgr.add(createEarlyCSEPass(true));
+    passMgr.add(createInstructionCombiningPass(1));
+    passMgr.add(createCFGSimplificationPass());
+    return;
+  }
   passMgr.add(createInstructionCombiningPass(1));
   passMgr.add(createCFGSimplificationPass());
   passMgr.add(createSROAPass());
@@ -410,6 +563,7 @@ void LegacyPatch::addOptimizationPasses(legacy::PassManager &passMgr) {
   passMgr.add(createCFGSimplificationPass());
   passMgr.add(createAggressiveInstCombinerPass());
   passMgr.add(createInstructionCombiningPass(1));
+  passMgr.add(createLegacyPatchImageOpCombine());
   passMgr.add(createLegacyPatchPeepholeOpt());
   passMgr.add(createCFGSimplificationPass());
   passMgr.add(createReassociatePass());
@@ -437,8 +591,17 @@ void LegacyPatch::addOptimizationPasses(legacy::PassManager &passMgr) {
                                               .needCanonicalLoops(true)
                                               .sinkCommonInsts(true)));
   passMgr.add(createLoopUnrollPass(cl::OptLevel));
+  if (PackRelaxedPrecision) {
+    // Demote relaxed precision math to 16-bit floats, and pair the 16-bit operations into packed math
+    passMgr.add(createLegacyPatchRelaxedPrecision());
+    passMgr.add(createSLPVectorizerPass());
+  }
   // uses DivergenceAnalysis
   passMgr.add(createLegacyPatchReadFirstLane());
+  // uses DivergenceAnalysis
+  passMgr.add(createLegacyPatchHoistDescLoads());
+  // uses DivergenceAnalysis
+  passMgr.add(createLegacyPatchHoistUniformOps());
   passMgr.add(createInstructionCombiningPass(1));
   passMgr.add(createConstantMergePass());
   passMgr.add(createDivRemPairsPass());
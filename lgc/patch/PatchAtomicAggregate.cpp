@@ -0,0 +1,295 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2017-2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchAtomicAggregate.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchAtomicAggregate.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchAtomicAggregate.h"
+#include "lgc/Builder.h"
+#include "lgc/LgcContext.h"
+#include "lgc/patch/Patch.h"
+#include "lgc/state/PipelineState.h"
+#include "lgc/state/ShaderStage.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include <memory>
+
+#define DEBUG_TYPE "lgc-patch-atomic-aggregate"
+
+using namespace lgc;
+using namespace llvm;
+
+// -aggregate-atomics: maximum number of distinct addresses per wave that the lanes of an atomic are aggregated for
+static cl::opt<unsigned> AggregateAtomics(
+    "aggregate-atomics",
+    cl::desc("Maximum number of distinct addresses per wave that the lanes of a compute shader buffer or image atomic "
+             "with an unused result are combined into one atomic for (0 to disable)"),
+    cl::init(4));
+
+namespace {
+class LegacyPatchAtomicAggregate final : public FunctionPass {
+public:
+  LegacyPatchAtomicAggregate();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchAtomicAggregate(const LegacyPatchAtomicAggregate &) = delete;
+  LegacyPatchAtomicAggregate &operator=(const LegacyPatchAtomicAggregate &) = delete;
+
+  PatchAtomicAggregate m_impl;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchAtomicAggregate::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for buffer atomic aggregation.
+FunctionPass *lgc::createLegacyPatchAtomicAggregate() {
+  return new LegacyPatchAtomicAggregate();
+}
+
+// =====================================================================================================================
+LegacyPatchAtomicAggregate::LegacyPatchAtomicAggregate() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Get the analysis usage of this pass.
+//
+// @param [out] analysisUsage : The analysis usage.
+void LegacyPatchAtomicAggregate::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will aggregate buffer atomics in
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchAtomicAggregate::runOnFunction(Function &function) {
+  PipelineState *pipelineState = getAnalysis<LegacyPipelineStateWrapper>().getPipelineState(function.getParent());
+  return m_impl.runImpl(function, pipelineState);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will aggregate buffer atomics in
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchAtomicAggregate::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  const auto &moduleAnalysisManager = analysisManager.getResult<ModuleAnalysisManagerFunctionProxy>(function);
+  PipelineState *pipelineState =
+      moduleAnalysisManager.getCachedResult<PipelineStateWrapper>(*function.getParent())->getPipelineState();
+  if (!runImpl(function, pipelineState))
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
+
+// =====================================================================================================================
+// Get the group arithmetic operation that combines the values of the lanes of a buffer or image atomic, and the
+// operands that give the address it accesses.
+//
+// @param atomic : The call that might be a buffer or image atomic
+// @param [out] addressOperandIdxs : The indices of the address operands
+// @returns : The group arithmetic operation, or -1 if the call is not an atomic that this pass aggregates
+static int getAggregateOp(CallInst *atomic, SmallVectorImpl<unsigned> &addressOperandIdxs) {
+  const Intrinsic::ID intrinsicId = atomic->getIntrinsicID();
+  if (intrinsicId == Intrinsic::not_intrinsic)
+    return -1;
+
+  // The intrinsics are named llvm.amdgcn.<kind>.atomic.<op>, with a dimension suffix for image atomics.
+  StringRef name = Intrinsic::getBaseName(intrinsicId);
+  if (name.consume_front("llvm.amdgcn.raw.buffer.atomic.")) {
+    // (value, rsrc, offset, soffset, cachepolicy)
+    addressOperandIdxs.push_back(2);
+  } else if (name.consume_front("llvm.amdgcn.struct.buffer.atomic.")) {
+    // (value, rsrc, vindex, offset, soffset, cachepolicy)
+    addressOperandIdxs.push_back(2);
+    addressOperandIdxs.push_back(3);
+  }
+  if (!addressOperandIdxs.empty()) {
+    // The AMDGPU atomic optimizer already handles buffer atomics at a constant address.
+    if (all_of(addressOperandIdxs,
+               [atomic](unsigned operandIdx) { return isa<Constant>(atomic->getArgOperand(operandIdx)); }))
+      return -1;
+  } else if (name.consume_front("llvm.amdgcn.image.atomic.")) {
+    // (value, coordinates..., rsrc, texfailctrl, cachepolicy)
+    for (unsigned operandIdx = 1; operandIdx + 3 < atomic->arg_size(); ++operandIdx)
+      addressOperandIdxs.push_back(operandIdx);
+  } else {
+    return -1;
+  }
+
+  // Subtracting each value is the same as subtracting their sum.
+  return StringSwitch<int>(name.split('.').first)
+      .Cases("add", "sub", Builder::IAdd)
+      .Case("and", Builder::And)
+      .Case("or", Builder::Or)
+      .Case("xor", Builder::Xor)
+      .Case("smin", Builder::SMin)
+      .Case("umin", Builder::UMin)
+      .Case("smax", Builder::SMax)
+      .Case("umax", Builder::UMax)
+      .Default(-1);
+}
+
+// =====================================================================================================================
+// Executes this LLVM patching pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will aggregate atomics in
+// @param pipelineState : Pipeline state
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchAtomicAggregate::runImpl(Function &function, PipelineState *pipelineState) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Atomic-Aggregate\n");
+
+  // In other stages, the lanes of a wave can include helper invocations, which must not do atomics.
+  if (AggregateAtomics == 0 || getShaderStage(&function) != ShaderStageCompute)
+    return false;
+
+  // The buffer and image atomic intrinsics need a uniform descriptor, so only their address can differ between lanes.
+  struct AggregatedAtomic {
+    CallInst *atomic;                            // The atomic
+    int groupArithOp;                            // The group arithmetic operation that combines the lane values
+    SmallVector<unsigned, 4> addressOperandIdxs; // The indices of the address operands
+  };
+  SmallVector<AggregatedAtomic, 4> atomics;
+  for (BasicBlock &block : function) {
+    for (Instruction &inst : block) {
+      auto call = dyn_cast<CallInst>(&inst);
+      if (!call || !call->use_empty() || !call->getType()->isIntegerTy(32))
+        continue;
+      SmallVector<unsigned, 4> addressOperandIdxs;
+      int groupArithOp = getAggregateOp(call, addressOperandIdxs);
+      if (groupArithOp >= 0)
+        atomics.push_back({call, groupArithOp, addressOperandIdxs});
+    }
+  }
+  if (atomics.empty())
+    return false;
+
+  std::unique_ptr<Builder> builder(pipelineState->getLgcContext()->createBuilder(pipelineState,
+                                                                               /*useBuilderRecorder=*/false));
+  for (AggregatedAtomic &atomic : atomics)
+    aggregateAtomic(atomic.atomic, atomic.groupArithOp, atomic.addressOperandIdxs, AggregateAtomics, *builder);
+  return true;
+}
+
+// =====================================================================================================================
+// Put a buffer or image atomic in a loop over the distinct addresses of the lanes that do it. In each iteration, the
+// lanes with the address of the first remaining lane combine their values and leave the loop, and the first of them
+// does the atomic for all of them. The lanes that remain after the last iteration do their own atomics.
+//
+//   header:
+//     %iteration = phi i32 [ 0, %entry ], [ %iteration.next, %latch ]
+//     %first = readfirstlane(%address)
+//     br (%address == %first), %aggregate, %latch
+//   aggregate:
+//     %combined = reduction(%value)
+//     br (elect), %issue, %done
+//   issue:
+//     atomic(%combined, %first, ...)
+//     br %done
+//   latch:
+//     %iteration.next = add i32 %iteration, 1
+//     br (%iteration.next < maxIterations), %header, %fallback
+//   fallback:
+//     atomic(%value, %address, ...)
+//     br %done
+//
+// @param atomic : The atomic, whose result is unused
+// @param groupArithOp : The group arithmetic operation that combines the values of the lanes
+// @param addressOperandIdxs : The indices of the operands that give the address of the atomic
+// @param maxIterations : Maximum number of addresses whose lanes are aggregated
+// @param builder : Builder to use
+void PatchAtomicAggregate::aggregateAtomic(CallInst *atomic, unsigned groupArithOp,
+                                           ArrayRef<unsigned> addressOperandIdxs, unsigned maxIterations,
+                                           Builder &builder) {
+  LLVM_DEBUG(dbgs() << "aggregate: " << *atomic << "\n");
+  Value *value = atomic->getArgOperand(0);
+
+  BasicBlock *entryBlock = atomic->getParent();
+  BasicBlock *doneBlock = entryBlock->splitBasicBlock(atomic->getNextNode(), ".atomic.done");
+  Function *function = entryBlock->getParent();
+  LLVMContext &context = function->getContext();
+  BasicBlock *headerBlock = BasicBlock::Create(context, ".atomic.header", function, doneBlock);
+  BasicBlock *aggregateBlock = BasicBlock::Create(context, ".atomic.aggregate", function, doneBlock);
+  BasicBlock *issueBlock = BasicBlock::Create(context, ".atomic.issue", function, doneBlock);
+  BasicBlock *latchBlock = BasicBlock::Create(context, ".atomic.latch", function, doneBlock);
+  BasicBlock *fallbackBlock = BasicBlock::Create(context, ".atomic.fallback", function, doneBlock);
+  entryBlock->getTerminator()->setSuccessor(0, headerBlock);
+
+  builder.SetInsertPoint(headerBlock);
+  PHINode *iteration = builder.CreatePHI(builder.getInt32Ty(), 2);
+  iteration->addIncoming(builder.getInt32(0), entryBlock);
+  SmallVector<Value *, 4> firstAddress;
+  Value *isSameAddress = builder.getTrue();
+  for (unsigned operandIdx : addressOperandIdxs) {
+    Value *address = atomic->getArgOperand(operandIdx);
+    firstAddress.push_back(builder.CreateSubgroupBroadcastFirst(address));
+    isSameAddress = builder.CreateAnd(isSameAddress, builder.CreateICmpEQ(address, firstAddress.back()));
+  }
+  builder.CreateCondBr(isSameAddress, aggregateBlock, latchBlock);
+
+  builder.SetInsertPoint(aggregateBlock);
+  Value *waveSize = builder.CreateGetWaveSize();
+  Value *combined =
+      builder.CreateSubgroupClusteredReduction(static_cast<Builder::GroupArithOp>(groupArithOp), value, waveSize);
+  builder.CreateCondBr(builder.CreateSubgroupElect(), issueBlock, doneBlock);
+
+  builder.SetInsertPoint(issueBlock);
+  CallInst *combinedAtomic = cast<CallInst>(atomic->clone());
+  combinedAtomic->setArgOperand(0, combined);
+  for (unsigned i = 0; i != addressOperandIdxs.size(); ++i)
+    combinedAtomic->setArgOperand(addressOperandIdxs[i], firstAddress[i]);
+  builder.Insert(combinedAtomic);
+  builder.CreateBr(doneBlock);
+
+  builder.SetInsertPoint(latchBlock);
+  Value *nextIteration = builder.CreateAdd(iteration, builder.getInt32(1));
+  iteration->addIncoming(nextIteration, latchBlock);
+  builder.CreateCondBr(builder.CreateICmpULT(nextIteration, builder.getInt32(maxIterations)), headerBlock,
+                       fallbackBlock);
+
+  builder.SetInsertPoint(fallbackBlock);
+  atomic->moveBefore(builder.CreateBr(doneBlock));
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for buffer atomic aggregation.
+INITIALIZE_PASS(LegacyPatchAtomicAggregate, DEBUG_TYPE, "Patch LLVM for buffer atomic aggregation", false, false)
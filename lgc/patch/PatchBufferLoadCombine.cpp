@@ -0,0 +1,332 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2017-2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchBufferLoadCombine.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchBufferLoadCombine.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchBufferLoadCombine.h"
+#include "lgc/patch/Patch.h"
+#include "lgc/state/PipelineState.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include <tuple>
+
+#define DEBUG_TYPE "lgc-patch-buffer-load-combine"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchBufferLoadCombine final : public FunctionPass {
+public:
+  LegacyPatchBufferLoadCombine();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchBufferLoadCombine(const LegacyPatchBufferLoadCombine &) = delete;
+  LegacyPatchBufferLoadCombine &operator=(const LegacyPatchBufferLoadCombine &) = delete;
+
+  PatchBufferLoadCombine m_impl;
+};
+
+// A buffer load that is a candidate for combining
+struct BufferLoad {
+  CallInst *call;  // The buffer load intrinsic call
+  int64_t offset;  // Constant part of its byte offset
+  unsigned size;   // Byte size of the loaded value
+  unsigned order;  // Position of the call in its block
+};
+
+// Loads that can be combined: the buffer descriptor, the variable part of the offset (nullptr if the offset is
+// constant), the soffset operand (nullptr for a scalar buffer load) and the cache policy operand
+using BufferLoadKey = std::tuple<Value *, Value *, Value *, Value *>;
+using BufferLoadGroups = MapVector<BufferLoadKey, SmallVector<BufferLoad, 4>>;
+
+} // anonymous namespace
+
+// Maximum byte size of a combined buffer load (dwordx4)
+static const unsigned MaxCombinedLoadSize = 16;
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchBufferLoadCombine::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for buffer load combining.
+FunctionPass *lgc::createLegacyPatchBufferLoadCombine() {
+  return new LegacyPatchBufferLoadCombine();
+}
+
+// =====================================================================================================================
+LegacyPatchBufferLoadCombine::LegacyPatchBufferLoadCombine() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Get the analysis usage of this pass.
+//
+// @param [out] analysisUsage : The analysis usage.
+void LegacyPatchBufferLoadCombine::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine buffer loads in
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchBufferLoadCombine::runOnFunction(Function &function) {
+  PipelineState *pipelineState = getAnalysis<LegacyPipelineStateWrapper>().getPipelineState(function.getParent());
+  return m_impl.runImpl(function, pipelineState);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine buffer loads in
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchBufferLoadCombine::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  const auto &moduleAnalysisManager = analysisManager.getResult<ModuleAnalysisManagerFunctionProxy>(function);
+  PipelineState *pipelineState =
+      moduleAnalysisManager.getCachedResult<PipelineStateWrapper>(*function.getParent())->getPipelineState();
+  if (!runImpl(function, pipelineState))
+    return PreservedAnalyses::all();
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Split a buffer offset into a variable part and a constant part.
+//
+// @param offset : The i32 offset operand of a buffer load
+// @param dataLayout : Data layout of the module
+// @param [out] base : The variable part of the offset, or nullptr if the offset is constant
+// @returns : The constant part of the offset
+static int64_t splitBufferOffset(Value *offset, const DataLayout &dataLayout, Value *&base) {
+  int64_t constOffset = 0;
+  for (;;) {
+    if (auto constInt = dyn_cast<ConstantInt>(offset)) {
+      base = nullptr;
+      return constOffset + constInt->getSExtValue();
+    }
+    auto binaryOp = dyn_cast<BinaryOperator>(offset);
+    if (!binaryOp)
+      break;
+    auto constInt = dyn_cast<ConstantInt>(binaryOp->getOperand(1));
+    if (!constInt)
+      break;
+    // InstCombine turns the add of a constant into an or when the bits of the constant are known clear.
+    if (binaryOp->getOpcode() != Instruction::Add &&
+        (binaryOp->getOpcode() != Instruction::Or ||
+         !haveNoCommonBitsSet(binaryOp->getOperand(0), constInt, dataLayout)))
+      break;
+    constOffset += constInt->getSExtValue();
+    offset = binaryOp->getOperand(0);
+  }
+  base = offset;
+  return constOffset;
+}
+
+// =====================================================================================================================
+// Combine the loads of one group that access contiguous dwords into wider loads.
+//
+// @param [in/out] loads : Loads of the group, in block order
+// @param base : The variable part of the offset of the loads, or nullptr if their offsets are constant
+// @param isScalar : Whether these are scalar buffer loads
+// @param [in/out] builder : IR builder to use
+// @returns : True if any load was combined
+static bool combineBufferLoads(SmallVectorImpl<BufferLoad> &loads, Value *base, bool isScalar, IRBuilder<> &builder) {
+  if (loads.size() < 2)
+    return false;
+
+  llvm::sort(loads, [](const BufferLoad &lhs, const BufferLoad &rhs) {
+    return std::make_pair(lhs.offset, lhs.order) < std::make_pair(rhs.offset, rhs.order);
+  });
+
+  bool changed = false;
+  for (unsigned begin = 0, end = 0; begin != loads.size(); begin = end) {
+    // Gather the loads from the start of the run onwards that overlap or abut it and keep it within a dwordx4.
+    const int64_t start = loads[begin].offset;
+    int64_t runEnd = start + loads[begin].size;
+    for (end = begin + 1; end != loads.size(); ++end) {
+      const BufferLoad &load = loads[end];
+      if (load.offset > runEnd || (load.offset - start) % 4 != 0 ||
+          load.offset + load.size - start > MaxCombinedLoadSize)
+        break;
+      runEnd = std::max(runEnd, load.offset + load.size);
+    }
+
+    // There is no scalar dwordx3 load on all targets, so leave the last loads to the next run instead.
+    while (isScalar && runEnd - start == 12 && end - begin > 1) {
+      --end;
+      runEnd = start;
+      for (unsigned idx = begin; idx != end; ++idx)
+        runEnd = std::max(runEnd, loads[idx].offset + loads[idx].size);
+    }
+    if (end - begin < 2)
+      continue;
+
+    // Create the combined load where the first load of the run in the block is.
+    const BufferLoad *firstLoad = &loads[begin];
+    for (unsigned idx = begin + 1; idx != end; ++idx) {
+      if (loads[idx].order < firstLoad->order)
+        firstLoad = &loads[idx];
+    }
+    CallInst *firstCall = firstLoad->call;
+    builder.SetInsertPoint(firstCall);
+
+    Value *offset = builder.getInt32(start);
+    if (base)
+      offset = start == 0 ? base : builder.CreateAdd(base, offset);
+
+    const unsigned dwordCount = (runEnd - start) / 4;
+    Type *loadTy = builder.getInt32Ty();
+    if (dwordCount > 1)
+      loadTy = FixedVectorType::get(loadTy, dwordCount);
+    SmallVector<Value *, 4> args(firstCall->args());
+    args[1] = offset;
+    Value *combinedLoad = builder.CreateIntrinsic(firstCall->getIntrinsicID(), loadTy, args);
+    LLVM_DEBUG(dbgs() << "Combined " << (end - begin) << " buffer loads into " << *combinedLoad << "\n");
+
+    // Replace the loads of the run with the dwords they read from the combined load.
+    for (unsigned idx = begin; idx != end; ++idx) {
+      CallInst *call = loads[idx].call;
+      const unsigned firstDword = (loads[idx].offset - start) / 4;
+      const unsigned count = loads[idx].size / 4;
+      Value *part = combinedLoad;
+      if (count == 1 && dwordCount > 1)
+        part = builder.CreateExtractElement(combinedLoad, firstDword);
+      else if (count != dwordCount) {
+        SmallVector<int, 4> mask;
+        for (unsigned dword = 0; dword != count; ++dword)
+          mask.push_back(firstDword + dword);
+        part = builder.CreateShuffleVector(combinedLoad, mask);
+      }
+      part = builder.CreateBitCast(part, call->getType());
+      part->takeName(call);
+      call->replaceAllUsesWith(part);
+    }
+    // Erase the loads only now, as the builder inserts before one of them.
+    for (unsigned idx = begin; idx != end; ++idx)
+      loads[idx].call->eraseFromParent();
+    changed = true;
+  }
+  return changed;
+}
+
+// =====================================================================================================================
+// Combine the loads of all the groups, and clear the groups.
+//
+// @param [in/out] groups : Groups of loads that can be combined
+// @param isScalar : Whether these are scalar buffer loads
+// @param [in/out] builder : IR builder to use
+// @returns : True if any load was combined
+static bool combineBufferLoadGroups(BufferLoadGroups &groups, bool isScalar, IRBuilder<> &builder) {
+  bool changed = false;
+  for (auto &group : groups)
+    changed |= combineBufferLoads(group.second, std::get<1>(group.first), isScalar, builder);
+  groups.clear();
+  return changed;
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine buffer loads in
+// @param pipelineState : Pipeline state
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchBufferLoadCombine::runImpl(Function &function, PipelineState *pipelineState) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Buffer-Load-Combine\n");
+
+  // With tight bounds checking, each dword of a load must be checked on its own, but the hardware can return zero for
+  // all dwords of a wide load that is partially out of bounds.
+  if (pipelineState->getOptions().robustBufferAccess2)
+    return false;
+
+  const DataLayout &dataLayout = function.getParent()->getDataLayout();
+  IRBuilder<> builder(function.getContext());
+  bool changed = false;
+
+  for (BasicBlock &block : function) {
+    BufferLoadGroups rawLoads;
+    BufferLoadGroups scalarLoads;
+    unsigned order = 0;
+    for (auto instIt = block.begin(); instIt != block.end();) {
+      Instruction &inst = *instIt++;
+      ++order;
+      auto call = dyn_cast<CallInst>(&inst);
+      const Intrinsic::ID intrinsicId = call ? call->getIntrinsicID() : Intrinsic::not_intrinsic;
+      if (intrinsicId != Intrinsic::amdgcn_raw_buffer_load && intrinsicId != Intrinsic::amdgcn_s_buffer_load) {
+        // Raw buffer loads read memory, so they cannot be combined across a write that might alias them. Scalar
+        // buffer loads are only used for invariant memory.
+        if (inst.mayWriteToMemory())
+          changed |= combineBufferLoadGroups(rawLoads, /*isScalar=*/false, builder);
+        continue;
+      }
+
+      // Only loads of whole dwords that can be bitcast from a dword vector are combined.
+      Type *loadTy = call->getType();
+      const unsigned size = dataLayout.getTypeStoreSize(loadTy);
+      if (size % 4 != 0 || size >= MaxCombinedLoadSize)
+        continue;
+      Type *dwordsTy = builder.getInt32Ty();
+      if (size > 4)
+        dwordsTy = FixedVectorType::get(dwordsTy, size / 4);
+      if (!CastInst::isBitCastable(dwordsTy, loadTy))
+        continue;
+
+      Value *base = nullptr;
+      const int64_t offset = splitBufferOffset(call->getArgOperand(1), dataLayout, base);
+      if (intrinsicId == Intrinsic::amdgcn_raw_buffer_load) {
+        BufferLoadKey key(call->getArgOperand(0), base, call->getArgOperand(2), call->getArgOperand(3));
+        rawLoads[key].push_back({call, offset, size, order});
+      } else {
+        BufferLoadKey key(call->getArgOperand(0), base, nullptr, call->getArgOperand(2));
+        scalarLoads[key].push_back({call, offset, size, order});
+      }
+    }
+    changed |= combineBufferLoadGroups(rawLoads, /*isScalar=*/false, builder);
+    changed |= combineBufferLoadGroups(scalarLoads, /*isScalar=*/true, builder);
+  }
+  return changed;
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for buffer load combining.
+INITIALIZE_PASS(LegacyPatchBufferLoadCombine, DEBUG_TYPE, "Patch LLVM for buffer load combining", false, false)
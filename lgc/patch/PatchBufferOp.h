@@ -34,10 +34,8 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstVisitor.h"
-
-namespace llvm {
-class LegacyDivergenceAnalysis;
-} // namespace llvm
+#include "llvm/IR/PassManager.h"
+#include <functional>
 
 namespace lgc {
 
@@ -45,12 +43,18 @@ class PipelineState;
 
 // =====================================================================================================================
 // Represents the pass of LLVM patching operations for buffer operations
-class PatchBufferOp final : public llvm::FunctionPass, public llvm::InstVisitor<PatchBufferOp> {
+class PatchBufferOp final : public llvm::InstVisitor<PatchBufferOp>, public llvm::PassInfoMixin<PatchBufferOp> {
 public:
-  PatchBufferOp();
+  PatchBufferOp() {}
+
+  llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  // NOTE: Once the switch to the new pass manager is completed, the isDivergent argument can be removed and put back as
+  // a class attribute.
+  bool runImpl(llvm::Function &function, PipelineState *pipelineState,
+               std::function<bool(llvm::Value *)> isDivergent);
 
-  void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override;
-  bool runOnFunction(llvm::Function &function) override;
+  static llvm::StringRef name() { return "Patch LLVM for buffer operations"; }
 
   // Visitors
   void visitAtomicCmpXchgInst(llvm::AtomicCmpXchgInst &atomicCmpXchgInst);
@@ -70,12 +74,7 @@ public:
   void visitICmpInst(llvm::ICmpInst &icmpInst);
   void visitPtrToIntInst(llvm::PtrToIntInst &ptrToIntInst);
 
-  static char ID; // ID of this pass
-
 private:
-  PatchBufferOp(const PatchBufferOp &) = delete;
-  PatchBufferOp &operator=(const PatchBufferOp &) = delete;
-
   llvm::Value *getPointerOperandAsInst(llvm::Value *const value);
   llvm::Value *getBaseAddressFromBufferDesc(llvm::Value *const bufferDesc) const;
   void copyMetadata(llvm::Value *const dest, const llvm::Value *const src) const;
@@ -95,7 +94,7 @@ private:
   llvm::DenseMap<PhiIncoming, llvm::Value *> m_incompletePhis; // The incomplete phi map.
   llvm::DenseSet<llvm::Value *> m_invariantSet;                // The invariant set.
   llvm::DenseSet<llvm::Value *> m_divergenceSet;               // The divergence set.
-  llvm::LegacyDivergenceAnalysis *m_divergenceAnalysis;        // The divergence analysis.
+  std::function<bool(llvm::Value *)> m_isDivergent;            // Returns true if the given value is divergent.
   llvm::SmallVector<llvm::Instruction *, 16> m_postVisitInsts; // The post process instruction set.
   std::unique_ptr<llvm::IRBuilder<>> m_builder;                // The IRBuilder.
   llvm::LLVMContext *m_context;                                // The LLVM context.
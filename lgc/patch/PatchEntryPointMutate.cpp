@@ -65,6 +65,8 @@
 #include "lgc/util/AddressExtender.h"
 #include "lgc/util/BuilderBase.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -101,7 +103,7 @@ PatchEntryPointMutate::PatchEntryPointMutate() : m_hasTs(false), m_hasGs(false)
 // =====================================================================================================================
 PatchEntryPointMutate::UserDataArg::UserDataArg(llvm::Type *argTy, const llvm::Twine &name, unsigned userDataValue,
                                                 unsigned *argIndex)
-    : argTy(argTy), name(name.str()), userDataValue(userDataValue), argIndex(argIndex) {
+    : argTy(argTy), name(name.str()), userDataValue(userDataValue), argIndex(argIndex), usageWeight(0) {
   if (llvm::isa<llvm::PointerType>(argTy))
     argDwordSize = argTy->getPointerAddressSpace() == ADDR_SPACE_CONST_32BIT ? 1 : 2;
   else
@@ -381,6 +383,42 @@ void PatchEntryPointMutate::gatherUserDataUsage(Module *module) {
       getUserDataUsage(lastVertexStage)->usesStreamOutTable = true;
     }
   }
+
+  weightUserDataUsage();
+}
+
+// =====================================================================================================================
+// Weight the gathered usage of each user data node that is a candidate for unspilling, so that
+// determineUnspilledUserDataArgs can keep the most heavily used ones in SGPRs when they do not all fit. Each use counts
+// for 1, multiplied by 8 for each loop it is inside, up to a depth of 3.
+void PatchEntryPointMutate::weightUserDataUsage() {
+  static const unsigned MaxWeightedLoopDepth = 3;
+  static const unsigned LoopDepthWeightShift = 3;
+
+  // Loop info for each function, only computed for functions that contain a use.
+  DenseMap<Function *, std::unique_ptr<LoopInfo>> loopInfos;
+  auto weightUsage = [&](UserDataNodeUsage &nodeUsage) {
+    for (Instruction *user : nodeUsage.users) {
+      std::unique_ptr<LoopInfo> &loopInfo = loopInfos[user->getFunction()];
+      if (!loopInfo) {
+        DominatorTree domTree(*user->getFunction());
+        loopInfo = std::make_unique<LoopInfo>(domTree);
+      }
+      unsigned loopDepth = std::min(loopInfo->getLoopDepth(user->getParent()), MaxWeightedLoopDepth);
+      nodeUsage.usageWeight += uint64_t(1) << (LoopDepthWeightShift * loopDepth);
+    }
+  };
+
+  for (auto &userDataUsage : m_userDataUsage) {
+    if (!userDataUsage)
+      continue;
+    for (UserDataNodeUsage &nodeUsage : userDataUsage->pushConstOffsets)
+      weightUsage(nodeUsage);
+    for (UserDataNodeUsage &nodeUsage : userDataUsage->rootDescriptors)
+      weightUsage(nodeUsage);
+    for (UserDataNodeUsage &nodeUsage : userDataUsage->descriptorTables)
+      weightUsage(nodeUsage);
+  }
 }
 
 // =====================================================================================================================
@@ -790,6 +828,52 @@ void PatchEntryPointMutate::processCalls(Function &func, SmallVectorImpl<Type *>
   }
 }
 
+// =====================================================================================================================
+// Gets the number of waves per SIMD to budget the registers of the shader for, from its occupancy target. The target is
+// capped by the waves that a SIMD can hold, and for a compute shader by the thread groups that fit in the LDS of a CU,
+// as registers given up beyond that cap would not buy any occupancy.
+//
+// @param minWavesPerSimd : Minimum number of waves per SIMD that the shader is to run with
+// @returns : Number of waves per SIMD to budget the registers for
+unsigned PatchEntryPointMutate::getOccupancyWaves(unsigned minWavesPerSimd) {
+  const unsigned gfxMajor = m_pipelineState->getTargetInfo().getGfxIpVersion().major;
+  unsigned waves = std::min(minWavesPerSimd, gfxMajor >= 10 ? 16U : 10U);
+
+  if (m_shaderStage == ShaderStageCompute) {
+    const DataLayout &dataLayout = m_module->getDataLayout();
+    uint64_t ldsSize = 0;
+    for (GlobalVariable &global : m_module->globals()) {
+      if (global.getType()->getAddressSpace() == ADDR_SPACE_LOCAL && !global.use_empty())
+        ldsSize += dataLayout.getTypeAllocSize(global.getValueType());
+    }
+    if (ldsSize != 0) {
+      const auto &mode = m_pipelineState->getShaderModes()->getComputeShaderMode();
+      const unsigned threads = std::max(mode.workgroupSizeX, 1U) * std::max(mode.workgroupSizeY, 1U) *
+                               std::max(mode.workgroupSizeZ, 1U);
+      const unsigned wavesPerGroup = divideCeil(threads, m_pipelineState->getShaderWaveSize(m_shaderStage));
+      const uint64_t groupsPerCu = 65536 / ldsSize;
+      waves = std::min<uint64_t>(waves, std::max<uint64_t>(groupsPerCu * wavesPerGroup / 4, 1));
+    }
+  }
+  return std::max(waves, 1U);
+}
+
+// =====================================================================================================================
+// Gets the VGPR limit that lets the given number of waves of the shader share the VGPRs of a SIMD.
+//
+// @param wavesPerSimd : Number of waves per SIMD
+// @returns : Number of VGPRs that each wave can use
+unsigned PatchEntryPointMutate::getVgprLimitForWaves(unsigned wavesPerSimd) {
+  const unsigned gfxMajor = m_pipelineState->getTargetInfo().getGfxIpVersion().major;
+  const bool wave32 = gfxMajor >= 10 && m_pipelineState->getShaderWaveSize(m_shaderStage) == 32;
+
+  // VGPRs are allocated in granules out of the register file of each SIMD.
+  const unsigned vgprGranule = wave32 ? 8 : 4;
+  const unsigned totalVgprs = gfxMajor >= 10 ? (wave32 ? 1024 : 512) : 256;
+  const unsigned vgprLimit = totalVgprs / wavesPerSimd / vgprGranule * vgprGranule;
+  return std::min(vgprLimit, m_pipelineState->getTargetInfo().getGpuProperty().maxVgprsAvailable);
+}
+
 // =====================================================================================================================
 // Set Attributes on new function
 void PatchEntryPointMutate::setFuncAttrs(Function *entryPoint) {
@@ -846,6 +930,14 @@ void PatchEntryPointMutate::setFuncAttrs(Function *entryPoint) {
   unsigned vgprLimit = shaderOptions->vgprLimit;
   unsigned sgprLimit = shaderOptions->sgprLimit;
 
+  // An occupancy target tightens the VGPR limit to what that many waves per SIMD leave to each wave.
+  unsigned minWavesPerEu = 0;
+  if (shaderOptions->minWavesPerSimd != 0) {
+    minWavesPerEu = getOccupancyWaves(shaderOptions->minWavesPerSimd);
+    const unsigned occupancyVgprLimit = getVgprLimitForWaves(minWavesPerEu);
+    vgprLimit = vgprLimit != 0 ? std::min(vgprLimit, occupancyVgprLimit) : occupancyVgprLimit;
+  }
+
   if (vgprLimit != 0) {
     builder.addAttribute("amdgpu-num-vgpr", std::to_string(vgprLimit));
     resUsage->numVgprsAvailable = std::min(vgprLimit, resUsage->numVgprsAvailable);
@@ -861,8 +953,13 @@ void PatchEntryPointMutate::setFuncAttrs(Function *entryPoint) {
       std::min(resUsage->numSgprsAvailable, m_pipelineState->getTargetInfo().getGpuProperty().maxSgprsAvailable);
 
   if (shaderOptions->maxThreadGroupsPerComputeUnit != 0) {
-    std::string wavesPerEu = std::string("1,") + std::to_string(shaderOptions->maxThreadGroupsPerComputeUnit);
+    const unsigned maxWavesPerEu = shaderOptions->maxThreadGroupsPerComputeUnit;
+    minWavesPerEu = std::min(std::max(minWavesPerEu, 1U), maxWavesPerEu);
+    std::string wavesPerEu = std::to_string(minWavesPerEu) + "," + std::to_string(maxWavesPerEu);
     builder.addAttribute("amdgpu-waves-per-eu", wavesPerEu);
+  } else if (minWavesPerEu != 0) {
+    // The back-end also keeps the SGPRs within what the occupancy target leaves to each wave.
+    builder.addAttribute("amdgpu-waves-per-eu", std::to_string(minWavesPerEu));
   }
 
   if (shaderOptions->unrollThreshold != 0)
@@ -983,7 +1080,8 @@ uint64_t PatchEntryPointMutate::generateEntryPointArgTys(ShaderInputs *shaderInp
   inRegMask = (1ull << argTys.size()) - 1;
 
   // Push the fixed system (not user data) register args.
-  inRegMask |= shaderInputs->getShaderArgTys(m_pipelineState, m_shaderStage, argTys, argNames, argOffset);
+  inRegMask |= shaderInputs->getShaderArgTys(m_pipelineState, m_shaderStage, argTys, argNames, argOffset,
+                                             isComputeWithCalls());
 
   return inRegMask;
 }
@@ -1156,6 +1254,7 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
         unsigned userDataValue = static_cast<unsigned>(UserDataMapping::DescriptorSet0) + descSetIdx;
         userDataArgs.push_back(UserDataArg(builder.getInt32Ty(), "descTable" + Twine(descSetIdx), userDataValue,
                                            &descriptorTable.entryArgIdx));
+        userDataArgs.back().usageWeight = descriptorTable.usageWeight;
       }
     }
 
@@ -1190,7 +1289,7 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
              static_cast<unsigned>(UserDataMapping::PushConstMax) - static_cast<unsigned>(UserDataMapping::PushConst0));
       addUserDataArg(userDataArgs, static_cast<unsigned>(UserDataMapping::PushConst0) + dwordOffset,
                      pushConstOffset.dwordSize, "pushConst" + Twine(dwordOffset), &pushConstOffset.entryArgIdx,
-                     builder);
+                     pushConstOffset.usageWeight, builder);
     }
 
     return;
@@ -1228,8 +1327,9 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
       }
       // Add the arg (descriptor set pointer) that we can potentially unspill.
       unsigned *argIndex = descSetUsage == nullptr ? nullptr : &descSetUsage->entryArgIdx;
+      uint64_t usageWeight = descSetUsage == nullptr ? 0 : descSetUsage->usageWeight;
       addUserDataArg(userDataArgs, userDataValue, node.sizeInDwords, "descTable" + Twine(userDataNodeIdx), argIndex,
-                     builder);
+                     usageWeight, builder);
       break;
     }
 
@@ -1276,7 +1376,8 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
 
           // Add the arg (part of the push const) that we can potentially unspill.
           addUserDataArg(userDataArgs, node.offsetInDwords + dwordOffset, pushConstOffset.dwordSize,
-                         "pushConst" + Twine(dwordOffset), &pushConstOffset.entryArgIdx, builder);
+                         "pushConst" + Twine(dwordOffset), &pushConstOffset.entryArgIdx, pushConstOffset.usageWeight,
+                         builder);
         }
       } else {
         // Mark push constant for spill for compute library.
@@ -1307,7 +1408,7 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
         unsigned dwordSize = rootDescUsage.users[0]->getType()->getPrimitiveSizeInBits() / 32;
         // Add the arg (root descriptor) that we can potentially unspill.
         addUserDataArg(userDataArgs, dwordOffset, dwordSize, "rootDesc" + Twine(dwordOffset),
-                       &rootDescUsage.entryArgIdx, builder);
+                       &rootDescUsage.entryArgIdx, rootDescUsage.usageWeight, builder);
       }
       break;
     }
@@ -1321,14 +1422,16 @@ void PatchEntryPointMutate::addUserDataArgs(SmallVectorImpl<UserDataArg> &userDa
 // @param userDataValue : PAL metadata user data value, ~0U (UserDataMapping::Invalid) for none
 // @param sizeInDwords : Size of argument in dwords
 // @param argIndex : Where to store arg index once it is allocated, nullptr for none
+// @param usageWeight : Loop-depth-weighted static use count of the user data node
 // @param builder : IRBuilder (just for getting types)
 void PatchEntryPointMutate::addUserDataArg(SmallVectorImpl<UserDataArg> &userDataArgs, unsigned userDataValue,
                                            unsigned sizeInDwords, const Twine &name, unsigned *argIndex,
-                                           IRBuilder<> &builder) {
+                                           uint64_t usageWeight, IRBuilder<> &builder) {
   Type *argTy = builder.getInt32Ty();
   if (sizeInDwords != 1)
     argTy = FixedVectorType::get(argTy, sizeInDwords);
   userDataArgs.push_back(UserDataArg(argTy, name, userDataValue, argIndex));
+  userDataArgs.back().usageWeight = usageWeight;
 }
 
 // =====================================================================================================================
@@ -1411,12 +1514,38 @@ void PatchEntryPointMutate::determineUnspilledUserDataArgs(ArrayRef<UserDataArg>
   if (spillTableArg.hasValue())
     userDataEnd -= 1;
 
+  // If the args do not all fit, choose the ones to keep in SGPRs by usage weight, heaviest first, leaving room for the
+  // spill table pointer. The chosen args keep their original order. Compute-with-calls keeps the original order
+  // throughout, as the layout there has to match what library code expects.
+  SmallVector<bool, 16> spillArgs(userDataArgs.size(), false);
+  if (!isComputeWithCalls()) {
+    unsigned totalDwordSize = 0;
+    for (const UserDataArg &userDataArg : userDataArgs)
+      totalDwordSize += userDataArg.argDwordSize;
+    if (totalDwordSize > userDataEnd) {
+      SmallVector<unsigned, 16> argOrder;
+      for (unsigned argIdx = 0; argIdx != userDataArgs.size(); ++argIdx)
+        argOrder.push_back(argIdx);
+      std::stable_sort(argOrder.begin(), argOrder.end(), [&](unsigned lhs, unsigned rhs) {
+        return userDataArgs[lhs].usageWeight > userDataArgs[rhs].usageWeight;
+      });
+      unsigned availableDwordSize = spillTableArg.hasValue() || userDataEnd == 0 ? userDataEnd : userDataEnd - 1;
+      for (unsigned argIdx : argOrder) {
+        if (userDataArgs[argIdx].argDwordSize <= availableDwordSize)
+          availableDwordSize -= userDataArgs[argIdx].argDwordSize;
+        else
+          spillArgs[argIdx] = true;
+      }
+    }
+  }
+
   // See if we need to spill any user data nodes in userDataArgs, copying the unspilled ones across to unspilledArgs.
   unsigned userDataIdx = 0;
 
-  for (const UserDataArg &userDataArg : userDataArgs) {
+  for (unsigned argIdx = 0; argIdx != userDataArgs.size(); ++argIdx) {
+    const UserDataArg &userDataArg = userDataArgs[argIdx];
     unsigned afterUserDataIdx = userDataIdx + userDataArg.argDwordSize;
-    if (afterUserDataIdx > userDataEnd) {
+    if (spillArgs[argIdx] || afterUserDataIdx > userDataEnd) {
       // Spill this node. Allocate the spill table arg.
       if (!spillTableArg.hasValue()) {
         spillTableArg = UserDataArg(builder.getInt32Ty(), "spillTable", UserDataMapping::SpillTable,
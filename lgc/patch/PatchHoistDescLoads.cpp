@@ -0,0 +1,250 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistDescLoads.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchHoistDescLoads.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchHoistDescLoads.h"
+#include "lgc/patch/Patch.h"
+#include "lgc/state/IntrinsDefs.h"
+#include "lgc/util/BuilderBase.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Analysis/DivergenceAnalysis.h"
+#include "llvm/Analysis/LegacyDivergenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#define DEBUG_TYPE "lgc-patch-hoist-desc-loads"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchHoistDescLoads final : public FunctionPass {
+public:
+  LegacyPatchHoistDescLoads();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchHoistDescLoads(const LegacyPatchHoistDescLoads &) = delete;
+  LegacyPatchHoistDescLoads &operator=(const LegacyPatchHoistDescLoads &) = delete;
+
+  PatchHoistDescLoads m_impl;
+};
+
+// Loads of the same descriptor: the table pointer, the constant byte offset from it and the loaded type
+using DescLoadKey = std::pair<Value *, std::pair<int64_t, Type *>>;
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchHoistDescLoads::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for hoisting uniform descriptor loads.
+FunctionPass *lgc::createLegacyPatchHoistDescLoads() {
+  return new LegacyPatchHoistDescLoads();
+}
+
+// =====================================================================================================================
+LegacyPatchHoistDescLoads::LegacyPatchHoistDescLoads() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchHoistDescLoads::runOnFunction(Function &function) {
+  LegacyDivergenceAnalysis *divergenceAnalysis = &getAnalysis<LegacyDivergenceAnalysis>();
+  auto isDivergent = [divergenceAnalysis](const Value &value) { return divergenceAnalysis->isDivergent(&value); };
+  DominatorTree &dominatorTree = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  LoopInfo &loopInfo = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  return m_impl.runImpl(function, isDivergent, dominatorTree, loopInfo);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchHoistDescLoads::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  DivergenceInfo &divergenceInfo = analysisManager.getResult<DivergenceAnalysis>(function);
+  auto isDivergent = [&](const Value &value) { return divergenceInfo.isDivergent(value); };
+  DominatorTree &dominatorTree = analysisManager.getResult<DominatorTreeAnalysis>(function);
+  LoopInfo &loopInfo = analysisManager.getResult<LoopAnalysis>(function);
+  if (!runImpl(function, isDivergent, dominatorTree, loopInfo))
+    return PreservedAnalyses::all();
+
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param isDivergent : Function returning true if the given value is divergent
+// @param dominatorTree : Dominator tree of the function
+// @param loopInfo : Loop info of the function
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchHoistDescLoads::runImpl(Function &function, std::function<bool(const Value &)> isDivergent,
+                                  DominatorTree &dominatorTree, LoopInfo &loopInfo) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Hoist-Desc-Loads\n");
+
+  const DataLayout &dataLayout = function.getParent()->getDataLayout();
+  BasicBlock *entryBlock = &function.getEntryBlock();
+
+  // Gather the loads from constant memory at a constant offset from a uniform table pointer that is a function
+  // argument or is computed in the entry block, grouped by descriptor. Loads with a variable offset (e.g. indexing a
+  // descriptor array) are not known to stay inside the table, so they are not hoisted.
+  MapVector<DescLoadKey, SmallVector<LoadInst *, 4>> descLoads;
+  for (BasicBlock &block : function) {
+    for (Instruction &inst : block) {
+      auto load = dyn_cast<LoadInst>(&inst);
+      if (!load || !load->isSimple() || load->getPointerAddressSpace() != ADDR_SPACE_CONST)
+        continue;
+
+      APInt offset(dataLayout.getIndexTypeSizeInBits(load->getPointerOperandType()), 0);
+      Value *table = load->getPointerOperand()->stripAndAccumulateConstantOffsets(dataLayout, offset,
+                                                                                  /*AllowNonInbounds=*/true);
+      if (auto tableInst = dyn_cast<Instruction>(table)) {
+        if (tableInst->getParent() != entryBlock)
+          continue;
+      } else if (!isa<Argument>(table)) {
+        continue;
+      }
+      if (isDivergent(*table))
+        continue;
+
+      descLoads[{table, {offset.getSExtValue(), load->getType()}}].push_back(load);
+    }
+  }
+
+  bool changed = false;
+  BuilderBase builder(function.getContext());
+
+  for (auto &descLoad : descLoads) {
+    Value *table = descLoad.first.first;
+    int64_t offset = descLoad.first.second.first;
+    SmallVectorImpl<LoadInst *> &loads = descLoad.second;
+
+    // Find the nearest common dominator of the loads, and hoist it out of loops.
+    BasicBlock *hoistBlock = loads.front()->getParent();
+    unsigned maxLoopDepth = loopInfo.getLoopDepth(hoistBlock);
+    for (LoadInst *load : drop_begin(loads)) {
+      hoistBlock = dominatorTree.findNearestCommonDominator(hoistBlock, load->getParent());
+      maxLoopDepth = std::max(maxLoopDepth, loopInfo.getLoopDepth(load->getParent()));
+    }
+    for (Loop *loop = loopInfo.getLoopFor(hoistBlock); loop; loop = loop->getParentLoop()) {
+      BasicBlock *preheader = loop->getLoopPreheader();
+      if (!preheader)
+        break;
+      hoistBlock = preheader;
+    }
+
+    // Only a load in a loop is worth moving on its own. Otherwise, moving it would only lengthen the live range of
+    // the descriptor.
+    if (loads.size() == 1 && loopInfo.getLoopDepth(hoistBlock) == maxLoopDepth)
+      continue;
+
+    // Insert before the first load in the hoist block, if any, or else at its end.
+    Instruction *insertPos = hoistBlock->getTerminator();
+    for (LoadInst *load : loads) {
+      if (load->getParent() == hoistBlock) {
+        insertPos = load;
+        break;
+      }
+    }
+    if (auto tableInst = dyn_cast<Instruction>(table)) {
+      if (!dominatorTree.dominates(tableInst, insertPos))
+        continue;
+    }
+
+    LoadInst *hoistedLoad = dyn_cast<LoadInst>(insertPos);
+    if (!hoistedLoad) {
+      // Build the address of the descriptor from the table pointer, and clone one of the loads to load it.
+      builder.SetInsertPoint(insertPos);
+      Value *descPtr = builder.CreateBitCast(table, builder.getInt8Ty()->getPointerTo(ADDR_SPACE_CONST));
+      if (offset != 0)
+        descPtr = builder.CreateGEP(builder.getInt8Ty(), descPtr, builder.getInt64(offset));
+      descPtr = builder.CreateBitCast(descPtr, loads.front()->getPointerOperandType());
+
+      hoistedLoad = cast<LoadInst>(loads.front()->clone());
+      hoistedLoad->setOperand(LoadInst::getPointerOperandIndex(), descPtr);
+      hoistedLoad->insertBefore(insertPos);
+      hoistedLoad->takeName(loads.front());
+    }
+
+    for (LoadInst *load : loads) {
+      if (load == hoistedLoad)
+        continue;
+      combineMetadataForCSE(hoistedLoad, load, /*DoesKMove=*/true);
+      hoistedLoad->setAlignment(std::min(hoistedLoad->getAlign(), load->getAlign()));
+      load->replaceAllUsesWith(hoistedLoad);
+      load->eraseFromParent();
+    }
+
+    LLVM_DEBUG(dbgs() << "Hoisted " << loads.size() << " descriptor loads to " << *hoistedLoad << "\n");
+    changed = true;
+  }
+
+  return changed;
+}
+
+// =====================================================================================================================
+// Specify what analysis passes this pass depends on.
+//
+// @param [in/out] analysisUsage : The place to record our analysis pass usage requirements.
+void LegacyPatchHoistDescLoads::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<LegacyDivergenceAnalysis>();
+  analysisUsage.addRequired<DominatorTreeWrapperPass>();
+  analysisUsage.addRequired<LoopInfoWrapperPass>();
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for hoisting uniform descriptor loads.
+INITIALIZE_PASS_BEGIN(LegacyPatchHoistDescLoads, DEBUG_TYPE, "Patch LLVM for hoisting uniform descriptor loads", false,
+                      false)
+INITIALIZE_PASS_DEPENDENCY(LegacyDivergenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(LegacyPatchHoistDescLoads, DEBUG_TYPE, "Patch LLVM for hoisting uniform descriptor loads", false,
+                    false)
@@ -0,0 +1,152 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistGetPc.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchHoistGetPc.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchHoistGetPc.h"
+#include "lgc/patch/Patch.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/DemandedBits.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "lgc-patch-hoist-get-pc"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchHoistGetPc final : public FunctionPass {
+public:
+  LegacyPatchHoistGetPc();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchHoistGetPc(const LegacyPatchHoistGetPc &) = delete;
+  LegacyPatchHoistGetPc &operator=(const LegacyPatchHoistGetPc &) = delete;
+
+  PatchHoistGetPc m_impl;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchHoistGetPc::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for sharing one PC read in a function.
+FunctionPass *lgc::createLegacyPatchHoistGetPc() {
+  return new LegacyPatchHoistGetPc();
+}
+
+// =====================================================================================================================
+LegacyPatchHoistGetPc::LegacyPatchHoistGetPc() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Get the analysis usage of this pass.
+//
+// @param [out] analysisUsage : The analysis usage.
+void LegacyPatchHoistGetPc::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<DemandedBitsWrapperPass>();
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchHoistGetPc::runOnFunction(Function &function) {
+  return m_impl.runImpl(function, getAnalysis<DemandedBitsWrapperPass>().getDemandedBits());
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchHoistGetPc::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  if (!runImpl(function, analysisManager.getResult<DemandedBitsAnalysis>(function)))
+    return PreservedAnalyses::all();
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param demandedBits : Demanded bits analysis of the function
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchHoistGetPc::runImpl(Function &function, DemandedBits &demandedBits) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Hoist-Get-Pc\n");
+
+  SmallVector<CallInst *, 4> getPcs;
+  for (BasicBlock &block : function) {
+    for (Instruction &inst : block) {
+      auto call = dyn_cast<CallInst>(&inst);
+      if (!call || call->getIntrinsicID() != Intrinsic::amdgcn_s_getpc)
+        continue;
+      // Only the PC reads whose low half is not used are shared.
+      if (demandedBits.getDemandedBits(call).countTrailingZeros() >= 32)
+        getPcs.push_back(call);
+    }
+  }
+  if (getPcs.size() < 2)
+    return false;
+
+  IRBuilder<> builder(function.getContext());
+  builder.SetInsertPoint(&*function.getEntryBlock().getFirstInsertionPt());
+  Value *sharedPc = builder.CreateIntrinsic(Intrinsic::amdgcn_s_getpc, {}, {});
+  for (CallInst *getPc : getPcs) {
+    getPc->replaceAllUsesWith(sharedPc);
+    getPc->eraseFromParent();
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for sharing one PC read in a function.
+INITIALIZE_PASS_BEGIN(LegacyPatchHoistGetPc, DEBUG_TYPE, "Patch LLVM for sharing one PC read in a function", false,
+                      false)
+INITIALIZE_PASS_DEPENDENCY(DemandedBitsWrapperPass)
+INITIALIZE_PASS_END(LegacyPatchHoistGetPc, DEBUG_TYPE, "Patch LLVM for sharing one PC read in a function", false, false)
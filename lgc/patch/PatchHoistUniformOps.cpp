@@ -0,0 +1,171 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchHoistUniformOps.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchHoistUniformOps.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchHoistUniformOps.h"
+#include "lgc/patch/Patch.h"
+#include "llvm/Analysis/DivergenceAnalysis.h"
+#include "llvm/Analysis/LegacyDivergenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/LoopIterator.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "lgc-patch-hoist-uniform-ops"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchHoistUniformOps final : public FunctionPass {
+public:
+  LegacyPatchHoistUniformOps();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchHoistUniformOps(const LegacyPatchHoistUniformOps &) = delete;
+  LegacyPatchHoistUniformOps &operator=(const LegacyPatchHoistUniformOps &) = delete;
+
+  PatchHoistUniformOps m_impl;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchHoistUniformOps::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for hoisting uniform operations out of loops.
+FunctionPass *lgc::createLegacyPatchHoistUniformOps() {
+  return new LegacyPatchHoistUniformOps();
+}
+
+// =====================================================================================================================
+LegacyPatchHoistUniformOps::LegacyPatchHoistUniformOps() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchHoistUniformOps::runOnFunction(Function &function) {
+  LegacyDivergenceAnalysis *divergenceAnalysis = &getAnalysis<LegacyDivergenceAnalysis>();
+  auto isDivergent = [divergenceAnalysis](const Value &value) { return divergenceAnalysis->isDivergent(&value); };
+  LoopInfo &loopInfo = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  return m_impl.runImpl(function, isDivergent, loopInfo);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchHoistUniformOps::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  DivergenceInfo &divergenceInfo = analysisManager.getResult<DivergenceAnalysis>(function);
+  auto isDivergent = [&](const Value &value) { return divergenceInfo.isDivergent(value); };
+  LoopInfo &loopInfo = analysisManager.getResult<LoopAnalysis>(function);
+  if (!runImpl(function, isDivergent, loopInfo))
+    return PreservedAnalyses::all();
+
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : LLVM function to be run on
+// @param isDivergent : Function returning true if the given value is divergent
+// @param loopInfo : Loop info of the function
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchHoistUniformOps::runImpl(Function &function, std::function<bool(const Value &)> isDivergent,
+                                   LoopInfo &loopInfo) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Hoist-Uniform-Ops\n");
+
+  bool changed = false;
+
+  // Visit inner loops before outer ones, so that an operation can be hoisted out of a whole loop nest one loop at a
+  // time. Visit the blocks of a loop in dominance order (header first), so that an operation whose operands were
+  // hoisted becomes invariant itself.
+  SmallVector<Loop *, 8> loops = loopInfo.getLoopsInPreorder();
+  for (Loop *loop : reverse(loops)) {
+    BasicBlock *preheader = loop->getLoopPreheader();
+    if (!preheader)
+      continue;
+    Instruction *insertPos = preheader->getTerminator();
+
+    LoopBlocksRPO loopBlocks(loop);
+    loopBlocks.perform(&loopInfo);
+    for (BasicBlock *block : loopBlocks) {
+      for (Instruction &inst : make_early_inc_range(*block)) {
+        if (isa<PHINode>(inst) || isa<AllocaInst>(inst) || inst.isTerminator() || inst.mayReadOrWriteMemory() ||
+            inst.getType()->isVoidTy())
+          continue;
+        if (isDivergent(inst) || !loop->hasLoopInvariantOperands(&inst) || !isSafeToSpeculativelyExecute(&inst))
+          continue;
+
+        LLVM_DEBUG(dbgs() << "Hoisting uniform " << inst << "\n");
+        inst.moveBefore(insertPos);
+        changed = true;
+      }
+    }
+  }
+
+  return changed;
+}
+
+// =====================================================================================================================
+// Specify what analysis passes this pass depends on.
+//
+// @param [in/out] analysisUsage : The place to record our analysis pass usage requirements.
+void LegacyPatchHoistUniformOps::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<LegacyDivergenceAnalysis>();
+  analysisUsage.addRequired<LoopInfoWrapperPass>();
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for hoisting uniform operations out of loops.
+INITIALIZE_PASS_BEGIN(LegacyPatchHoistUniformOps, DEBUG_TYPE, "Patch LLVM for hoisting uniform operations out of loops",
+                      false, false)
+INITIALIZE_PASS_DEPENDENCY(LegacyDivergenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(LegacyPatchHoistUniformOps, DEBUG_TYPE, "Patch LLVM for hoisting uniform operations out of loops",
+                    false, false)
@@ -0,0 +1,251 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchImageOpCombine.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchImageOpCombine.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchImageOpCombine.h"
+#include "lgc/patch/Patch.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "lgc-patch-image-op-combine"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchImageOpCombine final : public FunctionPass {
+public:
+  LegacyPatchImageOpCombine();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchImageOpCombine(const LegacyPatchImageOpCombine &) = delete;
+  LegacyPatchImageOpCombine &operator=(const LegacyPatchImageOpCombine &) = delete;
+
+  PatchImageOpCombine m_impl;
+};
+
+// An image op that is a candidate for combining
+struct ImageOp {
+  CallInst *call; // The image intrinsic call
+  unsigned dmask; // Its dmask
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchImageOpCombine::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for image op combining.
+FunctionPass *lgc::createLegacyPatchImageOpCombine() {
+  return new LegacyPatchImageOpCombine();
+}
+
+// =====================================================================================================================
+LegacyPatchImageOpCombine::LegacyPatchImageOpCombine() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Get the analysis usage of this pass.
+//
+// @param [out] analysisUsage : The analysis usage.
+void LegacyPatchImageOpCombine::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine image ops in
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchImageOpCombine::runOnFunction(Function &function) {
+  return m_impl.runImpl(function);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine image ops in
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchImageOpCombine::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  if (!runImpl(function))
+    return PreservedAnalyses::all();
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Get the dmask of an image sample or image load that can be combined with others.
+//
+// @param call : The call to check
+// @returns : The dmask of the image op, or 0 if the call is not an image op that can be combined
+static unsigned getCombinableDmask(CallInst *call) {
+  Function *callee = call->getCalledFunction();
+  if (!callee || !callee->isIntrinsic())
+    return 0;
+  // The dmask of a gather selects the channel to gather rather than the channels to return, and the ops with a
+  // texfail result return a struct.
+  StringRef name = callee->getName();
+  if (!name.startswith("llvm.amdgcn.image.sample") && !name.startswith("llvm.amdgcn.image.load"))
+    return 0;
+  if (call->getType()->isStructTy())
+    return 0;
+  auto dmask = dyn_cast<ConstantInt>(call->getArgOperand(0));
+  return dmask ? dmask->getZExtValue() & 0xF : 0;
+}
+
+// =====================================================================================================================
+// Check whether two image ops can be combined, that is whether they are the same op apart from the dmask.
+//
+// @param lhs : The earlier image op
+// @param rhs : The later image op
+// @returns : True if the image ops can be combined
+static bool canCombineImageOps(const ImageOp &lhs, const ImageOp &rhs) {
+  if (lhs.call->getIntrinsicID() != rhs.call->getIntrinsicID() || lhs.call->arg_size() != rhs.call->arg_size() ||
+      lhs.call->getType()->getScalarType() != rhs.call->getType()->getScalarType())
+    return false;
+  for (unsigned idx = 1; idx != lhs.call->arg_size(); ++idx) {
+    if (lhs.call->getArgOperand(idx) != rhs.call->getArgOperand(idx))
+      return false;
+  }
+  // Identical ops returning a single channel are left to CSE.
+  return countPopulation(lhs.dmask | rhs.dmask) > 1;
+}
+
+// =====================================================================================================================
+// Replace an image op with the channels it returns from the combined image op.
+//
+// @param op : The image op to replace
+// @param combined : The combined image op
+// @param [in/out] builder : IR builder to use
+static void replaceWithCombinedChannels(const ImageOp &op, const ImageOp &combined, IRBuilder<> &builder) {
+  // An image op returns the channels in its dmask, packed in channel order.
+  SmallVector<int, 4> mask;
+  for (unsigned channel = 0; channel != 4; ++channel) {
+    if (op.dmask & (1U << channel))
+      mask.push_back(countPopulation(combined.dmask & ((1U << channel) - 1)));
+  }
+
+  Value *part = nullptr;
+  if (auto vectorTy = dyn_cast<FixedVectorType>(op.call->getType())) {
+    mask.resize(vectorTy->getNumElements(), UndefMaskElem);
+    part = builder.CreateShuffleVector(combined.call, mask);
+  } else {
+    part = builder.CreateExtractElement(combined.call, mask[0]);
+  }
+  part->takeName(op.call);
+  op.call->replaceAllUsesWith(part);
+}
+
+// =====================================================================================================================
+// Combine two image ops into one with the union of their dmasks, placed where the earlier one is.
+//
+// @param lhs : The earlier image op
+// @param rhs : The later image op
+// @param [in/out] builder : IR builder to use
+// @returns : The combined image op
+static ImageOp combineImageOps(const ImageOp &lhs, const ImageOp &rhs, IRBuilder<> &builder) {
+  const unsigned dmask = lhs.dmask | rhs.dmask;
+  Type *resultTy = FixedVectorType::get(lhs.call->getType()->getScalarType(), countPopulation(dmask));
+
+  // The return type is the first overloaded type of the image intrinsics.
+  Function *callee = lhs.call->getCalledFunction();
+  SmallVector<Type *, 4> overloadTys;
+  Intrinsic::getIntrinsicSignature(callee, overloadTys);
+  overloadTys[0] = resultTy;
+  Function *combinedFunc = Intrinsic::getDeclaration(callee->getParent(), callee->getIntrinsicID(), overloadTys);
+
+  builder.SetInsertPoint(lhs.call);
+  SmallVector<Value *, 12> args(lhs.call->args());
+  args[0] = builder.getInt32(dmask);
+  CallInst *combinedCall = builder.CreateCall(combinedFunc, args);
+  combinedCall->setAttributes(lhs.call->getAttributes());
+  LLVM_DEBUG(dbgs() << "Combined image ops into " << *combinedCall << "\n");
+
+  ImageOp combined = {combinedCall, dmask};
+  replaceWithCombinedChannels(lhs, combined, builder);
+  replaceWithCombinedChannels(rhs, combined, builder);
+  lhs.call->eraseFromParent();
+  rhs.call->eraseFromParent();
+  return combined;
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will combine image ops in
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchImageOpCombine::runImpl(Function &function) {
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Image-Op-Combine\n");
+
+  IRBuilder<> builder(function.getContext());
+  bool changed = false;
+
+  for (BasicBlock &block : function) {
+    SmallVector<ImageOp, 8> candidates;
+    for (auto instIt = block.begin(); instIt != block.end();) {
+      Instruction &inst = *instIt++;
+      auto call = dyn_cast<CallInst>(&inst);
+      const unsigned dmask = call ? getCombinableDmask(call) : 0;
+      if (!dmask) {
+        // Image ops read memory, so they cannot be combined across a write that might alias them. This also keeps
+        // them from being combined across a kill or demote, which changes the lanes that implicit derivatives use.
+        if (inst.mayWriteToMemory())
+          candidates.clear();
+        continue;
+      }
+
+      ImageOp op = {call, dmask};
+      auto candidate = llvm::find_if(candidates, [&](const ImageOp &other) { return canCombineImageOps(other, op); });
+      if (candidate == candidates.end()) {
+        candidates.push_back(op);
+        continue;
+      }
+      *candidate = combineImageOps(*candidate, op, builder);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for image op combining.
+INITIALIZE_PASS(LegacyPatchImageOpCombine, DEBUG_TYPE, "Patch LLVM for image op combining", false, false)
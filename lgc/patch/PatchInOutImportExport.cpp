@@ -46,6 +46,69 @@
 using namespace llvm;
 using namespace lgc;
 
+// -reconfig-workgroup-zorder-tile-size: maximum tile size of the Z-order workgroup reconfiguration
+static cl::opt<unsigned> ReconfigWorkgroupZOrderTileSize(
+    "reconfig-workgroup-zorder-tile-size",
+    cl::desc("Maximum size of the square tiles that the workgroup is reconfigured to in Morton order, for compute "
+             "shaders whose image coordinates derive from the invocation ID (0 to disable)"),
+    cl::init(8));
+
+// -fold-constant-tess-factors: fold constant tessellation factors written by TCS instead of passing them through LDS
+static cl::opt<bool> FoldConstantTessFactors(
+    "fold-constant-tess-factors",
+    cl::desc("Fold the tessellation factors that TCS writes as constants into TES, instead of passing them in LDS"),
+    cl::init(true));
+
+// Count of the outer and inner tessellation factors, by primitive mode.
+// Row 0 - Unknown, 1 - Triangle, 2 - Quad, 3 - Isoline.
+static const unsigned ExpTessFactorCount[][2] = {{0, 0}, {3, 1}, {4, 2}, {2, 0}};
+
+// =====================================================================================================================
+// Gets the tile size of the Z-order workgroup reconfiguration: the largest power of 2 not above the maximum tile size
+// that divides both the X and Y sizes of the workgroup.
+//
+// @param mode : Compute shader mode
+// @returns : Tile size, or 0 if Z-order reconfiguration is not possible
+static unsigned getZOrderTileSize(const ComputeShaderMode &mode) {
+  if (ReconfigWorkgroupZOrderTileSize < 2)
+    return 0;
+  unsigned tileSize = 1u << Log2_32(ReconfigWorkgroupZOrderTileSize);
+  while (tileSize >= 2 && ((mode.workgroupSizeX % tileSize) != 0 || (mode.workgroupSizeY % tileSize) != 0))
+    tileSize /= 2;
+  return tileSize >= 2 ? tileSize : 0;
+}
+
+// =====================================================================================================================
+// Checks whether the local invocation ID (or a value derived from it) is used as the coordinate of an image operation.
+//
+// @param localInvocationId : Local invocation ID
+// @returns : True if an image coordinate is derived from the local invocation ID
+static bool isUsedInImageCoord(Value *localInvocationId) {
+  SmallVector<Value *, 8> worklist;
+  SmallPtrSet<Value *, 16> visited;
+  worklist.push_back(localInvocationId);
+  visited.insert(localInvocationId);
+  while (!worklist.empty()) {
+    Value *value = worklist.pop_back_val();
+    for (User *user : value->users()) {
+      if (auto call = dyn_cast<CallInst>(user)) {
+        Function *callee = call->getCalledFunction();
+        if (callee && callee->getName().startswith("llvm.amdgcn.image."))
+          return true;
+        continue;
+      }
+      // Only follow the arithmetic that image coordinates are typically computed with.
+      if (!isa<BinaryOperator>(user) && !isa<CastInst>(user) && !isa<ExtractElementInst>(user) &&
+          !isa<InsertElementInst>(user) && !isa<ShuffleVectorInst>(user) && !isa<SelectInst>(user) &&
+          !isa<PHINode>(user))
+        continue;
+      if (visited.insert(user).second)
+        worklist.push_back(user);
+    }
+  }
+  return false;
+}
+
 namespace lgc {
 
 // =====================================================================================================================
@@ -86,6 +149,7 @@ void PatchInOutImportExport::initPerShader() {
   m_threadId = nullptr;
 
   m_attribExports.clear();
+  m_fsInterpCoords.clear();
 }
 
 // =====================================================================================================================
@@ -115,8 +179,11 @@ PreservedAnalyses PatchInOutImportExport::run(Module &module, ModuleAnalysisMana
     auto &fam = analysisManager.getResult<FunctionAnalysisManagerModuleProxy>(module).getManager();
     return fam.getResult<PostDominatorTreeAnalysis>(f);
   };
-  if (runImpl(module, pipelineShaders, pipelineState, getPDT))
-    return PreservedAnalyses::none();
+  if (runImpl(module, pipelineShaders, pipelineState, getPDT)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
   return PreservedAnalyses::all();
 }
 
@@ -180,6 +247,8 @@ bool PatchInOutImportExport::runImpl(Module &module, PipelineShadersResult &pipe
     break;
   }
 
+  collectConstantTessFactors(module);
+
   // Process each shader in turn, in reverse order (because for example VS uses inOutUsage.tcs.calcFactor
   // set by TCS).
   for (int shaderStage = ShaderStageCountInternal - 1; shaderStage >= 0; --shaderStage) {
@@ -437,7 +506,8 @@ void PatchInOutImportExport::processShader() {
     // This does not particularly have to be done here; it could be done anywhere after BuilderImpl.
     for (Function &func : *m_module) {
       if (func.isDeclaration() && func.getName().startswith(lgcName::ReconfigureLocalInvocationId)) {
-        WorkgroupLayout workgroupLayout = calculateWorkgroupLayout();
+        bool imageCoordsFromId = any_of(func.users(), [](User *user) { return isUsedInImageCoord(user); });
+        WorkgroupLayout workgroupLayout = calculateWorkgroupLayout(imageCoordsFromId);
         while (!func.use_empty()) {
           CallInst *reconfigCall = cast<CallInst>(*func.user_begin());
           Value *localInvocationId = reconfigCall->getArgOperand(0);
@@ -1741,33 +1811,13 @@ Value *PatchInOutImportExport::patchFsGenericInputImport(Type *inputTy, unsigned
 
   // Not "flat" and "custom" interpolation
   if (interpMode != InOutInfo::InterpModeFlat && interpMode != InOutInfo::InterpModeCustom) {
-    auto ij = auxInterpValue;
-    if (!ij) {
-      if (interpMode == InOutInfo::InterpModeSmooth) {
-        if (interpLoc == InOutInfo::InterpLocCentroid) {
-          ij = adjustCentroidIj(getFunctionArgument(m_entryPoint, entryArgIdxs.perspInterp.centroid),
-                                getFunctionArgument(m_entryPoint, entryArgIdxs.perspInterp.center), insertPos);
-        } else if (interpLoc == InOutInfo::InterpLocSample)
-          ij = getFunctionArgument(m_entryPoint, entryArgIdxs.perspInterp.sample);
-        else {
-          assert(interpLoc == InOutInfo::InterpLocCenter);
-          ij = getFunctionArgument(m_entryPoint, entryArgIdxs.perspInterp.center);
-        }
-      } else {
-        assert(interpMode == InOutInfo::InterpModeNoPersp);
-        if (interpLoc == InOutInfo::InterpLocCentroid) {
-          ij = adjustCentroidIj(getFunctionArgument(m_entryPoint, entryArgIdxs.linearInterp.centroid),
-                                getFunctionArgument(m_entryPoint, entryArgIdxs.linearInterp.center), insertPos);
-        } else if (interpLoc == InOutInfo::InterpLocSample)
-          ij = getFunctionArgument(m_entryPoint, entryArgIdxs.linearInterp.sample);
-        else {
-          assert(interpLoc == InOutInfo::InterpLocCenter);
-          ij = getFunctionArgument(m_entryPoint, entryArgIdxs.linearInterp.center);
-        }
-      }
-    }
-    coordI = ExtractElementInst::Create(ij, ConstantInt::get(Type::getInt32Ty(*m_context), 0), "", insertPos);
-    coordJ = ExtractElementInst::Create(ij, ConstantInt::get(Type::getInt32Ty(*m_context), 1), "", insertPos);
+    if (auxInterpValue) {
+      coordI = ExtractElementInst::Create(auxInterpValue, ConstantInt::get(Type::getInt32Ty(*m_context), 0), "",
+                                          insertPos);
+      coordJ = ExtractElementInst::Create(auxInterpValue, ConstantInt::get(Type::getInt32Ty(*m_context), 1), "",
+                                          insertPos);
+    } else
+      std::tie(coordI, coordJ) = getFsInterpCoords(interpMode, interpLoc);
   }
 
   Type *basicTy = inputTy->isVectorTy() ? cast<VectorType>(inputTy)->getElementType() : inputTy;
@@ -1929,6 +1979,10 @@ void PatchInOutImportExport::patchTcsGenericOutputExport(Value *output, unsigned
                                                          Value *compIdx, Value *vertexIdx, Instruction *insertPos) {
   assert(compIdx);
 
+  // If every patch is culled, TES never reads the outputs
+  if (m_tessPatchAlwaysCulled)
+    return;
+
   Type *outputTy = output->getType();
   auto ldsOffset = calcLdsOffsetForTcsOutput(outputTy, location, locOffset, compIdx, vertexIdx, insertPos);
   writeValueToLds(output, ldsOffset, insertPos);
@@ -2197,6 +2251,14 @@ Value *PatchInOutImportExport::patchTesBuiltInInputImport(Type *inputTy, unsigne
   }
   case BuiltInTessLevelOuter:
   case BuiltInTessLevelInner: {
+    ArrayRef<Constant *> constTessLevel =
+        builtInId == BuiltInTessLevelOuter ? m_constTessLevelOuter : m_constTessLevelInner;
+    if (!constTessLevel.empty()) {
+      // TCS writes the tessellation factors as constants, so they are not passed through LDS
+      input = getConstantTessLevel(inputTy, elemIdx, constTessLevel, insertPos);
+      break;
+    }
+
     assert(perPatchBuiltInInLocMap.find(builtInId) != perPatchBuiltInInLocMap.end());
     unsigned loc = perPatchBuiltInInLocMap[builtInId];
 
@@ -3040,6 +3102,11 @@ void PatchInOutImportExport::patchTcsBuiltInOutputExport(Value *output, unsigned
   auto &builtInUsage = resUsage->builtInUsage.tcs;
   auto &builtInOutLocMap = resUsage->inOutUsage.builtInOutputLocMap;
 
+  // If every patch is culled, TES never reads the outputs, but the tessellation factors still have to be written to
+  // the TF buffer for the hardware to cull the patches.
+  if (m_tessPatchAlwaysCulled && builtInId != BuiltInTessLevelOuter && builtInId != BuiltInTessLevelInner)
+    return;
+
   switch (builtInId) {
   case BuiltInPosition: {
     if (!static_cast<bool>(builtInUsage.position))
@@ -5280,6 +5347,46 @@ void PatchInOutImportExport::addExportInstForBuiltInOutput(Value *output, unsign
   }
 }
 
+// =====================================================================================================================
+// Gets the I and J coordinates provided by hardware for the given interpolation mode and location, shared by all the
+// inputs interpolated with them. They are set up at the start of the entry-point, so that inputs read in blocks that
+// do not dominate each other still share them, rather than each setting up its own.
+//
+// @param interpMode : Interpolation mode (smooth or no-perspective)
+// @param interpLoc : Interpolation location (center, centroid or sample)
+std::pair<Value *, Value *> PatchInOutImportExport::getFsInterpCoords(unsigned interpMode, unsigned interpLoc) {
+  auto &coords = m_fsInterpCoords[interpMode << 8 | interpLoc];
+  if (coords.first)
+    return coords;
+
+  auto &entryArgIdxs = m_pipelineState->getShaderInterfaceData(ShaderStageFragment)->entryArgIdxs.fs;
+  unsigned sampleArgIdx = entryArgIdxs.linearInterp.sample;
+  unsigned centerArgIdx = entryArgIdxs.linearInterp.center;
+  unsigned centroidArgIdx = entryArgIdxs.linearInterp.centroid;
+  if (interpMode == InOutInfo::InterpModeSmooth) {
+    sampleArgIdx = entryArgIdxs.perspInterp.sample;
+    centerArgIdx = entryArgIdxs.perspInterp.center;
+    centroidArgIdx = entryArgIdxs.perspInterp.centroid;
+  } else {
+    assert(interpMode == InOutInfo::InterpModeNoPersp);
+  }
+
+  Instruction *insertPos = &*m_entryPoint->getEntryBlock().getFirstInsertionPt();
+  Value *ij = nullptr;
+  if (interpLoc == InOutInfo::InterpLocCentroid) {
+    ij = adjustCentroidIj(getFunctionArgument(m_entryPoint, centroidArgIdx),
+                          getFunctionArgument(m_entryPoint, centerArgIdx), insertPos);
+  } else if (interpLoc == InOutInfo::InterpLocSample)
+    ij = getFunctionArgument(m_entryPoint, sampleArgIdx);
+  else {
+    assert(interpLoc == InOutInfo::InterpLocCenter);
+    ij = getFunctionArgument(m_entryPoint, centerArgIdx);
+  }
+  coords.first = ExtractElementInst::Create(ij, ConstantInt::get(Type::getInt32Ty(*m_context), 0), "", insertPos);
+  coords.second = ExtractElementInst::Create(ij, ConstantInt::get(Type::getInt32Ty(*m_context), 1), "", insertPos);
+  return coords;
+}
+
 // =====================================================================================================================
 // Adjusts I/J calculation for "centroid" interpolation mode by taking "center" mode into account.
 //
@@ -5327,7 +5434,9 @@ Value *PatchInOutImportExport::getSubgroupLocalInvocationId(Instruction *insertP
 // =====================================================================================================================
 // Do automatic workgroup size reconfiguration in a compute shader, to allow ReconfigWorkgroup
 // to apply optimizations.
-WorkgroupLayout PatchInOutImportExport::calculateWorkgroupLayout() {
+//
+// @param imageCoordsFromId : Whether image coordinates are derived from the local invocation ID
+WorkgroupLayout PatchInOutImportExport::calculateWorkgroupLayout(bool imageCoordsFromId) {
   auto &resUsage = *m_pipelineState->getShaderResourceUsage(ShaderStageCompute);
   if (m_shaderStage == ShaderStageCompute) {
     bool reconfig = false;
@@ -5351,11 +5460,20 @@ WorkgroupLayout PatchInOutImportExport::calculateWorkgroupLayout() {
       // 8x8 requested.
       reconfig = true;
       break;
+    case WorkgroupLayout::ZOrder:
+      // Z-order requested.
+      reconfig = true;
+      break;
     }
 
     if (reconfig) {
       auto &mode = m_pipelineState->getShaderModes()->getComputeShaderMode();
-      if ((mode.workgroupSizeX % 2) == 0 && (mode.workgroupSizeY % 2) == 0) {
+      if (static_cast<WorkgroupLayout>(resUsage.builtInUsage.cs.workgroupLayout) == WorkgroupLayout::Unknown &&
+          imageCoordsFromId && mode.workgroupSizeY > 1 && getZOrderTileSize(mode) != 0) {
+        // If the image coordinates are derived from the invocation ID, neighbouring invocations likely access
+        // neighbouring texels, so a Morton order of 2D tiles keeps the accesses of a wave within a compact area.
+        resUsage.builtInUsage.cs.workgroupLayout = static_cast<unsigned>(WorkgroupLayout::ZOrder);
+      } else if ((mode.workgroupSizeX % 2) == 0 && (mode.workgroupSizeY % 2) == 0) {
         if ((mode.workgroupSizeX > 8 && mode.workgroupSizeY >= 8) ||
             (mode.workgroupSizeX >= 8 && mode.workgroupSizeY > 8)) {
           // If our local size in the X & Y dimensions are greater than 8, we can reconfigure.
@@ -5411,6 +5529,29 @@ Value *PatchInOutImportExport::reconfigWorkgroup(Value *localInvocationId, Instr
                                            insertPos);
   }
 
+  if (workgroupLayout == WorkgroupLayout::ZOrder) {
+    // The flat ID is split into the index of a TxT tile, with the tiles in row-major order, and the index of the
+    // invocation in the tile, whose even and odd bits are the X and Y in the tile (Morton order).
+    const unsigned tileSize = getZOrderTileSize(mode);
+    assert(tileSize != 0);
+    const unsigned tileBits = Log2_32(tileSize);
+    const unsigned tileCountX = mode.workgroupSizeX / tileSize;
+
+    IRBuilder<> builder(insertPos);
+    Value *flatId = builder.CreateExtractElement(remappedId, uint64_t(0));
+    Value *tileId = builder.CreateLShr(flatId, 2 * tileBits);
+    Value *newX = builder.CreateShl(builder.CreateURem(tileId, builder.getInt32(tileCountX)), tileBits);
+    Value *newY = builder.CreateShl(builder.CreateUDiv(tileId, builder.getInt32(tileCountX)), tileBits);
+    for (unsigned bit = 0; bit != tileBits; ++bit) {
+      Value *bitX = builder.CreateAnd(builder.CreateLShr(flatId, 2 * bit), 1);
+      Value *bitY = builder.CreateAnd(builder.CreateLShr(flatId, 2 * bit + 1), 1);
+      newX = builder.CreateOr(newX, builder.CreateShl(bitX, bit));
+      newY = builder.CreateOr(newY, builder.CreateShl(bitY, bit));
+    }
+    remappedId = builder.CreateInsertElement(remappedId, newX, uint64_t(0));
+    return builder.CreateInsertElement(remappedId, newY, 1);
+  }
+
   Instruction *const x = ExtractElementInst::Create(remappedId, ConstantInt::get(int32Ty, 0), "", insertPos);
 
   Instruction *const bit0 = BinaryOperator::CreateAnd(x, ConstantInt::get(int32Ty, 0x1), "", insertPos);
@@ -5708,6 +5849,108 @@ void PatchInOutImportExport::exportVertexAttribs(Instruction *insertPos) {
   }
 }
 
+// =====================================================================================================================
+// Collects the tessellation factors that TCS writes as constants. TES reads of such factors are folded to the
+// constants, so TCS does not have to write them to LDS. Also works out whether the constant outer tessellation factors
+// cull every patch, in which case TES never runs and TCS does not have to write its other outputs to LDS either.
+//
+// NOTE: This is only done if TCS does not read back any of its outputs, as those reads still go through LDS.
+//
+// @param module : LLVM module
+void PatchInOutImportExport::collectConstantTessFactors(Module &module) {
+  m_constTessLevelOuter.clear();
+  m_constTessLevelInner.clear();
+  m_tessPatchAlwaysCulled = false;
+
+  if (!FoldConstantTessFactors || !m_pipelineState->hasShaderStage(ShaderStageTessControl) ||
+      !m_pipelineState->hasShaderStage(ShaderStageTessEval))
+    return;
+
+  SmallVector<Constant *, 4> constTessLevels[2] = {SmallVector<Constant *, 4>(4), SmallVector<Constant *, 4>(2)};
+  bool isConstant[2] = {true, true};
+  for (Function &func : module) {
+    if (!func.isDeclaration())
+      continue;
+    const bool isBuiltInOutputExport = func.getName().startswith(lgcName::OutputExportBuiltIn);
+    const bool isOutputImport = func.getName().startswith(lgcName::OutputImportGeneric) ||
+                                func.getName().startswith(lgcName::OutputImportBuiltIn);
+    if (!isBuiltInOutputExport && !isOutputImport)
+      continue;
+
+    for (User *user : func.users()) {
+      auto call = dyn_cast<CallInst>(user);
+      if (!call || getShaderStage(call->getFunction()) != ShaderStageTessControl)
+        continue;
+      if (isOutputImport)
+        return;
+
+      const unsigned builtInId = cast<ConstantInt>(call->getOperand(0))->getZExtValue();
+      if (builtInId != BuiltInTessLevelOuter && builtInId != BuiltInTessLevelInner)
+        continue;
+      const unsigned i = builtInId == BuiltInTessLevelOuter ? 0 : 1;
+      auto &constTessLevel = constTessLevels[i];
+
+      // Record one constant element, which must agree with what other writes of the element have written.
+      auto setElement = [&](uint64_t elemIdx, Constant *elem) {
+        if (!elem || isa<UndefValue>(elem))
+          return;
+        if (elemIdx >= constTessLevel.size() || (constTessLevel[elemIdx] && constTessLevel[elemIdx] != elem))
+          isConstant[i] = false;
+        else
+          constTessLevel[elemIdx] = elem;
+      };
+
+      auto output = dyn_cast<Constant>(call->getOperand(3));
+      if (!output) {
+        isConstant[i] = false;
+      } else if (output->getType()->isArrayTy()) {
+        for (unsigned elemIdx = 0; elemIdx < output->getType()->getArrayNumElements(); ++elemIdx)
+          setElement(elemIdx, output->getAggregateElement(elemIdx));
+      } else if (auto elemIdx = dyn_cast<ConstantInt>(call->getOperand(1))) {
+        setElement(elemIdx->getZExtValue(), output);
+      } else {
+        isConstant[i] = false;
+      }
+    }
+  }
+
+  if (isConstant[0]) {
+    // If any of the relevant outer tessellation factors is not greater than zero (or is NaN), the patch is culled.
+    const auto primitiveMode =
+        static_cast<unsigned>(m_pipelineState->getShaderModes()->getTessellationMode().primitiveMode);
+    for (unsigned elemIdx = 0; elemIdx < ExpTessFactorCount[primitiveMode][0]; ++elemIdx) {
+      auto tessFactor = dyn_cast_or_null<ConstantFP>(constTessLevels[0][elemIdx]);
+      if (tessFactor && !(tessFactor->getValueAPF().convertToFloat() > 0.0f))
+        m_tessPatchAlwaysCulled = true;
+    }
+    m_constTessLevelOuter = std::move(constTessLevels[0]);
+  }
+  if (isConstant[1])
+    m_constTessLevelInner = std::move(constTessLevels[1]);
+}
+
+// =====================================================================================================================
+// Gets the value of a TES read of the tessellation factors that TCS writes as constants.
+//
+// @param inputTy : Type of input value
+// @param elemIdx : Index used for array element indexing (could be null)
+// @param constTessLevel : Constant elements of the tessellation factors (null if not written)
+// @param insertPos : Where to insert the patch instruction
+Value *PatchInOutImportExport::getConstantTessLevel(Type *inputTy, Value *elemIdx, ArrayRef<Constant *> constTessLevel,
+                                                    Instruction *insertPos) {
+  Type *elemTy = inputTy->isArrayTy() ? inputTy->getArrayElementType() : inputTy;
+  SmallVector<Constant *, 4> elems;
+  for (Constant *elem : constTessLevel)
+    elems.push_back(elem ? elem : UndefValue::get(elemTy));
+
+  if (!elemIdx) {
+    // gl_TessLevelOuter[4] / gl_TessLevelInner[2] is read as a whole
+    assert(inputTy->isArrayTy() && inputTy->getArrayNumElements() == elems.size());
+    return ConstantArray::get(cast<ArrayType>(inputTy), elems);
+  }
+  return ExtractElementInst::Create(ConstantVector::get(elems), elemIdx, "", insertPos);
+}
+
 // =====================================================================================================================
 // The process of handling the store of tessellation factors.
 // 1. Collect outer and inner tessellation factors from the corresponding callInst.
@@ -5717,8 +5960,6 @@ void PatchInOutImportExport::storeTessFactors() {
     return;
 
   BuilderBase builder(*m_context);
-  // Row 0 - Unknown, 1 - Triangle, 2 - Quad, 3 - Isoline.
-  static const unsigned expTessFactorCount[][2] = {{0, 0}, {3, 1}, {4, 2}, {2, 0}};
   const auto primitiveMode =
       static_cast<unsigned>(m_pipelineState->getShaderModes()->getTessellationMode().primitiveMode);
 
@@ -5734,7 +5975,7 @@ void PatchInOutImportExport::storeTessFactors() {
       Type *outputTy = output->getType();
       isOutputArray[i] = outputTy->isArrayTy();
       if (isOutputArray[i]) {
-        const unsigned tessFactorCount = expTessFactorCount[primitiveMode][i];
+        const unsigned tessFactorCount = ExpTessFactorCount[primitiveMode][i];
         for (unsigned elemIdx = 0; elemIdx < tessFactorCount; ++elemIdx) {
           auto elem = builder.CreateExtractValue(output, elemIdx);
           tessFactors->push_back(elem);
@@ -5760,8 +6001,10 @@ void PatchInOutImportExport::storeTessFactors() {
     tessFactors = &outerTessFactors;
     tessLevelInsts = m_tessLevelOuterInsts;
     for (unsigned i = 0; i < 2; ++i) {
-      // If tessellation factors are used as input of TES or TCS, they are required to write to LDS.
-      const bool needWriteToLds = perPatchBuiltInOutLocMap.count(builtInId) == 1;
+      // If tessellation factors are used as input of TES or TCS, they are required to write to LDS, unless they are
+      // constants that TES reads are folded to.
+      const bool isConstant = !(i == 0 ? m_constTessLevelOuter : m_constTessLevelInner).empty();
+      const bool needWriteToLds = perPatchBuiltInOutLocMap.count(builtInId) == 1 && !isConstant;
       if (needWriteToLds) {
         const unsigned loc = perPatchBuiltInOutLocMap[builtInId];
         if (isOutputArray[i]) {
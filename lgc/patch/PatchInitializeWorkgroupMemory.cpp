@@ -47,6 +47,29 @@ static cl::opt<bool>
                              cl::init(false));
 namespace lgc {
 
+// =====================================================================================================================
+// Check whether a workgroup variable might be read. A variable whose uses are all plain stores into it cannot observe
+// its initial value, so it does not need to be initialized.
+//
+// @param global : The workgroup variable
+// @returns : True if the variable might be read
+static bool mayReadWorkgroupVariable(GlobalVariable *global) {
+  SmallVector<Value *, 8> pointers;
+  pointers.push_back(global);
+  for (unsigned idx = 0; idx != pointers.size(); ++idx) {
+    for (User *user : pointers[idx]->users()) {
+      if (isa<GEPOperator>(user) || isa<BitCastOperator>(user) || isa<AddrSpaceCastOperator>(user)) {
+        pointers.push_back(user);
+        continue;
+      }
+      auto store = dyn_cast<StoreInst>(user);
+      if (!store || store->getPointerOperand() != pointers[idx])
+        return true;
+    }
+  }
+  return false;
+}
+
 // =====================================================================================================================
 // Initializes static members.
 char LegacyPatchInitializeWorkgroupMemory::ID = 0;
@@ -81,8 +104,11 @@ bool LegacyPatchInitializeWorkgroupMemory::runOnModule(Module &module) {
 PreservedAnalyses PatchInitializeWorkgroupMemory::run(Module &module, ModuleAnalysisManager &analysisManager) {
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
   PipelineShadersResult &pipelineShaders = analysisManager.getResult<PipelineShaders>(module);
-  if (runImpl(module, pipelineShaders, pipelineState))
-    return PreservedAnalyses::none();
+  if (runImpl(module, pipelineShaders, pipelineState)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
   return PreservedAnalyses::all();
 }
 
@@ -121,13 +147,23 @@ bool PatchInitializeWorkgroupMemory::runImpl(Module &module, PipelineShadersResu
   Instruction *insertPos = &*m_entryPoint->front().getFirstInsertionPt();
   builder.SetInsertPoint(insertPos);
 
+  // Put the variables that might be read first, so that only an LDS prefix needs initializing.
+  auto readGlobalsEnd =
+      std::stable_partition(workgroupGlobals.begin(), workgroupGlobals.end(), mayReadWorkgroupVariable);
+
   // Fill the map of each variable with zeroinitializer and calculate its corresponding offset on LDS
   unsigned offset = 0;
-  for (auto global : workgroupGlobals) {
+  unsigned initDwordSize = 0;
+  for (auto globalIt = workgroupGlobals.begin(); globalIt != workgroupGlobals.end(); ++globalIt) {
+    if (globalIt == readGlobalsEnd)
+      initDwordSize = offset;
+    GlobalVariable *global = *globalIt;
     unsigned varSize = getTypeSizeInDwords(global->getType()->getPointerElementType());
     m_globalLdsOffsetMap.insert({global, builder.getInt32(offset)});
     offset += varSize;
   }
+  if (readGlobalsEnd == workgroupGlobals.end())
+    initDwordSize = offset;
 
   // The new LDS is an i32 array
   const unsigned ldsSize = offset;
@@ -148,17 +184,20 @@ bool PatchInitializeWorkgroupMemory::runImpl(Module &module, PipelineShadersResu
     global->eraseFromParent();
   }
 
-  initializeWithZero(lds, builder);
+  if (initDwordSize != 0)
+    initializeWithZero(lds, initDwordSize, builder);
 
   return true;
 }
 
 // =====================================================================================================================
-// Initialize the given LDS variable with zero.
+// Initialize the start of the given LDS variable with zero.
 //
 // @param lds : The LDS variable to be initialized
+// @param initDwordSize : Size in dwords of the part of the LDS to initialize, a multiple of 4
 // @param builder : BuilderBase to use for instruction constructing
-void PatchInitializeWorkgroupMemory::initializeWithZero(GlobalVariable *lds, BuilderBase &builder) {
+void PatchInitializeWorkgroupMemory::initializeWithZero(GlobalVariable *lds, unsigned initDwordSize,
+                                                        BuilderBase &builder) {
   auto entryInsertPos = &*m_entryPoint->front().getFirstInsertionPt();
   auto originBlock = entryInsertPos->getParent();
   auto endInitBlock = originBlock->splitBasicBlock(entryInsertPos);
@@ -188,16 +227,18 @@ void PatchInitializeWorkgroupMemory::initializeWithZero(GlobalVariable *lds, Bui
   }
   originBlock->getTerminator()->replaceUsesOfWith(endInitBlock, forHeaderBlock);
 
-  // Each thread stores a zero to the continues LDS
+  // Each thread stores zero to 4 dwords at a time, with the stores striped across the workgroup so that the
+  // threads of a wave store to contiguous LDS
   // for (int loopIdx = 0; loopIdx < loopCount; ++loopIdx) {
-  //   if (threadId * loopCount + loopIdx < requiredNumThreads) {
-  //      unsigned ldsOffset = (threadId * loopCount) + loopIdx;
-  //      CreateStore(zero, ldsOffset);
+  //   if (loopIdx * actualNumThreads + threadId < requiredNumThreads) {
+  //      unsigned ldsOffset = (loopIdx * actualNumThreads + threadId) * 4;
+  //      CreateStore(<4 x i32> zero, ldsOffset);
   //   }
   //  }
 
   PHINode *loopIdxPhi = nullptr;
-  const unsigned requiredNumThreads = lds->getType()->getPointerElementType()->getArrayNumElements();
+  assert(initDwordSize % 4 == 0);
+  const unsigned requiredNumThreads = initDwordSize / 4;
   Value *loopCount = builder.getInt32((requiredNumThreads + actualNumThreads - 1) / actualNumThreads);
 
   // Construct ".for.Header" block
@@ -214,21 +255,22 @@ void PatchInitializeWorkgroupMemory::initializeWithZero(GlobalVariable *lds, Bui
   // Construct ".body" block
   {
     builder.SetInsertPoint(bodyBlock);
-    // The active thread is : threadId x loopCount + loopIdx < requiredNumThreads
-    Value *index = builder.CreateMul(threadId, loopCount);
-    index = builder.CreateAdd(index, loopIdxPhi);
+    // The active thread is : loopIdx x actualNumThreads + threadId < requiredNumThreads
+    Value *index = builder.CreateMul(loopIdxPhi, builder.getInt32(actualNumThreads));
+    index = builder.CreateAdd(index, threadId);
     Value *isActiveThread = builder.CreateICmpULT(index, builder.getInt32(requiredNumThreads));
     builder.CreateCondBr(isActiveThread, initBlock, endInitBlock);
 
     // Construct ".init" block
     {
       builder.SetInsertPoint(initBlock);
-      // ldsOffset = (threadId * loopCount) + loopIdx
-      Value *ldsOffset = builder.CreateMul(threadId, loopCount);
-      ldsOffset = builder.CreateAdd(ldsOffset, loopIdxPhi);
+      // ldsOffset = (loopIdx * actualNumThreads + threadId) * 4
+      Value *ldsOffset = builder.CreateShl(index, 2);
       Value *writePtr =
           builder.CreateGEP(lds->getType()->getPointerElementType(), lds, {builder.getInt32(0), ldsOffset});
-      builder.CreateAlignedStore(builder.getInt32(0), writePtr, Align(4));
+      auto storeTy = FixedVectorType::get(builder.getInt32Ty(), 4);
+      writePtr = builder.CreateBitCast(writePtr, storeTy->getPointerTo(ADDR_SPACE_LOCAL));
+      builder.CreateAlignedStore(Constant::getNullValue(storeTy), writePtr, Align(16));
 
       // Update loop index
       Value *loopNext = builder.CreateAdd(loopIdxPhi, builder.getInt32(1));
@@ -30,52 +30,169 @@
  */
 #include "PatchLlvmIrInclusion.h"
 #include "lgc/state/Abi.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 #define DEBUG_TYPE "lgc-patch-llvm-ir-inclusion"
 
 using namespace llvm;
 using namespace lgc;
 
-namespace lgc {
+namespace {
+
+// Forms of the LLVM IR included in the ELF
+enum class IrInclusionFormat {
+  Text,              // IR disassembly
+  Bitcode,           // Bitcode
+  CompressedBitcode, // Zlib compressed bitcode
+};
+
+} // anonymous namespace
+
+// -llvm-ir-inclusion-format: form of the LLVM IR included in the ELF
+static cl::opt<IrInclusionFormat> LlvmIrInclusionFormat(
+    "llvm-ir-inclusion-format", cl::desc("Form of the LLVM IR included in the ELF with -include-llvm-ir:"),
+    cl::init(IrInclusionFormat::Text),
+    cl::values(clEnumValN(IrInclusionFormat::Text, "text", "IR disassembly, in section .AMDGPU.comment.llvmir"),
+               clEnumValN(IrInclusionFormat::Bitcode, "bitcode", "bitcode, in section .AMDGPU.comment.llvmbc"),
+               clEnumValN(IrInclusionFormat::CompressedBitcode, "compressed-bitcode",
+                          "zlib compressed bitcode after its uncompressed size as a 64-bit little-endian value, in "
+                          "section .AMDGPU.comment.llvmbc.zlib")));
+
+// -llvm-ir-inclusion-stages: hardware shader stages whose entry-points are included in the ELF
+static cl::list<std::string> LlvmIrInclusionStages(
+    "llvm-ir-inclusion-stages",
+    cl::desc("With -include-llvm-ir, include only the entry-points of these hardware shader stages (ls, hs, es, gs, "
+             "vs, ps, cs) and the functions given by -llvm-ir-inclusion-functions"),
+    cl::CommaSeparated);
+
+// -llvm-ir-inclusion-functions: functions included in the ELF
+static cl::list<std::string> LlvmIrInclusionFunctions(
+    "llvm-ir-inclusion-functions",
+    cl::desc("With -include-llvm-ir, include only these functions and the entry-points given by "
+             "-llvm-ir-inclusion-stages"),
+    cl::CommaSeparated);
+
+namespace {
+
+// =====================================================================================================================
+// Legacy pass manager wrapper class
+class LegacyPatchLlvmIrInclusion : public ModulePass {
+public:
+  LegacyPatchLlvmIrInclusion() : ModulePass(ID) {}
+
+  bool runOnModule(Module &module) override { return m_impl.runImpl(module); }
+
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override { analysisUsage.setPreservesAll(); }
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchLlvmIrInclusion(const LegacyPatchLlvmIrInclusion &) = delete;
+  LegacyPatchLlvmIrInclusion &operator=(const LegacyPatchLlvmIrInclusion &) = delete;
+
+  PatchLlvmIrInclusion m_impl;
+};
+
+} // anonymous namespace
 
 // =====================================================================================================================
 // Initializes static members.
-char PatchLlvmIrInclusion::ID = 0;
+char LegacyPatchLlvmIrInclusion::ID = 0;
+
+namespace lgc {
 
 // =====================================================================================================================
 // Pass creator, creates the pass of LLVM patching operations of including LLVM IR as a separate section in the ELF.
-ModulePass *createPatchLlvmIrInclusion() {
-  return new PatchLlvmIrInclusion();
+ModulePass *createLegacyPatchLlvmIrInclusion() {
+  return new LegacyPatchLlvmIrInclusion();
 }
 
 // =====================================================================================================================
-PatchLlvmIrInclusion::PatchLlvmIrInclusion() : LegacyPatch(ID) {
+// Executes this patching pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchLlvmIrInclusion::run(Module &module, ModuleAnalysisManager &analysisManager) {
+  // Adding the global variable that holds the IR does not invalidate any analysis.
+  runImpl(module);
+  return PreservedAnalyses::all();
 }
 
 // =====================================================================================================================
 // Executes this patching pass on the specified LLVM module.
 //
 // This pass includes LLVM IR as a separate section in the ELF binary by inserting a new global variable with explicit
-// section.
+// section. With -llvm-ir-inclusion-stages or -llvm-ir-inclusion-functions, only the chosen function definitions are
+// included, so that the IR of a large pipeline does not have to be printed or written out in whole.
 //
 // @param [in/out] module : LLVM module to be run on
-bool PatchLlvmIrInclusion::runOnModule(Module &module) {
-  LegacyPatch::init(&module);
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchLlvmIrInclusion::runImpl(Module &module) {
+  Patch::init(&module);
+
+  // Find the function definitions to include, if only some are.
+  StringSet<> includedFunctions;
+  for (const std::string &stage : LlvmIrInclusionStages)
+    includedFunctions.insert("_amdgpu_" + stage + "_main");
+  for (const std::string &function : LlvmIrInclusionFunctions)
+    includedFunctions.insert(function);
+  auto isIncluded = [&](const GlobalValue *globalValue) {
+    return includedFunctions.empty() || !isa<Function>(globalValue) || includedFunctions.count(globalValue->getName());
+  };
+
+  SmallString<0> irData;
+  raw_svector_ostream irStream(irData);
+  StringRef sectionName = "llvmir";
+  if (LlvmIrInclusionFormat == IrInclusionFormat::Text) {
+    if (includedFunctions.empty()) {
+      irStream << *m_module;
+    } else {
+      for (Function &func : *m_module) {
+        if (!func.isDeclaration() && isIncluded(&func))
+          irStream << func;
+      }
+    }
+  } else {
+    // The bitcode is of a copy of the module in which the functions that are not included are declarations.
+    std::unique_ptr<Module> clonedModule;
+    if (!includedFunctions.empty()) {
+      ValueToValueMapTy valueMap;
+      clonedModule = CloneModule(*m_module, valueMap, isIncluded);
+    }
+    WriteBitcodeToFile(clonedModule ? *clonedModule : *m_module, irStream);
+    sectionName = "llvmbc";
 
-  std::string moduleStr;
-  raw_string_ostream llvmIr(moduleStr);
-  llvmIr << *m_module;
-  llvmIr.flush();
+    // Without zlib, the bitcode is included uncompressed.
+    if (LlvmIrInclusionFormat == IrInclusionFormat::CompressedBitcode && zlib::isAvailable()) {
+      SmallString<0> compressedBitcode;
+      if (!errorToBool(zlib::compress(irData, compressedBitcode))) {
+        SmallString<0> compressedData;
+        raw_svector_ostream compressedStream(compressedData);
+        support::endian::write(compressedStream, static_cast<uint64_t>(irData.size()), support::little);
+        compressedStream << compressedBitcode;
+        irData = std::move(compressedData);
+        sectionName = "llvmbc.zlib";
+      }
+    }
+  }
 
-  auto globalTy = ArrayType::get(Type::getInt8Ty(*m_context), moduleStr.size());
-  auto initializer = ConstantDataArray::getString(m_module->getContext(), moduleStr, false);
+  auto globalTy = ArrayType::get(Type::getInt8Ty(*m_context), irData.size());
+  auto initializer = ConstantDataArray::getString(m_module->getContext(), irData, false);
   auto global = new GlobalVariable(*m_module, globalTy, true, GlobalValue::ExternalLinkage, initializer, "llvmir",
                                    nullptr, GlobalValue::NotThreadLocal, false);
   assert(global);
 
   std::string namePrefix = Util::Abi::AmdGpuCommentName;
-  global->setSection(namePrefix + "llvmir");
+  global->setSection(namePrefix + sectionName.str());
 
   return true;
 }
@@ -84,5 +201,5 @@ bool PatchLlvmIrInclusion::runOnModule(Module &module) {
 
 // =====================================================================================================================
 // Initializes the pass of LLVM patching operations of including LLVM IR as a separate section in the ELF binary.
-INITIALIZE_PASS(PatchLlvmIrInclusion, DEBUG_TYPE, "Include LLVM IR as a separate section in the ELF binary", false,
-                false)
+INITIALIZE_PASS(LegacyPatchLlvmIrInclusion, DEBUG_TYPE, "Include LLVM IR as a separate section in the ELF binary",
+                false, false)
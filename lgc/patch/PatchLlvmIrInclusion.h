@@ -31,24 +31,19 @@
 #pragma once
 
 #include "lgc/patch/Patch.h"
+#include "llvm/IR/PassManager.h"
 
 namespace lgc {
 
 // =====================================================================================================================
 // Represents the pass of LLVM patch operations of including LLVM IR as a separate section in the ELF binary.
-class PatchLlvmIrInclusion : public LegacyPatch {
+class PatchLlvmIrInclusion : public Patch, public llvm::PassInfoMixin<PatchLlvmIrInclusion> {
 public:
-  PatchLlvmIrInclusion();
+  llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
 
-  bool runOnModule(llvm::Module &module) override;
+  bool runImpl(llvm::Module &module);
 
-  void getAnalysisUsage(llvm::AnalysisUsage &analysisUsage) const override { analysisUsage.setPreservesAll(); }
-
-  static char ID; // ID of this pass
-
-private:
-  PatchLlvmIrInclusion(const PatchLlvmIrInclusion &) = delete;
-  PatchLlvmIrInclusion &operator=(const PatchLlvmIrInclusion &) = delete;
+  static llvm::StringRef name() { return "Include LLVM IR as a separate section in the ELF binary"; }
 };
 
 } // namespace lgc
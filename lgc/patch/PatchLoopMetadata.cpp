@@ -30,7 +30,9 @@
  */
 #include "lgc/patch/PatchLoopMetadata.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include <vector>
@@ -40,6 +42,17 @@
 using namespace llvm;
 using namespace lgc;
 
+// -loop-unroll-target-occupancy: target waves per SIMD that unrolling of loops without an unroll directive is limited
+// to keep
+static cl::opt<unsigned>
+    LoopUnrollTargetOccupancy("loop-unroll-target-occupancy",
+                              cl::desc("Limit unrolling of loops without an unroll directive to keep the estimated "
+                                       "VGPR usage within the given waves per SIMD (0 to not limit it)"),
+                              cl::init(0));
+
+// Default unroll threshold of the AMDGPU target, above which there is no point in setting a loop's threshold
+static const unsigned DefaultUnrollThreshold = 300;
+
 namespace llvm {
 // A proxy from a ModuleAnalysisManager to a loop.
 typedef OuterAnalysisManagerProxy<ModuleAnalysisManager, Loop, LoopStandardAnalysisResults &>
@@ -225,6 +238,26 @@ bool PatchLoopMetadata::runImpl(Loop &loop, PipelineState *pipelineState) {
     }
   }
 
+  if (!changed && LoopUnrollTargetOccupancy != 0 && loop.isInnermost() && loopMetaNode->getNumOperands() <= 1) {
+    // The SPIR-V did not have an unroll directive. Limit how far the loop can be unrolled, if unrolling it further
+    // would be likely to take the VGPR usage over the occupancy target.
+    unsigned threshold = getOccupancyUnrollThreshold(loop, mPipelineState->getShaderWaveSize(stage));
+    if (threshold == 0) {
+      LLVM_DEBUG(dbgs() << "  disabling loop unroll to keep occupancy\n");
+      MDNode *disableLoopUnrollMetaNode =
+          MDNode::get(*m_context, MDString::get(*m_context, "llvm.loop.unroll.disable"));
+      loopMetaNode = MDNode::concatenate(loopMetaNode, MDNode::get(*m_context, disableLoopUnrollMetaNode));
+      changed = true;
+    } else if (threshold < DefaultUnrollThreshold) {
+      LLVM_DEBUG(dbgs() << "  setting amdgpu.loop.unroll.threshold " << threshold << " to keep occupancy\n");
+      Metadata *thresholdMeta[] = {MDString::get(*m_context, "amdgpu.loop.unroll.threshold"),
+                                   ConstantAsMetadata::get(ConstantInt::get(Type::getInt32Ty(*m_context), threshold))};
+      MDNode *thresholdMetaNode = MDNode::get(*m_context, thresholdMeta);
+      loopMetaNode = MDNode::concatenate(loopMetaNode, MDNode::get(*m_context, thresholdMetaNode));
+      changed = true;
+    }
+  }
+
   if (m_disableLicmThreshold > 0 && loop.getNumBlocks() >= m_disableLicmThreshold) {
     LLVM_DEBUG(dbgs() << "  disabling LICM\n");
     MDNode *licmDisableNode = MDNode::get(*m_context, MDString::get(*m_context, "llvm.licm.disable"));
@@ -239,6 +272,58 @@ bool PatchLoopMetadata::runImpl(Loop &loop, PipelineState *pipelineState) {
   return changed;
 }
 
+// =====================================================================================================================
+// Get the unroll threshold that keeps the estimated VGPR usage of the loop within the occupancy target, assuming that
+// the values live into the loop stay live throughout it, and that each unrolled copy of the body adds the values it
+// defines that are used outside their own block.
+//
+// @param loop : Loop to estimate
+// @param waveSize : Wave size of the shader
+// @returns : Unroll threshold (size of the unrolled loop) that keeps occupancy, 0 if the loop should not be unrolled,
+//            or UINT_MAX if it does not need limiting
+unsigned PatchLoopMetadata::getOccupancyUnrollThreshold(Loop &loop, unsigned waveSize) {
+  const DataLayout &dataLayout = loop.getHeader()->getModule()->getDataLayout();
+  auto getDwordSize = [&](Type *ty) -> unsigned {
+    if (!ty->isSized())
+      return 0;
+    return (dataLayout.getTypeStoreSize(ty).getFixedSize() + 3) / 4;
+  };
+
+  unsigned loopSize = 0;
+  unsigned liveInDwords = 0;
+  unsigned iterationDwords = 0;
+  SmallPtrSet<Value *, 16> liveIns;
+  for (BasicBlock *block : loop.blocks()) {
+    for (Instruction &inst : *block) {
+      ++loopSize;
+      for (Value *operand : inst.operands()) {
+        auto operandInst = dyn_cast<Instruction>(operand);
+        if ((isa<Argument>(operand) || (operandInst && !loop.contains(operandInst))) && liveIns.insert(operand).second)
+          liveInDwords += getDwordSize(operand->getType());
+      }
+      if (isa<PHINode>(inst) || any_of(inst.users(), [block](User *user) {
+            return isa<PHINode>(user) || cast<Instruction>(user)->getParent() != block;
+          }))
+        iterationDwords += getDwordSize(inst.getType());
+    }
+  }
+
+  // The number of VGPRs per lane in a SIMD, shared by the waves on it. GFX10+ has twice as many for wave32.
+  unsigned simdVgprs = 256;
+  if (m_gfxIp.major >= 10)
+    simdVgprs = waveSize == 32 ? 1024 : 512;
+  const unsigned vgprBudget = std::min(simdVgprs / LoopUnrollTargetOccupancy, 256U);
+  if (iterationDwords == 0)
+    return UINT_MAX;
+  if (liveInDwords + 2 * iterationDwords > vgprBudget)
+    return 0;
+
+  const unsigned maxUnrollCount = (vgprBudget - liveInDwords) / iterationDwords;
+  if (maxUnrollCount >= DefaultUnrollThreshold)
+    return UINT_MAX;
+  return loopSize * maxUnrollCount;
+}
+
 // =====================================================================================================================
 // Initializes the pass for patching Loop metadata.
 INITIALIZE_PASS(LegacyPatchLoopMetadata, DEBUG_TYPE, "Set or amend metadata to control loop unrolling", false, false)
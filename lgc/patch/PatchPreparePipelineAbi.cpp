@@ -32,7 +32,13 @@
 #include "Gfx6ConfigBuilder.h"
 #include "Gfx9ConfigBuilder.h"
 #include "ShaderMerger.h"
+#include "lgc/state/IntrinsDefs.h"
 #include "lgc/state/PalMetadata.h"
+#include "lgc/state/PipelineState.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Debug.h"
 
@@ -113,6 +119,8 @@ bool PatchPreparePipelineAbi::runImpl(Module &module, PipelineShadersResult &pip
     setCallingConvs(module);
     setRemainingCallingConvs(module);
   } else {
+    refineFragmentShaderUsage();
+
     if (m_gfxIp.major >= 9)
       mergeShaderAndSetCallingConvs(module);
     setRemainingCallingConvs(module);
@@ -358,6 +366,47 @@ void PatchPreparePipelineAbi::setAbiEntryNames(Module &module) {
   }
 }
 
+// =====================================================================================================================
+// Clear the discard and resource write usage of the fragment shader if its optimized code no longer has a kill or a
+// write to memory visible outside the shader. The usage is recorded by the Builder when the operations are created,
+// before optimizations may remove the code containing them, and it makes the config builder select late Z and set
+// KILL_ENABLE. A shader with only fence, export and private or LDS memory writes left can use early Z (or ReZ).
+void PatchPreparePipelineAbi::refineFragmentShaderUsage() {
+  Function *entryPoint = m_pipelineShaders->getEntryPoint(ShaderStageFragment);
+  if (!entryPoint)
+    return;
+  auto resUsage = m_pipelineState->getShaderResourceUsage(ShaderStageFragment);
+  auto &builtInUsage = resUsage->builtInUsage.fs;
+  if (!builtInUsage.discard && !resUsage->resourceWrite)
+    return;
+
+  bool hasKill = false;
+  bool hasWrite = false;
+  for (Instruction &inst : instructions(entryPoint)) {
+    if (auto call = dyn_cast<CallBase>(&inst)) {
+      const Intrinsic::ID intrinsicId = call->getIntrinsicID();
+      if (intrinsicId == Intrinsic::amdgcn_kill || intrinsicId == Intrinsic::amdgcn_wqm_demote) {
+        hasKill = true;
+        continue;
+      }
+      // A call to a function that is not inline leaves the usage as it is.
+      if (intrinsicId == Intrinsic::not_intrinsic && !call->isInlineAsm())
+        return;
+      if (call->mayWriteToMemory() && !call->onlyAccessesInaccessibleMemory())
+        hasWrite = true;
+    } else if (auto store = dyn_cast<StoreInst>(&inst)) {
+      const unsigned addrSpace = store->getPointerAddressSpace();
+      hasWrite |= addrSpace != ADDR_SPACE_PRIVATE && addrSpace != ADDR_SPACE_LOCAL;
+    } else if (!isa<FenceInst>(inst) && inst.mayWriteToMemory()) {
+      // An atomic, which is not filtered by address space, as LDS atomics are not expected in a fragment shader.
+      hasWrite = true;
+    }
+  }
+
+  builtInUsage.discard &= hasKill;
+  resUsage->resourceWrite &= hasWrite;
+}
+
 // =====================================================================================================================
 // Add ABI metadata
 //
@@ -30,11 +30,13 @@
  */
 #include "lgc/patch/PatchReadFirstLane.h"
 #include "lgc/patch/Patch.h"
+#include "lgc/state/Defs.h"
 #include "lgc/state/PipelineState.h"
 #include "llvm/Analysis/DivergenceAnalysis.h"
 #include "llvm/Analysis/LegacyDivergenceAnalysis.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicsAMDGPU.h"
@@ -164,6 +166,8 @@ bool PatchReadFirstLane::runImpl(Function &function, std::function<bool(const Us
 
   bool changed = promoteEqualUniformOps(function);
   changed |= liftReadFirstLane(function);
+  changed |= lowerUniformPermutes(function);
+  changed |= promoteUniformBranches(function);
   return changed;
 }
 
@@ -310,6 +314,70 @@ bool PatchReadFirstLane::liftReadFirstLane(Function &function) {
   return changed;
 }
 
+// =====================================================================================================================
+// Replace each ds_bpermute whose index is uniform with a readlane, as all lanes then read the same lane. The subgroup
+// builder only knows that a shuffle index is uniform when it is a constant; divergence analysis also finds the uniform
+// indices that are computed, such as ones loaded from a uniform buffer.
+//
+// @param [in,out] function : LLVM function to be run for the optimization.
+// @returns : True if any ds_bpermute was replaced
+bool PatchReadFirstLane::lowerUniformPermutes(Function &function) {
+  SmallVector<IntrinsicInst *, 4> uniformPermutes;
+  for (Instruction &inst : instructions(function)) {
+    auto intrinsic = dyn_cast<IntrinsicInst>(&inst);
+    if (intrinsic && intrinsic->getIntrinsicID() == Intrinsic::amdgcn_ds_bpermute &&
+        !m_isDivergentUse(intrinsic->getArgOperandUse(0)))
+      uniformPermutes.push_back(intrinsic);
+  }
+
+  BuilderBase builder(function.getContext());
+  for (IntrinsicInst *permute : uniformPermutes) {
+    builder.SetInsertPoint(permute);
+    // The ds_bpermute index is in bytes, so it is four times the lane to read.
+    Value *const lane = builder.CreateLShr(permute->getArgOperand(0), 2);
+    Value *const readlane =
+        builder.CreateIntrinsic(Intrinsic::amdgcn_readlane, {}, {permute->getArgOperand(1), lane});
+    readlane->takeName(permute);
+    permute->replaceAllUsesWith(readlane);
+    permute->eraseFromParent();
+  }
+  return !uniformPermutes.empty();
+}
+
+// =====================================================================================================================
+// Make each branch or switch condition that the front-end marked as uniform, such as one that the SPIR-V asserts to be
+// uniform in the subgroup, visibly uniform to divergence analysis where it could not prove that itself. The condition
+// is read from the first active lane, so the structurizer skips the region of the branch and instruction selection
+// generates a scalar branch with no exec mask manipulation.
+//
+// @param [in,out] function : LLVM function to be run for the optimization.
+// @returns : True if any condition was replaced
+bool PatchReadFirstLane::promoteUniformBranches(Function &function) {
+  SmallVector<Instruction *, 4> uniformBranches;
+  for (BasicBlock &block : function) {
+    Instruction *terminator = block.getTerminator();
+    auto branch = dyn_cast_or_null<BranchInst>(terminator);
+    if (!(branch && branch->isConditional()) && !isa_and_nonnull<SwitchInst>(terminator))
+      continue;
+    const Use &condition = terminator->getOperandUse(0);
+    auto conditionInst = dyn_cast<Instruction>(condition.get());
+    if (conditionInst && conditionInst->getMetadata(MetaNameUniform) &&
+        conditionInst->getType()->getPrimitiveSizeInBits() <= 32 && m_isDivergentUse(condition))
+      uniformBranches.push_back(terminator);
+  }
+
+  BuilderBase builder(function.getContext());
+  for (Instruction *terminator : uniformBranches) {
+    builder.SetInsertPoint(terminator);
+    Value *condition = terminator->getOperand(0);
+    Value *uniformCondition = builder.CreateZExt(condition, builder.getInt32Ty());
+    uniformCondition = builder.CreateIntrinsic(Intrinsic::amdgcn_readfirstlane, {}, uniformCondition);
+    uniformCondition = builder.CreateTrunc(uniformCondition, condition->getType());
+    terminator->setOperand(0, uniformCondition);
+  }
+  return !uniformBranches.empty();
+}
+
 // =====================================================================================================================
 // The decision of whether an instruction should be added to the m_canAssumeUniformDivergentUseMap is only made once all
 // later instructions in the basic block have been processed. To avoid scanning all instructions excessively, we
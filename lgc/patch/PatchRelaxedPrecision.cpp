@@ -0,0 +1,349 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchRelaxedPrecision.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchRelaxedPrecision.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchRelaxedPrecision.h"
+#include "lgc/patch/Patch.h"
+#include "lgc/state/PipelineState.h"
+#include "lgc/state/TargetInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "lgc-patch-relaxed-precision"
+
+using namespace lgc;
+using namespace llvm;
+
+namespace {
+class LegacyPatchRelaxedPrecision final : public FunctionPass {
+public:
+  LegacyPatchRelaxedPrecision();
+
+  virtual bool runOnFunction(Function &function) override;
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override;
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchRelaxedPrecision(const LegacyPatchRelaxedPrecision &) = delete;
+  LegacyPatchRelaxedPrecision &operator=(const LegacyPatchRelaxedPrecision &) = delete;
+
+  PatchRelaxedPrecision m_impl;
+};
+
+// Number of operations in a chain of relaxed precision operations, and number of conversions that doing the chain in
+// 16-bit floats needs
+struct ChainCost {
+  unsigned opCount;
+  unsigned conversionCount;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchRelaxedPrecision::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for relaxed precision math in 16-bit floats.
+FunctionPass *lgc::createLegacyPatchRelaxedPrecision() {
+  return new LegacyPatchRelaxedPrecision();
+}
+
+// =====================================================================================================================
+LegacyPatchRelaxedPrecision::LegacyPatchRelaxedPrecision() : FunctionPass(ID) {
+}
+
+// =====================================================================================================================
+// Get the analysis usage of this pass.
+//
+// @param [out] analysisUsage : The analysis usage.
+void LegacyPatchRelaxedPrecision::getAnalysisUsage(AnalysisUsage &analysisUsage) const {
+  analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+  analysisUsage.setPreservesCFG();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will do relaxed precision math in
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchRelaxedPrecision::runOnFunction(Function &function) {
+  PipelineState *pipelineState = getAnalysis<LegacyPipelineStateWrapper>().getPipelineState(function.getParent());
+  return m_impl.runImpl(function, pipelineState);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will do relaxed precision math in
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchRelaxedPrecision::run(Function &function, FunctionAnalysisManager &analysisManager) {
+  const auto &moduleAnalysisManager = analysisManager.getResult<ModuleAnalysisManagerFunctionProxy>(function);
+  PipelineState *pipelineState =
+      moduleAnalysisManager.getCachedResult<PipelineStateWrapper>(*function.getParent())->getPipelineState();
+  if (!runImpl(function, pipelineState))
+    return PreservedAnalyses::all();
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserveSet<CFGAnalyses>();
+  return preservedAnalyses;
+}
+
+// =====================================================================================================================
+// Check whether the float modes of a shader allow its 32-bit float math to be done in 16-bit floats. The rounding
+// modes must be round to nearest even, which the 16-bit operations would also do, and the shader must not ask for
+// 32-bit denormals to be kept. Flushing 16-bit denormals is within what relaxed precision allows.
+//
+// @param shaderMode : Common shader mode of the shader
+// @returns : True if the 32-bit float math may be done in 16-bit floats
+static bool isFloatModeCompatible(const CommonShaderMode &shaderMode) {
+  auto isRoundToNearest = [](FpRoundMode roundMode) {
+    return roundMode == FpRoundMode::DontCare || roundMode == FpRoundMode::Even;
+  };
+  return isRoundToNearest(shaderMode.fp16RoundMode) && isRoundToNearest(shaderMode.fp32RoundMode) &&
+         shaderMode.fp32DenormMode != FpDenormMode::FlushNone;
+}
+
+// =====================================================================================================================
+// Check whether an instruction is a 32-bit float operation that has a packed 16-bit equivalent.
+//
+// @param inst : Instruction to check
+// @returns : True if the operation can be done in 16-bit floats
+static bool isDemotableOp(const Instruction &inst) {
+  if (!inst.getType()->getScalarType()->isFloatTy())
+    return false;
+  switch (inst.getOpcode()) {
+  case Instruction::FAdd:
+  case Instruction::FSub:
+  case Instruction::FMul:
+  case Instruction::FNeg:
+    return true;
+  default:
+    break;
+  }
+  if (auto intrinsic = dyn_cast<IntrinsicInst>(&inst)) {
+    switch (intrinsic->getIntrinsicID()) {
+    case Intrinsic::fma:
+    case Intrinsic::fmuladd:
+    case Intrinsic::minnum:
+    case Intrinsic::maxnum:
+      return true;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+// =====================================================================================================================
+// Get the float operands of an operation accepted by isDemotableOp.
+//
+// @param inst : The operation
+// @returns : The operands, without the callee of an intrinsic call
+static iterator_range<Use *> getFloatOperands(Instruction *inst) {
+  if (auto call = dyn_cast<CallInst>(inst))
+    return call->args();
+  return inst->operands();
+}
+
+// =====================================================================================================================
+// Get the 16-bit float type with the same shape as a 32-bit float type.
+//
+// @param floatTy : The 32-bit float scalar or vector type
+// @returns : The 16-bit float type
+static Type *getHalfType(Type *floatTy) {
+  Type *halfTy = Type::getHalfTy(floatTy->getContext());
+  if (auto vecTy = dyn_cast<FixedVectorType>(floatTy))
+    return FixedVectorType::get(halfTy, vecTy->getNumElements());
+  return halfTy;
+}
+
+// =====================================================================================================================
+// Check whether a value is the extension of a 16-bit float value, which a demoted operation can use directly.
+//
+// @param value : Value to check
+// @returns : True if the value is an fpext from a 16-bit float type
+static bool isHalfExtension(Value *value) {
+  auto ext = dyn_cast<FPExtInst>(value);
+  return ext && ext->getSrcTy() == getHalfType(ext->getType());
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM function.
+//
+// @param [in/out] function : Function that we will do relaxed precision math in
+// @param pipelineState : Pipeline state
+// @returns : True if the function was modified by the transformation and false otherwise
+bool PatchRelaxedPrecision::runImpl(Function &function, PipelineState *pipelineState) {
+  // Packed 16-bit float math is available from GFX9.
+  if (pipelineState->getTargetInfo().getGfxIpVersion().major < 9)
+    return false;
+  const ShaderStage shaderStage = getShaderStage(&function);
+  if (shaderStage == ShaderStageInvalid ||
+      !isFloatModeCompatible(pipelineState->getShaderModes()->getCommonShaderMode(shaderStage)))
+    return false;
+
+  // Gather the relaxed precision operations, and join the ones that use each other into chains.
+  const unsigned relaxedPrecisionKind = function.getContext().getMDKindID(RelaxedPrecisionMetadataName);
+  SmallVector<Instruction *, 16> ops;
+  SmallPtrSet<Instruction *, 16> opSet;
+  EquivalenceClasses<Instruction *> chains;
+  for (Instruction &inst : instructions(function)) {
+    if (inst.getMetadata(relaxedPrecisionKind) && isDemotableOp(inst)) {
+      ops.push_back(&inst);
+      opSet.insert(&inst);
+      chains.insert(&inst);
+    }
+  }
+  if (ops.empty())
+    return false;
+  for (Instruction *op : ops) {
+    for (Value *operand : getFloatOperands(op)) {
+      auto operandInst = dyn_cast<Instruction>(operand);
+      if (operandInst && opSet.count(operandInst))
+        chains.unionSets(op, operandInst);
+    }
+  }
+
+  // Count the operations of each chain, and the conversions it needs: one truncation for each distinct input that is
+  // neither a constant nor an extension from 16 bits, and one extension for each operation used outside the chain.
+  DenseMap<Instruction *, ChainCost> chainCosts;
+  DenseSet<std::pair<Instruction *, Value *>> chainInputs;
+  for (Instruction *op : ops) {
+    Instruction *leader = chains.getLeaderValue(op);
+    ChainCost &cost = chainCosts[leader];
+    ++cost.opCount;
+    for (Value *operand : getFloatOperands(op)) {
+      auto operandInst = dyn_cast<Instruction>(operand);
+      if ((operandInst && opSet.count(operandInst)) || isa<Constant>(operand) || isHalfExtension(operand))
+        continue;
+      if (chainInputs.insert({leader, operand}).second)
+        ++cost.conversionCount;
+    }
+    if (any_of(op->users(), [&](User *user) { return !opSet.count(cast<Instruction>(user)); }))
+      ++cost.conversionCount;
+  }
+
+  // Only demote the chains that save more operations than their conversions cost.
+  SmallPtrSet<Instruction *, 16> demotedSet;
+  for (Instruction *op : ops) {
+    const ChainCost &cost = chainCosts[chains.getLeaderValue(op)];
+    if (cost.opCount > cost.conversionCount)
+      demotedSet.insert(op);
+  }
+  if (demotedSet.empty())
+    return false;
+
+  // Get the 16-bit version of an input of a demoted operation, truncating it just after its definition.
+  DenseMap<Value *, Value *> halfValues;
+  IRBuilder<> builder(function.getContext());
+  auto getHalfValue = [&](Value *value) -> Value * {
+    auto it = halfValues.find(value);
+    if (it != halfValues.end())
+      return it->second;
+    Type *halfTy = getHalfType(value->getType());
+    Value *halfValue = nullptr;
+    if (auto constant = dyn_cast<Constant>(value))
+      halfValue = ConstantExpr::getFPTrunc(constant, halfTy);
+    else if (isHalfExtension(value))
+      halfValue = cast<FPExtInst>(value)->getOperand(0);
+    else {
+      IRBuilder<>::InsertPointGuard guard(builder);
+      if (auto inst = dyn_cast<Instruction>(value)) {
+        if (isa<PHINode>(inst))
+          builder.SetInsertPoint(&*inst->getParent()->getFirstInsertionPt());
+        else
+          builder.SetInsertPoint(inst->getNextNode());
+      } else
+        builder.SetInsertPoint(&*function.getEntryBlock().getFirstInsertionPt());
+      halfValue = builder.CreateFPTrunc(value, halfTy);
+    }
+    halfValues[value] = halfValue;
+    return halfValue;
+  };
+
+  // Create the 16-bit operations in reverse post order, so the 16-bit versions of their operands are created first.
+  // Operations in unreachable blocks are left alone.
+  SmallVector<Instruction *, 16> demotedOps;
+  SmallPtrSet<Instruction *, 16> demotedOpSet;
+  ReversePostOrderTraversal<Function *> rpot(&function);
+  for (BasicBlock *block : rpot) {
+    for (Instruction &inst : *block) {
+      if (!demotedSet.count(&inst))
+        continue;
+      SmallVector<Value *, 3> halfOperands;
+      for (Value *operand : getFloatOperands(&inst))
+        halfOperands.push_back(getHalfValue(operand));
+
+      builder.SetInsertPoint(&inst);
+      Value *halfOp = nullptr;
+      if (auto intrinsic = dyn_cast<IntrinsicInst>(&inst))
+        halfOp = builder.CreateIntrinsic(intrinsic->getIntrinsicID(), halfOperands[0]->getType(), halfOperands);
+      else if (isa<UnaryOperator>(inst))
+        halfOp = builder.CreateUnOp(static_cast<Instruction::UnaryOps>(inst.getOpcode()), halfOperands[0]);
+      else
+        halfOp = builder.CreateBinOp(static_cast<Instruction::BinaryOps>(inst.getOpcode()), halfOperands[0],
+                                     halfOperands[1]);
+      if (auto halfInst = dyn_cast<Instruction>(halfOp))
+        halfInst->copyFastMathFlags(&inst);
+      halfValues[&inst] = halfOp;
+      demotedOps.push_back(&inst);
+      demotedOpSet.insert(&inst);
+    }
+  }
+
+  // Extend the results that are used outside the demoted chains back to 32 bits, and erase the 32-bit operations.
+  for (Instruction *op : demotedOps) {
+    if (all_of(op->users(), [&](User *user) { return demotedOpSet.count(cast<Instruction>(user)); }))
+      continue;
+    builder.SetInsertPoint(op->getNextNode());
+    Value *ext = builder.CreateFPExt(halfValues[op], op->getType());
+    ext->takeName(op);
+    op->replaceUsesWithIf(ext, [&](Use &use) { return !demotedOpSet.count(cast<Instruction>(use.getUser())); });
+  }
+  for (Instruction *op : demotedOps)
+    op->dropAllReferences();
+  for (Instruction *op : demotedOps)
+    op->eraseFromParent();
+  LLVM_DEBUG(dbgs() << "Demoted " << demotedOps.size() << " relaxed precision operations to 16-bit floats\n");
+  return true;
+}
+
+// =====================================================================================================================
+// Initializes the pass of LLVM patching operations for relaxed precision math in 16-bit floats.
+INITIALIZE_PASS(LegacyPatchRelaxedPrecision, DEBUG_TYPE, "Patch LLVM for relaxed precision math in 16-bit floats",
+                false, false)
@@ -55,6 +55,58 @@ using namespace lgc;
 // -disable-gs-onchip: disable geometry shader on-chip mode
 cl::opt<bool> DisableGsOnChip("disable-gs-onchip", cl::desc("Disable geometry shader on-chip mode"), cl::init(false));
 
+// -gs-offchip-efficiency: throughput of GS with an off-chip GS-VS ring relative to on-chip, in percent
+static cl::opt<unsigned> GsOffChipEfficiency("gs-offchip-efficiency",
+                                             cl::desc("Throughput of a GS primitive with the GS-VS ring off chip "
+                                                      "relative to on chip, in percent (0 to use the default of the "
+                                                      "GFX IP)"),
+                                             cl::init(0));
+
+namespace {
+
+// Tuning of the choice between on-chip and off-chip GS-VS ring for a GFX IP major version
+struct GsOnChipTuning {
+  unsigned majorVersion;             // GFX IP major version
+  unsigned ldsSizePerCu;             // LDS size per CU in dwords
+  unsigned maxSubgroupsPerCu;        // Maximum count of GS subgroups resident in a CU
+  unsigned offChipEfficiencyPercent; // Throughput of a GS primitive with the GS-VS ring off chip relative to on chip
+};
+
+// The last entry also applies to the later GFX IP versions. The efficiencies are starting points, to be refined with
+// -gs-offchip-efficiency on the content that the choice matters for.
+static const GsOnChipTuning GsOnChipTunings[] = {
+    {9, 16384, 16, 50},
+    {10, 16384, 16, 50},
+};
+
+// =====================================================================================================================
+// Gets the tuning of the choice between on-chip and off-chip GS-VS ring for the given GFX IP major version.
+//
+// @param majorVersion : GFX IP major version, 9 or later
+const GsOnChipTuning &getGsOnChipTuning(unsigned majorVersion) {
+  for (const GsOnChipTuning &tuning : GsOnChipTunings) {
+    if (tuning.majorVersion == majorVersion)
+      return tuning;
+  }
+  return GsOnChipTunings[array_lengthof(GsOnChipTunings) - 1];
+}
+
+// =====================================================================================================================
+// Estimates the count of GS primitives that are in flight in a CU, when the count of resident GS subgroups is limited
+// by their LDS use.
+//
+// @param primsPerSubgroup : GS primitives per subgroup, including those of all GS instances
+// @param ldsSizePerSubgroup : LDS size per subgroup in dwords
+// @param tuning : Tuning of the GFX IP
+unsigned estimateGsPrimsInFlight(unsigned primsPerSubgroup, unsigned ldsSizePerSubgroup, const GsOnChipTuning &tuning) {
+  unsigned subgroups = tuning.maxSubgroupsPerCu;
+  if (ldsSizePerSubgroup != 0)
+    subgroups = std::min(subgroups, tuning.ldsSizePerCu / ldsSizePerSubgroup);
+  return primsPerSubgroup * subgroups;
+}
+
+} // anonymous namespace
+
 namespace lgc {
 
 // =====================================================================================================================
@@ -96,7 +148,9 @@ PreservedAnalyses PatchResourceCollect::run(Module &module, ModuleAnalysisManage
   PipelineShadersResult &pipelineShaders = analysisManager.getResult<PipelineShaders>(module);
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
   runImpl(module, pipelineShaders, pipelineState);
-  return PreservedAnalyses::none();
+  PreservedAnalyses preservedAnalyses;
+  preservedAnalyses.preserve<PipelineShaders>();
+  return preservedAnalyses;
 }
 
 // =====================================================================================================================
@@ -218,6 +272,7 @@ void PatchResourceCollect::setNggControl(Module *module) {
   nggControl.subgroupSizing = options.nggSubgroupSizing;
   nggControl.primsPerSubgroup = std::min(options.nggPrimsPerSubgroup, Gfx9::NggMaxThreadsPerSubgroup);
   nggControl.vertsPerSubgroup = std::min(options.nggVertsPerSubgroup, Gfx9::NggMaxThreadsPerSubgroup);
+  nggControl.vertsPerPrimHint = options.nggVertsPerPrimHint;
 
   if (nggControl.enableNgg) {
     if (options.nggFlags & NggFlagForceCullingMode)
@@ -279,12 +334,16 @@ void PatchResourceCollect::setNggControl(Module *module) {
     case NggSubgroupSizing::Explicit:
       LLPC_OUTS("Explicit\n");
       break;
+    case NggSubgroupSizing::Adaptive:
+      LLPC_OUTS("Adaptive\n");
+      break;
     default:
       llvm_unreachable("Should never be called!");
       break;
     }
     LLPC_OUTS("PrimsPerSubgroup             = " << nggControl.primsPerSubgroup << "\n");
     LLPC_OUTS("VertsPerSubgroup             = " << nggControl.vertsPerSubgroup << "\n");
+    LLPC_OUTS("VertsPerPrimHint             = " << nggControl.vertsPerPrimHint << "\n");
     LLPC_OUTS("\n");
   }
 }
@@ -586,6 +645,16 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
       const unsigned gsVsRingItemSize =
           hasGs ? std::max(1u, 4 * gsResUsage->inOutUsage.outputMapLocCount * geometryMode.outputVertices) : 0;
 
+      // If GS emits at most one vertex and output vertices are not compacted (and so not culled), the vertex emitted by
+      // a thread is exported by the same thread. If the vertex is also small, its outputs are kept in registers across
+      // the export rather than written to and read back from GS-VS ring, and GS-VS ring takes no LDS.
+      static const unsigned MaxGsOutputLocsInRegs = 4;
+      const bool gsOutputsInRegs =
+          hasGs && geometryMode.outputVertices == 1 && nggControl->passthroughMode &&
+          nggControl->compactMode == NggCompactDisable && !gsResUsage->inOutUsage.enableXfb &&
+          gsResUsage->inOutUsage.outputMapLocCount <= MaxGsOutputLocsInRegs;
+      const unsigned gsVsLdsItemSize = gsOutputsInRegs ? 0 : gsVsRingItemSize;
+
       const unsigned esExtraLdsSize = NggLdsManager::calcEsExtraLdsSize(m_pipelineState) / 4; // In dwords
       const unsigned gsExtraLdsSize = NggLdsManager::calcGsExtraLdsSize(m_pipelineState) / 4; // In dwords
 
@@ -617,6 +686,28 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
         esVertsPerSubgroup = nggControl->vertsPerSubgroup;
         gsPrimsPerSubgroup = nggControl->primsPerSubgroup;
         break;
+      case NggSubgroupSizing::Adaptive:
+        // A subgroup ends when either its vertex count or its primitive count reaches the limit, so the limits are
+        // set in the measured ratio of vertices to primitives. The side that runs out first then gets the full
+        // subgroup, and the other side is not cut short before it. The hint does not describe the domain points that
+        // tessellation produces, so Auto is used for that, as it is when there is no measurement.
+        if (nggControl->vertsPerPrimHint != 0 && !hasTs) {
+          // Allow for the vertices of the first primitive, which are not shared with an earlier one.
+          const unsigned firstPrimVerts = m_pipelineState->getVerticesPerPrimitive();
+          const unsigned vertsPerPrimHint = nggControl->vertsPerPrimHint;
+          if (vertsPerPrimHint <= 100) {
+            gsPrimsPerSubgroup = Gfx9::NggMaxThreadsPerSubgroup;
+            esVertsPerSubgroup = std::min(Gfx9::NggMaxThreadsPerSubgroup,
+                                          (Gfx9::NggMaxThreadsPerSubgroup * vertsPerPrimHint + 99) / 100 +
+                                              firstPrimVerts);
+          } else {
+            esVertsPerSubgroup = Gfx9::NggMaxThreadsPerSubgroup;
+            gsPrimsPerSubgroup =
+                std::max(1u, (Gfx9::NggMaxThreadsPerSubgroup - firstPrimVerts) * 100 / vertsPerPrimHint);
+          }
+          break;
+        }
+        LLVM_FALLTHROUGH;
       case NggSubgroupSizing::Auto:
         if (m_pipelineState->getTargetInfo().getGfxIpVersion() == GfxIpVersion{10, 1}) {
           esVertsPerSubgroup = Gfx9::NggMaxThreadsPerSubgroup / 2 - 2;
@@ -655,11 +746,11 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
 
         // The equation for required LDS is:
         // LDS allocation = (esGsRingItemSize * esVertsPerSubgroup) +
-        //                  (gsVsRingItemSize * gsInstanceCount * gsPrimsPerSubgroup) +
+        //                  (gsVsLdsItemSize * gsInstanceCount * gsPrimsPerSubgroup) +
         //                  extraLdsSize
         gsPrimsPerSubgroup = std::min(
             gsPrimsPerSubgroup, (gsMaxLdsSize - esExtraLdsSize - gsExtraLdsSize) /
-                                    ((esGsRingItemSize * vertsPerPrimitive) + (gsVsRingItemSize * gsInstanceCount)));
+                                    ((esGsRingItemSize * vertsPerPrimitive) + (gsVsLdsItemSize * gsInstanceCount)));
 
         // Let's take into consideration instancing:
         assert(gsInstanceCount >= 1);
@@ -684,7 +775,7 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
       }
 
       unsigned expectedEsLdsSize = esVertsPerSubgroup * esGsRingItemSize + esExtraLdsSize;
-      unsigned expectedGsLdsSize = gsPrimsPerSubgroup * gsInstanceCount * gsVsRingItemSize + gsExtraLdsSize;
+      unsigned expectedGsLdsSize = gsPrimsPerSubgroup * gsInstanceCount * gsVsLdsItemSize + gsExtraLdsSize;
 
       const unsigned ldsSizeDwordGranularity =
           1u << m_pipelineState->getTargetInfo().getGpuProperty().ldsSizeDwordGranularityShift;
@@ -707,7 +798,7 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
         gsPrimsPerSubgroup =
             std::min(gsPrimsPerSubgroup, (maxHwGsLdsSizeDwords - esExtraLdsSize - gsExtraLdsSize) /
                                              (static_cast<unsigned>(esGsRingItemSize * esVertToGsPrimRatio) +
-                                              (gsVsRingItemSize * gsInstanceCount)));
+                                              (gsVsLdsItemSize * gsInstanceCount)));
 
         // Make sure that we have at least one primitive.
         gsPrimsPerSubgroup = std::max(1u, gsPrimsPerSubgroup);
@@ -719,10 +810,21 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
 
         // And then recalculate our LDS usage.
         expectedEsLdsSize = (esVertsPerSubgroup * esGsRingItemSize) + esExtraLdsSize;
-        expectedGsLdsSize = (gsPrimsPerSubgroup * gsInstanceCount * gsVsRingItemSize) + gsExtraLdsSize;
+        expectedGsLdsSize = (gsPrimsPerSubgroup * gsInstanceCount * gsVsLdsItemSize) + gsExtraLdsSize;
         ldsSizeDwords = alignTo(expectedEsLdsSize + expectedGsLdsSize, ldsSizeDwordGranularity);
       }
 
+      if (hasGs) {
+        // The GS LDS regions that are never live at the same time share LDS (see NggLdsManager::planGsLdsLayout), so
+        // the LDS needed can be less than the sum of the region sizes used above.
+        const unsigned esGsRingLdsSize = alignTo(expectedEsLdsSize, 4u) * SizeOfDword;
+        const unsigned gsVsRingLdsSize = gsPrimsPerSubgroup * gsInstanceCount * gsVsLdsItemSize * SizeOfDword;
+        const unsigned plannedLdsSizeDwords =
+            alignTo((NggLdsManager::planGsLdsLayout(m_pipelineState, esGsRingLdsSize) + gsVsRingLdsSize) / SizeOfDword,
+                    ldsSizeDwordGranularity);
+        ldsSizeDwords = std::min(ldsSizeDwords, plannedLdsSizeDwords);
+      }
+
       // Make sure we don't allocate more than what can legally be allocated by a single subgroup on the hardware.
       assert(ldsSizeDwords <= maxHwGsLdsSizeDwords);
 
@@ -745,6 +847,7 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
 
       gsResUsage->inOutUsage.gs.calcFactor.primAmpFactor = primAmpFactor;
       gsResUsage->inOutUsage.gs.calcFactor.enableMaxVertOut = enableMaxVertOut;
+      gsResUsage->inOutUsage.gs.calcFactor.gsOutputsInRegs = gsOutputsInRegs;
 
       gsOnChip = true; // In NGG mode, GS is always on-chip since copy shader is not present.
     } else {
@@ -837,12 +940,10 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
         unsigned onchipEsGsLdsSizeOnchipGsVs = esGsLdsSize;
 
         if (onchipEsGsVsLdsSize > maxLdsSize) {
-          // TODO: This code only allocates the minimum required LDS to hit the on chip GS prims per subgroup
-          //       threshold. This leaves some LDS space unused. The extra space could potentially be used to
-          //       increase the GS Prims per subgroup.
-
-          // Set the threshold at the minimum to keep things on chip.
-          onchipGsPrimsPerSubgroup = maxGsPrimsPerSubgroup;
+          // The target GS prims per subgroup do not fit with GSVS data on chip as well. Use the most GS prims per
+          // subgroup that do fit; whether that is better than the GSVS ring off chip is decided below.
+          const unsigned ldsSizePerPrim = esGsRingItemSize * esMinVertsPerSubgroup * reuseOffMultiplier + gsVsItemSize;
+          onchipGsPrimsPerSubgroup = std::min(maxLdsSize / ldsSizePerPrim, gsPrimsPerSubgroup);
 
           if (onchipGsPrimsPerSubgroup > 0) {
             worstCaseEsVertsPerSubgroup =
@@ -865,6 +966,21 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
           }
         }
 
+        if (gsOnChip) {
+          // Keeping GSVS data on chip saves its round trip through memory, but takes LDS, so that fewer or smaller GS
+          // subgroups are in flight in a CU. Estimate the GS primitives in flight both ways, and only keep GSVS data on
+          // chip if the saving outweighs the loss.
+          const GsOnChipTuning &tuning = getGsOnChipTuning(m_pipelineState->getTargetInfo().getGfxIpVersion().major);
+          const unsigned offChipEfficiencyPercent =
+              GsOffChipEfficiency != 0 ? GsOffChipEfficiency : tuning.offChipEfficiencyPercent;
+          const unsigned onChipPrimsInFlight =
+              estimateGsPrimsInFlight(onchipGsPrimsPerSubgroup * gsInstanceCount, onchipEsGsVsLdsSize, tuning);
+          const unsigned offChipPrimsInFlight =
+              estimateGsPrimsInFlight(gsPrimsPerSubgroup * gsInstanceCount, gsOnChipLdsSize, tuning);
+          if (uint64_t(onChipPrimsInFlight) * 100 < uint64_t(offChipPrimsInFlight) * offChipEfficiencyPercent)
+            gsOnChip = false;
+        }
+
         // If on chip GSVS is optimal, update the ESGS parameters with any changes that allowed for GSVS data.
         if (gsOnChip) {
           gsOnChipLdsSize = onchipEsGsVsLdsSize;
@@ -962,6 +1078,8 @@ bool PatchResourceCollect::checkGsOnChipValidity() {
       LLPC_OUTS("GS primitive amplification factor: " << gsResUsage->inOutUsage.gs.calcFactor.primAmpFactor << "\n");
       LLPC_OUTS("GS enable max output vertices per instance: "
                 << (gsResUsage->inOutUsage.gs.calcFactor.enableMaxVertOut ? "true" : "false") << "\n");
+      LLPC_OUTS("GS outputs in registers: "
+                << (gsResUsage->inOutUsage.gs.calcFactor.gsOutputsInRegs ? "true" : "false") << "\n");
       LLPC_OUTS("\n");
 
       LLPC_OUTS("GS is on-chip (NGG)\n");
@@ -2517,6 +2635,17 @@ void PatchResourceCollect::updateInputLocInfoMapWithPack() {
   // Create locationMap according to the packable calls
   m_locationInfoMapManager->createMap(packableCalls, m_shaderStage, requireDword);
 
+  if (isFs) {
+    // Report the param cache usage and interpolation cost of the packing.
+    const auto &packingCost = m_locationInfoMapManager->getPackingCost();
+    inOutUsage.packedParamCount = packingCost.locationCount;
+    inOutUsage.packedParamComponentCount = packingCost.componentCount;
+    inOutUsage.packedInterpInstCount = packingCost.interpInstCount;
+    LLVM_DEBUG(dbgs() << "FS inputs packed into " << packingCost.locationCount << " params with "
+                      << packingCost.componentCount << " components used, needing about "
+                      << packingCost.interpInstCount << " interpolation instructions\n");
+  }
+
   // Fill inputLocInfoMap of {TCS, GS, FS} for the packable calls
   unsigned newLocIdx = 0;
   for (auto call : packableCalls) {
@@ -3071,6 +3200,7 @@ void InOutLocationInfoMapManager::buildMap(ShaderStage shaderStage) {
   std::sort(m_locationSpans.begin(), m_locationSpans.end());
 
   m_locationInfoMap.clear();
+  m_packingCost = {};
 
   // Map original InOutLocationInfo to new InOutLocationInfo
   unsigned consectiveLocation = 0;
@@ -3118,6 +3248,23 @@ void InOutLocationInfoMapManager::buildMap(ShaderStage shaderStage) {
     newLocInfo.setStreamId(spanIt->firstLocationInfo.getStreamId());
     m_locationInfoMap.insert({spanIt->firstLocationInfo, newLocInfo});
 
+    // Account for the cost. The spans that are compatible share the params, so this is a cost of the packing
+    // rather than a choice in it: flat, custom and 16-bit interpolation are set per param by SPI_PS_INPUT_CNTL, so
+    // each class needs its own params anyway. In FS, a smooth span needs two interpolation instructions (P1 and P2)
+    // whether it is 16-bit or not, a flat component needs one move for both its halves, and a custom component needs
+    // a move for each of the three vertices.
+    if (compIdx == 0 && !isHighHalf)
+      ++m_packingCost.locationCount;
+    if (!isHighHalf) {
+      ++m_packingCost.componentCount;
+      if (spanIt->compatibilityInfo.isFlat)
+        m_packingCost.interpInstCount += 1;
+      else if (spanIt->compatibilityInfo.isCustom)
+        m_packingCost.interpInstCount += 3;
+    }
+    if (!spanIt->compatibilityInfo.isFlat && !spanIt->compatibilityInfo.isCustom)
+      m_packingCost.interpInstCount += 2;
+
     // Update component index
     if ((spanIt->compatibilityInfo.is16Bit && isHighHalf) || !spanIt->compatibilityInfo.is16Bit)
       ++compIdx;
@@ -0,0 +1,276 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  PatchShaderProfile.cpp
+ * @brief LLPC source file: contains implementation of class lgc::PatchShaderProfile.
+ ***********************************************************************************************************************
+ */
+#include "lgc/patch/PatchShaderProfile.h"
+#include "lgc/patch/Patch.h"
+#include "lgc/state/PalMetadata.h"
+#include "lgc/state/PipelineState.h"
+#include "lgc/state/TargetInfo.h"
+#include "lgc/util/BuilderBase.h"
+#include "lgc/util/Internal.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#define DEBUG_TYPE "lgc-patch-shader-profile"
+
+using namespace lgc;
+using namespace llvm;
+
+// -shader-profile: instrument each shader to accumulate its execution time in the shader profile buffer
+static cl::opt<bool> ShaderProfile("shader-profile",
+                                   cl::desc("Instrument each shader to accumulate its execution time and wave count in "
+                                            "the shader profile buffer of the user data layout"),
+                                   cl::init(false));
+
+// -shader-profile-loops: with -shader-profile, also instrument the outermost loops of each shader
+static cl::opt<bool> ShaderProfileLoops("shader-profile-loops",
+                                        cl::desc("With -shader-profile, also instrument the outermost loops of each "
+                                                 "shader"),
+                                        cl::init(false));
+
+// -shader-profile-realtime: with -shader-profile, read the constant-rate real time counter
+static cl::opt<bool> ShaderProfileRealTime("shader-profile-realtime",
+                                           cl::desc("With -shader-profile, read the constant-rate real time counter "
+                                                    "(s_memrealtime) rather than the shader clock (s_memtime)"),
+                                           cl::init(false));
+
+namespace {
+class LegacyPatchShaderProfile final : public ModulePass {
+public:
+  LegacyPatchShaderProfile();
+
+  virtual bool runOnModule(Module &module) override;
+
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override {
+    analysisUsage.addRequired<LegacyPipelineShaders>();
+    analysisUsage.addRequired<LegacyPipelineStateWrapper>();
+    analysisUsage.addPreserved<LegacyPipelineShaders>();
+  }
+
+  static char ID; // ID of this pass
+
+private:
+  LegacyPatchShaderProfile(const LegacyPatchShaderProfile &) = delete;
+  LegacyPatchShaderProfile &operator=(const LegacyPatchShaderProfile &) = delete;
+
+  PatchShaderProfile m_impl;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacyPatchShaderProfile::ID = 0;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of LLVM patching operations for instrumenting shaders with performance counters.
+ModulePass *lgc::createLegacyPatchShaderProfile() {
+  return new LegacyPatchShaderProfile();
+}
+
+// =====================================================================================================================
+LegacyPatchShaderProfile::LegacyPatchShaderProfile() : ModulePass(ID) {
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @returns : True if the module was modified by the transformation and false otherwise
+bool LegacyPatchShaderProfile::runOnModule(Module &module) {
+  PipelineState *pipelineState = getAnalysis<LegacyPipelineStateWrapper>().getPipelineState(&module);
+  PipelineShadersResult &pipelineShaders = getAnalysis<LegacyPipelineShaders>().getResult();
+  return m_impl.runImpl(module, pipelineShaders, pipelineState);
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+// @returns : The preserved analyses (The analyses that are still valid after this pass)
+PreservedAnalyses PatchShaderProfile::run(Module &module, ModuleAnalysisManager &analysisManager) {
+  PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
+  PipelineShadersResult &pipelineShaders = analysisManager.getResult<PipelineShaders>(module);
+  if (runImpl(module, pipelineShaders, pipelineState)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
+  return PreservedAnalyses::all();
+}
+
+// =====================================================================================================================
+// Executes this LLVM pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @param pipelineShaders : Pipeline shaders analysis result
+// @param pipelineState : Pipeline state
+// @returns : True if the module was modified by the transformation and false otherwise
+bool PatchShaderProfile::runImpl(Module &module, PipelineShadersResult &pipelineShaders, PipelineState *pipelineState) {
+  if (!ShaderProfile)
+    return false;
+
+  LLVM_DEBUG(dbgs() << "Run the pass Patch-Shader-Profile\n");
+
+  m_pipelineState = pipelineState;
+  std::tie(m_topNode, m_node) =
+      pipelineState->findResourceNode(ResourceNodeType::DescriptorBuffer, ShaderProfileDescSet, ShaderProfileBinding);
+  if (!m_node || m_node->type != ResourceNodeType::DescriptorBuffer || m_node->sizeInDwords < 4) {
+    LLVM_DEBUG(dbgs() << "No shader profile buffer in the user data layout\n");
+    return false;
+  }
+  // s_memrealtime is only on GFX8 and later.
+  m_realTime = ShaderProfileRealTime && pipelineState->getTargetInfo().getGfxIpVersion().major >= 8;
+
+  bool changed = false;
+  for (unsigned stage = 0; stage < ShaderStageNativeStageCount; ++stage) {
+    Function *entryPoint = pipelineShaders.getEntryPoint(static_cast<ShaderStage>(stage));
+    if (!entryPoint || entryPoint->isDeclaration())
+      continue;
+    instrumentShader(entryPoint, static_cast<ShaderStage>(stage));
+    changed = true;
+  }
+  return changed;
+}
+
+// =====================================================================================================================
+// Instruments one shader: its whole execution, and with -shader-profile-loops its outermost loops.
+//
+// @param entryPoint : Entry-point of the shader
+// @param stage : Shader stage
+void PatchShaderProfile::instrumentShader(Function *entryPoint, ShaderStage stage) {
+  const unsigned sectionOffset = stage * ShaderProfileStageSize;
+  const unsigned maxLoops = ShaderProfileStageSize / ShaderProfileRegionSize - 1;
+
+  // Find the loops to instrument before changing the CFG.
+  SmallVector<std::pair<BasicBlock *, BasicBlock *>, 4> loops;
+  if (ShaderProfileLoops) {
+    DominatorTree domTree(*entryPoint);
+    LoopInfo loopInfo(domTree);
+    for (BasicBlock &block : *entryPoint) {
+      Loop *loop = loopInfo.getLoopFor(&block);
+      if (!loop || loop->getParentLoop() || loop->getHeader() != &block || loops.size() == maxLoops)
+        continue;
+      BasicBlock *preheader = loop->getLoopPreheader();
+      BasicBlock *exitBlock = loop->getUniqueExitBlock();
+      if (preheader && exitBlock && loop->hasDedicatedExits())
+        loops.push_back({preheader, exitBlock});
+    }
+  }
+
+  BuilderBase builder(entryPoint->getContext());
+  builder.SetInsertPoint(&*entryPoint->getEntryBlock().getFirstInsertionPt());
+  Value *shaderStart = readCounter(builder);
+
+  SmallVector<ReturnInst *, 4> returns;
+  for (BasicBlock &block : *entryPoint) {
+    if (auto ret = dyn_cast<ReturnInst>(block.getTerminator()))
+      returns.push_back(ret);
+  }
+  for (ReturnInst *ret : returns)
+    accumulate(ret, shaderStart, stage, sectionOffset);
+
+  for (unsigned loopIdx = 0; loopIdx != loops.size(); ++loopIdx) {
+    builder.SetInsertPoint(loops[loopIdx].first->getTerminator());
+    Value *loopStart = readCounter(builder);
+    accumulate(&*loops[loopIdx].second->getFirstInsertionPt(), loopStart, stage,
+               sectionOffset + (loopIdx + 1) * ShaderProfileRegionSize);
+  }
+
+  m_pipelineState->getShaderResourceUsage(stage)->resourceWrite = true;
+  m_pipelineState->getPalMetadata()->setShaderProfileInfo(stage, sectionOffset, loops.size(),
+                                                          m_realTime ? "s_memrealtime" : "s_memtime");
+}
+
+// =====================================================================================================================
+// Reads the time counter.
+//
+// @param builder : Builder, at the place to read the counter
+// @returns : The 64-bit counter value
+Value *PatchShaderProfile::readCounter(BuilderBase &builder) {
+  return builder.CreateIntrinsic(m_realTime ? Intrinsic::amdgcn_s_memrealtime : Intrinsic::amdgcn_s_memtime, {}, {});
+}
+
+// =====================================================================================================================
+// Reads the time counter, and adds the ticks since the given start time and 1 to the region of the shader profile
+// buffer at the given offset, from the first active lane of the wave.
+//
+// @param insertPos : Where to insert the code
+// @param startTime : Counter value at the start of the region
+// @param stage : Shader stage
+// @param byteOffset : Byte offset of the region in the shader profile buffer
+void PatchShaderProfile::accumulate(Instruction *insertPos, Value *startTime, ShaderStage stage, unsigned byteOffset) {
+  BuilderBase builder(insertPos);
+  Value *ticks = builder.CreateSub(readCounter(builder), startTime);
+
+  Value *lane = builder.CreateIntrinsic(Intrinsic::amdgcn_mbcnt_lo, {}, {builder.getInt32(-1), builder.getInt32(0)});
+  if (m_pipelineState->getShaderWaveSize(stage) == 64)
+    lane = builder.CreateIntrinsic(Intrinsic::amdgcn_mbcnt_hi, {}, {builder.getInt32(-1), lane});
+  Value *firstLane = builder.CreateIntrinsic(Intrinsic::amdgcn_readfirstlane, {}, lane);
+  Instruction *atomicPos = SplitBlockAndInsertIfThen(builder.CreateICmpEQ(lane, firstLane), insertPos, false);
+  builder.SetInsertPoint(atomicPos);
+
+  // Get the buffer descriptor in the same way as DescBuilder: a top-level descriptor with lgc.root.descriptor, which
+  // PatchEntryPointMutate loads from the spill table or its entry SGPRs; otherwise from its descriptor table.
+  Type *descTy = FixedVectorType::get(builder.getInt32Ty(), 4);
+  Value *desc = nullptr;
+  if (m_node == m_topNode) {
+    std::string callName = lgcName::RootDescriptor;
+    addTypeMangling(descTy, {}, callName);
+    desc = builder.CreateNamedCall(callName, descTy, builder.getInt32(m_node->offsetInDwords), Attribute::ReadNone);
+  } else {
+    Value *tablePtr = builder.CreateNamedCall(
+        lgcName::DescriptorTableAddr, builder.getInt8Ty()->getPointerTo(ADDR_SPACE_CONST),
+        {builder.getInt32(unsigned(ResourceNodeType::DescriptorBuffer)), builder.getInt32(ShaderProfileDescSet),
+         builder.getInt32(ShaderProfileBinding), builder.getInt32(HighAddrPc)},
+        Attribute::ReadNone);
+    Value *descPtr = builder.CreateConstGEP1_32(builder.getInt8Ty(), tablePtr, m_node->offsetInDwords * 4);
+    descPtr = builder.CreateBitCast(descPtr, descTy->getPointerTo(ADDR_SPACE_CONST));
+    desc = builder.CreateLoad(descTy, descPtr);
+  }
+
+  builder.CreateIntrinsic(Intrinsic::amdgcn_raw_buffer_atomic_add, builder.getInt64Ty(),
+                          {ticks, desc, builder.getInt32(byteOffset), builder.getInt32(0), builder.getInt32(0)});
+  builder.CreateIntrinsic(Intrinsic::amdgcn_raw_buffer_atomic_add, builder.getInt64Ty(),
+                          {builder.getInt64(1), desc, builder.getInt32(byteOffset + 8), builder.getInt32(0),
+                           builder.getInt32(0)});
+}
+
+INITIALIZE_PASS(LegacyPatchShaderProfile, DEBUG_TYPE, "Patch LLVM for instrumenting shaders with performance counters",
+                false, false)
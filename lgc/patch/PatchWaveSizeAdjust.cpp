@@ -30,9 +30,14 @@
  */
 #include "lgc/patch/PatchWaveSizeAdjust.h"
 #include "lgc/patch/Patch.h"
+#include "lgc/state/IntrinsDefs.h"
 #include "lgc/state/TargetInfo.h"
+#include "llvm/Analysis/DivergenceAnalysis.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/IntrinsicsAMDGPU.h"
+#include "llvm/InitializePasses.h"
 #include "llvm/Support/Debug.h"
 
 #define DEBUG_TYPE "lgc-patch-wave-size-adjust"
@@ -40,6 +45,37 @@
 using namespace lgc;
 using namespace llvm;
 
+namespace {
+
+// Thresholds of the wave size heuristic for one GFXIP. Shader characteristics that favor wave32 are a high density of
+// divergent branches (fewer inactive lanes per branch) and a high VGPR pressure (a wave32 wave needs half the VGPR
+// storage of a wave64 one, so more waves fit). Shader characteristics that favor wave64 are a high density of
+// subgroup operations (each operation covers twice the lanes) and a large LDS usage (fewer LDS accesses are issued
+// per thread).
+struct WaveSizeTuning {
+  unsigned wave32DivergentBranchesPerKiloInst; // Divergent branches per 1000 instructions to prefer wave32
+  unsigned wave32VgprDwords;                   // Estimated VGPR pressure in dwords to prefer wave32
+  unsigned wave64SubgroupOpsPerKiloInst;       // Subgroup operations per 1000 instructions to prefer wave64
+  unsigned wave64LdsBytes;                     // LDS usage in bytes to prefer wave64
+};
+
+// Tuning table for GFX10.1
+const WaveSizeTuning Gfx10WaveSizeTuning = {20, 64, 10, 16384};
+
+// Tuning table for GFX10.3, where compute shaders default to wave64
+const WaveSizeTuning Gfx103WaveSizeTuning = {30, 96, 8, 8192};
+
+// Characteristics of the IR of one shader stage
+struct ShaderStats {
+  unsigned instCount = 0;            // Count of instructions
+  unsigned divergentBranchCount = 0; // Count of conditional branches and switches with divergent conditions
+  unsigned subgroupOpCount = 0;      // Count of cross-lane operations
+  unsigned vgprDwords = 0;           // Maximum over blocks of the dwords of divergent values referenced in the block
+  unsigned ldsBytes = 0;             // Size of LDS variables referenced by the shader
+};
+
+} // anonymous namespace
+
 char LegacyPatchWaveSizeAdjust::ID = 0;
 
 // =====================================================================================================================
@@ -64,7 +100,12 @@ LegacyPatchWaveSizeAdjust::LegacyPatchWaveSizeAdjust() : ModulePass(ID) {
 // @returns : True if the module was modified by the transformation and false otherwise
 bool LegacyPatchWaveSizeAdjust::runOnModule(Module &module) {
   auto pipelineState = getAnalysis<LegacyPipelineStateWrapper>().getPipelineState(&module);
-  return m_impl.runImpl(module, pipelineState);
+  auto getIsDivergent = [this](Function &func) -> std::function<bool(const Value &)> {
+    // NOTE: The divergence analysis of a function is only valid until that of another function is requested.
+    LegacyDivergenceAnalysis *divergenceAnalysis = &getAnalysis<LegacyDivergenceAnalysis>(func);
+    return [divergenceAnalysis](const Value &value) { return divergenceAnalysis->isDivergent(&value); };
+  };
+  return m_impl.runImpl(module, pipelineState, getIsDivergent);
 }
 
 // =====================================================================================================================
@@ -75,23 +116,188 @@ bool LegacyPatchWaveSizeAdjust::runOnModule(Module &module) {
 // @returns : The preserved analyses (The analyses that are still valid after this pass)
 PreservedAnalyses PatchWaveSizeAdjust::run(Module &module, ModuleAnalysisManager &analysisManager) {
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
-  runImpl(module, pipelineState);
+  FunctionAnalysisManager &functionAnalysisManager =
+      analysisManager.getResult<FunctionAnalysisManagerModuleProxy>(module).getManager();
+  auto getIsDivergent = [&functionAnalysisManager](Function &func) -> std::function<bool(const Value &)> {
+    DivergenceInfo *divergenceInfo = &functionAnalysisManager.getResult<DivergenceAnalysis>(func);
+    return [divergenceInfo](const Value &value) { return divergenceInfo->isDivergent(value); };
+  };
+  runImpl(module, pipelineState, getIsDivergent);
   return PreservedAnalyses::all();
 }
 
+// =====================================================================================================================
+// Gets the tuning table of the wave size heuristic selected by the pipeline options
+//
+// @param pipelineState : Pipeline state
+// @returns : Tuning table, or nullptr if the wave size heuristic is disabled
+static const WaveSizeTuning *getWaveSizeTuning(PipelineState *pipelineState) {
+  const GfxIpVersion gfxIp = pipelineState->getTargetInfo().getGfxIpVersion();
+  if (gfxIp.major < 10)
+    return nullptr; // Only GFX10+ supports wave32
+
+  switch (pipelineState->getOptions().waveSizeHeuristic) {
+  case WaveSizeHeuristic::Auto:
+    return gfxIp >= GfxIpVersion({10, 3}) ? &Gfx103WaveSizeTuning : &Gfx10WaveSizeTuning;
+  case WaveSizeHeuristic::Gfx10:
+    return &Gfx10WaveSizeTuning;
+  case WaveSizeHeuristic::Gfx103:
+    return &Gfx103WaveSizeTuning;
+  default:
+    return nullptr;
+  }
+}
+
+// =====================================================================================================================
+// Checks whether the given intrinsic is a cross-lane operation, as generated for subgroup operations
+//
+// @param intrinsicId : Intrinsic ID
+static bool isSubgroupIntrinsic(Intrinsic::ID intrinsicId) {
+  switch (intrinsicId) {
+  case Intrinsic::amdgcn_ballot:
+  case Intrinsic::amdgcn_ds_bpermute:
+  case Intrinsic::amdgcn_ds_swizzle:
+  case Intrinsic::amdgcn_icmp:
+  case Intrinsic::amdgcn_mov_dpp:
+  case Intrinsic::amdgcn_permlane16:
+  case Intrinsic::amdgcn_permlanex16:
+  case Intrinsic::amdgcn_readlane:
+  case Intrinsic::amdgcn_set_inactive:
+  case Intrinsic::amdgcn_update_dpp:
+  case Intrinsic::amdgcn_writelane:
+  case Intrinsic::amdgcn_wwm:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// =====================================================================================================================
+// Gets the count of dwords of VGPRs needed by a divergent value, or 0 for values that do not live in VGPRs
+//
+// @param value : Value
+// @param dataLayout : Data layout of the module
+static unsigned getVgprDwords(const Value &value, const DataLayout &dataLayout) {
+  Type *ty = value.getType();
+  // NOTE: Divergent conditions are lane masks, which live in SGPRs.
+  if (!ty->isSized() || ty->isIntOrIntVectorTy(1))
+    return 0;
+  return alignTo(dataLayout.getTypeSizeInBits(ty).getFixedSize(), 32) / 32;
+}
+
+// =====================================================================================================================
+// Collects the characteristics of the IR of a function of a shader stage
+//
+// @param func : Function to collect the characteristics of
+// @param isDivergent : Function telling whether a value of the function is divergent
+// @param [in/out] stats : Shader characteristics to update
+// @param [in/out] ldsVariables : LDS variables referenced by the shader stage
+static void collectShaderStats(Function &func, const std::function<bool(const Value &)> &isDivergent,
+                               ShaderStats &stats, SmallPtrSetImpl<GlobalVariable *> &ldsVariables) {
+  const DataLayout &dataLayout = func.getParent()->getDataLayout();
+  SmallPtrSet<const Value *, 32> blockValues;
+
+  for (BasicBlock &block : func) {
+    unsigned blockDwords = 0;
+    blockValues.clear();
+    auto addDivergentValue = [&](const Value &value) {
+      if ((isa<Instruction>(value) || isa<Argument>(value)) && isDivergent(value) && blockValues.insert(&value).second)
+        blockDwords += getVgprDwords(value, dataLayout);
+    };
+
+    for (Instruction &inst : block) {
+      ++stats.instCount;
+      addDivergentValue(inst);
+
+      for (const Use &operand : inst.operands()) {
+        addDivergentValue(*operand);
+
+        if (operand->getType()->isPointerTy()) {
+          auto global = dyn_cast<GlobalVariable>(getUnderlyingObject(operand));
+          if (global && global->getAddressSpace() == ADDR_SPACE_LOCAL)
+            ldsVariables.insert(global);
+        }
+      }
+
+      if (auto branch = dyn_cast<BranchInst>(&inst)) {
+        if (branch->isConditional() && isDivergent(*branch->getCondition()))
+          ++stats.divergentBranchCount;
+      } else if (auto switchInst = dyn_cast<SwitchInst>(&inst)) {
+        if (isDivergent(*switchInst->getCondition()))
+          ++stats.divergentBranchCount;
+      } else if (auto intrinsic = dyn_cast<IntrinsicInst>(&inst)) {
+        if (isSubgroupIntrinsic(intrinsic->getIntrinsicID()))
+          ++stats.subgroupOpCount;
+      }
+    }
+
+    stats.vgprDwords = std::max(stats.vgprDwords, blockDwords);
+  }
+}
+
+// =====================================================================================================================
+// Picks the wave size of a shader stage from the characteristics of its IR
+//
+// @param stats : Shader characteristics
+// @param tuning : Tuning table of the wave size heuristic
+// @returns : Picked wave size, or 0 to use the per-stage default
+static unsigned pickWaveSize(const ShaderStats &stats, const WaveSizeTuning &tuning) {
+  if (stats.instCount == 0)
+    return 0;
+
+  const unsigned divergentBranchesPerKiloInst = stats.divergentBranchCount * 1000ULL / stats.instCount;
+  const unsigned subgroupOpsPerKiloInst = stats.subgroupOpCount * 1000ULL / stats.instCount;
+
+  const bool preferWave32 = divergentBranchesPerKiloInst >= tuning.wave32DivergentBranchesPerKiloInst ||
+                            stats.vgprDwords >= tuning.wave32VgprDwords;
+  const bool preferWave64 =
+      subgroupOpsPerKiloInst >= tuning.wave64SubgroupOpsPerKiloInst || stats.ldsBytes >= tuning.wave64LdsBytes;
+
+  // Conflicting (or no) preferences leave the choice to the per-stage default
+  if (preferWave32 == preferWave64)
+    return 0;
+  return preferWave32 ? 32 : 64;
+}
+
 // =====================================================================================================================
 // Run the PatchWaveSizeAdjust pass on a module
 //
 // @param module : Module to run this pass on
 // @param pipelineState : Pipeline state
+// @param getIsDivergent : Callback to get the divergence of values of a function
 // @returns : True if the module was modified by the transformation and false otherwise
-bool PatchWaveSizeAdjust::runImpl(Module &module, PipelineState *pipelineState) {
+bool PatchWaveSizeAdjust::runImpl(Module &module, PipelineState *pipelineState, const GetIsDivergent &getIsDivergent) {
   LLVM_DEBUG(dbgs() << "Running the pass of adjusting wave size heuristic\n");
 
+  const WaveSizeTuning *tuning = getWaveSizeTuning(pipelineState);
+
   for (int stageIdx = 0; stageIdx < ShaderStageCount; ++stageIdx) {
     ShaderStage shaderStage = static_cast<ShaderStage>(stageIdx);
     if (pipelineState->hasShaderStage(shaderStage)) {
-      pipelineState->setShaderDefaultWaveSize(shaderStage);
+      // NOTE: The heuristic does not apply when the wave size is explicitly specified, when the lowering of the
+      // shader (e.g. of its subgroup operations) has already fixed the wave size, or when the legacy GS path
+      // requires wave64.
+      unsigned preferredWaveSize = 0;
+      if (tuning && !pipelineState->isShaderWaveSizeSet(shaderStage) &&
+          pipelineState->getShaderOptions(shaderStage).waveSize == 0 &&
+          !pipelineState->hasShaderStage(ShaderStageGeometry)) {
+        ShaderStats stats;
+        SmallPtrSet<GlobalVariable *, 4> ldsVariables;
+        for (Function &func : module) {
+          if (!func.isDeclaration() && getShaderStage(&func) == shaderStage)
+            collectShaderStats(func, getIsDivergent(func), stats, ldsVariables);
+        }
+        for (GlobalVariable *ldsVariable : ldsVariables)
+          stats.ldsBytes += module.getDataLayout().getTypeAllocSize(ldsVariable->getValueType());
+
+        preferredWaveSize = pickWaveSize(stats, *tuning);
+        LLVM_DEBUG(dbgs() << getShaderStageAbbreviation(shaderStage) << ": instructions " << stats.instCount
+                          << ", divergent branches " << stats.divergentBranchCount << ", subgroup operations "
+                          << stats.subgroupOpCount << ", VGPR dwords " << stats.vgprDwords << ", LDS bytes "
+                          << stats.ldsBytes << ", preferred wave size " << preferredWaveSize << "\n");
+      }
+
+      pipelineState->setShaderDefaultWaveSize(shaderStage, preferredWaveSize);
       if (shaderStage == ShaderStageGeometry)
         pipelineState->setShaderDefaultWaveSize(ShaderStageCopyShader);
     }
@@ -102,4 +308,8 @@ bool PatchWaveSizeAdjust::runImpl(Module &module, PipelineState *pipelineState)
 
 // =====================================================================================================================
 // Initializes the pass
-INITIALIZE_PASS(LegacyPatchWaveSizeAdjust, DEBUG_TYPE, "Patch LLVM for per-shader wave size adjustment", false, false)
+INITIALIZE_PASS_BEGIN(LegacyPatchWaveSizeAdjust, DEBUG_TYPE, "Patch LLVM for per-shader wave size adjustment", false,
+                      false)
+INITIALIZE_PASS_DEPENDENCY(LegacyDivergenceAnalysis)
+INITIALIZE_PASS_END(LegacyPatchWaveSizeAdjust, DEBUG_TYPE, "Patch LLVM for per-shader wave size adjustment", false,
+                    false)
@@ -77,11 +77,24 @@ bool LegacyPatchWorkarounds::runOnModule(Module &module) {
 // @returns : The preserved analyses (The analyses that are still valid after this pass)
 PreservedAnalyses PatchWorkarounds::run(Module &module, ModuleAnalysisManager &analysisManager) {
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
-  if (runImpl(module, pipelineState))
-    return PreservedAnalyses::none();
+  if (runImpl(module, pipelineState)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
   return PreservedAnalyses::all();
 }
 
+// =====================================================================================================================
+// Returns whether any of the workarounds of this pass applies to the target and options of the pipeline, so that the
+// pass is only added to the pass pipeline, and so only scans the module, when it has something to do.
+//
+// @param pipelineState : Pipeline state
+bool PatchWorkarounds::isNeeded(PipelineState *pipelineState) {
+  return !pipelineState->getOptions().disableImageResourceCheck &&
+         pipelineState->getTargetInfo().getGpuWorkarounds().gfx10.waFixBadImageDescriptor;
+}
+
 // =====================================================================================================================
 // Executes this LLVM pass on the specified LLVM function.
 //
@@ -111,8 +124,7 @@ bool PatchWorkarounds::runImpl(Module &module, PipelineState *pipelineState) {
 // are handling gracefully)
 //
 void PatchWorkarounds::applyImageDescWorkaround(void) {
-  if (!m_pipelineState->getOptions().disableImageResourceCheck &&
-      m_pipelineState->getTargetInfo().getGpuWorkarounds().gfx10.waFixBadImageDescriptor) {
+  if (isNeeded(m_pipelineState)) {
 
     // We have to consider waterfall.last.use as this may be used on a resource
     // descriptor that is then used by an image instruction.
@@ -415,9 +415,10 @@ static const ShaderInputDesc FsSgprInputs[] = {
 };
 
 // SGPRs: CS
+// The hardware only initializes these when the config builder enables them, which it does when they are arguments.
 static const ShaderInputDesc CsSgprInputs[] = {
-    {ShaderInput::WorkgroupId, 0, true},
-    {ShaderInput::MultiDispatchInfo, 0, true},
+    {ShaderInput::WorkgroupId, offsetof(InterfaceData, entryArgIdxs.cs.workgroupId)},
+    {ShaderInput::MultiDispatchInfo, offsetof(InterfaceData, entryArgIdxs.cs.multiDispatchInfo)},
 };
 
 // VGPRs: VS
@@ -486,10 +487,12 @@ static const ShaderInputDesc CsVgprInputs[] = {
 // @param shaderStage : Shader stage
 // @param [in/out] argTys : Argument types vector to add to
 // @param [in/out] argNames : Argument names vector to add to
+// @param argOffset : Index of the first argument added
+// @param computeWithCalls : Whether this is a compute shader or library whose inputs are passed to other functions
 // @returns : Bitmap with bits set for SGPR arguments so caller can set "inreg" attribute on the args
 uint64_t ShaderInputs::getShaderArgTys(PipelineState *pipelineState, ShaderStage shaderStage,
                                        SmallVectorImpl<Type *> &argTys, SmallVectorImpl<std::string> &argNames,
-                                       unsigned argOffset) {
+                                       unsigned argOffset, bool computeWithCalls) {
 
   bool hasTs = pipelineState->hasShaderStage(ShaderStageTessControl);
   bool hasGs = pipelineState->hasShaderStage(ShaderStageGeometry);
@@ -547,6 +550,13 @@ uint64_t ShaderInputs::getShaderArgTys(PipelineState *pipelineState, ShaderStage
       }
     }
     break;
+  case ShaderStageCompute:
+    if (computeWithCalls) {
+      // The functions called may use the workgroup ID, so it must be passed even if it appears unused here.
+      getShaderInputUsage(shaderStage, ShaderInput::WorkgroupId)->enable();
+      getShaderInputUsage(shaderStage, ShaderInput::MultiDispatchInfo)->enable();
+    }
+    break;
   default:
     break;
   }
@@ -44,6 +44,24 @@
 using namespace llvm;
 using namespace lgc;
 
+// =====================================================================================================================
+// Checks whether the given half of a merged shader may write memory that the other half could read, i.e. whether a
+// barrier is needed between the two halves.
+//
+// @param func : Entry-point of the half of the merged shader (may be null)
+// @returns : True if the function may write memory
+static bool mayWriteMemory(const Function *func) {
+  if (!func)
+    return false;
+  for (const BasicBlock &block : *func) {
+    for (const Instruction &inst : block) {
+      if (inst.mayWriteToMemory())
+        return true;
+    }
+  }
+  return false;
+}
+
 // =====================================================================================================================
 //
 // @param pipelineState : Pipeline state
@@ -368,10 +386,14 @@ Function *ShaderMerger::generateLsHsEntryPoint(Function *lsEntryPoint, Function
   BranchInst::Create(endLsBlock, beginLsBlock);
 
   // Construct ".endls" block
-  args.clear();
-  attribs.clear();
-  attribs.push_back(Attribute::NoRecurse);
-  emitCall("llvm.amdgcn.s.barrier", Type::getVoidTy(*m_context), args, attribs, endLsBlock);
+  // NOTE: The barrier only orders the LS outputs written to LDS before the HS reads them. If LS writes no memory at
+  // all (for example, VS has no outputs), HS does not depend on it and the barrier can be left out.
+  if (m_hasVs && mayWriteMemory(lsEntryPoint)) {
+    args.clear();
+    attribs.clear();
+    attribs.push_back(Attribute::NoRecurse);
+    emitCall("llvm.amdgcn.s.barrier", Type::getVoidTy(*m_context), args, attribs, endLsBlock);
+  }
 
   auto hsEnable = new ICmpInst(*endLsBlock, ICmpInst::ICMP_ULT, threadId, hsVertCount, "");
   BranchInst::Create(beginHsBlock, endHsBlock, hsEnable, endLsBlock);
@@ -840,10 +862,14 @@ Function *ShaderMerger::generateEsGsEntryPoint(Function *esEntryPoint, Function
   BranchInst::Create(endEsBlock, beginEsBlock);
 
   // Construct ".endes" block
-  args.clear();
-  attribs.clear();
-  attribs.push_back(Attribute::NoRecurse);
-  emitCall("llvm.amdgcn.s.barrier", Type::getVoidTy(*m_context), args, attribs, endEsBlock);
+  // NOTE: The barrier only orders the ES outputs written to the ES-GS ring before the GS reads them. If ES writes no
+  // memory at all, GS does not depend on it and the barrier can be left out.
+  if (((hasTs && m_hasTes) || (!hasTs && m_hasVs)) && mayWriteMemory(esEntryPoint)) {
+    args.clear();
+    attribs.clear();
+    attribs.push_back(Attribute::NoRecurse);
+    emitCall("llvm.amdgcn.s.barrier", Type::getVoidTy(*m_context), args, attribs, endEsBlock);
+  }
 
   auto gsEnable = new ICmpInst(*endEsBlock, ICmpInst::ICMP_ULT, threadId, gsPrimCount, "");
   BranchInst::Create(beginGsBlock, endGsBlock, gsEnable, endEsBlock);
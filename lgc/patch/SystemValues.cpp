@@ -467,13 +467,11 @@ Value *ShaderSystemValues::setRingBufferDataFormat(Value *bufDesc, unsigned data
 //
 // @param descSet : Descriptor set to find
 unsigned ShaderSystemValues::findResourceNodeByDescSet(unsigned descSet) {
-  auto userDataNodes = m_pipelineState->getUserDataNodes();
-  for (unsigned i = 0; i < userDataNodes.size(); ++i) {
-    auto node = &userDataNodes[i];
-    if (node->type == ResourceNodeType::DescriptorTableVaPtr && node->innerTable[0].set == descSet)
-      return i;
-  }
-  return InvalidValue;
+  const ResourceNode *node =
+      m_pipelineState->findResourceNode(ResourceNodeType::DescriptorTableVaPtr, descSet, 0).first;
+  if (!node)
+    return InvalidValue;
+  return node - m_pipelineState->getUserDataNodes().data();
 }
 
 // =====================================================================================================================
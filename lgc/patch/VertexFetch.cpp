@@ -39,7 +39,9 @@
 #include "lgc/util/BuilderBase.h"
 #include "lgc/util/Internal.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
 #include "llvm/IR/Module.h"
 
 #define DEBUG_TYPE "lgc-vertex-fetch"
@@ -77,10 +79,13 @@ struct VertexCompFormatInfo {
 // Vertex fetch manager
 class VertexFetchImpl : public VertexFetch {
 public:
-  VertexFetchImpl(LgcContext *lgcContext);
+  VertexFetchImpl(LgcContext *lgcContext, bool uniformFetchesToSgprs);
   VertexFetchImpl(const VertexFetchImpl &) = delete;
   VertexFetchImpl &operator=(const VertexFetchImpl &) = delete;
 
+  // Set the vertex inputs that are going to be fetched
+  void coalesceFetches(ArrayRef<const VertexInputDescription *> descriptions) override;
+
   // Generate code to fetch a vertex value
   Value *fetchVertex(Type *inputTy, const VertexInputDescription *description, unsigned location, unsigned compIdx,
                      BuilderBase &builder) override;
@@ -102,6 +107,12 @@ private:
 
   Value *loadVertexBufferDescriptor(unsigned binding, BuilderBase &builder);
 
+  Value *getVertexBufferIndex(const VertexInputDescription *description, BuilderBase &builder);
+
+  static bool canCoalesceFetch(const VertexInputDescription *description);
+
+  Value *getCoalescedFetch(const VertexInputDescription *description, unsigned numChannels, BuilderBase &builder);
+
   void addVertexFetchInst(Value *vbDesc, unsigned numChannels, bool is16bitFetch, Value *vbIndex, unsigned offset,
                           unsigned stride, unsigned dfmt, unsigned nfmt, Instruction *insertPos, Value **ppFetch) const;
 
@@ -116,6 +127,18 @@ private:
   Value *m_vertexBufTablePtr = nullptr; // Vertex buffer table pointer
   Value *m_vertexIndex = nullptr;       // Vertex index
   Value *m_instanceIndex = nullptr;     // Instance index
+  bool m_uniformFetchesToSgprs = false; // Whether to move the values of inputs with a zero divisor to SGPRs
+  // Vertex buffer indices of inputs with a zero divisor (keyed by 0) or a divisor, by input rate
+  SmallDenseMap<unsigned, Value *, 2> m_instanceIndicesByRate;
+
+  // A vertex fetch that covers the inputs at adjacent offsets in one binding
+  struct CoalescedFetch {
+    const VertexInputDescription *description; // Description of the input at the lowest offset
+    unsigned size;                             // Byte size of the fetch
+    Value *fetch;                              // The fetched dwords, or nullptr if not generated yet
+  };
+  SmallVector<CoalescedFetch, 4> m_coalescedFetches;                      // Coalesced vertex fetches
+  DenseMap<const VertexInputDescription *, unsigned> m_coalescedFetchMap; // Map from input to its coalesced fetch
 
   static const VertexCompFormatInfo m_vertexCompFormatInfo[]; // Info table of vertex component format
   static const unsigned char m_vertexFormatMapGfx10[][8];     // Info table of vertex format mapping for GFX10
@@ -363,8 +386,11 @@ bool LegacyLowerVertexFetch::runOnModule(Module &module) {
 // @returns : The preserved analyses (The analyses that are still valid after this pass)
 PreservedAnalyses LowerVertexFetch::run(Module &module, ModuleAnalysisManager &analysisManager) {
   PipelineState *pipelineState = analysisManager.getResult<PipelineStateWrapper>(module).getPipelineState();
-  if (runImpl(module, pipelineState))
-    return PreservedAnalyses::none();
+  if (runImpl(module, pipelineState)) {
+    PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserve<PipelineShaders>();
+    return preservedAnalyses;
+  }
   return PreservedAnalyses::all();
 }
 
@@ -375,7 +401,8 @@ PreservedAnalyses LowerVertexFetch::run(Module &module, ModuleAnalysisManager &a
 // @param pipelineState : Pipeline state
 // @returns : True if the module was modified by the transformation and false otherwise
 bool LowerVertexFetch::runImpl(Module &module, PipelineState *pipelineState) {
-  std::unique_ptr<VertexFetch> vertexFetch(VertexFetch::create(pipelineState->getLgcContext()));
+  std::unique_ptr<VertexFetch> vertexFetch(
+      VertexFetch::create(pipelineState->getLgcContext(), /*uniformFetchesToSgprs=*/true));
 
   // Gather vertex fetch calls. We can assume they're all in one function, the vertex shader.
   // We can assume that multiple fetches of the same location, component and type have been CSEd.
@@ -392,6 +419,25 @@ bool LowerVertexFetch::runImpl(Module &module, PipelineState *pipelineState) {
 
   if (!pipelineState->isUnlinked() || !pipelineState->getVertexInputDescriptions().empty()) {
     // Whole-pipeline compilation (or shader compilation where we were given the vertex input descriptions).
+    // Lower the vertex fetches in program order, so that a coalesced fetch, generated at the first of the inputs
+    // it covers, is available to the others.
+    Function *vertexShader = vertexFetches[0]->getFunction();
+    SmallPtrSet<CallInst *, 8> vertexFetchSet(vertexFetches.begin(), vertexFetches.end());
+    vertexFetches.clear();
+    for (Instruction &inst : instructions(vertexShader)) {
+      if (auto call = dyn_cast<CallInst>(&inst)) {
+        if (vertexFetchSet.count(call))
+          vertexFetches.push_back(call);
+      }
+    }
+
+    SmallVector<const VertexInputDescription *, 8> descriptions;
+    for (CallInst *call : vertexFetches) {
+      unsigned location = cast<ConstantInt>(call->getArgOperand(0))->getZExtValue();
+      descriptions.push_back(pipelineState->findVertexInputDescription(location));
+    }
+    vertexFetch->coalesceFetches(descriptions);
+
     // Lower each vertex fetch.
     for (CallInst *call : vertexFetches) {
       Value *vertex = nullptr;
@@ -482,16 +528,20 @@ bool LowerVertexFetch::runImpl(Module &module, PipelineState *pipelineState) {
 
 // =====================================================================================================================
 // Create a VertexFetch
-VertexFetch *VertexFetch::create(LgcContext *lgcContext) {
-  return new VertexFetchImpl(lgcContext);
+//
+// @param lgcContext : LGC context
+// @param uniformFetchesToSgprs : Whether to move the values of inputs with a zero divisor to SGPRs
+VertexFetch *VertexFetch::create(LgcContext *lgcContext, bool uniformFetchesToSgprs) {
+  return new VertexFetchImpl(lgcContext, uniformFetchesToSgprs);
 }
 
 // =====================================================================================================================
 // Constructor
 //
-// @param context : LLVM context
-VertexFetchImpl::VertexFetchImpl(LgcContext *lgcContext)
-    : m_lgcContext(lgcContext), m_context(&lgcContext->getContext()) {
+// @param lgcContext : LGC context
+// @param uniformFetchesToSgprs : Whether to move the values of inputs with a zero divisor to SGPRs
+VertexFetchImpl::VertexFetchImpl(LgcContext *lgcContext, bool uniformFetchesToSgprs)
+    : m_lgcContext(lgcContext), m_context(&lgcContext->getContext()), m_uniformFetchesToSgprs(uniformFetchesToSgprs) {
 
   // Initialize default fetch values
   auto zero = ConstantInt::get(Type::getInt32Ty(*m_context), 0);
@@ -532,6 +582,65 @@ VertexFetchImpl::VertexFetchImpl(LgcContext *lgcContext)
   m_fetchDefaults.double64 = ConstantVector::get({zero, zero, zero, zero, zero, zero, doubleOne0, doubleOne1});
 }
 
+// =====================================================================================================================
+// Set the vertex inputs that are going to be fetched, and find the inputs whose fetches can be coalesced: inputs
+// with 32-bit channels that are adjacent in the same binding are fetched together with one wider fetch, as long as
+// that fetch meets the alignment of a whole vertex fetch (see addVertexFetchInst).
+//
+// @param descriptions : Vertex input descriptions of the fetches, with nullptr for an input without a description
+void VertexFetchImpl::coalesceFetches(ArrayRef<const VertexInputDescription *> descriptions) {
+  m_coalescedFetches.clear();
+  m_coalescedFetchMap.clear();
+
+  // Gather the distinct inputs that can be coalesced, ordered by binding and offset.
+  SmallVector<const VertexInputDescription *, 8> candidates;
+  for (const VertexInputDescription *description : descriptions) {
+    if (description && canCoalesceFetch(description) && !is_contained(candidates, description))
+      candidates.push_back(description);
+  }
+  llvm::sort(candidates, [](const VertexInputDescription *lhs, const VertexInputDescription *rhs) {
+    return std::make_tuple(lhs->binding, lhs->offset, lhs->location) <
+           std::make_tuple(rhs->binding, rhs->offset, rhs->location);
+  });
+
+  auto getEnd = [](const VertexInputDescription *description) {
+    return description->offset + getVertexComponentFormatInfo(description->dfmt)->vertexByteSize;
+  };
+
+  for (unsigned begin = 0, end = 0; begin != candidates.size(); begin = end) {
+    // Gather the inputs that overlap or follow on from the first one, within a dwordx4 fetch.
+    const VertexInputDescription *first = candidates[begin];
+    unsigned fetchEnd = getEnd(first);
+    for (end = begin + 1; end != candidates.size(); ++end) {
+      const VertexInputDescription *description = candidates[end];
+      if (description->binding != first->binding || description->stride != first->stride ||
+          description->inputRate != first->inputRate || description->offset > fetchEnd ||
+          getEnd(description) - first->offset > SizeOfVec4)
+        break;
+      fetchEnd = std::max(fetchEnd, getEnd(description));
+    }
+
+    // Drop inputs from the end until the fetch is aligned as a whole vertex fetch, and within the stride.
+    unsigned size = 0;
+    for (; end - begin > 1; --end) {
+      size = 0;
+      for (unsigned idx = begin; idx != end; ++idx)
+        size = std::max(size, getEnd(candidates[idx]) - first->offset);
+      if (first->offset % size == 0 && first->stride % size == 0 &&
+          (first->stride == 0 || first->offset + size <= first->stride))
+        break;
+    }
+    if (end - begin < 2) {
+      end = begin + 1;
+      continue;
+    }
+
+    for (unsigned idx = begin; idx != end; ++idx)
+      m_coalescedFetchMap[candidates[idx]] = m_coalescedFetches.size();
+    m_coalescedFetches.push_back({first, size, nullptr});
+  }
+}
+
 // =====================================================================================================================
 // Executes vertex fetch operations based on the specified vertex input type and its location.
 //
@@ -544,37 +653,6 @@ Value *VertexFetchImpl::fetchVertex(Type *inputTy, const VertexInputDescription
                                     unsigned compIdx, BuilderBase &builder) {
   Value *vertex = nullptr;
   Instruction *insertPos = &*builder.GetInsertPoint();
-  auto vbDesc = loadVertexBufferDescriptor(description->binding, builder);
-
-  Value *vbIndex = nullptr;
-  if (description->inputRate == VertexInputRateVertex) {
-    // Use vertex index
-    if (!m_vertexIndex) {
-      auto savedInsertPoint = builder.saveIP();
-      builder.SetInsertPoint(&*insertPos->getFunction()->front().getFirstInsertionPt());
-      m_vertexIndex = ShaderInputs::getVertexIndex(builder, *m_lgcContext);
-      builder.restoreIP(savedInsertPoint);
-    }
-    vbIndex = m_vertexIndex;
-  } else {
-    if (description->inputRate == VertexInputRateNone) {
-      vbIndex = ShaderInputs::getSpecialUserData(UserDataMapping::BaseInstance, builder);
-    } else if (description->inputRate == VertexInputRateInstance) {
-      // Use instance index
-      if (!m_instanceIndex) {
-        auto savedInsertPoint = builder.saveIP();
-        builder.SetInsertPoint(&*insertPos->getFunction()->front().getFirstInsertionPt());
-        m_instanceIndex = ShaderInputs::getInstanceIndex(builder, *m_lgcContext);
-        builder.restoreIP(savedInsertPoint);
-      }
-      vbIndex = m_instanceIndex;
-    } else {
-      // There is a divisor.
-      vbIndex = builder.CreateUDiv(ShaderInputs::getInput(ShaderInput::InstanceId, builder, *m_lgcContext),
-                                   builder.getInt32(description->inputRate));
-      vbIndex = builder.CreateAdd(vbIndex, ShaderInputs::getSpecialUserData(UserDataMapping::BaseInstance, builder));
-    }
-  }
 
   Value *vertexFetches[2] = {}; // Two vertex fetch operations might be required
   Value *vertexFetch = nullptr; // Coalesced vector by combining the results of two vertex fetch operations
@@ -584,9 +662,21 @@ Value *VertexFetchImpl::fetchVertex(Type *inputTy, const VertexInputDescription
   const bool is8bitFetch = (inputTy->getScalarSizeInBits() == 8);
   const bool is16bitFetch = (inputTy->getScalarSizeInBits() == 16);
 
-  // Do the first vertex fetch operation
-  addVertexFetchInst(vbDesc, formatInfo.numChannels, is16bitFetch, vbIndex, description->offset, description->stride,
-                     formatInfo.dfmt, formatInfo.nfmt, insertPos, &vertexFetches[0]);
+  // Take the vertex from a fetch coalesced with other inputs if there is one. A 16-bit fetch cannot use it, as it
+  // converts the data in the fetch.
+  if (!is16bitFetch)
+    vertexFetches[0] = getCoalescedFetch(description, formatInfo.numChannels, builder);
+
+  Value *vbDesc = nullptr;
+  Value *vbIndex = nullptr;
+  if (!vertexFetches[0]) {
+    vbDesc = loadVertexBufferDescriptor(description->binding, builder);
+    vbIndex = getVertexBufferIndex(description, builder);
+
+    // Do the first vertex fetch operation
+    addVertexFetchInst(vbDesc, formatInfo.numChannels, is16bitFetch, vbIndex, description->offset,
+                       description->stride, formatInfo.dfmt, formatInfo.nfmt, insertPos, &vertexFetches[0]);
+  }
 
   // Do post-processing in certain cases
   std::vector<Constant *> shuffleMask;
@@ -716,6 +806,23 @@ Value *VertexFetchImpl::fetchVertex(Type *inputTy, const VertexInputDescription
   } else
     vertexFetch = vertexFetches[0];
 
+  if (m_uniformFetchesToSgprs && description->inputRate == VertexInputRateNone) {
+    // The index is the same in all lanes, so is the fetched value. Move each dword of it to an SGPR, so that the code
+    // using it is scalar, and does not take VGPRs for it.
+    builder.SetInsertPoint(insertPos);
+    if (!vertexFetch->getType()->isVectorTy()) {
+      vertexFetch = builder.CreateIntrinsic(Intrinsic::amdgcn_readfirstlane, {}, vertexFetch);
+    } else {
+      Value *uniformFetch = UndefValue::get(vertexFetch->getType());
+      for (unsigned i = 0; i != cast<FixedVectorType>(vertexFetch->getType())->getNumElements(); ++i) {
+        Value *channel = builder.CreateExtractElement(vertexFetch, i);
+        channel = builder.CreateIntrinsic(Intrinsic::amdgcn_readfirstlane, {}, channel);
+        uniformFetch = builder.CreateInsertElement(uniformFetch, channel, i);
+      }
+      vertexFetch = uniformFetch;
+    }
+  }
+
   // Finalize vertex fetch
   Type *basicTy = inputTy->isVectorTy() ? cast<VectorType>(inputTy)->getElementType() : inputTy;
   const unsigned bitWidth = basicTy->getScalarSizeInBits();
@@ -940,6 +1047,124 @@ Value *VertexFetchImpl::loadVertexBufferDescriptor(unsigned binding, BuilderBase
   return vbDesc;
 }
 
+// =====================================================================================================================
+// Gets the index of the vertex (or instance) in the vertex buffer of the given vertex input.
+//
+// @param description : Vertex input description
+// @param builder : Builder with insert point set
+Value *VertexFetchImpl::getVertexBufferIndex(const VertexInputDescription *description, BuilderBase &builder) {
+  Instruction *insertPos = &*builder.GetInsertPoint();
+  Value *vbIndex = nullptr;
+  if (description->inputRate == VertexInputRateVertex) {
+    // Use vertex index
+    if (!m_vertexIndex) {
+      auto savedInsertPoint = builder.saveIP();
+      builder.SetInsertPoint(&*insertPos->getFunction()->front().getFirstInsertionPt());
+      m_vertexIndex = ShaderInputs::getVertexIndex(builder, *m_lgcContext);
+      builder.restoreIP(savedInsertPoint);
+    }
+    vbIndex = m_vertexIndex;
+  } else {
+    if (description->inputRate != VertexInputRateInstance) {
+      // Use base instance, plus the instance ID divided by the divisor if there is one. This is computed once for
+      // each divisor, at the start of the shader, so that the inputs with the same divisor share it.
+      Value *&instanceIndex = m_instanceIndicesByRate[description->inputRate];
+      if (!instanceIndex) {
+        auto savedInsertPoint = builder.saveIP();
+        builder.SetInsertPoint(&*insertPos->getFunction()->front().getFirstInsertionPt());
+        instanceIndex = ShaderInputs::getSpecialUserData(UserDataMapping::BaseInstance, builder);
+        if (description->inputRate != VertexInputRateNone) {
+          Value *instanceId = ShaderInputs::getInput(ShaderInput::InstanceId, builder, *m_lgcContext);
+          Value *dividedInstanceId = builder.CreateUDiv(instanceId, builder.getInt32(description->inputRate));
+          instanceIndex = builder.CreateAdd(dividedInstanceId, instanceIndex);
+        }
+        builder.restoreIP(savedInsertPoint);
+      }
+      vbIndex = instanceIndex;
+    } else {
+      // Use instance index
+      if (!m_instanceIndex) {
+        auto savedInsertPoint = builder.saveIP();
+        builder.SetInsertPoint(&*insertPos->getFunction()->front().getFirstInsertionPt());
+        m_instanceIndex = ShaderInputs::getInstanceIndex(builder, *m_lgcContext);
+        builder.restoreIP(savedInsertPoint);
+      }
+      vbIndex = m_instanceIndex;
+    }
+  }
+  return vbIndex;
+}
+
+// =====================================================================================================================
+// Checks whether the fetch of a vertex input can be coalesced with others. Only formats with 32-bit channels whose
+// fetch returns the data unchanged can be, as then a wider fetch of the same bits can be split back into the inputs.
+//
+// @param description : Vertex input description
+bool VertexFetchImpl::canCoalesceFetch(const VertexInputDescription *description) {
+  switch (description->dfmt) {
+  case BufDataFormat32:
+  case BufDataFormat32_32:
+  case BufDataFormat32_32_32:
+  case BufDataFormat32_32_32_32:
+    break;
+  default:
+    return false;
+  }
+  return (description->nfmt == BufNumFormatUint || description->nfmt == BufNumFormatSint ||
+          description->nfmt == BufNumFormatFloat) &&
+         description->offset % 4 == 0;
+}
+
+// =====================================================================================================================
+// Gets the channels of a vertex input from the fetch coalesced with other inputs, generating that fetch at the first
+// input that uses it.
+//
+// @param description : Vertex input description
+// @param numChannels : Valid number of channels of the input
+// @param builder : Builder with insert point set
+// @returns : The channels of the input, or nullptr if the input is not coalesced, or the coalesced fetch is not
+//            available at the insert point
+Value *VertexFetchImpl::getCoalescedFetch(const VertexInputDescription *description, unsigned numChannels,
+                                          BuilderBase &builder) {
+  auto it = m_coalescedFetchMap.find(description);
+  if (it == m_coalescedFetchMap.end())
+    return nullptr;
+  CoalescedFetch &coalescedFetch = m_coalescedFetches[it->second];
+
+  Instruction *insertPos = &*builder.GetInsertPoint();
+  if (!coalescedFetch.fetch) {
+    const VertexInputDescription *first = coalescedFetch.description;
+    Value *vbDesc = loadVertexBufferDescriptor(first->binding, builder);
+    Value *vbIndex = getVertexBufferIndex(first, builder);
+    static const unsigned DataFormats[] = {BUF_DATA_FORMAT_32, BUF_DATA_FORMAT_32_32, BUF_DATA_FORMAT_32_32_32,
+                                           BUF_DATA_FORMAT_32_32_32_32};
+    const unsigned dwordCount = coalescedFetch.size / 4;
+    addVertexFetchInst(vbDesc, dwordCount, false, vbIndex, first->offset, first->stride, DataFormats[dwordCount - 1],
+                       BUF_NUM_FORMAT_UINT, insertPos, &coalescedFetch.fetch);
+  } else {
+    // The fetch was generated for an earlier input. Check that it dominates this one: in the same block it must
+    // come first, otherwise it must be in the entry block.
+    auto fetchInst = cast<Instruction>(coalescedFetch.fetch);
+    BasicBlock *fetchBlock = fetchInst->getParent();
+    if (fetchBlock == insertPos->getParent() ? !fetchInst->comesBefore(insertPos)
+                                              : fetchBlock != &fetchBlock->getParent()->getEntryBlock())
+      return nullptr;
+  }
+
+  Value *fetch = coalescedFetch.fetch;
+  if (!fetch->getType()->isVectorTy())
+    return fetch;
+  const unsigned firstChannel = (description->offset - coalescedFetch.description->offset) / 4;
+  if (numChannels == 1)
+    return builder.CreateExtractElement(fetch, firstChannel);
+  if (numChannels == cast<FixedVectorType>(fetch->getType())->getNumElements())
+    return fetch;
+  SmallVector<int, 4> shuffleMask;
+  for (unsigned channel = 0; channel != numChannels; ++channel)
+    shuffleMask.push_back(firstChannel + channel);
+  return builder.CreateShuffleVector(fetch, shuffleMask);
+}
+
 // =====================================================================================================================
 // Inserts instructions to do vertex fetch operations.
 //
@@ -962,13 +1187,18 @@ void VertexFetchImpl::addVertexFetchInst(Value *vbDesc, unsigned numChannels, bo
                                          Instruction *insertPos, Value **ppFetch) const {
   const VertexCompFormatInfo *formatInfo = getVertexComponentFormatInfo(dfmt);
 
+  // NOTE: For the vertex data format 8_8, 8_8_8_8, 16_16, and 16_16_16_16, tbuffer_load has a HW defect when
+  // vertex buffer is unaligned on the targets that do not report otherwise. Therefore, we have to split the vertex
+  // fetch to component-based ones there.
+  const bool unalignedFetchDefect =
+      !m_lgcContext->getTargetInfo().getGpuProperty().typedVertexFetch.unaligned8And16 &&
+      (dfmt == BufDataFormat8_8 || dfmt == BufDataFormat8_8_8_8 || dfmt == BufDataFormat16_16 ||
+       dfmt == BufDataFormat16_16_16_16);
+
   // NOTE: If the vertex attribute offset and stride are aligned on data format boundaries, we can do a vertex fetch
   // operation to read the whole vertex. Otherwise, we have to do vertex per-component fetch operations.
   if (((offset % formatInfo->vertexByteSize) == 0 && (stride % formatInfo->vertexByteSize) == 0 &&
-       // NOTE: For the vertex data format 8_8, 8_8_8_8, 16_16, and 16_16_16_16, tbuffer_load has a HW defect when
-       // vertex buffer is unaligned. Therefore, we have to split the vertex fetch to component-based ones
-       dfmt != BufDataFormat8_8 && dfmt != BufDataFormat8_8_8_8 && dfmt != BufDataFormat16_16 &&
-       dfmt != BufDataFormat16_16_16_16) ||
+       !unalignedFetchDefect) ||
       formatInfo->compDfmt == dfmt) {
     // NOTE: If the vertex attribute offset is greater than vertex attribute stride, we have to adjust both vertex
     // buffer index and vertex attribute offset accordingly. Otherwise, vertex fetch might behave unexpectedly.
@@ -1145,7 +1375,7 @@ bool VertexFetchImpl::needPatchA2S(const VertexInputDescription *inputDesc) cons
   if (inputDesc->dfmt == BufDataFormat2_10_10_10 || inputDesc->dfmt == BufDataFormat2_10_10_10_Bgra) {
     if (inputDesc->nfmt == BufNumFormatSnorm || inputDesc->nfmt == BufNumFormatSscaled ||
         inputDesc->nfmt == BufNumFormatSint)
-      needPatch = m_lgcContext->getTargetInfo().getGfxIpVersion().major < 9;
+      needPatch = !m_lgcContext->getTargetInfo().getGpuProperty().typedVertexFetch.signedA2;
   }
 
   return needPatch;
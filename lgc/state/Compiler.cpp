@@ -28,22 +28,53 @@
  * @brief LLPC source file: PipelineState methods that do IR linking and compilation
  ***********************************************************************************************************************
  */
+#include "lgc/ElfLinker.h"
 #include "lgc/LgcContext.h"
 #include "lgc/PassManager.h"
+#include "lgc/builder/BuilderRecorder.h"
 #include "lgc/patch/Patch.h"
 #include "lgc/state/PipelineState.h"
+#include "lgc/util/IsaStats.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <thread>
 
 #define DEBUG_TYPE "lgc-compiler"
 
 using namespace lgc;
 using namespace llvm;
 
+// -emit-lgc-bc: emit a serialized recorded module (LLVM bitcode) suitable for input to LGC in another process
+static cl::opt<bool> EmitLgcBc("emit-lgc-bc",
+                               cl::desc("Emit a serialized recorded module suitable for input to LGC (middle-end "
+                                        "compiler) in another process"),
+                               cl::init(false));
+
+// -parallel-codegen: run backend codegen of each hardware shader stage of a whole graphics pipeline on its own thread
+static cl::opt<bool> ParallelCodeGen("parallel-codegen",
+                                     cl::desc("Run backend codegen of each hardware shader stage of a whole graphics "
+                                              "pipeline on its own thread, then link the stage ELFs"),
+                                     cl::init(false));
+
+// Name of the named metadata node that marks a serialized recorded module, and records its format version and
+// the target it was recorded for
+static const char RecordedModuleMetadataName[] = "lgc.recorded.module";
+
+// Format version of a serialized recorded module. This needs to be bumped whenever LGC changes in such a way that a
+// recorded module written by an older LGC would no longer compile correctly, for example when the operands of an
+// lgc.create.* call or the layout of some pipeline state metadata changes.
+static const unsigned RecordedModuleVersion = 1;
+
 namespace lgc {
 // Create BuilderReplayer pass
 ModulePass *createLegacyBuilderReplayer(Pipeline *pipeline);
@@ -115,6 +146,10 @@ Module *PipelineState::irLink(ArrayRef<Module *> modules, PipelineLink pipelineL
       if (!func.isDeclaration() && !isShaderEntryPoint(&func))
         setShaderStage(&func, stage);
     }
+
+    // If the shader module comes from a shader compile (for example it was translated in its own context), pick up
+    // the shader modes it recorded. This does nothing if the front-end set the modes in this pipeline.
+    getShaderModes()->readModesFromShader(module, stage);
   }
 
 #ifndef NDEBUG
@@ -183,6 +218,12 @@ bool PipelineState::generate(std::unique_ptr<Module> pipelineModule, raw_pwrite_
                              bool newPassManager) {
   m_lastError.clear();
 
+  if (EmitLgcBc && !m_noReplayer) {
+    // -emit-lgc-bc: Just write the serialized recorded module.
+    writeRecordedModule(&*pipelineModule, outStream);
+    return true;
+  }
+
   if (newPassManager)
     generateWithNewPassManager(std::move(pipelineModule), outStream, checkShaderCacheFunc, timers);
   else
@@ -192,14 +233,46 @@ bool PipelineState::generate(std::unique_ptr<Module> pipelineModule, raw_pwrite_
   return getLastError() == "";
 }
 
+// =====================================================================================================================
+// Generate pipeline module as above, writing the output directly into the caller's buffer, which the steps that finish
+// the ELF after codegen then work on in place.
+//
+// @param pipelineModule : IR pipeline module
+// @param [out] outBuffer : Buffer to write ELF or IR disassembly output to; previous contents are discarded
+// @param checkShaderCacheFunc : Function to check shader cache in graphics pipeline
+// @param timers : Optional timers, as for the other generate()
+// @param newPassManager : Whether to use the new pass manager or not.
+// @returns : As for the other generate()
+bool PipelineState::generate(std::unique_ptr<Module> pipelineModule, SmallVectorImpl<char> &outBuffer,
+                             Pipeline::CheckShaderCacheFunc checkShaderCacheFunc, ArrayRef<Timer *> timers,
+                             bool newPassManager) {
+  outBuffer.clear();
+  raw_svector_ostream outStream(outBuffer);
+  m_outBuffer = &outBuffer;
+  bool result = generate(std::move(pipelineModule), outStream, checkShaderCacheFunc, timers, newPassManager);
+  m_outBuffer = nullptr;
+  return result;
+}
+
 void PipelineState::generateWithNewPassManager(std::unique_ptr<Module> pipelineModule, raw_pwrite_stream &outStream,
                                                Pipeline::CheckShaderCacheFunc checkShaderCacheFunc,
                                                ArrayRef<Timer *> timers) {
   unsigned passIndex = 1000;
   Timer *patchTimer = timers.size() >= 1 ? timers[0] : nullptr;
   Timer *optTimer = timers.size() >= 2 ? timers[1] : nullptr;
+  Timer *codeGenTimer = timers.size() >= 3 ? timers[2] : nullptr;
 
-  // Set up "whole pipeline" passes, where we have a single module representing the whole pipeline.
+  // The fast compile tier does codegen at -O1 at most. The target machine is kept for later compiles, so its
+  // optimization level is put back afterwards.
+  TargetMachine *targetMachine = getLgcContext()->getTargetMachine();
+  const CodeGenOpt::Level optLevel = targetMachine->getOptLevel();
+  if (getOptions().fastCompile)
+    targetMachine->setOptLevel(std::min(optLevel, CodeGenOpt::Less));
+  auto restoreOptLevel = make_scope_exit([targetMachine, optLevel] { targetMachine->setOptLevel(optLevel); });
+
+  // Set up "whole pipeline" passes, where we have a single module representing the whole pipeline. All the patch and
+  // optimization passes share the analysis managers of this pass manager, so an analysis such as the divergence
+  // analysis or a dominator tree is computed once and reused by the later passes, until a pass invalidates it.
   std::unique_ptr<lgc::PassManager> passMgr(lgc::PassManager::Create());
   passMgr->setPassIndex(&passIndex);
   passMgr->registerFunctionAnalysis([&] { return getLgcContext()->getTargetMachine()->getTargetIRAnalysis(); });
@@ -222,18 +295,43 @@ void PipelineState::generateWithNewPassManager(std::unique_ptr<Module> pipelineM
     passMgr->addPass(PrintModulePass(outStream));
   else {
     // Patching.
-    Patch::addPasses(this, *passMgr, m_noReplayer, patchTimer, optTimer, checkShaderCacheFunc);
+    Patch::addPasses(this, *passMgr, !m_noReplayer, patchTimer, optTimer, checkShaderCacheFunc);
 
     // Add pass to clear pipeline state from IR
     passMgr->addPass(PipelineStateClearer());
-
-    // TODO: Add code generation passes
   }
 
   // Run the "whole pipeline" passes.
   passMgr->run(*pipelineModule);
 
-  report_fatal_error("The new pass manager is not fully implemented yet.");
+  if (m_emitLgc)
+    return;
+
+  // Code generation. The LLVM codegen passes only run in the legacy pass manager, so they get a pass manager of their
+  // own, run on the patched module. -parallel-codegen and -isa-stats are handled as in generateWithLegacyPassManager.
+  bool parallelCodeGen = useParallelCodeGen();
+  if (parallelCodeGen) {
+    generateHwStagesInParallel(*pipelineModule, outStream, codeGenTimer);
+    return;
+  }
+
+  bool isaStats = isIsaStatsEnabled() && LgcContext::emitsElf();
+  bool isaStatsInPlace = isaStats && m_outBuffer;
+  SmallString<0> isaStatsElf;
+  raw_svector_ostream isaStatsStream(isaStatsElf);
+  std::unique_ptr<LegacyPassManager> codeGenPassMgr(LegacyPassManager::Create());
+  codeGenPassMgr->setPassIndex(&passIndex);
+  codeGenPassMgr->add(createTargetTransformInfoWrapperPass(targetMachine->getTargetIRAnalysis()));
+  getLgcContext()->preparePassManager(&*codeGenPassMgr);
+  getLgcContext()->addTargetPasses(*codeGenPassMgr, codeGenTimer,
+                                   isaStats && !isaStatsInPlace ? isaStatsStream : outStream);
+  codeGenPassMgr->run(*pipelineModule);
+
+  if (isaStats) {
+    addIsaStatsToElf(isaStatsInPlace ? *m_outBuffer : isaStatsElf, *targetMachine, LgcContext::getLgcOuts());
+    if (!isaStatsInPlace)
+      outStream << isaStatsElf;
+  }
 }
 
 void PipelineState::generateWithLegacyPassManager(std::unique_ptr<Module> pipelineModule, raw_pwrite_stream &outStream,
@@ -245,6 +343,14 @@ void PipelineState::generateWithLegacyPassManager(std::unique_ptr<Module> pipeli
   Timer *optTimer = timers.size() >= 2 ? timers[1] : nullptr;
   Timer *codeGenTimer = timers.size() >= 3 ? timers[2] : nullptr;
 
+  // The fast compile tier does codegen at -O1 at most. The target machine is kept for later compiles, so its
+  // optimization level is put back afterwards.
+  TargetMachine *targetMachine = getLgcContext()->getTargetMachine();
+  const CodeGenOpt::Level optLevel = targetMachine->getOptLevel();
+  if (getOptions().fastCompile)
+    targetMachine->setOptLevel(std::min(optLevel, CodeGenOpt::Less));
+  auto restoreOptLevel = make_scope_exit([targetMachine, optLevel] { targetMachine->setOptLevel(optLevel); });
+
   // Set up "whole pipeline" passes, where we have a single module representing the whole pipeline.
   std::unique_ptr<LegacyPassManager> passMgr(LegacyPassManager::Create());
   passMgr->setPassIndex(&passIndex);
@@ -279,11 +385,284 @@ void PipelineState::generateWithLegacyPassManager(std::unique_ptr<Module> pipeli
   // Add pass to clear pipeline state from IR
   passMgr->add(createLegacyPipelineStateClearer());
 
-  // Code generation.
-  getLgcContext()->addTargetPasses(*passMgr, codeGenTimer, outStream);
+  // Code generation. With -parallel-codegen, a whole graphics pipeline instead stops after patching, and does the
+  // codegen of each of its hardware shader stages separately below.
+  bool parallelCodeGen = useParallelCodeGen();
+  // With -isa-stats, the ELF is generated into a buffer, to add the ISA statistics to its PAL metadata; that is the
+  // caller's buffer if generate() was given one. The ELF linker adds them itself for -parallel-codegen.
+  bool isaStats = isIsaStatsEnabled() && !m_emitLgc && LgcContext::emitsElf() && !parallelCodeGen;
+  bool isaStatsInPlace = isaStats && m_outBuffer;
+  SmallString<0> isaStatsElf;
+  raw_svector_ostream isaStatsStream(isaStatsElf);
+  if (!parallelCodeGen) {
+    getLgcContext()->addTargetPasses(*passMgr, codeGenTimer,
+                                     isaStats && !isaStatsInPlace ? isaStatsStream : outStream);
+  }
 
   // Run the "whole pipeline" passes.
   passMgr->run(*pipelineModule);
+
+  if (isaStats) {
+    addIsaStatsToElf(isaStatsInPlace ? *m_outBuffer : isaStatsElf, *getLgcContext()->getTargetMachine(),
+                     LgcContext::getLgcOuts());
+    if (!isaStatsInPlace)
+      outStream << isaStatsElf;
+  }
+
+  if (parallelCodeGen)
+    generateHwStagesInParallel(*pipelineModule, outStream, codeGenTimer);
+}
+
+// =====================================================================================================================
+// Test whether to do the codegen of each hardware shader stage of the pipeline on its own thread, which is done for a
+// whole graphics pipeline with -parallel-codegen. That is not done when any output other than the ELF is wanted, or
+// for a pipeline without an FS, as the ELF linker would add a null FS to it.
+bool PipelineState::useParallelCodeGen() const {
+  return ParallelCodeGen && isWholePipeline() && isGraphics() &&
+         (getShaderStageMask() & shaderStageToMask(ShaderStageFragment)) && !m_emitLgc && !LgcContext::getLgcOuts() &&
+         LgcContext::emitsElf();
+}
+
+// =====================================================================================================================
+// Test whether a function is the entry-point of a hardware shader stage, going by its calling convention.
+//
+// @param func : Function to test
+static bool isHwStageEntryPoint(const Function &func) {
+  if (func.isDeclaration())
+    return false;
+  switch (func.getCallingConv()) {
+  case CallingConv::AMDGPU_CS:
+  case CallingConv::AMDGPU_PS:
+  case CallingConv::AMDGPU_VS:
+  case CallingConv::AMDGPU_GS:
+  case CallingConv::AMDGPU_ES:
+  case CallingConv::AMDGPU_HS:
+  case CallingConv::AMDGPU_LS:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// =====================================================================================================================
+// Collect the global values that a function refers to, directly, through the functions it calls, or through the
+// initializers of the global variables it uses.
+//
+// @param func : Function to start from
+// @param [in/out] globals : Set to add the global values (including the function itself) to
+static void collectReferencedGlobals(Function *func, SmallPtrSetImpl<const GlobalValue *> &globals) {
+  SmallVector<const Value *, 16> worklist;
+  worklist.push_back(func);
+  while (!worklist.empty()) {
+    const Value *value = worklist.pop_back_val();
+    if (auto globalValue = dyn_cast<GlobalValue>(value)) {
+      if (!globals.insert(globalValue).second)
+        continue;
+      if (auto callee = dyn_cast<Function>(globalValue)) {
+        for (const Instruction &inst : instructions(callee)) {
+          for (const Value *operand : inst.operands()) {
+            if (isa<Constant>(operand))
+              worklist.push_back(operand);
+          }
+        }
+      } else if (auto globalVar = dyn_cast<GlobalVariable>(globalValue)) {
+        if (globalVar->hasInitializer())
+          worklist.push_back(globalVar->getInitializer());
+      }
+    } else if (auto constant = dyn_cast<Constant>(value)) {
+      // A constant expression or aggregate may refer to global values in its operands.
+      for (const Value *operand : constant->operands()) {
+        if (isa<Constant>(operand))
+          worklist.push_back(operand);
+      }
+    }
+  }
+}
+
+// =====================================================================================================================
+// Run backend codegen on a module containing a single hardware shader stage, in its own LLVMContext and LgcContext,
+// so that this can be done concurrently with the other stages of the pipeline.
+//
+// @param bitcode : The module, as bitcode
+// @param gpuName : LLVM GPU name of the target
+// @param palAbiVersion : PAL pipeline ABI version to compile for
+// @param optLevel : Codegen optimization level
+// @param [out] elf : Buffer to write the ELF to
+static void generateHwStage(StringRef bitcode, StringRef gpuName, unsigned palAbiVersion, CodeGenOpt::Level optLevel,
+                            SmallVectorImpl<char> &elf) {
+  LLVMContext context;
+  std::unique_ptr<LgcContext> lgcContext(LgcContext::Create(context, gpuName, palAbiVersion));
+  lgcContext->getTargetMachine()->setOptLevel(optLevel);
+  std::unique_ptr<Module> module = cantFail(parseBitcodeFile(MemoryBufferRef(bitcode, "lgcHwStage"), context));
+
+  std::unique_ptr<LegacyPassManager> passMgr(LegacyPassManager::Create());
+  passMgr->add(createTargetTransformInfoWrapperPass(lgcContext->getTargetMachine()->getTargetIRAnalysis()));
+  lgcContext->preparePassManager(&*passMgr);
+  raw_svector_ostream elfStream(elf);
+  lgcContext->addTargetPasses(*passMgr, nullptr, elfStream);
+  passMgr->run(*module);
+}
+
+// =====================================================================================================================
+// Do backend codegen on a patched whole pipeline module with each hardware shader stage in a module of its own, each
+// on its own thread, then link the resulting ELFs into the pipeline ELF. Each stage's ELF has the whole pipeline's PAL
+// metadata, plus the register settings for its own stage from codegen, so the merging of PAL metadata in the ELF
+// linker gives the same result as codegen of the whole module. If there is only one hardware stage, or the stages
+// share some function or global variable, the module is instead generated in one piece.
+//
+// @param [in/out] pipelineModule : Patched pipeline module
+// @param [out] outStream : Stream to write the pipeline ELF to
+// @param codeGenTimer : Timer to time the codegen with, nullptr if not timing
+void PipelineState::generateHwStagesInParallel(Module &pipelineModule, raw_pwrite_stream &outStream,
+                                               Timer *codeGenTimer) {
+  if (codeGenTimer)
+    codeGenTimer->startTimer();
+
+  // Find the hardware stage entry-points, and the global values used by each one.
+  SmallVector<Function *, 4> entryPoints;
+  for (Function &func : pipelineModule) {
+    if (isHwStageEntryPoint(func))
+      entryPoints.push_back(&func);
+  }
+  SmallVector<SmallPtrSet<const GlobalValue *, 16>, 4> stageGlobals(entryPoints.size());
+  SmallPtrSet<const GlobalValue *, 16> allGlobals;
+  bool canSplit = entryPoints.size() >= 2;
+  for (unsigned stageIdx = 0; canSplit && stageIdx != entryPoints.size(); ++stageIdx) {
+    collectReferencedGlobals(entryPoints[stageIdx], stageGlobals[stageIdx]);
+    for (const GlobalValue *globalValue : stageGlobals[stageIdx]) {
+      if (!allGlobals.insert(globalValue).second && !globalValue->isDeclaration())
+        canSplit = false;
+    }
+  }
+
+  if (!canSplit) {
+    std::unique_ptr<LegacyPassManager> passMgr(LegacyPassManager::Create());
+    passMgr->add(createTargetTransformInfoWrapperPass(getLgcContext()->getTargetMachine()->getTargetIRAnalysis()));
+    getLgcContext()->preparePassManager(&*passMgr);
+    getLgcContext()->addTargetPasses(*passMgr, nullptr, outStream);
+    passMgr->run(pipelineModule);
+  } else {
+    // Clone a module for each stage, with just the definitions that stage uses, and write it as bitcode to be read
+    // into the stage's own LLVMContext.
+    SmallVector<SmallString<0>, 4> stageBitcodes(entryPoints.size());
+    for (unsigned stageIdx = 0; stageIdx != entryPoints.size(); ++stageIdx) {
+      ValueToValueMapTy valueMap;
+      std::unique_ptr<Module> stageModule = CloneModule(pipelineModule, valueMap, [&](const GlobalValue *globalValue) {
+        return stageGlobals[stageIdx].count(globalValue) != 0;
+      });
+      // The definitions that were not cloned have become unused declarations, so remove them.
+      for (Function &func : make_early_inc_range(*stageModule)) {
+        if (func.isDeclaration() && func.use_empty())
+          func.eraseFromParent();
+      }
+      for (GlobalVariable &globalVar : make_early_inc_range(stageModule->globals())) {
+        if (globalVar.isDeclaration() && globalVar.use_empty())
+          globalVar.eraseFromParent();
+      }
+      raw_svector_ostream bitcodeStream(stageBitcodes[stageIdx]);
+      WriteBitcodeToFile(*stageModule, bitcodeStream);
+    }
+
+    // Do the codegen of the first stage on this thread, and of each other stage on a thread of its own.
+    StringRef gpuName = getLgcContext()->getTargetMachine()->getTargetCPU();
+    unsigned palAbiVersion = getLgcContext()->getPalAbiVersion();
+    CodeGenOpt::Level optLevel = getLgcContext()->getTargetMachine()->getOptLevel();
+    SmallVector<SmallString<0>, 4> stageElfs(entryPoints.size());
+    SmallVector<std::thread, 4> threads;
+    for (unsigned stageIdx = 1; stageIdx != entryPoints.size(); ++stageIdx) {
+      threads.emplace_back(generateHwStage, StringRef(stageBitcodes[stageIdx]), gpuName, palAbiVersion, optLevel,
+                           std::ref(stageElfs[stageIdx]));
+    }
+    generateHwStage(stageBitcodes[0], gpuName, palAbiVersion, optLevel, stageElfs[0]);
+    for (std::thread &thread : threads)
+      thread.join();
+
+    // Link the stage ELFs into the pipeline ELF, in the order of their entry-points, so that the pipeline ELF does not
+    // depend on which stage finished first. Each stage ELF is named after its entry-point, as the linker names the
+    // local symbols that it makes for relocations after the ELF they are in.
+    SmallVector<MemoryBufferRef, 4> elfs;
+    for (unsigned stageIdx = 0; stageIdx != entryPoints.size(); ++stageIdx)
+      elfs.push_back(MemoryBufferRef(stageElfs[stageIdx], entryPoints[stageIdx]->getName()));
+    // Link straight into the caller's buffer if generate() was given one.
+    std::unique_ptr<ElfLinker> elfLinker(createElfLinker(elfs));
+    if (m_outBuffer ? !elfLinker->link(*m_outBuffer) : !elfLinker->link(outStream))
+      report_fatal_error("Failed to link the ELFs of the hardware shader stages");
+  }
+
+  if (codeGenTimer)
+    codeGenTimer->stopTimer();
+}
+
+// =====================================================================================================================
+// Write the pipeline module returned by irLink() as a serialized recorded module, so the rest of the compile can be
+// run by a different process, possibly with a different build of LGC. This can only be used if the front-end used a
+// BuilderRecorder, in which case the pipeline state is in the module's IR metadata just as generate() expects.
+//
+// @param [in/out] pipelineModule : IR pipeline module returned by irLink()
+// @param [out] outStream : Stream to write the serialized module to
+void PipelineState::writeRecordedModule(Module *pipelineModule, raw_ostream &outStream) {
+  assert(!m_noReplayer && "Recorded module needs the front-end to use a BuilderRecorder");
+
+  // The pipeline state is already in the module's IR metadata, as irLink() recorded it. Remove the opcode metadata
+  // from lgc.create.* declarations; the BuilderReplayer in the reading LGC then gets each opcode from the
+  // declaration's name, which does not change when a Builder method is added or removed.
+  unsigned opcodeMetaKindId = pipelineModule->getContext().getMDKindID(BuilderCallOpcodeMetadataName);
+  for (Function &func : *pipelineModule) {
+    if (func.isDeclaration() && func.getName().startswith(BuilderCallPrefix))
+      func.setMetadata(opcodeMetaKindId, nullptr);
+  }
+
+  // Mark the module with the format version and the target.
+  LLVMContext &context = pipelineModule->getContext();
+  Type *int32Ty = Type::getInt32Ty(context);
+  Metadata *operands[] = {
+      ConstantAsMetadata::get(ConstantInt::get(int32Ty, RecordedModuleVersion)),
+      MDString::get(context, getLgcContext()->getTargetMachine()->getTargetCPU()),
+      ConstantAsMetadata::get(ConstantInt::get(int32Ty, getLgcContext()->getPalAbiVersion())),
+  };
+  NamedMDNode *namedMetaNode = pipelineModule->getOrInsertNamedMetadata(RecordedModuleMetadataName);
+  namedMetaNode->clearOperands();
+  namedMetaNode->addOperand(MDNode::get(context, operands));
+
+  WriteBitcodeToFile(*pipelineModule, outStream);
+
+  // Leave the module as it was apart from the opcode metadata, so it can still be passed to generate().
+  pipelineModule->eraseNamedMetadata(namedMetaNode);
+}
+
+// =====================================================================================================================
+// Read a serialized recorded module written by writeRecordedModule(). This is a static method in Pipeline, as the
+// client needs the target returned by it to create the LgcContext (and thus the Pipeline) that compiles the module.
+//
+// @param blob : Serialized recorded module
+// @param context : LLVMContext to read the module into
+// @param [out] target : Target that the module was recorded for
+// @returns : The module, or nullptr if the blob is not a recorded module in a format version that this LGC can read
+std::unique_ptr<Module> Pipeline::readRecordedModule(MemoryBufferRef blob, LLVMContext &context,
+                                                     RecordedModuleTarget *target) {
+  Expected<std::unique_ptr<Module>> moduleOrErr = parseBitcodeFile(blob, context);
+  if (!moduleOrErr) {
+    consumeError(moduleOrErr.takeError());
+    return nullptr;
+  }
+  std::unique_ptr<Module> module = std::move(*moduleOrErr);
+
+  NamedMDNode *namedMetaNode = module->getNamedMetadata(RecordedModuleMetadataName);
+  if (!namedMetaNode || namedMetaNode->getNumOperands() != 1)
+    return nullptr;
+  MDNode *metaNode = namedMetaNode->getOperand(0);
+  if (metaNode->getNumOperands() != 3)
+    return nullptr;
+  auto version = mdconst::dyn_extract<ConstantInt>(metaNode->getOperand(0));
+  auto gpuName = dyn_cast<MDString>(metaNode->getOperand(1));
+  auto palAbiVersion = mdconst::dyn_extract<ConstantInt>(metaNode->getOperand(2));
+  if (!version || version->getZExtValue() != RecordedModuleVersion || !gpuName || !palAbiVersion)
+    return nullptr;
+
+  target->gpuName = gpuName->getString().str();
+  target->palAbiVersion = palAbiVersion->getZExtValue();
+  module->eraseNamedMetadata(namedMetaNode);
+  return module;
 }
 
 // =====================================================================================================================
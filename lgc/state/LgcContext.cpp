@@ -120,39 +120,55 @@ static void setOptionDefault(const char *name, StringRef value) {
 // allowed to call it again after that. It must also be called before LLVM command-line processing, so
 // that you can use a pass name in an option such as -print-after. If multiple concurrent compiles are
 // possible, this should be called in a thread-safe way.
-void LgcContext::initialize() {
+//
+// @param lazy : Whether to initialize only what the default compile path needs
+void LgcContext::initialize(bool lazy) {
 #ifndef NDEBUG
   Initialized = true;
 #endif
+  static bool BaseInitialized = false;
+  static bool FullyInitialized = false;
 
   auto &passRegistry = *PassRegistry::getPassRegistry();
 
-  // Initialize LLVM target: AMDGPU
-  LLVMInitializeAMDGPUTargetInfo();
-  LLVMInitializeAMDGPUTarget();
-  LLVMInitializeAMDGPUTargetMC();
-  LLVMInitializeAMDGPUAsmPrinter();
-  LLVMInitializeAMDGPUAsmParser();
-  LLVMInitializeAMDGPUDisassembler();
-
-  // Initialize core LLVM passes so they can be referenced by -stop-before etc.
-  initializeCore(passRegistry);
-  initializeTransformUtils(passRegistry);
-  initializeScalarOpts(passRegistry);
-  initializeVectorization(passRegistry);
-  initializeInstCombine(passRegistry);
-  initializeAggressiveInstCombine(passRegistry);
-  initializeIPO(passRegistry);
-  initializeCodeGen(passRegistry);
-  initializeShadowStackGCLoweringPass(passRegistry);
-  initializeExpandReductionsPass(passRegistry);
-  initializeRewriteSymbolsLegacyPassPass(passRegistry);
-
-  // Initialize LGC passes so they can be referenced by -stop-before etc.
-  initializeUtilPasses(passRegistry);
-  initializeStatePasses(passRegistry);
-  initializeLegacyBuilderReplayerPass(passRegistry);
-  initializePatchPasses(passRegistry);
+  if (!BaseInitialized) {
+    BaseInitialized = true;
+
+    // Initialize LLVM target: AMDGPU
+    LLVMInitializeAMDGPUTargetInfo();
+    LLVMInitializeAMDGPUTarget();
+    LLVMInitializeAMDGPUTargetMC();
+    LLVMInitializeAMDGPUAsmPrinter();
+
+    // Initialize the LLVM passes that codegen adds by pass ID, and the core LLVM passes.
+    initializeCore(passRegistry);
+    initializeCodeGen(passRegistry);
+
+    // Initialize LGC passes so they can be referenced by -stop-before etc.
+    initializeUtilPasses(passRegistry);
+    initializeStatePasses(passRegistry);
+    initializeLegacyBuilderReplayerPass(passRegistry);
+    initializePatchPasses(passRegistry);
+  }
+
+  if (!lazy && !FullyInitialized) {
+    FullyInitialized = true;
+
+    LLVMInitializeAMDGPUAsmParser();
+    LLVMInitializeAMDGPUDisassembler();
+
+    // Initialize the other LLVM passes so they can be referenced by -stop-before etc. (They register themselves when
+    // they are created, so this is not needed to run them.)
+    initializeTransformUtils(passRegistry);
+    initializeScalarOpts(passRegistry);
+    initializeVectorization(passRegistry);
+    initializeInstCombine(passRegistry);
+    initializeAggressiveInstCombine(passRegistry);
+    initializeIPO(passRegistry);
+    initializeShadowStackGCLoweringPass(passRegistry);
+    initializeExpandReductionsPass(passRegistry);
+    initializeRewriteSymbolsLegacyPassPass(passRegistry);
+  }
 
   // Initialize some command-line option defaults.
   setOptionDefault("filetype", "obj");
@@ -218,9 +234,15 @@ bool LgcContext::isGpuNameValid(llvm::StringRef gpuName) {
 // @param context : LLVM context to give each Builder
 // @param gpuName : LLVM GPU name (e.g. "gfx900"); empty to use -mcpu option setting
 // @param palAbiVersion : PAL pipeline ABI version to compile for
-LgcContext *LgcContext::Create(LLVMContext &context, StringRef gpuName, unsigned palAbiVersion) {
+// @param targetMachine : Optional target machine taken from an earlier LgcContext, to use instead of creating a new
+//                        one if it is for the same target and options. The LgcContext takes ownership of it.
+LgcContext *LgcContext::Create(LLVMContext &context, StringRef gpuName, unsigned palAbiVersion,
+                               TargetMachine *targetMachine) {
   assert(Initialized && "Must call LgcContext::Initialize before LgcContext::Create");
 
+  // The asm parser is needed to emit inline assembly. It is not initialized by a lazy LgcContext::initialize.
+  LLVMInitializeAMDGPUAsmParser();
+
   LgcContext *builderContext = new LgcContext(context, palAbiVersion);
 
   std::string mcpuName = codegen::getMCPU(); // -mcpu setting from llvm/CodeGen/CommandFlags.h
@@ -230,10 +252,22 @@ LgcContext *LgcContext::Create(LLVMContext &context, StringRef gpuName, unsigned
   builderContext->m_targetInfo = new TargetInfo;
   // If we can't set the target info it means the gpuName isn't valid
   if (!builderContext->m_targetInfo->setTargetInfo(gpuName)) {
+    delete targetMachine;
     delete builderContext;
     return nullptr;
   }
 
+  // Reuse the given target machine if it was created the same way as we would create it below. A target machine
+  // does not refer to any LLVMContext, so it can be carried over to an LgcContext with a new one.
+  if (targetMachine) {
+    if (targetMachine->getTargetCPU() == gpuName && targetMachine->getOptLevel() == cl::OptLevel &&
+        targetMachine->Options.MCOptions.ShowMCEncoding == ShowEncoding) {
+      builderContext->m_targetMachine = targetMachine;
+      return builderContext;
+    }
+    delete targetMachine;
+  }
+
   // Get the LLVM target and create the target machine. This should not fail, as we determined above
   // that we support the requested target.
   const std::string triple = "amdgcn--amdpal";
@@ -272,6 +306,15 @@ LgcContext::~LgcContext() {
   delete m_passManagerCache;
 }
 
+// =====================================================================================================================
+// Take the target machine out of this LgcContext, so it can be given to a new LgcContext that replaces this one.
+// The caller takes ownership of it.
+TargetMachine *LgcContext::takeTargetMachine() {
+  TargetMachine *targetMachine = m_targetMachine;
+  m_targetMachine = nullptr;
+  return targetMachine;
+}
+
 // =====================================================================================================================
 // Create a Pipeline object for a pipeline compile.
 // This actually creates a PipelineState, but returns the Pipeline superclass that is visible to
@@ -381,6 +424,13 @@ void LgcContext::addTargetPasses(lgc::LegacyPassManager &passMgr, Timer *codeGen
     passMgr.add(createStartStopTimer(codeGenTimer, false));
 }
 
+// =====================================================================================================================
+// Test whether addTargetPasses emits an ELF object, rather than LLVM IR (for "-emit-llvm" or "-emit-llvm-bc") or ISA
+// assembly (for "-filetype=asm")
+bool LgcContext::emitsElf() {
+  return !EmitLlvm && !EmitLlvmBc && codegen::getFileType() == CGFT_ObjectFile;
+}
+
 // =====================================================================================================================
 // Get pass manager cache
 PassManagerCache *LgcContext::getPassManagerCache() {
@@ -82,6 +82,15 @@ msgpack::ArrayDocNode buildArrayDocNode(msgpack::Document *document, Hash128 has
     childNode[i] = hash[i];
   return childNode;
 }
+
+// =====================================================================================================================
+// Compares a pending register value with a register number, for looking up pending register values.
+//
+// @param entry : The register number and the pending value
+// @param regNum : The register number to compare with
+bool pendingRegisterLess(const std::pair<unsigned, unsigned> &entry, unsigned regNum) {
+  return entry.first < regNum;
+}
 } // namespace
 
 // =====================================================================================================================
@@ -152,6 +161,8 @@ void PalMetadata::initialize() {
 //
 // @param module : Pipeline IR module
 void PalMetadata::record(Module *module) {
+  flushRegisters();
+
   // Add the metadata version number.
   auto versionNode = m_document->getRoot().getMap(true)[Util::Abi::PalCodeObjectMetadataKey::Version].getArray(true);
   versionNode[0] = Util::Abi::PipelineMetadataMajorVersion;
@@ -180,6 +191,8 @@ void PalMetadata::record(Module *module) {
 // @param blob : MsgPack PAL metadata to merge
 // @param isGlueCode : True if the blob was generated for glue code.
 void PalMetadata::mergeFromBlob(llvm::StringRef blob, bool isGlueCode) {
+  flushRegisters();
+
   // Use msgpack::Document::readFromBlob to read the new MsgPack PAL metadata, merging it into the msgpack::Document
   // we already have. We pass it a lambda that determines how to cope with merge conflicts, which returns:
   // -1: failure
@@ -388,7 +401,7 @@ void PalMetadata::setUserDataEntry(ShaderStage stage, unsigned userDataIndex, un
   // Write the register(s)
   userDataReg += userDataIndex;
   while (dwordCount--)
-    m_registers[userDataReg++] = userDataValue++;
+    getPendingRegister(userDataReg++) = userDataValue++;
 }
 
 // =====================================================================================================================
@@ -405,6 +418,8 @@ void PalMetadata::setUserDataSpillUsage(unsigned dwordOffset) {
 // Fix up user data registers. Any user data register that has one of the unlinked UserDataMapping values defined
 // in AbiUnlinked.h is fixed up by looking at pipeline state.
 void PalMetadata::fixUpRegisters() {
+  flushRegisters();
+
   static const std::pair<unsigned, unsigned> ComputeRegRanges[] = {{mmCOMPUTE_USER_DATA_0, 16}};
   static const std::pair<unsigned, unsigned> Gfx8RegRanges[] = {
       {mmSPI_SHADER_USER_DATA_PS_0, 16}, {mmSPI_SHADER_USER_DATA_VS_0, 16}, {mmSPI_SHADER_USER_DATA_GS_0, 16},
@@ -589,6 +604,10 @@ void PalMetadata::finalizePipeline(bool isWholePipeline) {
 //
 // @param regNum : Register number
 unsigned PalMetadata::getRegister(unsigned regNum) {
+  auto pendingIt = lower_bound(m_pendingRegisters, regNum, pendingRegisterLess);
+  if (pendingIt != m_pendingRegisters.end() && pendingIt->first == regNum)
+    return pendingIt->second;
+
   auto mapIt = m_registers.find(m_document->getNode(regNum));
   if (mapIt == m_registers.end()) {
     return 0;
@@ -605,10 +624,35 @@ unsigned PalMetadata::getRegister(unsigned regNum) {
 // @param regNum : Register number
 // @param value : Value to OR in
 void PalMetadata::setRegister(unsigned regNum, unsigned value) {
-  msgpack::DocNode &node = m_registers[regNum];
-  if (node.getKind() == msgpack::Type::UInt)
-    value |= node.getUInt();
-  node = value;
+  getPendingRegister(regNum) |= value;
+}
+
+// =====================================================================================================================
+// Get the pending value of a register, which is to be written into the MsgPack document later. Registers are set many
+// times over while a pipeline is compiled, so they are kept in a small sorted array until the document is needed,
+// rather than finding or inserting a map node each time.
+//
+// @param regNum : Register number
+// @returns : Reference to the pending value, which starts as the value of the register in the document, or 0
+unsigned &PalMetadata::getPendingRegister(unsigned regNum) {
+  auto pendingIt = lower_bound(m_pendingRegisters, regNum, pendingRegisterLess);
+  if (pendingIt == m_pendingRegisters.end() || pendingIt->first != regNum) {
+    unsigned value = 0;
+    auto mapIt = m_registers.find(m_document->getNode(regNum));
+    if (mapIt != m_registers.end() && mapIt->second.getKind() == msgpack::Type::UInt)
+      value = mapIt->second.getUInt();
+    pendingIt = m_pendingRegisters.insert(pendingIt, {regNum, value});
+  }
+  return pendingIt->second;
+}
+
+// =====================================================================================================================
+// Write the pending register values into the MsgPack document, before anything that reads or changes the registers
+// in the document directly.
+void PalMetadata::flushRegisters() {
+  for (const auto &entry : m_pendingRegisters)
+    m_registers[entry.first] = entry.second;
+  m_pendingRegisters.clear();
 }
 
 // =====================================================================================================================
@@ -735,11 +779,30 @@ void PalMetadata::eraseColorExportInfo() {
   m_pipelineNode.erase(m_document->getNode(PipelineMetadataKey::ColorExports));
 }
 
+// =====================================================================================================================
+// Store the layout of the shader profile buffer section of a shader instrumented by -shader-profile, in the
+// .shader_profile map of the API shader: the byte offset of the section, the number of loop regions after the shader
+// region, and the name of the counter instruction that the ticks were read with.
+//
+// @param stage : API shader stage
+// @param offset : Byte offset of the section in the shader profile buffer
+// @param loopCount : Number of instrumented loops
+// @param counter : Name of the counter instruction, "s_memtime" or "s_memrealtime"
+void PalMetadata::setShaderProfileInfo(ShaderStage stage, unsigned offset, unsigned loopCount, StringRef counter) {
+  auto shaderNode =
+      m_pipelineNode[Util::Abi::PipelineMetadataKey::Shaders].getMap(true)[ApiStageNames[stage]].getMap(true);
+  auto profileNode = shaderNode[".shader_profile"].getMap(true);
+  profileNode[".offset"] = offset;
+  profileNode[".loop_count"] = loopCount;
+  profileNode[".counter"] = m_document->getNode(counter, /*copy=*/true);
+}
+
 // =====================================================================================================================
 // Get the VS entry register info. Used by the linker to generate the fetch shader.
 //
 // @param [out] regInfo : Where to store VS entry register info
 void PalMetadata::getVsEntryRegInfo(VsEntryRegInfo &regInfo) {
+  flushRegisters();
   regInfo = {};
   regInfo.callingConv = getCallingConventionForFirstHardwareShaderStage();
   unsigned userDataReg0 = getFirstUserDataReg(regInfo.callingConv);
@@ -61,6 +61,31 @@ static const char IaStateMetadataName[] = "lgc.input.assembly.state";
 static const char RsStateMetadataName[] = "lgc.rasterizer.state";
 static const char ColorExportFormatsMetadataName[] = "lgc.color.export.formats";
 static const char ColorExportStateMetadataName[] = "lgc.color.export.state";
+static const char StateBlobMetadataName[] = "lgc.state.blob";
+
+// -compact-pipeline-state: record the larger parts of pipeline state into IR as a single binary blob
+static cl::opt<bool> CompactPipelineState("compact-pipeline-state",
+                                          cl::desc("Record pipeline options, user data nodes, vertex inputs and color "
+                                                   "export state into IR as a single binary blob"),
+                                          cl::init(false));
+
+// Version of the binary blob form of pipeline state. This needs to be bumped whenever the layout of a section, or of
+// one of the structs that is copied into a section, changes.
+static const unsigned StateBlobVersion = 1;
+
+// Kinds of section in the binary blob form of pipeline state. The blob is an array of dwords: the version, then
+// the sections, each one being a dword of kind, a dword of payload size in dwords, then the payload.
+enum class StateBlobSection : unsigned {
+  Client,             // Client name length in bytes, then the name padded to a dword boundary
+  PipelineLink,       // PipelineLink enum
+  Options,            // Options struct
+  ShaderOptions,      // Shader stage, then ShaderOptions struct
+  UserDataNodes,      // Total node count, top-level node count, then the nodes with each inner table following
+                      //  its DescriptorTableVaPtr node
+  VertexInputs,       // Dwords per element, then array of VertexInputDescription
+  ColorExportFormats, // Dwords per element, then array of ColorExportFormat
+  ColorExportState,   // ColorExportState struct
+};
 
 namespace {
 
@@ -290,6 +315,7 @@ void PipelineState::clear(Module *module) {
   getShaderModes()->clear();
   m_options = {};
   m_userDataNodes = {};
+  invalidateResourceNodeIndex();
   m_deviceIndex = 0;
   m_vertexInputDescriptions.clear();
   m_colorExportFormats.clear();
@@ -305,11 +331,18 @@ void PipelineState::clear(Module *module) {
 // @param [in/out] module : Module to record the IR metadata in
 void PipelineState::record(Module *module) {
   getShaderModes()->record(module);
-  recordOptions(module);
-  recordUserDataNodes(module);
-  recordDeviceIndex(module);
-  recordVertexInputDescriptions(module);
-  recordColorExportState(module);
+  if (CompactPipelineState) {
+    recordStateBlob(module);
+    recordDeviceIndex(module);
+  } else {
+    if (auto blobMetaNode = module->getNamedMetadata(StateBlobMetadataName))
+      module->eraseNamedMetadata(blobMetaNode);
+    recordOptions(module);
+    recordUserDataNodes(module);
+    recordDeviceIndex(module);
+    recordVertexInputDescriptions(module);
+    recordColorExportState(module);
+  }
   recordGraphicsState(module);
   if (m_palMetadata)
     m_palMetadata->record(module);
@@ -322,16 +355,265 @@ void PipelineState::record(Module *module) {
 void PipelineState::readState(Module *module) {
   getShaderModes()->readModesFromPipeline(module);
   readShaderStageMask(module);
-  readOptions(module);
-  readUserDataNodes(module);
+  if (!readStateBlob(module)) {
+    readOptions(module);
+    readUserDataNodes(module);
+    readVertexInputDescriptions(module);
+    readColorExportState(module);
+  }
   readDeviceIndex(module);
-  readVertexInputDescriptions(module);
-  readColorExportState(module);
   readGraphicsState(module);
   if (!m_palMetadata)
     m_palMetadata = new PalMetadata(this, module);
 }
 
+// =====================================================================================================================
+// Record options (including client name and pipeline link kind), user data nodes, vertex input descriptions and
+// color export state into IR as a single binary blob. This is the -compact-pipeline-state alternative to recording
+// them as named metadata: for a large user data node table, it avoids creating an IR metadata node and a constant
+// for every field of every node, and it makes reading them back a matter of copying dwords.
+//
+// @param [in/out] module : Module to record the blob in
+void PipelineState::recordStateBlob(Module *module) {
+  SmallVector<unsigned, 64> blob;
+  blob.push_back(StateBlobVersion);
+  unsigned sectionStart = 0;
+  auto startSection = [&](StateBlobSection kind) {
+    blob.push_back(unsigned(kind));
+    blob.push_back(0);
+    sectionStart = blob.size();
+  };
+  auto endSection = [&] { blob[sectionStart - 1] = blob.size() - sectionStart; };
+  auto appendDwords = [&](const void *data, size_t sizeInBytes) {
+    assert(sizeInBytes % sizeof(unsigned) == 0);
+    const unsigned *dwords = static_cast<const unsigned *>(data);
+    blob.append(dwords, dwords + sizeInBytes / sizeof(unsigned));
+  };
+
+  if (!m_client.empty()) {
+    startSection(StateBlobSection::Client);
+    blob.push_back(m_client.size());
+    size_t nameStart = blob.size();
+    blob.resize(nameStart + alignTo(m_client.size(), sizeof(unsigned)) / sizeof(unsigned));
+    memcpy(&blob[nameStart], m_client.data(), m_client.size());
+    endSection();
+  }
+
+  if (m_pipelineLink != PipelineLink::WholePipeline) {
+    startSection(StateBlobSection::PipelineLink);
+    blob.push_back(unsigned(m_pipelineLink));
+    endSection();
+  }
+
+  startSection(StateBlobSection::Options);
+  appendDwords(&m_options, sizeof(m_options));
+  endSection();
+
+  for (unsigned stage = 0; stage != m_shaderOptions.size(); ++stage) {
+    startSection(StateBlobSection::ShaderOptions);
+    blob.push_back(stage);
+    appendDwords(&m_shaderOptions[stage], sizeof(m_shaderOptions[stage]));
+    endSection();
+  }
+
+  if (!m_userDataNodes.empty()) {
+    startSection(StateBlobSection::UserDataNodes);
+    size_t totalNodeCountIndex = blob.size();
+    blob.push_back(0);
+    blob.push_back(m_userDataNodes.size());
+    unsigned totalNodeCount = 0;
+    std::function<void(ArrayRef<ResourceNode>)> appendTable = [&](ArrayRef<ResourceNode> nodes) {
+      totalNodeCount += nodes.size();
+      for (const ResourceNode &node : nodes) {
+        blob.push_back(unsigned(node.type));
+        blob.push_back(node.offsetInDwords);
+        blob.push_back(node.sizeInDwords);
+        switch (node.type) {
+        case ResourceNodeType::DescriptorTableVaPtr:
+          blob.push_back(node.innerTable.size());
+          appendTable(node.innerTable);
+          break;
+        case ResourceNodeType::IndirectUserDataVaPtr:
+        case ResourceNodeType::StreamOutTableVaPtr:
+          blob.push_back(node.indirectSizeInDwords);
+          break;
+        default:
+          blob.push_back(node.set);
+          blob.push_back(node.binding);
+          blob.push_back(node.stride);
+          blob.push_back(node.immutableSize);
+          appendDwords(node.immutableValue, node.immutableSize * DescriptorSizeSamplerInDwords * sizeof(unsigned));
+          break;
+        }
+      }
+    };
+    appendTable(m_userDataNodes);
+    blob[totalNodeCountIndex] = totalNodeCount;
+    endSection();
+  }
+
+  if (!m_vertexInputDescriptions.empty()) {
+    startSection(StateBlobSection::VertexInputs);
+    blob.push_back(sizeof(VertexInputDescription) / sizeof(unsigned));
+    appendDwords(m_vertexInputDescriptions.data(), m_vertexInputDescriptions.size() * sizeof(VertexInputDescription));
+    endSection();
+  }
+
+  if (!m_colorExportFormats.empty()) {
+    startSection(StateBlobSection::ColorExportFormats);
+    blob.push_back(sizeof(ColorExportFormat) / sizeof(unsigned));
+    appendDwords(m_colorExportFormats.data(), m_colorExportFormats.size() * sizeof(ColorExportFormat));
+    endSection();
+  }
+
+  startSection(StateBlobSection::ColorExportState);
+  appendDwords(&m_colorExportState, sizeof(m_colorExportState));
+  endSection();
+
+  // Remove any named metadata that the blob supersedes, such as from IR assembly that was written without
+  // -compact-pipeline-state.
+  for (StringRef metaName : {ClientMetadataName, UnlinkedMetadataName, OptionsMetadataName, UserDataMetadataName,
+                             VertexInputsMetadataName, ColorExportFormatsMetadataName, ColorExportStateMetadataName}) {
+    if (auto namedMetaNode = module->getNamedMetadata(metaName))
+      module->eraseNamedMetadata(namedMetaNode);
+  }
+  for (unsigned stage = 0; stage != ShaderStageCompute + 1; ++stage) {
+    std::string metaName =
+        (Twine(OptionsMetadataName) + "." + getShaderStageAbbreviation(static_cast<ShaderStage>(stage))).str();
+    if (auto namedMetaNode = module->getNamedMetadata(metaName))
+      module->eraseNamedMetadata(namedMetaNode);
+  }
+
+  LLVMContext &context = module->getContext();
+  StringRef blobBytes(reinterpret_cast<const char *>(blob.data()), blob.size() * sizeof(unsigned));
+  auto blobMetaNode = module->getOrInsertNamedMetadata(StateBlobMetadataName);
+  blobMetaNode->clearOperands();
+  blobMetaNode->addOperand(MDNode::get(context, MDString::get(context, blobBytes)));
+}
+
+// =====================================================================================================================
+// Read options (including client name and pipeline link kind), user data nodes, vertex input descriptions and
+// color export state from the binary blob written by recordStateBlob().
+//
+// @param module : Module to read the blob from
+// @returns : True if the module has a blob, false if that state is in named metadata instead
+bool PipelineState::readStateBlob(Module *module) {
+  auto blobMetaNode = module->getNamedMetadata(StateBlobMetadataName);
+  if (!blobMetaNode || blobMetaNode->getNumOperands() == 0)
+    return false;
+  StringRef blobBytes = cast<MDString>(blobMetaNode->getOperand(0)->getOperand(0))->getString();
+
+  // MDString data is not necessarily dword aligned, so take one aligned copy of the whole blob.
+  SmallVector<unsigned, 64> blobCopy(blobBytes.size() / sizeof(unsigned));
+  memcpy(blobCopy.data(), blobBytes.data(), blobCopy.size() * sizeof(unsigned));
+  ArrayRef<unsigned> blob = blobCopy;
+  if (blob.empty() || blob[0] != StateBlobVersion)
+    report_fatal_error("Pipeline state blob has unsupported version");
+  blob = blob.drop_front();
+
+  m_client.clear();
+  m_pipelineLink = PipelineLink::WholePipeline;
+  m_vertexInputDescriptions.clear();
+  m_colorExportFormats.clear();
+
+  // Copy dwords into a struct, allowing for the struct having been smaller or bigger when the blob was written.
+  auto readDwords = [](ArrayRef<unsigned> payload, void *data, size_t sizeInBytes) {
+    memset(data, 0, sizeInBytes);
+    memcpy(data, payload.data(), std::min(payload.size() * sizeof(unsigned), sizeInBytes));
+  };
+
+  while (!blob.empty()) {
+    StateBlobSection kind = StateBlobSection(blob[0]);
+    ArrayRef<unsigned> payload = blob.slice(2, blob[1]);
+    blob = blob.drop_front(2 + blob[1]);
+
+    switch (kind) {
+    case StateBlobSection::Client:
+      m_client = StringRef(reinterpret_cast<const char *>(&payload[1]), payload[0]).str();
+      break;
+    case StateBlobSection::PipelineLink:
+      m_pipelineLink = PipelineLink(payload[0]);
+      break;
+    case StateBlobSection::Options:
+      readDwords(payload, &m_options, sizeof(m_options));
+      break;
+    case StateBlobSection::ShaderOptions:
+      if (m_shaderOptions.size() <= payload[0])
+        m_shaderOptions.resize(payload[0] + 1);
+      readDwords(payload.drop_front(), &m_shaderOptions[payload[0]], sizeof(ShaderOptions));
+      break;
+    case StateBlobSection::UserDataNodes: {
+      // Allocate a single buffer, with the top-level table at the start, and inner tables allocated after it.
+      unsigned totalNodeCount = payload[0];
+      unsigned topNodeCount = payload[1];
+      payload = payload.drop_front(2);
+      ResourceNode *allocUserDataNodes = allocateUserDataNodes(totalNodeCount);
+      ResourceNode *nextInnerTable = allocUserDataNodes + topNodeCount;
+      std::function<void(MutableArrayRef<ResourceNode>)> readTable = [&](MutableArrayRef<ResourceNode> nodes) {
+        for (ResourceNode &node : nodes) {
+          node.type = ResourceNodeType(payload[0]);
+          node.offsetInDwords = payload[1];
+          node.sizeInDwords = payload[2];
+          switch (node.type) {
+          case ResourceNodeType::DescriptorTableVaPtr: {
+            MutableArrayRef<ResourceNode> innerTable(nextInnerTable, payload[3]);
+            nextInnerTable += innerTable.size();
+            node.innerTable = innerTable;
+            payload = payload.drop_front(4);
+            readTable(innerTable);
+            break;
+          }
+          case ResourceNodeType::IndirectUserDataVaPtr:
+          case ResourceNodeType::StreamOutTableVaPtr:
+            node.indirectSizeInDwords = payload[3];
+            payload = payload.drop_front(4);
+            break;
+          default: {
+            node.set = payload[3];
+            node.binding = payload[4];
+            node.stride = payload[5];
+            node.immutableSize = payload[6];
+            node.immutableValue = nullptr;
+            unsigned immutableSizeInDwords = node.immutableSize * DescriptorSizeSamplerInDwords;
+            if (immutableSizeInDwords) {
+              uint32_t *immutableValue = allocateImmutableValue(immutableSizeInDwords);
+              std::copy_n(&payload[7], immutableSizeInDwords, immutableValue);
+              node.immutableValue = immutableValue;
+            }
+            payload = payload.drop_front(7 + immutableSizeInDwords);
+            break;
+          }
+          }
+        }
+      };
+      readTable(MutableArrayRef<ResourceNode>(allocUserDataNodes, topNodeCount));
+      assert(nextInnerTable == allocUserDataNodes + totalNodeCount);
+      m_userDataNodes = ArrayRef<ResourceNode>(allocUserDataNodes, topNodeCount);
+      invalidateResourceNodeIndex();
+      break;
+    }
+    case StateBlobSection::VertexInputs:
+      for (unsigned idx = 1; idx < payload.size(); idx += payload[0]) {
+        m_vertexInputDescriptions.push_back({});
+        readDwords(payload.slice(idx, payload[0]), &m_vertexInputDescriptions.back(), sizeof(VertexInputDescription));
+      }
+      break;
+    case StateBlobSection::ColorExportFormats:
+      for (unsigned idx = 1; idx < payload.size(); idx += payload[0]) {
+        m_colorExportFormats.push_back({});
+        readDwords(payload.slice(idx, payload[0]), &m_colorExportFormats.back(), sizeof(ColorExportFormat));
+      }
+      break;
+    case StateBlobSection::ColorExportState:
+      readDwords(payload, &m_colorExportState, sizeof(m_colorExportState));
+      break;
+    default:
+      llvm_unreachable("Unknown pipeline state blob section");
+    }
+  }
+  return true;
+}
+
 // =====================================================================================================================
 // Read shaderStageMask from IR. This consists of checking what shader stage functions are present in the IR.
 // It also sets the m_computeLibrary flag if there are no shader entry-points.
@@ -519,13 +801,13 @@ void PipelineState::setUserDataNodes(ArrayRef<ResourceNode> nodes) {
     if (node.type == ResourceNodeType::DescriptorTableVaPtr)
       nodeCount += node.innerTable.size();
   }
-  assert(m_allocUserDataNodes == nullptr);
-  m_allocUserDataNodes = std::make_unique<ResourceNode[]>(nodeCount);
+  assert(m_userDataNodes.empty());
 
   // Copy nodes in.
-  ResourceNode *destTable = m_allocUserDataNodes.get();
+  ResourceNode *destTable = allocateUserDataNodes(nodeCount);
   ResourceNode *destInnerTable = destTable + nodeCount;
   m_userDataNodes = ArrayRef<ResourceNode>(destTable, nodes.size());
+  invalidateResourceNodeIndex();
   setUserDataNodesTable(nodes, destTable, destInnerTable);
   assert(destInnerTable == destTable + nodes.size());
 }
@@ -559,10 +841,9 @@ void PipelineState::setUserDataNodesTable(ArrayRef<ResourceNode> nodes, Resource
       // If there is immutable sampler data, take our own copy of it.
       if (node.immutableSize != 0) {
         unsigned sizeInDwords = node.immutableSize * DescriptorSizeSamplerInDwords;
-        auto buffer = std::make_unique<uint32_t[]>(sizeInDwords);
-        std::copy_n(node.immutableValue, sizeInDwords, buffer.get());
-        destNode.immutableValue = buffer.get();
-        m_immutableValueAllocs.push_back(std::move(buffer));
+        uint32_t *immutableValue = allocateImmutableValue(sizeInDwords);
+        std::copy_n(node.immutableValue, sizeInDwords, immutableValue);
+        destNode.immutableValue = immutableValue;
       }
       break;
     }
@@ -653,9 +934,9 @@ void PipelineState::readUserDataNodes(Module *module) {
   // Prepare to read the resource nodes from the named MD node. We allocate a single buffer, with the
   // outer table at the start, and inner tables allocated from the end backwards.
   unsigned totalNodeCount = userDataMetaNode->getNumOperands();
-  m_allocUserDataNodes = std::make_unique<ResourceNode[]>(totalNodeCount);
+  ResourceNode *allocUserDataNodes = allocateUserDataNodes(totalNodeCount);
 
-  ResourceNode *nextOuterNode = m_allocUserDataNodes.get();
+  ResourceNode *nextOuterNode = allocUserDataNodes;
   ResourceNode *nextNode = nextOuterNode;
   ResourceNode *endNextInnerTable = nextOuterNode + totalNodeCount;
   ResourceNode *endThisInnerTable = nullptr;
@@ -698,10 +979,10 @@ void PipelineState::readUserDataNodes(Module *module) {
         unsigned immutableSizeInDwords = metadataNode->getNumOperands() - ImmutableStartOperand;
         nextNode->immutableSize = immutableSizeInDwords / DescriptorSizeSamplerInDwords;
         if (nextNode->immutableSize) {
-          m_immutableValueAllocs.push_back(std::make_unique<uint32_t[]>(immutableSizeInDwords));
-          nextNode->immutableValue = m_immutableValueAllocs.back().get();
+          uint32_t *immutableValue = allocateImmutableValue(immutableSizeInDwords);
+          nextNode->immutableValue = immutableValue;
           for (unsigned i = 0; i != immutableSizeInDwords; ++i)
-            m_immutableValueAllocs.back()[i] =
+            immutableValue[i] =
                 mdconst::dyn_extract<ConstantInt>(metadataNode->getOperand(ImmutableStartOperand + i))->getZExtValue();
         }
       }
@@ -716,7 +997,28 @@ void PipelineState::readUserDataNodes(Module *module) {
       nextNode = nextOuterNode;
     }
   }
-  m_userDataNodes = ArrayRef<ResourceNode>(m_allocUserDataNodes.get(), nextOuterNode);
+  m_userDataNodes = ArrayRef<ResourceNode>(allocUserDataNodes, nextOuterNode);
+  invalidateResourceNodeIndex();
+}
+
+// =====================================================================================================================
+// Allocates a table of user data nodes, which lives as long as the pipeline state. The nodes are not initialized.
+//
+// @param nodeCount : Number of nodes
+ResourceNode *PipelineState::allocateUserDataNodes(unsigned nodeCount) {
+  static_assert(std::is_trivially_destructible<ResourceNode>::value, "Nodes are freed without being destroyed");
+  ResourceNode *nodes = m_allocator.Allocate<ResourceNode>(nodeCount);
+  for (unsigned idx = 0; idx != nodeCount; ++idx)
+    new (&nodes[idx]) ResourceNode();
+  return nodes;
+}
+
+// =====================================================================================================================
+// Allocates a buffer for immutable sampler data, which lives as long as the pipeline state.
+//
+// @param sizeInDwords : Size of the data in dwords
+uint32_t *PipelineState::allocateImmutableValue(unsigned sizeInDwords) {
+  return m_allocator.Allocate<uint32_t>(sizeInDwords);
 }
 
 // =====================================================================================================================
@@ -805,6 +1107,29 @@ bool PipelineState::matchResourceNode(const ResourceNode &node, ResourceNodeType
   return false;
 }
 
+// =====================================================================================================================
+// Build the indices of the user data nodes used by findResourceNode, so that a lookup does not have to scan the whole
+// user data node table, which can contain thousands of nodes for a bindless layout. The candidates for a {set,binding}
+// are kept in table order, so a lookup finds the same node as a scan of the table would.
+void PipelineState::buildResourceNodeIndex() const {
+  m_resourceNodeIndex.clear();
+  m_descTableNodeIndex.clear();
+  for (const ResourceNode &node : getUserDataNodes()) {
+    if (!nodeTypeHasBinding(node.type))
+      continue;
+
+    if (node.type == ResourceNodeType::DescriptorTableVaPtr) {
+      assert(!node.innerTable.empty());
+      m_descTableNodeIndex.try_emplace(node.innerTable[0].set, &node);
+
+      for (const ResourceNode &innerNode : node.innerTable)
+        m_resourceNodeIndex[{innerNode.set, innerNode.binding}].push_back({&node, &innerNode});
+    } else
+      m_resourceNodeIndex[{node.set, node.binding}].push_back({&node, &node});
+  }
+  m_resourceNodeIndexValid = true;
+}
+
 // =====================================================================================================================
 // Find the resource node for the given {set,binding} compatible with nodeType.
 //
@@ -820,26 +1145,22 @@ bool PipelineState::matchResourceNode(const ResourceNode &node, ResourceNodeType
 // @param binding : ID of descriptor binding
 std::pair<const ResourceNode *, const ResourceNode *>
 PipelineState::findResourceNode(ResourceNodeType nodeType, unsigned descSet, unsigned binding) const {
-  for (const ResourceNode &node : getUserDataNodes()) {
-    if (!nodeTypeHasBinding(node.type))
-      continue;
-
-    if (node.type == ResourceNodeType::DescriptorTableVaPtr) {
-      if (nodeType == ResourceNodeType::DescriptorTableVaPtr) {
-        assert(!node.innerTable.empty());
-
-        if (node.innerTable[0].set == descSet)
-          return {&node, &node};
-        continue;
-      }
+  if (!m_resourceNodeIndexValid)
+    buildResourceNodeIndex();
+
+  if (nodeType == ResourceNodeType::DescriptorTableVaPtr) {
+    auto it = m_descTableNodeIndex.find(descSet);
+    if (it != m_descTableNodeIndex.end())
+      return {it->second, it->second};
+    return {nullptr, nullptr};
+  }
 
-      // Check inner nodes.
-      for (const ResourceNode &innerNode : node.innerTable) {
-        if (matchResourceNode(innerNode, nodeType, descSet, binding))
-          return {&node, &innerNode};
-      }
-    } else if (matchResourceNode(node, nodeType, descSet, binding))
-      return {&node, &node};
+  auto it = m_resourceNodeIndex.find({descSet, binding});
+  if (it != m_resourceNodeIndex.end()) {
+    for (const auto &candidate : it->second) {
+      if (matchResourceNode(*candidate.second, nodeType, descSet, binding))
+        return candidate;
+    }
   }
 
   if (nodeType == ResourceNodeType::DescriptorFmask &&
@@ -995,6 +1316,24 @@ const ColorExportFormat &PipelineState::getColorExportFormat(unsigned location)
   return m_colorExportFormats[location];
 }
 
+// =====================================================================================================================
+// Get the mask of the channels (RGBA from bit 0) of one color export that need exporting. That is the channels that
+// are written to the target, plus alpha if it is used for blending or alpha-to-coverage.
+//
+// @param location : Export location
+// @returns : Mask of the channels that need exporting
+unsigned PipelineState::getColorExportChannelMask(unsigned location) {
+  const ColorExportFormat &colorExportFormat = getColorExportFormat(location);
+  // With dual source blending, both sources feed the same target, so the write mask tells us nothing about what
+  // the blend reads.
+  if (colorExportFormat.channelWriteMask == 0 || getColorExportState().dualSourceBlendEnable)
+    return 0xF;
+  unsigned channelMask = colorExportFormat.channelWriteMask & 0xF;
+  if (colorExportFormat.blendSrcAlphaToColor || (getColorExportState().alphaToCoverageEnable && location == 0))
+    channelMask |= 0x8;
+  return channelMask;
+}
+
 // =====================================================================================================================
 // Record color export state (including formats) into IR metadata
 //
@@ -1010,7 +1349,7 @@ void PipelineState::recordColorExportState(Module *module) {
 
     // The color export formats named metadata node's operands are:
     // - N metadata nodes for N color targets, each one containing
-    // { dfmt, nfmt, blendEnable, blendSrcAlphaToColor }
+    // { dfmt, nfmt, blendEnable, blendSrcAlphaToColor, channelWriteMask }
     for (const ColorExportFormat &target : m_colorExportFormats)
       exportFormatsMetaNode->addOperand(getArrayOfInt32MetaNode(getContext(), target, /*atLeastOneValue=*/true));
   }
@@ -1202,7 +1541,8 @@ unsigned PipelineState::getShaderSubgroupSize(ShaderStage stage) {
 // Set the default wave size for the specified shader stage
 //
 // @param stage : Shader stage
-void PipelineState::setShaderDefaultWaveSize(ShaderStage stage) {
+// @param preferredWaveSize : Wave size picked by the wave size heuristic, or 0 to use the fixed per-stage default
+void PipelineState::setShaderDefaultWaveSize(ShaderStage stage, unsigned preferredWaveSize) {
   ShaderStage checkingStage = stage;
   const bool isGfx10Plus = getTargetInfo().getGfxIpVersion().major >= 10;
   if (isGfx10Plus && stage == ShaderStageGeometry && !hasShaderStage(ShaderStageGeometry)) {
@@ -1218,8 +1558,9 @@ void PipelineState::setShaderDefaultWaveSize(ShaderStage stage) {
     if (isGfx10Plus) {
       // NOTE: GPU property wave size is used in shader, unless:
       //  1) A stage-specific default is preferred.
-      //  2) If specified by tuning option, use the specified wave size.
-      //  3) If gl_SubgroupSize is used in shader, use the specified subgroup size when required.
+      //  2) The wave size heuristic picks a wave size from analysis of the shader.
+      //  3) If specified by tuning option, use the specified wave size.
+      //  4) If gl_SubgroupSize is used in shader, use the specified subgroup size when required.
 
       if (checkingStage == ShaderStageFragment) {
         // Per programming guide, it's recommended to use wave64 for fragment shader.
@@ -1234,6 +1575,11 @@ void PipelineState::setShaderDefaultWaveSize(ShaderStage stage) {
       if (getTargetInfo().getGfxIpVersion() >= GfxIpVersion({10, 3}) && stage == ShaderStageCompute)
         waveSize = 64;
 
+      if (preferredWaveSize != 0) {
+        assert(preferredWaveSize == 32 || preferredWaveSize == 64);
+        waveSize = preferredWaveSize;
+      }
+
       unsigned waveSizeOption = getShaderOptions(checkingStage).waveSize;
       if (waveSizeOption != 0)
         waveSize = waveSizeOption;
@@ -1322,7 +1668,12 @@ unsigned PipelineState::computeExportFormat(Type *outputTy, unsigned location) {
 
   const unsigned maxCompBitCount = getMaxComponentBitCount(colorExportFormat->dfmt);
 
-  const bool formatHasAlpha = hasAlpha(colorExportFormat->dfmt);
+  // Nothing needs exporting if none of the channels that the shader outputs are written to the target.
+  const unsigned channelMask = getColorExportChannelMask(location);
+  if ((outputMask & channelMask) == 0)
+    return EXP_FORMAT_ZERO;
+
+  const bool formatHasAlpha = hasAlpha(colorExportFormat->dfmt) && (channelMask & 0x8) != 0;
   const bool alphaExport =
       (outputMask == 0xF && (formatHasAlpha || colorExportFormat->blendSrcAlphaToColor || enableAlphaToCoverage));
 
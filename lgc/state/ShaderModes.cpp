@@ -181,7 +181,8 @@ void ShaderModes::record(Module *module) {
 // =====================================================================================================================
 // Read shader modes (common and specific) from a shader IR module, but only if no modes have been set
 // in this ShaderModes. This is used to handle the case that the shader module comes from an earlier
-// shader compile, and it had its ShaderModes recorded into IR then.
+// shader compile, and it had its ShaderModes recorded into IR then. The shader mode metadata is removed from the
+// shader module, so that it does not clash with that of other shader modules when they are linked.
 //
 // @param module : LLVM module
 // @param stage : Shader stage
@@ -195,12 +196,15 @@ void ShaderModes::readModesFromShader(Module *module, ShaderStage stage) {
       std::string(CommonShaderModeMetadataPrefix) + getShaderStageAbbreviation(static_cast<ShaderStage>(stage));
   PipelineState::readNamedMetadataArrayOfInt32(module, metadataName, m_commonShaderModes[stage]);
 
-  // Then the specific shader modes.
+  // Then the specific shader modes. The tessellation mode is merged, as it is supplied by both TCS and TES.
   switch (stage) {
   case ShaderStageTessControl:
-  case ShaderStageTessEval:
-    PipelineState::readNamedMetadataArrayOfInt32(module, TessellationModeMetadataName, m_tessellationMode);
+  case ShaderStageTessEval: {
+    TessellationMode tessellationMode = {};
+    PipelineState::readNamedMetadataArrayOfInt32(module, TessellationModeMetadataName, tessellationMode);
+    setTessellationMode(tessellationMode);
     break;
+  }
   case ShaderStageGeometry:
     PipelineState::readNamedMetadataArrayOfInt32(module, GeometryShaderModeMetadataName, m_geometryShaderMode);
     break;
@@ -213,6 +217,18 @@ void ShaderModes::readModesFromShader(Module *module, ShaderStage stage) {
   default:
     break;
   }
+
+  // Remove all shader mode metadata from the shader module.
+  SmallVector<NamedMDNode *, 8> modeMetadata;
+  for (NamedMDNode &namedMetadata : module->named_metadata()) {
+    StringRef name = namedMetadata.getName();
+    if (name.startswith(CommonShaderModeMetadataPrefix) || name == TessellationModeMetadataName ||
+        name == GeometryShaderModeMetadataName || name == FragmentShaderModeMetadataName ||
+        name == ComputeShaderModeMetadataName)
+      modeMetadata.push_back(&namedMetadata);
+  }
+  for (NamedMDNode *namedMetadata : modeMetadata)
+    module->eraseNamedMetadata(namedMetadata);
 }
 
 // =====================================================================================================================
@@ -250,6 +250,7 @@ static void setGfx9BaseInfo(TargetInfo *targetInfo) {
   targetInfo->getGpuProperty().gsOnChipDefaultLdsSizePerSubgroup = 0; // GFX9+ does not use this
   targetInfo->getGpuProperty().tessFactorBufferSizePerSe = 8192;
   targetInfo->getGpuProperty().numShaderEngines = 4;
+  targetInfo->getGpuProperty().typedVertexFetch.signedA2 = true;
 }
 
 // gfx9
@@ -286,6 +287,7 @@ static void setGfx906Info(TargetInfo *targetInfo) {
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth8 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth4 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.sameSignedness = true;
+  targetInfo->getGpuProperty().supportFloatDot2 = true;
 }
 
 // gfx10
@@ -353,6 +355,7 @@ static void setGfx1011Info(TargetInfo *targetInfo) {
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth8 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth4 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.sameSignedness = true;
+  targetInfo->getGpuProperty().supportFloatDot2 = true;
 }
 
 // gfx1012
@@ -379,6 +382,7 @@ static void setGfx1012Info(TargetInfo *targetInfo) {
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth8 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth4 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.sameSignedness = true;
+  targetInfo->getGpuProperty().supportFloatDot2 = true;
 }
 
 // gfx103
@@ -391,6 +395,7 @@ static void setGfx103Info(TargetInfo *targetInfo) {
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth8 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.compBitwidth4 = true;
   targetInfo->getGpuProperty().supportIntegerDotFlag.sameSignedness = true;
+  targetInfo->getGpuProperty().supportFloatDot2 = true;
 }
 
 // gfx1030
@@ -34,6 +34,7 @@
 #include "lgc/Pipeline.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/BinaryFormat/ELF.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Path.h"
@@ -132,6 +133,10 @@ int main(int argc, char **argv) {
                                    "a shader or pipeline with amdllpc, and using the -emit-lgc option to stop\n"
                                    "before running LGC.\n"
                                    "\n"
+                                   "An input file can instead be a serialized recorded module, written by\n"
+                                   "compiling a pipeline with amdllpc and using the -emit-lgc-bc option. If\n"
+                                   "-mcpu is not given, the GPU it was recorded for is used.\n"
+                                   "\n"
                                    "If the -l (link) option is given, then the lgc tool instead parses a single\n"
                                    "module of LLVM IR assembler from the first input file, and uses the IR metadata\n"
                                    "from that to set LGC pipeline state. Then it reads the remaining input files,\n"
@@ -147,8 +152,6 @@ int main(int argc, char **argv) {
   assert(mcpu != opts.end());
   auto *mcpuOpt = reinterpret_cast<cl::opt<std::string> *>(mcpu->second);
   StringRef gpuName = *mcpuOpt;
-  if (gpuName == "")
-    gpuName = "gfx802";
 
   // If we will be outputting to stdout, default to -filetype=asm
   if ((!InFiles.empty() && InFiles[0] == "-" && OutFileName.empty()) || OutFileName == "-") {
@@ -159,16 +162,6 @@ int main(int argc, char **argv) {
       *static_cast<cl::opt<CodeGenFileType> *>(opt) = CGFT_AssemblyFile;
   }
 
-  // Create the LgcContext.
-  std::unique_ptr<LgcContext> lgcContext(LgcContext::Create(context, gpuName, PalAbiVersion));
-  if (!lgcContext) {
-    errs() << progName << ": GPU type '" << gpuName << "' not recognized\n";
-    return 1;
-  }
-
-  if (VerboseOutput)
-    lgcContext->setLlpcOuts(&outs());
-
   // Read the "other" part-pipeline ELF input.
   std::unique_ptr<MemoryBuffer> otherBuffer;
   if (!OtherName.empty()) {
@@ -196,20 +189,60 @@ int main(int argc, char **argv) {
     inBuffers.push_back(std::move(*fileOrErr));
   }
 
-  // Process each input file.
+  // Read any input files that are serialized recorded modules (from "amdllpc -emit-lgc-bc"). The target of the
+  // first one is the default if -mcpu and -pal-abi-version are not given.
+  SmallVector<std::unique_ptr<Module>, 4> recordedModules;
+  RecordedModuleTarget recordedTarget = {"gfx802", PalAbiVersion};
+  bool haveRecordedTarget = false;
   for (auto &inBuffer : inBuffers) {
     MemoryBufferRef bufferRef = inBuffer->getMemBufferRef();
+    recordedModules.emplace_back();
+    StringRef buffer = bufferRef.getBuffer();
+    if (!isBitcode(reinterpret_cast<const unsigned char *>(buffer.begin()),
+                   reinterpret_cast<const unsigned char *>(buffer.end())))
+      continue;
+    RecordedModuleTarget target;
+    recordedModules.back() = Pipeline::readRecordedModule(bufferRef, context, &target);
+    if (!recordedModules.back()) {
+      errs() << progName << ": " << bufferRef.getBufferIdentifier()
+             << ": Not a recorded module in a format version supported by this LGC\n";
+      return 1;
+    }
+    if (!haveRecordedTarget) {
+      recordedTarget = target;
+      haveRecordedTarget = true;
+    }
+  }
+  if (gpuName == "")
+    gpuName = recordedTarget.gpuName;
+  if (PalAbiVersion.getNumOccurrences() == 0)
+    PalAbiVersion = recordedTarget.palAbiVersion;
+
+  // Create the LgcContext.
+  std::unique_ptr<LgcContext> lgcContext(LgcContext::Create(context, gpuName, PalAbiVersion));
+  if (!lgcContext) {
+    errs() << progName << ": GPU type '" << gpuName << "' not recognized\n";
+    return 1;
+  }
+
+  if (VerboseOutput)
+    lgcContext->setLlpcOuts(&outs());
+
+  // Process each input file.
+  for (unsigned inIdx = 0; inIdx != inBuffers.size(); ++inIdx) {
+    MemoryBufferRef bufferRef = inBuffers[inIdx]->getMemBufferRef();
     StringRef bufferName = bufferRef.getBufferIdentifier();
+    std::unique_ptr<Module> &recordedModule = recordedModules[inIdx];
 
     // Split the input into multiple LLVM IR modules. We assume that a new module starts with
     // a "target" line to set the datalayout or triple, or a "define" line for a new function,
     // but not until after we have seen at least one line starting with '!' (metadata declaration)
-    // in the previous module.
+    // in the previous module. A serialized recorded module is a single module, so is not split.
     SmallVector<StringRef, 4> separatedAsms;
     StringRef remaining = bufferRef.getBuffer();
     separatedAsms.push_back(remaining);
     bool hadMetadata = false;
-    for (;;) {
+    while (!recordedModule) {
       auto notSpacePos = remaining.find_first_not_of(" \t\n");
       if (notSpacePos != StringRef::npos) {
         if (remaining[notSpacePos] == '!')
@@ -248,16 +281,20 @@ int main(int argc, char **argv) {
       if (Extract && Extract != idx + 1)
         continue;
 
-      // Use a MemoryBufferRef with the original filename so error reporting reports it.
-      MemoryBufferRef asmBuffer(asmText, bufferName);
-
-      // Assemble the text
-      SMDiagnostic error;
-      std::unique_ptr<Module> module = parseAssembly(asmBuffer, error, context);
-      if (!module) {
-        error.print(progName, errs());
-        errs() << "\n";
-        return 1;
+      bool isRecordedModule = recordedModule != nullptr;
+      std::unique_ptr<Module> module = std::move(recordedModule);
+      if (!isRecordedModule) {
+        // Use a MemoryBufferRef with the original filename so error reporting reports it.
+        MemoryBufferRef asmBuffer(asmText, bufferName);
+
+        // Assemble the text
+        SMDiagnostic error;
+        module = parseAssembly(asmBuffer, error, context);
+        if (!module) {
+          error.print(progName, errs());
+          errs() << "\n";
+          return 1;
+        }
       }
 
       // Verify the resulting IR.
@@ -323,7 +360,10 @@ int main(int argc, char **argv) {
             err = pipeline->getLastError();
         }
       } else {
-        // Run the middle-end compiler.
+        // Run the middle-end compiler. A serialized recorded module needs the pipeline state setting from it
+        // before generate() sets up its passes.
+        if (isRecordedModule)
+          pipeline->setStateFromModule(&*module);
         if (!pipeline->generate(std::move(module), outStream, nullptr, {}, false))
           err = pipeline->getLastError();
       }
@@ -348,6 +388,9 @@ int main(int argc, char **argv) {
           const char *ext = ".s";
           if (isElfBinary(outBuffer)) {
             ext = ".elf";
+          } else if (isBitcode(reinterpret_cast<const unsigned char *>(outBuffer.begin()),
+                               reinterpret_cast<const unsigned char *>(outBuffer.end()))) {
+            ext = ".bc";
           } else if (isIsaText(outBuffer)) {
             ext = ".s";
           } else {
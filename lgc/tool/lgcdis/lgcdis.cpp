@@ -48,6 +48,12 @@ cl::list<std::string> InFiles(cl::Positional, cl::OneOrMore, cl::ValueRequired,
 // -o: output filename
 cl::opt<std::string> OutFileName("o", cl::cat(LgcDisCategory), cl::desc("Output filename ('-' for stdout)"),
                                  cl::value_desc("filename"));
+
+// -j: number of threads to disassemble the input files with
+cl::opt<unsigned> NumThreads("j", cl::cat(LgcDisCategory),
+                             cl::desc("Number of threads to disassemble the input files with (0 for the number of "
+                                      "hardware threads); the output is in input file order"),
+                             cl::value_desc("threads"), cl::init(1));
 } // anonymous namespace
 
 // =====================================================================================================================
@@ -76,8 +82,10 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  // Read and process each input file.
+  // Read each input file, then disassemble them all, so that they can be disassembled in parallel. A batch of input
+  // files too long for the command line can be given in a response file ("@file").
   SmallVector<std::unique_ptr<MemoryBuffer>, 4> inBuffers;
+  SmallVector<MemoryBufferRef, 4> inObjects;
   for (auto inFileName : InFiles) {
     // Read the input file. getFileOrSTDIN handles the case of inFileName being "-".
     ErrorOr<std::unique_ptr<MemoryBuffer>> fileOrErr = MemoryBuffer::getFileOrSTDIN(inFileName);
@@ -87,8 +95,10 @@ int main(int argc, char **argv) {
       errs() << "\n";
       return 1;
     }
-    disassembleObject((*fileOrErr)->getMemBufferRef(), ostream);
+    inBuffers.push_back(std::move(*fileOrErr));
+    inObjects.push_back(inBuffers.back()->getMemBufferRef());
   }
+  disassembleObjects(inObjects, ostream, NumThreads);
 
   return 0;
 }
@@ -29,7 +29,6 @@
 ***********************************************************************************************************************
 */
 #include "lgc/util/GfxRegHandler.h"
-#include "llvm/IR/IntrinsicsAMDGPU.h"
 
 using namespace lgc;
 using namespace llvm;
@@ -83,13 +82,10 @@ Value *GfxRegHandler::getRegCombine(unsigned regIdLo, unsigned regIdHi) {
 // @param regIdHi : Reg ID of high part register
 // @param regValue : Data used for setting
 void GfxRegHandler::setRegCombine(unsigned regIdLo, unsigned regIdHi, Value *regValue) {
-  Value *regValueLo =
-      m_builder->CreateIntrinsic(Intrinsic::amdgcn_ubfe, m_builder->getInt32Ty(),
-                                 {regValue, m_builder->getInt32(0), m_builder->getInt32(m_bitsInfo[regIdLo].count)});
-
+  // setRegCommon masks the value to the bits of the low part, so it is not masked here.
   Value *regValueHi = m_builder->CreateLShr(regValue, m_builder->getInt32(m_bitsInfo[regIdLo].count));
 
-  setRegCommon(regIdLo, regValueLo);
+  setRegCommon(regIdLo, regValue);
   setRegCommon(regIdHi, regValueHi);
 }
 
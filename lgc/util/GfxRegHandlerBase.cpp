@@ -29,7 +29,6 @@
 ***********************************************************************************************************************
 */
 #include "lgc/util/GfxRegHandlerBase.h"
-#include "llvm/IR/IntrinsicsAMDGPU.h"
 
 using namespace lgc;
 using namespace llvm;
@@ -85,18 +84,20 @@ Value *GfxRegHandlerBase::getRegister() {
 }
 
 // =====================================================================================================================
-// Get data from a range of bits in indexed dword according to BitsInfo
+// Get data from a range of bits in indexed dword according to BitsInfo. As the range is constant, this is a shift
+// and/or a mask rather than amdgcn_ubfe, which leaves nothing for later passes to fold.
 //
 // @param bitsInfo : The BitsInfo of data
 Value *GfxRegHandlerBase::getBits(const BitsInfo &bitsInfo) {
+  Value *dword = getDword(bitsInfo.index);
   if (bitsInfo.count == 32)
-    return getDword(bitsInfo.index);
+    return dword;
 
-  extractDwordIfNecessary(bitsInfo.index);
-
-  return m_builder->CreateIntrinsic(
-      Intrinsic::amdgcn_ubfe, m_builder->getInt32Ty(),
-      {m_dwords[bitsInfo.index], m_builder->getInt32(bitsInfo.offset), m_builder->getInt32(bitsInfo.count)});
+  if (bitsInfo.offset != 0)
+    dword = m_builder->CreateLShr(dword, bitsInfo.offset);
+  if (bitsInfo.offset + bitsInfo.count == 32)
+    return dword; // The shift has already dropped the bits above the range
+  return m_builder->CreateAnd(dword, bitsInfo.getMask() >> bitsInfo.offset);
 }
 
 // =====================================================================================================================
@@ -108,7 +109,7 @@ void GfxRegHandlerBase::setBits(const BitsInfo &bitsInfo, Value *newBits) {
   extractDwordIfNecessary(bitsInfo.index);
 
   if (bitsInfo.count != 32) {
-    Value *dwordsNew = replaceBits(m_dwords[bitsInfo.index], bitsInfo.offset, bitsInfo.count, newBits);
+    Value *dwordsNew = replaceBits(m_dwords[bitsInfo.index], bitsInfo, newBits);
     setDword(bitsInfo.index, dwordsNew);
   } else
     setDword(bitsInfo.index, newBits);
@@ -118,16 +119,17 @@ void GfxRegHandlerBase::setBits(const BitsInfo &bitsInfo, Value *newBits) {
 // Return new dword which is replaced [offset, offset + count) with pNewBits
 //
 // @param dword : Target dword
-// @param offset : The first bit to be replaced
-// @param count : The number of bits should be replaced
+// @param bitsInfo : The BitsInfo of the bits to be replaced
 // @param newBits : The new bits to replace specified ones
-Value *GfxRegHandlerBase::replaceBits(Value *dword, unsigned offset, unsigned count, Value *newBits) {
+Value *GfxRegHandlerBase::replaceBits(Value *dword, const BitsInfo &bitsInfo, Value *newBits) {
   // mask = ((1 << count) - 1) << offset
   // Result = (pDword & ~mask)|((pNewBits << offset) & mask)
-  unsigned maskBits = ((1 << count) - 1) << offset;
-  Value *mask = m_builder->getInt32(maskBits);
-  Value *notMask = m_builder->getInt32(~maskBits);
-  Value *beginBit = m_builder->getInt32(offset);
-  newBits = m_builder->CreateAnd(m_builder->CreateShl(newBits, beginBit), mask);
-  return m_builder->CreateOr(m_builder->CreateAnd(dword, notMask), newBits);
+  // The shift is skipped for a range at bit 0, and the mask of the new bits for a range that ends at bit 31, where
+  // the shift has already dropped the bits above it.
+  const unsigned maskBits = bitsInfo.getMask();
+  if (bitsInfo.offset != 0)
+    newBits = m_builder->CreateShl(newBits, bitsInfo.offset);
+  if (bitsInfo.offset + bitsInfo.count != 32)
+    newBits = m_builder->CreateAnd(newBits, maskBits);
+  return m_builder->CreateOr(m_builder->CreateAnd(dword, ~maskBits), newBits);
 }
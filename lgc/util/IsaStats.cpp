@@ -0,0 +1,459 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  IsaStats.cpp
+ * @brief LGC source file: Static statistics of the ISA of each hardware stage of a pipeline ELF
+ ***********************************************************************************************************************
+ */
+#include "lgc/util/IsaStats.h"
+#include "lgc/state/AbiMetadata.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#if LLVM_MAIN_REVISION && LLVM_MAIN_REVISION < 401324
+// Old version
+#include "llvm/Support/TargetRegistry.h"
+#else
+// New version (and unknown version)
+#include "llvm/MC/TargetRegistry.h"
+#endif
+#include "llvm/Target/TargetMachine.h"
+
+#define DEBUG_TYPE "lgc-isa-stats"
+
+using namespace lgc;
+using namespace llvm;
+
+// -isa-stats: add static ISA statistics of each hardware stage to the PAL metadata of each pipeline ELF
+static cl::opt<bool> IsaStats("isa-stats",
+                              cl::desc("Add static ISA statistics of each hardware stage (instruction mix, s_waitcnt "
+                                       "count, spill estimates, estimated occupancy) to the PAL metadata of each "
+                                       "pipeline ELF"),
+                              cl::init(false));
+
+// Key of the map of ISA statistics in the PAL metadata of a hardware stage
+static const char IsaStatsKey[] = ".isa_stats";
+
+namespace {
+
+// Static statistics of the ISA of one hardware stage
+struct StageIsaStats {
+  unsigned instructions = 0; // Number of instructions
+  unsigned codeSize = 0;     // Byte size of the code
+  unsigned salu = 0;         // Scalar ALU instructions
+  unsigned valu = 0;         // Vector ALU instructions
+  unsigned smem = 0;         // Scalar memory instructions
+  unsigned vmem = 0;         // Vector memory instructions (buffer, image, global, flat and scratch)
+  unsigned lds = 0;          // LDS and GDS instructions
+  unsigned exports = 0;      // Export instructions
+  unsigned branches = 0;     // Branch instructions
+  unsigned waitcnts = 0;     // s_waitcnt instructions
+  unsigned sgprSpills = 0;   // v_writelane instructions, an upper bound of the SGPRs spilled to VGPR lanes
+  unsigned vgprSpills = 0;   // Stores to scratch, an estimate of the VGPRs spilled to memory
+  unsigned wavesPerSimd = 0; // Estimated occupancy in waves per SIMD
+  // Whether the scratch of a compute shader that spills would fit in the LDS left over by it
+  bool ldsSpillCandidate = false;
+};
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Checks whether the ISA statistics are to be added to each pipeline ELF (option -isa-stats).
+bool lgc::isIsaStatsEnabled() {
+  return IsaStats;
+}
+
+// =====================================================================================================================
+// Counts one instruction in the statistics of a hardware stage, by the category that its opcode name starts with.
+//
+// @param name : Opcode name of the instruction, such as "V_ADD_F32_e32_gfx10"
+// @param hasScratch : Whether the hardware stage uses scratch memory, so that its MUBUF stores without an address are
+//                     taken as spills
+// @param [in/out] stats : Statistics of the hardware stage
+static void countInstruction(StringRef name, bool hasScratch, StageIsaStats &stats) {
+  ++stats.instructions;
+  if (name.startswith("S_WAITCNT"))
+    ++stats.waitcnts;
+  else if (name.startswith("S_BRANCH") || name.startswith("S_CBRANCH") || name.startswith("S_SETPC") ||
+           name.startswith("S_SWAPPC"))
+    ++stats.branches;
+  else if (name.startswith("S_LOAD_") || name.startswith("S_BUFFER_") || name.startswith("S_STORE_") ||
+           name.startswith("S_SCRATCH_") || name.startswith("S_ATOMIC_") || name.startswith("S_DCACHE_") ||
+           name.startswith("S_MEMTIME") || name.startswith("S_MEMREALTIME"))
+    ++stats.smem;
+  else if (name.startswith("S_"))
+    ++stats.salu;
+  else if (name.startswith("DS_"))
+    ++stats.lds;
+  else if (name.startswith("EXP"))
+    ++stats.exports;
+  else if (name.startswith("BUFFER_") || name.startswith("TBUFFER_") || name.startswith("IMAGE_") ||
+           name.startswith("GLOBAL_") || name.startswith("FLAT_") || name.startswith("SCRATCH_")) {
+    ++stats.vmem;
+    // The backend spills VGPRs with scratch stores, or on older targets with MUBUF stores in offset-only mode.
+    if (name.startswith("SCRATCH_STORE") ||
+        (hasScratch && name.startswith("BUFFER_STORE") && name.contains("_OFFSET") && !name.contains("_OFFEN")))
+      ++stats.vgprSpills;
+  } else {
+    ++stats.valu;
+    // The backend spills SGPRs into lanes of VGPRs.
+    if (name.startswith("V_WRITELANE"))
+      ++stats.sgprSpills;
+  }
+}
+
+// =====================================================================================================================
+// Gets an unsigned integer from a PAL metadata map, or 0 if it is not there.
+//
+// @param map : PAL metadata map
+// @param key : Key of the item
+// @returns : Value of the item
+static unsigned getUInt(msgpack::MapDocNode &map, StringRef key) {
+  auto it = map.find(key);
+  if (it == map.end() || it->second.getKind() != msgpack::Type::UInt)
+    return 0;
+  return it->second.getUInt();
+}
+
+// =====================================================================================================================
+// Gets the number of threads in a thread group of a compute shader.
+//
+// @param stageMap : Metadata map of the hardware stage
+// @returns : Number of threads in a thread group, or 0 if the hardware stage has no thread group dimensions
+static unsigned getThreadgroupSize(msgpack::MapDocNode &stageMap) {
+  auto dims = stageMap.find(Util::Abi::HardwareStageMetadataKey::ThreadgroupDimensions);
+  if (dims == stageMap.end() || dims->second.getKind() != msgpack::Type::Array)
+    return 0;
+  unsigned threads = 1;
+  for (auto &dim : dims->second.getArray())
+    threads *= dim.getKind() == msgpack::Type::UInt ? dim.getUInt() : 1;
+  return threads;
+}
+
+// =====================================================================================================================
+// Estimates the occupancy of a hardware stage in waves per SIMD, from its VGPR, SGPR and LDS usage.
+//
+// @param gfxMajor : Major version of the graphics IP
+// @param stageMap : PAL metadata of the hardware stage
+// @returns : Estimated number of waves per SIMD
+static unsigned estimateWavesPerSimd(unsigned gfxMajor, msgpack::MapDocNode &stageMap) {
+  const unsigned waveSize = getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::WavefrontSize);
+  const bool wave32 = gfxMajor >= 10 && waveSize == 32;
+  const unsigned maxWaves = gfxMajor >= 10 ? 16 : 10;
+  unsigned waves = maxWaves;
+
+  // VGPRs are allocated in granules out of the register file of each SIMD.
+  const unsigned vgprGranule = wave32 ? 8 : 4;
+  const unsigned totalVgprs = gfxMajor >= 10 ? (wave32 ? 1024 : 512) : 256;
+  const unsigned vgprs = alignTo(std::max(getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::VgprCount), 1U),
+                                 vgprGranule);
+  waves = std::min(waves, totalVgprs / vgprs);
+
+  // SGPRs only limit the occupancy before GFX10.
+  if (gfxMajor < 10) {
+    const unsigned sgprs = alignTo(std::max(getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::SgprCount), 1U), 16);
+    waves = std::min(waves, 800 / sgprs);
+  }
+
+  // LDS limits the thread groups of a compute shader that fit in a CU of four SIMDs.
+  const unsigned ldsSize = getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::LdsSize);
+  const unsigned threads = getThreadgroupSize(stageMap);
+  if (ldsSize != 0 && threads != 0) {
+    const unsigned wavesPerGroup = divideCeil(threads, waveSize != 0 ? waveSize : 64);
+    const unsigned groupsPerCu = 65536 / ldsSize;
+    waves = std::min(waves, std::max(groupsPerCu * wavesPerGroup / 4, 1U));
+  }
+  return std::max(waves, 1U);
+}
+
+// =====================================================================================================================
+// Checks whether the scratch memory of a compute shader that spills VGPRs would fit in the LDS left over by the shader,
+// that is, whether the shader would benefit from its spills going to LDS rather than to memory. The LLVM AMDGPU backend
+// has no LDS spill target, so this is only reported, for a developer to decide whether to move the data by hand.
+//
+// @param gfxMajor : Major version of the graphics IP, or 0 if unknown
+// @param stageMap : Metadata map of the hardware stage
+// @param stats : ISA statistics of the hardware stage
+// @returns : Whether the scratch of each lane of a whole thread group fits next to the LDS that the shader uses
+static bool isLdsSpillCandidate(unsigned gfxMajor, msgpack::MapDocNode &stageMap, const StageIsaStats &stats) {
+  const unsigned threads = getThreadgroupSize(stageMap);
+  const uint64_t scratchSize = getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::ScratchMemorySize);
+  if (threads == 0 || scratchSize == 0 || stats.vgprSpills == 0)
+    return false;
+  const uint64_t maxLdsSize = gfxMajor == 6 ? 32768 : 65536;
+  return getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::LdsSize) + scratchSize * threads <= maxLdsSize;
+}
+
+// =====================================================================================================================
+// Finds the PAL metadata note in the contents of a note section.
+//
+// @param notes : Contents of the note section
+// @returns : The msgpack blob of the PAL metadata, or an empty StringRef if there is none
+static StringRef findMetadataBlob(StringRef notes) {
+  constexpr unsigned NoteHeaderSize = 12;
+  while (notes.size() >= NoteHeaderSize) {
+    const unsigned nameSize = support::endian::read32le(notes.data());
+    const unsigned descSize = support::endian::read32le(notes.data() + 4);
+    const unsigned type = support::endian::read32le(notes.data() + 8);
+    const unsigned descOffset = NoteHeaderSize + alignTo<4>(nameSize);
+    if (notes.substr(NoteHeaderSize, nameSize).rtrim('\0') == Util::Abi::AmdGpuArchName &&
+        type == ELF::NT_AMDGPU_METADATA)
+      return notes.substr(descOffset, descSize);
+    notes = notes.drop_front(std::min(size_t(descOffset + alignTo<4>(descSize)), notes.size()));
+  }
+  return "";
+}
+
+// =====================================================================================================================
+// Builds the contents of a note section with the PAL metadata note replaced.
+//
+// @param notes : Contents of the note section
+// @param blob : New PAL metadata msgpack blob
+// @param [out] newNotes : New contents of the note section
+// @returns : True if the note section contained the PAL metadata note
+static bool replaceMetadataNote(StringRef notes, StringRef blob, SmallVectorImpl<char> &newNotes) {
+  constexpr unsigned NoteHeaderSize = 12;
+  bool replaced = false;
+  while (notes.size() >= NoteHeaderSize) {
+    const unsigned nameSize = support::endian::read32le(notes.data());
+    const unsigned descSize = support::endian::read32le(notes.data() + 4);
+    const unsigned type = support::endian::read32le(notes.data() + 8);
+    const unsigned descOffset = NoteHeaderSize + alignTo<4>(nameSize);
+    const unsigned totalSize = descOffset + alignTo<4>(descSize);
+    if (totalSize > notes.size())
+      return false;
+    StringRef name = notes.substr(NoteHeaderSize, nameSize).rtrim('\0');
+    StringRef desc = notes.substr(descOffset, descSize);
+    if (name == Util::Abi::AmdGpuArchName && type == ELF::NT_AMDGPU_METADATA) {
+      desc = blob;
+      replaced = true;
+    }
+
+    char header[NoteHeaderSize];
+    support::endian::write32le(header, nameSize);
+    support::endian::write32le(header + 4, desc.size());
+    support::endian::write32le(header + 8, type);
+    newNotes.append(header, header + NoteHeaderSize);
+    newNotes.append(notes.begin() + NoteHeaderSize, notes.begin() + descOffset);
+    newNotes.append(desc.begin(), desc.end());
+    newNotes.resize(alignTo<4>(newNotes.size()));
+    notes = notes.drop_front(totalSize);
+  }
+  return replaced;
+}
+
+// =====================================================================================================================
+// Rewrites an ELF with its PAL metadata note replaced, laying out its sections again as their sizes change.
+//
+// @param [in/out] elf : ELF to rewrite
+// @param blob : New PAL metadata msgpack blob
+static void replaceMetadataBlob(SmallVectorImpl<char> &elf, StringRef blob) {
+  using Ehdr = object::ELF64LE::Ehdr;
+  using Shdr = object::ELF64LE::Shdr;
+  const Ehdr &header = *reinterpret_cast<const Ehdr *>(elf.data());
+  SmallVector<Shdr, 8> sections(reinterpret_cast<const Shdr *>(elf.data() + header.e_shoff),
+                                reinterpret_cast<const Shdr *>(elf.data() + header.e_shoff) + header.e_shnum);
+
+  SmallString<0> newElf;
+  newElf.append(elf.data(), elf.data() + sizeof(Ehdr));
+  for (Shdr &section : sections) {
+    if (section.sh_type == ELF::SHT_NULL)
+      continue;
+    StringRef data(elf.data() + section.sh_offset, section.sh_type == ELF::SHT_NOBITS ? 0 : section.sh_size);
+    SmallString<0> newNotes;
+    if (section.sh_type == ELF::SHT_NOTE && replaceMetadataNote(data, blob, newNotes)) {
+      data = newNotes;
+      section.sh_size = data.size();
+    }
+    newElf.resize(alignTo(newElf.size(), std::max(uint64_t(section.sh_addralign), uint64_t(1))));
+    section.sh_offset = newElf.size();
+    newElf.append(data.begin(), data.end());
+  }
+
+  newElf.resize(alignTo<8>(newElf.size()));
+  reinterpret_cast<Ehdr *>(newElf.data())->e_shoff = newElf.size();
+  newElf.append(reinterpret_cast<const char *>(sections.data()),
+                reinterpret_cast<const char *>(sections.data() + sections.size()));
+  elf.assign(newElf.begin(), newElf.end());
+}
+
+// =====================================================================================================================
+// Adds the static ISA statistics of each hardware stage of a pipeline ELF to its PAL metadata note, as a map under
+// ".isa_stats" in the metadata of the hardware stage, and prints them to outs if it is set. The instruction mix comes
+// from disassembling the code of the entry-point of the hardware stage; the spill counts are estimates from the
+// instructions that the backend spills with, and the occupancy is estimated from the register and LDS usage in the
+// metadata. An ELF that cannot be decoded is left as it is.
+//
+// @param [in/out] elf : Pipeline ELF
+// @param targetMachine : Target machine, for disassembling the code
+// @param outs : Stream to print the statistics to, or nullptr
+void lgc::addIsaStatsToElf(SmallVectorImpl<char> &elf, TargetMachine &targetMachine, raw_ostream *outs) {
+  using Ehdr = object::ELF64LE::Ehdr;
+  using Shdr = object::ELF64LE::Shdr;
+  if (elf.size() < sizeof(Ehdr))
+    return;
+  const Ehdr &header = *reinterpret_cast<const Ehdr *>(elf.data());
+  if (!header.checkMagic() || header.getFileClass() != ELF::ELFCLASS64 || header.e_phnum != 0 ||
+      header.e_shoff + header.e_shnum * sizeof(Shdr) > elf.size())
+    return;
+
+  Expected<std::unique_ptr<object::ObjectFile>> objFileOrErr =
+      object::ObjectFile::createELFObjectFile(MemoryBufferRef(StringRef(elf.data(), elf.size()), "IsaStats"));
+  if (!objFileOrErr) {
+    consumeError(objFileOrErr.takeError());
+    return;
+  }
+  object::ObjectFile &objFile = **objFileOrErr;
+
+  // Find the PAL metadata.
+  StringRef blob;
+  for (const object::SectionRef &section : objFile.sections()) {
+    if (object::ELFSectionRef(section).getType() == ELF::SHT_NOTE) {
+      blob = findMetadataBlob(cantFail(section.getContents()));
+      if (!blob.empty())
+        break;
+    }
+  }
+  msgpack::Document document;
+  if (blob.empty() || !document.readFromBlob(blob, false))
+    return;
+  auto pipelines = document.getRoot().getMap(true)[Util::Abi::PalCodeObjectMetadataKey::Pipelines];
+  if (pipelines.getKind() != msgpack::Type::Array || pipelines.getArray().size() == 0)
+    return;
+  auto hwStages = pipelines.getArray()[0].getMap(true)[Util::Abi::PipelineMetadataKey::HardwareStages];
+  if (hwStages.getKind() != msgpack::Type::Map)
+    return;
+
+  // Find the code of each function symbol.
+  StringMap<StringRef> functionCode;
+  for (const object::SymbolRef &symbol : objFile.symbols()) {
+    object::ELFSymbolRef elfSymbol(symbol);
+    if (elfSymbol.getELFType() != ELF::STT_FUNC)
+      continue;
+    object::section_iterator section = cantFail(symbol.getSection());
+    if (section == objFile.section_end())
+      continue;
+    StringRef contents = cantFail(section->getContents());
+    uint64_t offset = cantFail(symbol.getValue());
+    if (offset + elfSymbol.getSize() <= contents.size())
+      functionCode[cantFail(symbol.getName())] = contents.substr(offset, elfSymbol.getSize());
+  }
+
+  // The disassembler is not initialized by a lazy LgcContext::initialize.
+  LLVMInitializeAMDGPUDisassembler();
+  const MCSubtargetInfo &subtargetInfo = *targetMachine.getMCSubtargetInfo();
+  const MCInstrInfo &instrInfo = *targetMachine.getMCInstrInfo();
+  MCContext context(targetMachine.getTargetTriple(), targetMachine.getMCAsmInfo(), targetMachine.getMCRegisterInfo(),
+                    &subtargetInfo);
+  std::unique_ptr<MCDisassembler> disassembler(targetMachine.getTarget().createMCDisassembler(subtargetInfo, context));
+  if (!disassembler)
+    return;
+  unsigned gfxMajor = 0;
+  StringRef cpuName = targetMachine.getTargetCPU();
+  if (cpuName.consume_front("gfx") && cpuName.size() > 2)
+    cpuName.drop_back(2).getAsInteger(10, gfxMajor);
+
+  if (outs) {
+    *outs << "===============================================================================\n"
+          << "// LLPC ISA statistics\n";
+  }
+
+  for (auto &hwStage : hwStages.getMap()) {
+    if (hwStage.first.getKind() != msgpack::Type::String || hwStage.second.getKind() != msgpack::Type::Map)
+      continue;
+    msgpack::MapDocNode stageMap = hwStage.second.getMap();
+    auto entryPoint = stageMap.find(Util::Abi::HardwareStageMetadataKey::EntryPoint);
+    if (entryPoint == stageMap.end() || entryPoint->second.getKind() != msgpack::Type::String)
+      continue;
+    auto code = functionCode.find(entryPoint->second.getString());
+    if (code == functionCode.end())
+      continue;
+
+    // Disassemble the code of the entry-point, skipping a dword at a time over what does not decode.
+    StageIsaStats stats;
+    const bool hasScratch = getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::ScratchMemorySize) != 0;
+    ArrayRef<uint8_t> bytes(reinterpret_cast<const uint8_t *>(code->second.data()), code->second.size());
+    stats.codeSize = bytes.size();
+    for (uint64_t offset = 0; offset < bytes.size();) {
+      MCInst inst;
+      uint64_t size = 0;
+      if (disassembler->getInstruction(inst, size, bytes.slice(offset), offset, nulls()) != MCDisassembler::Success ||
+          size == 0) {
+        offset += 4;
+        continue;
+      }
+      countInstruction(instrInfo.getName(inst.getOpcode()), hasScratch, stats);
+      offset += size;
+    }
+    stats.wavesPerSimd = estimateWavesPerSimd(gfxMajor, stageMap);
+    stats.ldsSpillCandidate = isLdsSpillCandidate(gfxMajor, stageMap, stats);
+
+    msgpack::MapDocNode statsMap = stageMap[IsaStatsKey].getMap(true);
+    statsMap[".instructions"] = stats.instructions;
+    statsMap[".code_size"] = stats.codeSize;
+    statsMap[".salu"] = stats.salu;
+    statsMap[".valu"] = stats.valu;
+    statsMap[".smem"] = stats.smem;
+    statsMap[".vmem"] = stats.vmem;
+    statsMap[".lds"] = stats.lds;
+    statsMap[".exports"] = stats.exports;
+    statsMap[".branches"] = stats.branches;
+    statsMap[".waitcnts"] = stats.waitcnts;
+    statsMap[".sgpr_spill_estimate"] = stats.sgprSpills;
+    statsMap[".vgpr_spill_estimate"] = stats.vgprSpills;
+    statsMap[".waves_per_simd_estimate"] = stats.wavesPerSimd;
+    statsMap[".lds_spill_candidate"] = stats.ldsSpillCandidate;
+
+    if (outs) {
+      *outs << hwStage.first.getString() << ": instructions " << stats.instructions << ", code size " << stats.codeSize
+            << ", salu " << stats.salu << ", valu " << stats.valu << ", smem " << stats.smem << ", vmem "
+            << stats.vmem << ", lds " << stats.lds << ", exports " << stats.exports << ", branches "
+            << stats.branches << ", s_waitcnt " << stats.waitcnts << ", vgprs "
+            << getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::VgprCount) << ", sgprs "
+            << getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::SgprCount) << ", lds size "
+            << getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::LdsSize) << ", scratch size "
+            << getUInt(stageMap, Util::Abi::HardwareStageMetadataKey::ScratchMemorySize) << ", sgpr spills ~"
+            << stats.sgprSpills << ", vgpr spills ~" << stats.vgprSpills << ", waves/SIMD ~" << stats.wavesPerSimd
+            << (stats.ldsSpillCandidate ? ", scratch fits in LDS" : "") << "\n";
+    }
+  }
+  if (outs)
+    *outs << "\n";
+
+  std::string newBlob;
+  document.writeToBlob(newBlob);
+  replaceMetadataBlob(elf, newBlob);
+}
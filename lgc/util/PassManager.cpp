@@ -31,13 +31,17 @@
 #include "lgc/PassManager.h"
 #include "lgc/util/Debug.h"
 #include "llvm/Analysis/CFGPrinter.h"
+#include "llvm/Analysis/LazyCallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/PrintPasses.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/StandardInstrumentations.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Transforms/Scalar/JumpThreading.h"
+#include <chrono>
 
 namespace llvm {
 namespace cl {
@@ -52,6 +56,11 @@ static cl::opt<std::string> DumpCfgAfter("dump-cfg-after", cl::desc("Dump CFG as
 // -dump-pass-name : dump executed pass name
 static cl::opt<bool> DumpPassName("dump-pass-name", cl::desc("Dump executed pass name"), cl::init(false));
 
+// -dump-pass-stats : dump the time taken and the change in instruction count of each executed pass
+static cl::opt<bool> DumpPassStats("dump-pass-stats",
+                                   cl::desc("Dump the time and the instruction count change of each executed pass"),
+                                   cl::init(false));
+
 // -disable-pass-indices: indices of passes to be disabled
 static cl::list<unsigned> DisablePassIndices("disable-pass-indices", cl::ZeroOrMore,
                                              cl::desc("Indices of passes to be disabled"));
@@ -65,6 +74,58 @@ using namespace llvm;
 
 namespace {
 
+// =====================================================================================================================
+// Recorder of the statistics of the executed passes for -dump-pass-stats: the wall time each pass takes, and the
+// instruction count of the module before and after it. Passes run by a pass that is being recorded (such as the
+// function passes of a pass adaptor) are recorded too, so the recorder keeps a stack of the passes being run.
+class PassStats {
+public:
+  void begin(StringRef passName, unsigned passIndex, const Module &module);
+  void end();
+
+private:
+  // A pass that is being run
+  struct RunningPass {
+    std::string passName;                             // Name of the pass
+    unsigned passIndex;                               // Index of the pass, for -disable-pass-indices
+    const Module *module;                             // Module the pass is run on (or on a part of)
+    unsigned instCount;                               // Instruction count of the module before the pass
+    std::chrono::steady_clock::time_point startTime; // Time the pass started
+  };
+  SmallVector<RunningPass, 4> m_runningPasses; // Stack of the passes being run
+};
+
+// =====================================================================================================================
+// Legacy pass that marks the beginning or the end of a pass for the PassStats recorder. It is added before and after
+// each pass in the legacy pass manager.
+class LegacyPassStatsPass final : public ModulePass {
+public:
+  LegacyPassStatsPass(PassStats &passStats, StringRef passName, unsigned passIndex, bool isBegin)
+      : ModulePass(ID), m_passStats(passStats), m_passName(passName), m_passIndex(passIndex), m_isBegin(isBegin) {}
+
+  bool runOnModule(Module &module) override {
+    if (m_isBegin)
+      m_passStats.begin(m_passName, m_passIndex, module);
+    else
+      m_passStats.end();
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override { analysisUsage.setPreservesAll(); }
+
+  StringRef getPassName() const override { return "Record pass statistics"; }
+
+  static char ID; // ID of this pass
+
+private:
+  PassStats &m_passStats; // Recorder of the pass statistics
+  std::string m_passName; // Name of the recorded pass
+  unsigned m_passIndex;   // Index of the recorded pass
+  bool m_isBegin;         // Whether this marks the beginning (rather than the end) of the recorded pass
+};
+
+char LegacyPassStatsPass::ID = 0;
+
 // =====================================================================================================================
 // LLPC's legacy::PassManager override.
 // This is the implementation subclass of the PassManager class declared in PassManager.h
@@ -83,6 +144,7 @@ private:
   AnalysisID m_printModule = nullptr;   // Pass id of dump pass "Print Module IR"
   AnalysisID m_jumpThreading = nullptr; // Pass id of opt pass "Jump Threading"
   unsigned *m_passIndex = nullptr;      // Pass Index
+  PassStats m_passStats;                // Recorder of the pass statistics for -dump-pass-stats
 };
 
 // =====================================================================================================================
@@ -106,10 +168,53 @@ private:
   VerifyInstrumentation instrumentationVerify;   // Verify instrumentation, run module verifier after each pass.
   unsigned *m_passIndex = nullptr;               // Pass Index.
   bool initialized = false;                      // Whether the pass manager is initialized or not
+  PassStats m_passStats;                         // Recorder of the pass statistics for -dump-pass-stats.
 };
 
 } // namespace
 
+// =====================================================================================================================
+// Record the beginning of a pass
+//
+// @param passName : Name of the pass
+// @param passIndex : Index of the pass
+// @param module : Module the pass is run on (or on a part of)
+void PassStats::begin(StringRef passName, unsigned passIndex, const Module &module) {
+  m_runningPasses.push_back(
+      {passName.str(), passIndex, &module, module.getInstructionCount(), std::chrono::steady_clock::now()});
+}
+
+// =====================================================================================================================
+// Record the end of the most recently begun pass, and dump its statistics
+void PassStats::end() {
+  if (m_runningPasses.empty())
+    return;
+  RunningPass runningPass = m_runningPasses.pop_back_val();
+  std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - runningPass.startTime;
+  LLPC_OUTS("Pass[" << runningPass.passIndex << "] = " << runningPass.passName << ": " << format("%.3f", time.count())
+                    << " ms, instructions " << runningPass.instCount << " -> "
+                    << runningPass.module->getInstructionCount() << "\n");
+}
+
+// =====================================================================================================================
+// Get the module of the IR unit that a pass in the new pass manager is run on
+//
+// @param ir : IR unit (module, function, SCC or loop)
+// @returns : The module containing the IR unit, or nullptr if it is not known
+static const Module *getModuleOfIr(Any ir) {
+  if (any_isa<const Module *>(ir))
+    return any_cast<const Module *>(ir);
+  if (any_isa<const Function *>(ir))
+    return any_cast<const Function *>(ir)->getParent();
+  if (any_isa<const LazyCallGraph::SCC *>(ir)) {
+    const LazyCallGraph::SCC *scc = any_cast<const LazyCallGraph::SCC *>(ir);
+    return scc->begin() != scc->end() ? scc->begin()->getFunction().getParent() : nullptr;
+  }
+  if (any_isa<const Loop *>(ir))
+    return any_cast<const Loop *>(ir)->getHeader()->getModule();
+  return nullptr;
+}
+
 // =====================================================================================================================
 // Get the PassInfo for a registered pass given short name
 //
@@ -222,6 +327,43 @@ void PassManagerImpl::registerCallbacks() {
   instrumentationCallbacks.registerBeforeSkippedPassCallback(beforePass);
   instrumentationCallbacks.registerBeforeNonSkippedPassCallback(beforePass);
 
+  // Record the time and instruction count change of each pass that is run on an IR unit whose module is known. (A pass
+  // that invalidates its IR unit, such as by deleting a loop, was run on one whose module was known.)
+  if (cl::DumpPassStats) {
+    instrumentationCallbacks.registerBeforeNonSkippedPassCallback([this](StringRef passName, Any ir) {
+      const Module *module = getModuleOfIr(ir);
+      if (passName != PrintModulePass::name() && module)
+        m_passStats.begin(passName, m_passIndex ? *m_passIndex - 1 : 0, *module);
+    });
+    auto afterPass = [this](StringRef passName, Any ir) {
+      if (passName != PrintModulePass::name() && getModuleOfIr(ir))
+        m_passStats.end();
+    };
+    instrumentationCallbacks.registerAfterPassCallback(
+        [afterPass](StringRef passName, Any ir, const PreservedAnalyses &preserved) { afterPass(passName, ir); });
+    instrumentationCallbacks.registerAfterPassInvalidatedCallback(
+        [this](StringRef passName, const PreservedAnalyses &preserved) {
+          if (passName != PrintModulePass::name())
+            m_passStats.end();
+        });
+  }
+
+  // Record each pass that is run as a time trace event, if the front-end enabled the trace profiler on this thread,
+  // with the pass index as its detail so that it can be matched with -dump-pass-stats and -disable-pass-indices.
+  // (The legacy pass manager does this itself.)
+  if (timeTraceProfilerEnabled()) {
+    instrumentationCallbacks.registerBeforeNonSkippedPassCallback([this](StringRef passName, Any ir) {
+      timeTraceProfilerBegin(passName, [&]() {
+        return passName != PrintModulePass::name() && m_passIndex ? ("Pass[" + Twine(*m_passIndex - 1) + "]").str()
+                                                                   : std::string();
+      });
+    });
+    instrumentationCallbacks.registerAfterPassCallback(
+        [](StringRef passName, Any ir, const PreservedAnalyses &preserved) { timeTraceProfilerEnd(); });
+    instrumentationCallbacks.registerAfterPassInvalidatedCallback(
+        [](StringRef passName, const PreservedAnalyses &preserved) { timeTraceProfilerEnd(); });
+  }
+
   instrumentationCallbacks.registerShouldRunOptionalPassCallback([this](StringRef passName, Any ir) {
     // Skip the jump threading pass as it interacts really badly with the structurizer.
     if (passName == JumpThreadingPass::name())
@@ -255,8 +397,9 @@ void LegacyPassManagerImpl::add(Pass *pass) {
   if (passId == m_jumpThreading)
     return;
 
+  unsigned passIndex = 0;
   if (passId != m_printModule && m_passIndex) {
-    unsigned passIndex = (*m_passIndex)++;
+    passIndex = (*m_passIndex)++;
 
     for (auto disableIndex : cl::DisablePassIndices) {
       if (disableIndex == passIndex) {
@@ -269,8 +412,15 @@ void LegacyPassManagerImpl::add(Pass *pass) {
       LLPC_OUTS("Pass[" << passIndex << "] = " << pass->getPassName() << "\n");
   }
 
-  // Add the pass to the superclass pass manager.
+  // Add the pass to the superclass pass manager, between passes to record its statistics if needed. (For a function
+  // pass, this ends the function pass manager it would otherwise share with the passes around it, so each function
+  // pass is run on all the functions in turn.)
+  const bool recordStats = cl::DumpPassStats && passId != m_printModule && !pass->getAsImmutablePass();
+  if (recordStats)
+    legacy::PassManager::add(new LegacyPassStatsPass(m_passStats, pass->getPassName(), passIndex, /*isBegin=*/true));
   legacy::PassManager::add(pass);
+  if (recordStats)
+    legacy::PassManager::add(new LegacyPassStatsPass(m_passStats, "", passIndex, /*isBegin=*/false));
 
   if (cl::VerifyIr) {
     // Add a verify pass after it.
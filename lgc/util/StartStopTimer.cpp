@@ -33,6 +33,7 @@
 #include "lgc/util/Internal.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 
 #define DEBUG_TYPE "lgc-start-stop-timer"
@@ -115,6 +116,14 @@ bool StartStopTimer::runImpl(Module &module) {
     m_timer->startTimer();
   else
     m_timer->stopTimer();
+
+  // Also record the phase in the time trace, if the front-end enabled the trace profiler on this thread.
+  if (timeTraceProfilerEnabled()) {
+    if (m_starting)
+      timeTraceProfilerBegin(m_timer->getName(), "");
+    else
+      timeTraceProfilerEnd();
+  }
   return false;
 }
 
@@ -32,6 +32,7 @@
 #include "LLVMSPIRVLib.h"
 #include "SPIRVInternal.h"
 #include "llpcCacheAccessor.h"
+#include "llpcCacheStats.h"
 #include "llpcComputeContext.h"
 #include "llpcContext.h"
 #include "llpcDebug.h"
@@ -39,11 +40,14 @@
 #include "llpcError.h"
 #include "llpcFile.h"
 #include "llpcGraphicsContext.h"
+#include "llpcPipelineBuildJob.h"
+#include "llpcPipelineBuildScheduler.h"
 #include "llpcShaderModuleHelper.h"
 #include "llpcSpirvLower.h"
 #include "llpcSpirvLowerResourceCollect.h"
 #include "llpcSpirvLowerTranslator.h"
 #include "llpcSpirvLowerUtil.h"
+#include "llpcThreading.h"
 #include "llpcTimerProfiler.h"
 #include "llpcUtil.h"
 #include "spirvExt.h"
@@ -54,12 +58,16 @@
 #include "lgc/ElfLinker.h"
 #include "lgc/EnumIterator.h"
 #include "lgc/PassManager.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
@@ -68,7 +76,9 @@
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <mutex>
 #include <set>
 #include <unordered_set>
@@ -141,10 +151,51 @@ opt<unsigned> ShaderCacheMode("shader-cache-mode",
                                    "load on-disk cache for read/write, 4 - load on-disk cache for read only"),
                               init(0));
 
+// -shader-cache-max-memory-size: budget of the shader data held in memory by the internal shader cache
+opt<unsigned> ShaderCacheMaxMemorySize("shader-cache-max-memory-size",
+                                       desc("Maximum size in MB of the shader data that the internal shader cache "
+                                            "holds in memory (0 for no limit)"),
+                                       value_desc("size"), init(0));
+
+// -shader-cache-max-file-size: budget of the on-disk file of the internal shader cache
+opt<unsigned> ShaderCacheMaxFileSize("shader-cache-max-file-size",
+                                     desc("Maximum size in MB of the on-disk file of the internal shader cache, "
+                                          "which is compacted once it is exceeded (0 for no limit)"),
+                                     value_desc("size"), init(0));
+
 // -cache-full-pipelines: Add full pipelines to the caches that are provided.
 opt<bool> CacheFullPipelines("cache-full-pipelines", desc("Add full pipelines to the caches that are provided."),
                              init(true));
 
+// -dedup-in-flight-pipelines: share the build of a pipeline requested by several threads at the same time
+static opt<bool> DedupInFlightPipelines("dedup-in-flight-pipelines",
+                                        desc("Make a thread building a pipeline that another thread is already "
+                                             "building wait for that build and share its ELF"),
+                                        init(true));
+
+// -slow-pipeline-dump-threshold: compile time above which a pipeline is dumped
+opt<unsigned> SlowPipelineDumpThreshold("slow-pipeline-dump-threshold",
+                                        desc("Dump each pipeline whose compile takes longer than this many "
+                                             "milliseconds, with its compile time and phase timings (0 to disable)"),
+                                        value_desc("ms"), init(0));
+
+// -background-build-cost-threshold: estimated compile time above which a background build is recommended
+static opt<unsigned> BackgroundBuildCostThreshold("background-build-cost-threshold",
+                                                  desc("Estimated compile time in milliseconds above which "
+                                                       "EstimatePipelineCost recommends building a pipeline in the "
+                                                       "background"),
+                                                  value_desc("ms"), init(10));
+
+// -slow-pipeline-dump-dir: directory where slow pipelines are dumped
+static opt<std::string> SlowPipelineDumpDir("slow-pipeline-dump-dir",
+                                            desc("Directory where pipelines slower than "
+                                                 "-slow-pipeline-dump-threshold are dumped"),
+                                            value_desc("dir"), init("."));
+
+// -slow-pipeline-dump-limit: maximum number of slow pipelines to dump
+static opt<unsigned> SlowPipelineDumpLimit("slow-pipeline-dump-limit",
+                                           desc("Maximum number of slow pipelines to dump in a process"), init(16));
+
 // -executable-name: executable file name
 static opt<std::string> ExecutableName("executable-name", desc("Executable file name"), value_desc("filename"),
                                        init("amdllpc"));
@@ -152,20 +203,101 @@ static opt<std::string> ExecutableName("executable-name", desc("Executable file
 // -trim-debug-info: Trim debug information in SPIR-V binary
 opt<bool> TrimDebugInfo("trim-debug-info", cl::desc("Trim debug information in SPIR-V binary"), init(true));
 
+// -debug-info-line-tables-only: Translate only the source line information from the SPIR-V debug information
+opt<bool> DebugInfoLineTablesOnly("debug-info-line-tables-only",
+                                  cl::desc("With -trim-debug-info=false, translate only the source line information "
+                                           "from the SPIR-V debug information, not the debug information of "
+                                           "variables, types and lexical scopes"),
+                                  init(false));
+
+// -optimize-module-spirv: Optimize the SPIR-V binary of a shader module when it is built
+opt<bool> OptimizeModuleSpirv("optimize-module-spirv",
+                              cl::desc("Optimize the SPIR-V binary of a shader module once when the module is built, "
+                                       "and keep the smaller binary in the module data for all of its pipelines "
+                                       "(needs LLPC built with LLPC_ENABLE_SPIRV_OPT)"),
+                              init(false));
+
 // -enable-per-stage-cache: Enable shader cache per shader stage
 opt<bool> EnablePerStageCache("enable-per-stage-cache", cl::desc("Enable shader cache per shader stage"), init(true));
 
 // -context-reuse-limit: The maximum number of times a compiler context can be reused.
 opt<int> ContextReuseLimit("context-reuse-limit",
-                           cl::desc("The maximum number of times a compiler context can be reused"), init(100));
+                           cl::desc("The maximum number of times a compiler context can be reused (0 for no limit)"),
+                           init(0));
+
+// -context-reset-size: Reset a compiler context once the SPIR-V translated in it exceeds this size.
+opt<unsigned> ContextResetSize("context-reset-size",
+                               cl::desc("Reset a compiler context once the total size of SPIR-V translated in it, an "
+                                        "estimate of the types and constants it has accumulated, exceeds this many "
+                                        "KB (0 for no limit)"),
+                               init(4096));
+
+// -parallel-stage-translation: Translate and lower the shader stages of a pipeline concurrently
+opt<bool> ParallelStageTranslation("parallel-stage-translation",
+                                   cl::desc("Translate and lower the shader stages of a pipeline concurrently, each "
+                                            "in its own LLVM context"),
+                                   init(false));
+
+// -enable-translated-ir-cache: Cache the translated and lowered IR of each shader stage
+opt<bool> EnableTranslatedIrCache("enable-translated-ir-cache",
+                                  cl::desc("Cache the translated and lowered IR of each shader stage, so that a shader "
+                                           "used by several pipelines is translated from SPIR-V only once"),
+                                  init(false));
+
+// -spec-constant-placeholders: Share the translated IR of a shader between its specializations
+opt<bool> SpecConstantPlaceholders("spec-constant-placeholders",
+                                   cl::desc("With -enable-translated-ir-cache, translate the scalar specialization "
+                                            "constants of a shader as placeholders where possible, so that the "
+                                            "translated IR is cached once for all specializations of the shader"),
+                                   init(false));
+
+// -pre-lower-shader-modules: Translate and lower the entry-points of each shader module in the background
+opt<bool> PreLowerShaderModules("pre-lower-shader-modules",
+                                cl::desc("With -enable-translated-ir-cache, translate and lower each entry-point of a "
+                                         "shader module into the translated IR cache in the background when the "
+                                         "module is built"),
+                                init(false));
+
+// -glue-shader-cache-size: The number of glue shader ELFs kept in memory by a compiler.
+opt<unsigned> GlueShaderCacheSize("glue-shader-cache-size",
+                                  cl::desc("The number of most recently used glue shader ELFs kept in memory by a "
+                                           "compiler, in front of the shader caches (0 to disable)"),
+                                  init(64));
+
+// -non-fragment-elf-cache-size: The number of decoded non-fragment pipeline halves kept in memory by a compiler.
+opt<unsigned> NonFragmentElfCacheSize("non-fragment-elf-cache-size",
+                                      cl::desc("The number of most recently used non-fragment pipeline halves kept "
+                                               "decoded in memory by a compiler, for merging with fragment halves "
+                                               "(0 to disable)"),
+                                      init(16));
+
+// -compute-library-cache-size: The number of compute library ELFs kept in memory by a compiler.
+opt<unsigned> ComputeLibraryCacheSize("compute-library-cache-size",
+                                      cl::desc("The number of most recently used compute library ELFs kept in memory "
+                                               "by a compiler, for linking into the compute pipelines that call them "
+                                               "(0 to disable)"),
+                                      init(16));
+
+// -negative-cache-ttl: The time in milliseconds for which a compiler remembers that a pipeline failed to compile.
+opt<unsigned> NegativeCacheTtl("negative-cache-ttl",
+                               cl::desc("The time in milliseconds for which a compiler remembers that a pipeline "
+                                        "failed to compile, and fails building it again without compiling it "
+                                        "(0 to disable)"),
+                               init(0));
+
+// -parallel-glue-shader-compile: Compile the glue shaders of a pipeline that miss in the caches concurrently
+opt<bool> ParallelGlueShaderCompile("parallel-glue-shader-compile",
+                                    cl::desc("Compile the glue shaders of a pipeline that miss in the caches "
+                                             "concurrently, each in its own LLVM context"),
+                                    init(false));
 
 // -fatal-llvm-errors: Make all LLVM errors fatal
 opt<bool> FatalLlvmErrors("fatal-llvm-errors", cl::desc("Make all LLVM errors fatal"), init(false));
 
-// -new-pass-manager: Use LLVM's new pass manager (experimental)
+// -new-pass-manager: Use LLVM's new pass manager
 opt<unsigned> NewPassManager("new-pass-manager",
                              cl::desc("0 - Legacy pass manager, 1 - New pass manager front-end, 2 - New pass manager "
-                                      "front-end and middle-end (experimental)"),
+                                      "front-end and middle-end"),
                              init(1));
 
 extern opt<bool> EnableOuts;
@@ -180,7 +312,7 @@ extern opt<std::string> LogFileOuts;
 
 } // namespace llvm
 
-// -use-builder-recorder
+// -use-builder-recorder: if not given, a pipeline compile only records when it needs to (see useBuilderRecorder)
 static cl::opt<bool> UseBuilderRecorder("use-builder-recorder",
                                         cl::desc("Do lowering via recording and replaying LLPC builder"),
                                         cl::init(true));
@@ -224,15 +356,185 @@ static void fatalErrorHandler(void *userData, const char *reason, bool genCrashD
 }
 
 // =====================================================================================================================
-// Returns the cache accessor object resulting from checking the caches for the glue shader for the given identifier.
+// Dumps a pipeline whose compile took longer than -slow-pipeline-dump-threshold to -slow-pipeline-dump-dir, along with
+// the SPIR-V of its shaders and its compile time and phase timings, unless -slow-pipeline-dump-limit pipelines have
+// been dumped already.
 //
-// @param glueShaderIdentifier : The linker object for which the glue shaders are needed.
-// @param context : The context that contains the application caches.
-// @param compiler : The compiler object that contains the internal caches.
-static CacheAccessor checkCacheForGlueShader(StringRef glueShaderIdentifier, Context *context, Compiler *compiler) {
-  Hash glueShaderCacheHash =
-      PipelineDumper::generateHashForGlueShader({glueShaderIdentifier.size(), glueShaderIdentifier.data()});
-  return CacheAccessor(context, glueShaderCacheHash, compiler->getInternalCaches());
+// @param context : Context of the pipeline
+// @param shaderInfo : Shader info of the stages of the pipeline
+// @param compileTime : Wall time of the compile, in milliseconds
+// @param phaseTimes : Wall times of the compile phases, as text
+static void dumpSlowPipeline(Context *context, ArrayRef<const PipelineShaderInfo *> shaderInfo, double compileTime,
+                             StringRef phaseTimes) {
+  static std::atomic<unsigned> SlowPipelineDumpCount(0);
+  if (SlowPipelineDumpCount >= cl::SlowPipelineDumpLimit)
+    return;
+
+  PipelineContext *pipelineContext = context->getPipelineContext();
+  PipelineBuildInfo pipelineInfo = {};
+  if (pipelineContext->isGraphics()) {
+    pipelineInfo.pGraphicsInfo =
+        static_cast<const GraphicsPipelineBuildInfo *>(pipelineContext->getPipelineBuildInfo());
+  } else {
+    pipelineInfo.pComputeInfo = static_cast<const ComputePipelineBuildInfo *>(pipelineContext->getPipelineBuildInfo());
+  }
+
+  // A pipeline that is dumped already (such as by the compile of another of its stages) gives no dump file.
+  PipelineDumpOptions dumpOptions = {};
+  dumpOptions.pDumpDir = cl::SlowPipelineDumpDir.c_str();
+  PipelineDumpFile *dumpFile =
+      PipelineDumper::BeginPipelineDump(&dumpOptions, pipelineInfo, context->getPipelineHashCode());
+  if (!dumpFile)
+    return;
+  ++SlowPipelineDumpCount;
+
+  for (const PipelineShaderInfo *shaderInfoEntry : shaderInfo) {
+    if (!shaderInfoEntry || !shaderInfoEntry->pModuleData)
+      continue;
+    auto moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfoEntry->pModuleData);
+    if (moduleData->binType == BinaryType::Spirv) {
+      MetroHash::Hash moduleHash = *reinterpret_cast<const MetroHash::Hash *>(&moduleData->hash[0]);
+      PipelineDumper::DumpSpirvBinary(dumpOptions.pDumpDir, &moduleData->binCode, &moduleHash);
+    }
+  }
+
+  std::string extraInfo;
+  raw_string_ostream ostream(extraInfo);
+  ostream << ";Compile time: " << format("%.3f", compileTime) << "ms" << phaseTimes;
+  ostream.flush();
+  PipelineDumper::DumpPipelineExtraInfo(dumpFile, &extraInfo);
+  PipelineDumper::EndPipelineDump(dumpFile);
+}
+
+// =====================================================================================================================
+// Returns the hash used to look up the glue shader for the given identifier in the caches.
+//
+// @param glueShaderIdentifier : The identifier of the glue shader.
+static MetroHash::Hash getCacheHashForGlueShader(StringRef glueShaderIdentifier) {
+  return PipelineDumper::generateHashForGlueShader({glueShaderIdentifier.size(), glueShaderIdentifier.data()});
+}
+
+// =====================================================================================================================
+// Returns the hash used to look up the translated and lowered IR of a shader stage in the caches. It covers the inputs
+// of SPIR-V translation and lowering: the shader module, entry point, specialization constants and shader options, the
+// pipeline options, the converting samplers of the resource mapping, the target and the compile options. With
+// specialization constant placeholders, the specialization constants are left out, as the cached IR is shared by all
+// specializations of the shader.
+//
+// @param context : The context of the pipeline that uses the shader
+// @param shaderInfo : The shader info of the stage
+// @param optionHash : The hash of the compile options
+// @param specConstPlaceholders : Whether the specialization constants are translated as placeholders
+static MetroHash::Hash generateHashForTranslatedShader(Context *context, const PipelineShaderInfo *shaderInfo,
+                                                       const MetroHash::Hash &optionHash, bool specConstPlaceholders) {
+  static const char TranslatedIrTag[] = "TranslatedIr";
+  static const char SpecConstPlaceholdersTag[] = "SpecConstPlaceholders";
+  MetroHash64 hasher;
+  hasher.Update(reinterpret_cast<const uint8_t *>(TranslatedIrTag), sizeof(TranslatedIrTag));
+  hasher.Update(optionHash);
+  hasher.Update(context->getGfxIpVersion());
+
+  PipelineShaderInfo unspecializedShaderInfo = *shaderInfo;
+  if (specConstPlaceholders) {
+    hasher.Update(reinterpret_cast<const uint8_t *>(SpecConstPlaceholdersTag), sizeof(SpecConstPlaceholdersTag));
+    unspecializedShaderInfo.pSpecializationInfo = nullptr;
+    shaderInfo = &unspecializedShaderInfo;
+  }
+  PipelineDumper::updateHashForPipelineShaderInfo(shaderInfo->entryStage, shaderInfo, true, &hasher, false);
+  PipelineDumper::updateHashForPipelineOptions(context->getPipelineContext()->getPipelineOptions(), &hasher, false);
+
+  // Only the YCbCr samplers of the resource mapping are read by the SPIR-V translator.
+  const ResourceMappingData *resourceMapping = context->getResourceMapping();
+  for (unsigned i = 0; i < resourceMapping->staticDescriptorValueCount; ++i) {
+    const StaticDescriptorValue &range = resourceMapping->pStaticDescriptorValues[i];
+    if (range.type != ResourceMappingNodeType::DescriptorYCbCrSampler)
+      continue;
+    hasher.Update(range.set);
+    hasher.Update(range.binding);
+    hasher.Update(range.arraySize);
+    hasher.Update(reinterpret_cast<const uint8_t *>(range.pValue),
+                  range.arraySize * SPIRV::ConvertingSamplerDwordCount * sizeof(unsigned));
+  }
+
+  MetroHash::Hash hash = {};
+  hasher.Finalize(hash.bytes);
+  return hash;
+}
+
+// =====================================================================================================================
+// Specializes a module that was translated with specialization constant placeholders (see readSpirv), by replacing each
+// placeholder with the value of its specialization constant, or with the default value of the constant if it is not
+// specialized. The constant expressions that used the placeholders are then folded, so the rest of the compile,
+// including the LGC optimization passes, sees the specialized values as plain constants.
+//
+// @param [in/out] module : The module to specialize
+// @param specializationInfo : The specialization info of the shader (may be null)
+static void specializeConstantPlaceholders(Module *module, const VkSpecializationInfo *specializationInfo) {
+  SmallVector<GlobalVariable *, 8> placeholders;
+  for (GlobalVariable &global : module->globals()) {
+    if (global.hasMetadata(gSPIRVMD::SpecConstPlaceholder))
+      placeholders.push_back(&global);
+  }
+  if (placeholders.empty())
+    return;
+
+  for (GlobalVariable *placeholder : placeholders) {
+    MDNode *placeholderMeta = placeholder->getMetadata(gSPIRVMD::SpecConstPlaceholder);
+    unsigned specId = mdconst::extract<ConstantInt>(placeholderMeta->getOperand(0))->getZExtValue();
+    ConstantInt *defaultValue = mdconst::extract<ConstantInt>(placeholderMeta->getOperand(1));
+    uint64_t value = defaultValue->getZExtValue();
+    for (unsigned i = 0; specializationInfo && i < specializationInfo->mapEntryCount; ++i) {
+      const VkSpecializationMapEntry &mapEntry = specializationInfo->pMapEntries[i];
+      if (mapEntry.constantID != specId)
+        continue;
+      assert(mapEntry.size <= sizeof(uint64_t));
+      value = 0;
+      memcpy(&value, voidPtrInc(specializationInfo->pData, mapEntry.offset), mapEntry.size);
+      // A boolean specialization constant is true for any non-zero value.
+      if (defaultValue->getBitWidth() == 1)
+        value = value != 0;
+    }
+
+    Constant *address = ConstantExpr::getIntToPtr(ConstantInt::get(Type::getInt64Ty(module->getContext()), value),
+                                                  placeholder->getType());
+    placeholder->replaceAllUsesWith(address);
+    placeholder->eraseFromParent();
+  }
+
+  const DataLayout &dataLayout = module->getDataLayout();
+  for (Function &func : *module) {
+    for (Instruction &inst : instructions(func)) {
+      for (Use &operand : inst.operands()) {
+        if (auto expr = dyn_cast<ConstantExpr>(operand))
+          operand.set(ConstantFoldConstant(expr, dataLayout));
+      }
+    }
+  }
+}
+
+// =====================================================================================================================
+// Decide whether the front-end of a pipeline compile records its Builder calls for BuilderReplayer to replay, or
+// uses BuilderImpl directly, which saves generating the IR twice. Recording is only needed where the pipeline state
+// is not complete when the front-end runs, and where the front-end output does not go straight into the pipeline
+// module: stages translated in their own contexts or through the translated-IR cache, and LLVM bitcode input, which
+// was recorded. With -v, the IR dumps show the recorded lgc.create.* calls as they always have.
+//
+// @param shaderInfo : Shader info of this pipeline
+// @param unlinked : Whether some pipeline state is not provided to LGC
+// @returns : True to use BuilderRecorder
+static bool useBuilderRecorder(ArrayRef<const PipelineShaderInfo *> shaderInfo, bool unlinked) {
+  if (UseBuilderRecorder.getNumOccurrences() > 0)
+    return UseBuilderRecorder;
+  if (unlinked || EnableOuts() || cl::ParallelStageTranslation || cl::EnableTranslatedIrCache)
+    return true;
+  for (const PipelineShaderInfo *shaderInfoEntry : shaderInfo) {
+    if (!shaderInfoEntry || !shaderInfoEntry->pModuleData)
+      continue;
+    auto moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfoEntry->pModuleData);
+    if (moduleData->binType != BinaryType::Spirv)
+      return true;
+  }
+  return false;
 }
 
 // =====================================================================================================================
@@ -259,27 +561,321 @@ static void updateCache(CacheAccessor &cacheAccessor, StringRef elfData) {
 }
 
 // =====================================================================================================================
-// Sets all of the glue shaders in elfLinker by getting the binary from the cache or compiling it.
+// Sets all of the glue shaders in elfLinker by getting the binary from the cache or compiling it. With
+// -parallel-glue-shader-compile, the glue shaders that miss in the caches are compiled concurrently, each in a context
+// of its own from the context pool, so that the link waits for the slowest one rather than for all of them in turn.
 //
 // @param elfLinker : The linker object for which the glue shaders are needed.
 // @param context : The context that contains the application caches.
-// @param compiler : The compiler object that contains the internal caches.
-static void setGlueBinaryBlobsInLinker(ElfLinker *elfLinker, Context *context, Compiler *compiler) {
+void Compiler::setGlueBinaryBlobsInLinker(ElfLinker *elfLinker, Context *context) {
   ArrayRef<StringRef> glueShaderIdentifiers = elfLinker->getGlueInfo();
+  GlueShaderCache &glueShaderCache = getGlueShaderCache();
+
+  // Take the glue shaders that the compiler has in memory, and request the entries for all of the others at once.
+  SmallVector<MetroHash::Hash, 4> glueShaderCacheHashes;
+  SmallVector<unsigned, 4> glueIndicesToLookUp;
   for (unsigned i = 0; i < glueShaderIdentifiers.size(); ++i) {
     LLPC_OUTS("ID for glue shader" << i << ": " << llvm::toHex(glueShaderIdentifiers[i]) << "\n");
-    CacheAccessor cacheAccessor = checkCacheForGlueShader(glueShaderIdentifiers[i], context, compiler);
+    MetroHash::Hash glueShaderCacheHash = getCacheHashForGlueShader(glueShaderIdentifiers[i]);
+    std::string elf;
+    const auto lookUpStart = CacheStatsCollector::Clock::now();
+    const bool inMemory = glueShaderCache.lookUp(glueShaderCacheHash, &elf);
+    CacheStatsCollector::get().recordLookup(CacheLayerGlueShaderMemory, inMemory, elf.size(),
+                                            CacheStatsCollector::Clock::now() - lookUpStart);
+    if (inMemory) {
+      LLPC_OUTS("In-memory cache hit for glue shader " << i << "\n");
+      elfLinker->addGlue(i, elf);
+      continue;
+    }
+    glueShaderCacheHashes.push_back(glueShaderCacheHash);
+    glueIndicesToLookUp.push_back(i);
+  }
+  std::vector<CacheAccessor> cacheAccessors =
+      CacheAccessor::lookUpAll(context, glueShaderCacheHashes, getInternalCaches());
+
+  SmallVector<unsigned, 4> missIndices;
+  for (unsigned j = 0; j < glueIndicesToLookUp.size(); ++j) {
+    unsigned i = glueIndicesToLookUp[j];
+    CacheAccessor &cacheAccessor = cacheAccessors[j];
 
     if (cacheAccessor.isInCache()) {
       LLPC_OUTS("Cache hit for glue shader " << i << "\n");
       setGlueBinaryBlobFromCacheData(elfLinker, i, cacheAccessor);
+      BinaryData elf = cacheAccessor.getElfFromCache();
+      glueShaderCache.insert(glueShaderCacheHashes[j],
+                             StringRef(reinterpret_cast<const char *>(elf.pCode), elf.codeSize));
     } else {
       LLPC_OUTS("Cache miss for glue shader " << i << "\n");
-      StringRef elfData = elfLinker->compileGlue(i);
-      LLPC_OUTS("Updating the cache for glue shader " << i << "\n");
-      updateCache(cacheAccessor, elfData);
+      missIndices.push_back(j);
+    }
+  }
+
+  // Compile the glue shaders that missed. They are only compiled in separate contexts when there is more than one, and
+  // not when dumping, as the dump output of concurrent compiles would be interleaved.
+  bool compileConcurrently = cl::ParallelGlueShaderCompile && missIndices.size() > 1 && !EnableOuts();
+  SmallVector<StringRef, 4> compiledElfs(glueIndicesToLookUp.size());
+  cantFail(parallelFor(compileConcurrently ? 0 : 1, missIndices, [&](unsigned j) -> Error {
+    unsigned i = glueIndicesToLookUp[j];
+    if (!compileConcurrently) {
+      compiledElfs[j] = elfLinker->compileGlue(i);
+      return Error::success();
+    }
+    Context *glueContext = acquireContext();
+    compiledElfs[j] = elfLinker->compileGlue(i, glueContext->getLgcContext());
+    releaseContext(glueContext);
+    return Error::success();
+  }));
+
+  for (unsigned j : missIndices) {
+    StringRef elfData = compiledElfs[j];
+    LLPC_OUTS("Updating the cache for glue shader " << glueIndicesToLookUp[j] << "\n");
+    updateCache(cacheAccessors[j], elfData);
+    // An empty ELF indicates a recoverable error, which is not to be remembered.
+    if (!elfData.empty())
+      glueShaderCache.insert(glueShaderCacheHashes[j], elfData);
+  }
+}
+
+// =====================================================================================================================
+// Gets the ELF of the glue shader with the given hash, making it the most recently used one.
+//
+// @param hash : The cache hash of the glue shader
+// @param [out] elf : The ELF of the glue shader, if found
+// @returns : True if the glue shader was found
+bool GlueShaderCache::lookUp(const MetroHash::Hash &hash, std::string *elf) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it == m_entries.end())
+    return false;
+  m_entries.splice(m_entries.begin(), m_entries, it);
+  *elf = it->elf;
+  return true;
+}
+
+// =====================================================================================================================
+// Adds the ELF of the glue shader with the given hash, evicting the least recently used one if the cache is full.
+//
+// @param hash : The cache hash of the glue shader
+// @param elf : The ELF of the glue shader
+void GlueShaderCache::insert(const MetroHash::Hash &hash, StringRef elf) {
+  if (cl::GlueShaderCacheSize == 0)
+    return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it != m_entries.end()) {
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return;
+  }
+  m_entries.push_front({hash, elf.str()});
+  while (m_entries.size() > cl::GlueShaderCacheSize)
+    m_entries.pop_back();
+}
+
+// =====================================================================================================================
+// Takes the non-fragment half with the given hash out of the cache, if it is there.
+//
+// @param hash : The cache hash of the non-fragment stages
+std::unique_ptr<NonFragmentElf> NonFragmentElfCache::take(const MetroHash::Hash &hash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it == m_entries.end())
+    return nullptr;
+  std::unique_ptr<NonFragmentElf> elf = std::move(it->elf);
+  m_entries.erase(it);
+  return elf;
+}
+
+// =====================================================================================================================
+// Puts the non-fragment half with the given hash in the cache as the most recently used one, evicting the least
+// recently used one if the cache is full. If another build has already put one with the same hash back, that one is
+// kept instead.
+//
+// @param hash : The cache hash of the non-fragment stages
+// @param elf : The non-fragment half
+void NonFragmentElfCache::insert(const MetroHash::Hash &hash, std::unique_ptr<NonFragmentElf> elf) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it != m_entries.end()) {
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return;
+  }
+  m_entries.push_front({hash, std::move(elf)});
+  while (m_entries.size() > cl::NonFragmentElfCacheSize)
+    m_entries.pop_back();
+}
+
+// =====================================================================================================================
+// Gets the ELF of the compute library with the given hash, making it the most recently used one.
+//
+// @param hash : The cache hash of the compute library
+// @returns : The relocatable ELF of the compute library, or nullptr if it is not in the cache
+std::shared_ptr<const ElfPackage> ComputeLibraryCache::lookUp(const MetroHash::Hash &hash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it == m_entries.end())
+    return nullptr;
+  m_entries.splice(m_entries.begin(), m_entries, it);
+  return it->elf;
+}
+
+// =====================================================================================================================
+// Adds the ELF of the compute library with the given hash, evicting the least recently used one if the cache is full.
+//
+// @param hash : The cache hash of the compute library
+// @param elf : The relocatable ELF of the compute library
+void ComputeLibraryCache::insert(const MetroHash::Hash &hash, std::shared_ptr<const ElfPackage> elf) {
+  if (cl::ComputeLibraryCacheSize == 0)
+    return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it != m_entries.end()) {
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return;
+  }
+  m_entries.push_front({hash, std::move(elf)});
+  while (m_entries.size() > cl::ComputeLibraryCacheSize)
+    m_entries.pop_back();
+}
+
+// =====================================================================================================================
+// Gets the result of the failed build of the pipeline with the given hash, if it has not expired.
+//
+// @param hash : The cache hash of the pipeline
+// @param [out] result : The result of the failed build, if found
+// @returns : True if a failed build of the pipeline was found
+bool NegativeResultCache::lookUp(const MetroHash::Hash &hash, Result *result) {
+  if (cl::NegativeCacheTtl == 0)
+    return false;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = find_if(m_entries, [&hash](const Entry &entry) { return entry.hash == hash; });
+  if (it == m_entries.end())
+    return false;
+  if (std::chrono::steady_clock::now() >= it->expiry) {
+    m_entries.erase(it);
+    return false;
+  }
+  *result = it->result;
+  return true;
+}
+
+// =====================================================================================================================
+// Remembers the result of a failed build of the pipeline with the given hash, if it is one that would be repeated by
+// building it again. Entries that have expired are dropped.
+//
+// @param hash : The cache hash of the pipeline
+// @param result : The result of the failed build
+void NegativeResultCache::insert(const MetroHash::Hash &hash, Result result) {
+  // The number of failed pipelines remembered, which bounds the cost of a look up.
+  constexpr size_t MaxEntries = 256;
+
+  if (cl::NegativeCacheTtl == 0 || (result != Result::ErrorInvalidShader && result != Result::Unsupported))
+    return;
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.remove_if([&](const Entry &entry) { return entry.hash == hash || now >= entry.expiry; });
+  m_entries.push_front({hash, result, now + std::chrono::milliseconds(cl::NegativeCacheTtl)});
+  while (m_entries.size() > MaxEntries)
+    m_entries.pop_back();
+}
+
+// =====================================================================================================================
+// Joins the build of the pipeline with the given hash. If no build of it is in progress, a new one is started, which
+// the caller must build and then complete.
+//
+// @param hash : The cache hash of the pipeline
+// @param [out] isOwner : Whether a new build was started, which the caller owns
+// @returns : The build that was joined or started
+std::shared_ptr<InFlightBuildTable::Build> InFlightBuildTable::join(const MetroHash::Hash &hash, bool *isOwner) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (cl::DedupInFlightPipelines) {
+    auto it = find_if(m_builds, [&hash](const std::shared_ptr<Build> &build) { return build->hash == hash; });
+    if (it != m_builds.end()) {
+      *isOwner = false;
+      return *it;
+    }
+  }
+  auto build = std::make_shared<Build>();
+  build->hash = hash;
+  m_builds.push_back(build);
+  *isOwner = true;
+  return build;
+}
+
+// =====================================================================================================================
+// Completes a build started by join: removes it from the table, so that later requests look in the caches instead, and
+// wakes the threads that wait for it.
+//
+// @param build : The build
+// @param result : Result of the build
+// @param elf : The pipeline ELF, if the build succeeded
+void InFlightBuildTable::complete(Build &build, Result result, const ElfPackage &elf) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_builds.remove_if([&build](const std::shared_ptr<Build> &entry) { return &*entry == &build; });
+  }
+  {
+    std::lock_guard<std::mutex> lock(build.mutex);
+    build.result = result;
+    if (result == Result::Success)
+      build.elf = elf;
+    build.complete = true;
+  }
+  build.doneCondition.notify_all();
+}
+
+// =====================================================================================================================
+// Waits for a build that another thread started, and gets its result and ELF. A build that was cancelled is not used,
+// as the waiting thread's own build was not.
+//
+// @param build : The build
+// @param [out] result : Result of the build
+// @param [out] elf : The pipeline ELF, if the build succeeded
+// @returns : False if the build was cancelled, in which case the caller has to build the pipeline itself
+bool InFlightBuildTable::wait(Build &build, Result *result, ElfPackage *elf) {
+  std::unique_lock<std::mutex> lock(build.mutex);
+  build.doneCondition.wait(lock, [&build] { return build.complete; });
+  if (build.result == Result::ErrorUnavailable)
+    return false;
+  *result = build.result;
+  if (build.result == Result::Success)
+    *elf = build.elf;
+  return true;
+}
+
+// Maximum number of buffers kept in an ElfPackagePool
+static constexpr size_t MaxPooledElfPackages = 16;
+// Maximum capacity of a buffer kept in an ElfPackagePool, so that the pool does not hold on to the memory of an
+// unusually large pipeline
+static constexpr size_t MaxPooledElfPackageCapacity = 16 << 20;
+
+// =====================================================================================================================
+// Takes an empty buffer out of the pool, or creates one if the pool is empty.
+//
+// @returns : The buffer
+std::unique_ptr<ElfPackage> ElfPackagePool::take() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_elfs.empty()) {
+      std::unique_ptr<ElfPackage> elf = std::move(m_elfs.back());
+      m_elfs.pop_back();
+      return elf;
     }
   }
+  return std::make_unique<ElfPackage>();
+}
+
+// =====================================================================================================================
+// Gives a buffer back to the pool, unless the pool is full or the buffer is too large to keep. The buffer is cleared,
+// keeping its capacity.
+//
+// @param elf : The buffer
+void ElfPackagePool::give(std::unique_ptr<ElfPackage> elf) {
+  if (!elf || elf->capacity() > MaxPooledElfPackageCapacity)
+    return;
+  elf->clear();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_elfs.size() < MaxPooledElfPackages)
+    m_elfs.push_back(std::move(elf));
 }
 
 // =====================================================================================================================
@@ -326,6 +922,26 @@ private:
   bool *m_hasError;
 };
 
+// =====================================================================================================================
+// Checks whether any of the compilation options refers to LLVM passes by name, which needs all the passes to be
+// registered before the options are parsed.
+//
+// @param optionCount : Count of compilation-option strings
+// @param options : An array of compilation-option strings
+static bool hasPassNameOption(unsigned optionCount, const char *const *options) {
+  static const char *const PassNameOptions[] = {"print-after", "print-before", "stop-after",       "stop-before",
+                                                "start-after", "start-before", "lgc-pass-pipeline"};
+  // The first option is the client name.
+  for (unsigned i = 1; i < optionCount; ++i) {
+    StringRef option = StringRef(options[i]).ltrim('-');
+    for (const char *passNameOption : PassNameOptions) {
+      if (option.startswith(passNameOption))
+        return true;
+    }
+  }
+  return false;
+}
+
 // =====================================================================================================================
 // Creates LLPC compiler from the specified info.
 //
@@ -346,9 +962,10 @@ Result VKAPI_CALL ICompiler::Create(GfxIpVersion gfxIp, unsigned optionCount, co
   std::lock_guard<sys::Mutex> lock(*SCompilerMutex);
   MetroHash::Hash optionHash = Compiler::generateHashForCompileOptions(optionCount, options);
 
-  // Initialize passes so they can be referenced by -print-after etc.
+  // Initialize passes so they can be referenced by -print-after etc. Unless an option does that, the middle-end is
+  // initialized lazily, as that takes less time.
   initializeLowerPasses(*PassRegistry::getPassRegistry());
-  LgcContext::initialize();
+  LgcContext::initialize(/*lazy=*/!hasPassNameOption(optionCount, options));
 
   bool parseCmdOption = true;
   if (HaveParsedOptions) {
@@ -433,6 +1050,8 @@ Compiler::Compiler(GfxIpVersion gfxIp, unsigned optionCount, const char *const *
 
   // Initialize shader cache
   ShaderCacheCreateInfo createInfo = {};
+  createInfo.maxMemorySize = static_cast<size_t>(cl::ShaderCacheMaxMemorySize) << 20;
+  createInfo.maxFileSize = static_cast<size_t>(cl::ShaderCacheMaxFileSize) << 20;
   ShaderCacheAuxCreateInfo auxCreateInfo = {};
   unsigned shaderCacheMode = cl::ShaderCacheMode;
   auxCreateInfo.shaderCacheMode = static_cast<ShaderCacheMode>(shaderCacheMode);
@@ -464,6 +1083,12 @@ Compiler::Compiler(GfxIpVersion gfxIp, unsigned optionCount, const char *const *
 
 // =====================================================================================================================
 Compiler::~Compiler() {
+  // Wait for the asynchronous pipeline builds that are still queued or running.
+  {
+    std::unique_lock<std::mutex> lock(m_asyncBuildMutex);
+    m_asyncBuildDone.wait(lock, [this] { return m_asyncBuildCount == 0; });
+  }
+
   bool shutdown = false;
   {
     // Free context pool
@@ -509,6 +1134,7 @@ Compiler::~Compiler() {
   }
 
   if (shutdown) {
+    TimerProfiler::writeTimeTrace();
     ShaderCacheManager::shutdown();
     remove_fatal_error_handler();
     delete m_contextPool;
@@ -535,10 +1161,12 @@ Result Compiler::BuildShaderModule(const ShaderModuleBuildInfo *shaderInfo, Shad
   ShaderModuleDataEx moduleDataEx = {};
   // For trimming debug info
   uint8_t *trimmedCode = nullptr;
+  // SPIR-V binary kept in the module data before trimming, which is the optimized one if the module is optimized
+  const BinaryData *spirvBin = &shaderInfo->shaderBin;
+  BinaryData optimizedSpirvBin = {};
 
   ElfPackage moduleBinary;
   raw_svector_ostream moduleBinaryStream(moduleBinary);
-  std::vector<ShaderEntryName> entryNames;
   SmallVector<ShaderModuleEntryData, 4> moduleEntryDatas;
   SmallVector<ShaderModuleEntry, 4> moduleEntries;
   SmallVector<FsOutInfo, 4> fsOutInfos;
@@ -565,20 +1193,32 @@ Result Compiler::BuildShaderModule(const ShaderModuleBuildInfo *shaderInfo, Shad
 
   // Check the type of input shader binary
   if (Vkgc::isSpirvBinary(&shaderInfo->shaderBin)) {
-    unsigned debugInfoSize = 0;
+    SpirvModuleSummary &summary = moduleDataEx.spirvSummary;
 
     moduleDataEx.common.binType = BinaryType::Spirv;
-    if (ShaderModuleHelper::verifySpirvBinary(&shaderInfo->shaderBin) != Result::Success) {
-      LLPC_ERRS("Unsupported SPIR-V instructions are found!\n");
-      result = Result::Unsupported;
-    }
-    if (result == Result::Success) {
-      result = ShaderModuleHelper::collectInfoFromSpirvBinary(&shaderInfo->shaderBin, &moduleDataEx.common.usage,
-                                                              entryNames, &debugInfoSize);
+    result = ShaderModuleHelper::collectInfoFromSpirvBinary(&shaderInfo->shaderBin, trimDebugInfo,
+                                                            &moduleDataEx.common.usage, &summary);
+    // Optimize the binary once here, so that every pipeline using the module translates the smaller binary. The info
+    // is collected again from the optimized binary; if that fails, the original binary is kept.
+    if (result == Result::Success && cl::OptimizeModuleSpirv &&
+        ShaderModuleHelper::optimizeModuleSpirv(spirvBin, &optimizedSpirvBin) == Result::Success) {
+      ShaderModuleUsage optimizedUsage = {};
+      SpirvModuleSummary optimizedSummary = {};
+      if (ShaderModuleHelper::collectInfoFromSpirvBinary(&optimizedSpirvBin, trimDebugInfo, &optimizedUsage,
+                                                         &optimizedSummary) == Result::Success) {
+        moduleDataEx.common.usage = optimizedUsage;
+        summary = optimizedSummary;
+        spirvBin = &optimizedSpirvBin;
+      } else
+        ShaderModuleHelper::cleanOptimizedSpirv(&optimizedSpirvBin);
     }
-    moduleDataEx.common.binCode.codeSize = shaderInfo->shaderBin.codeSize;
+    // Only the separate translation for the translated IR cache can use specialization constant placeholders
+    summary.specConstPlaceholders = result == Result::Success && moduleDataEx.common.usage.useSpecConstant &&
+                                    cl::EnableTranslatedIrCache && cl::SpecConstantPlaceholders &&
+                                    ShaderModuleHelper::canUseSpecConstantPlaceholders(spirvBin);
+    moduleDataEx.common.binCode.codeSize = spirvBin->codeSize;
     if (trimDebugInfo)
-      moduleDataEx.common.binCode.codeSize -= debugInfoSize;
+      moduleDataEx.common.binCode.codeSize -= summary.debugInfoSize;
   } else if (ShaderModuleHelper::isLlvmBitcode(&shaderInfo->shaderBin)) {
     moduleDataEx.common.binType = BinaryType::LlvmBc;
     moduleDataEx.common.binCode = shaderInfo->shaderBin;
@@ -594,10 +1234,10 @@ Result Compiler::BuildShaderModule(const ShaderModuleBuildInfo *shaderInfo, Shad
     // Trim debug info
     if (trimDebugInfo) {
       trimmedCode = new uint8_t[moduleDataEx.common.binCode.codeSize];
-      ShaderModuleHelper::trimSpirvDebugInfo(&shaderInfo->shaderBin, moduleDataEx.common.binCode.codeSize, trimmedCode);
+      ShaderModuleHelper::trimSpirvDebugInfo(spirvBin, moduleDataEx.common.binCode.codeSize, trimmedCode);
       moduleDataEx.common.binCode.pCode = trimmedCode;
     } else {
-      moduleDataEx.common.binCode.pCode = shaderInfo->shaderBin.pCode;
+      moduleDataEx.common.binCode.pCode = spirvBin->pCode;
     }
 
     // Calculate SPIR-V cache hash
@@ -708,12 +1348,111 @@ Result Compiler::BuildShaderModule(const ShaderModuleBuildInfo *shaderInfo, Shad
     moduleDataExCopy->common.binCode.pCode = code;
     moduleDataExCopy->extra.pFsOutInfos = fsOutInfo;
     shaderOut->pModuleData = &moduleDataExCopy->common;
+    if (cl::PreLowerShaderModules && cl::EnableTranslatedIrCache)
+      submitShaderModulePreLowering(moduleDataExCopy);
   } else {
     if (hEntry)
       m_shaderCache->resetShader(hEntry);
   }
   delete[] allocData;
+  ShaderModuleHelper::cleanOptimizedSpirv(&optimizedSpirvBin);
+
+  return result;
+}
+
+// =====================================================================================================================
+// Submits background jobs that translate and lower each entry-point of a SPIR-V shader module into the translated-IR
+// cache, so that the first pipeline using an entry-point finds its translated IR in the cache. The translated IR is
+// only found by pipelines that use the same pipeline and shader options as the jobs, which are the default ones.
+//
+// @param moduleDataEx : Module data of the shader module, as returned to the client
+void Compiler::submitShaderModulePreLowering(const ShaderModuleDataEx *moduleDataEx) {
+  const SpirvModuleSummary &summary = moduleDataEx->spirvSummary;
+  if (moduleDataEx->common.binType != BinaryType::Spirv || summary.idBound == 0 || summary.isLibrary ||
+      summary.entryPointCount > MaxSpirvSummaryEntryPoints)
+    return;
+
+  // The client may destroy the shader module before the jobs run, so they share a copy of the module data. The
+  // translation does not read the entries or the fragment outputs of the module data, so those are left out.
+  size_t codeSize = moduleDataEx->common.binCode.codeSize;
+  auto moduleDataCopy = std::make_shared<std::vector<uint8_t>>(sizeof(ShaderModuleDataEx) + codeSize);
+  auto moduleDataExCopy = reinterpret_cast<ShaderModuleDataEx *>(moduleDataCopy->data());
+  memcpy(moduleDataExCopy, moduleDataEx, sizeof(ShaderModuleDataEx));
+  void *code = voidPtrInc(moduleDataExCopy, sizeof(ShaderModuleDataEx));
+  memcpy(code, moduleDataEx->common.binCode.pCode, codeSize);
+  moduleDataExCopy->common.binCode.pCode = code;
+  moduleDataExCopy->extra.fsOutInfoCount = 0;
+  moduleDataExCopy->extra.pFsOutInfos = nullptr;
+  moduleDataExCopy->extra.entryCount = 0;
+
+  uint64_t key = MetroHash::compact64(reinterpret_cast<const MetroHash::Hash *>(moduleDataEx->common.cacheHash));
+  for (unsigned i = 0; i < summary.entryPointCount; ++i) {
+    ShaderStage stage = summary.entryPoints[i].stage;
+    if (stage >= ShaderStageNativeStageCount)
+      continue;
+    auto entryName = static_cast<const char *>(voidPtrInc(code, summary.entryPoints[i].nameOffset));
+    auto preLower = [this, moduleDataCopy, stage, entryName] {
+      preLowerShaderStage(reinterpret_cast<const ShaderModuleData *>(moduleDataCopy->data()), stage, entryName);
+    };
+    submitBackgroundTask(preLower, PipelineBuildPriority::Background, key);
+  }
+}
+
+// =====================================================================================================================
+// Translates and lowers one entry-point of a shader module into the translated-IR cache, in the same way as a pipeline
+// with default pipeline and shader options that uses the entry-point for the stage.
+//
+// @param moduleData : Module data of the shader module
+// @param stage : Shader stage of the entry-point
+// @param entryName : Name of the entry-point
+Result Compiler::preLowerShaderStage(const ShaderModuleData *moduleData, ShaderStage stage, const char *entryName) {
+  GraphicsPipelineBuildInfo graphicsInfo = {};
+  ComputePipelineBuildInfo computeInfo = {};
+  PipelineShaderInfo *gfxShaderInfos[] = {&graphicsInfo.vs, &graphicsInfo.tcs, &graphicsInfo.tes, &graphicsInfo.gs,
+                                          &graphicsInfo.fs};
+  PipelineShaderInfo *stageInfo = stage == ShaderStageCompute ? &computeInfo.cs : gfxShaderInfos[stage];
+  stageInfo->pModuleData = moduleData;
+  stageInfo->pEntryTarget = entryName;
+  stageInfo->entryStage = stage;
+
+  // Shader info of the pipeline, in the same layout as the pipeline builds use, so each stage has the same index.
+  std::vector<const PipelineShaderInfo *> shaderInfo(
+      stage == ShaderStageCompute ? ShaderStageNativeStageCount : ShaderStageGfxCount, nullptr);
+  shaderInfo[stage] = stageInfo;
+
+  MetroHash::Hash cacheHash = {};
+  MetroHash::Hash pipelineHash = {};
+  std::unique_ptr<PipelineContext> pipelineContext;
+  if (stage == ShaderStageCompute) {
+    cacheHash = PipelineDumper::generateHashForComputePipeline(&computeInfo, true, false);
+    pipelineHash = PipelineDumper::generateHashForComputePipeline(&computeInfo, false, false);
+    pipelineContext = std::make_unique<ComputeContext>(m_gfxIp, &computeInfo, &pipelineHash, &cacheHash);
+  } else {
+    cacheHash = PipelineDumper::generateHashForGraphicsPipeline(&graphicsInfo, true, false, UnlinkedStageCount);
+    pipelineHash = PipelineDumper::generateHashForGraphicsPipeline(&graphicsInfo, false, false, UnlinkedStageCount);
+    pipelineContext = std::make_unique<GraphicsContext>(m_gfxIp, &graphicsInfo, &pipelineHash, &cacheHash);
+  }
+
+  Context *context = acquireContext();
+  context->attachPipelineContext(&*pipelineContext);
+  bool hasError = false;
+  context->setDiagnosticHandler(std::make_unique<LlpcDiagnosticHandler>(&hasError));
+  context->setScalarBlockLayout(pipelineContext->getPipelineOptions()->scalarBlockLayout);
+  context->setRobustBufferAccess(pipelineContext->getPipelineOptions()->robustBufferAccess);
+
+  std::vector<Module *> modules(shaderInfo.size(), nullptr);
+  modules[stage] =
+      new Module((Twine("llpc") + getShaderStageName(stage)).str() + std::to_string(getModuleIdByIndex(stage)),
+                 *context);
+  context->setModuleTargetMachine(modules[stage]);
 
+  unsigned stageSkipMask = 0;
+  LLPC_OUTS("Pre-lowering " << getShaderStageName(stage) << " shader entry-point " << entryName << "\n");
+  Result result = translateAndLowerStagesSeparately(context, shaderInfo, modules, &stageSkipMask, &hasError);
+
+  delete modules[stage];
+  context->setDiagnosticHandler(nullptr);
+  releaseContext(context);
   return result;
 }
 
@@ -738,9 +1477,11 @@ template <typename T> static FormattedBytes formatBytesLittleEndian(ArrayRef<T>
 // @param [out] stageCacheAccesses : Stage cache access result. All elements
 //                                   must be initialized in the caller as
 //                                   CacheAccessInfo::CacheNotChecked
+// @param glueShadersOnly : Only get the glue shaders needed by the link into the caches, without linking
 Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<const PipelineShaderInfo *> shaderInfo,
                                                  ElfPackage *pipelineElf,
-                                                 MutableArrayRef<CacheAccessInfo> stageCacheAccesses) {
+                                                 MutableArrayRef<CacheAccessInfo> stageCacheAccesses,
+                                                 bool glueShadersOnly) {
   LLPC_OUTS("Building pipeline with relocatable shader elf.\n");
   Result result = Result::Success;
 
@@ -748,7 +1489,9 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
   bool isUnlinkedPipeline = context->getPipelineContext()->isUnlinked();
   context->getPipelineContext()->setUnlinked(true);
 
+  // The relocatable ELF of each stage: a view of the cache entry on a cache hit, otherwise of the ELF built into elf.
   ElfPackage elf[enumCount<UnlinkedShaderStage>()];
+  StringRef stageElfs[enumCount<UnlinkedShaderStage>()];
   assert(stageCacheAccesses.size() >= shaderInfo.size());
 
   const MetroHash::Hash originalCacheHash = context->getPipelineContext()->getCacheHashCodeWithoutCompact();
@@ -756,16 +1499,12 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
   LLPC_OUTS("LLPC version: " << VersionTuple(LLPC_INTERFACE_MAJOR_VERSION, LLPC_INTERFACE_MINOR_VERSION) << "\n");
   LLPC_OUTS("Hash for pipeline cache lookup: " << formatBytesLittleEndian<uint8_t>(originalCacheHash.bytes) << "\n");
 
+  // Request the cache entries for all of the relocatable shaders at once.
+  SmallVector<UnlinkedShaderStage, UnlinkedStageCount> unlinkedStages;
+  SmallVector<MetroHash::Hash, UnlinkedStageCount> stageCacheHashes;
   for (UnlinkedShaderStage stage : lgc::enumRange<UnlinkedShaderStage>()) {
     if (!hasDataForUnlinkedShaderType(stage, shaderInfo))
       continue;
-
-    unsigned shaderStageMask = getShaderStageMaskForType(stage) & originalShaderStageMask;
-    context->getPipelineContext()->setShaderStageMask(shaderStageMask);
-    const auto shaderStages = maskToShaderStages(shaderStageMask);
-    assert(all_of(shaderStages, isNativeStage) && "Unexpected stage kind");
-
-    // Check the cache for the relocatable shader for this stage .
     MetroHash::Hash cacheHash = {};
     if (context->isGraphics()) {
       auto pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(context->getPipelineBuildInfo());
@@ -774,19 +1513,32 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
       auto pipelineInfo = reinterpret_cast<const ComputePipelineBuildInfo *>(context->getPipelineBuildInfo());
       cacheHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, true, true);
     }
+    unlinkedStages.push_back(stage);
+    stageCacheHashes.push_back(cacheHash);
+  }
+  std::vector<CacheAccessor> stageCacheAccessors =
+      CacheAccessor::lookUpAll(context, stageCacheHashes, getInternalCaches());
+
+  for (unsigned stageIndex = 0; stageIndex < unlinkedStages.size(); ++stageIndex) {
+    UnlinkedShaderStage stage = unlinkedStages[stageIndex];
+    unsigned shaderStageMask = getShaderStageMaskForType(stage) & originalShaderStageMask;
+    context->getPipelineContext()->setShaderStageMask(shaderStageMask);
+    const auto shaderStages = maskToShaderStages(shaderStageMask);
+    assert(all_of(shaderStages, isNativeStage) && "Unexpected stage kind");
+
+    // Check the cache for the relocatable shader for this stage .
     // Note that this code updates m_pipelineHash of the pipeline context. It
     // must be restored before we link the pipeline ELF at the end of this for-loop.
-    context->getPipelineContext()->setHashForCacheLookUp(cacheHash);
+    context->getPipelineContext()->setHashForCacheLookUp(stageCacheHashes[stageIndex]);
     LLPC_OUTS("Finalized hash for " << getUnlinkedShaderStageName(stage) << " stage cache lookup: "
                                     << format_hex(context->getPipelineContext()->get128BitCacheHashCode()[0], 18) << ' '
                                     << format_hex(context->getPipelineContext()->get128BitCacheHashCode()[1], 18)
                                     << '\n');
 
-    CacheAccessor cacheAccessor(context, cacheHash, getInternalCaches());
+    CacheAccessor &cacheAccessor = stageCacheAccessors[stageIndex];
     if (cacheAccessor.isInCache()) {
       BinaryData elfBin = cacheAccessor.getElfFromCache();
-      auto data = reinterpret_cast<const char *>(elfBin.pCode);
-      elf[stage].assign(data, data + elfBin.codeSize);
+      stageElfs[stage] = StringRef(reinterpret_cast<const char *>(elfBin.pCode), elfBin.codeSize);
       LLPC_OUTS("Cache hit for shader stage " << getUnlinkedShaderStageName(stage) << "\n");
       for (ShaderStage stage : shaderStages)
         stageCacheAccesses[stage] =
@@ -810,6 +1562,7 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
     result = buildPipelineInternal(context, singleStageShaderInfo, /*unlinked=*/true, &stageElf, stageCacheAccesses);
     if (result != Result::Success)
       break;
+    stageElfs[stage] = stageElf.str();
 
     // Add the result to the cache.
     BinaryData elfBin = {stageElf.size(), stageElf.data()};
@@ -826,7 +1579,7 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
       bool hasError = false;
       context->setDiagnosticHandler(std::make_unique<LlpcDiagnosticHandler>(&hasError));
 
-      hasError |= !linkRelocatableShaderElf(elf, pipelineElf, context);
+      hasError |= !linkRelocatableShaderElf(stageElfs, pipelineElf, context, glueShadersOnly);
       context->setDiagnosticHandler(nullptr);
 
       if (hasError)
@@ -834,10 +1587,10 @@ Result Compiler::buildPipelineWithRelocatableElf(Context *context, ArrayRef<cons
     } else {
       // Return the first relocatable shader, since we can only return one anyway.
       for (auto unlinkedStage : enumRange<UnlinkedShaderStage>()) {
-        auto &unlinkedStageElf = elf[unlinkedStage];
+        StringRef unlinkedStageElf = stageElfs[unlinkedStage];
         if (unlinkedStageElf.empty())
           continue;
-        *pipelineElf = unlinkedStageElf;
+        pipelineElf->assign(unlinkedStageElf.begin(), unlinkedStageElf.end());
         break;
       }
     }
@@ -869,12 +1622,9 @@ static bool isUnrelocatableResourceMappingRootNode(const ResourceMappingNode *no
     }
     break;
   }
-  case ResourceMappingNodeType::DescriptorResource:
-  case ResourceMappingNodeType::DescriptorSampler:
-  case ResourceMappingNodeType::DescriptorCombinedTexture:
-  case ResourceMappingNodeType::DescriptorTexelBuffer:
   case ResourceMappingNodeType::DescriptorBufferCompact:
-    // Generic descriptors in the top level are not handled by the linker.
+    // A compact descriptor in the top level is expanded by code that cannot be easily patched. Other descriptors in
+    // the top level are loaded from the spill table, selected by a relocation.
     return true;
 #if (LLPC_CLIENT_INTERFACE_MAJOR_VERSION >= 50)
   case ResourceMappingNodeType::InlineBuffer:
@@ -902,8 +1652,19 @@ static bool hasUnrelocatableDescriptorNode(const ResourceMappingData *resourceMa
   }
 
   for (unsigned i = 0; i < resourceMapping->userDataNodeCount; ++i) {
-    if (isUnrelocatableResourceMappingRootNode(&resourceMapping->pUserDataNodes[i].node))
+    const ResourceMappingNode *node = &resourceMapping->pUserDataNodes[i].node;
+    if (isUnrelocatableResourceMappingRootNode(node))
       return true;
+
+    // An immutable sampler in the top level is not in the user data, as a pipeline compile takes its value from the
+    // static descriptor values.
+    if (node->type == ResourceMappingNodeType::DescriptorSampler ||
+        node->type == ResourceMappingNodeType::DescriptorCombinedTexture) {
+      for (const auto &range : descriptorRangeValues) {
+        if (range.set == node->srdRange.set && range.binding == node->srdRange.binding)
+          return true;
+      }
+    }
   }
 
   // If there is no 1-to-1 mapping between descriptor sets and descriptor tables, then relocatable shaders will fail.
@@ -921,21 +1682,84 @@ static bool hasUnrelocatableDescriptorNode(const ResourceMappingData *resourceMa
 }
 
 // =====================================================================================================================
-// Returns true if a graphics pipeline can be built out of the given shader infos.
+// Fills in the size counts of a pipeline cost estimate from the summaries of the shader modules of the given stages,
+// and returns the compile time that the uncalibrated cost model gives for them. The model is linear in the counts. Its
+// coefficients are only a starting point for the relative costs; calibrateCompileTime scales the result by the compile
+// times of the pipelines that have been built, measured over the same span as the pipeline timer of TimerProfiler. For
+// a module without a summary, the instruction count is approximated from its binary size.
 //
-// @param shaderInfos : Shader infos for the pipeline to be built
-// @param pipelineInfo : Pipeline info for the pipeline to be built
-bool Compiler::canUseRelocatableGraphicsShaderElf(const ArrayRef<const PipelineShaderInfo *> &shaderInfos,
-                                                  const GraphicsPipelineBuildInfo *pipelineInfo) {
+// @param shaderInfo : Shader infos of the stages
+// @param relocatable : Whether the stages would be built as relocatable shader ELFs
+// @param [in/out] estimate : Cost estimate whose counts are filled in
+// @returns : Uncalibrated compile time, in milliseconds
+static double modelCompileTime(ArrayRef<const PipelineShaderInfo *> shaderInfo, bool relocatable,
+                               PipelineCostEstimate *estimate) {
+  // Fixed cost of a pipeline (context setup, pass managers, ELF output), and of each stage in it
+  constexpr double PipelineTime = 1.5;
+  constexpr double StageTime = 0.8;
+  // Costs of each SPIR-V instruction, function (mostly inlining) and loop (loop passes and unrolling)
+  constexpr double InstructionTime = 0.004;
+  constexpr double FunctionTime = 0.05;
+  constexpr double LoopTime = 0.25;
+  // Relocatable stages skip the whole-pipeline optimizations, but have to be linked
+  constexpr double RelocatableScale = 0.85;
+  constexpr double LinkTime = 0.3;
+  // Average size of a SPIR-V instruction, for a module without a summary
+  constexpr unsigned InstructionSize = 16;
+
+  estimate->relocatable = relocatable;
+  for (const PipelineShaderInfo *stageInfo : shaderInfo) {
+    if (!stageInfo || !stageInfo->pModuleData)
+      continue;
+    ++estimate->stageCount;
+    const ShaderModuleDataEx *moduleDataEx = reinterpret_cast<const ShaderModuleDataEx *>(stageInfo->pModuleData);
+    const SpirvModuleSummary &summary = moduleDataEx->spirvSummary;
+    if (summary.idBound != 0) {
+      estimate->instructionCount += summary.instructionCount;
+      estimate->functionCount += summary.functionCount;
+      estimate->loopCount += summary.loopCount;
+    } else {
+      estimate->instructionCount += moduleDataEx->common.binCode.codeSize / InstructionSize;
+      ++estimate->functionCount;
+    }
+  }
+
+  double compileTime = StageTime * estimate->stageCount + InstructionTime * estimate->instructionCount +
+                       FunctionTime * estimate->functionCount + LoopTime * estimate->loopCount;
+  if (relocatable)
+    compileTime = compileTime * RelocatableScale + LinkTime;
+  return PipelineTime + compileTime;
+}
+
+// =====================================================================================================================
+// Returns true if a pipeline with the given first shader stage and resource mapping can be built out of relocatable
+// shader ELFs, regardless of -relocatable-shader-elf-limit.
+//
+// @param shaderInfo : Shader info of the first shader stage of the pipeline, may be null
+// @param resourceMapping : Resource mapping of the pipeline
+static bool isRelocatableShaderElfSupported(const PipelineShaderInfo *shaderInfo,
+                                            const ResourceMappingData *resourceMapping) {
   // Check user data nodes for unsupported Descriptor types.
-  if (hasUnrelocatableDescriptorNode(&pipelineInfo->resourceMapping))
+  if (hasUnrelocatableDescriptorNode(resourceMapping))
     return false;
 
-  if (shaderInfos[0]) {
-    const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfos[0]->pModuleData);
+  if (shaderInfo) {
+    const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo->pModuleData);
     if (moduleData && moduleData->binType != BinaryType::Spirv)
       return false;
   }
+  return true;
+}
+
+// =====================================================================================================================
+// Returns true if a graphics pipeline can be built out of the given shader infos.
+//
+// @param shaderInfos : Shader infos for the pipeline to be built
+// @param pipelineInfo : Pipeline info for the pipeline to be built
+bool Compiler::canUseRelocatableGraphicsShaderElf(const ArrayRef<const PipelineShaderInfo *> &shaderInfos,
+                                                  const GraphicsPipelineBuildInfo *pipelineInfo) {
+  if (!isRelocatableShaderElfSupported(shaderInfos[0], &pipelineInfo->resourceMapping))
+    return false;
 
   if (cl::RelocatableShaderElfLimit != -1) {
     if (m_relocatablePipelineCompilations >= cl::RelocatableShaderElfLimit)
@@ -951,15 +1775,7 @@ bool Compiler::canUseRelocatableGraphicsShaderElf(const ArrayRef<const PipelineS
 //
 // @param shaderInfo : Shader info for the pipeline to be built
 bool Compiler::canUseRelocatableComputeShaderElf(const ComputePipelineBuildInfo *pipelineInfo) {
-  const PipelineShaderInfo *shaderInfo = &pipelineInfo->cs;
-  if (shaderInfo) {
-    const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo->pModuleData);
-    if (moduleData && moduleData->binType != BinaryType::Spirv)
-      return false;
-  }
-
-  // Check UserDataNode for unsupported Descriptor types.
-  if (hasUnrelocatableDescriptorNode(&pipelineInfo->resourceMapping))
+  if (!isRelocatableShaderElfSupported(&pipelineInfo->cs, &pipelineInfo->resourceMapping))
     return false;
 
   if (cl::RelocatableShaderElfLimit != -1) {
@@ -971,6 +1787,173 @@ bool Compiler::canUseRelocatableComputeShaderElf(const ComputePipelineBuildInfo
   return true;
 }
 
+// =====================================================================================================================
+// Translates and lowers the SPIR-V shader stages of a pipeline outside the pipeline's context, optionally concurrently
+// and optionally through the translated-IR cache. Each stage is processed in its own context, with a BuilderRecorder
+// that has no pipeline, so that the shader modes are recorded into the stage module as for a shader compile, and are
+// read back by Pipeline::irLink. The resulting modules are then moved into the pipeline's context through bitcode, and
+// their stages are added to the skip mask so that the per-stage passes in buildPipelineInternal are not run on them
+// again. With the translated-IR cache, that bitcode is what is cached, and a cache hit skips the front-end entirely.
+// With -spec-constant-placeholders, the cached bitcode of a stage whose specialization constants can be left as
+// placeholders is shared by all specializations of the shader, and is specialized once moved into the pipeline's
+// context.
+//
+// This does nothing if there are no SPIR-V stages to process (or fewer than two without the translated-IR cache), or
+// if the stages must be processed in the pipeline's context (direct builder, or output of the translation results).
+//
+// @param context : Acquired context of the pipeline
+// @param shaderInfo : Shader info of this pipeline
+// @param [in/out] modules : Per-stage modules; the initially empty modules of the processed stages are replaced
+// @param [in/out] stageSkipMask : Mask of shader stages that are not to be translated and lowered
+// @param [out] hasError : Set to true if an error diagnostic was reported while processing a stage
+Result Compiler::translateAndLowerStagesSeparately(Context *context, ArrayRef<const PipelineShaderInfo *> shaderInfo,
+                                                   MutableArrayRef<Module *> modules, unsigned *stageSkipMask,
+                                                   bool *hasError) {
+  if (!UseBuilderRecorder || EnableOuts())
+    return Result::Success;
+
+  SmallVector<unsigned, ShaderStageGfxCount> shaderIndices;
+  for (unsigned shaderIndex = 0; shaderIndex < shaderInfo.size(); ++shaderIndex) {
+    const PipelineShaderInfo *shaderInfoEntry = shaderInfo[shaderIndex];
+    if (shaderInfoEntry && shaderInfoEntry->pModuleData &&
+        !(*stageSkipMask & shaderStageToMask(shaderInfoEntry->entryStage)))
+      shaderIndices.push_back(shaderIndex);
+  }
+  if (shaderIndices.empty() || (shaderIndices.size() < 2 && !cl::EnableTranslatedIrCache))
+    return Result::Success;
+
+  std::vector<SmallString<0>> stageBitcodes(shaderInfo.size());
+  std::unique_ptr<bool[]> stageHasError = std::make_unique<bool[]>(shaderInfo.size());
+
+  // Decide which stages have their specialization constants translated as placeholders, so that their cached IR is
+  // shared by all specializations of the shader.
+  SmallVector<bool, ShaderStageGfxCount> specConstPlaceholders(shaderInfo.size(), false);
+  if (cl::EnableTranslatedIrCache && cl::SpecConstantPlaceholders) {
+    for (unsigned shaderIndex : shaderIndices) {
+      auto moduleDataEx = reinterpret_cast<const ShaderModuleDataEx *>(shaderInfo[shaderIndex]->pModuleData);
+      // Use the result of the check done when the shader module was built, if its SPIR-V summary is there
+      if (moduleDataEx->spirvSummary.idBound != 0)
+        specConstPlaceholders[shaderIndex] = moduleDataEx->spirvSummary.specConstPlaceholders;
+      else
+        specConstPlaceholders[shaderIndex] =
+            moduleDataEx->common.usage.useSpecConstant &&
+            ShaderModuleHelper::canUseSpecConstantPlaceholders(&moduleDataEx->common.binCode);
+    }
+  }
+
+  // Request the translated IR of all of the stages from the caches at once.
+  std::vector<CacheAccessor> cacheAccessors;
+  SmallVector<CacheAccessor *, ShaderStageGfxCount> stageCacheAccessors(shaderInfo.size(), nullptr);
+  if (cl::EnableTranslatedIrCache) {
+    SmallVector<MetroHash::Hash, ShaderStageGfxCount> cacheHashes;
+    for (unsigned shaderIndex : shaderIndices)
+      cacheHashes.push_back(generateHashForTranslatedShader(context, shaderInfo[shaderIndex], m_optionHash,
+                                                            specConstPlaceholders[shaderIndex]));
+    cacheAccessors = CacheAccessor::lookUpAll(context, cacheHashes, getInternalCaches());
+    for (unsigned i = 0; i < shaderIndices.size(); ++i)
+      stageCacheAccessors[shaderIndices[i]] = &cacheAccessors[i];
+  }
+
+  Error err = parallelFor(cl::ParallelStageTranslation ? 0 : 1, shaderIndices, [&](unsigned shaderIndex) -> Error {
+    const PipelineShaderInfo *shaderInfoEntry = shaderInfo[shaderIndex];
+    ShaderStage entryStage = shaderInfoEntry->entryStage;
+
+    CacheAccessor *cacheAccessor = stageCacheAccessors[shaderIndex];
+    if (cacheAccessor) {
+      if (cacheAccessor->isInCache()) {
+        LLPC_OUTS("Cache hit for translated IR of " << getShaderStageName(entryStage) << " shader\n");
+        BinaryData bitcode = cacheAccessor->getElfFromCache();
+        auto data = reinterpret_cast<const char *>(bitcode.pCode);
+        stageBitcodes[shaderIndex].assign(data, data + bitcode.codeSize);
+        return Error::success();
+      }
+      LLPC_OUTS("Cache miss for translated IR of " << getShaderStageName(entryStage) << " shader\n");
+    }
+
+    Context *stageContext = acquireContext();
+    stageContext->attachPipelineContext(context->getPipelineContext());
+    stageContext->setScalarBlockLayout(context->getScalarBlockLayout());
+    stageContext->setRobustBufferAccess(context->getRobustBufferAccess());
+    stageContext->setDiagnosticHandler(std::make_unique<LlpcDiagnosticHandler>(&stageHasError[shaderIndex]));
+    stageContext->setBuilder(stageContext->getLgcContext()->createBuilder(nullptr, true));
+    stageContext->getBuilder()->setShaderStage(getLgcShaderStage(entryStage));
+
+    auto module = std::make_unique<Module>(modules[shaderIndex]->getModuleIdentifier(), *stageContext);
+    stageContext->setModuleTargetMachine(&*module);
+
+    unsigned passIndex = 0;
+    bool success = false;
+    if (cl::NewPassManager) {
+      std::unique_ptr<lgc::PassManager> translatePassMgr(lgc::PassManager::Create());
+      translatePassMgr->setPassIndex(&passIndex);
+      SpirvLower::registerPasses(*translatePassMgr);
+      translatePassMgr->addPass(
+          SpirvLowerTranslator(entryStage, shaderInfoEntry, specConstPlaceholders[shaderIndex]));
+      success = runPasses(&*translatePassMgr, &*module);
+
+      if (success) {
+        std::unique_ptr<lgc::PassManager> lowerPassMgr(lgc::PassManager::Create());
+        lowerPassMgr->setPassIndex(&passIndex);
+        SpirvLower::registerPasses(*lowerPassMgr);
+        SpirvLower::addPasses(stageContext, entryStage, *lowerPassMgr, nullptr);
+        success = runPasses(&*lowerPassMgr, &*module);
+      }
+    } else {
+      std::unique_ptr<lgc::LegacyPassManager> translatePassMgr(lgc::LegacyPassManager::Create());
+      translatePassMgr->setPassIndex(&passIndex);
+      translatePassMgr->add(
+          createSpirvLowerTranslator(entryStage, shaderInfoEntry, specConstPlaceholders[shaderIndex]));
+      success = runPasses(&*translatePassMgr, &*module);
+
+      if (success) {
+        if (!EnableOuts()) {
+          success = runPasses(&stageContext->getLowerPassManager(entryStage, &passIndex), &*module);
+        } else {
+          std::unique_ptr<lgc::LegacyPassManager> lowerPassMgr(lgc::LegacyPassManager::Create());
+          lowerPassMgr->setPassIndex(&passIndex);
+          LegacySpirvLower::addPasses(stageContext, entryStage, *lowerPassMgr, nullptr);
+          success = runPasses(&*lowerPassMgr, &*module);
+        }
+      }
+    }
+
+    // A stage that reported an error diagnostic is not cached, so that the diagnostic is reported again.
+    if (success) {
+      raw_svector_ostream bitcodeStream(stageBitcodes[shaderIndex]);
+      WriteBitcodeToFile(*module, bitcodeStream);
+      if (cacheAccessor && !stageHasError[shaderIndex])
+        cacheAccessor->setElfInCache({stageBitcodes[shaderIndex].size(), stageBitcodes[shaderIndex].data()});
+    }
+
+    module.reset();
+    stageContext->setDiagnosticHandler(nullptr);
+    releaseContext(stageContext);
+
+    if (!success)
+      return createResultError(Result::ErrorInvalidShader, "Failed to translate SPIR-V or run per-shader passes");
+    return Error::success();
+  });
+  if (err)
+    return reportError(std::move(err));
+
+  // Move the stage modules into the pipeline's context.
+  for (unsigned shaderIndex : shaderIndices) {
+    BinaryData bitcode = {stageBitcodes[shaderIndex].size(), stageBitcodes[shaderIndex].data()};
+    std::unique_ptr<Module> module = context->loadLibrary(&bitcode);
+    if (!module)
+      return Result::ErrorInvalidShader;
+    if (specConstPlaceholders[shaderIndex])
+      specializeConstantPlaceholders(&*module, shaderInfo[shaderIndex]->pSpecializationInfo);
+
+    delete modules[shaderIndex];
+    modules[shaderIndex] = module.release();
+    *stageSkipMask |= shaderStageToMask(shaderInfo[shaderIndex]->entryStage);
+    *hasError |= stageHasError[shaderIndex];
+  }
+
+  return Result::Success;
+}
+
 // =====================================================================================================================
 // Build pipeline internally -- common code for graphics and compute
 //
@@ -986,6 +1969,7 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
   unsigned passIndex = 0;
   const PipelineShaderInfo *fragmentShaderInfo = nullptr;
   TimerProfiler timerProfiler(context->getPipelineHashCode(), "LLPC", TimerProfiler::PipelineTimerEnableMask);
+  const auto startTime = std::chrono::steady_clock::now();
   bool buildingRelocatableElf = context->getPipelineContext()->isUnlinked();
 
   bool hasError = false;
@@ -1000,14 +1984,36 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
   LgcContext *builderContext = context->getLgcContext();
   std::unique_ptr<Pipeline> pipeline(builderContext->createPipeline());
   context->getPipelineContext()->setPipelineState(&*pipeline, unlinked);
-  context->setBuilder(builderContext->createBuilder(&*pipeline, UseBuilderRecorder));
+  context->setBuilder(
+      builderContext->createBuilder(&*pipeline, useBuilderRecorder(shaderInfo, unlinked || buildingRelocatableElf)));
 
   std::unique_ptr<Module> pipelineModule;
 
+  // Set up the shader cache checker, and check the per-stage caches before running the front-end. Only enable per
+  // stage cache for full graphic pipeline.
+  GraphicsShaderCacheChecker graphicsShaderCacheChecker(this, context);
+  bool checkPerStageCache = cl::EnablePerStageCache && context->isGraphics() && !buildingRelocatableElf &&
+                            (context->getShaderStageMask() & (ShaderStageVertexBit | ShaderStageFragmentBit));
+  bool allStagesCached = false;
+  if (checkPerStageCache) {
+    unsigned lgcStageMask = 0;
+    for (ShaderStage stage : gfxShaderStages())
+      if (context->getShaderStageMask() & shaderStageToMask(stage))
+        lgcStageMask |= getLgcShaderStageMask(stage);
+    // The ELF of a pipeline is only put together from the cache alone if it has both halves, as the merge needs the
+    // ELF of a fragment half.
+    unsigned stagesLeftToCompile = graphicsShaderCacheChecker.checkEarly(lgcStageMask, stageCacheAccesses);
+    unsigned fragmentStageMask = getLgcShaderStageMask(ShaderStageFragment);
+    if (stagesLeftToCompile == 0 && (lgcStageMask & fragmentStageMask) && (lgcStageMask & ~fragmentStageMask)) {
+      allStagesCached = true;
+      fragmentShaderInfo = context->getPipelineShaderInfo(ShaderStageFragment);
+    }
+  }
+
   // NOTE: If input is LLVM IR, read it now. There is now only ever one IR module representing the
   // whole pipeline.
   const PipelineShaderInfo *shaderInfoEntry = shaderInfo[0] ? shaderInfo[0] : shaderInfo.back();
-  if (shaderInfoEntry) {
+  if (shaderInfoEntry && !allStagesCached) {
     const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfoEntry->pModuleData);
     if (moduleData && moduleData->binType == BinaryType::LlvmBc)
       pipelineModule.reset(context->loadLibrary(&moduleData->binCode).release());
@@ -1015,7 +2021,7 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
 
   // If not IR input, run the per-shader passes, including SPIR-V translation, and then link the modules
   // into a single pipeline module.
-  if (!pipelineModule) {
+  if (!pipelineModule && !allStagesCached) {
     // Create empty modules and set target machine in each.
     std::vector<Module *> modules(shaderInfo.size());
     unsigned stageSkipMask = 0;
@@ -1067,6 +2073,14 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
       context->setModuleTargetMachine(module);
     }
 
+    // Optionally translate and lower the SPIR-V stages concurrently or through the translated-IR cache, each in its
+    // own context. This marks the stages it processed in stageSkipMask, so the loops below just link their modules.
+    if (result == Result::Success && (cl::ParallelStageTranslation || cl::EnableTranslatedIrCache)) {
+      timerProfiler.startStopTimer(TimerTranslate, true);
+      result = translateAndLowerStagesSeparately(context, shaderInfo, modules, &stageSkipMask, &hasError);
+      timerProfiler.startStopTimer(TimerTranslate, false);
+    }
+
     for (unsigned shaderIndex = 0; shaderIndex < shaderInfo.size() && result == Result::Success; ++shaderIndex) {
       const PipelineShaderInfo *shaderInfoEntry = shaderInfo[shaderIndex];
       ShaderStage entryStage = shaderInfoEntry ? shaderInfoEntry->entryStage : ShaderStageInvalid;
@@ -1155,6 +2169,9 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
         );
         // Run the passes.
         success = runPasses(&*lowerPassMgr, modules[shaderIndex]);
+      } else if (!timerProfiler.getTimer(TimerLower) && !EnableOuts()) {
+        // Use this context's cached lowering pass manager for the stage.
+        success = runPasses(&context->getLowerPassManager(entryStage, &passIndex), modules[shaderIndex]);
       } else {
         std::unique_ptr<lgc::LegacyPassManager> lowerPassMgr(lgc::LegacyPassManager::Create());
         lowerPassMgr->setPassIndex(&passIndex);
@@ -1184,8 +2201,6 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
   }
 
   // Set up function to check shader cache.
-  GraphicsShaderCacheChecker graphicsShaderCacheChecker(this, context);
-
   Pipeline::CheckShaderCacheFunc checkShaderCacheFunc =
       // @param module : Module
       // @param stageMask : Shader stage mask
@@ -1196,16 +2211,32 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
         return graphicsShaderCacheChecker.check(module, stageMask, stageHashes, stageCacheAccesses);
       };
 
-  // Only enable per stage cache for full graphic pipeline
-  bool checkPerStageCache = cl::EnablePerStageCache && context->isGraphics() && !buildingRelocatableElf &&
-                            (context->getShaderStageMask() & (ShaderStageVertexBit | ShaderStageFragmentBit));
   if (!checkPerStageCache)
     checkShaderCacheFunc = nullptr;
 
-  // Generate pipeline.
-  raw_svector_ostream elfStream(*pipelineElf);
+  // For a build that can be cancelled, the PatchCheckShaderCache pass is also the cancellation point of the middle-end:
+  // if the build has been cancelled by then, all shader stages are removed, so that the optimization and code
+  // generation passes have nothing left to do. It is also where an asynchronous build lets more urgent builds run
+  // before its optimization and code generation.
+  bool stagesDropped = false;
+  if (context->getPipelineContext()->isCancellable()) {
+    Pipeline::CheckShaderCacheFunc checkCacheFunc = std::move(checkShaderCacheFunc);
+    checkShaderCacheFunc = [context, checkCacheFunc, &stagesDropped](const Module *module, unsigned stageMask,
+                                                                     ArrayRef<ArrayRef<uint8_t>> stageHashes) {
+      PipelineBuildScheduler::yield();
+      if (context->isCancelled()) {
+        stagesDropped = true;
+        return 0U;
+      }
+      return checkCacheFunc ? checkCacheFunc(module, stageMask, stageHashes) : stageMask;
+    };
+  }
+
+  if (result == Result::Success && context->isCancelled())
+    result = Result::ErrorUnavailable;
 
-  if (result == Result::Success) {
+  // Generate pipeline, straight into the pipeline ELF buffer.
+  if (result == Result::Success && !allStagesCached) {
     result = Result::ErrorInvalidShader;
 #if LLPC_ENABLE_EXCEPTION
     try
@@ -1217,13 +2248,16 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
           timerProfiler.getTimer(TimerCodeGen),
       };
 
-      pipeline->generate(std::move(pipelineModule), elfStream, checkShaderCacheFunc, timers, cl::NewPassManager == 2);
+      pipeline->generate(std::move(pipelineModule), *pipelineElf, checkShaderCacheFunc, timers,
+                         cl::NewPassManager == 2);
       result = Result::Success;
     }
 #if LLPC_ENABLE_EXCEPTION
     catch (const char *) {
     }
 #endif
+    if (stagesDropped)
+      result = Result::ErrorUnavailable;
   }
   if (checkPerStageCache) {
     // For graphics, update shader caches with results of compile, and merge ELF outputs if necessary.
@@ -1239,9 +2273,73 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
   if (result == Result::Success && hasError)
     result = Result::ErrorInvalidShader;
 
+  context->getPipelineContext()->recordPeakMemoryGrowth(timerProfiler.getPeakMallocGrowth());
+
+  if (result == Result::Success) {
+    std::chrono::duration<double, std::milli> compileTime = std::chrono::steady_clock::now() - startTime;
+    PipelineCostEstimate estimate = {};
+    recordCompileTime(modelCompileTime(shaderInfo, buildingRelocatableElf, &estimate), compileTime.count());
+    if (cl::SlowPipelineDumpThreshold != 0 && compileTime.count() > cl::SlowPipelineDumpThreshold)
+      dumpSlowPipeline(context, shaderInfo, compileTime.count(), timerProfiler.getPhaseTimes());
+  }
+
   return result;
 }
 
+// =====================================================================================================================
+// Check shader cache for graphics pipeline before the front-end runs, by hashes built from the shader info rather than
+// from the in/out usage. A half found in the cache here is taken from the cache without checking it again in the
+// PatchCheckShaderCache pass; if both halves are found, there is nothing left to compile.
+//
+// @param stageMask : Shader stage mask (NOTE: This is a LGC shader stage mask)
+// @param [out] stageCacheAccesses : Stage cache access info to fill out
+// @returns : Stage mask of the stages left to compile.
+unsigned GraphicsShaderCacheChecker::checkEarly(unsigned stageMask,
+                                                MutableArrayRef<CacheAccessInfo> stageCacheAccesses) {
+  MetroHash::Hash fragmentHash = {};
+  MetroHash::Hash nonFragmentHash = {};
+  Compiler::buildShaderCacheHash(m_context, stageMask, {}, &fragmentHash, &nonFragmentHash);
+  unsigned stagesLeftToCompile = stageMask;
+
+  bool checkFragment = stageMask & getLgcShaderStageMask(ShaderStageFragment);
+  bool checkNonFragment = stageMask & ~getLgcShaderStageMask(ShaderStageFragment);
+  SmallVector<MetroHash::Hash, 2> cacheHashes;
+  if (checkFragment)
+    cacheHashes.push_back(fragmentHash);
+  if (checkNonFragment)
+    cacheHashes.push_back(nonFragmentHash);
+  std::vector<CacheAccessor> cacheAccessors =
+      CacheAccessor::lookUpAll(m_context, cacheHashes, m_compiler->getInternalCaches());
+
+  if (checkFragment) {
+    CacheAccessor &accessor = cacheAccessors.front();
+    if (accessor.isInCache()) {
+      stagesLeftToCompile &= ~getLgcShaderStageMask(ShaderStageFragment);
+      stageCacheAccesses[ShaderStageFragment] =
+          accessor.hitInternalCache() ? CacheAccessInfo::InternalCacheHit : CacheAccessInfo::CacheHit;
+      m_fragmentCacheAccessor.emplace(std::move(accessor));
+    } else {
+      m_earlyFragmentCacheAccessor.emplace(std::move(accessor));
+    }
+  }
+
+  if (checkNonFragment) {
+    CacheAccessor &accessor = cacheAccessors.back();
+    if (accessor.isInCache()) {
+      stagesLeftToCompile &= getLgcShaderStageMask(ShaderStageFragment);
+      auto accessInfo = accessor.hitInternalCache() ? CacheAccessInfo::InternalCacheHit : CacheAccessInfo::CacheHit;
+      for (ShaderStage stage : gfxShaderStages())
+        if (stage != ShaderStageFragment && (getLgcShaderStageMask(stage) & stageMask))
+          stageCacheAccesses[stage] = accessInfo;
+      m_nonFragmentHash = nonFragmentHash;
+      m_nonFragmentCacheAccessor.emplace(std::move(accessor));
+    } else {
+      m_earlyNonFragmentCacheAccessor.emplace(std::move(accessor));
+    }
+  }
+  return stagesLeftToCompile;
+}
+
 // =====================================================================================================================
 // Check shader cache for graphics pipeline, returning mask of which shader stages we want to keep in this compile.
 // This is called from the PatchCheckShaderCache pass (via a lambda in BuildPipelineInternal), to remove
@@ -1255,14 +2353,34 @@ Result Compiler::buildPipelineInternal(Context *context, ArrayRef<const Pipeline
 unsigned GraphicsShaderCacheChecker::check(const Module *module, const unsigned stageMask,
                                            ArrayRef<ArrayRef<uint8_t>> stageHashes,
                                            llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses) {
+  unsigned stagesLeftToCompile = stageMask;
+
+  // Remove the stages of the halves already found in the cache by checkEarly.
+  if (m_fragmentCacheAccessor)
+    stagesLeftToCompile &= ~getLgcShaderStageMask(ShaderStageFragment);
+  if (m_nonFragmentCacheAccessor)
+    stagesLeftToCompile &= getLgcShaderStageMask(ShaderStageFragment);
+
   // Check per stage shader cache
   MetroHash::Hash fragmentHash = {};
   MetroHash::Hash nonFragmentHash = {};
-  Compiler::buildShaderCacheHash(m_context, stageMask, stageHashes, &fragmentHash, &nonFragmentHash);
-  unsigned stagesLeftToCompile = stageMask;
-
-  if (stageMask & getLgcShaderStageMask(ShaderStageFragment)) {
-    m_fragmentCacheAccessor.emplace(m_context, fragmentHash, m_compiler->getInternalCaches());
+  Compiler::buildShaderCacheHash(m_context, stagesLeftToCompile, stageHashes, &fragmentHash, &nonFragmentHash);
+
+  // Request the fragment and non-fragment entries at once.
+  bool checkFragment = stagesLeftToCompile & getLgcShaderStageMask(ShaderStageFragment);
+  bool checkNonFragment = stagesLeftToCompile & ~getLgcShaderStageMask(ShaderStageFragment);
+  if (checkNonFragment)
+    m_nonFragmentHash = nonFragmentHash;
+  SmallVector<MetroHash::Hash, 2> cacheHashes;
+  if (checkFragment)
+    cacheHashes.push_back(fragmentHash);
+  if (checkNonFragment)
+    cacheHashes.push_back(nonFragmentHash);
+  std::vector<CacheAccessor> cacheAccessors =
+      CacheAccessor::lookUpAll(m_context, cacheHashes, m_compiler->getInternalCaches());
+
+  if (checkFragment) {
+    m_fragmentCacheAccessor.emplace(std::move(cacheAccessors.front()));
     if (m_fragmentCacheAccessor->isInCache()) {
       // Remove fragment shader stages.
       stagesLeftToCompile &= ~getLgcShaderStageMask(ShaderStageFragment);
@@ -1273,9 +2391,9 @@ unsigned GraphicsShaderCacheChecker::check(const Module *module, const unsigned
     }
   }
 
-  if (stageMask & ~getLgcShaderStageMask(ShaderStageFragment)) {
+  if (checkNonFragment) {
     auto accessInfo = CacheAccessInfo::CacheNotChecked;
-    m_nonFragmentCacheAccessor.emplace(m_context, nonFragmentHash, m_compiler->getInternalCaches());
+    m_nonFragmentCacheAccessor.emplace(std::move(cacheAccessors.back()));
     if (m_nonFragmentCacheAccessor->isInCache()) {
       // Remove non-fragment shader stages.
       stagesLeftToCompile &= getLgcShaderStageMask(ShaderStageFragment);
@@ -1319,9 +2437,14 @@ void GraphicsShaderCacheChecker::updateAndMerge(Result result, ElfPackage *outpu
   if (m_nonFragmentCacheAccessor) {
     if (!m_nonFragmentCacheAccessor->isInCache()) {
       m_nonFragmentCacheAccessor->setElfInCache(pipelineElf);
+      if (m_earlyNonFragmentCacheAccessor)
+        m_earlyNonFragmentCacheAccessor->setElfInCache(pipelineElf);
       LLPC_OUTS("Non fragment shader cache miss.\n");
     } else {
       needToMergeElf = true;
+      // A half found by the in/out usage hash is also added under the hash of the early lookup that missed it.
+      if (m_earlyNonFragmentCacheAccessor)
+        m_earlyNonFragmentCacheAccessor->setElfInCache(m_nonFragmentCacheAccessor->getElfFromCache());
       LLPC_OUTS("Non fragment shader cache hit.\n");
     }
   }
@@ -1329,9 +2452,13 @@ void GraphicsShaderCacheChecker::updateAndMerge(Result result, ElfPackage *outpu
   if (m_fragmentCacheAccessor) {
     if (!m_fragmentCacheAccessor->isInCache()) {
       m_fragmentCacheAccessor->setElfInCache(pipelineElf);
+      if (m_earlyFragmentCacheAccessor)
+        m_earlyFragmentCacheAccessor->setElfInCache(pipelineElf);
       LLPC_OUTS("Fragment shader cache miss.\n");
     } else {
       needToMergeElf = true;
+      if (m_earlyFragmentCacheAccessor)
+        m_earlyFragmentCacheAccessor->setElfInCache(m_fragmentCacheAccessor->getElfFromCache());
       LLPC_OUTS("Fragment shader cache hit.\n");
     }
   }
@@ -1352,6 +2479,20 @@ void GraphicsShaderCacheChecker::updateAndMerge(Result result, ElfPackage *outpu
       fragmentElf.codeSize = compiledPipelineElf.size();
     }
 
+    if (cl::NonFragmentElfCacheSize != 0 && m_nonFragmentCacheAccessor && m_nonFragmentCacheAccessor->isInCache()) {
+      // Merge into the decoded non-fragment half kept by the compiler, decoding it from the shader cache's ELF if it
+      // is not there.
+      NonFragmentElfCache &nonFragmentElfCache = m_compiler->getNonFragmentElfCache();
+      std::unique_ptr<NonFragmentElf> nonFragmentElf = nonFragmentElfCache.take(m_nonFragmentHash);
+      if (!nonFragmentElf) {
+        nonFragmentElf = std::make_unique<NonFragmentElf>(m_context->getGfxIpVersion(),
+                                                          m_nonFragmentCacheAccessor->getElfFromCache());
+      }
+      nonFragmentElf->mergeFragmentElf(m_context, &fragmentElf, outputPipelineElf);
+      nonFragmentElfCache.insert(m_nonFragmentHash, std::move(nonFragmentElf));
+      return;
+    }
+
     BinaryData nonFragmentElf = {};
     if ((m_nonFragmentCacheAccessor && m_nonFragmentCacheAccessor->isInCache()))
       nonFragmentElf = m_nonFragmentCacheAccessor->getElfFromCache();
@@ -1424,6 +2565,99 @@ Result Compiler::buildGraphicsPipelineInternal(GraphicsContext *graphicsContext,
   return result;
 }
 
+// =====================================================================================================================
+// Estimates the cost of building a graphics pipeline, without compiling it.
+//
+// @param pipelineInfo : Info of the graphics pipeline
+// @param [out] estimate : Cost estimate of building the pipeline
+Result Compiler::EstimatePipelineCost(const GraphicsPipelineBuildInfo *pipelineInfo, PipelineCostEstimate *estimate) {
+  // clang-format off
+  const PipelineShaderInfo *shaderInfo[ShaderStageGfxCount] = {
+    &pipelineInfo->vs,
+    &pipelineInfo->tcs,
+    &pipelineInfo->tes,
+    &pipelineInfo->gs,
+    &pipelineInfo->fs,
+  };
+  // clang-format on
+  for (ShaderStage stage : gfxShaderStages()) {
+    Result result = validatePipelineShaderInfo(shaderInfo[stage]);
+    if (result != Result::Success)
+      return result;
+  }
+
+  *estimate = {};
+  // -relocatable-shader-elf-limit is not checked, as it counts the pipelines that are actually built.
+  bool relocatable = (pipelineInfo->options.enableRelocatableShaderElf || cl::UseRelocatableShaderElf) &&
+                     isRelocatableShaderElfSupported(shaderInfo[0], &pipelineInfo->resourceMapping);
+  estimate->estimatedCompileTime = calibrateCompileTime(modelCompileTime(shaderInfo, relocatable, estimate));
+  estimate->preferBackgroundBuild = estimate->estimatedCompileTime > cl::BackgroundBuildCostThreshold;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Estimates the cost of building a compute pipeline, without compiling it.
+//
+// @param pipelineInfo : Info of the compute pipeline
+// @param [out] estimate : Cost estimate of building the pipeline
+Result Compiler::EstimatePipelineCost(const ComputePipelineBuildInfo *pipelineInfo, PipelineCostEstimate *estimate) {
+  Result result = validatePipelineShaderInfo(&pipelineInfo->cs);
+  if (result != Result::Success)
+    return result;
+
+  *estimate = {};
+  // -relocatable-shader-elf-limit is not checked, as it counts the pipelines that are actually built.
+  bool relocatable = (pipelineInfo->options.enableRelocatableShaderElf || cl::UseRelocatableShaderElf) &&
+                     isRelocatableShaderElfSupported(&pipelineInfo->cs, &pipelineInfo->resourceMapping);
+  const PipelineShaderInfo *shaderInfo[] = {&pipelineInfo->cs};
+  estimate->estimatedCompileTime = calibrateCompileTime(modelCompileTime(shaderInfo, relocatable, estimate));
+  estimate->preferBackgroundBuild = estimate->estimatedCompileTime > cl::BackgroundBuildCostThreshold;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Scales a compile time given by the cost model by the ratio of the measured compile times of the pipelines this
+// compiler has built to the compile times that the model gave for them, once there are enough of them.
+//
+// @param modelCompileTime : Compile time given by the cost model, in milliseconds
+// @returns : Calibrated compile time, in milliseconds
+double Compiler::calibrateCompileTime(double modelCompileTime) {
+  // The number of pipeline compiles needed before the model is calibrated
+  constexpr unsigned MinCompileTimeSamples = 4;
+
+  std::lock_guard<std::mutex> lock(m_compileTimeMutex);
+  if (m_compileTimeSamples < MinCompileTimeSamples || m_modelCompileTimeTotal == 0)
+    return modelCompileTime;
+  return modelCompileTime * (m_compileTimeTotal / m_modelCompileTimeTotal);
+}
+
+// =====================================================================================================================
+// Records the measured compile time of a pipeline along with the compile time that the cost model gave for it, for
+// calibrating the model.
+//
+// @param modelCompileTime : Compile time given by the cost model, in milliseconds
+// @param compileTime : Measured compile time, in milliseconds
+void Compiler::recordCompileTime(double modelCompileTime, double compileTime) {
+  std::lock_guard<std::mutex> lock(m_compileTimeMutex);
+  m_modelCompileTimeTotal += modelCompileTime;
+  m_compileTimeTotal += compileTime;
+  ++m_compileTimeSamples;
+}
+
+// =====================================================================================================================
+// Gets the statistics of the cache lookups since they were last reset, which are those of all compilers in the process.
+//
+// @param [out] stats : Statistics of the cache lookups
+void Compiler::GetCacheStats(CacheStats *stats) {
+  CacheStatsCollector::get().query(stats);
+}
+
+// =====================================================================================================================
+// Resets the statistics of the cache lookups.
+void Compiler::ResetCacheStats() {
+  CacheStatsCollector::get().reset();
+}
+
 // =====================================================================================================================
 // Build graphics pipeline from the specified info.
 //
@@ -1432,6 +2666,185 @@ Result Compiler::buildGraphicsPipelineInternal(GraphicsContext *graphicsContext,
 // @param pipelineDumpFile : Handle of pipeline dump file
 Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipelineInfo,
                                        GraphicsPipelineBuildOut *pipelineOut, void *pipelineDumpFile) {
+  return buildGraphicsPipeline(pipelineInfo, pipelineOut, pipelineDumpFile, nullptr);
+}
+
+// =====================================================================================================================
+// Compiles ahead of time the glue shaders needed to link the specified graphics pipelines from relocatable shader ELFs,
+// keeping them in the caches. The relocatable shader ELFs are built or found in the caches on the way, but the
+// pipelines are not linked.
+//
+// @param pipelineInfos : Infos of the graphics pipelines whose glue shaders are to be compiled
+// @param pipelineCount : Count of pipeline infos
+Result Compiler::PrecompileGlueShaders(const GraphicsPipelineBuildInfo *const *pipelineInfos, unsigned pipelineCount) {
+  Result result = Result::Success;
+  for (unsigned pipelineIndex = 0; pipelineIndex < pipelineCount && result == Result::Success; ++pipelineIndex) {
+    const GraphicsPipelineBuildInfo *pipelineInfo = pipelineInfos[pipelineIndex];
+    // clang-format off
+    SmallVector<const PipelineShaderInfo *, ShaderStageGfxCount> shaderInfo = {
+      &pipelineInfo->vs,
+      &pipelineInfo->tcs,
+      &pipelineInfo->tes,
+      &pipelineInfo->gs,
+      &pipelineInfo->fs,
+    };
+    // clang-format on
+    for (ShaderStage stage : gfxShaderStages()) {
+      result = validatePipelineShaderInfo(shaderInfo[stage]);
+      if (result != Result::Success)
+        break;
+    }
+    if (result != Result::Success)
+      break;
+    if (!canUseRelocatableGraphicsShaderElf(shaderInfo, pipelineInfo)) {
+      result = Result::Unsupported;
+      break;
+    }
+
+    PipelineHashContext hashContext;
+    MetroHash::Hash cacheHash =
+        PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false, UnlinkedStageCount, &hashContext);
+    MetroHash::Hash pipelineHash =
+        PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, false, false, UnlinkedStageCount, &hashContext);
+    GraphicsContext graphicsContext(m_gfxIp, pipelineInfo, &pipelineHash, &cacheHash);
+
+    Context *context = acquireContext();
+    context->attachPipelineContext(&graphicsContext);
+    ElfPackage pipelineElf;
+    CacheAccessInfo stageCacheAccesses[ShaderStageCount] = {};
+    result = buildPipelineWithRelocatableElf(context, shaderInfo, &pipelineElf, stageCacheAccesses,
+                                             /*glueShadersOnly=*/true);
+    releaseContext(context);
+  }
+  return result;
+}
+
+// =====================================================================================================================
+// Builds one part of a graphics pipeline as a library, which is the unlinked relocatable shader ELF of its stages. The
+// stages of the other part are removed from a copy of the pipeline info, so that neither the pipeline cache hash nor
+// the per-stage cache hash of the part depends on them.
+//
+// @param pipelineInfo : Info of the graphics pipeline that the library is a part of
+// @param part : Part of the pipeline to build
+// @param [out] pipelineOut : Output of building the library
+Result Compiler::BuildGraphicsPipelineLibrary(const GraphicsPipelineBuildInfo *pipelineInfo, UnlinkedShaderStage part,
+                                              GraphicsPipelineBuildOut *pipelineOut) {
+  if (!pipelineInfo || !pipelineOut)
+    return Result::ErrorInvalidPointer;
+  if (part != UnlinkedStageVertexProcess && part != UnlinkedStageFragment)
+    return Result::ErrorInvalidValue;
+
+  GraphicsPipelineBuildInfo libraryInfo = *pipelineInfo;
+  // clang-format off
+  PipelineShaderInfo *shaderInfo[ShaderStageGfxCount] = {
+    &libraryInfo.vs,
+    &libraryInfo.tcs,
+    &libraryInfo.tes,
+    &libraryInfo.gs,
+    &libraryInfo.fs,
+  };
+  // clang-format on
+  const unsigned partStageMask = getShaderStageMaskForType(part);
+  for (ShaderStage stage : gfxShaderStages()) {
+    if ((partStageMask & shaderStageToMask(stage)) == 0)
+      *shaderInfo[stage] = {};
+  }
+
+  if (!hasDataForUnlinkedShaderType(part, {shaderInfo, ShaderStageGfxCount}))
+    return Result::ErrorInvalidValue;
+  const PipelineShaderInfo *firstShaderInfo = part == UnlinkedStageFragment ? &libraryInfo.fs : &libraryInfo.vs;
+  if (!isRelocatableShaderElfSupported(firstShaderInfo, &libraryInfo.resourceMapping))
+    return Result::Unsupported;
+
+  libraryInfo.unlinked = true;
+  libraryInfo.options.enableRelocatableShaderElf = true;
+  return buildGraphicsPipeline(&libraryInfo, pipelineOut, nullptr, nullptr);
+}
+
+// =====================================================================================================================
+// Links a graphics pipeline from the libraries of its parts and the glue shaders for its state.
+//
+// @param pipelineInfo : Info of the graphics pipeline
+// @param libraries : Library ELFs, indexed by UnlinkedShaderStage
+// @param libraryCount : Count of entries in libraries
+// @param [out] pipelineOut : Output of linking the pipeline
+Result Compiler::LinkGraphicsPipelineLibraries(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                               const BinaryData *libraries, unsigned libraryCount,
+                                               GraphicsPipelineBuildOut *pipelineOut) {
+  if (!pipelineInfo || !pipelineOut || (libraryCount != 0 && !libraries))
+    return Result::ErrorInvalidPointer;
+  if (libraryCount > UnlinkedStageFragment + 1)
+    return Result::ErrorInvalidValue;
+
+  // clang-format off
+  const PipelineShaderInfo *shaderInfo[ShaderStageGfxCount] = {
+    &pipelineInfo->vs,
+    &pipelineInfo->tcs,
+    &pipelineInfo->tes,
+    &pipelineInfo->gs,
+    &pipelineInfo->fs,
+  };
+  // clang-format on
+  for (ShaderStage stage : gfxShaderStages()) {
+    Result result = validatePipelineShaderInfo(shaderInfo[stage]);
+    if (result != Result::Success)
+      return result;
+  }
+
+  // The linker reads the library ELFs where the client has them.
+  StringRef elf[enumCount<UnlinkedShaderStage>()];
+  for (unsigned part = 0; part != libraryCount; ++part) {
+    auto data = static_cast<const char *>(libraries[part].pCode);
+    if (data)
+      elf[part] = StringRef(data, libraries[part].codeSize);
+  }
+  if (elf[UnlinkedStageVertexProcess].empty())
+    return Result::ErrorInvalidValue;
+
+  PipelineHashContext hashContext;
+  MetroHash::Hash cacheHash =
+      PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false, UnlinkedStageCount, &hashContext);
+  MetroHash::Hash pipelineHash =
+      PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, false, false, UnlinkedStageCount, &hashContext);
+  GraphicsContext graphicsContext(m_gfxIp, pipelineInfo, &pipelineHash, &cacheHash);
+
+  Context *context = acquireContext();
+  context->attachPipelineContext(&graphicsContext);
+  LLPC_OUTS("Linking graphics pipeline from libraries.\n");
+  bool hasError = false;
+  context->setDiagnosticHandler(std::make_unique<LlpcDiagnosticHandler>(&hasError));
+  ElfPackage pipelineElf;
+  hasError |= !linkRelocatableShaderElf(elf, &pipelineElf, context);
+  context->setDiagnosticHandler(nullptr);
+  releaseContext(context);
+  if (hasError)
+    return Result::ErrorInvalidShader;
+
+  if (!pipelineInfo->pfnOutputAlloc)
+    return Result::ErrorInvalidPointer;
+  void *allocBuf = pipelineInfo->pfnOutputAlloc(pipelineInfo->pInstance, pipelineInfo->pUserData, pipelineElf.size());
+  if (!allocBuf)
+    return Result::ErrorOutOfMemory;
+  memcpy(allocBuf, pipelineElf.data(), pipelineElf.size());
+  pipelineOut->pipelineBin.codeSize = pipelineElf.size();
+  pipelineOut->pipelineBin.pCode = allocBuf;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Build graphics pipeline from the specified info, with optional cancellation.
+//
+// @param pipelineInfo : Info to build this graphics pipeline
+// @param [out] pipelineOut : Output of building this graphics pipeline
+// @param pipelineDumpFile : Handle of pipeline dump file
+// @param cancelFlag : Flag that is raised when the build is cancelled, or nullptr if it cannot be cancelled
+// @param linkMode : How to build the pipeline if it is not in the cache
+// @param [out] fastBuilt : If not nullptr, set to whether this build made a fast pipeline, linked from relocatable
+//                          shader ELFs or compiled at the fast compile tier, rather than the optimized one
+Result Compiler::buildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                       GraphicsPipelineBuildOut *pipelineOut, void *pipelineDumpFile,
+                                       const std::atomic<bool> *cancelFlag, GraphicsLinkMode linkMode,
+                                       bool *fastBuilt) {
   Result result = Result::Success;
   BinaryData elfBin = {};
   // clang-format off
@@ -1443,9 +2856,12 @@ Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline
     &pipelineInfo->fs,
   };
   // clang-format on
-  const bool relocatableElfRequested = pipelineInfo->options.enableRelocatableShaderElf || cl::UseRelocatableShaderElf;
-  const bool buildUsingRelocatableElf =
-      relocatableElfRequested && canUseRelocatableGraphicsShaderElf(shaderInfo, pipelineInfo);
+  const bool relocatableElfRequested =
+      linkMode == GraphicsLinkMode::FastLink ||
+      (linkMode == GraphicsLinkMode::Default &&
+       (pipelineInfo->options.enableRelocatableShaderElf || cl::UseRelocatableShaderElf));
+  bool buildUsingRelocatableElf = false;
+  bool buildUsingFastTier = false;
 
   for (ShaderStage stage : gfxShaderStages()) {
     result = validatePipelineShaderInfo(shaderInfo[stage]);
@@ -1453,15 +2869,24 @@ Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline
       break;
   }
 
-  MetroHash::Hash cacheHash = {};
-  MetroHash::Hash pipelineHash = {};
-  cacheHash = PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false);
-  pipelineHash = PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, false, false);
+  // The cache and pipeline hashes share the hashes of the resource mapping and the vertex input state. The pipeline
+  // hash is only needed to build the pipeline or to report it, so a cache hit costs only the cache hash and a look up.
+  PipelineHashContext hashContext;
+  MetroHash::Hash cacheHash =
+      PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false, UnlinkedStageCount, &hashContext);
+  Optional<MetroHash::Hash> pipelineHash;
+  auto getPipelineHash = [&]() {
+    if (!pipelineHash) {
+      pipelineHash =
+          PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, false, false, UnlinkedStageCount, &hashContext);
+    }
+    return &*pipelineHash;
+  };
 
   if (result == Result::Success && EnableOuts()) {
     LLPC_OUTS("===============================================================================\n");
     LLPC_OUTS("// LLPC calculated hash results (graphics pipeline)\n\n");
-    LLPC_OUTS("PIPE : " << format("0x%016" PRIX64, MetroHash::compact64(&pipelineHash)) << "\n");
+    LLPC_OUTS("PIPE : " << format("0x%016" PRIX64, MetroHash::compact64(getPipelineHash())) << "\n");
     for (ShaderStage stage : gfxShaderStages()) {
       auto moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo[stage]->pModuleData);
       if (moduleData) {
@@ -1470,10 +2895,6 @@ Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline
                   << format("0x%016" PRIX64, MetroHash::compact64(hash)) << "\n");
       }
     }
-    if (relocatableElfRequested && !buildUsingRelocatableElf) {
-      LLPC_OUTS("\nWarning: Relocatable shader compilation requested but not possible. "
-                << "Falling back to whole-pipeline compilation.\n");
-    }
     LLPC_OUTS("\n");
   }
 
@@ -1491,13 +2912,52 @@ Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline
     cacheAccessor.emplace(pipelineInfo, cacheHash, getInternalCaches());
   }
 
-  ElfPackage candidateElf;
+  // The pipeline ELF is staged in a buffer from the pool, which is given back once the ELF has been copied out.
+  std::unique_ptr<ElfPackage> candidateElfBuffer = m_elfPackagePool.take();
+  auto giveBackCandidateElf = make_scope_exit([&] { m_elfPackagePool.give(std::move(candidateElfBuffer)); });
+  ElfPackage &candidateElf = *candidateElfBuffer;
+  std::shared_ptr<InFlightBuildTable::Build> inFlightBuild;
 
   if (!cacheAccessor || !cacheAccessor->isInCache()) {
     LLPC_OUTS("Cache miss for graphics pipeline.\n");
-    GraphicsContext graphicsContext(m_gfxIp, pipelineInfo, &pipelineHash, &cacheHash);
-    result = buildGraphicsPipelineInternal(&graphicsContext, shaderInfo, buildUsingRelocatableElf, &candidateElf,
-                                           pipelineOut->stageCacheAccesses);
+    if (result == Result::Success && m_negativeResultCache.lookUp(cacheHash, &result)) {
+      LLPC_OUTS("Graphics pipeline failed to compile recently, not compiling it again.\n");
+    } else if (result == Result::Success && linkMode != GraphicsLinkMode::FastLink &&
+               joinInFlightBuild(cacheHash, &result, &candidateElf, &inFlightBuild)) {
+      // A fast-linked build does not share its result, as it is not the pipeline that the cache hash stands for.
+      LLPC_OUTS("Graphics pipeline was built by another thread at the same time.\n");
+      pipelineOut->pipelineCacheAccess = CacheAccessInfo::InternalCacheHit;
+    } else {
+      // Whether relocatable shader ELFs are used is decided only now, so that cache hits do not count towards
+      // -relocatable-shader-elf-limit.
+      buildUsingRelocatableElf =
+          relocatableElfRequested && canUseRelocatableGraphicsShaderElf(shaderInfo, pipelineInfo);
+      if (relocatableElfRequested && !buildUsingRelocatableElf) {
+        LLPC_OUTS("Warning: Relocatable shader compilation requested but not possible. "
+                  << "Falling back to whole-pipeline compilation.\n");
+      }
+      // A fast build that cannot link relocatable shader ELFs compiles the whole pipeline at the fast compile tier
+      // instead. It keeps the pipeline hash of the optimized pipeline, which is what it stands in for.
+      GraphicsPipelineBuildInfo fastTierInfo;
+      const GraphicsPipelineBuildInfo *buildInfo = pipelineInfo;
+      buildUsingFastTier = linkMode == GraphicsLinkMode::FastLink && !buildUsingRelocatableElf;
+      if (buildUsingFastTier) {
+        LLPC_OUTS("Compiling graphics pipeline at the fast compile tier.\n");
+        fastTierInfo = *pipelineInfo;
+        fastTierInfo.options.fastCompile = true;
+        buildInfo = &fastTierInfo;
+        shaderInfo = {&fastTierInfo.vs, &fastTierInfo.tcs, &fastTierInfo.tes, &fastTierInfo.gs, &fastTierInfo.fs};
+      }
+      GraphicsContext graphicsContext(m_gfxIp, buildInfo, getPipelineHash(), &cacheHash);
+      graphicsContext.setCancelFlag(cancelFlag);
+      result = buildGraphicsPipelineInternal(&graphicsContext, shaderInfo, buildUsingRelocatableElf, &candidateElf,
+                                             pipelineOut->stageCacheAccesses);
+      pipelineOut->peakMemoryGrowth = graphicsContext.getPeakMemoryGrowth();
+      if (result != Result::Success)
+        m_negativeResultCache.insert(cacheHash, result);
+      if (inFlightBuild)
+        m_inFlightBuilds.complete(*inFlightBuild, result, candidateElf);
+    }
 
     if (result == Result::Success) {
       elfBin.codeSize = candidateElf.size();
@@ -1519,22 +2979,29 @@ Result Compiler::BuildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline
     void *allocBuf = nullptr;
     if (pipelineInfo->pfnOutputAlloc) {
       allocBuf = pipelineInfo->pfnOutputAlloc(pipelineInfo->pInstance, pipelineInfo->pUserData, elfBin.codeSize);
+      if (allocBuf) {
+        uint8_t *code = static_cast<uint8_t *>(allocBuf);
+        memcpy(code, elfBin.pCode, elfBin.codeSize);
 
-      uint8_t *code = static_cast<uint8_t *>(allocBuf);
-      memcpy(code, elfBin.pCode, elfBin.codeSize);
-
-      pipelineOut->pipelineBin.codeSize = elfBin.codeSize;
-      pipelineOut->pipelineBin.pCode = code;
+        pipelineOut->pipelineBin.codeSize = elfBin.codeSize;
+        pipelineOut->pipelineBin.pCode = code;
+      } else
+        result = Result::ErrorOutOfMemory;
     } else {
       // Allocator is not specified
       result = Result::ErrorInvalidPointer;
     }
   }
 
-  if (cacheAccessor && !cacheAccessor->isInCache() && result == Result::Success) {
+  // A fast pipeline is kept out of the cache, so that the optimized whole-pipeline build of it can be added later.
+  const bool builtFast = buildUsingRelocatableElf || buildUsingFastTier;
+  if (cacheAccessor && !cacheAccessor->isInCache() && result == Result::Success &&
+      !(linkMode == GraphicsLinkMode::FastLink && builtFast)) {
     LLPC_OUTS("Adding graphics pipeline to the cache.\n");
     cacheAccessor->setElfInCache(elfBin);
   }
+  if (fastBuilt)
+    *fastBuilt = builtFast;
   return result;
 }
 
@@ -1583,30 +3050,44 @@ Result Compiler::buildComputePipelineInternal(ComputeContext *computeContext,
 // @param pipelineDumpFile : Handle of pipeline dump file
 Result Compiler::BuildComputePipeline(const ComputePipelineBuildInfo *pipelineInfo,
                                       ComputePipelineBuildOut *pipelineOut, void *pipelineDumpFile) {
+  return buildComputePipeline(pipelineInfo, pipelineOut, pipelineDumpFile, nullptr);
+}
+
+// =====================================================================================================================
+// Build compute pipeline from the specified info, with optional cancellation.
+//
+// @param pipelineInfo : Info to build this compute pipeline
+// @param [out] pipelineOut : Output of building this compute pipeline
+// @param pipelineDumpFile : Handle of pipeline dump file
+// @param cancelFlag : Flag that is raised when the build is cancelled, or nullptr if it cannot be cancelled
+Result Compiler::buildComputePipeline(const ComputePipelineBuildInfo *pipelineInfo,
+                                      ComputePipelineBuildOut *pipelineOut, void *pipelineDumpFile,
+                                      const std::atomic<bool> *cancelFlag) {
   BinaryData elfBin = {};
 
   const bool relocatableElfRequested = pipelineInfo->options.enableRelocatableShaderElf || cl::UseRelocatableShaderElf;
-  const bool buildUsingRelocatableElf = relocatableElfRequested && canUseRelocatableComputeShaderElf(pipelineInfo);
 
   Result result = validatePipelineShaderInfo(&pipelineInfo->cs);
 
-  MetroHash::Hash cacheHash = {};
-  MetroHash::Hash pipelineHash = {};
-  cacheHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, true, false);
-  pipelineHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, false, false);
+  // The pipeline hash is only needed to build the pipeline or to report it, so a cache hit costs only the cache hash
+  // and a look up.
+  PipelineHashContext hashContext;
+  MetroHash::Hash cacheHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, true, false, &hashContext);
+  Optional<MetroHash::Hash> pipelineHash;
+  auto getPipelineHash = [&]() {
+    if (!pipelineHash)
+      pipelineHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, false, false, &hashContext);
+    return &*pipelineHash;
+  };
 
   if (result == Result::Success && EnableOuts()) {
     const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(pipelineInfo->cs.pModuleData);
     auto moduleHash = reinterpret_cast<const MetroHash::Hash *>(&moduleData->hash[0]);
     LLPC_OUTS("\n===============================================================================\n");
     LLPC_OUTS("// LLPC calculated hash results (compute pipeline)\n\n");
-    LLPC_OUTS("PIPE : " << format("0x%016" PRIX64, MetroHash::compact64(&pipelineHash)) << "\n");
+    LLPC_OUTS("PIPE : " << format("0x%016" PRIX64, MetroHash::compact64(getPipelineHash())) << "\n");
     LLPC_OUTS(format("%-4s : ", getShaderStageAbbreviation(ShaderStageCompute, true))
               << format("0x%016" PRIX64, MetroHash::compact64(moduleHash)) << "\n");
-    if (relocatableElfRequested && !buildUsingRelocatableElf) {
-      LLPC_OUTS("\nWarning: Relocatable shader compilation requested but not possible. "
-                << "Falling back to whole-pipeline compilation.\n");
-    }
     LLPC_OUTS("\n");
   }
 
@@ -1624,12 +3105,36 @@ Result Compiler::BuildComputePipeline(const ComputePipelineBuildInfo *pipelineIn
     cacheAccessor.emplace(pipelineInfo, cacheHash, getInternalCaches());
   }
 
-  ElfPackage candidateElf;
+  // The pipeline ELF is staged in a buffer from the pool, which is given back once the ELF has been copied out.
+  std::unique_ptr<ElfPackage> candidateElfBuffer = m_elfPackagePool.take();
+  auto giveBackCandidateElf = make_scope_exit([&] { m_elfPackagePool.give(std::move(candidateElfBuffer)); });
+  ElfPackage &candidateElf = *candidateElfBuffer;
+  std::shared_ptr<InFlightBuildTable::Build> inFlightBuild;
   if (!cacheAccessor || !cacheAccessor->isInCache()) {
     LLPC_OUTS("Cache miss for compute pipeline.\n");
-    ComputeContext computeContext(m_gfxIp, pipelineInfo, &pipelineHash, &cacheHash);
-    result = buildComputePipelineInternal(&computeContext, pipelineInfo, buildUsingRelocatableElf, &candidateElf,
-                                          &pipelineOut->stageCacheAccess);
+    if (result == Result::Success && m_negativeResultCache.lookUp(cacheHash, &result)) {
+      LLPC_OUTS("Compute pipeline failed to compile recently, not compiling it again.\n");
+    } else if (result == Result::Success && joinInFlightBuild(cacheHash, &result, &candidateElf, &inFlightBuild)) {
+      LLPC_OUTS("Compute pipeline was built by another thread at the same time.\n");
+      pipelineOut->pipelineCacheAccess = CacheAccessInfo::InternalCacheHit;
+    } else {
+      // Whether relocatable shader ELFs are used is decided only now, so that cache hits do not count towards
+      // -relocatable-shader-elf-limit.
+      const bool buildUsingRelocatableElf = relocatableElfRequested && canUseRelocatableComputeShaderElf(pipelineInfo);
+      if (relocatableElfRequested && !buildUsingRelocatableElf) {
+        LLPC_OUTS("Warning: Relocatable shader compilation requested but not possible. "
+                  << "Falling back to whole-pipeline compilation.\n");
+      }
+      ComputeContext computeContext(m_gfxIp, pipelineInfo, getPipelineHash(), &cacheHash);
+      computeContext.setCancelFlag(cancelFlag);
+      result = buildComputePipelineInternal(&computeContext, pipelineInfo, buildUsingRelocatableElf, &candidateElf,
+                                            &pipelineOut->stageCacheAccess);
+      pipelineOut->peakMemoryGrowth = computeContext.getPeakMemoryGrowth();
+      if (result != Result::Success)
+        m_negativeResultCache.insert(cacheHash, result);
+      if (inFlightBuild)
+        m_inFlightBuilds.complete(*inFlightBuild, result, candidateElf);
+    }
 
     if (result == Result::Success) {
       elfBin.codeSize = candidateElf.size();
@@ -1668,6 +3173,270 @@ Result Compiler::BuildComputePipeline(const ComputePipelineBuildInfo *pipelineIn
   return result;
 }
 
+// =====================================================================================================================
+// Waits for the build of the pipeline with the given hash that another thread is doing, if there is one, and gets its
+// result. Otherwise, starts a build in the table of in-flight builds, which the caller must complete once it has built
+// the pipeline.
+//
+// @param cacheHash : The cache hash of the pipeline
+// @param [out] result : Result of the other thread's build
+// @param [out] pipelineElf : The pipeline ELF of the other thread's build, if it succeeded
+// @param [out] ownBuild : The build started for the caller, if there was no other build to wait for
+// @returns : True if the pipeline was built by another thread
+bool Compiler::joinInFlightBuild(const MetroHash::Hash &cacheHash, Result *result, ElfPackage *pipelineElf,
+                                 std::shared_ptr<InFlightBuildTable::Build> *ownBuild) {
+  for (;;) {
+    bool isOwner = false;
+    std::shared_ptr<InFlightBuildTable::Build> build = m_inFlightBuilds.join(cacheHash, &isOwner);
+    if (isOwner) {
+      *ownBuild = std::move(build);
+      return false;
+    }
+    if (InFlightBuildTable::wait(*build, result, pipelineElf))
+      return true;
+    // The other build was cancelled, so join or start another one.
+  }
+}
+
+// =====================================================================================================================
+// Queues a task of the compiler on the global build scheduler, counting it as an asynchronous build, so that the
+// compiler is not destroyed before the task has run.
+//
+// @param task : Function to run
+// @param priority : Priority level of the task
+// @param key : Key of the task, so that tasks with the same key are not run at the same time
+void Compiler::submitBackgroundTask(std::function<void()> task, PipelineBuildPriority priority, uint64_t key) {
+  {
+    std::lock_guard<std::mutex> lock(m_asyncBuildMutex);
+    ++m_asyncBuildCount;
+  }
+
+  auto runTask = [this, task] {
+    task();
+
+    // The compiler may be destroyed as soon as the count drops to 0, so this must be the last access to it.
+    std::lock_guard<std::mutex> lock(m_asyncBuildMutex);
+    if (--m_asyncBuildCount == 0)
+      m_asyncBuildDone.notify_all();
+  };
+  PipelineBuildScheduler::getGlobal().submit(runTask, priority, key);
+}
+
+// =====================================================================================================================
+// Queues a pipeline build on the global build scheduler, which runs it on the global thread pool.
+//
+// @param build : Function that builds the pipeline
+// @param callback : Client's completion callback, may be null
+// @param userData : User data passed to the callback
+// @param [out] job : Handle of the submitted build
+// @param priority : Priority level of the build
+// @param key : Cache hash of the pipeline, so that builds of the same pipeline are not run at the same time
+Result Compiler::submitPipelineBuild(PipelineBuildJob::BuildFunc build, PipelineBuildCallbackFunc callback,
+                                     void *userData, IPipelineBuildJob **job, PipelineBuildPriority priority,
+                                     uint64_t key) {
+  std::shared_ptr<PipelineBuildJob> buildJob = PipelineBuildJob::create(std::move(build), callback, userData);
+  submitBackgroundTask([buildJob] { buildJob->run(); }, priority, key);
+
+  *job = &*buildJob;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Submits a graphics pipeline build to run asynchronously.
+//
+// @param pipelineInfo : Info to build this graphics pipeline
+// @param [out] pipelineOut : Output of building this graphics pipeline, valid once the build completes
+// @param callback : Optional function called on completion
+// @param userData : User data passed to the callback
+// @param [out] job : Handle of the submitted build
+// @param priority : Priority level of the build
+Result Compiler::BuildGraphicsPipelineAsync(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                            GraphicsPipelineBuildOut *pipelineOut, PipelineBuildCallbackFunc callback,
+                                            void *userData, IPipelineBuildJob **job, PipelineBuildPriority priority) {
+  if (!pipelineInfo || !pipelineOut || !job)
+    return Result::ErrorInvalidPointer;
+
+  MetroHash::Hash cacheHash =
+      PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false, UnlinkedStageCount);
+  auto build = [this, pipelineInfo, pipelineOut](const std::atomic<bool> *cancelFlag) {
+    return buildGraphicsPipeline(pipelineInfo, pipelineOut, nullptr, cancelFlag);
+  };
+  return submitPipelineBuild(build, callback, userData, job, priority, MetroHash::compact64(&cacheHash));
+}
+
+// =====================================================================================================================
+// Builds a graphics pipeline quickly, by linking relocatable shader ELFs or else by compiling it at the fast compile
+// tier, and submits an optimized whole-pipeline build of it to run in the background, unless the pipeline was found in
+// the cache.
+//
+// @param pipelineInfo : Info to build this graphics pipeline
+// @param [out] pipelineOut : Output of the fast build of this graphics pipeline
+// @param [out] optimizedPipelineOut : Output of the background build, valid once the build completes
+// @param callback : Optional function called on completion of the background build
+// @param userData : User data passed to the callback
+// @param [out] job : Handle of the background build, or nullptr if there is none
+Result Compiler::BuildGraphicsPipelineOptimizeLater(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                                    GraphicsPipelineBuildOut *pipelineOut,
+                                                    GraphicsPipelineBuildOut *optimizedPipelineOut,
+                                                    PipelineBuildCallbackFunc callback, void *userData,
+                                                    IPipelineBuildJob **job) {
+  if (!pipelineInfo || !pipelineOut || !optimizedPipelineOut || !job)
+    return Result::ErrorInvalidPointer;
+  *job = nullptr;
+
+  bool fastBuilt = false;
+  Result result =
+      buildGraphicsPipeline(pipelineInfo, pipelineOut, nullptr, nullptr, GraphicsLinkMode::FastLink, &fastBuilt);
+  if (result != Result::Success || !fastBuilt)
+    return result;
+
+  LLPC_OUTS("Submitting optimized whole-pipeline build of fast graphics pipeline.\n");
+  MetroHash::Hash cacheHash =
+      PipelineDumper::generateHashForGraphicsPipeline(pipelineInfo, true, false, UnlinkedStageCount);
+  auto build = [this, pipelineInfo, optimizedPipelineOut](const std::atomic<bool> *cancelFlag) {
+    return buildGraphicsPipeline(pipelineInfo, optimizedPipelineOut, nullptr, cancelFlag,
+                                 GraphicsLinkMode::WholePipeline);
+  };
+  return submitPipelineBuild(build, callback, userData, job, PipelineBuildPriority::Background,
+                             MetroHash::compact64(&cacheHash));
+}
+
+// =====================================================================================================================
+// Output allocator that allocates the output ELF of a build in the ElfPackage passed as the user data.
+//
+// @param instance : Unused
+// @param userData : The ElfPackage to allocate the output in
+// @param size : Size of the output ELF
+static void *VKAPI_CALL allocateInElfPackage(void *instance, void *userData, size_t size) {
+  auto elf = static_cast<ElfPackage *>(userData);
+  elf->resize(size);
+  return elf->data();
+}
+
+// =====================================================================================================================
+// Builds the relocatable ELF of the compute shader of a compute pipeline, or of a compute library, through the caches.
+//
+// @param pipelineInfo : Info of the compute pipeline or compute library
+// @param [out] elf : The relocatable ELF
+Result Compiler::buildUnlinkedComputeElf(const ComputePipelineBuildInfo *pipelineInfo, ElfPackage *elf) {
+  if (!isRelocatableShaderElfSupported(&pipelineInfo->cs, &pipelineInfo->resourceMapping))
+    return Result::Unsupported;
+
+  ComputePipelineBuildInfo unlinkedInfo = *pipelineInfo;
+  unlinkedInfo.unlinked = true;
+  unlinkedInfo.options.enableRelocatableShaderElf = true;
+  unlinkedInfo.pfnOutputAlloc = allocateInElfPackage;
+  unlinkedInfo.pInstance = nullptr;
+  unlinkedInfo.pUserData = elf;
+  ComputePipelineBuildOut unlinkedOut = {};
+  return buildComputePipeline(&unlinkedInfo, &unlinkedOut, nullptr, nullptr);
+}
+
+// =====================================================================================================================
+// Gets the relocatable ELF of a compute library from the compute library cache, building it if it is not there.
+//
+// @param libraryInfo : Info of the compute library
+// @param [out] elf : The relocatable ELF of the compute library
+Result Compiler::getComputeLibraryElf(const ComputePipelineBuildInfo *libraryInfo,
+                                      std::shared_ptr<const ElfPackage> *elf) {
+  MetroHash::Hash cacheHash = PipelineDumper::generateHashForComputePipeline(libraryInfo, true, false);
+  *elf = m_computeLibraryCache.lookUp(cacheHash);
+  if (*elf) {
+    LLPC_OUTS("Compute library found in the compute library cache.\n");
+    return Result::Success;
+  }
+
+  auto libraryElf = std::make_shared<ElfPackage>();
+  Result result = buildUnlinkedComputeElf(libraryInfo, &*libraryElf);
+  if (result != Result::Success)
+    return result;
+  m_computeLibraryCache.insert(cacheHash, libraryElf);
+  *elf = std::move(libraryElf);
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Builds a compute pipeline whose compute shader calls functions of compute libraries, by linking the relocatable ELF
+// of the compute shader with those of the libraries. The libraries are kept in the compute library cache, so that a
+// library is compiled once and linked into each pipeline that calls it.
+//
+// @param pipelineInfo : Info to build this compute pipeline
+// @param libraryInfos : Infos of the compute libraries that the compute shader calls
+// @param libraryCount : Count of compute libraries
+// @param [out] pipelineOut : Output of building this compute pipeline
+Result Compiler::BuildComputePipelineWithLibraries(const ComputePipelineBuildInfo *pipelineInfo,
+                                                   const ComputePipelineBuildInfo *const *libraryInfos,
+                                                   unsigned libraryCount, ComputePipelineBuildOut *pipelineOut) {
+  if (!pipelineInfo || !pipelineOut || (libraryCount != 0 && !libraryInfos))
+    return Result::ErrorInvalidPointer;
+  if (!pipelineInfo->pfnOutputAlloc)
+    return Result::ErrorInvalidPointer;
+
+  ElfPackage computeElf;
+  Result result = buildUnlinkedComputeElf(pipelineInfo, &computeElf);
+  if (result != Result::Success)
+    return result;
+  StringRef elf[enumCount<UnlinkedShaderStage>()];
+  elf[UnlinkedStageCompute] = computeElf.str();
+
+  SmallVector<std::shared_ptr<const ElfPackage>, 4> libraryElfs(libraryCount);
+  SmallVector<StringRef, 4> libraryElfRefs;
+  for (unsigned i = 0; i != libraryCount; ++i) {
+    if (!libraryInfos[i])
+      return Result::ErrorInvalidPointer;
+    result = getComputeLibraryElf(libraryInfos[i], &libraryElfs[i]);
+    if (result != Result::Success)
+      return result;
+    libraryElfRefs.push_back(StringRef(libraryElfs[i]->data(), libraryElfs[i]->size()));
+  }
+
+  MetroHash::Hash cacheHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, true, false);
+  MetroHash::Hash pipelineHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, false, false);
+  ComputeContext computeContext(m_gfxIp, pipelineInfo, &pipelineHash, &cacheHash);
+
+  Context *context = acquireContext();
+  context->attachPipelineContext(&computeContext);
+  LLPC_OUTS("Linking compute pipeline with " << libraryCount << " compute libraries.\n");
+  bool hasError = false;
+  context->setDiagnosticHandler(std::make_unique<LlpcDiagnosticHandler>(&hasError));
+  ElfPackage pipelineElf;
+  hasError |= !linkRelocatableShaderElf(elf, &pipelineElf, context, false, libraryElfRefs);
+  context->setDiagnosticHandler(nullptr);
+  releaseContext(context);
+  if (hasError)
+    return Result::ErrorInvalidShader;
+
+  void *allocBuf = pipelineInfo->pfnOutputAlloc(pipelineInfo->pInstance, pipelineInfo->pUserData, pipelineElf.size());
+  if (!allocBuf)
+    return Result::ErrorOutOfMemory;
+  memcpy(allocBuf, pipelineElf.data(), pipelineElf.size());
+  pipelineOut->pipelineBin.codeSize = pipelineElf.size();
+  pipelineOut->pipelineBin.pCode = allocBuf;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Submits a compute pipeline build to run asynchronously.
+//
+// @param pipelineInfo : Info to build this compute pipeline
+// @param [out] pipelineOut : Output of building this compute pipeline, valid once the build completes
+// @param callback : Optional function called on completion
+// @param userData : User data passed to the callback
+// @param [out] job : Handle of the submitted build
+// @param priority : Priority level of the build
+Result Compiler::BuildComputePipelineAsync(const ComputePipelineBuildInfo *pipelineInfo,
+                                           ComputePipelineBuildOut *pipelineOut, PipelineBuildCallbackFunc callback,
+                                           void *userData, IPipelineBuildJob **job, PipelineBuildPriority priority) {
+  if (!pipelineInfo || !pipelineOut || !job)
+    return Result::ErrorInvalidPointer;
+
+  MetroHash::Hash cacheHash = PipelineDumper::generateHashForComputePipeline(pipelineInfo, true, false);
+  auto build = [this, pipelineInfo, pipelineOut](const std::atomic<bool> *cancelFlag) {
+    return buildComputePipeline(pipelineInfo, pipelineOut, nullptr, cancelFlag);
+  };
+  return submitPipelineBuild(build, callback, userData, job, priority, MetroHash::compact64(&cacheHash));
+}
+
 // =====================================================================================================================
 // Builds hash code from compilation-options
 //
@@ -1679,6 +3448,13 @@ MetroHash::Hash Compiler::generateHashForCompileOptions(unsigned optionCount, co
                                        cl::EnablePipelineDump.ArgStr,
                                        cl::ShaderCacheFileDir.ArgStr,
                                        cl::ShaderCacheMode.ArgStr,
+                                       cl::ShaderCacheMaxMemorySize.ArgStr,
+                                       cl::ShaderCacheMaxFileSize.ArgStr,
+                                       "shader-cache-shared-file",
+                                       "shader-cache-evict-lfu",
+                                       "shader-cache-compress",
+                                       "shader-cache-segmented",
+                                       "negative-cache-ttl",
                                        cl::EnableOuts.ArgStr,
                                        cl::EnableErrs.ArgStr,
                                        cl::LogFileDbgs.ArgStr,
@@ -1731,11 +3507,13 @@ Result Compiler::validatePipelineShaderInfo(const PipelineShaderInfo *shaderInfo
   const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo->pModuleData);
   if (moduleData) {
     if (moduleData->binType == BinaryType::Spirv) {
-      auto spirvBin = &moduleData->binCode;
       if (shaderInfo->pEntryTarget) {
-        unsigned stageMask = ShaderModuleHelper::getStageMaskFromSpirvBinary(spirvBin, shaderInfo->pEntryTarget);
+        unsigned stageMask = ShaderModuleHelper::getStageMaskFromModuleData(moduleData, shaderInfo->pEntryTarget);
 
-        if ((stageMask & shaderStageToMask(shaderStage)) == 0) {
+        // A compute library has no entry-point, and all its functions are compiled.
+        const bool isComputeLibrary =
+            shaderStage == ShaderStageCompute && ShaderModuleHelper::isLibraryModuleData(moduleData);
+        if ((stageMask & shaderStageToMask(shaderStage)) == 0 && !isComputeLibrary) {
           LLPC_ERRS("Fail to find entry-point " << shaderInfo->pEntryTarget << " for "
                                                 << getShaderStageName(shaderStage) << " shader\n");
           result = Result::ErrorInvalidShader;
@@ -1806,11 +3584,16 @@ Context *Compiler::acquireContext() const {
     GfxIpVersion gfxIpVersion = context->getGfxIpVersion();
 
     if (!context->isInUse() && gfxIpVersion == m_gfxIp) {
-      // Free up context if it is being used too many times to avoid consuming too much memory.
+      // Replace the context if it has accumulated too much memory, or if it has been used too many times. The
+      // LLVMContext never frees types and constants, so this is the only way to get that memory back. The new
+      // context reuses the target machine, which does not depend on the LLVMContext, so replacing is cheap.
       int contextReuseLimit = cl::ContextReuseLimit.getValue();
-      if (contextReuseLimit > 0 && context->getUseCount() > contextReuseLimit) {
+      uint64_t contextResetSize = uint64_t(cl::ContextResetSize.getValue()) * 1024;
+      if ((contextResetSize > 0 && context->getTranslatedSpirvSize() > contextResetSize) ||
+          (contextReuseLimit > 0 && context->getUseCount() > contextReuseLimit)) {
+        std::unique_ptr<TargetMachine> targetMachine = context->takeTargetMachine();
         delete context;
-        context = new Context(m_gfxIp);
+        context = new Context(m_gfxIp, std::move(targetMachine));
       }
       freeContext = context;
       break;
@@ -1835,6 +3618,12 @@ Context *Compiler::acquireContext() const {
 // @param passMgr : Pass manager
 // @param [in/out] module : Module
 bool Compiler::runPasses(lgc::LegacyPassManager *passMgr, Module *module) const {
+  // Let more urgent asynchronous builds run first, and do not start any more passes for a build that has been
+  // cancelled.
+  PipelineBuildScheduler::yield();
+  if (static_cast<Context &>(module->getContext()).isCancelled())
+    return false;
+
   bool success = false;
 #if LLPC_ENABLE_EXCEPTION
   try
@@ -1857,6 +3646,12 @@ bool Compiler::runPasses(lgc::LegacyPassManager *passMgr, Module *module) const
 // @param passMgr : Pass manager
 // @param [in/out] module : Module
 bool Compiler::runPasses(lgc::PassManager *passMgr, Module *module) const {
+  // Let more urgent asynchronous builds run first, and do not start any more passes for a build that has been
+  // cancelled.
+  PipelineBuildScheduler::yield();
+  if (static_cast<Context &>(module->getContext()).isCancelled())
+    return false;
+
   bool success = false;
 #if LLPC_ENABLE_EXCEPTION
   try
@@ -1886,9 +3681,14 @@ void Compiler::releaseContext(Context *context) const {
 // =====================================================================================================================
 // Builds hash code from input context for per shader stage cache
 //
+// Without the per-stage hashes of in/out usage, which are only known once the middle-end has collected the resource
+// usage, the hash of each half is instead built from the shader info of every stage of the pipeline, as the shaders of
+// the other half determine the in/out usage of the interface between the halves. That is what allows the cache to be
+// checked before the front-end runs.
+//
 // @param context : Acquired context
 // @param stageMask : Shader stage mask (NOTE: This is a LGC shader stage mask passed by middle-end)
-// @param stageHashes : Per-stage hash of in/out usage
+// @param stageHashes : Per-stage hash of in/out usage, or empty to build the hashes from the shader info alone
 // @param [out] fragmentHash : Hash code of fragment shader
 // @param [out] nonFragmentHash : Hash code of all non-fragment shader
 void Compiler::buildShaderCacheHash(Context *context, unsigned stageMask, ArrayRef<ArrayRef<uint8_t>> stageHashes,
@@ -1897,9 +3697,25 @@ void Compiler::buildShaderCacheHash(Context *context, unsigned stageMask, ArrayR
   MetroHash64 nonFragmentHasher;
   auto pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(context->getPipelineBuildInfo());
   auto pipelineOptions = context->getPipelineContext()->getPipelineOptions();
+  bool hashInOutUsage = !stageHashes.empty();
+  fragmentHasher.Update(hashInOutUsage);
+  nonFragmentHasher.Update(hashInOutUsage);
 
   // Build hash per shader stage
   for (ShaderStage stage : gfxShaderStages()) {
+    if (!hashInOutUsage && (context->getShaderStageMask() & shaderStageToMask(stage))) {
+      // Add the shader info of each stage of the pipeline to the hash of the other half.
+      MetroHash64 interfaceHasher;
+      PipelineDumper::updateHashForPipelineShaderInfo(stage, context->getPipelineShaderInfo(stage), true,
+                                                      &interfaceHasher, false);
+      MetroHash::Hash interfaceHash = {};
+      interfaceHasher.Finalize(interfaceHash.bytes);
+      if (stage == ShaderStageFragment)
+        nonFragmentHasher.Update(MetroHash::compact64(&interfaceHash));
+      else
+        fragmentHasher.Update(MetroHash::compact64(&interfaceHash));
+    }
+
     if ((stageMask & getLgcShaderStageMask(stage)) == 0)
       continue;
 
@@ -1908,12 +3724,20 @@ void Compiler::buildShaderCacheHash(Context *context, unsigned stageMask, ArrayR
 
     // Update common shader info
     PipelineDumper::updateHashForPipelineShaderInfo(stage, shaderInfo, true, &hasher, false);
-    hasher.Update(pipelineInfo->iaState.deviceIndex);
+    if (PipelineDumper::isDeviceIndexUsed(shaderInfo))
+      hasher.Update(pipelineInfo->iaState.deviceIndex);
 
-    PipelineDumper::updateHashForResourceMappingInfo(context->getResourceMapping(), &hasher, stage);
+    // Only the descriptor sets that the shader module is decorated with are hashed, so that a change to the layout of
+    // other sets does not miss the cache for the stage.
+    uint64_t descriptorSetMask = UINT64_MAX;
+    auto moduleDataEx = reinterpret_cast<const ShaderModuleDataEx *>(shaderInfo->pModuleData);
+    if (moduleDataEx && moduleDataEx->common.binType == BinaryType::Spirv && moduleDataEx->spirvSummary.idBound != 0)
+      descriptorSetMask = moduleDataEx->spirvSummary.descriptorSetMask;
+    PipelineDumper::updateHashForResourceMappingInfo(context->getResourceMapping(), &hasher, stage, descriptorSetMask);
 
     // Update input/output usage (provided by middle-end caller of this callback).
-    hasher.Update(stageHashes[getLgcShaderStage(stage)].data(), stageHashes[getLgcShaderStage(stage)].size());
+    if (hashInOutUsage)
+      hasher.Update(stageHashes[getLgcShaderStage(stage)].data(), stageHashes[getLgcShaderStage(stage)].size());
 
     // Update vertex input state
     if (stage == ShaderStageVertex)
@@ -1955,11 +3779,14 @@ void Compiler::buildShaderCacheHash(Context *context, unsigned stageMask, ArrayR
 // =====================================================================================================================
 // Link relocatable shader elf file into a pipeline elf file and apply relocations.  Returns true if successful.
 //
-// @param shaderElfs : An array of pipeline elf packages, indexed by stage, containing relocatable elf.
-//                     TODO: This has an implicit length of ShaderStageNativeStageCount. Use ArrayRef instead.
+// @param shaderElfs : The relocatable ELF of each unlinked stage, empty for a stage that is not in the pipeline. They
+//                     are read in place, so can be views of cache entries, which must stay valid until the link.
 // @param [out] pipelineElf : Elf package containing the pipeline elf
 // @param context : Acquired context
-bool Compiler::linkRelocatableShaderElf(ElfPackage *shaderElfs, ElfPackage *pipelineElf, Context *context) {
+// @param glueShadersOnly : Stop once the glue shaders are in the caches, without linking
+// @param libraryElfs : Relocatable ELFs of the compute libraries that the shaders call
+bool Compiler::linkRelocatableShaderElf(ArrayRef<StringRef> shaderElfs, ElfPackage *pipelineElf, Context *context,
+                                        bool glueShadersOnly, ArrayRef<StringRef> libraryElfs) {
   assert(!context->getPipelineContext()->isUnlinked() && "Not supposed to link this pipeline.");
 
   // Set up middle-end objects, including setting up pipeline state.
@@ -1971,19 +3798,23 @@ bool Compiler::linkRelocatableShaderElf(ElfPackage *shaderElfs, ElfPackage *pipe
   SmallVector<MemoryBufferRef, 3> elfs;
   for (auto stage : enumRange<UnlinkedShaderStage>()) {
     if (!shaderElfs[stage].empty())
-      elfs.push_back(MemoryBufferRef(shaderElfs[stage].str(), getUnlinkedShaderStageName(stage)));
+      elfs.push_back(MemoryBufferRef(shaderElfs[stage], getUnlinkedShaderStageName(stage)));
   }
-  std::unique_ptr<ElfLinker> elfLinker(pipeline->createElfLinker(elfs));
+  for (StringRef libraryElf : libraryElfs)
+    elfs.push_back(MemoryBufferRef(libraryElf, "library"));
+  ElfLinker *elfLinker = context->getElfLinker(&*pipeline, elfs);
 
   if (elfLinker->fragmentShaderUsesMappedBuiltInInputs()) {
     LLPC_OUTS("Failed to link relocatable shaders because FS uses builtin inputs.");
     return false;
   }
 
-  setGlueBinaryBlobsInLinker(elfLinker.get(), context, this);
-  // Do the link.
-  raw_svector_ostream outStream(*pipelineElf);
-  if (!elfLinker->link(outStream)) {
+  setGlueBinaryBlobsInLinker(elfLinker, context);
+  if (glueShadersOnly)
+    return true;
+
+  // Do the link, writing directly into the pipeline ELF.
+  if (!elfLinker->link(*pipelineElf)) {
     // Link failed in a recoverable way.
     // TODO: Action this failure by doing a full pipeline compile.
     report_fatal_error("Link failed; need full pipeline compile instead: " + pipeline->getLastError());
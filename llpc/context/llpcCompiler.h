@@ -37,6 +37,13 @@
 #include "vkgcElfReader.h"
 #include "vkgcMetroHash.h"
 #include "lgc/CommonDefs.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 
 namespace llvm {
 
@@ -46,6 +53,7 @@ class Module;
 
 namespace lgc {
 
+class ElfLinker;
 class LegacyPassManager;
 class PassManager;
 
@@ -61,6 +69,7 @@ class Compiler;
 class ComputeContext;
 class Context;
 class GraphicsContext;
+class NonFragmentElf;
 
 // =====================================================================================================================
 // Object to manage checking and updating shader cache for graphics pipeline.
@@ -68,6 +77,9 @@ class GraphicsShaderCacheChecker {
 public:
   GraphicsShaderCacheChecker(Compiler *compiler, Context *context) : m_compiler(compiler), m_context(context) {}
 
+  // Check shader caches before the front-end runs, returning mask of which shader stages are left to compile.
+  unsigned checkEarly(unsigned stageMask, llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses);
+
   // Check shader caches, returning mask of which shader stages we want to keep in this compile.
   unsigned check(const llvm::Module *module, unsigned stageMask, llvm::ArrayRef<llvm::ArrayRef<uint8_t>> stageHashes,
                  llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses);
@@ -81,6 +93,11 @@ private:
   Context *m_context;
   llvm::Optional<CacheAccessor> m_nonFragmentCacheAccessor;
   llvm::Optional<CacheAccessor> m_fragmentCacheAccessor;
+  // Accessors of the early lookups that missed, to be updated with the compiled halves as well
+  llvm::Optional<CacheAccessor> m_earlyNonFragmentCacheAccessor;
+  llvm::Optional<CacheAccessor> m_earlyFragmentCacheAccessor;
+
+  MetroHash::Hash m_nonFragmentHash = {}; // Cache hash of the non-fragment stages
 
   // New ICache
   Vkgc::EntryHandle m_nonFragmentEntry;
@@ -88,6 +105,144 @@ private:
   Vkgc::EntryHandle m_fragmentEntry;
 };
 
+// =====================================================================================================================
+// In-process cache of the most recently used glue shader ELFs, shared by all the pipelines built by a compiler. It is
+// checked before the ICaches and shader caches, as the set of distinct glue shaders is small and repeats heavily.
+class GlueShaderCache {
+public:
+  // Gets the ELF of the glue shader with the given hash, making it the most recently used one.
+  bool lookUp(const MetroHash::Hash &hash, std::string *elf);
+
+  // Adds the ELF of the glue shader with the given hash, evicting the least recently used one if the cache is full.
+  void insert(const MetroHash::Hash &hash, llvm::StringRef elf);
+
+private:
+  struct Entry {
+    MetroHash::Hash hash; // Hash of the glue shader
+    std::string elf;      // ELF of the glue shader
+  };
+
+  std::mutex m_mutex;         // Mutex for m_entries
+  std::list<Entry> m_entries; // Entries, the most recently used first
+};
+
+// =====================================================================================================================
+// In-process cache of the most recently used non-fragment halves of graphics pipelines, with their PAL metadata
+// decoded, shared by all the pipelines built by a compiler. It saves decoding the metadata again when a non-fragment
+// half from the shader cache is merged with a succession of different fragment halves. An entry is taken out of the
+// cache while a fragment half is merged into it, then put back.
+class NonFragmentElfCache {
+public:
+  // Takes the non-fragment half with the given hash out of the cache, if it is there.
+  std::unique_ptr<NonFragmentElf> take(const MetroHash::Hash &hash);
+
+  // Puts the non-fragment half with the given hash in the cache as the most recently used one, evicting the least
+  // recently used one if the cache is full.
+  void insert(const MetroHash::Hash &hash, std::unique_ptr<NonFragmentElf> elf);
+
+private:
+  struct Entry {
+    MetroHash::Hash hash;                // Cache hash of the non-fragment stages
+    std::unique_ptr<NonFragmentElf> elf; // Non-fragment half
+  };
+
+  std::mutex m_mutex;         // Mutex for m_entries
+  std::list<Entry> m_entries; // Entries, the most recently used first
+};
+
+// =====================================================================================================================
+// In-process cache of the most recently used relocatable ELFs of compute libraries, shared by all the compute pipelines
+// built by a compiler that call them. A library is compiled once, and then linked into each pipeline that calls it. The
+// ELFs are shared rather than copied out, as a library can be large.
+class ComputeLibraryCache {
+public:
+  // Gets the ELF of the compute library with the given hash, making it the most recently used one.
+  std::shared_ptr<const ElfPackage> lookUp(const MetroHash::Hash &hash);
+
+  // Adds the ELF of the compute library with the given hash, evicting the least recently used one if the cache is full.
+  void insert(const MetroHash::Hash &hash, std::shared_ptr<const ElfPackage> elf);
+
+private:
+  struct Entry {
+    MetroHash::Hash hash;                  // Cache hash of the compute library
+    std::shared_ptr<const ElfPackage> elf; // Relocatable ELF of the compute library
+  };
+
+  std::mutex m_mutex;         // Mutex for m_entries
+  std::list<Entry> m_entries; // Entries, the most recently used first
+};
+
+// =====================================================================================================================
+// In-process cache of the pipelines that recently failed to compile, shared by all the pipelines built by a compiler.
+// A failure is remembered for the time given by -negative-cache-ttl, during which building the same pipeline again
+// returns the same result straight away instead of compiling it again. Only failures that compiling again would repeat
+// are remembered, not cancellations or running out of memory.
+class NegativeResultCache {
+public:
+  // Gets the result of the failed build of the pipeline with the given hash, if it has not expired.
+  bool lookUp(const MetroHash::Hash &hash, Result *result);
+
+  // Remembers the result of a failed build of the pipeline with the given hash, if it is one that would be repeated.
+  void insert(const MetroHash::Hash &hash, Result result);
+
+private:
+  struct Entry {
+    MetroHash::Hash hash;                         // Cache hash of the pipeline
+    Result result;                                // Result of building the pipeline
+    std::chrono::steady_clock::time_point expiry; // Time after which the pipeline is built again
+  };
+
+  std::mutex m_mutex;         // Mutex for m_entries
+  std::list<Entry> m_entries; // Entries, the most recently failed first
+};
+
+// =====================================================================================================================
+// In-process table of the pipeline builds that are in progress, shared by all the pipelines built by a compiler. When
+// a pipeline is requested by several threads at the same time, the first one builds it, and the others wait for it and
+// share the resulting ELF, whether or not the client provided a cache that can do that.
+class InFlightBuildTable {
+public:
+  // The build of one pipeline, shared by the thread that builds it and the threads that wait for it
+  struct Build {
+    MetroHash::Hash hash;                     // Cache hash of the pipeline
+    std::mutex mutex;                         // Mutex for complete, result and elf
+    std::condition_variable doneCondition;    // Signalled when the build completes
+    bool complete = false;                    // Whether the build has completed
+    Result result = Result::ErrorUnavailable; // Result of the build
+    ElfPackage elf;                           // The pipeline ELF, if the build succeeded
+  };
+
+  // Joins the build of the pipeline with the given hash, starting it if there is none in progress.
+  std::shared_ptr<Build> join(const MetroHash::Hash &hash, bool *isOwner);
+
+  // Completes a build started by join, waking the threads that wait for it.
+  void complete(Build &build, Result result, const ElfPackage &elf);
+
+  // Waits for a build started by another thread, and gets its result and ELF.
+  static bool wait(Build &build, Result *result, ElfPackage *elf);
+
+private:
+  std::mutex m_mutex;                         // Mutex for m_builds
+  std::list<std::shared_ptr<Build>> m_builds; // Builds in progress
+};
+
+// =====================================================================================================================
+// Pool of the buffers that pipeline builds stage their pipeline ELFs in, shared by all the pipelines built by a
+// compiler. A buffer keeps its capacity when it is given back, so a later build writes its ELF into a buffer that has
+// already grown to the size of a typical pipeline ELF, rather than reallocating and copying it as it grows.
+class ElfPackagePool {
+public:
+  // Takes an empty buffer out of the pool, or creates one if the pool is empty.
+  std::unique_ptr<ElfPackage> take();
+
+  // Gives a buffer back to the pool, unless the pool is full or the buffer is too large to keep.
+  void give(std::unique_ptr<ElfPackage> elf);
+
+private:
+  std::mutex m_mutex;                             // Mutex for m_elfs
+  std::vector<std::unique_ptr<ElfPackage>> m_elfs; // Buffers in the pool
+};
+
 // =====================================================================================================================
 // Represents LLPC pipeline compiler.
 class Compiler : public ICompiler {
@@ -108,6 +263,44 @@ public:
 
   virtual Result BuildComputePipeline(const ComputePipelineBuildInfo *pipelineInfo,
                                       ComputePipelineBuildOut *pipelineOut, void *pipelineDumpFile = nullptr);
+
+  virtual Result BuildGraphicsPipelineAsync(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                            GraphicsPipelineBuildOut *pipelineOut, PipelineBuildCallbackFunc callback,
+                                            void *userData, IPipelineBuildJob **job,
+                                            PipelineBuildPriority priority = PipelineBuildPriority::Normal);
+
+  virtual Result BuildComputePipelineAsync(const ComputePipelineBuildInfo *pipelineInfo,
+                                           ComputePipelineBuildOut *pipelineOut, PipelineBuildCallbackFunc callback,
+                                           void *userData, IPipelineBuildJob **job,
+                                           PipelineBuildPriority priority = PipelineBuildPriority::Normal);
+
+  virtual Result PrecompileGlueShaders(const GraphicsPipelineBuildInfo *const *pipelineInfos, unsigned pipelineCount);
+
+  virtual Result BuildGraphicsPipelineLibrary(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                              Vkgc::UnlinkedShaderStage part, GraphicsPipelineBuildOut *pipelineOut);
+
+  virtual Result LinkGraphicsPipelineLibraries(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                               const BinaryData *libraries, unsigned libraryCount,
+                                               GraphicsPipelineBuildOut *pipelineOut);
+
+  virtual Result BuildGraphicsPipelineOptimizeLater(const GraphicsPipelineBuildInfo *pipelineInfo,
+                                                    GraphicsPipelineBuildOut *pipelineOut,
+                                                    GraphicsPipelineBuildOut *optimizedPipelineOut,
+                                                    PipelineBuildCallbackFunc callback, void *userData,
+                                                    IPipelineBuildJob **job);
+
+  virtual Result BuildComputePipelineWithLibraries(const ComputePipelineBuildInfo *pipelineInfo,
+                                                   const ComputePipelineBuildInfo *const *libraryInfos,
+                                                   unsigned libraryCount, ComputePipelineBuildOut *pipelineOut);
+
+  virtual Result EstimatePipelineCost(const GraphicsPipelineBuildInfo *pipelineInfo, PipelineCostEstimate *estimate);
+
+  virtual Result EstimatePipelineCost(const ComputePipelineBuildInfo *pipelineInfo, PipelineCostEstimate *estimate);
+
+  virtual void GetCacheStats(CacheStats *stats);
+
+  virtual void ResetCacheStats();
+
   Result buildGraphicsPipelineInternal(GraphicsContext *graphicsContext,
                                        llvm::ArrayRef<const PipelineShaderInfo *> shaderInfo,
                                        bool buildingRelocatableElf, ElfPackage *pipelineElf,
@@ -119,7 +312,8 @@ public:
 
   Result buildPipelineWithRelocatableElf(Context *context, llvm::ArrayRef<const PipelineShaderInfo *> shaderInfo,
                                          ElfPackage *pipelineElf,
-                                         llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses);
+                                         llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses,
+                                         bool glueShadersOnly = false);
 
   Result buildPipelineInternal(Context *context, llvm::ArrayRef<const PipelineShaderInfo *> shaderInfo, bool unlinked,
                                ElfPackage *pipelineElf, llvm::MutableArrayRef<CacheAccessInfo> stageCacheAccesses);
@@ -142,6 +336,10 @@ public:
 
   CachePair getInternalCaches() { return {m_cache, m_shaderCache.get()}; }
 
+  GlueShaderCache &getGlueShaderCache() { return m_glueShaderCache; }
+
+  NonFragmentElfCache &getNonFragmentElfCache() { return m_nonFragmentElfCache; }
+
 private:
   Compiler() = delete;
   Compiler(const Compiler &) = delete;
@@ -152,12 +350,43 @@ private:
   Context *acquireContext() const;
   void releaseContext(Context *context) const;
 
+  // How buildGraphicsPipeline builds a graphics pipeline that is not in the cache
+  enum class GraphicsLinkMode {
+    Default,      // Link relocatable shader ELFs if the pipeline options request it and it is possible
+    FastLink,     // Link relocatable shader ELFs if it is possible, else compile at the fast compile tier, keeping the
+                  //  pipeline out of the cache
+    WholePipeline // Build the whole pipeline, whatever the pipeline options request
+  };
+
+  Result buildGraphicsPipeline(const GraphicsPipelineBuildInfo *pipelineInfo, GraphicsPipelineBuildOut *pipelineOut,
+                               void *pipelineDumpFile, const std::atomic<bool> *cancelFlag,
+                               GraphicsLinkMode linkMode = GraphicsLinkMode::Default, bool *fastBuilt = nullptr);
+  Result buildComputePipeline(const ComputePipelineBuildInfo *pipelineInfo, ComputePipelineBuildOut *pipelineOut,
+                              void *pipelineDumpFile, const std::atomic<bool> *cancelFlag);
+  Result submitPipelineBuild(std::function<Result(const std::atomic<bool> *cancelFlag)> build,
+                             PipelineBuildCallbackFunc callback, void *userData, IPipelineBuildJob **job,
+                             PipelineBuildPriority priority, uint64_t key);
+  void submitBackgroundTask(std::function<void()> task, PipelineBuildPriority priority, uint64_t key);
+  void submitShaderModulePreLowering(const Vkgc::ShaderModuleDataEx *moduleDataEx);
+  Result preLowerShaderStage(const ShaderModuleData *moduleData, ShaderStage stage, const char *entryName);
+
   bool runPasses(lgc::LegacyPassManager *passMgr, llvm::Module *module) const;
   bool runPasses(lgc::PassManager *passMgr, llvm::Module *module) const;
-  bool linkRelocatableShaderElf(ElfPackage *shaderElfs, ElfPackage *pipelineElf, Context *context);
+  Result translateAndLowerStagesSeparately(Context *context, llvm::ArrayRef<const PipelineShaderInfo *> shaderInfo,
+                                           llvm::MutableArrayRef<llvm::Module *> modules, unsigned *stageSkipMask,
+                                           bool *hasError);
+  bool linkRelocatableShaderElf(llvm::ArrayRef<llvm::StringRef> shaderElfs, ElfPackage *pipelineElf, Context *context,
+                                bool glueShadersOnly = false, llvm::ArrayRef<llvm::StringRef> libraryElfs = {});
+  Result buildUnlinkedComputeElf(const ComputePipelineBuildInfo *pipelineInfo, ElfPackage *elf);
+  Result getComputeLibraryElf(const ComputePipelineBuildInfo *libraryInfo, std::shared_ptr<const ElfPackage> *elf);
+  void setGlueBinaryBlobsInLinker(lgc::ElfLinker *elfLinker, Context *context);
   bool canUseRelocatableGraphicsShaderElf(const llvm::ArrayRef<const PipelineShaderInfo *> &shaderInfo,
                                           const GraphicsPipelineBuildInfo *pipelineInfo);
   bool canUseRelocatableComputeShaderElf(const ComputePipelineBuildInfo *pipelineInfo);
+  bool joinInFlightBuild(const MetroHash::Hash &cacheHash, Result *result, ElfPackage *pipelineElf,
+                         std::shared_ptr<InFlightBuildTable::Build> *ownBuild);
+  double calibrateCompileTime(double modelCompileTime);
+  void recordCompileTime(double modelCompileTime, double compileTime);
 
   std::vector<std::string> m_options;           // Compilation options
   MetroHash::Hash m_optionHash;                 // Hash code of compilation options
@@ -169,6 +398,19 @@ private:
   static llvm::sys::Mutex m_contextPoolMutex;   // Mutex for context pool access
   static std::vector<Context *> *m_contextPool; // Context pool
   unsigned m_relocatablePipelineCompilations;   // The number of pipelines compiled using relocatable shader elf
+  std::mutex m_asyncBuildMutex;                 // Mutex for m_asyncBuildCount
+  std::condition_variable m_asyncBuildDone;     // Signalled when m_asyncBuildCount drops to 0
+  unsigned m_asyncBuildCount = 0;               // The number of asynchronous builds queued or running
+  GlueShaderCache m_glueShaderCache;            // Most recently used glue shader ELFs
+  NonFragmentElfCache m_nonFragmentElfCache;    // Most recently used decoded non-fragment halves
+  ComputeLibraryCache m_computeLibraryCache;    // Most recently used compute library ELFs
+  NegativeResultCache m_negativeResultCache;    // Pipelines that recently failed to compile
+  InFlightBuildTable m_inFlightBuilds;          // Pipelines being built
+  ElfPackagePool m_elfPackagePool;              // Buffers to stage pipeline ELFs in
+  std::mutex m_compileTimeMutex;                // Mutex for the compile time totals
+  double m_modelCompileTimeTotal = 0;           // Total compile time the cost model estimated for built pipelines
+  double m_compileTimeTotal = 0;                // Total measured compile time of the same pipelines
+  unsigned m_compileTimeSamples = 0;            // The number of pipeline compiles in the totals
 };
 
 // Convert front-end LLPC shader stage to middle-end LGC shader stage
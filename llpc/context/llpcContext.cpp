@@ -30,19 +30,25 @@
  */
 #include "llpcContext.h"
 #include "SPIRVInternal.h"
+#include "SPIRVTypeCache.h"
 #include "llpcCompiler.h"
 #include "llpcDebug.h"
 #include "llpcPipelineContext.h"
 #include "llpcShaderCache.h"
 #include "llpcShaderCacheManager.h"
+#include "llpcSpirvLower.h"
 #include "vkgcMetroHash.h"
 #include "lgc/Builder.h"
+#include "lgc/ElfLinker.h"
 #include "lgc/LgcContext.h"
+#include "lgc/PassManager.h"
+#include "lgc/Pipeline.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/Bitstream/BitstreamReader.h"
 #include "llvm/Bitstream/BitstreamWriter.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
@@ -62,7 +68,9 @@ namespace Llpc {
 // =====================================================================================================================
 //
 // @param gfxIp : Graphics IP version info
-Context::Context(GfxIpVersion gfxIp) : LLVMContext(), m_gfxIp(gfxIp) {
+// @param targetMachine : Optional target machine taken from a context that this one replaces, for reuse
+Context::Context(GfxIpVersion gfxIp, std::unique_ptr<TargetMachine> targetMachine)
+    : LLVMContext(), m_gfxIp(gfxIp), m_targetMachine(std::move(targetMachine)) {
   reset();
 }
 
@@ -83,7 +91,8 @@ LgcContext *Context::getLgcContext() {
   if (!m_builderContext) {
     // First time: Create the LgcContext.
     std::string gpuName = LgcContext::getGpuNameString(m_gfxIp.major, m_gfxIp.minor, m_gfxIp.stepping);
-    m_builderContext.reset(LgcContext::Create(*this, gpuName, PAL_CLIENT_INTERFACE_MAJOR_VERSION));
+    m_builderContext.reset(
+        LgcContext::Create(*this, gpuName, PAL_CLIENT_INTERFACE_MAJOR_VERSION, m_targetMachine.release()));
     if (!m_builderContext)
       report_fatal_error(Twine("Unknown target '") + Twine(gpuName) + Twine("'"));
   }
@@ -91,7 +100,122 @@ LgcContext *Context::getLgcContext() {
 }
 
 // =====================================================================================================================
-// Loads library from external LLVM library.
+// Get (create if necessary) the cache of the types translated from SPIR-V into this context. It lives as long as the
+// context, so that a reused context translates the struct types that shaders commonly share only once.
+SPIRV::SPIRVTypeCache &Context::getSpirvTypeCache() {
+  if (!m_spirvTypeCache)
+    m_spirvTypeCache = std::make_unique<SPIRV::SPIRVTypeCache>();
+  return *m_spirvTypeCache;
+}
+
+// =====================================================================================================================
+// Take the target machine out of this context, for a new context that replaces this one to reuse. The context must
+// not be used other than to destroy it after this.
+std::unique_ptr<TargetMachine> Context::takeTargetMachine() {
+  if (m_builderContext)
+    return std::unique_ptr<TargetMachine>(m_builderContext->takeTargetMachine());
+  return std::move(m_targetMachine);
+}
+
+// =====================================================================================================================
+// Get an ELF linker for the given pipeline and ELFs. The linker (and the buffers it keeps) is reused from this
+// context's previous link, as a pooled context is only used by one compile at a time.
+//
+// @param pipeline : Pipeline whose state is used for the link
+// @param elfs : Array of unlinked ELF modules to link
+ElfLinker *Context::getElfLinker(Pipeline *pipeline, ArrayRef<MemoryBufferRef> elfs) {
+  if (m_elfLinker)
+    m_elfLinker->reset(pipeline, elfs);
+  else
+    m_elfLinker.reset(pipeline->createElfLinker(elfs));
+  return &*m_elfLinker;
+}
+
+// =====================================================================================================================
+// Get the per-shader SPIR-V lowering pass manager for the given shader stage. Its passes are the same for every
+// compile that has no lowering timer and no LLPC_OUTS dump, so it is reused from an earlier compile in this context,
+// saving the cost of constructing the pass manager and its passes each time. The key includes the pass index of the
+// first pass, as the pass indices (used by -disable-pass-indices) are assigned when passes are added.
+//
+// @param stage : Shader stage
+// @param [in/out] passIndex : Pass index of the first pass; updated to be after the last pass
+lgc::LegacyPassManager &Context::getLowerPassManager(ShaderStage stage, unsigned *passIndex) {
+  LowerPassManager &lowerPassMgr = m_lowerPassMgrs[{stage, *passIndex}];
+  if (!lowerPassMgr.passMgr) {
+    unsigned firstPassIndex = *passIndex;
+    lowerPassMgr.passMgr.reset(lgc::LegacyPassManager::Create());
+    lowerPassMgr.passMgr->setPassIndex(passIndex);
+    LegacySpirvLower::addPasses(this, stage, *lowerPassMgr.passMgr, nullptr);
+    lowerPassMgr.passMgr->setPassIndex(nullptr);
+    lowerPassMgr.passCount = *passIndex - firstPassIndex;
+  } else
+    *passIndex += lowerPassMgr.passCount;
+  return *lowerPassMgr.passMgr;
+}
+
+// =====================================================================================================================
+// Materializes the functions of a lazily loaded module that are reachable from the ones that have to be kept, that is,
+// the ones that are not discardable if unused (such as the shader entry-points) and the ones already referenced (from
+// global initializers), following the references in each function body. The remaining functions are not referenced
+// by anything that is kept, so they are turned into declarations without reading their bodies, and removed once the
+// module is fully materialized (as the bitcode reader still refers to them until then).
+//
+// @param [in/out] module : Lazily loaded module
+// @returns : Error from materializing
+static Error materializeReachableFunctions(Module &module) {
+  SmallVector<Function *, 16> worklist;
+  for (Function &func : module) {
+    if (func.isMaterializable() && (!func.isDiscardableIfUnused() || !func.use_empty()))
+      worklist.push_back(&func);
+  }
+
+  SmallPtrSet<const Constant *, 32> visitedConstants;
+  SmallVector<Constant *, 8> constants;
+  auto addReferences = [&](User *user) {
+    for (Value *operand : user->operands()) {
+      if (auto constant = dyn_cast_or_null<Constant>(operand))
+        constants.push_back(constant);
+    }
+    while (!constants.empty()) {
+      Constant *constant = constants.pop_back_val();
+      if (auto func = dyn_cast<Function>(constant)) {
+        if (func->isMaterializable())
+          worklist.push_back(func);
+      } else if (!isa<GlobalValue>(constant) && visitedConstants.insert(constant).second) {
+        for (Value *operand : constant->operands())
+          constants.push_back(cast<Constant>(operand));
+      }
+    }
+  };
+
+  while (!worklist.empty()) {
+    Function *func = worklist.pop_back_val();
+    if (!func->isMaterializable())
+      continue;
+    if (Error err = func->materialize())
+      return err;
+    addReferences(func);
+    for (Instruction &inst : instructions(func))
+      addReferences(&inst);
+  }
+
+  SmallVector<Function *, 16> unusedFuncs;
+  for (Function &func : module) {
+    if (func.isMaterializable()) {
+      func.deleteBody();
+      unusedFuncs.push_back(&func);
+    }
+  }
+  if (Error err = module.materializeAll())
+    return err;
+  for (Function *func : unusedFuncs)
+    func->eraseFromParent();
+  return Error::success();
+}
+
+// =====================================================================================================================
+// Loads library from external LLVM library. Only the functions reachable from the ones that have to be kept are read
+// from the bitcode; see materializeReachableFunctions.
 //
 // @param lib : Bitcodes of external LLVM library
 std::unique_ptr<Module> Context::loadLibrary(const BinaryData *lib) {
@@ -106,7 +230,7 @@ std::unique_ptr<Module> Context::loadLibrary(const BinaryData *lib) {
     LLPC_ERRS("Fails to load LLVM bitcode \n");
   } else {
     libModule = std::move(*moduleOrErr);
-    if (Error errCode = libModule->materializeAll()) {
+    if (Error errCode = materializeReachableFunctions(*libModule)) {
       LLPC_ERRS("Fails to materialize \n");
       libModule = nullptr;
     }
@@ -37,16 +37,30 @@
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Type.h"
 #include "llvm/Target/TargetMachine.h"
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
+namespace lgc {
+
+class ElfLinker;
+class LegacyPassManager;
+
+} // namespace lgc
+
+namespace SPIRV {
+
+class SPIRVTypeCache;
+
+} // namespace SPIRV
+
 namespace Llpc {
 
 // =====================================================================================================================
 // Represents LLPC context for pipeline compilation. Derived from the base class llvm::LLVMContext.
 class Context : public llvm::LLVMContext {
 public:
-  Context(GfxIpVersion gfxIp);
+  Context(GfxIpVersion gfxIp, std::unique_ptr<llvm::TargetMachine> targetMachine = nullptr);
   ~Context();
 
   void reset();
@@ -65,6 +79,16 @@ public:
   // Get the number of times this context is used.
   unsigned getUseCount() const { return m_useCount; }
 
+  // Add to the total size of SPIR-V translated in this context. As the LLVMContext keeps every type and constant
+  // created in it, this is used as an estimate of how much memory the context has accumulated.
+  void addTranslatedSpirvSize(size_t size) { m_translatedSpirvSize += size; }
+
+  // Get the total size in bytes of SPIR-V translated in this context.
+  size_t getTranslatedSpirvSize() const { return m_translatedSpirvSize; }
+
+  // Take the target machine out of this context, for a new context that replaces this one to reuse.
+  std::unique_ptr<llvm::TargetMachine> takeTargetMachine();
+
   // Attaches pipeline context to LLPC context.
   void attachPipelineContext(PipelineContext *pipelineContext) { m_pipelineContext = pipelineContext; }
 
@@ -80,6 +104,16 @@ public:
   // Get (create if necessary) LgcContext
   lgc::LgcContext *getLgcContext();
 
+  // Get (create if necessary) the cache of the types translated from SPIR-V into this context
+  SPIRV::SPIRVTypeCache &getSpirvTypeCache();
+
+  // Get an ELF linker for the given pipeline and ELFs, reusing the one from this context's previous link if any
+  lgc::ElfLinker *getElfLinker(lgc::Pipeline *pipeline, llvm::ArrayRef<llvm::MemoryBufferRef> elfs);
+
+  // Get the per-shader SPIR-V lowering pass manager for the given shader stage, reusing the one from an earlier
+  // compile in this context if any
+  lgc::LegacyPassManager &getLowerPassManager(ShaderStage stage, unsigned *passIndex);
+
   // Set value of scalarBlockLayout option. This gets called with the value from PipelineOptions when
   // starting a pipeline compile.
   void setScalarBlockLayout(bool scalarBlockLayout) { m_scalarBlockLayout = scalarBlockLayout; }
@@ -117,6 +151,8 @@ public:
 
   unsigned getActiveShaderStageCount() const { return m_pipelineContext->getActiveShaderStageCount(); }
 
+  bool isCancelled() const { return m_pipelineContext && m_pipelineContext->isCancelled(); }
+
   const char *getGpuNameAbbreviation() const { return PipelineContext::getGpuNameAbbreviation(m_gfxIp); }
 
   GfxIpVersion getGfxIpVersion() const { return m_gfxIp; }
@@ -137,17 +173,28 @@ private:
   Context(const Context &) = delete;
   Context &operator=(const Context &) = delete;
 
-  GfxIpVersion m_gfxIp;                              // Graphics IP version info
-  PipelineContext *m_pipelineContext;                // Pipeline-specific context
-  bool m_isInUse = false;                            // Whether this context is in use
-  lgc::Builder *m_builder = nullptr;                 // LLPC builder object
-  std::unique_ptr<lgc::LgcContext> m_builderContext; // Builder context
-
-  std::unique_ptr<llvm::TargetMachine> m_targetMachine; // Target machine
+  GfxIpVersion m_gfxIp;                                    // Graphics IP version info
+  PipelineContext *m_pipelineContext;                      // Pipeline-specific context
+  bool m_isInUse = false;                                  // Whether this context is in use
+  lgc::Builder *m_builder = nullptr;                       // LLPC builder object
+  std::unique_ptr<lgc::LgcContext> m_builderContext;       // Builder context
+  std::unique_ptr<lgc::ElfLinker> m_elfLinker;             // ELF linker, kept for reuse by the next link
+  std::unique_ptr<SPIRV::SPIRVTypeCache> m_spirvTypeCache; // Cache of types translated from SPIR-V
+
+  // A cached per-shader SPIR-V lowering pass manager
+  struct LowerPassManager {
+    std::unique_ptr<lgc::LegacyPassManager> passMgr; // Pass manager
+    unsigned passCount;                              // Number of pass indices taken by its passes
+  };
+  // Cached lowering pass managers, keyed by shader stage and the pass index of their first pass
+  std::map<std::pair<unsigned, unsigned>, LowerPassManager> m_lowerPassMgrs;
+
+  std::unique_ptr<llvm::TargetMachine> m_targetMachine; // Target machine to give the LgcContext when creating it
   bool m_scalarBlockLayout = false;                     // scalarBlockLayout option from last pipeline compile
   bool m_robustBufferAccess = false;                    // robustBufferAccess option from last pipeline compile
 
-  unsigned m_useCount = 0; // Number of times this context is used.
+  unsigned m_useCount = 0;           // Number of times this context is used.
+  size_t m_translatedSpirvSize = 0; // Total size in bytes of SPIR-V translated in this context
 };
 
 } // namespace Llpc
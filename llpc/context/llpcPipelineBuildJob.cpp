@@ -0,0 +1,127 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcPipelineBuildJob.cpp
+ * @brief LLPC source file: contains implementation of class Llpc::PipelineBuildJob.
+ ***********************************************************************************************************************
+ */
+#include "llpcPipelineBuildJob.h"
+
+#define DEBUG_TYPE "llpc-pipeline-build-job"
+
+namespace Llpc {
+
+// =====================================================================================================================
+//
+// @param build : Function that builds the pipeline
+// @param callback : Client's completion callback, may be null
+// @param userData : User data passed to the callback
+PipelineBuildJob::PipelineBuildJob(BuildFunc build, PipelineBuildCallbackFunc callback, void *userData)
+    : m_build(std::move(build)), m_callback(callback), m_userData(userData) {
+}
+
+// =====================================================================================================================
+// Creates a job, which holds a reference to itself until the client calls Destroy().
+//
+// @param build : Function that builds the pipeline
+// @param callback : Client's completion callback, may be null
+// @param userData : User data passed to the callback
+std::shared_ptr<PipelineBuildJob> PipelineBuildJob::create(BuildFunc build, PipelineBuildCallbackFunc callback,
+                                                           void *userData) {
+  auto job = std::make_shared<PipelineBuildJob>(std::move(build), callback, userData);
+  job->m_self = job;
+  return job;
+}
+
+// =====================================================================================================================
+// Moves a pending job to the running state. Returns false if the job has already been started or cancelled.
+bool PipelineBuildJob::tryStart() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != State::Pending)
+    return false;
+  m_state = State::Running;
+  return true;
+}
+
+// =====================================================================================================================
+// Completes the job: calls the client's callback, then releases the waiters.
+//
+// @param result : Result of the build
+void PipelineBuildJob::complete(Result result) {
+  if (m_callback)
+    m_callback(m_userData, result);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_result = result;
+  m_state = State::Complete;
+  m_completeCondition.notify_all();
+}
+
+// =====================================================================================================================
+// Runs the build, unless it has been cancelled.
+void PipelineBuildJob::run() {
+  if (!tryStart())
+    return;
+  Result result = m_build(&m_cancelled);
+  m_build = nullptr;
+
+  // A build that stopped early because of cancellation fails in an unspecified way; report it as cancelled.
+  if (result != Result::Success && m_cancelled)
+    result = Result::ErrorUnavailable;
+  complete(result);
+}
+
+// =====================================================================================================================
+// Waits for the build to complete.
+Result PipelineBuildJob::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_completeCondition.wait(lock, [this] { return m_state == State::Complete; });
+  return m_result;
+}
+
+// =====================================================================================================================
+// Checks whether the build has completed, without waiting.
+bool PipelineBuildJob::IsComplete() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_state == State::Complete;
+}
+
+// =====================================================================================================================
+// Cancels the build. A pending build is completed right away; a running build is asked to stop early.
+void PipelineBuildJob::Cancel() {
+  m_cancelled = true;
+  if (tryStart())
+    complete(Result::ErrorUnavailable);
+}
+
+// =====================================================================================================================
+// Waits for the build to complete, then releases the client's reference to the job.
+void PipelineBuildJob::Destroy() {
+  Wait();
+  std::shared_ptr<PipelineBuildJob> self = std::move(m_self);
+}
+
+} // namespace Llpc
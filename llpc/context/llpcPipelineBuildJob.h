@@ -0,0 +1,90 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcPipelineBuildJob.h
+ * @brief LLPC header file: contains declaration of class Llpc::PipelineBuildJob.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llpc.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace Llpc {
+
+// =====================================================================================================================
+// Represents an asynchronous pipeline build. The job is shared between the client, which owns it until it calls
+// Destroy(), and the thread pool job that runs the build.
+class PipelineBuildJob : public IPipelineBuildJob {
+public:
+  // Function that builds the pipeline. It is given the flag that is raised when the build is cancelled.
+  using BuildFunc = std::function<Result(const std::atomic<bool> *cancelFlag)>;
+
+  PipelineBuildJob(BuildFunc build, PipelineBuildCallbackFunc callback, void *userData);
+  ~PipelineBuildJob() override {}
+
+  // Creates a job, which holds a reference to itself until the client calls Destroy().
+  static std::shared_ptr<PipelineBuildJob> create(BuildFunc build, PipelineBuildCallbackFunc callback, void *userData);
+
+  // Runs the build, unless it has been cancelled. Called on the thread that processes the job.
+  void run();
+
+  virtual Result Wait() override;
+  virtual bool IsComplete() const override;
+  virtual void Cancel() override;
+  virtual void VKAPI_CALL Destroy() override;
+
+private:
+  PipelineBuildJob() = delete;
+  PipelineBuildJob(const PipelineBuildJob &) = delete;
+  PipelineBuildJob &operator=(const PipelineBuildJob &) = delete;
+
+  // State of the job
+  enum class State {
+    Pending,  // Not started yet
+    Running,  // Being built, or being completed after cancellation
+    Complete, // Completed; m_result is valid
+  };
+
+  bool tryStart();
+  void complete(Result result);
+
+  BuildFunc m_build;                           // Function that builds the pipeline
+  PipelineBuildCallbackFunc m_callback;        // Client's completion callback, may be null
+  void *m_userData;                            // User data passed to m_callback
+  mutable std::mutex m_mutex;                  // Guards m_state and m_result
+  std::condition_variable m_completeCondition; // Signalled when the job completes
+  State m_state = State::Pending;              // State of the job
+  std::atomic<bool> m_cancelled{false};        // Raised by Cancel() to make a running build stop early
+  Result m_result = Result::ErrorUnavailable;  // Result of the build
+  std::shared_ptr<PipelineBuildJob> m_self;    // Reference held on behalf of the client
+};
+
+} // namespace Llpc
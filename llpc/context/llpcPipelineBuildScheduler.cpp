@@ -0,0 +1,209 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcPipelineBuildScheduler.cpp
+ * @brief LLPC source file: contains implementation of class Llpc::PipelineBuildScheduler.
+ ***********************************************************************************************************************
+ */
+#include "llpcPipelineBuildScheduler.h"
+#include "llpcThreading.h"
+#include "llvm/Support/CommandLine.h"
+
+#define DEBUG_TYPE "llpc-pipeline-build-scheduler"
+
+using namespace llvm;
+
+namespace llvm {
+namespace cl {
+
+// -pipeline-build-aging-interval: waiting time that raises the urgency of a pending build by one priority level
+static opt<unsigned> PipelineBuildAgingInterval("pipeline-build-aging-interval",
+                                                desc("Time in milliseconds after which a pending asynchronous "
+                                                     "pipeline build is as urgent as a newly submitted build of the "
+                                                     "next priority level (0 to disable aging)"),
+                                                value_desc("ms"), init(100));
+
+} // namespace cl
+} // namespace llvm
+
+namespace Llpc {
+
+namespace {
+// The scheduler and priority level of the build running on this thread, if any.
+thread_local PipelineBuildScheduler *CurrentScheduler = nullptr;
+thread_local PipelineBuildPriority CurrentPriority = PipelineBuildPriority::Background;
+} // anonymous namespace
+
+// =====================================================================================================================
+//
+// @param pool : Thread pool to run the builds on
+PipelineBuildScheduler::PipelineBuildScheduler(ThreadPool &pool) : m_pool(pool) {
+}
+
+// =====================================================================================================================
+// Gets the scheduler shared by the whole process.
+PipelineBuildScheduler &PipelineBuildScheduler::getGlobal() {
+  // The scheduler is never destroyed, as the jobs it queues on the global thread pool may still run while the pool is
+  // destroyed at exit.
+  static PipelineBuildScheduler *GlobalScheduler = new PipelineBuildScheduler(ThreadPool::getGlobal());
+  return *GlobalScheduler;
+}
+
+// =====================================================================================================================
+// Queues a build, and a job on the thread pool to run the most urgent pending build.
+//
+// @param build : Function that runs the build
+// @param priority : Priority level of the build
+// @param key : Key of the build, such as the pipeline hash, or 0 if it has none
+void PipelineBuildScheduler::submit(BuildFunc build, PipelineBuildPriority priority, uint64_t key) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (key != 0) {
+      // Raise the pending builds with the same key, which this build is going to wait for.
+      for (PendingBuild &pending : m_pending) {
+        if (pending.key == key && pending.priority < priority) {
+          --m_pendingCounts[unsigned(pending.priority)];
+          ++m_pendingCounts[unsigned(priority)];
+          pending.priority = priority;
+        }
+      }
+    }
+    m_pending.push_back({std::move(build), priority, key, std::chrono::steady_clock::now()});
+    ++m_pendingCounts[unsigned(priority)];
+  }
+  m_pool.submit([this] { runNext(); });
+}
+
+// =====================================================================================================================
+// Runs the pending builds of a higher priority level than the build running on the calling thread. Does nothing on a
+// thread that is not running a build.
+void PipelineBuildScheduler::yield() {
+  if (CurrentScheduler)
+    CurrentScheduler->yieldTo(CurrentPriority);
+}
+
+// =====================================================================================================================
+// Runs the most urgent pending build that can be started, if any. This is the job that submit() queues for each build.
+void PipelineBuildScheduler::runNext() {
+  PendingBuild build;
+  if (takeBuild(0, build))
+    runBuild(build);
+}
+
+// =====================================================================================================================
+// Runs the pending builds of a higher priority level than the given one, until there are none left that can be
+// started.
+//
+// @param priority : Priority level of the build that yields
+void PipelineBuildScheduler::yieldTo(PipelineBuildPriority priority) {
+  const unsigned minPriority = unsigned(priority) + 1;
+  for (;;) {
+    // Check the counts first, so that a pass boundary with nothing more urgent pending does not take the lock.
+    bool anyPending = false;
+    for (unsigned level = minPriority; level != unsigned(PipelineBuildPriority::Count); ++level)
+      anyPending |= m_pendingCounts[level] != 0;
+    if (!anyPending)
+      return;
+
+    PendingBuild build;
+    if (!takeBuild(minPriority, build))
+      return;
+    runBuild(build);
+  }
+}
+
+// =====================================================================================================================
+// Takes the most urgent pending build of at least the given priority level whose key is not running.
+//
+// @param minPriority : Lowest priority level of a build to take
+// @param [out] build : The build taken
+// @returns : True if a build was taken
+bool PipelineBuildScheduler::takeBuild(unsigned minPriority, PendingBuild &build) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto now = std::chrono::steady_clock::now();
+  auto best = m_pending.end();
+  double bestUrgency = 0;
+  for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+    if (unsigned(it->priority) < minPriority)
+      continue;
+    if (it->key != 0 && m_runningKeys.count(it->key) != 0)
+      continue;
+    double urgency = unsigned(it->priority);
+    if (cl::PipelineBuildAgingInterval != 0) {
+      std::chrono::duration<double, std::milli> waitTime = now - it->submitTime;
+      urgency += waitTime.count() / cl::PipelineBuildAgingInterval;
+    }
+    // The list is oldest first, so the oldest of equally urgent builds is taken.
+    if (best == m_pending.end() || urgency > bestUrgency) {
+      best = it;
+      bestUrgency = urgency;
+    }
+  }
+  if (best == m_pending.end())
+    return false;
+
+  build = std::move(*best);
+  m_pending.erase(best);
+  --m_pendingCounts[unsigned(build.priority)];
+  if (build.key != 0)
+    ++m_runningKeys[build.key];
+  return true;
+}
+
+// =====================================================================================================================
+// Runs a build taken from the pending builds on the calling thread, and then lets the builds that were waiting for it
+// be started.
+//
+// @param build : The build
+void PipelineBuildScheduler::runBuild(PendingBuild &build) {
+  PipelineBuildScheduler *savedScheduler = CurrentScheduler;
+  PipelineBuildPriority savedPriority = CurrentPriority;
+  CurrentScheduler = this;
+  CurrentPriority = build.priority;
+  build.build();
+  CurrentScheduler = savedScheduler;
+  CurrentPriority = savedPriority;
+
+  if (build.key == 0)
+    return;
+
+  unsigned numUnblocked = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto runningIt = m_runningKeys.find(build.key);
+    if (--runningIt->second == 0) {
+      m_runningKeys.erase(runningIt);
+      for (const PendingBuild &pending : m_pending)
+        numUnblocked += pending.key == build.key;
+    }
+  }
+
+  // The jobs queued for the builds that had to wait for this one may have found nothing to run, so queue new ones.
+  for (unsigned i = 0; i != numUnblocked; ++i)
+    m_pool.submit([this] { runNext(); });
+}
+
+} // namespace Llpc
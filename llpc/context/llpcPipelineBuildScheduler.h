@@ -0,0 +1,100 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcPipelineBuildScheduler.h
+ * @brief LLPC header file: contains declaration of class Llpc::PipelineBuildScheduler.
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llpc.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace Llpc {
+
+class ThreadPool;
+
+// =====================================================================================================================
+// Orders the asynchronous pipeline builds run on a thread pool by priority. Each submitted build queues one job on the
+// pool, and the job runs whichever pending build is the most urgent at the time, rather than the build it was queued
+// for. A pending build's urgency is its priority level plus the time it has waited, measured in aging intervals, so
+// that a stream of urgent builds cannot starve the background ones.
+//
+// A build may be given a key, such as the hash of the pipeline it builds. A build is not started while another build
+// with the same key is running, so a duplicate build waits for the first one and then finds its result in the caches
+// instead of compiling it again. Submitting a build raises the priority of the pending builds with the same key to its
+// own.
+//
+// A running build calls yield() at its pass boundaries, which runs the pending builds of a higher priority level on
+// the calling thread, pausing the build until they are done. This lets a foreground build that is waiting for a worker
+// take over a worker that is busy with a background build.
+class PipelineBuildScheduler {
+public:
+  using BuildFunc = std::function<void()>;
+
+  explicit PipelineBuildScheduler(ThreadPool &pool);
+
+  // Gets the scheduler shared by the whole process, which runs the builds on the global thread pool.
+  static PipelineBuildScheduler &getGlobal();
+
+  // Queues a build. A key of 0 means that the build has no key.
+  void submit(BuildFunc build, PipelineBuildPriority priority, uint64_t key);
+
+  // Runs the pending builds of a higher priority level than the build running on the calling thread, if any.
+  static void yield();
+
+private:
+  PipelineBuildScheduler(const PipelineBuildScheduler &) = delete;
+  PipelineBuildScheduler &operator=(const PipelineBuildScheduler &) = delete;
+
+  // A build that has not started yet
+  struct PendingBuild {
+    BuildFunc build;                                  // Function that runs the build
+    PipelineBuildPriority priority;                   // Priority level of the build
+    uint64_t key;                                     // Key of the build, or 0
+    std::chrono::steady_clock::time_point submitTime; // Time the build was submitted, for aging
+  };
+
+  void runNext();
+  void yieldTo(PipelineBuildPriority priority);
+  bool takeBuild(unsigned minPriority, PendingBuild &build);
+  void runBuild(PendingBuild &build);
+
+  ThreadPool &m_pool;                                   // Thread pool the builds run on
+  std::mutex m_mutex;                                   // Guards m_pending and m_runningKeys
+  std::list<PendingBuild> m_pending;                    // Pending builds, oldest first
+  std::unordered_map<uint64_t, unsigned> m_runningKeys; // Number of running builds of each key
+  // Number of pending builds of each priority level, read by yield() without taking m_mutex
+  std::atomic<unsigned> m_pendingCounts[unsigned(PipelineBuildPriority::Count)] = {};
+};
+
+} // namespace Llpc
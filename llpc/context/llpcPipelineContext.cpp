@@ -72,6 +72,12 @@ static cl::opt<unsigned> SgprLimit("sgpr-limit", cl::desc("Maximum SGPR limit fo
 static cl::opt<unsigned> WavesPerEu("waves-per-eu", cl::desc("Maximum number of waves per EU for this shader"),
                                     cl::init(0));
 
+// -min-waves-per-simd: minimum number of waves per SIMD that each shader must be able to run with
+static cl::opt<unsigned> MinWavesPerSimd("min-waves-per-simd",
+                                         cl::desc("Minimum number of waves per SIMD that each shader must be able to "
+                                                  "run with, which sets its register limits (0 for no target)"),
+                                         cl::init(0));
+
 // -enable-load-scalarizer: Enable the optimization for load scalarizer.
 static cl::opt<bool> EnableScalarLoad("enable-load-scalarizer",
                                       cl::desc("Enable the optimization for load scalarizer."), cl::init(true));
@@ -110,6 +116,30 @@ static cl::opt<unsigned> ShadowDescTablePtrHigh("shadow-desc-table-ptr-high",
                                                 cl::desc("High part of VA for shadow descriptor table pointer"),
                                                 cl::init(2));
 
+// -ngg-hint-min-prims-per-draw: with NGG culling hints, the primitives per draw below which culling is turned off
+static cl::opt<unsigned>
+    NggHintMinPrimsPerDraw("ngg-hint-min-prims-per-draw",
+                           cl::desc("With NGG culling hints, turn off culling for pipelines that draw fewer "
+                                    "primitives per draw than this"),
+                           cl::init(256));
+
+// -ngg-hint-min-culled-percent: with NGG culling hints, the culled primitive percentage below which culling is turned
+// off
+static cl::opt<unsigned>
+    NggHintMinCulledPercent("ngg-hint-min-culled-percent",
+                            cl::desc("With NGG culling hints, turn off culling for pipelines that cull a smaller "
+                                     "percentage of primitives than this"),
+                            cl::init(10));
+
+// -ngg-hint-min-compact-culled-percent: with NGG culling hints, the culled primitive percentage below which vertex
+// compaction and the costlier cullers are turned off
+static cl::opt<unsigned>
+    NggHintMinCompactCulledPercent("ngg-hint-min-compact-culled-percent",
+                                   cl::desc("With NGG culling hints, turn off vertex compaction and the sphere and "
+                                            "small primitive cullers for pipelines that cull a smaller percentage "
+                                            "of primitives than this"),
+                                   cl::init(30));
+
 // -force-loop-unroll-count: Force to set the loop unroll count.
 static cl::opt<int> ForceLoopUnrollCount("force-loop-unroll-count", cl::desc("Force loop unroll count"), cl::init(0));
 
@@ -237,6 +267,35 @@ void PipelineContext::setPipelineState(Pipeline *pipeline, bool unlinked) const
     pipeline->setDeviceIndex(static_cast<const ComputePipelineBuildInfo *>(getPipelineBuildInfo())->deviceIndex);
 }
 
+// =====================================================================================================================
+// Applies the measured per-pipeline culling hints of the NGG state to the NGG flags. Culling costs LDS traffic and
+// ALU in the primitive shader, which is only repaid when enough primitives are culled. So this turns off all culling
+// (giving pass-through mode) for pipelines that draw few primitives per draw or rarely cull, and turns off vertex
+// compaction and the costlier cullers for pipelines that cull a moderate amount. Cullers that are turned off in the
+// NGG state are never turned on, and the hints are not used when culling mode is forced.
+//
+// @param nggState : NGG state of the pipeline
+// @param nggFlags : NGG flags from the NGG state settings
+// @returns : NGG flags with the hints applied
+static unsigned applyNggCullingHints(const Vkgc::NggState &nggState, unsigned nggFlags) {
+  if (!nggState.enableCullingHints || (nggFlags & NggFlagForceCullingMode))
+    return nggFlags;
+
+  const unsigned cullingFlags = NggFlagEnableVertexReuse | NggFlagEnableBackfaceCulling | NggFlagEnableFrustumCulling |
+                                NggFlagEnableBoxFilterCulling | NggFlagEnableSphereCulling |
+                                NggFlagEnableSmallPrimFilter | NggFlagEnableCullDistanceCulling;
+  const bool culledPercentMeasured = nggState.culledPrimPercentHint <= 100;
+
+  if ((nggState.primsPerDrawHint != 0 && nggState.primsPerDrawHint < NggHintMinPrimsPerDraw) ||
+      (culledPercentMeasured && nggState.culledPrimPercentHint < NggHintMinCulledPercent))
+    return nggFlags & ~cullingFlags;
+
+  if (culledPercentMeasured && nggState.culledPrimPercentHint < NggHintMinCompactCulledPercent)
+    return (nggFlags & ~(NggFlagEnableSphereCulling | NggFlagEnableSmallPrimFilter)) | NggFlagCompactDisable;
+
+  return nggFlags;
+}
+
 // =====================================================================================================================
 // Give the pipeline options to the middle-end.
 //
@@ -288,6 +347,7 @@ void PipelineContext::setOptionsInPipeline(Pipeline *pipeline) const {
                          (nggState.enableSphereCulling ? NggFlagEnableSphereCulling : 0) |
                          (nggState.enableSmallPrimFilter ? NggFlagEnableSmallPrimFilter : 0) |
                          (nggState.enableCullDistanceCulling ? NggFlagEnableCullDistanceCulling : 0);
+      options.nggFlags = applyNggCullingHints(nggState, options.nggFlags);
       options.nggBackfaceExponent = nggState.backfaceExponent;
 
       // Use a static cast from Vkgc NggSubgroupSizingType to LGC NggSubgroupSizing, and static assert that
@@ -306,18 +366,32 @@ void PipelineContext::setOptionsInPipeline(Pipeline *pipeline) const {
                     "Mismatch");
       static_assert(static_cast<NggSubgroupSizing>(NggSubgroupSizingType::Explicit) == NggSubgroupSizing::Explicit,
                     "Mismatch");
+      static_assert(static_cast<NggSubgroupSizing>(NggSubgroupSizingType::Adaptive) == NggSubgroupSizing::Adaptive,
+                    "Mismatch");
       options.nggSubgroupSizing = static_cast<NggSubgroupSizing>(nggState.subgroupSizing);
 
       options.nggVertsPerSubgroup = nggState.vertsPerSubgroup;
       options.nggPrimsPerSubgroup = nggState.primsPerSubgroup;
+      options.nggVertsPerPrimHint = nggState.vertsPerPrimHint;
     }
   }
 
   options.allowNullDescriptor = getPipelineOptions()->extendedRobustness.nullDescriptor;
+  options.robustBufferAccess2 = getPipelineOptions()->extendedRobustness.robustBufferAccess;
   options.disableImageResourceCheck = getPipelineOptions()->disableImageResourceCheck;
   options.enableInterpModePatch = getPipelineOptions()->enableInterpModePatch;
   options.pageMigrationEnabled = getPipelineOptions()->pageMigrationEnabled;
 
+  static_assert(static_cast<WaveSizeHeuristic>(Vkgc::WaveSizeHeuristic::Disable) == WaveSizeHeuristic::Disable,
+                "Mismatch");
+  static_assert(static_cast<WaveSizeHeuristic>(Vkgc::WaveSizeHeuristic::Auto) == WaveSizeHeuristic::Auto, "Mismatch");
+  static_assert(static_cast<WaveSizeHeuristic>(Vkgc::WaveSizeHeuristic::Gfx10) == WaveSizeHeuristic::Gfx10, "Mismatch");
+  static_assert(static_cast<WaveSizeHeuristic>(Vkgc::WaveSizeHeuristic::Gfx103) == WaveSizeHeuristic::Gfx103,
+                "Mismatch");
+  options.waveSizeHeuristic = static_cast<WaveSizeHeuristic>(getPipelineOptions()->waveSizeHeuristic);
+  options.groupWaterfallLoops = getPipelineOptions()->groupWaterfallLoops;
+  options.fastCompile = getPipelineOptions()->fastCompile;
+
   // Driver report full subgroup lanes for compute shader, here we just set fullSubgroups as default options
   options.fullSubgroups = true;
   pipeline->setOptions(options);
@@ -353,6 +427,8 @@ void PipelineContext::setOptionsInPipeline(Pipeline *pipeline) const {
     else
       shaderOptions.maxThreadGroupsPerComputeUnit = WavesPerEu;
 
+    shaderOptions.minWavesPerSimd = MinWavesPerSimd;
+
     shaderOptions.waveSize = shaderInfo->options.waveSize;
     shaderOptions.wgpMode = shaderInfo->options.wgpMode;
     if (!shaderInfo->options.allowVaryWaveSize) {
@@ -413,6 +489,13 @@ void PipelineContext::setOptionsInPipeline(Pipeline *pipeline) const {
       shaderOptions.dontUnrollHintThreshold = shaderInfo->options.dontUnrollHintThreshold;
     else
       shaderOptions.dontUnrollHintThreshold = DontUnrollHintThreshold;
+
+    static_assert(static_cast<lgc::MathPrecision>(Vkgc::MathPrecision::Strict) == lgc::MathPrecision::Strict,
+                  "Mismatch");
+    static_assert(static_cast<lgc::MathPrecision>(Vkgc::MathPrecision::Relaxed) == lgc::MathPrecision::Relaxed,
+                  "Mismatch");
+    static_assert(static_cast<lgc::MathPrecision>(Vkgc::MathPrecision::Fast) == lgc::MathPrecision::Fast, "Mismatch");
+    shaderOptions.mathPrecision = static_cast<lgc::MathPrecision>(shaderInfo->options.mathPrecision);
     pipeline->setShaderOptions(getLgcShaderStage(stage), shaderOptions);
   }
 }
@@ -786,6 +869,7 @@ void PipelineContext::setColorExportState(Pipeline *pipeline) const {
       formats[targetIndex].nfmt = nfmt;
       formats[targetIndex].blendEnable = cbState.target[targetIndex].blendEnable;
       formats[targetIndex].blendSrcAlphaToColor = cbState.target[targetIndex].blendSrcAlphaToColor;
+      formats[targetIndex].channelWriteMask = cbState.target[targetIndex].channelWriteMask;
     }
   }
 
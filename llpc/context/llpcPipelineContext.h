@@ -38,6 +38,8 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Type.h"
+#include <algorithm>
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -168,6 +170,21 @@ public:
   // Gets pipeline resource mapping data
   const ResourceMappingData *getResourceMapping() const { return &m_resourceMapping; }
 
+  // Set the flag that is raised when the build of this pipeline is cancelled, or nullptr if it cannot be cancelled.
+  void setCancelFlag(const std::atomic<bool> *cancelFlag) { m_cancelFlag = cancelFlag; }
+
+  // Check whether the build of this pipeline can be cancelled
+  bool isCancellable() const { return m_cancelFlag != nullptr; }
+
+  // Check whether the build of this pipeline has been cancelled
+  bool isCancelled() const { return m_cancelFlag && m_cancelFlag->load(std::memory_order_relaxed); }
+
+  // Record the growth of the heap usage seen in a compile for this pipeline, keeping the largest one
+  void recordPeakMemoryGrowth(size_t growth) { m_peakMemoryGrowth = std::max(m_peakMemoryGrowth, growth); }
+
+  // Get the largest growth of the heap usage seen in the compiles for this pipeline, in bytes
+  size_t getPeakMemoryGrowth() const { return m_peakMemoryGrowth; }
+
 protected:
   // Gets dummy vertex input create info
   virtual VkPipelineVertexInputStateCreateInfo *getDummyVertexInputInfo() { return nullptr; }
@@ -210,7 +227,9 @@ private:
   void setColorExportState(lgc::Pipeline *pipeline) const;
 
   ShaderFpMode m_shaderFpModes[ShaderStageCountInternal] = {};
-  bool m_unlinked = false; // Whether we are building an "unlinked" shader ELF
+  bool m_unlinked = false;                        // Whether we are building an "unlinked" shader ELF
+  const std::atomic<bool> *m_cancelFlag = nullptr; // Flag raised when the build is cancelled, may be null
+  size_t m_peakMemoryGrowth = 0;                   // Largest heap usage growth seen in the compiles, in bytes
 };
 
 } // namespace Llpc
@@ -29,14 +29,30 @@
 ***********************************************************************************************************************
 */
 #include "llpcShaderCache.h"
+#include "llpcCrc.h"
+#include "llpcDebug.h"
 #include "llpcError.h"
 #include "llpcFile.h"
+#include "llpcLz4.h"
+#include "llpcThreading.h"
 #include "vkgcUtil.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DJB.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include <algorithm>
+#include <cinttypes>
+#include <set>
 #include <string.h>
+#include <tuple>
+#include <unordered_set>
 
 #define DEBUG_TYPE "llpc-shader-cache"
 
@@ -45,6 +61,50 @@ using namespace llvm;
 static cl::opt<std::string> ShaderCacheFilename("shader-cache-filename", cl::desc("Filename for the shader cache"),
                                                 cl::value_desc("filename"), cl::init(""));
 
+// -shader-cache-mmap: map the on-disk shader cache file into memory instead of reading it
+static cl::opt<bool> ShaderCacheMmap("shader-cache-mmap",
+                                     cl::desc("Map the on-disk shader cache file into memory and verify CRCs on first "
+                                              "access, instead of reading and verifying the whole file at load"),
+                                     cl::init(false));
+
+// -shader-cache-file-batch-size: number of bytes of new shader data that are collected before they are appended to
+// the on-disk shader cache file
+static cl::opt<unsigned> ShaderCacheFileBatchSize("shader-cache-file-batch-size",
+                                                  cl::desc("Number of bytes of new shader data collected before they "
+                                                           "are appended to the on-disk shader cache file"),
+                                                  cl::init(256 * 1024));
+
+// -shader-cache-background-file-write: append the batches of new shader data to the on-disk file in the background
+static cl::opt<bool> ShaderCacheBackgroundFileWrite("shader-cache-background-file-write",
+                                                    cl::desc("Append the batches of new shader data to the on-disk "
+                                                             "shader cache file on a background thread"),
+                                                    cl::init(true));
+
+// -shader-cache-shared-file: share the on-disk shader cache file between processes
+static cl::opt<bool> ShaderCacheSharedFile("shader-cache-shared-file",
+                                           cl::desc("Share the on-disk shader cache file between processes that run "
+                                                    "at the same time, by locking it while it is loaded or appended"),
+                                           cl::init(false));
+
+// -shader-cache-evict-lfu: evict the least frequently used shader cache entries instead of the least recently used
+static cl::opt<bool> ShaderCacheEvictLfu("shader-cache-evict-lfu",
+                                         cl::desc("When a shader cache budget is exceeded, evict the least frequently "
+                                                  "used entries instead of the least recently used ones"),
+                                         cl::init(false));
+
+// -shader-cache-compress: compress the shader data stored in the shader cache
+static cl::opt<bool> ShaderCacheCompress("shader-cache-compress",
+                                         cl::desc("Compress the shader data stored in the shader cache with LZ4 block "
+                                                  "compression, and decompress it when it is retrieved"),
+                                         cl::init(false));
+
+// -shader-cache-segmented: keep the on-disk shader cache in a directory of segment files
+static cl::opt<bool> ShaderCacheSegmented("shader-cache-segmented",
+                                          cl::desc("Keep the on-disk shader cache in a directory with a segment file "
+                                                   "per build of the compiler and process, so that processes of "
+                                                   "different builds or GPUs do not reset or contend for one file"),
+                                          cl::init(false));
+
 namespace Llpc {
 
 #if !_WIN32
@@ -55,67 +115,22 @@ static const char CacheFileSubPath[] = "\\AMD\\LlpcCache\\";
 
 static const char ClientStr[] = "LLPC";
 
-static constexpr uint64_t CrcWidth = sizeof(uint64_t) * 8;
-static constexpr uint64_t CrcInitialValue = 0xFFFFFFFFFFFFFFFF;
-
-static const uint64_t CrcLookup[256] = {
-    0x0000000000000000, 0xAD93D23594C935A9, 0xF6B4765EBD5B5EFB, 0x5B27A46B29926B52, 0x40FB3E88EE7F885F,
-    0xED68ECBD7AB6BDF6, 0xB64F48D65324D6A4, 0x1BDC9AE3C7EDE30D, 0x81F67D11DCFF10BE, 0x2C65AF2448362517,
-    0x77420B4F61A44E45, 0xDAD1D97AF56D7BEC, 0xC10D4399328098E1, 0x6C9E91ACA649AD48, 0x37B935C78FDBC61A,
-    0x9A2AE7F21B12F3B3, 0xAE7F28162D3714D5, 0x03ECFA23B9FE217C, 0x58CB5E48906C4A2E, 0xF5588C7D04A57F87,
-    0xEE84169EC3489C8A, 0x4317C4AB5781A923, 0x183060C07E13C271, 0xB5A3B2F5EADAF7D8, 0x2F895507F1C8046B,
-    0x821A8732650131C2, 0xD93D23594C935A90, 0x74AEF16CD85A6F39, 0x6F726B8F1FB78C34, 0xC2E1B9BA8B7EB99D,
-    0x99C61DD1A2ECD2CF, 0x3455CFE43625E766, 0xF16D8219CEA71C03, 0x5CFE502C5A6E29AA, 0x07D9F44773FC42F8,
-    0xAA4A2672E7357751, 0xB196BC9120D8945C, 0x1C056EA4B411A1F5, 0x4722CACF9D83CAA7, 0xEAB118FA094AFF0E,
-    0x709BFF0812580CBD, 0xDD082D3D86913914, 0x862F8956AF035246, 0x2BBC5B633BCA67EF, 0x3060C180FC2784E2,
-    0x9DF313B568EEB14B, 0xC6D4B7DE417CDA19, 0x6B4765EBD5B5EFB0, 0x5F12AA0FE39008D6, 0xF281783A77593D7F,
-    0xA9A6DC515ECB562D, 0x04350E64CA026384, 0x1FE994870DEF8089, 0xB27A46B29926B520, 0xE95DE2D9B0B4DE72,
-    0x44CE30EC247DEBDB, 0xDEE4D71E3F6F1868, 0x7377052BABA62DC1, 0x2850A14082344693, 0x85C3737516FD733A,
-    0x9E1FE996D1109037, 0x338C3BA345D9A59E, 0x68AB9FC86C4BCECC, 0xC5384DFDF882FB65, 0x4F48D60609870DAF,
-    0xE2DB04339D4E3806, 0xB9FCA058B4DC5354, 0x146F726D201566FD, 0x0FB3E88EE7F885F0, 0xA2203ABB7331B059,
-    0xF9079ED05AA3DB0B, 0x54944CE5CE6AEEA2, 0xCEBEAB17D5781D11, 0x632D792241B128B8, 0x380ADD49682343EA,
-    0x95990F7CFCEA7643, 0x8E45959F3B07954E, 0x23D647AAAFCEA0E7, 0x78F1E3C1865CCBB5, 0xD56231F41295FE1C,
-    0xE137FE1024B0197A, 0x4CA42C25B0792CD3, 0x1783884E99EB4781, 0xBA105A7B0D227228, 0xA1CCC098CACF9125,
-    0x0C5F12AD5E06A48C, 0x5778B6C67794CFDE, 0xFAEB64F3E35DFA77, 0x60C18301F84F09C4, 0xCD5251346C863C6D,
-    0x9675F55F4514573F, 0x3BE6276AD1DD6296, 0x203ABD891630819B, 0x8DA96FBC82F9B432, 0xD68ECBD7AB6BDF60,
-    0x7B1D19E23FA2EAC9, 0xBE25541FC72011AC, 0x13B6862A53E92405, 0x489122417A7B4F57, 0xE502F074EEB27AFE,
-    0xFEDE6A97295F99F3, 0x534DB8A2BD96AC5A, 0x086A1CC99404C708, 0xA5F9CEFC00CDF2A1, 0x3FD3290E1BDF0112,
-    0x9240FB3B8F1634BB, 0xC9675F50A6845FE9, 0x64F48D65324D6A40, 0x7F281786F5A0894D, 0xD2BBC5B36169BCE4,
-    0x899C61D848FBD7B6, 0x240FB3EDDC32E21F, 0x105A7C09EA170579, 0xBDC9AE3C7EDE30D0, 0xE6EE0A57574C5B82,
-    0x4B7DD862C3856E2B, 0x50A1428104688D26, 0xFD3290B490A1B88F, 0xA61534DFB933D3DD, 0x0B86E6EA2DFAE674,
-    0x91AC011836E815C7, 0x3C3FD32DA221206E, 0x671877468BB34B3C, 0xCA8BA5731F7A7E95, 0xD1573F90D8979D98,
-    0x7CC4EDA54C5EA831, 0x27E349CE65CCC363, 0x8A709BFBF105F6CA, 0x9E91AC0C130E1B5E, 0x33027E3987C72EF7,
-    0x6825DA52AE5545A5, 0xC5B608673A9C700C, 0xDE6A9284FD719301, 0x73F940B169B8A6A8, 0x28DEE4DA402ACDFA,
-    0x854D36EFD4E3F853, 0x1F67D11DCFF10BE0, 0xB2F403285B383E49, 0xE9D3A74372AA551B, 0x44407576E66360B2,
-    0x5F9CEF95218E83BF, 0xF20F3DA0B547B616, 0xA92899CB9CD5DD44, 0x04BB4BFE081CE8ED, 0x30EE841A3E390F8B,
-    0x9D7D562FAAF03A22, 0xC65AF24483625170, 0x6BC9207117AB64D9, 0x7015BA92D04687D4, 0xDD8668A7448FB27D,
-    0x86A1CCCC6D1DD92F, 0x2B321EF9F9D4EC86, 0xB118F90BE2C61F35, 0x1C8B2B3E760F2A9C, 0x47AC8F555F9D41CE,
-    0xEA3F5D60CB547467, 0xF1E3C7830CB9976A, 0x5C7015B69870A2C3, 0x0757B1DDB1E2C991, 0xAAC463E8252BFC38,
-    0x6FFC2E15DDA9075D, 0xC26FFC20496032F4, 0x9948584B60F259A6, 0x34DB8A7EF43B6C0F, 0x2F07109D33D68F02,
-    0x8294C2A8A71FBAAB, 0xD9B366C38E8DD1F9, 0x7420B4F61A44E450, 0xEE0A5304015617E3, 0x43998131959F224A,
-    0x18BE255ABC0D4918, 0xB52DF76F28C47CB1, 0xAEF16D8CEF299FBC, 0x0362BFB97BE0AA15, 0x58451BD25272C147,
-    0xF5D6C9E7C6BBF4EE, 0xC1830603F09E1388, 0x6C10D43664572621, 0x3737705D4DC54D73, 0x9AA4A268D90C78DA,
-    0x8178388B1EE19BD7, 0x2CEBEABE8A28AE7E, 0x77CC4ED5A3BAC52C, 0xDA5F9CE03773F085, 0x40757B122C610336,
-    0xEDE6A927B8A8369F, 0xB6C10D4C913A5DCD, 0x1B52DF7905F36864, 0x008E459AC21E8B69, 0xAD1D97AF56D7BEC0,
-    0xF63A33C47F45D592, 0x5BA9E1F1EB8CE03B, 0xD1D97A0A1A8916F1, 0x7C4AA83F8E402358, 0x276D0C54A7D2480A,
-    0x8AFEDE61331B7DA3, 0x91224482F4F69EAE, 0x3CB196B7603FAB07, 0x679632DC49ADC055, 0xCA05E0E9DD64F5FC,
-    0x502F071BC676064F, 0xFDBCD52E52BF33E6, 0xA69B71457B2D58B4, 0x0B08A370EFE46D1D, 0x10D4399328098E10,
-    0xBD47EBA6BCC0BBB9, 0xE6604FCD9552D0EB, 0x4BF39DF8019BE542, 0x7FA6521C37BE0224, 0xD2358029A377378D,
-    0x891224428AE55CDF, 0x2481F6771E2C6976, 0x3F5D6C94D9C18A7B, 0x92CEBEA14D08BFD2, 0xC9E91ACA649AD480,
-    0x647AC8FFF053E129, 0xFE502F0DEB41129A, 0x53C3FD387F882733, 0x08E45953561A4C61, 0xA5778B66C2D379C8,
-    0xBEAB1185053E9AC5, 0x1338C3B091F7AF6C, 0x481F67DBB865C43E, 0xE58CB5EE2CACF197, 0x20B4F813D42E0AF2,
-    0x8D272A2640E73F5B, 0xD6008E4D69755409, 0x7B935C78FDBC61A0, 0x604FC69B3A5182AD, 0xCDDC14AEAE98B704,
-    0x96FBB0C5870ADC56, 0x3B6862F013C3E9FF, 0xA142850208D11A4C, 0x0CD157379C182FE5, 0x57F6F35CB58A44B7,
-    0xFA6521692143711E, 0xE1B9BB8AE6AE9213, 0x4C2A69BF7267A7BA, 0x170DCDD45BF5CCE8, 0xBA9E1FE1CF3CF941,
-    0x8ECBD005F9191E27, 0x235802306DD02B8E, 0x787FA65B444240DC, 0xD5EC746ED08B7575, 0xCE30EE8D17669678,
-    0x63A33CB883AFA3D1, 0x388498D3AA3DC883, 0x95174AE63EF4FD2A, 0x0F3DAD1425E60E99, 0xA2AE7F21B12F3B30,
-    0xF989DB4A98BD5062, 0x541A097F0C7465CB, 0x4FC6939CCB9986C6, 0xE25541A95F50B36F, 0xB972E5C276C2D83D,
-    0x14E137F7E20BED94};
+// Name of the index of the segments in the directory of a segmented cache, and the maximum number of segments of one
+// build that processes append to at the same time.
+static const char SegmentIndexName[] = "index";
+static constexpr unsigned MaxSegmentsPerBuild = 64;
+
+// The segments claimed by the caches of this process, and the lock for access to them
+static std::mutex ClaimedSegmentsLock;
+static std::set<std::string> ClaimedSegments;
 
 // =====================================================================================================================
 ShaderCache::ShaderCache()
     : m_onDiskFile(), m_disableCache(true), m_shaderDataEnd(sizeof(ShaderCacheSerializedHeader)), m_totalShaders(0),
-      m_serializedSize(sizeof(ShaderCacheSerializedHeader)), m_getValueFunc(nullptr), m_storeValueFunc(nullptr) {
+      m_fileJournalShaders(0), m_fileWriteBatchShaders(0), m_fileWriteResult(Result::Success), m_fileWriting(false),
+      m_lockFileFd(-1), m_segmentLockFd(-1), m_maxMemorySize(0), m_maxFileSize(0),
+      m_liveDataSize(0), m_accessTick(0), m_compacting(false), m_prefetchCancelled(false), m_getValueFunc(nullptr),
+      m_storeValueFunc(nullptr) {
   memset(m_fileFullPath, 0, sizeof(m_fileFullPath));
   memset(&m_gfxIp, 0, sizeof(m_gfxIp));
 }
@@ -128,25 +143,51 @@ ShaderCache::~ShaderCache() {
 // =====================================================================================================================
 // Destruction, does clean-up work.
 void ShaderCache::Destroy() {
-  if (m_onDiskFile.isOpen())
+  // A background prefetch looks entries up in the cache, so it is stopped before anything is released.
+  m_prefetchCancelled = true;
+  waitForPrefetch();
+  m_prefetchCancelled = false;
+  // A background compaction of the on-disk file swaps in the compacted file and appends the journal when it finishes.
+  if (m_compactionThread.joinable())
+    m_compactionThread.join();
+  if (m_onDiskFile.isOpen()) {
+    // Append any shader data still held in the journal before the file is closed.
+    std::lock_guard<sys::Mutex> storageLock(m_lock);
+    if (flushFileJournal() != Result::Success)
+      LLPC_ERRS("Failed to write shader cache file: " << m_fileFullPath << "\n");
     m_onDiskFile.close();
+  }
+  if (m_lockFileFd >= 0) {
+    sys::Process::SafelyCloseFileDescriptor(m_lockFileFd);
+    m_lockFileFd = -1;
+  }
+  if (m_segmentLockFd >= 0) {
+    sys::Process::SafelyCloseFileDescriptor(m_segmentLockFd);
+    m_segmentLockFd = -1;
+    std::lock_guard<std::mutex> claimedSegmentsLock(ClaimedSegmentsLock);
+    ClaimedSegments.erase(m_fileFullPath);
+  }
   resetRuntimeCache();
 }
 
 // =====================================================================================================================
 // Resets the runtime shader cache to an empty state. Releases all allocator memory and decommits it back to the OS.
 void ShaderCache::resetRuntimeCache() {
-  for (auto indexMap : m_shaderIndexMap)
-    delete indexMap.second;
-  m_shaderIndexMap.clear();
+  for (ShaderIndexShard &shard : m_shards) {
+    for (auto indexMap : shard.indexMap)
+      delete indexMap.second;
+    shard.indexMap.clear();
+  }
 
-  for (auto allocIt : m_allocationList)
-    delete[] allocIt.first;
-  m_allocationList.clear();
+  m_mappedFile.reset();
+  m_fileJournal.clear();
+  m_fileJournalShaders = 0;
+  m_contents.clear();
+  m_fileContents.clear();
 
   m_totalShaders = 0;
   m_shaderDataEnd = sizeof(ShaderCacheSerializedHeader);
-  m_serializedSize = sizeof(ShaderCacheSerializedHeader);
+  m_liveDataSize = 0;
 }
 
 // =====================================================================================================================
@@ -161,43 +202,30 @@ Result ShaderCache::Serialize(void *blob, size_t *size) {
   Result result = Result::Success;
 
   if (*size == 0) {
-    // Query shader cache serialized size
-    (*size) = m_serializedSize;
+    // Query shader cache serialized size. Entries with identical shader data share it, so this is less than the size
+    // of the shader data of all entries.
+    ShaderCacheSerializedPieces pieces;
+    lockCacheMap(true);
+    collectSerializedPieces(&pieces, nullptr);
+    unlockCacheMap(true);
+    (*size) = pieces.size;
   } else {
-    // Do serialize
-    assert(m_shaderDataEnd == m_serializedSize || m_shaderDataEnd == sizeof(ShaderCacheSerializedHeader));
-
-    if (m_serializedSize >= sizeof(ShaderCacheSerializedHeader)) {
-      if (blob && (*size) >= m_serializedSize) {
-        // First construct the header and copy it into the memory provided
-        ShaderCacheSerializedHeader header = {};
-        header.headerSize = sizeof(ShaderCacheSerializedHeader);
-        header.shaderCount = m_totalShaders;
-        header.shaderDataEnd = m_shaderDataEnd;
-        getBuildTime(&header.buildId);
-
-        memcpy(blob, &header, sizeof(ShaderCacheSerializedHeader));
-
-        void *dataDst = voidPtrInc(blob, sizeof(ShaderCacheSerializedHeader));
-
-        // Then iterate through all allocators (which hold the backing memory for the shader data)
-        // and copy their contents to the blob.
-        for (auto it : m_allocationList) {
-          assert(it.first);
-
-          const size_t copySize = it.second;
-          if (voidPtrDiff(dataDst, blob) + copySize > (*size)) {
-            result = Result::ErrorUnknown;
-            break;
-          }
-
-          memcpy(dataDst, it.first, copySize);
-          dataDst = voidPtrInc(dataDst, copySize);
-        }
-      } else {
-        llvm_unreachable("Should never be called!");
-        result = Result::ErrorUnknown;
+    // Do serialize, by copying the pieces that refer to the shader data into the blob.
+    ShaderCacheSerializedPieces pieces;
+    result = serializePieces(&pieces);
+    if (result != Result::Success)
+      return result;
+
+    if (blob && (*size) >= pieces.size) {
+      memcpy(blob, &pieces.header, sizeof(ShaderCacheSerializedHeader));
+      void *dataDst = voidPtrInc(blob, sizeof(ShaderCacheSerializedHeader));
+      for (ArrayRef<uint8_t> piece : pieces.pieces) {
+        memcpy(dataDst, piece.data(), piece.size());
+        dataDst = voidPtrInc(dataDst, piece.size());
       }
+    } else {
+      llvm_unreachable("Should never be called!");
+      result = Result::ErrorUnknown;
     }
   }
 
@@ -205,7 +233,108 @@ Result ShaderCache::Serialize(void *blob, size_t *size) {
 }
 
 // =====================================================================================================================
-// Merges the shader data of source shader caches into this shader cache.
+// Serializes the shader cache as pieces that refer to the data of its entries instead of copying it. Like Serialize,
+// the shader data still held in the file journal is appended to the on-disk file first.
+//
+// @param [out] pieces : The serialized shader cache
+Result ShaderCache::serializePieces(ShaderCacheSerializedPieces *pieces) {
+  {
+    std::lock_guard<sys::Mutex> storageLock(m_lock);
+    Result result = flushFileJournal();
+    if (result != Result::Success)
+      return result;
+  }
+
+  lockCacheMap(true);
+  collectSerializedPieces(pieces, nullptr);
+  unlockCacheMap(true);
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Collects the records of the entries in the cache as pieces that refer to their data. The first entry with a given
+// content hash gets a full record, and the entries with the same shader data after it get reference records.
+//
+// NOTE: This function assumes that the whole cache map has been locked by the calling function.
+//
+// @param [out] pieces : The serialized shader cache
+// @param [out] writtenContents : If not nullptr, the shader data stored in full records, by content hash
+void ShaderCache::collectSerializedPieces(ShaderCacheSerializedPieces *pieces, ShaderContentMap *writtenContents) {
+  pieces->pieces.clear();
+  pieces->storage.clear();
+  size_t dataSize = 0;
+  size_t shaderCount = 0;
+
+  // The headers of records that do not have a copy next to the shader data in memory. Space for all entries is
+  // reserved up front, so that the pieces referring to them stay valid.
+  size_t entryCount = 0;
+  for (const ShaderIndexShard &shard : m_shards)
+    entryCount += shard.indexMap.size();
+  auto headers = std::make_shared<std::vector<ShaderHeader>>();
+  headers->reserve(entryCount);
+
+  ShaderContentMap contents;
+  if (!writtenContents)
+    writtenContents = &contents;
+  writtenContents->clear();
+
+  auto addPiece = [&](const void *piece, size_t size) {
+    const auto *data = static_cast<const uint8_t *>(piece);
+    if (!pieces->pieces.empty() && pieces->pieces.back().end() == data)
+      pieces->pieces.back() = ArrayRef<uint8_t>(pieces->pieces.back().data(), pieces->pieces.back().size() + size);
+    else
+      pieces->pieces.push_back(ArrayRef<uint8_t>(data, size));
+    dataSize += size;
+  };
+
+  // Only the data of the entries still in the cache is serialized. Entries that were loaded together are adjacent in
+  // memory, so their data is coalesced into one piece when the map happens to visit them in order.
+  for (ShaderIndexShard &shard : m_shards) {
+    for (auto it : shard.indexMap) {
+      const ShaderIndex *index = it.second;
+      if (index->state != ShaderEntryState::Ready || !index->dataBlob)
+        continue;
+      assert(index->storage);
+      const ShaderHeader &header = index->header;
+      const size_t storedSize = header.size - sizeof(ShaderHeader);
+      bool isReference = false;
+      if (header.contentHash != 0) {
+        auto inserted = writtenContents->try_emplace(header.contentHash, ShaderContent{header.crc, storedSize, {}});
+        isReference = !inserted.second && inserted.first->second.crc == header.crc &&
+                      inserted.first->second.size == storedSize;
+      }
+
+      if (isReference) {
+        headers->push_back(header);
+        headers->back().recordSize = sizeof(ShaderHeader);
+        addPiece(&headers->back(), sizeof(ShaderHeader));
+        ++shaderCount;
+        continue;
+      }
+      if (index->sharedData) {
+        headers->push_back(header);
+        addPiece(&headers->back(), sizeof(ShaderHeader));
+        addPiece(index->dataBlob, storedSize);
+      } else
+        addPiece(static_cast<const ShaderHeader *>(index->dataBlob) - 1, header.size);
+      if (pieces->storage.empty() || pieces->storage.back() != index->storage)
+        pieces->storage.push_back(index->storage);
+      ++shaderCount;
+    }
+  }
+  pieces->storage.push_back(std::move(headers));
+
+  pieces->header = {};
+  pieces->header.headerSize = sizeof(ShaderCacheSerializedHeader);
+  pieces->header.shaderCount = shaderCount;
+  pieces->header.shaderDataEnd = sizeof(ShaderCacheSerializedHeader) + dataSize;
+  getBuildTime(&pieces->header.buildId);
+  pieces->size = pieces->header.shaderDataEnd;
+}
+
+// =====================================================================================================================
+// Merges the shader data of source shader caches into this shader cache. The data is not copied: a merged entry shares
+// the memory of the source entry, which stays alive until both caches have released it.
 //
 // @param srcCacheCount : Count of input source shader caches
 // @param ppSrcCaches : Input shader caches
@@ -221,22 +350,30 @@ Result ShaderCache::Merge(unsigned srcCacheCount, const IShaderCache **ppSrcCach
     ShaderCache *srcCache = static_cast<ShaderCache *>(const_cast<IShaderCache *>(ppSrcCaches[i]));
     srcCache->lockCacheMap(true);
 
-    for (auto it : srcCache->m_shaderIndexMap) {
-      uint64_t key = it.first;
+    for (ShaderIndexShard &srcShard : srcCache->m_shards) {
+      for (auto it : srcShard.indexMap) {
+        uint64_t key = it.first;
+        ShaderIndexMap &indexMap = getShard(key).indexMap;
 
-      auto indexMap = m_shaderIndexMap.find(key);
-      if (indexMap == m_shaderIndexMap.end()) {
-        ShaderIndex *index = nullptr;
-        void *mem = getCacheSpace(it.second->header.size);
-        memcpy(mem, it.second->dataBlob, it.second->header.size);
+        if (indexMap.find(key) != indexMap.end())
+          continue;
 
-        index = new ShaderIndex;
-        index->dataBlob = mem;
+        if (it.second->state != ShaderEntryState::Ready || !it.second->dataBlob)
+          continue;
+
+        assert(it.second->storage);
+        ShaderIndex *index = new ShaderIndex;
+        index->storage = it.second->storage;
+        index->dataBlob = it.second->dataBlob;
+        index->crcPending = it.second->crcPending;
+        index->sharedData = it.second->sharedData;
         index->state = ShaderEntryState::Ready;
         index->header = it.second->header;
+        registerContent(index);
 
-        m_shaderIndexMap[key] = index;
+        indexMap[key] = index;
         m_totalShaders++;
+        m_liveDataSize += index->header.size;
       }
     }
     srcCache->unlockCacheMap(true);
@@ -244,9 +381,164 @@ Result ShaderCache::Merge(unsigned srcCacheCount, const IShaderCache **ppSrcCach
 
   unlockCacheMap(false);
 
+  enforceBudgets();
+
   return result;
 }
 
+// =====================================================================================================================
+// Loads a shader cache file, as written by writePackedFile or by an on-disk cache, into this runtime shader cache,
+// which must be empty. Unlike initial data given at creation, a file that does not match this build of LLPC, or whose
+// shader data is corrupted, is reported as an error.
+//
+// @param filePath : Path of the shader cache file
+Result ShaderCache::loadFile(const char *filePath) {
+  assert(m_fileFullPath[0] == '\0' && m_totalShaders == 0);
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> fileOrErr =
+      MemoryBuffer::getFile(filePath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!fileOrErr)
+    return Result::NotFound;
+  const MemoryBuffer &file = **fileOrErr;
+  if (file.getBufferSize() < sizeof(ShaderCacheSerializedHeader))
+    return Result::ErrorInvalidValue;
+
+  lockCacheMap(false);
+  Result result = loadCacheFromBlob(file.getBufferStart(), file.getBufferSize());
+  if (result != Result::Success)
+    resetRuntimeCache();
+  unlockCacheMap(false);
+  return result;
+}
+
+// =====================================================================================================================
+// Writes the shader cache to a standalone file that can be shipped with an application and loaded by the on-disk
+// cache, including in read-only mode. The records are sorted by key, so that the file does not depend on the order in
+// which the entries were added or merged. An entry whose shader data is identical to that of an earlier entry is
+// written as a reference record. When compress is set, entries that are not compressed yet are compressed with LZ4, if
+// that makes them smaller.
+//
+// @param filePath : Path of the file to write
+// @param compress : Whether to compress the entries that are not compressed yet
+// @param [out] stats : If not nullptr, the statistics of the written file
+Result ShaderCache::writePackedFile(const char *filePath, bool compress, ShaderCachePackStats *stats) {
+  {
+    std::lock_guard<sys::Mutex> storageLock(m_lock);
+    Result result = flushFileJournal();
+    if (result != Result::Success)
+      return result;
+  }
+
+  // The shards are locked for write, as the CRCs that were deferred at load are verified before the data is packed.
+  for (ShaderIndexShard &shard : m_shards)
+    lockShard(shard, false);
+
+  std::vector<ShaderIndex *> entries;
+  for (ShaderIndexShard &shard : m_shards) {
+    for (auto it : shard.indexMap) {
+      ShaderIndex *index = it.second;
+      if (index->state != ShaderEntryState::Ready || !index->dataBlob)
+        continue;
+      checkDeferredCrc(index);
+      if (index->state == ShaderEntryState::Ready)
+        entries.push_back(index);
+    }
+  }
+  llvm::sort(entries, [](const ShaderIndex *lhs, const ShaderIndex *rhs) { return lhs->header.key < rhs->header.key; });
+
+  ShaderCachePackStats packStats = {};
+  std::vector<uint8_t> fileData(sizeof(ShaderCacheSerializedHeader));
+  ShaderContentMap writtenContents;
+  std::vector<uint8_t> compressedData;
+  for (const ShaderIndex *index : entries) {
+    ShaderHeader header = index->header;
+    const void *data = index->dataBlob;
+    size_t storedSize = header.size - sizeof(ShaderHeader);
+
+    bool compressed = false;
+    if (compress && header.uncompressedSize == 0) {
+      compressedData.resize(getLz4BlockBound(storedSize));
+      const size_t compressedSize = compressLz4Block(data, storedSize, compressedData.data(), compressedData.size());
+      if (compressedSize != 0 && compressedSize < storedSize) {
+        data = compressedData.data();
+        header.uncompressedSize = storedSize;
+        storedSize = compressedSize;
+        header.size = storedSize + sizeof(ShaderHeader);
+        header.crc = calculateCrc(static_cast<const uint8_t *>(data), storedSize);
+        header.contentHash = calculateContentHash(data, storedSize);
+        compressed = true;
+      }
+    }
+
+    // As in collectSerializedPieces, the shader data is identified by its content hash, CRC and size.
+    bool isReference = false;
+    if (header.contentHash != 0) {
+      auto inserted = writtenContents.try_emplace(header.contentHash, ShaderContent{header.crc, storedSize, {}});
+      if (!inserted.second) {
+        isReference = inserted.first->second.crc == header.crc && inserted.first->second.size == storedSize;
+        if (!isReference)
+          header.contentHash = 0;
+      }
+    }
+
+    header.recordSize = isReference ? sizeof(ShaderHeader) : header.size;
+    const auto *headerBytes = reinterpret_cast<const uint8_t *>(&header);
+    fileData.insert(fileData.end(), headerBytes, headerBytes + sizeof(ShaderHeader));
+    if (isReference)
+      ++packStats.referenceCount;
+    else {
+      const auto *dataBytes = static_cast<const uint8_t *>(data);
+      fileData.insert(fileData.end(), dataBytes, dataBytes + storedSize);
+      if (compressed)
+        ++packStats.compressedCount;
+    }
+    ++packStats.shaderCount;
+  }
+
+  for (ShaderIndexShard &shard : m_shards)
+    unlockShard(shard, false);
+
+  ShaderCacheSerializedHeader fileHeader = {};
+  fileHeader.headerSize = sizeof(ShaderCacheSerializedHeader);
+  fileHeader.shaderCount = packStats.shaderCount;
+  fileHeader.shaderDataEnd = fileData.size();
+  getBuildTime(&fileHeader.buildId);
+  memcpy(fileData.data(), &fileHeader, sizeof(fileHeader));
+  packStats.fileSize = fileData.size();
+
+  File file;
+  Result result = file.open(filePath, FileAccessWrite | FileAccessBinary);
+  if (result == Result::Success)
+    result = file.write(fileData.data(), fileData.size());
+  if (result == Result::Success)
+    result = file.flush();
+  if (result == Result::Success && stats)
+    *stats = packStats;
+  return result;
+}
+
+// =====================================================================================================================
+// Reads the build ID in the header of a shader cache file, which gives the graphics IP and the hash of the compilation
+// options that a cache must be created with to load it.
+//
+// @param filePath : Path of the shader cache file
+// @param [out] buildId : The build ID of the file
+Result ShaderCache::readFileBuildId(const char *filePath, BuildUniqueId *buildId) {
+  File file;
+  Result result = file.open(filePath, FileAccessRead | FileAccessBinary);
+  if (result != Result::Success)
+    return result;
+
+  ShaderCacheSerializedHeader header = {};
+  result = file.read(&header, sizeof(header), nullptr);
+  if (result != Result::Success)
+    return result;
+  if (header.headerSize != sizeof(ShaderCacheSerializedHeader))
+    return Result::ErrorInvalidValue;
+  *buildId = header.buildId;
+  return Result::Success;
+}
+
 // =====================================================================================================================
 // Initializes the Shader Cache in late stage.
 //
@@ -260,6 +552,8 @@ Result ShaderCache::init(const ShaderCacheCreateInfo *createInfo, const ShaderCa
     m_clientData = createInfo->pClientData;
     m_getValueFunc = createInfo->pfnGetValueFunc;
     m_storeValueFunc = createInfo->pfnStoreValueFunc;
+    m_maxMemorySize = createInfo->maxMemorySize;
+    m_maxFileSize = createInfo->maxFileSize;
     m_gfxIp = auxCreateInfo->gfxIp;
     m_hash = auxCreateInfo->hash;
 
@@ -282,6 +576,20 @@ Result ShaderCache::init(const ShaderCacheCreateInfo *createInfo, const ShaderCa
       result = buildFileName(auxCreateInfo->executableName, auxCreateInfo->cacheFilePath, auxCreateInfo->gfxIp,
                              &cacheFileExists);
 
+      // A segmented cache appends to a segment of its own, which is the cache file from here on.
+      if (result == Result::Success && ShaderCacheSegmented)
+        result = claimSegment(&cacheFileExists);
+
+      // A shared file is loaded or created under the file lock, as another process may be appending to it. It may
+      // also have been created since we checked for it.
+      if (result == Result::Success && ShaderCacheSharedFile && !ShaderCacheSegmented) {
+        result = openLockFile();
+        if (result == Result::Success)
+          result = lockCacheFile();
+        if (result == Result::Success)
+          cacheFileExists = File::exists(m_fileFullPath);
+      }
+
       if (result == Result::Success) {
         // Open the storage file if it exists
         if (cacheFileExists) {
@@ -309,6 +617,15 @@ Result ShaderCache::init(const ShaderCacheCreateInfo *createInfo, const ShaderCa
       // any memory allocated
       if (loadResult != Result::Success)
         resetRuntimeCache();
+
+      unlockCacheFile();
+
+      // The segments that other processes of the same build append to are loaded after the cache's own segment, as
+      // only the shader data of its own segment can be referred to by the records appended to it.
+      if (result == Result::Success && m_segmentLockFd >= 0) {
+        addSegmentToIndex();
+        loadSegments();
+      }
     }
 
     unlockCacheMap(false);
@@ -346,6 +663,21 @@ Result ShaderCache::buildFileName(const char *executableName, const char *cacheF
         snprintf(m_fileFullPath, PathBufferLen, "%s%s%s", cacheFilePath, CacheFileSubPath, ShaderCacheFilename.c_str());
   }
 
+  // The directory of a segmented cache is shared by the GPUs of the host, whose segments are told apart by their names.
+  if (ShaderCacheSegmented) {
+    SmallString<PathBufferLen> segmentDir(cacheFilePath);
+    segmentDir += CacheFileSubPath;
+    if (ShaderCacheFilename.empty()) {
+      length = snprintf(hashedFileName, PathBufferLen, "%s.%s", executableName, ClientStr);
+      length = snprintf(hashedFileName, PathBufferLen, "%08x.segments", djbHash(hashedFileName, 0));
+      segmentDir += hashedFileName;
+    } else {
+      segmentDir += ShaderCacheFilename;
+      segmentDir += ".segments";
+    }
+    m_segmentDir = segmentDir.str().str();
+  }
+
   assert(cacheFileExists);
   *cacheFileExists = File::exists(m_fileFullPath);
   Result result = Result::Success;
@@ -360,10 +692,215 @@ Result ShaderCache::buildFileName(const char *executableName, const char *cacheF
   return result;
 }
 
+// =====================================================================================================================
+// Opens the lock file that serializes the accesses to a shared cache file. The lock file is next to the cache file and
+// is kept open until the cache is destroyed. It is separate from the cache file, because the cache file is reopened
+// when it is reset, which would release a lock held on it.
+Result ShaderCache::openLockFile() {
+  std::string lockFileName = (Twine(m_fileFullPath) + ".lock").str();
+  std::error_code errCode =
+      sys::fs::openFileForWrite(lockFileName, m_lockFileFd, sys::fs::CD_OpenAlways, sys::fs::OF_None);
+  if (errCode) {
+    LLPC_ERRS("Failed to open shader cache lock file: " << lockFileName << "\n");
+    m_lockFileFd = -1;
+    return Result::ErrorUnavailable;
+  }
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Takes the lock of a shared cache file, waiting for other processes to release it. Does nothing if the cache file is
+// not shared.
+Result ShaderCache::lockCacheFile() {
+  if (m_lockFileFd < 0)
+    return Result::Success;
+  if (std::error_code errCode = sys::fs::lockFile(m_lockFileFd)) {
+    LLPC_ERRS("Failed to lock shader cache file: " << m_fileFullPath << "\n");
+    return Result::ErrorUnknown;
+  }
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Releases the lock of a shared cache file taken by lockCacheFile.
+void ShaderCache::unlockCacheFile() {
+  if (m_lockFileFd >= 0)
+    (void)sys::fs::unlockFile(m_lockFileFd);
+}
+
+// =====================================================================================================================
+// Claims a segment of a segmented cache, which becomes the cache file that this cache loads first and appends to. The
+// segments of one build of the compiler for one GPU are named after a hash of its unique ID, and one is claimed by
+// locking its lock file, which stays locked until the cache is destroyed. The lock is not exclusive between caches in
+// the same process, so they also record the segments they claimed in a set of the process. The segments of other
+// builds (or of other GPUs) are left alone, so that their processes keep their cache.
+//
+// @param [out] cacheFileExists : Whether the claimed segment exists
+Result ShaderCache::claimSegment(bool *cacheFileExists) {
+  if (std::error_code errCode = sys::fs::create_directories(m_segmentDir)) {
+    LLPC_ERRS("Failed to create shader cache directory: " << m_segmentDir << "\n");
+    return Result::ErrorUnavailable;
+  }
+
+  const std::string prefix = getSegmentPrefix();
+  for (unsigned segment = 0; segment < MaxSegmentsPerBuild; ++segment) {
+    SmallString<PathBufferLen> segmentPath(m_segmentDir);
+    sys::path::append(segmentPath, prefix + Twine(segment) + ".bin");
+    std::lock_guard<std::mutex> claimedSegmentsLock(ClaimedSegmentsLock);
+    if (ClaimedSegments.count(segmentPath.str().str()) != 0)
+      continue;
+    int lockFileFd = -1;
+    if (sys::fs::openFileForWrite(segmentPath + ".lock", lockFileFd, sys::fs::CD_OpenAlways, sys::fs::OF_None))
+      continue;
+    if (sys::fs::tryLockFile(lockFileFd)) {
+      // Another process appends to this segment.
+      sys::Process::SafelyCloseFileDescriptor(lockFileFd);
+      continue;
+    }
+    ClaimedSegments.insert(segmentPath.str().str());
+    m_segmentLockFd = lockFileFd;
+    snprintf(m_fileFullPath, PathBufferLen, "%s", segmentPath.c_str());
+    *cacheFileExists = File::exists(m_fileFullPath);
+    return Result::Success;
+  }
+
+  LLPC_ERRS("Failed to claim a segment of shader cache directory: " << m_segmentDir << "\n");
+  return Result::ErrorUnavailable;
+}
+
+// =====================================================================================================================
+// Returns the prefix of the names of the segments of this build of the compiler, with the graphics IP and compilation
+// options of the cache.
+std::string ShaderCache::getSegmentPrefix() {
+  BuildUniqueId buildId;
+  getBuildTime(&buildId);
+  uint64_t hash = 0;
+  Util::MetroHash64::Hash(reinterpret_cast<const uint8_t *>(&buildId), sizeof(buildId),
+                          reinterpret_cast<uint8_t *>(&hash));
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), "%016" PRIx64 ".", hash);
+  return prefix;
+}
+
+// =====================================================================================================================
+// Reads the names of the segments listed in the index of a segmented cache. Returns no names if there is no index yet.
+std::vector<std::string> ShaderCache::readSegmentIndex() {
+  SmallString<PathBufferLen> indexPath(m_segmentDir);
+  sys::path::append(indexPath, SegmentIndexName);
+  std::vector<std::string> segmentNames;
+  ErrorOr<std::unique_ptr<MemoryBuffer>> index = MemoryBuffer::getFile(indexPath);
+  if (!index)
+    return segmentNames;
+
+  SmallVector<StringRef, 16> lines;
+  (*index)->getBuffer().split(lines, '\n', -1, /*KeepEmpty=*/false);
+  for (StringRef line : lines)
+    segmentNames.push_back(line.str());
+  return segmentNames;
+}
+
+// =====================================================================================================================
+// Adds the segment of this cache to the index of the segments, unless it is listed already. The index is updated under
+// its lock file, by writing a new index and renaming it over the old one, so that it can be read without the lock and
+// only ever lists segments whose header has been written.
+void ShaderCache::addSegmentToIndex() {
+  SmallString<PathBufferLen> indexPath(m_segmentDir);
+  sys::path::append(indexPath, SegmentIndexName);
+  int lockFileFd = -1;
+  if (sys::fs::openFileForWrite(indexPath + ".lock", lockFileFd, sys::fs::CD_OpenAlways, sys::fs::OF_None)) {
+    LLPC_ERRS("Failed to open shader cache index lock file: " << indexPath << ".lock\n");
+    return;
+  }
+
+  if (!sys::fs::lockFile(lockFileFd)) {
+    std::vector<std::string> segmentNames = readSegmentIndex();
+    const StringRef segmentName = sys::path::filename(m_fileFullPath);
+    if (!is_contained(segmentNames, segmentName)) {
+      segmentNames.push_back(segmentName.str());
+      const std::string newIndexPath = (indexPath + ".tmp").str();
+      std::error_code errCode;
+      {
+        raw_fd_ostream newIndex(newIndexPath, errCode, sys::fs::OF_None);
+        if (!errCode) {
+          for (const std::string &name : segmentNames)
+            newIndex << name << "\n";
+          newIndex.close();
+          errCode = newIndex.error();
+        }
+      }
+      if (!errCode)
+        errCode = sys::fs::rename(newIndexPath, indexPath);
+      if (errCode)
+        LLPC_ERRS("Failed to update shader cache index: " << indexPath << "\n");
+    }
+    (void)sys::fs::unlockFile(lockFileFd);
+  }
+  sys::Process::SafelyCloseFileDescriptor(lockFileFd);
+}
+
+// =====================================================================================================================
+// Loads the other segments of this build of the compiler that are listed in the index. The segments of other builds are
+// skipped, and so is a segment that fails to load, keeping the entries loaded from it before the failure. The counts
+// of the cache file stay those of the cache's own segment.
+//
+// NOTE: This function assumes that a write lock has already been taken by the calling function.
+void ShaderCache::loadSegments() {
+  const std::string prefix = getSegmentPrefix();
+  const std::string ownSegmentName = sys::path::filename(m_fileFullPath).str();
+  const size_t totalShaders = m_totalShaders;
+  const size_t shaderDataEnd = m_shaderDataEnd;
+
+  for (const std::string &segmentName : readSegmentIndex()) {
+    if (!StringRef(segmentName).startswith(prefix) || segmentName == ownSegmentName)
+      continue;
+    SmallString<PathBufferLen> segmentPath(m_segmentDir);
+    sys::path::append(segmentPath, segmentName);
+    if (loadSegment(segmentPath.c_str()) != Result::Success)
+      LLPC_ERRS("Skipped invalid shader cache segment: " << segmentPath << "\n");
+  }
+
+  m_totalShaders = totalShaders;
+  m_shaderDataEnd = shaderDataEnd;
+}
+
+// =====================================================================================================================
+// Loads the shader data of a segment that another process appends to. Only the data before the data end in its header
+// is read, as the data after that may still be being appended.
+//
+// NOTE: This function assumes that a write lock has already been taken by the calling function.
+//
+// @param segmentPath : Path of the segment
+Result ShaderCache::loadSegment(const char *segmentPath) {
+  File segmentFile;
+  Result result = segmentFile.open(segmentPath, (FileAccessRead | FileAccessBinary));
+  if (result != Result::Success)
+    return result;
+
+  ShaderCacheSerializedHeader header = {};
+  result = segmentFile.read(&header, sizeof(ShaderCacheSerializedHeader), nullptr);
+  if (result == Result::Success)
+    result = validateAndLoadHeader(&header, File::getFileSize(segmentPath));
+
+  if (result == Result::Success) {
+    const size_t dataSize = m_shaderDataEnd - sizeof(ShaderCacheSerializedHeader);
+    std::shared_ptr<uint8_t> dataMem = getCacheSpace(dataSize);
+    size_t bytesRead = 0;
+    result = segmentFile.read(dataMem.get(), dataSize, &bytesRead);
+    if (result == Result::Success && bytesRead != dataSize)
+      result = Result::ErrorUnknown;
+    if (result == Result::Success)
+      result = populateIndexMap(dataMem.get(), dataSize, dataMem);
+  }
+
+  segmentFile.close();
+  return result;
+}
+
 // =====================================================================================================================
 // Resets the contents of the cache file, assumes the shader cache has been locked for writes.
 void ShaderCache::resetCacheFile() {
   m_onDiskFile.close();
+  m_fileContents.clear();
   const unsigned accessFlags = FileAccessRead | FileAccessWrite | FileAccessBinary;
   mustSucceed(m_onDiskFile.open(m_fileFullPath, accessFlags),
               Twine("Failed to open shader cache file: ") + m_fileFullPath);
@@ -402,91 +939,69 @@ ShaderEntryState ShaderCache::findShader(MetroHash::Hash hash, bool allocateOnMi
   Result mapResult = Result::Success;
   assert(phEntry);
 
-  bool readOnlyLock = (!allocateOnMiss);
-  lockCacheMap(readOnlyLock);
   uint64_t hashKey = MetroHash::compact64(&hash);
-  auto indexMap = m_shaderIndexMap.find(hashKey);
-  if (indexMap != m_shaderIndexMap.end()) {
+  ShaderIndexShard &shard = getShard(hashKey);
+
+  // Fast path: look the entry up under a shared lock of its shard. If it is ready, there is nothing to modify, so
+  // concurrent hits do not serialize.
+  lockShard(shard, true);
+  auto indexMap = shard.indexMap.find(hashKey);
+  if (indexMap != shard.indexMap.end() && indexMap->second->state == ShaderEntryState::Ready &&
+      !indexMap->second->crcPending) {
+    index = indexMap->second;
+    assert(index->dataBlob && index->header.size != 0);
+    index->lastAccess = ++m_accessTick;
+    recordFirstAccess(index, hashKey);
+    ++index->useCount;
+    *phEntry = index;
+    unlockShard(shard, true);
+    return ShaderEntryState::Ready;
+  }
+  unlockShard(shard, true);
+
+  // Slow path: the entry is missing, new or being compiled, so we may need to modify it. Take the write lock of the
+  // shard and look it up again, as another thread may have changed it in the meantime.
+  bool readOnlyLock = false;
+  lockShard(shard, readOnlyLock);
+  indexMap = shard.indexMap.find(hashKey);
+  if (indexMap != shard.indexMap.end()) {
     existed = true;
     index = indexMap->second;
+
+    checkDeferredCrc(index);
   } else if (allocateOnMiss) {
     index = new ShaderIndex;
-    m_shaderIndexMap[hashKey] = index;
+    shard.indexMap[hashKey] = index;
   }
 
   if (!index)
     mapResult = Result::ErrorUnavailable;
 
   if (mapResult == Result::Success) {
-    if (existed) {
-      // We don't need to hold on to the write lock if we're not the one doing the compile
-      if (!readOnlyLock) {
-        unlockCacheMap(readOnlyLock);
-        readOnlyLock = true;
-        lockCacheMap(readOnlyLock);
-      }
-    } else {
-      bool needsInit = true;
-
+    if (!existed) {
       // We didn't find the entry in our own hash map, now search the external cache if available
-      if (useExternalCache()) {
-        // The first call to the external cache queries the existence and the size of the cached shader.
-        Result extResult = m_getValueFunc(m_clientData, hashKey, nullptr, &index->header.size);
-        if (extResult == Result::Success) {
-          // An entry was found matching our hash, we should allocate memory to hold the data and call again
-          assert(index->header.size > 0);
-          index->dataBlob = getCacheSpace(index->header.size);
-
-          if (!index->dataBlob)
-            extResult = Result::ErrorOutOfMemory;
-          else {
-            extResult = m_getValueFunc(m_clientData, hashKey, index->dataBlob, &index->header.size);
-          }
-        }
-
-        if (extResult == Result::Success) {
-          // We now have a copy of the shader data from the external cache, just need to update the
-          // ShaderIndex. The first item in the data blob is a ShaderHeader, followed by the serialized
-          // data blob for the shader.
-          const auto *const header = static_cast<const ShaderHeader *>(index->dataBlob);
-          assert(index->header.size == header->size);
-
-          index->header = (*header);
-          index->state = ShaderEntryState::Ready;
-          needsInit = false;
-        } else if (extResult == Result::ErrorUnavailable) {
-          // This means the external cache is unavailable and we shouldn't bother using it anymore. To
-          // prevent useless calls we'll zero out the function pointers.
-          m_getValueFunc = nullptr;
-          m_storeValueFunc = nullptr;
-        } else {
-          // extResult should never be ErrorInvalidMemorySize since Cache space is always allocated based
-          // on 1st m_pfnGetValueFunc call.
-          assert(extResult != Result::ErrorOutOfMemory);
-
-          // Any other result means we just need to continue with initializing the new index/compiling.
-        }
-      }
-
-      if (needsInit) {
+      if (!loadFromExternalCache(hashKey, index)) {
         // This is a brand new cache entry so we need to initialize the ShaderIndex.
-        memset(index, 0, sizeof(*index));
+        index->header = {};
         index->header.key = hashKey;
         index->state = ShaderEntryState::New;
+        index->dataBlob = nullptr;
       }
     } // End if (existed == false)
 
     if (index->state == ShaderEntryState::Compiling) {
       // The shader is being compiled by another thread, we should release the lock and wait for it to complete.
-      // This uses the same lock as lock/unlockCacheMap.
-      CacheMapLock lock = makeCacheLock(readOnlyLock);
-      m_conditionVariable.wait(lock, [index] {
+      // Only threads waiting on this entry are woken when the compile finishes.
+      if (!index->compileDone)
+        index->compileDone = std::make_unique<std::condition_variable_any>();
+      ShardLock lock(shard, readOnlyLock);
+      index->compileDone->wait(lock, [index] {
         // The lock must have been acquired by the time we enter this lambda.
         return index->state != ShaderEntryState::Compiling;
       });
       // At this point the shader entry is either Ready, New or something failed. We've already
       // initialized our result code to an error code above, the Ready and New cases are handled below so
-      // nothing else to do here. The cache lock is in the locked state after waiting.
+      // nothing else to do here. The shard lock is in the locked state after waiting.
       assert(index->state != ShaderEntryState::Compiling);
     }
 
@@ -499,16 +1014,222 @@ ShaderEntryState ShaderCache::findShader(MetroHash::Hash hash, bool allocateOnMi
       index->state = ShaderEntryState::Compiling;
     }
 
-    // Return the ShaderIndex as a handle so subsequent calls into the cache can avoid the hash map lookup.
+    // Return the ShaderIndex as a handle so subsequent calls into the cache can avoid the hash map lookup. The entry is
+    // not evicted until the handle is released.
     (*phEntry) = index;
     result = index->state;
+    index->lastAccess = ++m_accessTick;
+    recordFirstAccess(index, hashKey);
+    ++index->useCount;
   }
 
-  unlockCacheMap(readOnlyLock);
+  unlockShard(shard, readOnlyLock);
 
   return result;
 }
 
+// =====================================================================================================================
+// Verifies the CRC of an entry loaded from a mapped cache file, if that was deferred to its first access. If its data
+// is corrupted, the entry is treated like an entry whose compilation previously failed, so that it is compiled again.
+//
+// NOTE: This function assumes that a write lock on the entry's shard has been taken by the calling function.
+//
+// @param [in/out] index : Shader index entry to verify
+void ShaderCache::checkDeferredCrc(ShaderIndex *index) {
+  if (!index->crcPending || verifyDeferredCrc(index))
+    return;
+  {
+    std::lock_guard<sys::Mutex> storageLock(m_lock);
+    m_liveDataSize -= index->header.size;
+  }
+  index->state = ShaderEntryState::New;
+  index->header.size = 0;
+  index->dataBlob = nullptr;
+}
+
+// =====================================================================================================================
+// Searches the external cache, if available, for the shader with the given key, and copies it into the entry. Returns
+// true if the entry is ready now.
+//
+// NOTE: This function assumes that a write lock on the entry's shard has been taken by the calling function.
+//
+// @param hashKey : Key of the shader
+// @param [in/out] index : Shader index entry to fill in
+bool ShaderCache::loadFromExternalCache(uint64_t hashKey, ShaderIndex *index) {
+  if (!useExternalCache())
+    return false;
+
+  // The first call to the external cache queries the existence and the size of the cached shader.
+  Result extResult = m_getValueFunc(m_clientData, hashKey, nullptr, &index->header.size);
+  if (extResult == Result::Success) {
+    // An entry was found matching our hash, we should allocate memory to hold the data and call again
+    assert(index->header.size > 0);
+    uint8_t *record = nullptr;
+    {
+      std::lock_guard<sys::Mutex> storageLock(m_lock);
+      record = getEntrySpace(index, index->header.size);
+    }
+
+    if (!record)
+      extResult = Result::ErrorOutOfMemory;
+    else {
+      extResult = m_getValueFunc(m_clientData, hashKey, record, &index->header.size);
+    }
+
+    if (extResult == Result::Success) {
+      // We now have a copy of the shader data from the external cache, just need to update the
+      // ShaderIndex. The first item in the record is a ShaderHeader, followed by the serialized
+      // data blob for the shader.
+      const auto *const header = reinterpret_cast<const ShaderHeader *>(record);
+      assert(index->header.size == header->size);
+
+      index->header = (*header);
+      index->dataBlob = record + sizeof(ShaderHeader);
+      index->sharedData = false;
+      index->state = ShaderEntryState::Ready;
+
+      std::lock_guard<sys::Mutex> storageLock(m_lock);
+      m_liveDataSize += index->header.size;
+      registerContent(index);
+      return true;
+    }
+  }
+
+  if (extResult == Result::ErrorUnavailable) {
+    // This means the external cache is unavailable and we shouldn't bother using it anymore. To
+    // prevent useless calls we'll zero out the function pointers.
+    std::lock_guard<sys::Mutex> storageLock(m_lock);
+    m_getValueFunc = nullptr;
+    m_storeValueFunc = nullptr;
+  } else {
+    // extResult should never be ErrorInvalidMemorySize since Cache space is always allocated based
+    // on 1st m_pfnGetValueFunc call.
+    assert(extResult != Result::ErrorOutOfMemory);
+
+    // Any other result means we just need to continue with initializing the new index/compiling.
+  }
+  return false;
+}
+
+// =====================================================================================================================
+// Counts a lookup of an entry, and records its key for the manifest if it is the first lookup of the entry.
+//
+// @param [in/out] index : Shader index entry that was looked up
+// @param hashKey : Key of the entry
+void ShaderCache::recordFirstAccess(ShaderIndex *index, uint64_t hashKey) {
+  if (index->accessCount++ != 0)
+    return;
+  std::lock_guard<std::mutex> manifestLock(m_manifestLock);
+  m_manifestKeys.push_back(hashKey);
+}
+
+// =====================================================================================================================
+// Writes a manifest of the entries that have been looked up in the shader cache, or queries its size. An entry that
+// was evicted and looked up again is only recorded once.
+//
+// @param [out] blob : System memory pointer where the manifest should be placed
+// @param [in/out] size : Size of the memory pointed to by blob. If the value stored in size is zero then no data will
+// be copied and instead the size required for the manifest will be returned in size
+Result ShaderCache::SerializeManifest(void *blob, size_t *size) {
+  std::vector<uint64_t> keys;
+  {
+    std::lock_guard<std::mutex> manifestLock(m_manifestLock);
+    std::unordered_set<uint64_t> seenKeys;
+    for (uint64_t key : m_manifestKeys) {
+      if (seenKeys.insert(key).second)
+        keys.push_back(key);
+    }
+  }
+
+  const size_t manifestSize = sizeof(ShaderCacheManifestHeader) + keys.size() * sizeof(uint64_t);
+  if (*size == 0) {
+    *size = manifestSize;
+    return Result::Success;
+  }
+  if (!blob || *size < manifestSize)
+    return Result::ErrorInvalidValue;
+
+  ShaderCacheManifestHeader header = {};
+  header.magic = ShaderCacheManifestMagic;
+  header.version = ShaderCacheManifestVersion;
+  header.keyCount = keys.size();
+  memcpy(blob, &header, sizeof(header));
+  memcpy(voidPtrInc(blob, sizeof(header)), keys.data(), keys.size() * sizeof(uint64_t));
+  *size = manifestSize;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Starts prefetching the entries recorded in a manifest on a background thread, which spreads the work over the
+// global thread pool. A prefetch that is still running is waited for first.
+//
+// @param manifest : Manifest written by SerializeManifest
+// @param manifestSize : Size of the manifest in bytes
+Result ShaderCache::Prefetch(const void *manifest, size_t manifestSize) {
+  if (!manifest || manifestSize < sizeof(ShaderCacheManifestHeader))
+    return Result::ErrorInvalidValue;
+
+  ShaderCacheManifestHeader header = {};
+  memcpy(&header, manifest, sizeof(header));
+  if (header.magic != ShaderCacheManifestMagic || header.version != ShaderCacheManifestVersion ||
+      header.keyCount > (manifestSize - sizeof(header)) / sizeof(uint64_t))
+    return Result::ErrorInvalidValue;
+
+  if (m_disableCache || header.keyCount == 0)
+    return Result::Success;
+
+  std::vector<uint64_t> hashKeys(header.keyCount);
+  memcpy(hashKeys.data(), voidPtrInc(manifest, sizeof(header)), hashKeys.size() * sizeof(uint64_t));
+
+  waitForPrefetch();
+  m_prefetchThread = std::thread(&ShaderCache::prefetchShaders, this, std::move(hashKeys));
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Waits for the prefetch started by the last call to Prefetch to finish.
+void ShaderCache::waitForPrefetch() {
+  if (m_prefetchThread.joinable())
+    m_prefetchThread.join();
+}
+
+// =====================================================================================================================
+// Prefetches the entries with the given keys, in parallel. Runs on the prefetch thread.
+//
+// @param hashKeys : Keys of the entries, in the order they were first looked up
+void ShaderCache::prefetchShaders(std::vector<uint64_t> hashKeys) {
+  Error err = parallelFor(0, hashKeys, [this](uint64_t hashKey) {
+    if (!m_prefetchCancelled)
+      prefetchShader(hashKey);
+    return Error::success();
+  });
+  consumeError(std::move(err));
+  enforceBudgets();
+}
+
+// =====================================================================================================================
+// Prefetches one entry, so that its first lookup does not have to wait for cache I/O. An entry loaded from a mapped
+// cache file has its CRC verified, which reads its data in from the file. An entry that is not in the cache is copied
+// from the external cache, if there is one. Entries that are not in any cache are skipped.
+//
+// @param hashKey : Key of the entry
+void ShaderCache::prefetchShader(uint64_t hashKey) {
+  ShaderIndexShard &shard = getShard(hashKey);
+  lockShard(shard, false);
+  auto indexMap = shard.indexMap.find(hashKey);
+  if (indexMap != shard.indexMap.end()) {
+    if (indexMap->second->state == ShaderEntryState::Ready)
+      checkDeferredCrc(indexMap->second);
+  } else {
+    auto *index = new ShaderIndex;
+    if (loadFromExternalCache(hashKey, index))
+      shard.indexMap[hashKey] = index;
+    else
+      delete index;
+  }
+  unlockShard(shard, false);
+}
+
 // =====================================================================================================================
 // Inserts a new shader into the cache. The new shader is written to the cache file if it is in-use, and will also
 // upload it to the client's external cache if it is in-use.
@@ -521,35 +1242,69 @@ void ShaderCache::insertShader(CacheEntryHandle hEntry, const void *blob, size_t
   assert(m_disableCache == false);
   assert(index && index->state == ShaderEntryState::Compiling);
 
-  lockCacheMap(false);
+  // Compress the shader before taking the locks, and only keep the compressed data if it is smaller.
+  const void *storedData = blob;
+  size_t storedSize = shaderSize;
+  std::vector<uint8_t> compressedData;
+  if (ShaderCacheCompress) {
+    compressedData.resize(getLz4BlockBound(shaderSize));
+    const size_t compressedSize = compressLz4Block(blob, shaderSize, compressedData.data(), compressedData.size());
+    if (compressedSize != 0 && compressedSize < shaderSize) {
+      storedData = compressedData.data();
+      storedSize = compressedSize;
+    }
+  }
+  const uint64_t crc = calculateCrc(static_cast<const uint8_t *>(storedData), storedSize);
+  const uint64_t contentHash = calculateContentHash(storedData, storedSize);
+
+  ShaderIndexShard &shard = getShard(index->header.key);
+  lockShard(shard, false);
+  m_lock.lock();
 
   Result result = Result::Success;
 
   if (result == Result::Success) {
-    // Allocate space to store the serialized shader and a copy of the header. The header is duplicated in the
-    // data to simplify serialize/load.
-    index->header.size = (shaderSize + sizeof(ShaderHeader));
-    index->dataBlob = getCacheSpace(index->header.size);
-
-    if (!index->dataBlob)
+    // The CRC of the serialized data as it is stored is useful for detecting data corruption.
+    index->header.size = (storedSize + sizeof(ShaderHeader));
+    index->header.uncompressedSize = storedData != blob ? shaderSize : 0;
+    index->header.crc = crc;
+    index->header.contentHash = contentHash;
+    index->header.recordSize = index->header.size;
+
+    // If another entry has identical shader data, share it. Otherwise allocate space to store the serialized shader
+    // and a copy of the header. The header is duplicated in the data to simplify serialize/load.
+    std::shared_ptr<const void> content = findContent(&index->header, storedData);
+    if (content) {
+      index->storage = std::move(content);
+      index->dataBlob = const_cast<void *>(index->storage.get());
+      index->sharedData = true;
+    } else if (uint8_t *record = getEntrySpace(index, index->header.size)) {
+      // Serialize the shader into an opaque blob of data, and copy the index's header into the data's header.
+      index->dataBlob = record + sizeof(ShaderHeader);
+      index->sharedData = false;
+      memcpy(index->dataBlob, storedData, storedSize);
+      memcpy(record, &index->header, sizeof(ShaderHeader));
+      registerContent(index);
+    } else
       result = Result::ErrorOutOfMemory;
-    else {
-      ++m_totalShaders;
-
-      auto *const header = static_cast<ShaderHeader *>(index->dataBlob);
-      void *const dataBlob = (header + 1);
 
-      // Serialize the shader into an opaque blob of data.
-      memcpy(dataBlob, blob, shaderSize);
-
-      // Compute a CRC for the serialized data (useful for detecting data corruption), and copy the index's
-      // header into the data's header.
-      index->header.crc = calculateCrc(static_cast<uint8_t *>(dataBlob), shaderSize);
-      (*header) = index->header;
+    if (result == Result::Success) {
+      ++m_totalShaders;
+      m_liveDataSize += index->header.size;
 
       if (useExternalCache()) {
-        // If we're making use of the external shader cache then we need to store the compiled shader data here.
-        Result externalResult = m_storeValueFunc(m_clientData, index->header.key, index->dataBlob, index->header.size);
+        // If we're making use of the external shader cache then we need to store the compiled shader data here. The
+        // external cache gets the header and the data in one blob.
+        std::vector<uint8_t> sharedRecord;
+        if (index->sharedData) {
+          sharedRecord.resize(index->header.size);
+          memcpy(sharedRecord.data(), &index->header, sizeof(ShaderHeader));
+          memcpy(sharedRecord.data() + sizeof(ShaderHeader), index->dataBlob, storedSize);
+        }
+        const void *externalRecord = index->sharedData ? static_cast<const void *>(sharedRecord.data())
+                                                       : static_cast<const ShaderHeader *>(index->dataBlob) - 1;
+        Result externalResult =
+            m_storeValueFunc(m_clientData, index->header.key, externalRecord, index->header.size);
         if (externalResult == Result::ErrorUnavailable) {
           // This is the only return code we can do anything about. In this case it means the external cache
           // is not available and we should zero out the function pointers to avoid making useless calls on
@@ -581,8 +1336,25 @@ void ShaderCache::insertShader(CacheEntryHandle hEntry, const void *blob, size_t
     index->dataBlob = nullptr;
   }
 
-  unlockCacheMap(false);
-  m_conditionVariable.notify_all();
+  // The entry is not evicted before the handle of the compiling thread is released, so the condition variable stays
+  // valid after the lock is released.
+  std::condition_variable_any *compileDone = index->compileDone.get();
+  m_lock.unlock();
+  unlockShard(shard, false);
+  if (compileDone)
+    compileDone->notify_all();
+
+  enforceBudgets();
+}
+
+// =====================================================================================================================
+// Releases a handle returned by findShader. The entry can be evicted once all of its handles are released.
+//
+// @param hEntry : Handle of shader cache entry
+void ShaderCache::releaseShader(CacheEntryHandle hEntry) {
+  auto *const index = static_cast<ShaderIndex *>(hEntry);
+  assert(index && index->useCount != 0);
+  --index->useCount;
 }
 
 // =====================================================================================================================
@@ -593,66 +1365,246 @@ void ShaderCache::resetShader(CacheEntryHandle hEntry) {
   auto *const index = static_cast<ShaderIndex *>(hEntry);
   assert(m_disableCache == false);
   assert(index && index->state == ShaderEntryState::Compiling);
-  lockCacheMap(false);
+  ShaderIndexShard &shard = getShard(index->header.key);
+  lockShard(shard, false);
   index->state = ShaderEntryState::New;
   index->header.size = 0;
   index->dataBlob = nullptr;
-  unlockCacheMap(false);
-  m_conditionVariable.notify_all();
+  std::condition_variable_any *compileDone = index->compileDone.get();
+  unlockShard(shard, false);
+  if (compileDone)
+    compileDone->notify_all();
 }
 
 // =====================================================================================================================
-// Retrieves the shader from the cache which is identified by the specified entry handle.
+// Retrieves the shader from the cache which is identified by the specified entry handle. A compressed shader is
+// decompressed into the given buffer, or into a buffer of the calling thread that is reused by its next retrieval of
+// a compressed shader if none is given. A caller that holds on to several shaders at once must give each a buffer.
 //
 // @param hEntry : Handle of shader cache entry
 // @param [out] ppBlob : Shader data
 // @param [out] size : Size of shader data in bytes
-Result ShaderCache::retrieveShader(CacheEntryHandle hEntry, const void **ppBlob, size_t *size) {
+// @param [in/out] decompressionBuffer : Buffer to decompress the shader into, or nullptr to use the thread's buffer
+Result ShaderCache::retrieveShader(CacheEntryHandle hEntry, const void **ppBlob, size_t *size,
+                                   std::vector<uint8_t> *decompressionBuffer) {
   const auto *const index = static_cast<ShaderIndex *>(hEntry);
 
   assert(m_disableCache == false);
   assert(index);
   assert(index->header.size >= sizeof(ShaderHeader));
 
-  lockCacheMap(true);
+  ShaderIndexShard &shard = getShard(index->header.key);
+  lockShard(shard, true);
 
-  *ppBlob = voidPtrInc(index->dataBlob, sizeof(ShaderHeader));
-  *size = index->header.size - sizeof(ShaderHeader);
+  const void *storedData = index->dataBlob;
+  const size_t storedSize = index->header.size - sizeof(ShaderHeader);
+  Result result = storedSize > 0 ? Result::Success : Result::ErrorUnknown;
+  if (index->header.uncompressedSize == 0) {
+    *ppBlob = storedData;
+    *size = storedSize;
+  } else {
+    static thread_local std::vector<uint8_t> ThreadDecompressionBuffer;
+    std::vector<uint8_t> &buffer = decompressionBuffer ? *decompressionBuffer : ThreadDecompressionBuffer;
+    buffer.resize(index->header.uncompressedSize);
+    if (!decompressLz4Block(storedData, storedSize, buffer.data(), buffer.size()))
+      result = Result::ErrorUnknown;
+    *ppBlob = buffer.data();
+    *size = buffer.size();
+  }
 
-  unlockCacheMap(true);
+  unlockShard(shard, true);
 
-  return *size > 0 ? Result::Success : Result::ErrorUnknown;
+  return result;
 }
 
 // =====================================================================================================================
-// Adds data for a new shader to the on-disk file
+// Adds data for a new shader to the on-disk file. The data is collected in the write-behind journal, which is appended
+// to the file once it reaches the batch size. If the file already holds identical shader data, only a reference record
+// is added. While the file is compacted, that must hold for the compacted file too.
+//
+// A file shared with other processes only gets full records, as another process may reset the file, dropping the
+// records that a reference record would refer to.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
 //
 // @param index : A new shader
 Result ShaderCache::addShaderToFile(const ShaderIndex *index) {
   assert(m_onDiskFile.isOpen());
 
-  // We only need to update the parts of the file that changed, which is the number of shaders, the new data section,
-  // and the shaderDataEnd.
+  ShaderHeader header = index->header;
+  const size_t storedSize = header.size - sizeof(ShaderHeader);
+  auto hasContent = [&header, storedSize](const ShaderContentMap &contents) {
+    auto it = contents.find(header.contentHash);
+    return it != contents.end() && it->second.crc == header.crc && it->second.size == storedSize;
+  };
+  bool isReference = false;
+  if (header.contentHash != 0 && m_lockFileFd < 0) {
+    isReference = hasContent(m_fileContents) && (!m_compacting || hasContent(m_compactedFileContents));
+    if (!isReference) {
+      const ShaderContent content = {header.crc, storedSize, {}};
+      m_fileContents.try_emplace(header.contentHash, content);
+      if (m_compacting)
+        m_compactedFileContents.try_emplace(header.contentHash, content);
+    }
+  }
+
+  header.recordSize = isReference ? sizeof(ShaderHeader) : header.size;
+  const auto *headerBytes = reinterpret_cast<const uint8_t *>(&header);
+  m_fileJournal.insert(m_fileJournal.end(), headerBytes, headerBytes + sizeof(ShaderHeader));
+  if (!isReference) {
+    const auto *data = static_cast<const uint8_t *>(index->dataBlob);
+    m_fileJournal.insert(m_fileJournal.end(), data, data + storedSize);
+  }
+  ++m_fileJournalShaders;
+  if (m_fileJournal.size() < ShaderCacheFileBatchSize)
+    return Result::Success;
+  if (!ShaderCacheBackgroundFileWrite)
+    return flushFileJournal();
+  startFileJournalWrite();
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Appends the shader data collected in the write-behind journal to the on-disk file.
+//
+// The data is written at the current end of the data section first, and only then is the header updated. The shader
+// count and data end are adjacent in the header, so they are updated with a single write. If the process dies before
+// the header write completes, the appended data lies beyond shaderDataEnd and is ignored on the next load, and a torn
+// entry is caught by its CRC.
+//
+// A shared file is appended under the file lock, after the data that other processes have appended since it was
+// loaded. Their shaders are not added to this cache; they are loaded by the processes that start later.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
+Result ShaderCache::flushFileJournal() {
+  // A batch that is being appended in the background is written first, as the journal follows it in the file.
+  Result result = finishFileJournalWrite();
+  if (result != Result::Success)
+    return result;
 
-  // Calculate the header offsets, then write the relevant data to the file.
-  const unsigned shaderCountOffset = offsetof(struct ShaderCacheSerializedHeader, shaderCount);
-  const unsigned dataEndOffset = offsetof(struct ShaderCacheSerializedHeader, shaderDataEnd);
+  // While the file is compacted, the journal is held back, and it is appended to the compacted file once that has been
+  // swapped in.
+  if (m_fileJournal.empty() || !m_onDiskFile.isOpen() || m_compacting)
+    return Result::Success;
 
-  m_onDiskFile.seek(shaderCountOffset, true);
-  Result result = m_onDiskFile.write(&m_totalShaders, sizeof(size_t));
+  result = lockCacheFile();
+  if (result != Result::Success)
+    return result;
+  // Without other writers, the file holds the shaders counted in this cache that are not in the journal.
+  const size_t fileShaderCount = m_totalShaders - m_fileJournalShaders;
+  result = writeFileJournal(m_fileJournal, m_fileJournalShaders, fileShaderCount, m_shaderDataEnd);
+  unlockCacheFile();
   if (result != Result::Success)
     return result;
+  m_shaderDataEnd += m_fileJournal.size();
+  m_fileJournal.clear();
+  m_fileJournalShaders = 0;
+  return Result::Success;
+}
+
+// =====================================================================================================================
+// Hands the write-behind journal over to a background thread that appends it to the on-disk file, so that the thread
+// that added the shader does not wait for the disk. If the previous batch is still being written, the journal keeps
+// collecting shader data and is handed over once that has finished. While the file is compacted, the journal is held
+// back as in flushFileJournal.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
+void ShaderCache::startFileJournalWrite() {
+  if (m_fileWriting || m_compacting || !m_onDiskFile.isOpen())
+    return;
+  if (finishFileJournalWrite() != Result::Success)
+    LLPC_ERRS("Failed to write shader cache file: " << m_fileFullPath << "\n");
+
+  // The journal is appended after the shaders in the file, so the counts are taken before it is handed over.
+  const size_t fileShaderCount = m_totalShaders - m_fileJournalShaders;
+  m_fileWriteBatch.swap(m_fileJournal);
+  m_fileWriteBatchShaders = m_fileJournalShaders;
+  m_fileJournal.clear();
+  m_fileJournalShaders = 0;
+  m_fileWriting = true;
+  m_fileWriterThread = std::thread(&ShaderCache::writeFileJournalBatch, this, fileShaderCount, m_shaderDataEnd);
+}
+
+// =====================================================================================================================
+// Waits for the batch that is being appended to the on-disk file in the background, if any, and accounts for it.
+// Returns the result of the append. A batch that failed to be appended goes back to the front of the journal.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
+Result ShaderCache::finishFileJournalWrite() {
+  if (!m_fileWriterThread.joinable())
+    return Result::Success;
+  m_fileWriterThread.join();
+  if (m_fileWriteResult == Result::Success) {
+    m_shaderDataEnd += m_fileWriteBatch.size();
+  } else {
+    m_fileJournal.insert(m_fileJournal.begin(), m_fileWriteBatch.begin(), m_fileWriteBatch.end());
+    m_fileJournalShaders += m_fileWriteBatchShaders;
+  }
+  m_fileWriteBatch.clear();
+  m_fileWriteBatchShaders = 0;
+  return m_fileWriteResult;
+}
+
+// =====================================================================================================================
+// Appends the batch handed over by startFileJournalWrite to the on-disk file. Runs on the file writer thread, without
+// the cache storage lock; the file is not used by other threads until finishFileJournalWrite has joined this one.
+//
+// @param fileShaderCount : Number of shaders the file holds, if it is not shared
+// @param fileDataEnd : End of the shader data in the file, if it is not shared
+void ShaderCache::writeFileJournalBatch(size_t fileShaderCount, size_t fileDataEnd) {
+  m_fileWriteResult = lockCacheFile();
+  if (m_fileWriteResult == Result::Success) {
+    m_fileWriteResult = writeFileJournal(m_fileWriteBatch, m_fileWriteBatchShaders, fileShaderCount, fileDataEnd);
+    unlockCacheFile();
+  }
+  m_fileWriting = false;
+}
+
+// =====================================================================================================================
+// Writes shader data collected in the write-behind journal to the on-disk file, and updates its header. The caller
+// accounts for the written data in m_shaderDataEnd.
+//
+// NOTE: This function assumes that the file lock of a shared file has been taken by the calling function, and that no
+// other thread uses the file meanwhile.
+//
+// @param journal : Shader data to append
+// @param journalShaders : Number of shaders in the shader data
+// @param fileShaderCount : Number of shaders the file holds, if it is not shared
+// @param fileDataEnd : End of the shader data in the file, if it is not shared
+Result ShaderCache::writeFileJournal(ArrayRef<uint8_t> journal, size_t journalShaders, size_t fileShaderCount,
+                                     size_t fileDataEnd) {
+  if (m_lockFileFd >= 0) {
+    // The file is shared, so read its current header. If another build of the compiler has reset the file, it no
+    // longer matches this cache and the journal is dropped.
+    ShaderCacheSerializedHeader header = {};
+    BuildUniqueId buildId;
+    getBuildTime(&buildId);
+    m_onDiskFile.rewind();
+    if (m_onDiskFile.read(&header, sizeof(header), nullptr) != Result::Success ||
+        header.headerSize != sizeof(ShaderCacheSerializedHeader) ||
+        memcmp(&header.buildId, &buildId, sizeof(buildId)) != 0 ||
+        header.shaderDataEnd > File::getFileSize(m_fileFullPath))
+      return Result::Success;
+    fileShaderCount = header.shaderCount;
+    fileDataEnd = header.shaderDataEnd;
+  }
 
   // Write the new shader data at the current end of the data section
-  m_onDiskFile.seek(static_cast<unsigned>(m_shaderDataEnd), true);
-  result = m_onDiskFile.write(index->dataBlob, index->header.size);
+  m_onDiskFile.seek(static_cast<unsigned>(fileDataEnd), true);
+  Result result = m_onDiskFile.write(journal.data(), journal.size());
+  if (result != Result::Success)
+    return result;
+  result = m_onDiskFile.flush();
   if (result != Result::Success)
     return result;
 
-  // Then update the data end value and write it out to the file.
-  m_shaderDataEnd += index->header.size;
-  m_onDiskFile.seek(dataEndOffset, true);
-  result = m_onDiskFile.write(&m_shaderDataEnd, sizeof(size_t));
+  // Then update the shader count and data end values in the header.
+  static_assert(offsetof(struct ShaderCacheSerializedHeader, shaderDataEnd) ==
+                    offsetof(struct ShaderCacheSerializedHeader, shaderCount) + sizeof(size_t),
+                "shaderCount and shaderDataEnd must be adjacent");
+  const size_t counts[] = {fileShaderCount + journalShaders, fileDataEnd + journal.size()};
+  m_onDiskFile.seek(offsetof(struct ShaderCacheSerializedHeader, shaderCount), true);
+  result = m_onDiskFile.write(counts, sizeof(counts));
   if (result != Result::Success)
     return result;
 
@@ -680,38 +1632,81 @@ Result ShaderCache::loadCacheFromFile() {
   result = validateAndLoadHeader(&header, fileSize);
 
   void *dataMem = nullptr;
+  std::shared_ptr<const void> storage;
   if (result == Result::Success) {
-    // The header is valid, so allocate space to fit all of the shader data.
-    dataMem = getCacheSpace(dataSize);
-  }
-
-  if (result == Result::Success) {
-    if (dataMem) {
-      // Read the shader data into the allocated memory.
-      m_onDiskFile.seek(sizeof(ShaderCacheSerializedHeader), true);
-      size_t bytesRead = 0;
-      result = m_onDiskFile.read(dataMem, dataSize, &bytesRead);
-
-      // If we didn't read the correct number of bytes then something went wrong and we should return a failure
-      if (bytesRead != dataSize)
+    if (ShaderCacheMmap) {
+      // Map the file instead of reading it. The shader index entries point directly into the mapping, and their CRCs
+      // are verified on first access.
+      dataMem = mapCacheFile(fileSize);
+      storage = m_mappedFile;
+      if (!dataMem)
         result = Result::ErrorUnknown;
-    } else
-      result = Result::ErrorOutOfMemory;
+    } else {
+      // The header is valid, so allocate space to fit all of the shader data.
+      std::shared_ptr<uint8_t> cacheSpace = getCacheSpace(dataSize);
+      dataMem = cacheSpace.get();
+      storage = std::move(cacheSpace);
+      if (dataMem) {
+        // Read the shader data into the allocated memory.
+        m_onDiskFile.seek(sizeof(ShaderCacheSerializedHeader), true);
+        size_t bytesRead = 0;
+        result = m_onDiskFile.read(dataMem, dataSize, &bytesRead);
+
+        // If we didn't read the correct number of bytes then something went wrong and we should return a failure
+        if (bytesRead != dataSize)
+          result = Result::ErrorUnknown;
+      } else
+        result = Result::ErrorOutOfMemory;
+    }
   }
 
   if (result == Result::Success) {
     // Now setup the shader index hash map.
-    result = populateIndexMap(dataMem, dataSize);
+    result = populateIndexMap(dataMem, dataSize, storage, /*deferCrc=*/m_mappedFile != nullptr);
   }
 
+  // All of the shader data in memory now comes from full records of the file, which new entries can refer to.
+  if (result == Result::Success)
+    m_fileContents = m_contents;
+
   if (result != Result::Success) {
-    // Something went wrong in loading the file, so reset it
+    // Something went wrong in loading the file, so reset it. The entries loaded so far, which hold on to the mapping,
+    // must be released before the file is truncated.
+    storage.reset();
+    resetRuntimeCache();
     resetCacheFile();
   }
 
   return result;
 }
 
+// =====================================================================================================================
+// Maps the whole on-disk cache file read-only into memory. Returns a pointer to the shader data that follows the
+// header, or nullptr if the file could not be mapped.
+//
+// NOTE: This function assumes that a write lock has already been taken by the calling function.
+//
+// @param fileSize : Size of the cache file in bytes
+void *ShaderCache::mapCacheFile(size_t fileSize) {
+  Expected<sys::fs::file_t> fileOrErr = sys::fs::openNativeFileForRead(m_fileFullPath);
+  if (!fileOrErr) {
+    consumeError(fileOrErr.takeError());
+    return nullptr;
+  }
+
+  std::error_code errCode;
+  auto mappedFile =
+      std::make_unique<sys::fs::mapped_file_region>(*fileOrErr, sys::fs::mapped_file_region::readonly, fileSize, 0,
+                                                    errCode);
+  // The mapping stays valid after the file handle is closed.
+  sys::fs::closeFile(*fileOrErr);
+  if (errCode)
+    return nullptr;
+
+  m_mappedFile = std::move(mappedFile);
+  return const_cast<char *>(m_mappedFile->const_data()) + sizeof(ShaderCacheSerializedHeader);
+}
+
 // =====================================================================================================================
 // Loads all shader data from a client provided initial data blob. Returns true if the file contents were loaded
 // successfully or false if invalid data was found.
@@ -730,12 +1725,12 @@ Result ShaderCache::loadCacheFromBlob(const void *initialData, size_t initialDat
   if (result == Result::Success) {
     // The header appears valid so allocate space for the shader data.
     const size_t dataSize = initialDataSize - header->headerSize;
-    void *dataMem = getCacheSpace(dataSize);
+    std::shared_ptr<uint8_t> dataMem = getCacheSpace(dataSize);
 
     if (dataMem) {
       // Then copy the data and setup the shader index hash map.
-      memcpy(dataMem, voidPtrInc(initialData, header->headerSize), dataSize);
-      result = populateIndexMap(dataMem, dataSize);
+      memcpy(dataMem.get(), voidPtrInc(initialData, header->headerSize), dataSize);
+      result = populateIndexMap(dataMem.get(), dataSize, dataMem);
     } else
       result = Result::ErrorOutOfMemory;
   }
@@ -749,7 +1744,10 @@ Result ShaderCache::loadCacheFromBlob(const void *initialData, size_t initialDat
 //
 // @param dataStart : Start pointer of cached shader data
 // @param dataSize : Shader data size in bytes
-Result ShaderCache::populateIndexMap(void *dataStart, size_t dataSize) {
+// @param storage : Memory holding the shader data, which the entries share
+// @param deferCrc : Whether to defer the CRC check of each entry to its first access
+Result ShaderCache::populateIndexMap(void *dataStart, size_t dataSize, const std::shared_ptr<const void> &storage,
+                                     bool deferCrc) {
   Result result = Result::Success;
 
   // Iterate through all of the entries to verify the data CRC, zero out the GPU memory pointer/offset and add to the
@@ -757,52 +1755,152 @@ Result ShaderCache::populateIndexMap(void *dataStart, size_t dataSize) {
   // take the hit each time we add shader data to the file.
   auto *header = static_cast<ShaderHeader *>(dataStart);
 
+  // The full records loaded so far, by content hash, which the reference records after them refer to
+  std::unordered_map<uint64_t, const ShaderHeader *> fullRecords;
+
   for (unsigned shader = 0; (shader < m_totalShaders && result == Result::Success); ++shader) {
     // Guard against buffer overruns.
     assert(voidPtrDiff(header, dataStart) <= dataSize);
+    const size_t remainingSize = dataSize - voidPtrDiff(header, dataStart);
+    if (remainingSize < sizeof(ShaderHeader) || header->size < sizeof(ShaderHeader)) {
+      result = Result::ErrorUnknown;
+      break;
+    }
+
+    // A reference record must match the full record with its content hash.
+    const bool isReference = header->recordSize != header->size;
+    const ShaderHeader *fullRecord = header;
+    if (isReference) {
+      auto it = fullRecords.find(header->contentHash);
+      if (header->recordSize != sizeof(ShaderHeader) || header->contentHash == 0 || it == fullRecords.end() ||
+          it->second->size != header->size || it->second->crc != header->crc) {
+        result = Result::ErrorUnknown;
+        break;
+      }
+      fullRecord = it->second;
+    } else if (header->size > remainingSize) {
+      result = Result::ErrorUnknown;
+      break;
+    } else if (header->contentHash != 0)
+      fullRecords.try_emplace(header->contentHash, header);
 
     // TODO: Add a static function to RelocatableShader to validate the input data.
 
-    // The serialized data blob representing each RelocatableShader object immediately follows the header.
-    void *const dataBlob = (header + 1);
+    // The serialized data blob representing each RelocatableShader object immediately follows the header of the full
+    // record.
+    void *const dataBlob = const_cast<ShaderHeader *>(fullRecord + 1);
 
-    // Verify the CRC
-    const uint64_t crc = calculateCrc(static_cast<uint8_t *>(dataBlob), (header->size - sizeof(ShaderHeader)));
+    // Verify the CRC, unless that is deferred to the first access of the entry, or it has been verified for the full
+    // record already.
+    const uint64_t crc = deferCrc || isReference ? header->crc
+                                                 : calculateCrc(static_cast<uint8_t *>(dataBlob),
+                                                                (header->size - sizeof(ShaderHeader)));
 
     if (crc == header->crc) {
       // It all checks out, so add this shader to the hash map!
       ShaderIndex *index = nullptr;
-      auto indexMap = m_shaderIndexMap.find(header->key);
-      if (indexMap == m_shaderIndexMap.end()) {
+      ShaderIndexMap &indexMap = getShard(header->key).indexMap;
+      if (indexMap.find(header->key) == indexMap.end()) {
         index = new ShaderIndex;
         index->header = (*header);
-        index->dataBlob = header;
+        index->header.recordSize = index->header.size;
+        index->dataBlob = dataBlob;
+        index->storage = storage;
         index->state = ShaderEntryState::Ready;
-        m_shaderIndexMap[header->key] = index;
+        index->crcPending = deferCrc;
+        index->sharedData = isReference;
+        indexMap[header->key] = index;
+        m_liveDataSize += index->header.size;
+        registerContent(index);
       }
     } else
       result = Result::ErrorUnknown;
 
     // Move to next entry in cache
-    header = static_cast<ShaderHeader *>(voidPtrInc(header, header->size));
+    header = static_cast<ShaderHeader *>(voidPtrInc(header, header->recordSize));
   }
 
   return result;
 }
 
 // =====================================================================================================================
-// Calculates a 64-bit CRC of the data provided
+// Verifies the CRC of an entry whose check was deferred at load. Returns true if the data is valid.
+//
+// NOTE: This function assumes that a write lock on the entry's shard has been taken by the calling function.
+//
+// @param [in/out] index : Shader index entry to verify
+bool ShaderCache::verifyDeferredCrc(ShaderIndex *index) {
+  assert(index->crcPending && index->dataBlob);
+  index->crcPending = false;
+  const uint64_t crc =
+      calculateCrc(static_cast<const uint8_t *>(index->dataBlob), index->header.size - sizeof(ShaderHeader));
+  return crc == index->header.crc;
+}
+
+// =====================================================================================================================
+// Finds shader data in memory that is identical to the shader data of a new entry. If different shader data has the
+// same content hash, the content hash of the entry is cleared, so that it is stored by itself.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
+//
+// @param [in/out] header : Header of the new entry
+// @param data : Shader data of the new entry
+// @returns : The identical shader data, which shares the memory holding it, or nullptr if there is none
+std::shared_ptr<const void> ShaderCache::findContent(ShaderHeader *header, const void *data) {
+  if (header->contentHash == 0)
+    return nullptr;
+  auto it = m_contents.find(header->contentHash);
+  if (it == m_contents.end())
+    return nullptr;
+  std::shared_ptr<const void> content = it->second.data.lock();
+  if (!content)
+    return nullptr;
+
+  const size_t size = header->size - sizeof(ShaderHeader);
+  if (it->second.crc == header->crc && it->second.size == size && memcmp(content.get(), data, size) == 0)
+    return content;
+  header->contentHash = 0;
+  return nullptr;
+}
+
+// =====================================================================================================================
+// Records the shader data of an entry by its content hash, unless other shader data in memory has the same hash.
+//
+// NOTE: This function assumes that the cache storage lock has been taken by the calling function.
+//
+// @param index : The entry
+void ShaderCache::registerContent(const ShaderIndex *index) {
+  if (index->header.contentHash == 0)
+    return;
+  ShaderContent &content = m_contents[index->header.contentHash];
+  if (!content.data.expired())
+    return;
+  content.crc = index->header.crc;
+  content.size = index->header.size - sizeof(ShaderHeader);
+  // The shader data shares the ownership of the memory holding it.
+  content.data = std::shared_ptr<const void>(index->storage, index->dataBlob);
+}
+
+// =====================================================================================================================
+// Calculates the CRC of the data provided. This is the CRC-32C of the data, which uses the crc32 instruction of the
+// host CPU when it is available, as verifying the CRCs dominates the time to load a large cache.
 //
 // @param data : Data need generate CRC
 // @param numBytes : Data size in bytes
 uint64_t ShaderCache::calculateCrc(const uint8_t *data, size_t numBytes) {
-  uint64_t crc = CrcInitialValue;
-  for (unsigned byte = 0; byte < numBytes; ++byte) {
-    uint8_t tableIndex = static_cast<uint8_t>(crc >> (CrcWidth - 8)) & 0xFF;
-    crc = (crc << 8) ^ CrcLookup[tableIndex] ^ data[byte];
-  }
+  return calculateCrc32c(data, numBytes);
+}
 
-  return crc;
+// =====================================================================================================================
+// Calculates the content hash of shader data, which identifies entries with identical shader data. The hash is never
+// 0, which marks an entry that is not content-addressed.
+//
+// @param data : Shader data as it is stored
+// @param numBytes : Data size in bytes
+uint64_t ShaderCache::calculateContentHash(const void *data, size_t numBytes) {
+  uint64_t hash = 0;
+  Util::MetroHash64::Hash(static_cast<const uint8_t *>(data), numBytes, reinterpret_cast<uint8_t *>(&hash));
+  return hash != 0 ? hash : 1;
 }
 
 // =====================================================================================================================
@@ -822,7 +1920,9 @@ Result ShaderCache::validateAndLoadHeader(const ShaderCacheSerializedHeader *hea
       memcmp(header->buildId.buildDate, buildId.buildDate, sizeof(buildId.buildDate)) == 0 &&
       memcmp(header->buildId.buildTime, buildId.buildTime, sizeof(buildId.buildTime)) == 0 &&
       memcmp(&header->buildId.gfxIp, &buildId.gfxIp, sizeof(buildId.gfxIp)) == 0 &&
-      memcmp(&header->buildId.hash, &buildId.hash, sizeof(buildId.hash)) == 0) {
+      memcmp(&header->buildId.hash, &buildId.hash, sizeof(buildId.hash)) == 0 &&
+      header->buildId.formatVersion == buildId.formatVersion &&
+      header->buildId.interfaceVersion == buildId.interfaceVersion) {
     // The header appears valid so copy the header data to the runtime cache
     m_totalShaders = header->shaderCount;
     m_shaderDataEnd = header->shaderDataEnd;
@@ -838,15 +1938,165 @@ Result ShaderCache::validateAndLoadHeader(const ShaderCacheSerializedHeader *hea
 }
 
 // =====================================================================================================================
-// Allocates memory from the shader cache's linear allocator. This function assumes that a write lock has been taken by
-// the calling function.
+// Allocates memory for the shader data of many entries that are loaded together. The entries share the memory, which
+// is released once all of them have been evicted or reset (in this cache and any cache they were merged into).
+//
+// @param numBytes : Allocation size in bytes
+std::shared_ptr<uint8_t> ShaderCache::getCacheSpace(size_t numBytes) {
+  return std::shared_ptr<uint8_t>(new uint8_t[numBytes], std::default_delete<uint8_t[]>());
+}
+
+// =====================================================================================================================
+// Allocates memory for the data blob of a single entry. Unlike the memory from getCacheSpace, it is only shared with
+// the entries that this one is merged into, and is released when all of them are evicted.
 //
+// @param [in/out] index : Entry that owns the memory
 // @param numBytes : Allocation size in bytes
-void *ShaderCache::getCacheSpace(size_t numBytes) {
-  auto p = new uint8_t[numBytes];
-  m_allocationList.push_back(std::pair<uint8_t *, size_t>(p, numBytes));
-  m_serializedSize += numBytes;
-  return p;
+uint8_t *ShaderCache::getEntrySpace(ShaderIndex *index, size_t numBytes) {
+  std::shared_ptr<uint8_t> space = getCacheSpace(numBytes);
+  uint8_t *data = space.get();
+  index->storage = std::move(space);
+  return data;
+}
+
+// =====================================================================================================================
+// Evicts entries and compacts the on-disk file once the budgets of the cache are exceeded. This must be called without
+// any lock of the cache held.
+void ShaderCache::enforceBudgets() {
+  if (m_maxMemorySize == 0 && m_maxFileSize == 0)
+    return;
+
+  lockCacheMap(false);
+  // Evict down to three quarters of the budget, so that a cache at its budget does not evict on every insertion.
+  if (m_maxMemorySize != 0 && m_liveDataSize > m_maxMemorySize)
+    evictShaders(m_maxMemorySize - m_maxMemorySize / 4);
+
+  // Entries evicted from memory are still in the on-disk file, which only ever grows, until it is compacted. A file
+  // shared with other processes is never compacted, as they may be appending to it. Nor is the segment of a segmented
+  // cache, as the cache also holds the entries of the other segments.
+  if (m_maxFileSize != 0 && m_onDiskFile.isOpen() && m_lockFileFd < 0 && m_segmentLockFd < 0 && !m_compacting &&
+      m_shaderDataEnd + m_fileWriteBatch.size() + m_fileJournal.size() > m_maxFileSize) {
+    if (sizeof(ShaderCacheSerializedHeader) + m_liveDataSize > m_maxFileSize)
+      evictShaders(m_maxFileSize - m_maxFileSize / 4);
+    compactCacheFile();
+  }
+  unlockCacheMap(false);
+}
+
+// =====================================================================================================================
+// Evicts the least recently (or frequently) used entries until the shader data of the entries in the cache fits the
+// given size. Entries that are being compiled, or whose handles have not been released, are not evicted. The memory of
+// an evicted entry is released once no other entry, of this cache or of a cache it was merged into, refers to it.
+//
+// NOTE: This function assumes that the whole cache map has been locked for writes by the calling function.
+//
+// @param targetSize : Size of shader data to evict down to
+void ShaderCache::evictShaders(size_t targetSize) {
+  struct Candidate {
+    uint64_t frequency;
+    uint64_t recency;
+    ShaderIndex *index;
+  };
+  std::vector<Candidate> candidates;
+  for (ShaderIndexShard &shard : m_shards) {
+    for (auto it : shard.indexMap) {
+      ShaderIndex *index = it.second;
+      if (index->state == ShaderEntryState::Ready && index->useCount == 0)
+        candidates.push_back({ShaderCacheEvictLfu ? index->accessCount.load() : 0, index->lastAccess, index});
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+    return std::tie(lhs.frequency, lhs.recency) < std::tie(rhs.frequency, rhs.recency);
+  });
+
+  for (const Candidate &candidate : candidates) {
+    if (m_liveDataSize <= targetSize)
+      break;
+    ShaderIndex *index = candidate.index;
+    LLVM_DEBUG(dbgs() << "Evicting shader cache entry " << format_hex(index->header.key, 18) << " ("
+                      << index->header.size << " bytes)\n");
+    getShard(index->header.key).indexMap.erase(index->header.key);
+    m_liveDataSize -= index->header.size;
+    delete index;
+  }
+
+  // Forget the shader data that no entry refers to anymore.
+  for (auto it = m_contents.begin(); it != m_contents.end();) {
+    if (it->second.data.expired())
+      it = m_contents.erase(it);
+    else
+      ++it;
+  }
+}
+
+// =====================================================================================================================
+// Starts the compaction of the on-disk file in the background. The compacted file only holds the entries that are in
+// the cache, with a full record for the first entry of each shader data and reference records for the others. The
+// journal is appended to the current file first, and new shader data is collected in the journal until the compacted
+// file has been swapped in.
+//
+// NOTE: This function assumes that the whole cache map has been locked for writes by the calling function.
+void ShaderCache::compactCacheFile() {
+  if (flushFileJournal() != Result::Success) {
+    LLPC_ERRS("Failed to write shader cache file: " << m_fileFullPath << "\n");
+    return;
+  }
+
+  ShaderCacheSerializedPieces pieces;
+  collectSerializedPieces(&pieces, &m_compactedFileContents);
+  std::vector<uint8_t> fileData;
+  fileData.reserve(pieces.size);
+  const auto *headerBytes = reinterpret_cast<const uint8_t *>(&pieces.header);
+  fileData.insert(fileData.end(), headerBytes, headerBytes + sizeof(ShaderCacheSerializedHeader));
+  for (ArrayRef<uint8_t> piece : pieces.pieces)
+    fileData.insert(fileData.end(), piece.begin(), piece.end());
+  const size_t shaderCount = pieces.header.shaderCount;
+
+  m_compacting = true;
+  if (m_compactionThread.joinable())
+    m_compactionThread.join();
+  m_compactionThread = std::thread(&ShaderCache::writeCompactedFile, this, std::move(fileData), shaderCount);
+}
+
+// =====================================================================================================================
+// Writes the compacted on-disk file next to the current one, and swaps it in. Runs on the compaction thread.
+//
+// @param fileData : Contents of the compacted file
+// @param shaderCount : Number of shaders in the compacted file
+void ShaderCache::writeCompactedFile(std::vector<uint8_t> fileData, size_t shaderCount) {
+  std::string compactedFileName = (Twine(m_fileFullPath) + ".compact").str();
+  File compactedFile;
+  Result result = compactedFile.open(compactedFileName.c_str(), (FileAccessWrite | FileAccessBinary));
+  if (result == Result::Success) {
+    result = compactedFile.write(fileData.data(), fileData.size());
+    if (result == Result::Success)
+      result = compactedFile.flush();
+    compactedFile.close();
+  }
+
+  std::lock_guard<sys::Mutex> storageLock(m_lock);
+  if (result == Result::Success && m_onDiskFile.isOpen()) {
+    m_onDiskFile.close();
+    if (!sys::fs::rename(compactedFileName, m_fileFullPath)) {
+      m_shaderDataEnd = fileData.size();
+      m_totalShaders = shaderCount + m_fileJournalShaders;
+      m_fileContents = std::move(m_compactedFileContents);
+    } else
+      result = Result::ErrorUnknown;
+    mustSucceed(m_onDiskFile.open(m_fileFullPath, (FileAccessReadUpdate | FileAccessBinary)),
+                Twine("Failed to open shader cache file: ") + m_fileFullPath);
+  }
+  if (result != Result::Success) {
+    // The current file is kept, and the journal is appended to it as usual.
+    LLPC_ERRS("Failed to compact shader cache file: " << m_fileFullPath << "\n");
+    (void)sys::fs::remove(compactedFileName);
+  }
+
+  m_compactedFileContents.clear();
+  m_compacting = false;
+  if (flushFileJournal() != Result::Success)
+    LLPC_ERRS("Failed to write shader cache file: " << m_fileFullPath << "\n");
 }
 
 // =====================================================================================================================
@@ -859,6 +2109,8 @@ void ShaderCache::getBuildTime(BuildUniqueId *buildId) {
   memcpy(&buildId->buildTime, __TIME__, std::min(strlen(__TIME__), sizeof(buildId->buildTime)));
   memcpy(&buildId->gfxIp, &m_gfxIp, sizeof(m_gfxIp));
   memcpy(&buildId->hash, &m_hash, sizeof(m_hash));
+  buildId->formatVersion = ShaderCacheFormatVersion;
+  buildId->interfaceVersion = (LLPC_INTERFACE_MAJOR_VERSION << 16) | LLPC_INTERFACE_MINOR_VERSION;
 }
 
 // =====================================================================================================================
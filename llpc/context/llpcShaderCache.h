@@ -34,19 +34,33 @@
 #include "llpcFile.h"
 #include "llpcUtil.h"
 #include "vkgcMetroHash.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/RWMutex.h"
+#include <atomic>
 #include <condition_variable>
-#include <list>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace Llpc {
 
 // Header data that is stored with each shader in the cache.
+//
+// In the storage file (and a serialized cache), each entry is a record of this header followed by the shader data. An
+// entry whose shader data is identical to that of an earlier record with the same content hash is a reference record
+// instead, which is just this header with recordSize set to the size of the header.
 struct ShaderHeader {
-  uint64_t key; // Compacted hash key used to identify shaders
-  uint64_t crc; // CRC of the shader cache entry, used to detect data corruption.
-  size_t size;  // Total size of the shader data in the storage file
+  uint64_t key;            // Compacted hash key used to identify shaders
+  uint64_t crc;            // CRC of the shader cache entry, used to detect data corruption.
+  size_t size;             // Total size of the shader data, including this header
+  size_t uncompressedSize; // Size of the shader data before LZ4 compression, or 0 if it is stored uncompressed
+  uint64_t contentHash;    // Hash of the shader data as it is stored, or 0 if the entry is not content-addressed
+  size_t recordSize;       // Size of the record in the storage file: size, or the header size for a reference record
 };
 
 // Enum defining the states a shader cache entry can be in
@@ -69,14 +83,47 @@ enum ShaderCacheMode {
 // Stores data in the hash map of cached shaders and helps correlated a shader in the hash to a location in the
 // cache's linear allocators where the shader is actually stored.
 struct ShaderIndex {
-  ShaderHeader header;             // Shader header data (key, crc, size)
-  volatile ShaderEntryState state; // Shader entry state
-  void *dataBlob;                  // Serialized data blob representing a cached RelocatableShader object.
+  ShaderHeader header = {};                                // Shader header data (key, crc, size)
+  volatile ShaderEntryState state = ShaderEntryState::New; // Shader entry state
+  void *dataBlob = nullptr;             // Serialized data blob representing a cached RelocatableShader object.
+  bool crcPending = false;              // Whether the CRC of the data blob still has to be verified on first access
+  bool sharedData = false;              // Whether the data blob is shared with entries with other keys, in which case
+                                        // it does not follow a copy of the header of this entry in memory
+  std::shared_ptr<const void> storage;  // Memory holding the data blob, shared with other entries and caches
+  std::atomic<uint64_t> lastAccess{0};  // Access tick of the most recent lookup of the entry
+  std::atomic<uint64_t> accessCount{0}; // Number of lookups of the entry
+  std::atomic<unsigned> useCount{0};    // Number of handles to the entry that have not been released yet
+  // Condition variable used to wait for compilation of the entry to finish, created by the first thread that waits, so
+  // that finishing the compilation of one entry does not wake the threads waiting for other entries
+  std::unique_ptr<std::condition_variable_any> compileDone;
 };
 
 // The key in hash map is a 64-bit compacted Shader Hash
 typedef std::unordered_map<uint64_t, ShaderIndex *> ShaderIndexMap;
 
+// Shader data that is stored once for all of the entries whose shader data is identical.
+struct ShaderContent {
+  uint64_t crc;                   // CRC of the shader data
+  size_t size;                    // Size of the shader data in bytes, not including the header
+  std::weak_ptr<const void> data; // The shader data in memory, which is released once no entry refers to it
+};
+
+// The key in hash map is the content hash of the shader data
+typedef std::unordered_map<uint64_t, ShaderContent> ShaderContentMap;
+
+// Number of bits of the hash key used to select a shard of the shader index map, and the resulting shard count.
+static constexpr unsigned ShaderIndexShardBits = 4;
+static constexpr unsigned ShaderIndexShardCount = 1U << ShaderIndexShardBits;
+
+// One shard of the shader index map. Each shard has its own reader/writer lock, so that lookups of different shaders
+// (and concurrent lookups of the same ready shader) do not serialize on a single cache-wide lock.
+struct ShaderIndexShard {
+  // Read/Write lock for access to the shard's hash map and the state of its entries
+  llvm::sys::RWMutex lock;
+  // Map of shader index data for the shaders whose keys fall into this shard
+  ShaderIndexMap indexMap;
+};
+
 // Specifies auxiliary info necessary to create a shader cache object.
 struct ShaderCacheAuxCreateInfo {
   ShaderCacheMode shaderCacheMode; // Mode of shader cache
@@ -92,15 +139,21 @@ static constexpr uint8_t DateLength = 11;
 // Length of time field used in BuildUniqueId
 static constexpr uint8_t TimeLength = 8;
 
+// Version of the layout of the serialized shader cache data, stored in BuildUniqueId
+static constexpr uint32_t ShaderCacheFormatVersion = 1;
+
 // Opaque data type representing an ID that uniquely identifies a particular build of LLPC. Such an ID will be stored
 // with all serialized pipelines and in the shader cache, and used during load of that data to ensure the version of
-// PAL that loads the data is exactly the same as the version that stored it. Currently, this ID is just the date
-// and time when LLPC was built.
+// PAL that loads the data is exactly the same as the version that stored it. Currently, this ID is the date and time
+// when LLPC was built, along with the versions of the data layout and of the LLPC interface, so that a cache file that
+// is shipped separately from the driver can also be checked by tools that were not built at the same time.
 struct BuildUniqueId {
   uint8_t buildDate[DateLength]; // Build date
   uint8_t buildTime[TimeLength]; // Build time
   GfxIpVersion gfxIp;            // Graphics IP version info
   MetroHash::Hash hash;          // Hash code of compilation options
+  uint32_t formatVersion;        // Version of the serialized data layout, ShaderCacheFormatVersion
+  uint32_t interfaceVersion;     // LLPC interface version, with the major version in the upper 16 bits
 };
 
 // This the header for the shader cache data when the cache is serialized/written to disk
@@ -112,6 +165,35 @@ struct ShaderCacheSerializedHeader {
   size_t shaderDataEnd;  // Offset to the end of shader data
 };
 
+// The serialized data of a shader cache as pieces that refer to the data of its entries, so that it can be written
+// out with scatter-gather I/O instead of being copied into one blob. The pieces stay valid while this is alive, even
+// if the entries are evicted in the meantime.
+struct ShaderCacheSerializedPieces {
+  ShaderCacheSerializedHeader header;               // Header, which comes before the pieces
+  std::vector<llvm::ArrayRef<uint8_t>> pieces;      // Shader data that follows the header, in order
+  std::vector<std::shared_ptr<const void>> storage; // Memory of the entries that the pieces refer to
+  size_t size;                                      // Total size of the header and the pieces
+};
+
+// Statistics of a shader cache file written by ShaderCache::writePackedFile
+struct ShaderCachePackStats {
+  size_t shaderCount;     // Number of entries in the file
+  size_t referenceCount;  // Number of entries stored as references to identical shader data earlier in the file
+  size_t compressedCount; // Number of full records compressed when they were packed
+  size_t fileSize;        // Size of the file in bytes
+};
+
+// Header of a manifest of the entries looked up in a shader cache. It is followed by the 64-bit keys of the entries,
+// in the order of their first lookup.
+struct ShaderCacheManifestHeader {
+  uint32_t magic;    // Must be ShaderCacheManifestMagic
+  uint32_t version;  // Must be ShaderCacheManifestVersion
+  uint64_t keyCount; // Number of keys that follow the header
+};
+
+static constexpr uint32_t ShaderCacheManifestMagic = 0x4D43504C; // "LPCM"
+static constexpr uint32_t ShaderCacheManifestVersion = 1;
+
 typedef void *CacheEntryHandle;
 
 // =====================================================================================================================
@@ -126,16 +208,30 @@ public:
   void Destroy() override;
 
   LLPC_NODISCARD Result Serialize(void *blob, size_t *size) override;
+  LLPC_NODISCARD Result serializePieces(ShaderCacheSerializedPieces *pieces);
 
   LLPC_NODISCARD Result Merge(unsigned srcCacheCount, const IShaderCache **ppSrcCaches) override;
 
+  LLPC_NODISCARD Result loadFile(const char *filePath);
+  LLPC_NODISCARD Result writePackedFile(const char *filePath, bool compress, ShaderCachePackStats *stats = nullptr);
+  LLPC_NODISCARD static Result readFileBuildId(const char *filePath, BuildUniqueId *buildId);
+
+  LLPC_NODISCARD Result SerializeManifest(void *blob, size_t *size) override;
+
+  LLPC_NODISCARD Result Prefetch(const void *manifest, size_t manifestSize) override;
+
+  void waitForPrefetch();
+
   LLPC_NODISCARD ShaderEntryState findShader(MetroHash::Hash hash, bool allocateOnMiss, CacheEntryHandle *phEntry);
 
   void insertShader(CacheEntryHandle hEntry, const void *blob, size_t size);
 
   void resetShader(CacheEntryHandle hEntry);
 
-  LLPC_NODISCARD Result retrieveShader(CacheEntryHandle hEntry, const void **ppBlob, size_t *size);
+  void releaseShader(CacheEntryHandle hEntry);
+
+  LLPC_NODISCARD Result retrieveShader(CacheEntryHandle hEntry, const void **ppBlob, size_t *size,
+                                       std::vector<uint8_t> *decompressionBuffer = nullptr);
 
   LLPC_NODISCARD bool isCompatible(const ShaderCacheCreateInfo *createInfo,
                                    const ShaderCacheAuxCreateInfo *auxCreateInfo);
@@ -148,61 +244,155 @@ private:
                                       bool *cacheFileExists);
   LLPC_NODISCARD Result validateAndLoadHeader(const ShaderCacheSerializedHeader *header, size_t dataSourceSize);
   LLPC_NODISCARD Result loadCacheFromBlob(const void *initialData, size_t initialDataSize);
-  LLPC_NODISCARD Result populateIndexMap(void *dataStart, size_t dataSize);
+  LLPC_NODISCARD Result populateIndexMap(void *dataStart, size_t dataSize, const std::shared_ptr<const void> &storage,
+                                         bool deferCrc = false);
+  void collectSerializedPieces(ShaderCacheSerializedPieces *pieces, ShaderContentMap *writtenContents);
+  LLPC_NODISCARD std::shared_ptr<const void> findContent(ShaderHeader *header, const void *data);
+  void registerContent(const ShaderIndex *index);
+  LLPC_NODISCARD bool verifyDeferredCrc(ShaderIndex *index);
+  void checkDeferredCrc(ShaderIndex *index);
+  LLPC_NODISCARD bool loadFromExternalCache(uint64_t hashKey, ShaderIndex *index);
+  void recordFirstAccess(ShaderIndex *index, uint64_t hashKey);
+  void prefetchShaders(std::vector<uint64_t> hashKeys);
+  void prefetchShader(uint64_t hashKey);
   LLPC_NODISCARD uint64_t calculateCrc(const uint8_t *data, size_t numBytes);
+  LLPC_NODISCARD static uint64_t calculateContentHash(const void *data, size_t numBytes);
 
   LLPC_NODISCARD Result loadCacheFromFile();
+  LLPC_NODISCARD void *mapCacheFile(size_t fileSize);
   void resetCacheFile();
   LLPC_NODISCARD Result addShaderToFile(const ShaderIndex *index);
-
-  void *getCacheSpace(size_t numBytes);
-
-  // Lock cache map
-  void lockCacheMap(bool readOnly) { m_lock.lock(); }
-
-  // Unlock cache map
-  void unlockCacheMap(bool readOnly) { m_lock.unlock(); }
+  LLPC_NODISCARD Result flushFileJournal();
+  void startFileJournalWrite();
+  LLPC_NODISCARD Result finishFileJournalWrite();
+  void writeFileJournalBatch(size_t fileShaderCount, size_t fileDataEnd);
+  LLPC_NODISCARD Result writeFileJournal(llvm::ArrayRef<uint8_t> journal, size_t journalShaders, size_t fileShaderCount,
+                                         size_t fileDataEnd);
+  void compactCacheFile();
+  void writeCompactedFile(std::vector<uint8_t> fileData, size_t shaderCount);
+  LLPC_NODISCARD Result claimSegment(bool *cacheFileExists);
+  std::string getSegmentPrefix();
+  std::vector<std::string> readSegmentIndex();
+  void addSegmentToIndex();
+  void loadSegments();
+  LLPC_NODISCARD Result loadSegment(const char *segmentPath);
+  LLPC_NODISCARD Result openLockFile();
+  LLPC_NODISCARD Result lockCacheFile();
+  void unlockCacheFile();
+
+  std::shared_ptr<uint8_t> getCacheSpace(size_t numBytes);
+  uint8_t *getEntrySpace(ShaderIndex *index, size_t numBytes);
+
+  void enforceBudgets();
+  void evictShaders(size_t targetSize);
+
+  // Returns the shard of the shader index map that holds the given key. The top bits of the key select the shard.
+  ShaderIndexShard &getShard(uint64_t hashKey) {
+    return m_shards[hashKey >> (64 - ShaderIndexShardBits)];
+  }
+
+  // Lock one shard of the cache map
+  static void lockShard(ShaderIndexShard &shard, bool readOnly) {
+    if (readOnly)
+      shard.lock.lock_shared();
+    else
+      shard.lock.lock();
+  }
+
+  // Unlock one shard of the cache map
+  static void unlockShard(ShaderIndexShard &shard, bool readOnly) {
+    if (readOnly)
+      shard.lock.unlock_shared();
+    else
+      shard.lock.unlock();
+  }
+
+  // Lock the whole cache map (all shards, in order), and the cache storage if not read-only
+  void lockCacheMap(bool readOnly) {
+    for (ShaderIndexShard &shard : m_shards)
+      lockShard(shard, readOnly);
+    if (!readOnly)
+      m_lock.lock();
+  }
+
+  // Unlock the whole cache map
+  void unlockCacheMap(bool readOnly) {
+    if (!readOnly)
+      m_lock.unlock();
+    for (ShaderIndexShard &shard : m_shards)
+      unlockShard(shard, readOnly);
+  }
 
   // Satisfies `BasicLockable`, so that we can pass it to `std::condition_variable_any::wait`.
   // Does *not* automatically lock/unlock on construction/destruction.
-  class CacheMapLock {
+  class ShardLock {
   public:
-    CacheMapLock(ShaderCache &sc, bool readOnlyLock) : m_sc(sc), m_readOnlyLock(readOnlyLock) {}
+    ShardLock(ShaderIndexShard &shard, bool readOnlyLock) : m_shard(shard), m_readOnlyLock(readOnlyLock) {}
 
-    void lock() { m_sc.lockCacheMap(m_readOnlyLock); }
-    void unlock() { m_sc.unlockCacheMap(m_readOnlyLock); }
+    void lock() { lockShard(m_shard, m_readOnlyLock); }
+    void unlock() { unlockShard(m_shard, m_readOnlyLock); }
 
   private:
-    ShaderCache &m_sc;
+    ShaderIndexShard &m_shard;
     const bool m_readOnlyLock;
   };
 
-  // Returns a new lock object that satisfies `BasicLockable`. It can be used with `std::condition_variable_any`.
-  CacheMapLock makeCacheLock(bool readOnlyLock) { return {*this, readOnlyLock}; }
-
   bool useExternalCache() { return m_getValueFunc && m_storeValueFunc; }
 
   void resetRuntimeCache();
   void getBuildTime(BuildUniqueId *buildId);
 
-  llvm::sys::Mutex m_lock; // Read/Write lock for access to the shader cache hash map
+  llvm::sys::Mutex m_lock; // Lock for access to the cache storage (allocations, on-disk file and counters)
   File m_onDiskFile;       // File for on-disk storage of the cache
   bool m_disableCache;     // Whether disable cache completely
 
-  // Map of shader index data which detail the hash, crc, size and CPU memory location for each shader
+  // Sharded map of shader index data which detail the hash, crc, size and CPU memory location for each shader
   // in the cache.
-  ShaderIndexMap m_shaderIndexMap;
+  ShaderIndexShard m_shards[ShaderIndexShardCount];
 
   // In memory copy of the shaderDataEnd and totalShaders stored in the on-disk file. We keep a copy to avoid having
   //  to do a read/modify/write of the value when adding a new shader.
   size_t m_shaderDataEnd;
   size_t m_totalShaders;
 
+  // Write-behind journal of shader data that has been added to the cache but not yet appended to the on-disk file.
+  // It is appended with a single write, followed by a single header update, once it grows large enough.
+  std::vector<uint8_t> m_fileJournal;
+  size_t m_fileJournalShaders; // Number of shaders in the write-behind journal
+
+  // Batch of the write-behind journal that is being appended to the on-disk file in the background. Shader data added
+  // meanwhile is collected in the journal, which is appended once the batch has been written.
+  std::vector<uint8_t> m_fileWriteBatch;
+  size_t m_fileWriteBatchShaders;  // Number of shaders in the batch being appended
+  Result m_fileWriteResult;        // Result of the last append of a batch in the background
+  std::atomic<bool> m_fileWriting; // Whether a batch is being appended in the background
+  std::thread m_fileWriterThread;  // Thread of the last append of a batch in the background
+
+  ShaderContentMap m_contents;              // Shader data in memory, by content hash
+  ShaderContentMap m_fileContents;          // Shader data stored in full records of the on-disk file
+  ShaderContentMap m_compactedFileContents; // Shader data stored in full records of the file being compacted
+
+  // Descriptor of the lock file of a cache file shared between processes, or -1 if the cache file is not shared
+  int m_lockFileFd;
+
+  std::string m_segmentDir; // Directory of the segments of a segmented cache
+  int m_segmentLockFd;      // Descriptor of the lock file of the segment of a segmented cache, or -1 if not segmented
+
+  size_t m_maxMemorySize;             // Budget of the shader data held in memory, or 0 for no limit
+  size_t m_maxFileSize;               // Budget of the on-disk file, or 0 for no limit
+  size_t m_liveDataSize;              // Size of the shader data of the entries in the cache
+  std::atomic<uint64_t> m_accessTick; // Tick of the last lookup, used to find the least recently used entries
+  bool m_compacting;                  // Whether a compaction of the on-disk file is running in the background
+  std::thread m_compactionThread;     // Thread of the last compaction of the on-disk file
+
+  std::mutex m_manifestLock;             // Lock for access to the manifest keys
+  std::vector<uint64_t> m_manifestKeys;  // Keys of the entries looked up, in the order of their first lookup
+  std::thread m_prefetchThread;          // Thread of the last prefetch of the entries of a manifest
+  std::atomic<bool> m_prefetchCancelled; // Whether the prefetch should stop, as the cache is being destroyed
+
   char m_fileFullPath[PathBufferLen]; // Full path/filename of the shader cache on-disk file
 
-  std::list<std::pair<uint8_t *, size_t>> m_allocationList; // Memory allocated by GetCacheSpace
-  unsigned m_serializedSize;                                // Serialized byte size of whole shader cache
-  std::condition_variable_any m_conditionVariable; // Condition variable used to wait for compililation to finish
+  std::shared_ptr<llvm::sys::fs::mapped_file_region> m_mappedFile; // Read-only mapping of the on-disk file, if any
   const void *m_clientData;                        // Client data that will be used by function GetValue and StoreValue
   ShaderCacheGetValue m_getValueFunc;              // GetValue function used to query an external cache for shader data
   ShaderCacheStoreValue m_storeValueFunc;          // StoreValue function used to store shader data in an external cache
@@ -115,11 +115,58 @@ enum CacheAccessInfo : uint8_t {
   InternalCacheHit,    ///< cache hit using internal cache.
 };
 
+/// Enumerates the layers of caches that builds look up compiled code in, for CacheStats.
+enum CacheLayer : unsigned {
+  CacheLayerInternalCache = 0,      ///< The compiler's internal ICache
+  CacheLayerApplicationCache,       ///< The ICache given in the build info
+  CacheLayerInternalShaderCache,    ///< The compiler's internal shader cache
+  CacheLayerApplicationShaderCache, ///< The shader cache given in the build info
+  CacheLayerGlueShaderMemory,       ///< The compiler's in-memory cache of the most recently used glue shader ELFs
+  CacheLayerCount,                  ///< Count of cache layers
+};
+
+/// Number of buckets of the histogram of the lookup latencies of a cache layer. Bucket 0 counts the lookups that took
+/// less than 1 microsecond, bucket i those that took from 2^(i-1) up to 2^i microseconds, and the last bucket all
+/// longer lookups.
+static const unsigned CacheLatencyBucketCount = 16;
+
+/// Represents the statistics of the lookups in one cache layer.
+struct CacheLayerStats {
+  uint64_t lookups;   ///< Count of lookups
+  uint64_t hits;      ///< Count of lookups that found the entry
+  uint64_t bytesRead; ///< Total size in bytes of the entries found
+  uint64_t waits;     ///< Count of lookups that waited for another thread to finish populating the entry
+  uint64_t waitNs;    ///< Total time spent waiting, in nanoseconds
+  uint64_t latencyNs; ///< Total time spent in lookups (including waits), in nanoseconds
+  uint64_t latencyHistogram[CacheLatencyBucketCount]; ///< Count of lookups by latency, see CacheLatencyBucketCount
+};
+
+/// Represents the statistics of the cache lookups of the builds of all compilers in the process.
+struct CacheStats {
+  CacheLayerStats layers[CacheLayerCount]; ///< Statistics of each cache layer, indexed by CacheLayer
+};
+
+/// Represents the static estimate of the cost of building a pipeline, made from the summaries of its shader modules
+/// without compiling anything, so that the client can decide whether to build the pipeline eagerly or in the
+/// background.
+struct PipelineCostEstimate {
+  unsigned stageCount;         ///< Count of the shader stages
+  unsigned instructionCount;   ///< Count of the SPIR-V instructions in the function bodies of all stages
+  unsigned functionCount;      ///< Count of the SPIR-V functions of all stages
+  unsigned loopCount;          ///< Count of the SPIR-V structured loops of all stages
+  bool relocatable;            ///< Whether the pipeline would be built from relocatable shader ELFs
+  double estimatedCompileTime; ///< Estimated compile time of the pipeline on a cache miss, in milliseconds
+  bool preferBackgroundBuild;  ///< Whether the estimated compile time is long enough that the pipeline should be built
+                               ///  in the background, such as with BuildGraphicsPipelineAsync
+};
+
 /// Represents output of building a graphics pipeline.
 struct GraphicsPipelineBuildOut {
   BinaryData pipelineBin; ///< Output pipeline binary data
   CacheAccessInfo pipelineCacheAccess; ///< Pipeline cache access status i.e., hit, miss, or not checked
   CacheAccessInfo stageCacheAccesses[ShaderStageCount]; ///< Shader cache access status i.e., hit, miss, or not checked
+  size_t peakMemoryGrowth; ///< Growth of the heap usage at its peak while building the pipeline, in bytes (0 if the
+                           ///  pipeline was not compiled, such as on a cache hit)
 };
 
 /// Represents output of building a compute pipeline.
@@ -127,6 +174,8 @@ struct ComputePipelineBuildOut {
   BinaryData pipelineBin; ///< Output pipeline binary data
   CacheAccessInfo pipelineCacheAccess; ///< Pipeline cache access status i.e., hit, miss, or not checked
   CacheAccessInfo stageCacheAccess;    ///< Shader cache access status i.e., hit, miss, or not checked
+  size_t peakMemoryGrowth; ///< Growth of the heap usage at its peak while building the pipeline, in bytes (0 if the
+                           ///  pipeline was not compiled, such as on a cache hit)
 };
 
 /// Defines callback function used to lookup shader cache info in an external cache
@@ -149,6 +198,12 @@ struct ShaderCacheCreateInfo {
   const void *pClientData;
   ShaderCacheGetValue pfnGetValueFunc;     ///< [Optional] Function to lookup shader cache data in an external cache
   ShaderCacheStoreValue pfnStoreValueFunc; ///< [Optional] Function to store shader cache data in an external cache
+
+  // [optional] Budgets of the shader cache. Once a budget is exceeded, the least recently used entries that are not in
+  // use are evicted. Zero means no limit.
+  size_t maxMemorySize; ///< [Optional] Maximum size in bytes of the shader data held in memory
+  size_t maxFileSize;   ///< [Optional] Maximum size in bytes of the on-disk cache file, which is compacted in the
+                        ///  background to only hold the entries that are still in the cache once it is exceeded
 };
 
 // =====================================================================================================================
@@ -179,6 +234,28 @@ public:
   ///          memory cannot be allocated.
   virtual Result Merge(unsigned srcCacheCount, const IShaderCache **ppSrcCaches) = 0;
 
+  /// Writes a manifest of the entries that have been looked up in this shader cache, in the order of their first
+  /// lookup, or queries the size required for it. Passing the manifest to Prefetch in a later run loads those entries
+  /// before they are needed.
+  ///
+  /// @param [in]      pBlob  System memory pointer where the manifest should be placed. This parameter can be null
+  ///                         when querying the size of the manifest.
+  /// @param [in,out]  pSize  Size of the memory pointed to by pBlob. If the value stored in pSize is zero then no
+  ///                         data will be copied and instead the size required for the manifest will be returned in
+  ///                         pSize.
+  ///
+  /// @returns : Success if the manifest was written or its size was queried, ErrorInvalidValue if pSize is too small.
+  virtual Result SerializeManifest(void *pBlob, size_t *pSize) = 0;
+
+  /// Starts loading and validating the entries recorded in a manifest on background threads, so that the first
+  /// lookups of those entries do not wait for cache I/O. Entries that are not in the cache are skipped.
+  ///
+  /// @param [in]  pManifest     Manifest written by SerializeManifest. It is copied, so it need not outlive the call.
+  /// @param [in]  manifestSize  Size of the manifest in bytes.
+  ///
+  /// @returns : Success if the prefetch was started, ErrorInvalidValue if the manifest is malformed.
+  virtual Result Prefetch(const void *pManifest, size_t manifestSize) = 0;
+
   /// Frees all resources associated with this object.
   virtual void Destroy() = 0;
 
@@ -190,6 +267,54 @@ protected:
   virtual ~IShaderCache() {}
 };
 
+/// Enumerates the priority levels of asynchronous pipeline builds. The builds of a higher level are started first, and
+/// a running build of a lower level lets them run at its next pass boundary. A pending build of a lower level gains
+/// urgency as it waits, so that it is not starved.
+enum class PipelineBuildPriority : unsigned {
+  Background = 0, ///< Speculative build, such as a precompile of a pipeline that may be needed later
+  Normal,         ///< Build of a pipeline that is needed soon
+  Foreground,     ///< Build of a pipeline that the next frame is waiting for
+  Count
+};
+
+// =====================================================================================================================
+/// Callback function type, called when an asynchronous pipeline build completes.
+///
+/// @param [in] pUserData  User data given when the build was submitted
+/// @param [in] result     Result of the build
+typedef void(VKAPI_CALL *PipelineBuildCallbackFunc)(void *pUserData, Result result);
+
+// =====================================================================================================================
+/// Represents the interfaces of an asynchronous pipeline build, submitted by ICompiler::BuildGraphicsPipelineAsync or
+/// ICompiler::BuildComputePipelineAsync.
+class IPipelineBuildJob {
+public:
+  /// Waits for the build to complete.
+  ///
+  /// @returns : Result of the build, or Result::ErrorUnavailable if it was cancelled.
+  virtual Result Wait() = 0;
+
+  /// Checks whether the build has completed, without waiting.
+  ///
+  /// @returns : True if the build has completed (or was cancelled and has stopped).
+  virtual bool IsComplete() const = 0;
+
+  /// Cancels the build. A build that has not started yet is dropped, and completes immediately with
+  /// Result::ErrorUnavailable. A build that is already running stops at its next cancellation point, and then
+  /// completes with Result::ErrorUnavailable; if it has passed its last cancellation point, it completes normally.
+  virtual void Cancel() = 0;
+
+  /// Waits for the build to complete, then frees all resources associated with this object.
+  virtual void VKAPI_CALL Destroy() = 0;
+
+protected:
+  /// @internal Constructor. Prevent use of new operator on this interface.
+  IPipelineBuildJob() {}
+
+  /// @internal Destructor. Prevent use of delete operator on this interface.
+  virtual ~IPipelineBuildJob() {}
+};
+
 // =====================================================================================================================
 /// Represents the interfaces of a pipeline compiler.
 class ICompiler {
@@ -250,6 +375,165 @@ public:
   virtual Result BuildComputePipeline(const ComputePipelineBuildInfo *pPipelineInfo,
                                       ComputePipelineBuildOut *pPipelineOut, void *pPipelineDumpFile = nullptr) = 0;
 
+  /// Submits a graphics pipeline build to run asynchronously on the compiler's worker threads. The pipeline info and
+  /// all the data it points to must remain valid, and the pipeline output must not be accessed, until the build
+  /// completes. A build of the same pipeline as a pending or running one waits for it, and then gets its result from
+  /// the caches.
+  ///
+  /// @param [in]  pPipelineInfo  Info to build this graphics pipeline
+  /// @param [out] pPipelineOut : Output of building this graphics pipeline, valid once the build completes
+  /// @param [in]  pfnCallback    Optional function called on completion, on an arbitrary thread
+  /// @param [in]  pUserData      User data passed to pfnCallback
+  /// @param [out] ppJob : Handle of the submitted build, to be destroyed by the caller
+  /// @param [in]  priority       Priority level of the build
+  ///
+  /// @returns : Result::Success if the build was submitted. Other return codes indicate failure.
+  virtual Result BuildGraphicsPipelineAsync(const GraphicsPipelineBuildInfo *pPipelineInfo,
+                                            GraphicsPipelineBuildOut *pPipelineOut,
+                                            PipelineBuildCallbackFunc pfnCallback, void *pUserData,
+                                            IPipelineBuildJob **ppJob,
+                                            PipelineBuildPriority priority = PipelineBuildPriority::Normal) = 0;
+
+  /// Submits a compute pipeline build to run asynchronously on the compiler's worker threads. The pipeline info and
+  /// all the data it points to must remain valid, and the pipeline output must not be accessed, until the build
+  /// completes. A build of the same pipeline as a pending or running one waits for it, and then gets its result from
+  /// the caches.
+  ///
+  /// @param [in]  pPipelineInfo  Info to build this compute pipeline
+  /// @param [out] pPipelineOut : Output of building this compute pipeline, valid once the build completes
+  /// @param [in]  pfnCallback    Optional function called on completion, on an arbitrary thread
+  /// @param [in]  pUserData      User data passed to pfnCallback
+  /// @param [out] ppJob : Handle of the submitted build, to be destroyed by the caller
+  /// @param [in]  priority       Priority level of the build
+  ///
+  /// @returns : Result::Success if the build was submitted. Other return codes indicate failure.
+  virtual Result BuildComputePipelineAsync(const ComputePipelineBuildInfo *pPipelineInfo,
+                                           ComputePipelineBuildOut *pPipelineOut,
+                                           PipelineBuildCallbackFunc pfnCallback, void *pUserData,
+                                           IPipelineBuildJob **ppJob,
+                                           PipelineBuildPriority priority = PipelineBuildPriority::Normal) = 0;
+
+  /// Compiles ahead of time the glue shaders (fetch shader, color export shader and null fragment shader) that are
+  /// needed to link the given graphics pipelines from relocatable shader ELFs, and keeps them in the caches, so that
+  /// building those pipelines, or others with the same vertex input and color export formats, only has to link. The
+  /// relocatable shader ELFs of the pipelines are built or found in the caches on the way.
+  ///
+  /// @param [in]  ppPipelineInfos  Array of infos of the graphics pipelines whose glue shaders are to be compiled
+  /// @param [in]  pipelineCount    Count of pipeline infos
+  ///
+  /// @returns : Result::Success if the glue shaders of all the pipelines were compiled. Unsupported if a pipeline
+  ///          cannot be built from relocatable shader ELFs. Other return codes indicate failure.
+  virtual Result PrecompileGlueShaders(const GraphicsPipelineBuildInfo *const *ppPipelineInfos,
+                                       unsigned pipelineCount) = 0;
+
+  /// Builds one part of a graphics pipeline as a library: the pre-rasterization stages (UnlinkedStageVertexProcess) or
+  /// the fragment stage (UnlinkedStageFragment). A library is the relocatable shader ELF of its stages, which depends
+  /// only on the pipeline state that those stages use. It is cached separately from the other part, so that the parts
+  /// can be built on different threads and shared between pipelines. The shader infos of the other part are ignored.
+  ///
+  /// @param [in]  pPipelineInfo  Info of the graphics pipeline that the library is a part of
+  /// @param [in]  part           Part of the pipeline to build
+  /// @param [out] pPipelineOut : Output of building the library; pipelineBin is the library ELF
+  ///
+  /// @returns : Result::Success if successful. Unsupported if the pipeline cannot be built from relocatable shader
+  ///          ELFs. Other return codes indicate failure.
+  virtual Result BuildGraphicsPipelineLibrary(const GraphicsPipelineBuildInfo *pPipelineInfo,
+                                              Vkgc::UnlinkedShaderStage part,
+                                              GraphicsPipelineBuildOut *pPipelineOut) = 0;
+
+  /// Links a graphics pipeline from the libraries of its parts, built by BuildGraphicsPipelineLibrary, and the glue
+  /// shaders for its vertex input and color export state, which are the interface between the parts and the fixed
+  /// function state. The glue shaders are compiled if they are not in the caches, and can be compiled ahead of time by
+  /// PrecompileGlueShaders; no shader is compiled from SPIR-V.
+  ///
+  /// @param [in]  pPipelineInfo  Info of the graphics pipeline, with the shader infos the libraries were built from
+  /// @param [in]  pLibraries     Library ELFs, indexed by Vkgc::UnlinkedShaderStage; an empty entry means that the
+  ///                             pipeline has no stage of that part
+  /// @param [in]  libraryCount   Count of entries in pLibraries, at most UnlinkedStageFragment + 1
+  /// @param [out] pPipelineOut : Output of linking the pipeline
+  ///
+  /// @returns : Result::Success if successful. Other return codes indicate failure.
+  virtual Result LinkGraphicsPipelineLibraries(const GraphicsPipelineBuildInfo *pPipelineInfo,
+                                               const BinaryData *pLibraries, unsigned libraryCount,
+                                               GraphicsPipelineBuildOut *pPipelineOut) = 0;
+
+  /// Builds a graphics pipeline quickly by linking relocatable shader ELFs, which are compiled without knowledge of
+  /// the other stages, and then submits a whole-pipeline build of it at background priority, which can remove unused
+  /// exports and user data loads and pack varyings across stages. If the pipeline cannot be built from relocatable
+  /// shader ELFs, the fast build instead compiles the whole pipeline at the fast compile tier (as with the fastCompile
+  /// pipeline option), and the background build compiles it again at the full tier. The optimized pipeline is added
+  /// to the pipeline cache, but the fast one is not, so later builds of the pipeline get the optimized one from the
+  /// cache. The client can replace the fast pipeline with the optimized one once the background build completes. As
+  /// with BuildGraphicsPipelineAsync, the pipeline info and all the data it points to must remain valid, and the
+  /// optimized pipeline output must not be accessed, until the background build completes.
+  ///
+  /// No background build is submitted, and *ppJob is set to null, if the pipeline was found in the cache, as
+  /// pPipelineOut already has the optimized pipeline then.
+  ///
+  /// @param [in]  pPipelineInfo          Info to build this graphics pipeline
+  /// @param [out] pPipelineOut : Output of the fast build of this graphics pipeline
+  /// @param [out] pOptimizedPipelineOut : Output of the background build, valid once the build completes
+  /// @param [in]  pfnCallback            Optional function called on completion of the background build, on an
+  ///                                     arbitrary thread
+  /// @param [in]  pUserData              User data passed to pfnCallback
+  /// @param [out] ppJob : Handle of the background build, to be destroyed by the caller, or null
+  ///
+  /// @returns : Result::Success if the fast build succeeded. Other return codes indicate failure.
+  virtual Result BuildGraphicsPipelineOptimizeLater(const GraphicsPipelineBuildInfo *pPipelineInfo,
+                                                    GraphicsPipelineBuildOut *pPipelineOut,
+                                                    GraphicsPipelineBuildOut *pOptimizedPipelineOut,
+                                                    PipelineBuildCallbackFunc pfnCallback, void *pUserData,
+                                                    IPipelineBuildJob **ppJob) = 0;
+
+  /// Builds a compute pipeline whose compute shader calls functions of compute libraries, by linking the relocatable
+  /// shader ELF of the compute shader with the relocatable ELFs of the libraries. A compute library is a SPIR-V module
+  /// with the Linkage capability and no entry-points, whose exported functions the compute shader imports. The
+  /// compiler keeps the ELFs of the most recently used libraries, so that a library is compiled once and then only
+  /// linked into each pipeline that calls it.
+  ///
+  /// @param [in]  pPipelineInfo  Info to build this compute pipeline
+  /// @param [in]  ppLibraryInfos Infos of the compute libraries; the resource mapping and options of each must match
+  ///                             those of the pipeline
+  /// @param [in]  libraryCount   Count of compute libraries
+  /// @param [out] pPipelineOut : Output of building this compute pipeline
+  ///
+  /// @returns : Result::Success if successful. Unsupported if the pipeline or a library cannot be built as a
+  ///          relocatable shader ELF. Other return codes indicate failure.
+  virtual Result BuildComputePipelineWithLibraries(const ComputePipelineBuildInfo *pPipelineInfo,
+                                                   const ComputePipelineBuildInfo *const *ppLibraryInfos,
+                                                   unsigned libraryCount, ComputePipelineBuildOut *pPipelineOut) = 0;
+
+  /// Estimates the cost of building a graphics pipeline from the summaries collected when its shader modules were
+  /// built, without compiling it. The estimate is calibrated by the compile times of the pipelines this compiler has
+  /// built so far.
+  ///
+  /// @param [in]  pPipelineInfo  Info of the graphics pipeline
+  /// @param [out] pEstimate : Cost estimate of building the pipeline
+  ///
+  /// @returns : Result::Success if successful. Other return codes indicate failure.
+  virtual Result EstimatePipelineCost(const GraphicsPipelineBuildInfo *pPipelineInfo,
+                                      PipelineCostEstimate *pEstimate) = 0;
+
+  /// Estimates the cost of building a compute pipeline from the summary collected when its shader module was built,
+  /// without compiling it. The estimate is calibrated by the compile times of the pipelines this compiler has built so
+  /// far.
+  ///
+  /// @param [in]  pPipelineInfo  Info of the compute pipeline
+  /// @param [out] pEstimate : Cost estimate of building the pipeline
+  ///
+  /// @returns : Result::Success if successful. Other return codes indicate failure.
+  virtual Result EstimatePipelineCost(const ComputePipelineBuildInfo *pPipelineInfo,
+                                      PipelineCostEstimate *pEstimate) = 0;
+
+  /// Gets the statistics of the cache lookups since they were last reset. The statistics are collected for the builds
+  /// of all compilers in the process.
+  ///
+  /// @param [out] pStats  Statistics of the cache lookups
+  virtual void GetCacheStats(CacheStats *pStats) = 0;
+
+  /// Resets the statistics of the cache lookups.
+  virtual void ResetCacheStats() = 0;
+
 #if LLPC_ENABLE_SHADER_CACHE
   /// Creates a shader cache object with the requested properties.
   ///
@@ -32,6 +32,7 @@
 #include "llpcContext.h"
 #include "llpcDebug.h"
 #include "llpcSpirvLowerAccessChain.h"
+#include "llpcSpirvLowerBoundsCheck.h"
 #include "llpcSpirvLowerConstImmediateStore.h"
 #include "llpcSpirvLowerGlobal.h"
 #include "llpcSpirvLowerInstMetaRemove.h"
@@ -46,6 +47,7 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Transforms/AggressiveInstCombine/AggressiveInstCombine.h"
 #include "llvm/Transforms/IPO.h"
@@ -75,6 +77,12 @@
 using namespace lgc;
 using namespace llvm;
 
+// -fuse-spirv-lower-memory-passes: lower constant immediate stores as part of the SPIR-V memory operation lowering
+static cl::opt<bool> FuseSpirvLowerMemoryPasses(
+    "fuse-spirv-lower-memory-passes",
+    cl::desc("Lower constant immediate stores in the same module traversal as SPIR-V memory operations"),
+    cl::init(false));
+
 namespace Llpc {
 // =====================================================================================================================
 // Replace a constant with instructions using a builder.
@@ -184,14 +192,22 @@ void SpirvLower::addPasses(Context *context, ShaderStage stage, lgc::PassManager
   // Lower SPIR-V global variables, inputs, and outputs
   passMgr.addPass(SpirvLowerGlobal());
 
-  // Lower SPIR-V constant immediate store.
-  passMgr.addPass(SpirvLowerConstImmediateStore());
+  if (FuseSpirvLowerMemoryPasses) {
+    // Lower SPIR-V constant folding - must be done before instruction combining pass.
+    passMgr.addPass(SpirvLowerMathConstFolding());
 
-  // Lower SPIR-V constant folding - must be done before instruction combining pass.
-  passMgr.addPass(SpirvLowerMathConstFolding());
+    // Lower SPIR-V memory operations, along with constant immediate store
+    passMgr.addPass(SpirvLowerMemoryOp(true));
+  } else {
+    // Lower SPIR-V constant immediate store.
+    passMgr.addPass(SpirvLowerConstImmediateStore());
 
-  // Lower SPIR-V memory operations
-  passMgr.addPass(SpirvLowerMemoryOp());
+    // Lower SPIR-V constant folding - must be done before instruction combining pass.
+    passMgr.addPass(SpirvLowerMathConstFolding());
+
+    // Lower SPIR-V memory operations
+    passMgr.addPass(SpirvLowerMemoryOp());
+  }
 
   // Remove redundant load/store operations and do minimal optimization
   // It is required by SpirvLowerImageOp.
@@ -206,6 +222,9 @@ void SpirvLower::addPasses(Context *context, ShaderStage stage, lgc::PassManager
   passMgr.addPass(createModuleToFunctionPassAdaptor(SimplifyCFGPass()));
   passMgr.addPass(createModuleToFunctionPassAdaptor(EarlyCSEPass()));
 
+  // Remove bounds checks that always pass (must be after the above optimizations, which make the ranges provable)
+  passMgr.addPass(SpirvLowerBoundsCheck());
+
   // Lower SPIR-V floating point optimisation
   passMgr.addPass(SpirvLowerMathFloatOp());
 
@@ -264,14 +283,22 @@ void LegacySpirvLower::addPasses(Context *context, ShaderStage stage, legacy::Pa
   // Lower SPIR-V global variables, inputs, and outputs
   passMgr.add(createLegacySpirvLowerGlobal());
 
-  // Lower SPIR-V constant immediate store.
-  passMgr.add(createLegacySpirvLowerConstImmediateStore());
+  if (FuseSpirvLowerMemoryPasses) {
+    // Lower SPIR-V constant folding - must be done before instruction combining pass.
+    passMgr.add(createLegacySpirvLowerMathConstFolding());
 
-  // Lower SPIR-V constant folding - must be done before instruction combining pass.
-  passMgr.add(createLegacySpirvLowerMathConstFolding());
+    // Lower SPIR-V memory operations, along with constant immediate store
+    passMgr.add(createLegacySpirvLowerMemoryOp(true));
+  } else {
+    // Lower SPIR-V constant immediate store.
+    passMgr.add(createLegacySpirvLowerConstImmediateStore());
+
+    // Lower SPIR-V constant folding - must be done before instruction combining pass.
+    passMgr.add(createLegacySpirvLowerMathConstFolding());
 
-  // Lower SPIR-V memory operations
-  passMgr.add(createLegacySpirvLowerMemoryOp());
+    // Lower SPIR-V memory operations
+    passMgr.add(createLegacySpirvLowerMemoryOp());
+  }
 
   // Remove redundant load/store operations and do minimal optimization
   // It is required by SpirvLowerImageOp.
@@ -282,6 +309,9 @@ void LegacySpirvLower::addPasses(Context *context, ShaderStage stage, legacy::Pa
   passMgr.add(createCFGSimplificationPass());
   passMgr.add(createEarlyCSEPass());
 
+  // Remove bounds checks that always pass (must be after the above optimizations, which make the ranges provable)
+  passMgr.add(createLegacySpirvLowerBoundsCheck());
+
   // Lower SPIR-V floating point optimisation
   passMgr.add(createLegacySpirvLowerMathFloatOp());
 
@@ -48,6 +48,7 @@ class PassManager;
 
 class PassRegistry;
 void initializeLegacySpirvLowerAccessChainPass(PassRegistry &);
+void initializeLegacySpirvLowerBoundsCheckPass(PassRegistry &);
 void initializeLegacySpirvLowerMathConstFoldingPass(PassRegistry &);
 void initializeLegacySpirvLowerMathFloatOpPass(PassRegistry &);
 void initializeLegacySpirvLowerConstImmediateStorePass(PassRegistry &);
@@ -73,6 +74,7 @@ namespace Llpc {
 // @param passRegistry : Pass registry
 inline static void initializeLowerPasses(llvm::PassRegistry &passRegistry) {
   initializeLegacySpirvLowerAccessChainPass(passRegistry);
+  initializeLegacySpirvLowerBoundsCheckPass(passRegistry);
   initializeLegacySpirvLowerConstImmediateStorePass(passRegistry);
   initializeLegacySpirvLowerMathConstFoldingPass(passRegistry);
   initializeLegacySpirvLowerMathFloatOpPass(passRegistry);
@@ -87,15 +89,17 @@ inline static void initializeLowerPasses(llvm::PassRegistry &passRegistry) {
 class Context;
 
 llvm::ModulePass *createLegacySpirvLowerAccessChain();
+llvm::ModulePass *createLegacySpirvLowerBoundsCheck();
 llvm::ModulePass *createLegacySpirvLowerConstImmediateStore();
 llvm::ModulePass *createLegacySpirvLowerMathConstFolding();
 llvm::ModulePass *createLegacySpirvLowerMathFloatOp();
-llvm::ModulePass *createLegacySpirvLowerMemoryOp();
+llvm::ModulePass *createLegacySpirvLowerMemoryOp(bool lowerConstImmediateStore = false);
 llvm::ModulePass *createLegacySpirvLowerGlobal();
 llvm::ModulePass *createLegacySpirvLowerInstMetaRemove();
 llvm::ModulePass *createSpirvLowerResourceCollect(bool collectDetailUsage);
 llvm::ModulePass *createLegacySpirvLowerTerminator();
-llvm::ModulePass *createSpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo);
+llvm::ModulePass *createSpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo,
+                                             bool specConstPlaceholders = false);
 
 // =====================================================================================================================
 // Represents the pass of SPIR-V lowering operations, as the base class.
@@ -0,0 +1,336 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcSpirvLowerBoundsCheck.cpp
+ * @brief LLPC source file: contains implementation of class Llpc::SpirvLowerBoundsCheck.
+ * @details This pass removes the bounds checks that the SPIR-V reader and SpirvLowerMemoryOp put on accesses to
+ *          private and function arrays when range analysis shows that the index is always in bounds, such as a
+ *          constant offset or a loop induction variable bounded by the array size. The checks on induction variables
+ *          whose range is only known at run time are hoisted out of their loop by versioning it.
+ ***********************************************************************************************************************
+ */
+#include "llpcSpirvLowerBoundsCheck.h"
+#include "SPIRVInternal.h"
+#include "llpcContext.h"
+#include "llpcDebug.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+
+#define DEBUG_TYPE "llpc-spirv-lower-bounds-check"
+
+using namespace llvm;
+using namespace SPIRV;
+using namespace Llpc;
+
+namespace Llpc {
+
+// =====================================================================================================================
+// Legacy pass manager wrapper class
+class LegacySpirvLowerBoundsCheck : public ModulePass {
+public:
+  LegacySpirvLowerBoundsCheck() : ModulePass(ID) {}
+
+  void getAnalysisUsage(AnalysisUsage &analysisUsage) const override {
+    analysisUsage.addRequired<LazyValueInfoWrapperPass>();
+    analysisUsage.addRequired<ScalarEvolutionWrapperPass>();
+    analysisUsage.addRequired<DominatorTreeWrapperPass>();
+    analysisUsage.addRequired<LoopInfoWrapperPass>();
+  }
+
+  virtual bool runOnModule(Module &module) override;
+
+  static char ID; // ID of this pass
+
+  LegacySpirvLowerBoundsCheck(const LegacySpirvLowerBoundsCheck &) = delete;
+  LegacySpirvLowerBoundsCheck &operator=(const LegacySpirvLowerBoundsCheck &) = delete;
+
+private:
+  SpirvLowerBoundsCheck Impl;
+};
+
+// =====================================================================================================================
+// Initializes static members.
+char LegacySpirvLowerBoundsCheck::ID = 0;
+
+// Loops with more instructions than this are not versioned to hoist their bounds checks, to limit the code growth
+static const unsigned MaxVersionedLoopInstCount = 256;
+
+// =====================================================================================================================
+// Pass creator, creates the pass of SPIR-V lowering bounds checks
+ModulePass *createLegacySpirvLowerBoundsCheck() {
+  return new LegacySpirvLowerBoundsCheck();
+}
+
+// =====================================================================================================================
+// Executes this SPIR-V lowering pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+bool LegacySpirvLowerBoundsCheck::runOnModule(Module &module) {
+  return Impl.runImpl(module, [&](Function &func) {
+    return SpirvLowerBoundsCheck::FunctionAnalyses{&getAnalysis<LazyValueInfoWrapperPass>(func).getLVI(),
+                                                   &getAnalysis<ScalarEvolutionWrapperPass>(func).getSE(),
+                                                   &getAnalysis<DominatorTreeWrapperPass>(func).getDomTree(),
+                                                   &getAnalysis<LoopInfoWrapperPass>(func).getLoopInfo()};
+  });
+}
+
+// =====================================================================================================================
+// Executes this SPIR-V lowering pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @param [in/out] analysisManager : Analysis manager to use for this transformation
+PreservedAnalyses SpirvLowerBoundsCheck::run(Module &module, ModuleAnalysisManager &analysisManager) {
+  FunctionAnalysisManager &functionAnalysisManager =
+      analysisManager.getResult<FunctionAnalysisManagerModuleProxy>(module).getManager();
+  bool changed = runImpl(module, [&](Function &func) {
+    return FunctionAnalyses{&functionAnalysisManager.getResult<LazyValueAnalysis>(func),
+                            &functionAnalysisManager.getResult<ScalarEvolutionAnalysis>(func),
+                            &functionAnalysisManager.getResult<DominatorTreeAnalysis>(func),
+                            &functionAnalysisManager.getResult<LoopAnalysis>(func)};
+  });
+  return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+
+// =====================================================================================================================
+// Checks whether range analysis shows that a bounds check always passes.
+//
+// @param check : The bounds check, comparing an index with the constant bound
+// @param lazyValueInfo : Lazy value info of the function
+// @param scalarEvolution : Scalar evolution of the function
+static bool isAlwaysInBounds(ICmpInst *check, LazyValueInfo &lazyValueInfo, ScalarEvolution &scalarEvolution) {
+  Value *index = check->getOperand(0);
+  auto bound = dyn_cast<Constant>(check->getOperand(1));
+  if (!bound)
+    return false;
+
+  // The value ranges, including those that dominating branches imply, cover constant offsets and indices that are
+  // masked or clamped.
+  if (lazyValueInfo.getPredicateAt(check->getPredicate(), index, bound, check, /*UseBlockValue=*/true) ==
+      LazyValueInfo::True)
+    return true;
+
+  // Scalar evolution covers loop induction variables, with the loop guards that bound them.
+  if (!scalarEvolution.isSCEVable(index->getType()))
+    return false;
+  return scalarEvolution.isKnownPredicateAt(check->getPredicate(), scalarEvolution.getSCEV(index),
+                                            scalarEvolution.getSCEV(bound), check);
+}
+
+// =====================================================================================================================
+// Executes this SPIR-V lowering pass on the specified LLVM module.
+//
+// @param [in/out] module : LLVM module to be run on
+// @param getFunctionAnalyses : Function to get the analyses of a function
+bool SpirvLowerBoundsCheck::runImpl(Module &module, GetFunctionAnalyses getFunctionAnalyses) {
+  LLVM_DEBUG(dbgs() << "Run the pass Spirv-Lower-Bounds-Check\n");
+
+  SpirvLower::init(&module);
+
+  unsigned checkCount = 0;
+  unsigned removedCount = 0;
+  unsigned hoistedCount = 0;
+  for (Function &func : module) {
+    SmallVector<ICmpInst *, 8> checks;
+    for (Instruction &inst : instructions(func)) {
+      if (inst.getMetadata(gSPIRVMD::BoundsCheck))
+        checks.push_back(cast<ICmpInst>(&inst));
+    }
+    if (checks.empty())
+      continue;
+    checkCount += checks.size();
+
+    // Find all the checks that can be removed before removing any, so that the analyses stay valid meanwhile.
+    FunctionAnalyses analyses = getFunctionAnalyses(func);
+    SmallVector<ICmpInst *, 8> removableChecks;
+    MapVector<Loop *, SmallVector<ICmpInst *, 4>> loopChecks;
+    for (ICmpInst *check : checks) {
+      check->setMetadata(gSPIRVMD::BoundsCheck, nullptr);
+      if (isAlwaysInBounds(check, *analyses.lazyValueInfo, *analyses.scalarEvolution))
+        removableChecks.push_back(check);
+      else if (Loop *loop = analyses.loopInfo->getLoopFor(check->getParent()))
+        loopChecks[loop].push_back(check);
+    }
+
+    // The branch or select on the check is left to be folded by later CFG simplification.
+    for (ICmpInst *check : removableChecks) {
+      LLVM_DEBUG(dbgs() << "remove: " << *check << "\n");
+      check->replaceAllUsesWith(ConstantInt::getTrue(check->getType()));
+      check->eraseFromParent();
+    }
+    removedCount += removableChecks.size();
+
+    for (auto &loopAndChecks : loopChecks) {
+      if (loopAndChecks.first->isInnermost())
+        hoistedCount += hoistLoopChecks(loopAndChecks.first, loopAndChecks.second, analyses);
+    }
+  }
+
+  if (checkCount != 0) {
+    LLPC_OUTS("===============================================================================\n");
+    LLPC_OUTS("// LLPC bounds check elision results (" << getShaderStageName(m_shaderStage) << " shader)\n\n");
+    LLPC_OUTS("Bounds checks: " << checkCount << ", removed: " << removedCount << ", hoisted: " << hoistedCount
+                                << "\n\n");
+  }
+  return checkCount != 0;
+}
+
+// =====================================================================================================================
+// Hoists the bounds checks on induction variables of an innermost loop out of it. The loop is versioned: a check in
+// the preheader that the whole range of each induction variable is in bounds picks between the original loop, with
+// those checks removed, and a copy of it that keeps them.
+//
+// Returns the number of checks that were hoisted.
+//
+// @param loop : The innermost loop
+// @param checks : The bounds checks in the loop that could not be removed
+// @param analyses : The analyses of the function, which are kept up to date
+unsigned SpirvLowerBoundsCheck::hoistLoopChecks(Loop *loop, ArrayRef<ICmpInst *> checks,
+                                                const FunctionAnalyses &analyses) {
+  ScalarEvolution &scalarEvolution = *analyses.scalarEvolution;
+  BasicBlock *exitingBlock = loop->getExitingBlock();
+  BasicBlock *exitBlock = loop->getExitBlock();
+  if (!loop->isLoopSimplifyForm() || !exitingBlock || !exitBlock || !exitBlock->getSinglePredecessor())
+    return 0;
+  unsigned instCount = 0;
+  for (BasicBlock *block : loop->blocks())
+    instCount += block->size();
+  if (instCount > MaxVersionedLoopInstCount)
+    return 0;
+  const SCEV *maxBackedgeTakenCount = scalarEvolution.getSymbolicMaxBackedgeTakenCount(loop);
+  if (isa<SCEVCouldNotCompute>(maxBackedgeTakenCount) ||
+      maxBackedgeTakenCount->getType()->getPrimitiveSizeInBits() > 32)
+    return 0;
+
+  // A check is hoisted if its index is an affine induction variable of the loop that does not wrap. The index then
+  // goes monotonically from its start value to its value in the last iteration that the check can be in, so it is in
+  // bounds in all iterations if both of those are. They are worked out in 64 bits, which the index cannot overflow.
+  BasicBlock *preheader = loop->getLoopPreheader();
+  Instruction *insertPos = preheader->getTerminator();
+  Type *int64Ty = Type::getInt64Ty(*m_context);
+  const SCEV *maxIteration = scalarEvolution.getZeroExtendExpr(maxBackedgeTakenCount, int64Ty);
+  SmallVector<std::pair<ICmpInst *, std::pair<const SCEV *, const SCEV *>>, 4> hoistableChecks;
+  for (ICmpInst *check : checks) {
+    auto bound = dyn_cast<ConstantInt>(check->getOperand(1));
+    Type *indexTy = check->getOperand(0)->getType();
+    if (check->getPredicate() != ICmpInst::ICMP_ULT || !bound || !indexTy->isIntegerTy() ||
+        indexTy->getPrimitiveSizeInBits() > 32)
+      continue;
+    auto index = dyn_cast<SCEVAddRecExpr>(scalarEvolution.getSCEV(check->getOperand(0)));
+    if (!index || index->getLoop() != loop || !index->isAffine() || !isa<SCEVConstant>(index->getOperand(1)))
+      continue;
+    const SCEV *start = nullptr;
+    const SCEV *step = nullptr;
+    if (index->hasNoUnsignedWrap()) {
+      start = scalarEvolution.getZeroExtendExpr(index->getStart(), int64Ty);
+      step = scalarEvolution.getZeroExtendExpr(index->getOperand(1), int64Ty);
+    } else if (index->hasNoSignedWrap()) {
+      start = scalarEvolution.getSignExtendExpr(index->getStart(), int64Ty);
+      step = scalarEvolution.getSignExtendExpr(index->getOperand(1), int64Ty);
+    } else {
+      continue;
+    }
+    const SCEV *last = scalarEvolution.getAddExpr(start, scalarEvolution.getMulExpr(step, maxIteration));
+    if (!isSafeToExpandAt(start, insertPos, scalarEvolution) || !isSafeToExpandAt(last, insertPos, scalarEvolution))
+      continue;
+    hoistableChecks.push_back({check, {start, last}});
+  }
+  if (hoistableChecks.empty())
+    return 0;
+
+  // Put the values used outside the loop through phis in the exit block, which get the values from the copy of the
+  // loop as well.
+  formLCSSA(*loop, *analyses.dominatorTree, analyses.loopInfo, &scalarEvolution);
+
+  // Make the check of the whole loop in the preheader.
+  SCEVExpander expander(scalarEvolution, m_module->getDataLayout(), "boundscheck");
+  IRBuilder<> builder(insertPos);
+  Value *loopInBounds = nullptr;
+  for (auto &hoistableCheck : hoistableChecks) {
+    Constant *bound = ConstantInt::get(int64Ty, cast<ConstantInt>(hoistableCheck.first->getOperand(1))->getZExtValue());
+    Value *start = expander.expandCodeFor(hoistableCheck.second.first, int64Ty, insertPos);
+    Value *last = expander.expandCodeFor(hoistableCheck.second.second, int64Ty, insertPos);
+    Value *inBounds = builder.CreateAnd(builder.CreateICmpULT(start, bound), builder.CreateICmpULT(last, bound));
+    loopInBounds = loopInBounds ? builder.CreateAnd(loopInBounds, inBounds) : inBounds;
+  }
+
+  // Copy the loop, placing the copy between its new preheader and the preheader, which becomes the block that picks
+  // one of them.
+  BasicBlock *loopPreheader = SplitBlock(preheader, preheader->getTerminator(), analyses.dominatorTree,
+                                         analyses.loopInfo, nullptr, loop->getHeader()->getName() + ".ph");
+  ValueToValueMapTy valueMap;
+  SmallVector<BasicBlock *, 8> copiedBlocks;
+  Loop *copiedLoop = cloneLoopWithPreheader(loopPreheader, preheader, loop, valueMap, ".boundscheck",
+                                            analyses.loopInfo, analyses.dominatorTree, copiedBlocks);
+  remapInstructionsInBlocks(copiedBlocks, valueMap);
+  Instruction *oldTerminator = preheader->getTerminator();
+  BranchInst::Create(loopPreheader, copiedLoop->getLoopPreheader(), loopInBounds, oldTerminator);
+  oldTerminator->eraseFromParent();
+  analyses.dominatorTree->changeImmediateDominator(exitBlock, preheader);
+
+  // The exit block is now reached from both loops.
+  BasicBlock *copiedExitingBlock = cast<BasicBlock>(valueMap[exitingBlock]);
+  for (PHINode &phi : exitBlock->phis()) {
+    Value *value = phi.getIncomingValueForBlock(exitingBlock);
+    auto it = valueMap.find(value);
+    phi.addIncoming(it != valueMap.end() ? static_cast<Value *>(it->second) : value, copiedExitingBlock);
+  }
+
+  // Remove the hoisted checks from the original loop. The copy keeps them.
+  for (auto &hoistableCheck : hoistableChecks) {
+    ICmpInst *check = hoistableCheck.first;
+    LLVM_DEBUG(dbgs() << "hoist: " << *check << "\n");
+    check->replaceAllUsesWith(ConstantInt::getTrue(check->getType()));
+    check->eraseFromParent();
+  }
+  scalarEvolution.forgetLoop(loop);
+  return hoistableChecks.size();
+}
+
+} // namespace Llpc
+
+// =====================================================================================================================
+// Initializes the pass of SPIR-V lowering bounds checks.
+INITIALIZE_PASS_BEGIN(LegacySpirvLowerBoundsCheck, DEBUG_TYPE, "Lower SPIR-V bounds checks", false, false)
+INITIALIZE_PASS_DEPENDENCY(LazyValueInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(LegacySpirvLowerBoundsCheck, DEBUG_TYPE, "Lower SPIR-V bounds checks", false, false)
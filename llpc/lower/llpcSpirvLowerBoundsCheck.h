@@ -0,0 +1,74 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcSpirvLowerBoundsCheck.h
+ * @brief LLPC header file: contains declaration of Llpc::SpirvLowerBoundsCheck
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llpcSpirvLower.h"
+#include "llvm/IR/PassManager.h"
+#include <functional>
+
+namespace llvm {
+class DominatorTree;
+class ICmpInst;
+class LazyValueInfo;
+class Loop;
+class LoopInfo;
+class ScalarEvolution;
+} // namespace llvm
+
+namespace Llpc {
+
+// =====================================================================================================================
+// Represents the pass of SPIR-V lowering bounds checks: it removes the bounds checks of private array accesses, marked
+// with the spirv.BoundsCheck metadata, that range analysis shows always pass. The checks on a loop induction variable
+// that remain are hoisted out of their loop, by versioning the loop: one check before the loop picks a copy of the
+// loop without the checks when the whole range of the induction variable is in bounds.
+class SpirvLowerBoundsCheck : public SpirvLower, public llvm::PassInfoMixin<SpirvLowerBoundsCheck> {
+public:
+  // The analyses of a function that the pass uses
+  struct FunctionAnalyses {
+    llvm::LazyValueInfo *lazyValueInfo;
+    llvm::ScalarEvolution *scalarEvolution;
+    llvm::DominatorTree *dominatorTree;
+    llvm::LoopInfo *loopInfo;
+  };
+  using GetFunctionAnalyses = std::function<FunctionAnalyses(llvm::Function &)>;
+
+  llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
+  bool runImpl(llvm::Module &module, GetFunctionAnalyses getFunctionAnalyses);
+
+  static llvm::StringRef name() { return "Lower SPIR-V bounds checks"; }
+
+private:
+  unsigned hoistLoopChecks(llvm::Loop *loop, llvm::ArrayRef<llvm::ICmpInst *> checks,
+                           const FunctionAnalyses &analyses);
+};
+
+} // namespace Llpc
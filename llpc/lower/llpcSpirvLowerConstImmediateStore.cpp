@@ -107,16 +107,25 @@ void SpirvLowerConstImmediateStore::processAllocaInsts(Function *func) {
   auto entryBlock = &func->front();
   for (auto instIt = entryBlock->begin(), instItEnd = entryBlock->end(); instIt != instItEnd; ++instIt) {
     auto inst = &*instIt;
-    if (auto allocaInst = dyn_cast<AllocaInst>(inst)) {
-      if (allocaInst->getType()->getElementType()->isAggregateType()) {
-        // Got an "alloca" instruction of aggregate type.
-        auto storeInst = findSingleStore(allocaInst);
-        if (storeInst && isa<Constant>(storeInst->getValueOperand())) {
-          // Got an aggregate "alloca" with a single store to the whole type.
-          // Do the optimization.
-          convertAllocaToReadOnlyGlobal(storeInst);
-        }
-      }
+    if (auto allocaInst = dyn_cast<AllocaInst>(inst))
+      processAllocaInst(allocaInst);
+  }
+}
+
+// =====================================================================================================================
+// Processes an "alloca" instruction to see if it can be optimized to a read-only global variable.
+//
+// NOTE: This is also used by SpirvLowerMemoryOp, when it does this lowering as part of its own traversal of the module.
+//
+// @param allocaInst : The "alloca" instruction to process
+void SpirvLowerConstImmediateStore::processAllocaInst(AllocaInst *allocaInst) {
+  if (allocaInst->getType()->getElementType()->isAggregateType()) {
+    // Got an "alloca" instruction of aggregate type.
+    auto storeInst = findSingleStore(allocaInst);
+    if (storeInst && isa<Constant>(storeInst->getValueOperand())) {
+      // Got an aggregate "alloca" with a single store to the whole type.
+      // Do the optimization.
+      convertAllocaToReadOnlyGlobal(storeInst);
     }
   }
 }
@@ -176,7 +185,7 @@ StoreInst *SpirvLowerConstImmediateStore::findSingleStore(AllocaInst *allocaInst
 void SpirvLowerConstImmediateStore::convertAllocaToReadOnlyGlobal(StoreInst *storeInst) {
   auto allocaInst = cast<AllocaInst>(storeInst->getPointerOperand());
   auto globalType = allocaInst->getType()->getElementType();
-  auto global = new GlobalVariable(*m_module, globalType,
+  auto global = new GlobalVariable(*allocaInst->getModule(), globalType,
                                    true, // isConstant
                                    GlobalValue::InternalLinkage, cast<Constant>(storeInst->getValueOperand()), "",
                                    nullptr, GlobalValue::NotThreadLocal, SPIRAS_Constant);
@@ -49,10 +49,12 @@ public:
 
   static llvm::StringRef name() { return "Lower SPIR-V constant immediate store"; }
 
+  static void processAllocaInst(llvm::AllocaInst *allocaInst);
+
 private:
   void processAllocaInsts(llvm::Function *func);
-  llvm::StoreInst *findSingleStore(llvm::AllocaInst *allocaInst);
-  void convertAllocaToReadOnlyGlobal(llvm::StoreInst *storeInst);
+  static llvm::StoreInst *findSingleStore(llvm::AllocaInst *allocaInst);
+  static void convertAllocaToReadOnlyGlobal(llvm::StoreInst *storeInst);
 };
 
 // =====================================================================================================================
@@ -37,7 +37,9 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
@@ -49,6 +51,21 @@ using namespace llvm;
 using namespace SPIRV;
 using namespace Llpc;
 
+// -lower-extracted-inout-members: lower aggregate loads of tessellation inputs/outputs member by member
+static cl::opt<bool> LowerExtractedInOutMembers(
+    "lower-extracted-inout-members",
+    cl::desc("Lower an aggregate load of a tessellation input/output whose users only extract scalar or vector "
+             "members by importing just those members"),
+    cl::init(false));
+
+// -lower-dynamic-indexed-gs-input: lower geometry shader inputs in place if they are accessed through dynamic vertex
+// indices
+static cl::opt<bool> LowerDynamicIndexedGsInput(
+    "lower-dynamic-indexed-gs-input",
+    cl::desc("Lower the inputs of a geometry shader with an import for each load, rather than proxy variables, if they "
+             "are accessed through dynamic vertex indices and that is cheaper"),
+    cl::init(true));
+
 namespace Llpc {
 
 // The code here relies on the SPIR-V built-in kind being the same as the Builder built-in kind.
@@ -211,6 +228,22 @@ bool SpirvLowerGlobal::runImpl(Module &module) {
 
   SpirvLower::init(&module);
 
+  // Clear state left by a previous run, as the pass can be reused from a cached pass manager.
+  m_globalVarProxyMap.clear();
+  m_inputProxyMap.clear();
+  m_outputProxyMap.clear();
+  m_retBlock = nullptr;
+  m_lowerInputInPlace = false;
+  m_lowerOutputInPlace = false;
+  m_retInsts.clear();
+  m_emitCalls.clear();
+  m_loadInsts.clear();
+  m_storeInsts.clear();
+  m_interpCalls.clear();
+
+  // NOTE: For geometry shader, inputs accessed through dynamic vertex indices may be lowered in-place as well.
+  m_lowerInputInPlace = shouldLowerGsInputInPlace();
+
   // Map globals to proxy variables
   for (auto global = m_module->global_begin(), end = m_module->global_end(); global != end; ++global) {
     if (global->getType()->getAddressSpace() == SPIRAS_Private)
@@ -383,6 +416,9 @@ void SpirvLowerGlobal::handleLoadInstGlobal(LoadInst &loadInst, const unsigned a
   auto inOut = cast<GlobalVariable>(loadSrc);
   auto inOutTy = inOut->getType()->getContainedType(0);
 
+  if (handleLoadInstExtractedMembers(inOut, {}, loadInst, addrSpace))
+    return;
+
   MDNode *metaNode = inOut->getMetadata(gSPIRVMD::InOut);
   assert(metaNode);
   auto inOutMetaVal = mdconst::dyn_extract<Constant>(metaNode->getOperand(0));
@@ -428,6 +464,62 @@ void SpirvLowerGlobal::handleLoadInstGEP(GetElementPtrInst *const getElemPtr, Lo
   for (auto i = getElemPtr->idx_begin() + 1, e = getElemPtr->idx_end(); i != e; ++i)
     indexOperands.push_back(toInt32Value(*i, &loadInst));
 
+  if (handleLoadInstExtractedMembers(inOut, indexOperands, loadInst, addrSpace))
+    return;
+
+  Value *loadValue = loadIndexedInOut(inOut, indexOperands, addrSpace, &loadInst);
+  m_loadInsts.insert(&loadInst);
+  loadInst.replaceAllUsesWith(loadValue);
+}
+
+// =====================================================================================================================
+// Try to handle a single "load" instruction of a whole aggregate input/output (or aggregate member of it) by importing
+// only the members that its users extract, rather than expanding the whole aggregate. That is possible when all the
+// users are "extractvalue" instructions of scalar or vector members, which is common for the large per-vertex arrays of
+// tessellation shaders.
+//
+// @param inOut : Input/output global variable
+// @param indexOperands : Indices (as i32) of the loaded member, excluding the leading zero index of the GEP
+// @param loadInst : Load instruction
+// @param addrSpace : Address space
+// @returns : True if the load was handled
+bool SpirvLowerGlobal::handleLoadInstExtractedMembers(GlobalVariable *inOut, ArrayRef<Value *> indexOperands,
+                                                      LoadInst &loadInst, const unsigned addrSpace) {
+  if (!LowerExtractedInOutMembers || loadInst.use_empty())
+    return false;
+
+  SmallVector<ExtractValueInst *, 8> extracts;
+  for (User *user : loadInst.users()) {
+    auto extract = dyn_cast<ExtractValueInst>(user);
+    if (!extract || extract->getType()->isAggregateType())
+      return false;
+    extracts.push_back(extract);
+  }
+
+  Type *int32Ty = Type::getInt32Ty(*m_context);
+  for (ExtractValueInst *extract : extracts) {
+    std::vector<Value *> memberIndexOperands(indexOperands.begin(), indexOperands.end());
+    for (unsigned index : extract->getIndices())
+      memberIndexOperands.push_back(ConstantInt::get(int32Ty, index));
+
+    Value *memberValue = loadIndexedInOut(inOut, memberIndexOperands, addrSpace, &loadInst);
+    extract->replaceAllUsesWith(memberValue);
+    extract->eraseFromParent();
+  }
+  m_loadInsts.insert(&loadInst);
+  return true;
+}
+
+// =====================================================================================================================
+// Import the member of an input/output that the given indices select.
+//
+// @param inOut : Input/output global variable
+// @param indexOperands : Indices (as i32) of the member, excluding the leading zero index of the GEP
+// @param addrSpace : Address space
+// @param insertPos : Where to insert the import calls
+// @returns : The imported value of the member
+Value *SpirvLowerGlobal::loadIndexedInOut(GlobalVariable *inOut, const std::vector<Value *> &indexOperands,
+                                          const unsigned addrSpace, Instruction *insertPos) {
   unsigned operandIdx = 0;
   Value *vertexIdx = nullptr;
   auto inOutTy = inOut->getType()->getContainedType(0);
@@ -444,10 +536,8 @@ void SpirvLowerGlobal::handleLoadInstGEP(GetElementPtrInst *const getElemPtr, Lo
     inOutMetaVal = cast<Constant>(inOutMetaVal->getOperand(1));
   }
 
-  Value *loadValue = loadInOutMember(inOutTy, addrSpace, indexOperands, operandIdx, 0, inOutMetaVal, nullptr, vertexIdx,
-                                     InterpLocUnknown, nullptr, &loadInst);
-  m_loadInsts.insert(&loadInst);
-  loadInst.replaceAllUsesWith(loadValue);
+  return loadInOutMember(inOutTy, addrSpace, indexOperands, operandIdx, 0, inOutMetaVal, nullptr, vertexIdx,
+                         InterpLocUnknown, nullptr, insertPos);
 }
 
 // =====================================================================================================================
@@ -460,7 +550,8 @@ void SpirvLowerGlobal::handleLoadInst() {
     const bool isTcsInput = (m_shaderStage == ShaderStageTessControl && addrSpace == SPIRAS_Input);
     const bool isTcsOutput = (m_shaderStage == ShaderStageTessControl && addrSpace == SPIRAS_Output);
     const bool isTesInput = (m_shaderStage == ShaderStageTessEval && addrSpace == SPIRAS_Input);
-    return isTcsInput || isTcsOutput || isTesInput;
+    const bool isGsInput = (m_shaderStage == ShaderStageGeometry && addrSpace == SPIRAS_Input);
+    return isTcsInput || isTcsOutput || isTesInput || isGsInput;
   };
 
   for (GlobalVariable &global : m_module->globals()) {
@@ -612,7 +703,7 @@ void SpirvLowerGlobal::mapGlobalVariableToProxy(GlobalVariable *globalVar) {
 void SpirvLowerGlobal::mapInputToProxy(GlobalVariable *input) {
   // NOTE: For tessellation shader, we do not map inputs to real proxy variables. Instead, we directly replace
   // "load" instructions with import calls in the lowering operation.
-  if (m_shaderStage == ShaderStageTessControl || m_shaderStage == ShaderStageTessEval) {
+  if (m_shaderStage == ShaderStageTessControl || m_shaderStage == ShaderStageTessEval || m_lowerInputInPlace) {
     m_inputProxyMap[input] = nullptr;
     m_lowerInputInPlace = true;
     return;
@@ -639,6 +730,76 @@ void SpirvLowerGlobal::mapInputToProxy(GlobalVariable *input) {
   m_inputProxyMap[input] = proxy;
 }
 
+// =====================================================================================================================
+// Decides whether the inputs of geometry shader are lowered in-place, with import calls for each "load" instruction,
+// rather than imported to proxy variables at the start of the shader. A load through a dynamic vertex index from a
+// proxy variable is expanded to a select across all the vertices (or spilled to scratch) for each dword of the loaded
+// value, while in-place lowering turns it into ES-GS ring reads at an offset indexed by the vertex index. The choice is
+// made by comparing the costs of the two, counted over the array sizes and the accesses of the inputs.
+//
+// @returns : True if the inputs are to be lowered in-place
+bool SpirvLowerGlobal::shouldLowerGsInputInPlace() {
+  if (m_shaderStage != ShaderStageGeometry || !LowerDynamicIndexedGsInput)
+    return false;
+
+  // Relative cost of an ES-GS ring read against a select
+  static const unsigned RingReadCost = 4;
+
+  const auto &dataLayout = m_module->getDataLayout();
+  auto getDwordCount = [&](Type *ty) { return std::max(1U, unsigned(dataLayout.getTypeAllocSize(ty) + 3) / 4); };
+
+  unsigned proxyCost = 0;
+  unsigned inPlaceCost = 0;
+  bool hasDynamicVertexIdx = false;
+  for (GlobalVariable &global : m_module->globals()) {
+    if (global.getType()->getAddressSpace() != SPIRAS_Input)
+      continue;
+
+    Type *inputTy = global.getValueType();
+    MDNode *metaNode = global.getMetadata(gSPIRVMD::InOut);
+    assert(metaNode);
+    auto inputMeta = mdconst::dyn_extract<Constant>(metaNode->getOperand(0));
+    const bool isVertexIndexed = inputTy->isArrayTy() && hasVertexIdx(*inputMeta);
+
+    // The proxy variable is imported as a whole
+    proxyCost += RingReadCost * getDwordCount(inputTy);
+
+    for (User *user : global.users()) {
+      if (auto loadInst = dyn_cast<LoadInst>(user)) {
+        inPlaceCost += RingReadCost * getDwordCount(loadInst->getType());
+        continue;
+      }
+
+      // In-place lowering of geometry shader inputs only supports a dynamic index for vertex indexing, and loads of
+      // scalar or vector members.
+      auto getElemPtr = dyn_cast<GEPOperator>(user);
+      if (!getElemPtr || getElemPtr->getNumIndices() < 2)
+        return false;
+      bool isDynamicVertexIdx = false;
+      for (unsigned idx = 0; idx != getElemPtr->getNumIndices(); ++idx) {
+        if (isa<ConstantInt>(getElemPtr->getOperand(idx + 1)))
+          continue;
+        if (idx != 1 || !isVertexIndexed)
+          return false;
+        isDynamicVertexIdx = true;
+      }
+
+      for (User *gepUser : getElemPtr->users()) {
+        auto loadInst = dyn_cast<LoadInst>(gepUser);
+        if (!loadInst || loadInst->getType()->isAggregateType())
+          return false;
+        const unsigned dwordCount = getDwordCount(loadInst->getType());
+        inPlaceCost += RingReadCost * dwordCount;
+        if (isDynamicVertexIdx)
+          proxyCost += dwordCount * inputTy->getArrayNumElements();
+      }
+      hasDynamicVertexIdx |= isDynamicVertexIdx;
+    }
+  }
+
+  return hasDynamicVertexIdx && inPlaceCost < proxyCost;
+}
+
 // =====================================================================================================================
 // Maps the specified output to proxy variable.
 //
@@ -854,7 +1015,8 @@ void SpirvLowerGlobal::lowerOutput() {
 // Does inplace lowering operations for SPIR-V inputs/outputs, replaces "load" instructions with import calls and
 // "store" instructions with export calls.
 void SpirvLowerGlobal::lowerInOutInPlace() {
-  assert(m_shaderStage == ShaderStageTessControl || m_shaderStage == ShaderStageTessEval);
+  assert(m_shaderStage == ShaderStageTessControl || m_shaderStage == ShaderStageTessEval ||
+         m_shaderStage == ShaderStageGeometry);
 
   // Invoke handling of "load" and "store" instruction
   handleLoadInst();
@@ -1481,7 +1643,7 @@ Value *SpirvLowerGlobal::loadInOutMember(Type *inOutTy, unsigned addrSpace, cons
                                          Value *locOffset, Value *vertexIdx, unsigned interpLoc, Value *auxInterpValue,
                                          Instruction *insertPos) {
   assert(m_shaderStage == ShaderStageTessControl || m_shaderStage == ShaderStageTessEval ||
-         m_shaderStage == ShaderStageFragment);
+         m_shaderStage == ShaderStageGeometry || m_shaderStage == ShaderStageFragment);
 
   if (inOutTy->isArrayTy()) {
     // Array type
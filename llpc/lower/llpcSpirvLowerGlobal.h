@@ -54,6 +54,10 @@ public:
   void handleLoadInst();
   void handleLoadInstGlobal(LoadInst &loadInst, const unsigned addrSpace);
   void handleLoadInstGEP(GetElementPtrInst *const getElemPtr, LoadInst &loadInst, const unsigned addrSpace);
+  bool handleLoadInstExtractedMembers(llvm::GlobalVariable *inOut, llvm::ArrayRef<llvm::Value *> indexOperands,
+                                      LoadInst &loadInst, const unsigned addrSpace);
+  llvm::Value *loadIndexedInOut(llvm::GlobalVariable *inOut, const std::vector<llvm::Value *> &indexOperands,
+                                const unsigned addrSpace, llvm::Instruction *insertPos);
 
   void handleStoreInst();
   void handleStoreInstGlobal(StoreInst &storeInst);
@@ -64,6 +68,7 @@ public:
 private:
   void mapGlobalVariableToProxy(llvm::GlobalVariable *globalVar);
   void mapInputToProxy(llvm::GlobalVariable *input);
+  bool shouldLowerGsInputInPlace();
   void mapOutputToProxy(llvm::GlobalVariable *input);
 
   void lowerGlobalVar();
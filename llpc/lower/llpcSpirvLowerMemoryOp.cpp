@@ -31,6 +31,7 @@
 #include "llpcSpirvLowerMemoryOp.h"
 #include "SPIRVInternal.h"
 #include "llpcContext.h"
+#include "llpcSpirvLowerConstImmediateStore.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/Debug.h"
@@ -50,12 +51,17 @@ char LegacySpirvLowerMemoryOp::ID = 0;
 
 // =====================================================================================================================
 // Pass creator, creates the pass of SPIR-V lowering memory operations.
-ModulePass *createLegacySpirvLowerMemoryOp() {
-  return new LegacySpirvLowerMemoryOp();
+//
+// @param lowerConstImmediateStore : Whether to also do the lowering of SpirvLowerConstImmediateStore
+ModulePass *createLegacySpirvLowerMemoryOp(bool lowerConstImmediateStore) {
+  return new LegacySpirvLowerMemoryOp(lowerConstImmediateStore);
 }
 
 // =====================================================================================================================
-LegacySpirvLowerMemoryOp::LegacySpirvLowerMemoryOp() : ModulePass(ID) {
+//
+// @param lowerConstImmediateStore : Whether to also do the lowering of SpirvLowerConstImmediateStore
+LegacySpirvLowerMemoryOp::LegacySpirvLowerMemoryOp(bool lowerConstImmediateStore)
+    : ModulePass(ID), Impl(lowerConstImmediateStore) {
 }
 
 // =====================================================================================================================
@@ -113,6 +119,18 @@ bool LegacySpirvLowerMemoryOp::runOnModule(Module &module) {
   return Impl.runImpl(module);
 }
 
+// =====================================================================================================================
+// Visits "alloca" instruction.
+//
+// @param allocaInst : "Alloca" instruction
+void SpirvLowerMemoryOp::visitAllocaInst(AllocaInst &allocaInst) {
+  // NOTE: When this pass also does the lowering of SpirvLowerConstImmediateStore, an "alloca" in the entry block is
+  // converted when it is visited. The SPIR-V translator puts all "alloca" instructions at the start of the entry block,
+  // so this is done before any of their users are visited, just like running that pass first.
+  if (m_lowerConstImmediateStore && allocaInst.getParent() == &allocaInst.getFunction()->front())
+    SpirvLowerConstImmediateStore::processAllocaInst(&allocaInst);
+}
+
 // =====================================================================================================================
 // Visits "extractelement" instruction.
 //
@@ -385,6 +403,7 @@ void SpirvLowerMemoryOp::expandStoreInst(StoreInst *storeInst, ArrayRef<GetEleme
                                        : ConstantInt::get(Type::getInt32Ty(*m_context), getElemPtrCount);
 
     auto doStore = new ICmpInst(checkStoreInsertPos, ICmpInst::ICMP_ULT, dynIndex, getElemPtrCountVal);
+    doStore->setMetadata(gSPIRVMD::BoundsCheck, MDNode::get(*m_context, {}));
     BranchInst::Create(storeBlock, endStoreBlock, doStore, checkStoreInsertPos);
 
     for (unsigned i = 1; i < getElemPtrCount; ++i) {
@@ -56,11 +56,15 @@ class SpirvLowerMemoryOp : public SpirvLower,
                            public llvm::InstVisitor<SpirvLowerMemoryOp>,
                            public llvm::PassInfoMixin<SpirvLowerMemoryOp> {
 public:
+  explicit SpirvLowerMemoryOp(bool lowerConstImmediateStore = false)
+      : m_lowerConstImmediateStore(lowerConstImmediateStore) {}
+
   llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
   bool runImpl(llvm::Module &module);
 
   static llvm::StringRef name() { return "Lower SPIR-V memory operations"; }
 
+  virtual void visitAllocaInst(llvm::AllocaInst &allocaInst);
   virtual void visitGetElementPtrInst(llvm::GetElementPtrInst &getElementPtrInst);
   virtual void visitExtractElementInst(llvm::ExtractElementInst &extractElementInst);
 
@@ -77,13 +81,14 @@ private:
   std::unordered_set<llvm::Instruction *> m_removeInsts;
   std::unordered_set<llvm::Instruction *> m_preRemoveInsts;
   llvm::SmallVector<StoreExpandInfo, 1> m_storeExpandInfo;
+  bool m_lowerConstImmediateStore; // Whether to also do the lowering of SpirvLowerConstImmediateStore
 };
 
 // =====================================================================================================================
 // Represents the pass of SPIR-V lowering memory operations.
 class LegacySpirvLowerMemoryOp : public llvm::ModulePass, public llvm::InstVisitor<LegacySpirvLowerMemoryOp> {
 public:
-  LegacySpirvLowerMemoryOp();
+  explicit LegacySpirvLowerMemoryOp(bool lowerConstImmediateStore = false);
 
   virtual bool runOnModule(llvm::Module &module);
 
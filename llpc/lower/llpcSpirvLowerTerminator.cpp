@@ -38,6 +38,7 @@
 #include "llpcSpirvLowerUtil.h"
 #include "lgc/Builder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicsAMDGPU.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -123,8 +124,11 @@ void SpirvLowerTerminator::visitCallInst(CallInst &callInst) {
   if (!callee)
     return;
 
+  // The kill is a recorded lgc.create.kill, or the amdgcn.kill that BuilderImpl creates for it directly.
   auto mangledName = callee->getName();
-  if (mangledName != "lgc.create.kill")
+  if (mangledName != "lgc.create.kill" &&
+      !(callee->getIntrinsicID() == Intrinsic::amdgcn_kill && isa<ConstantInt>(callInst.getArgOperand(0)) &&
+        cast<ConstantInt>(callInst.getArgOperand(0))->isZero()))
     return;
 
   // Already marked for removal?
@@ -33,7 +33,6 @@
 #include "llpcCompiler.h"
 #include "llpcContext.h"
 #include "lgc/Builder.h"
-#include <sstream>
 #include <string>
 
 #define DEBUG_TYPE "llpc-spirv-lower-translator"
@@ -48,8 +47,10 @@ char LegacySpirvLowerTranslator::ID = 0;
 //
 // @param stage : Shader stage
 // @param shaderInfo : Shader info for this shader
-ModulePass *Llpc::createSpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo) {
-  return new LegacySpirvLowerTranslator(stage, shaderInfo);
+// @param specConstPlaceholders : Whether to translate the scalar specialization constants as placeholders
+ModulePass *Llpc::createSpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo,
+                                             bool specConstPlaceholders) {
+  return new LegacySpirvLowerTranslator(stage, shaderInfo, specConstPlaceholders);
 }
 
 // =====================================================================================================================
@@ -103,8 +104,7 @@ void SpirvLowerTranslator::translateSpirvToLlvm(const PipelineShaderInfo *shader
   if (ShaderModuleHelper::optimizeSpirv(spirvBin, &optimizedSpirvBin) == Result::Success)
     spirvBin = &optimizedSpirvBin;
 
-  std::string spirvCode(static_cast<const char *>(spirvBin->pCode), spirvBin->codeSize);
-  std::istringstream spirvStream(spirvCode);
+  StringRef spirvCode(static_cast<const char *>(spirvBin->pCode), spirvBin->codeSize);
   std::string errMsg;
   SPIRV::SPIRVSpecConstMap specConstMap;
   ShaderStage entryStage = shaderInfo->entryStage;
@@ -134,9 +134,10 @@ void SpirvLowerTranslator::translateSpirvToLlvm(const PipelineShaderInfo *shader
     }
   }
 
-  if (!readSpirv(context->getBuilder(), &(moduleData->usage), &(shaderInfo->options), spirvStream,
+  context->addTranslatedSpirvSize(spirvBin->codeSize);
+  if (!readSpirv(context->getBuilder(), &(moduleData->usage), &(shaderInfo->options), spirvCode,
                  convertToExecModel(entryStage), shaderInfo->pEntryTarget, specConstMap, convertingSamplers, module,
-                 errMsg)) {
+                 errMsg, m_specConstPlaceholders)) {
     report_fatal_error(Twine("Failed to translate SPIR-V to LLVM (") +
                            getShaderStageName(static_cast<ShaderStage>(entryStage)) + " shader): " + errMsg,
                        false);
@@ -44,7 +44,9 @@ public:
   //
   // @param stage : Shader stage
   // @param shaderInfo : Shader info for this shader
-  SpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo) : m_shaderInfo(shaderInfo) {}
+  // @param specConstPlaceholders : Whether to translate the scalar specialization constants as placeholders
+  SpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo, bool specConstPlaceholders = false)
+      : m_shaderInfo(shaderInfo), m_specConstPlaceholders(specConstPlaceholders) {}
 
   llvm::PreservedAnalyses run(llvm::Module &module, llvm::ModuleAnalysisManager &analysisManager);
   bool runImpl(llvm::Module &module);
@@ -57,6 +59,7 @@ private:
   // -----------------------------------------------------------------------------------------------------------------
 
   const PipelineShaderInfo *m_shaderInfo; // Input shader info
+  bool m_specConstPlaceholders = false;   // Whether to translate scalar specialization constants as placeholders
 };
 
 // =====================================================================================================================
@@ -69,8 +72,10 @@ public:
   //
   // @param stage : Shader stage
   // @param shaderInfo : Shader info for this shader
-  LegacySpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo)
-      : LegacySpirvLower(ID), Impl(stage, shaderInfo) {}
+  // @param specConstPlaceholders : Whether to translate the scalar specialization constants as placeholders
+  LegacySpirvLowerTranslator(ShaderStage stage, const PipelineShaderInfo *shaderInfo,
+                             bool specConstPlaceholders = false)
+      : LegacySpirvLower(ID), Impl(stage, shaderInfo, specConstPlaceholders) {}
 
   bool runOnModule(llvm::Module &module) override;
 
@@ -0,0 +1,30 @@
+// This test checks that centroid inputs read in blocks that do not dominate each other share one adjustment of the
+// centroid I/J by the center I/J, set up at the start of the entry-point.
+
+// BEGIN_SHADERTEST
+/*
+; RUN: amdllpc -spvgen-dir=%spvgendir% -v %gfxip %s | FileCheck -check-prefix=SHADERTEST %s
+; SHADERTEST-LABEL: {{^// LLPC}} pipeline patching results
+; SHADERTEST: icmp slt i32 %PrimMask, 0
+; SHADERTEST-NOT: icmp slt i32 %PrimMask, 0
+; SHADERTEST: call float @llvm.amdgcn.interp.p1
+; SHADERTEST: AMDLLPC SUCCESS
+*/
+// END_SHADERTEST
+
+#version 450
+
+layout(location = 0) centroid in vec4 a;
+layout(location = 1) centroid in vec4 b;
+layout(location = 2) in vec4 c;
+layout(location = 3) flat in int sel;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    if (sel != 0)
+        fragColor = a;
+    else
+        fragColor = b * c;
+}
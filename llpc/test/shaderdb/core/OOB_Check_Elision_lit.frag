@@ -0,0 +1,28 @@
+// This test checks that the bounds check elision reports on the bounds checks of private array accesses, and that it
+// keeps the check of an access whose index comes from a uniform, as that cannot be shown to be in bounds.
+
+// BEGIN_SHADERTEST
+/*
+; RUN: amdllpc -spvgen-dir=%spvgendir% -v %gfxip %s -enable-scratch-bounds-checks | FileCheck -check-prefix=SHADERTEST %s
+; SHADERTEST-LABEL: {{^// LLPC}} bounds check elision results (fragment shader)
+; SHADERTEST: Bounds checks: {{[1-9][0-9]*}}, removed: {{[0-9]+}}
+; SHADERTEST-LABEL: {{^// LLPC}} SPIR-V lowering results
+; SHADERTEST: icmp ult i32 %{{.*}}, 8
+; SHADERTEST-NOT: !spirv.BoundsCheck
+; SHADERTEST: AMDLLPC SUCCESS
+*/
+// END_SHADERTEST
+
+#version 450 core
+
+layout (location = 0) in vec4 inColor;
+layout (location = 0) out vec4 outFragColor;
+layout (binding = 0) uniform Constant { int array_index; } c;
+
+void main() {
+  vec4 data[8];
+  for (int i = 0; i < 8; ++i)
+    data[i] = inColor * float(i);
+
+  outFragColor = data[c.array_index];
+}
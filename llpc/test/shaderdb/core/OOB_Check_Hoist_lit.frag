@@ -0,0 +1,27 @@
+// This test checks that the bounds check of a private array access indexed by the induction variable of a loop with
+// a trip count from a uniform is hoisted out of the loop, by versioning the loop.
+
+// BEGIN_SHADERTEST
+/*
+; RUN: amdllpc -spvgen-dir=%spvgendir% -v %gfxip %s -enable-scratch-bounds-checks | FileCheck -check-prefix=SHADERTEST %s
+; SHADERTEST-LABEL: {{^// LLPC}} bounds check elision results (fragment shader)
+; SHADERTEST: Bounds checks: {{[1-9][0-9]*}}, removed: {{[0-9]+}}, hoisted: {{[1-9][0-9]*}}
+; SHADERTEST-LABEL: {{^// LLPC}} SPIR-V lowering results
+; SHADERTEST: .boundscheck
+; SHADERTEST: AMDLLPC SUCCESS
+*/
+// END_SHADERTEST
+
+#version 450 core
+
+layout (location = 0) in vec4 inColor;
+layout (location = 0) out vec4 outFragColor;
+layout (binding = 0) uniform Constant { int count; int array_index; } c;
+
+void main() {
+  vec4 data[8];
+  for (int i = 0; i < c.count; ++i)
+    data[i] = inColor * float(i);
+
+  outFragColor = data[c.array_index & 7];
+}
@@ -0,0 +1,25 @@
+// Test that a multisampled image fetch does no fmask load when the user data layout has no fmask descriptor for the
+// image.
+
+#version 450 core
+
+layout(set = 0, binding = 0) uniform sampler2DMS samp;
+layout(location = 0) in vec2 inUV;
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    ivec2 iUV = ivec2(inUV);
+    oColor = texelFetch(samp, iUV, 2);
+}
+
+// BEGIN_SHADERTEST
+/*
+; RUN: amdllpc -spvgen-dir=%spvgendir% -v %gfxip %s | FileCheck -check-prefix=SHADERTEST %s
+; SHADERTEST-LABEL: {{^// LLPC}}  pipeline patching results
+; SHADERTEST-NOT: @llvm.amdgcn.image.load.2d.v4i32
+; SHADERTEST: call {{.*}} <4 x float> @llvm.amdgcn.image.load.2dmsaa.v4f32.i32(i32 15, {{.*}}, i32 2, <8 x i32>
+; SHADERTEST-NOT: @llvm.amdgcn.image.load.2d.v4i32
+; SHADERTEST: AMDLLPC SUCCESS
+*/
+// END_SHADERTEST
@@ -0,0 +1,35 @@
+// This test checks that a switch on a specialization constant is translated as a branch to the case it selects.
+
+// BEGIN_SHADERTEST
+/*
+; RUN: amdllpc -spvgen-dir=%spvgendir% -v %gfxip %s | FileCheck -check-prefix=SHADERTEST %s
+; SHADERTEST-LABEL: {{^// LLPC}} SPIRV-to-LLVM translation results
+; SHADERTEST-NOT: switch i32
+; SHADERTEST: AMDLLPC SUCCESS
+*/
+// END_SHADERTEST
+
+#version 450
+
+layout(constant_id = 0) const int mode = 1;
+
+layout(location = 0) in vec4 a;
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    vec4 color = vec4(0.0);
+    switch (mode)
+    {
+    case 0:
+        color = a;
+        break;
+    case 1:
+        color = a * 2.0;
+        break;
+    default:
+        color = -a;
+        break;
+    }
+    fragColor = color;
+}
@@ -45,9 +45,16 @@
 #include "spvgen.h"
 #include "lgc/LgcContext.h"
 #include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/Signals.h"
 
 #if defined(LLPC_MEM_TRACK_LEAK) && defined(_DEBUG)
@@ -66,7 +73,11 @@
 #include "vld.h"
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib> // getenv, EXIT_FAILURE, EXIT_SUCCESS
+#include <iostream>
+#include <mutex>
 
 #define DEBUG_TYPE "amd-llpc"
 
@@ -86,7 +97,7 @@ cl::opt<std::string> GfxIp("gfxip", cl::desc("Graphics IP version"), cl::value_d
 GfxIpVersion ParsedGfxIp = {8, 0, 2};
 
 // Input sources
-cl::list<std::string> InFiles(cl::Positional, cl::OneOrMore, cl::ValueRequired,
+cl::list<std::string> InFiles(cl::Positional, cl::ZeroOrMore, cl::ValueRequired,
                               cl::desc("<input_file[,entry_point]>...\n"
                                        "Type of input file is determined by its filename extension:\n"
                                        "  .spv      SPIR-V binary\n"
@@ -98,6 +109,7 @@ cl::list<std::string> InFiles(cl::Positional, cl::OneOrMore, cl::ValueRequired,
                                        "  .frag     GLSL fragment shader\n"
                                        "  .comp     GLSL compute shader\n"
                                        "  .pipe     Pipeline info file\n"
+                                       "  .pipebin  Pipeline info binary file\n"
                                        "  .ll       LLVM IR assembly text"));
 
 // -o: output
@@ -195,7 +207,8 @@ cl::opt<unsigned> NggSubgroupSizing(
              "2: Sub-group size is allocated as to allow half of the maximum allowable size\n"
              "3: Sub-group size is optimized for vertex thread utilization\n"
              "4: Sub-group size is optimized for primitive thread utilization\n"
-             "5: Sub-group size is allocated based on explicitly-specified vertsPerSubgroup and primsPerSubgroup"),
+             "5: Sub-group size is allocated based on explicitly-specified vertsPerSubgroup and primsPerSubgroup\n"
+             "6: Sub-group size is allocated from the measured vertex reuse given by -ngg-verts-per-prim-hint"),
     cl::value_desc("sizing"), cl::init(static_cast<unsigned>(NggSubgroupSizingType::Auto)));
 
 // -ngg-prims-per-subgroup: preferred numberof GS primitives to pack into a primitive shader sub-group (NGG)
@@ -210,9 +223,41 @@ cl::opt<unsigned>
                         cl::desc("Preferred number of vertices consumed by a primitive shader sub-group (NGG)"),
                         cl::value_desc("verts"), cl::init(256));
 
+// -ngg-enable-culling-hints: use the measured culling hints to select the cullers and compaction (NGG)
+cl::opt<bool>
+    NggEnableCullingHints("ngg-enable-culling-hints",
+                          cl::desc("Use the measured culling hints to select the cullers and compaction (NGG)"),
+                          cl::init(false));
+
+// -ngg-prims-per-draw-hint: measured average number of primitives per draw, 0 if not measured (NGG)
+cl::opt<unsigned> NggPrimsPerDrawHint("ngg-prims-per-draw-hint",
+                                      cl::desc("Measured average number of primitives per draw, 0 if not measured "
+                                               "(NGG)"),
+                                      cl::value_desc("prims"), cl::init(0));
+
+// -ngg-culled-prim-percent-hint: measured percentage of primitives that are culled, above 100 if not measured (NGG)
+cl::opt<unsigned> NggCulledPrimPercentHint("ngg-culled-prim-percent-hint",
+                                           cl::desc("Measured percentage of primitives that are culled, above 100 if "
+                                                    "not measured (NGG)"),
+                                           cl::value_desc("percent"), cl::init(~0U));
+
+// -ngg-verts-per-prim-hint: measured average number of distinct vertices per primitive, in hundredths (NGG)
+cl::opt<unsigned> NggVertsPerPrimHint("ngg-verts-per-prim-hint",
+                                      cl::desc("Measured average number of distinct vertices per primitive, in "
+                                               "hundredths, 0 if not measured (NGG)"),
+                                      cl::value_desc("verts"), cl::init(0));
+
 // -spvgen-dir: load SPVGEN from specified directory
 cl::opt<std::string> SpvGenDir("spvgen-dir", cl::desc("Directory to load SPVGEN library from"));
 
+// -glsl-cache-dir: directory of an on-disk cache of the SPIR-V that SPVGEN compiles from GLSL and HLSL input files
+cl::opt<std::string> GlslCacheDir("glsl-cache-dir",
+                                  cl::desc("Directory to cache the SPIR-V compiled from GLSL and HLSL input files in,\n"
+                                           "keyed by the source text, shader stage, entry point and SPVGEN version,\n"
+                                           "so that later runs do not compile the same source again. Sources with\n"
+                                           "#include are not cached"),
+                                  cl::value_desc("dir"));
+
 cl::opt<bool> RobustBufferAccess("robust-buffer-access", cl::desc("Validate if the index is out of bounds"),
                                  cl::init(false));
 
@@ -248,6 +293,71 @@ cl::opt<bool> DumpDuplicatePipelines(
     "dump-duplicate-pipelines",
     cl::desc("If TRUE, duplicate pipelines will be dumped to a file with a numeric suffix attached"), cl::init(false));
 
+// -dump-pipeline-info-binary: also dump the pipeline info in the binary encoding (.pipebin)
+cl::opt<bool> DumpPipelineInfoBinary(
+    "dump-pipeline-info-binary",
+    cl::desc("If TRUE, the pipeline info is also dumped, with its SPIR-V, to a .pipebin file that amdllpc reads\n"
+             "without parsing"),
+    cl::init(false));
+
+// -print-cache-access: print the cache access result of each compiled pipeline
+cl::opt<bool> PrintCacheAccess("print-cache-access",
+                               cl::desc("Print the pipeline and shader stage cache access results of each pipeline"),
+                               cl::init(false));
+
+// -print-cache-stats: print the statistics of the cache lookups of all compiled pipelines at exit
+cl::opt<bool> PrintCacheStats("print-cache-stats",
+                              cl::desc("Print the statistics of the cache lookups of all compiled pipelines at exit"),
+                              cl::init(false));
+
+// -server: run as a compile server that reads jobs from stdin
+cl::opt<bool> ServerMode("server",
+                         cl::desc("Run as a compile server with a warm compiler and shader cache. Each line read from\n"
+                                  "stdin is one job, a list of input files in the same form as the command line\n"
+                                  "inputs, optionally preceded by \"-o <output file>\". The result of each job is\n"
+                                  "reported on stdout as \"AMDLLPC JOB SUCCESS\" or \"AMDLLPC JOB FAILED\". Input\n"
+                                  "files can also be uploaded by content hash (\"have\" and \"put\" requests) and\n"
+                                  "referred to as \"@<hash>\", and \"-return-elf\" sends the ELF of a job on stdout,\n"
+                                  "so that compiles can be offloaded to a remote server (see amdllpc-remote.py)."),
+                         cl::init(false));
+
+// -seed-shader-cache: precompile the shader stages of the input pipelines into the on-disk shader cache
+cl::opt<bool> SeedShaderCache("seed-shader-cache",
+                              cl::desc("Compile each unique shader stage of the input pipelines once, as a\n"
+                                       "relocatable shader ELF, into the on-disk shader cache in\n"
+                                       "-shader-cache-file-dir that is named after -executable-name. A directory\n"
+                                       "input stands for the .pipe files in it. No pipeline ELF is written."),
+                              cl::init(false));
+
+// -replay-benchmark: build the input pipelines repeatedly in this process, reporting the throughput and build times
+cl::opt<bool> ReplayBenchmark("replay-benchmark",
+                              cl::desc("Replay the input pipelines (e.g. a corpus dumped with -enable-pipeline-dump)\n"
+                                       "through one compiler, and report the throughput, the build time percentiles\n"
+                                       "and the cache hits. A directory input stands for the .pipe files in it. The\n"
+                                       "inputs are loaded once, so only the pipeline builds are timed. No pipeline\n"
+                                       "ELF is written. The compile phase times of the pipelines are recorded with\n"
+                                       "-timer-profile-trace-file."),
+                              cl::init(false));
+
+// -replay-benchmark-iterations: number of times each pipeline is built for each thread count of -replay-benchmark
+cl::opt<unsigned> ReplayBenchmarkIterations("replay-benchmark-iterations",
+                                            cl::desc("Number of times -replay-benchmark builds each pipeline, for\n"
+                                                     "each thread count"),
+                                            cl::value_desc("integer"), cl::init(3));
+
+// -replay-benchmark-threads: thread counts that -replay-benchmark builds the pipelines with
+cl::list<unsigned> ReplayBenchmarkThreads("replay-benchmark-threads",
+                                          cl::desc("Comma-separated thread counts that -replay-benchmark builds the\n"
+                                                   "pipelines with, as for -num-threads (default: -num-threads)"),
+                                          cl::value_desc("integer,..."), cl::CommaSeparated);
+
+// -verify-deterministic-output: compile the inputs twice, and check that the pipeline ELFs are byte-identical
+cl::opt<bool> VerifyDeterministicOutput("verify-deterministic-output",
+                                        cl::desc("Compile the inputs a second time, on one thread with a compiler of\n"
+                                                 "its own that starts with empty caches, and fail if any pipeline ELF\n"
+                                                 "is not byte-identical to that of the compile with -num-threads"),
+                                        cl::init(false));
+
 #ifdef WIN_OS
 // -assert-to-msgbox: pop message box when an assert is hit, only valid in Windows
 cl::opt<bool> AssertToMsgBox("assert-to-msgbox", cl::desc("Pop message box when assert is hit"));
@@ -266,6 +376,36 @@ extern opt<bool> BuildShaderCache;
 } // namespace cl
 } // namespace llvm
 
+namespace {
+// Counts of the shader stages compiled by -seed-shader-cache
+struct SeedStats {
+  std::atomic<unsigned> pipelines{0};         // Pipelines processed
+  std::atomic<unsigned> compiledStages{0};    // Shader stages compiled into the cache
+  std::atomic<unsigned> cachedStages{0};      // Shader stages that were already in the cache
+  std::atomic<unsigned> unseededPipelines{0}; // Pipelines that could not be built from relocatable shader ELFs
+};
+SeedStats SeedShaderCacheStats;
+
+// Pipeline ELFs compiled by one pass of -verify-deterministic-output
+struct CompiledElfs {
+  bool writeFiles = true;              // Whether the ELFs are also written to files, as for a normal compile
+  std::vector<std::string> inputFiles; // First input file of each pipeline, by pipeline index
+  std::vector<std::string> elfs;       // Pipeline ELF of each pipeline, by pipeline index
+};
+} // anonymous namespace
+
+// =====================================================================================================================
+// Sets the value of a registered command-line option, before the options are parsed, so that it acts as the default.
+//
+// @param name : Name of the option
+// @param value : Value to set
+template <typename T> static void setRegisteredOption(StringRef name, const T &value) {
+  auto optIterator = cl::getRegisteredOptions().find(name);
+  assert(optIterator != cl::getRegisteredOptions().end());
+  cl::Option *opt = optIterator->second;
+  *static_cast<cl::opt<T> *>(opt) = value;
+}
+
 // =====================================================================================================================
 // Performs initialization work for LLPC standalone tool.
 //
@@ -342,11 +482,22 @@ static Result init(int argc, char *argv[], ICompiler *&compiler) {
     }
   }
 #endif
-  if (!envString) {
-    auto optIterator = cl::getRegisteredOptions().find("shader-cache-file-dir");
-    assert(optIterator != cl::getRegisteredOptions().end());
-    cl::Option *opt = optIterator->second;
-    *static_cast<cl::opt<std::string> *>(opt) = ".";
+  if (!envString)
+    setRegisteredOption<std::string>("shader-cache-file-dir", ".");
+
+  // For -seed-shader-cache, the compiled shader stages go into the on-disk shader cache, and the linked pipelines do
+  // not. The cache is created along with the compiler, so the defaults of its options are changed before the options
+  // are parsed, in the same way as for -gfxip.
+  for (int i = 1; i != argc; ++i) {
+    StringRef arg = argv[i];
+    if (arg.startswith("--"))
+      arg = arg.drop_front(1);
+    if (arg != "-seed-shader-cache" && arg != "-seed-shader-cache=true" && arg != "-seed-shader-cache=1")
+      continue;
+    setRegisteredOption<unsigned>("shader-cache-mode", 2); // Cache to disk
+    setRegisteredOption<bool>("cache-full-pipelines", false);
+    NumThreads.setValue(0); // Use all logical CPUs
+    break;
   }
 
   // Check to see that the ParsedGfxIp is valid
@@ -381,7 +532,7 @@ static Result init(int argc, char *argv[], ICompiler *&compiler) {
 // @returns : Result::Success on success, other status codes on failure
 static Result initCompileInfo(CompileInfo *compileInfo) {
   compileInfo->gfxIp = ParsedGfxIp;
-  compileInfo->relocatableShaderElf = EnableRelocatableShaderElf;
+  compileInfo->relocatableShaderElf = EnableRelocatableShaderElf || SeedShaderCache;
   compileInfo->autoLayoutDesc = AutoLayoutDesc;
   compileInfo->robustBufferAccess = RobustBufferAccess;
   compileInfo->scalarBlockLayout = ScalarBlockLayout;
@@ -407,18 +558,286 @@ static Result initCompileInfo(CompileInfo *compileInfo) {
     nggState.subgroupSizing = static_cast<NggSubgroupSizingType>(NggSubgroupSizing.getValue());
     nggState.primsPerSubgroup = NggPrimsPerSubgroup;
     nggState.vertsPerSubgroup = NggVertsPerSubgroup;
+
+    nggState.enableCullingHints = NggEnableCullingHints;
+    nggState.primsPerDrawHint = NggPrimsPerDrawHint;
+    nggState.culledPrimPercentHint = NggCulledPrimPercentHint;
+    nggState.vertsPerPrimHint = NggVertsPerPrimHint;
   }
 
   return Result::Success;
 }
 
+// =====================================================================================================================
+// Estimates the cost of compiling one pipeline, used as its scheduling priority. This is the total size of its input
+// files, so that the largest pipelines are started first and do not hold up the end of a multi-threaded run.
+//
+// @param inputSpecs : Input specifications of the pipeline
+// @returns : Estimated cost of compiling the pipeline
+static uint64_t estimateInputsCost(const InputSpecGroup &inputSpecs) {
+  uint64_t cost = 0;
+  for (const InputSpec &inputSpec : inputSpecs) {
+    uint64_t fileSize = 0;
+    if (!sys::fs::file_size(inputSpec.filename, fileSize))
+      cost += fileSize;
+  }
+  return cost;
+}
+
+// =====================================================================================================================
+// Gets the name used for a cache access result when printing it.
+//
+// @param cacheAccess : Cache access result
+// @returns : Name of the cache access result
+static const char *getCacheAccessName(CacheAccessInfo cacheAccess) {
+  switch (cacheAccess) {
+  case CacheAccessInfo::CacheMiss:
+    return "miss";
+  case CacheAccessInfo::CacheHit:
+    return "hit";
+  case CacheAccessInfo::InternalCacheHit:
+    return "internal-hit";
+  default:
+    return "not-checked";
+  }
+}
+
+// =====================================================================================================================
+// Prints the cache access results of a compiled pipeline, as one line that tools (e.g. the compile benchmark script)
+// can parse. Stages that were not checked are omitted.
+//
+// @param compileInfo : Compilation info of the pipeline
+// @param [out] ostream : Stream to print to
+static void printCacheAccess(const CompileInfo &compileInfo, raw_ostream &ostream) {
+  static const char *const StageAbbreviations[ShaderStageCount] = {"vs", "tcs", "tes", "gs", "fs", "cs"};
+
+  ostream << "LLPC CacheAccess:";
+  if (isGraphicsPipeline(compileInfo.stageMask)) {
+    const GraphicsPipelineBuildOut &pipelineOut = compileInfo.gfxPipelineOut;
+    ostream << " pipeline=" << getCacheAccessName(pipelineOut.pipelineCacheAccess);
+    for (unsigned stage = 0; stage < ShaderStageGfxCount; ++stage) {
+      if (pipelineOut.stageCacheAccesses[stage] != CacheAccessInfo::CacheNotChecked)
+        ostream << " " << StageAbbreviations[stage] << "=" << getCacheAccessName(pipelineOut.stageCacheAccesses[stage]);
+    }
+  } else {
+    const ComputePipelineBuildOut &pipelineOut = compileInfo.compPipelineOut;
+    ostream << " pipeline=" << getCacheAccessName(pipelineOut.pipelineCacheAccess);
+    if (pipelineOut.stageCacheAccess != CacheAccessInfo::CacheNotChecked) {
+      ostream << " " << StageAbbreviations[ShaderStageCompute] << "="
+              << getCacheAccessName(pipelineOut.stageCacheAccess);
+    }
+  }
+  ostream << " Files: " << join(map_range(compileInfo.inputSpecs, [](const InputSpec &spec) { return spec.filename; }),
+                                " ")
+          << "\n";
+}
+
+// =====================================================================================================================
+// Prints the statistics of the cache lookups, as one line per cache layer that was looked up. The latency histogram
+// gives the count of lookups per power-of-two bucket of microseconds, see CacheLatencyBucketCount.
+//
+// @param compiler : LLPC compiler object
+// @param [out] ostream : Stream to print to
+static void printCacheStats(ICompiler *compiler, raw_ostream &ostream) {
+  static const char *const LayerNames[CacheLayerCount] = {"internal-cache", "application-cache",
+                                                          "internal-shader-cache", "application-shader-cache",
+                                                          "glue-shader-memory"};
+  CacheStats stats = {};
+  compiler->GetCacheStats(&stats);
+  for (unsigned layer = 0; layer < CacheLayerCount; ++layer) {
+    const CacheLayerStats &layerStats = stats.layers[layer];
+    if (layerStats.lookups == 0)
+      continue;
+    std::string histogram =
+        join(map_range(makeArrayRef(layerStats.latencyHistogram), [](uint64_t count) { return std::to_string(count); }),
+             ",");
+    ostream << "LLPC CacheStats: layer=" << LayerNames[layer] << " lookups=" << layerStats.lookups
+            << " hits=" << layerStats.hits
+            << format(" hit-rate=%.1f%%", 100.0 * layerStats.hits / layerStats.lookups)
+            << " bytes-read=" << layerStats.bytesRead << " waits=" << layerStats.waits
+            << format(" wait-ms=%.3f", layerStats.waitNs / 1.0e6)
+            << format(" avg-latency-us=%.3f", layerStats.latencyNs / 1.0e3 / layerStats.lookups) << " histogram="
+            << histogram << "\n";
+  }
+}
+
+namespace {
+// =====================================================================================================================
+// Writes the reports of the pipelines compiled by one run to stdout in the order of their inputs, so that the output
+// does not depend on the order in which pipelines compiled on multiple threads finish. The report of each pipeline is
+// written as soon as it and all the pipelines before it have finished, so that progress is still visible.
+class OrderedReports {
+public:
+  explicit OrderedReports(size_t numPipelines) : m_reports(numPipelines), m_finished(numPipelines, false) {}
+
+  // Sets the report of a finished pipeline, and writes out the reports that are now in order.
+  //
+  // @param pipelineIdx : Index of the pipeline in the inputs
+  // @param report : Report of the pipeline
+  void finish(size_t pipelineIdx, std::string report) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reports[pipelineIdx] = std::move(report);
+    m_finished[pipelineIdx] = true;
+    for (; m_nextReport != m_reports.size() && m_finished[m_nextReport]; ++m_nextReport) {
+      outs() << m_reports[m_nextReport];
+      std::string().swap(m_reports[m_nextReport]);
+    }
+    outs().flush();
+  }
+
+private:
+  std::mutex m_mutex;                 // Guards the other members
+  std::vector<std::string> m_reports; // Reports of the finished pipelines not yet written, by pipeline index
+  std::vector<bool> m_finished;       // Whether each pipeline has finished
+  size_t m_nextReport = 0;            // Index of the next pipeline whose report is to be written
+};
+
+// Content store of a compile server, holding the input files uploaded by the client by the SHA-256 hash of their
+// content, so that a client only has to upload the inputs that the server does not have yet. The files are kept in a
+// temporary directory that is removed when the store is destroyed.
+class ServerContentStore {
+public:
+  ~ServerContentStore() {
+    if (!m_dir.empty())
+      sys::fs::remove_directories(m_dir);
+  }
+
+  // Gets whether the store has the content with the given hash.
+  //
+  // @param hash : Lower case hex SHA-256 hash of the content
+  bool contains(StringRef hash) const { return m_files.count(hash) != 0; }
+
+  // Gets the path of the file holding the content with the given hash, or an empty string if there is none.
+  //
+  // @param hash : Lower case hex SHA-256 hash of the content
+  StringRef getPath(StringRef hash) const {
+    auto it = m_files.find(hash);
+    return it != m_files.end() ? StringRef(it->second) : StringRef();
+  }
+
+  // Gets the path of a file in the store directory for the output of a job, creating the directory if needed.
+  //
+  // @param [out] path : Path of the output file
+  // @returns : `ErrorSuccess` on success, `ResultError` on failure
+  Error getOutputPath(std::string &path) {
+    if (Error err = createDir())
+      return err;
+    path = (m_dir + "/job.elf").str();
+    return Error::success();
+  }
+
+  // Adds content to the store, after checking that it matches its hash. The file keeps the extension of the input
+  // file, as that is how amdllpc determines the type of an input.
+  //
+  // @param hash : Lower case hex SHA-256 hash of the content, as given by the client
+  // @param extension : Filename extension of the input file, including the dot
+  // @param content : Content of the input file
+  // @returns : `ErrorSuccess` on success, `ResultError` on failure
+  Error put(StringRef hash, StringRef extension, StringRef content) {
+    if (toHex(SHA256::hash(arrayRefFromStringRef(content)), /*LowerCase=*/true) != hash)
+      return createResultError(Result::ErrorInvalidValue, "Uploaded content does not match its hash " + hash);
+    if (contains(hash))
+      return Error::success();
+    if (Error err = createDir())
+      return err;
+
+    std::string path = (m_dir + "/" + hash + extension).str();
+    std::error_code errCode;
+    raw_fd_ostream file(path, errCode, sys::fs::OF_None);
+    if (errCode)
+      return createResultError(Result::ErrorUnavailable, "Failed to open " + path + ": " + errCode.message());
+    file << content;
+    file.close();
+    if (file.has_error())
+      return createResultError(Result::ErrorUnavailable, "Failed to write " + path);
+    m_files[hash] = std::move(path);
+    return Error::success();
+  }
+
+private:
+  // Creates the store directory if it does not exist yet.
+  Error createDir() {
+    if (!m_dir.empty())
+      return Error::success();
+    if (std::error_code errCode = sys::fs::createUniqueDirectory("amdllpc-server", m_dir))
+      return createResultError(Result::ErrorUnavailable, "Failed to create server store: " + errCode.message());
+    return Error::success();
+  }
+
+  SmallString<128> m_dir;         // Store directory, or empty if it has not been created yet
+  StringMap<std::string> m_files; // Paths of the stored files, by content hash
+};
+} // anonymous namespace
+
+// =====================================================================================================================
+// Adds the shader stages of a pipeline built by -seed-shader-cache to the counts of the stages seeded.
+//
+// @param compileInfo : Compilation info of the pipeline
+static void countSeededStages(const CompileInfo &compileInfo) {
+  ArrayRef<CacheAccessInfo> stageCacheAccesses = compileInfo.compPipelineOut.stageCacheAccess;
+  if (isGraphicsPipeline(compileInfo.stageMask))
+    stageCacheAccesses = compileInfo.gfxPipelineOut.stageCacheAccesses;
+
+  bool seeded = false;
+  for (CacheAccessInfo cacheAccess : stageCacheAccesses) {
+    if (cacheAccess == CacheAccessInfo::CacheNotChecked)
+      continue;
+    seeded = true;
+    if (cacheAccess == CacheAccessInfo::CacheMiss)
+      ++SeedShaderCacheStats.compiledStages;
+    else
+      ++SeedShaderCacheStats.cachedStages;
+  }
+  ++SeedShaderCacheStats.pipelines;
+  if (!seeded)
+    ++SeedShaderCacheStats.unseededPipelines;
+}
+
+// =====================================================================================================================
+// Replaces each directory in a list of input files by the .pipe files in it, for -seed-shader-cache. The .pipe files
+// of a directory are given in the order of their names, so that the shader cache file does not depend on the order of
+// the directory entries.
+//
+// @param inputFiles : Input files
+// @param [out] pipelineFiles : Input files with the directories expanded
+// @returns : `ErrorSuccess` on success, `ResultError` on failure
+static Error expandPipelineDirectories(ArrayRef<std::string> inputFiles, std::vector<std::string> &pipelineFiles) {
+  for (const std::string &inputFile : inputFiles) {
+    if (!sys::fs::is_directory(inputFile)) {
+      pipelineFiles.push_back(inputFile);
+      continue;
+    }
+
+    std::vector<std::string> dirFiles;
+    std::error_code errCode;
+    sys::fs::recursive_directory_iterator end;
+    for (sys::fs::recursive_directory_iterator it(inputFile, errCode); it != end && !errCode; it.increment(errCode)) {
+      if (isPipelineInfoFile(it->path()))
+        dirFiles.push_back(it->path());
+    }
+    if (errCode)
+      return createResultError(Result::ErrorUnavailable, "Failed to read directory: " + inputFile);
+    if (dirFiles.empty())
+      return createResultError(Result::NotFound, "No .pipe files in directory: " + inputFile);
+
+    llvm::sort(dirFiles);
+    append_range(pipelineFiles, dirFiles);
+  }
+  return Error::success();
+}
+
 // =====================================================================================================================
 // Process one pipeline. This can either be a single .pipe file or a set of shader stages.
 //
 // @param compiler : LLPC compiler
 // @param inFiles : Input filename(s)
+// @param outFile : Output file, or empty to name it after the first input file
+// @param [out] reportOut : Stream to print the report of the pipeline to
+// @param [out] pipelineElf : If not null, gets a copy of the pipeline ELF
+// @param writeElf : Whether to write the pipeline ELF to the output file
 // @returns : `ErrorSuccess` on success, `ResultError` on failure
-static Error processInputs(ICompiler *compiler, InputSpecGroup &inputSpecs) {
+static Error processInputs(ICompiler *compiler, InputSpecGroup &inputSpecs, const std::string &outFile,
+                           raw_ostream &reportOut, std::string *pipelineElf, bool writeElf) {
   assert(!inputSpecs.empty());
   CompileInfo compileInfo = {};
   compileInfo.unlinked = true;
@@ -435,7 +854,7 @@ static Error processInputs(ICompiler *compiler, InputSpecGroup &inputSpecs) {
     if (Error err = processInputPipeline(compiler, compileInfo, firstInput, Unlinked, IgnoreColorAttachmentFormats))
       return err;
   } else {
-    if (Error err = processInputStages(compileInfo, inputSpecs, ValidateSpirv, NumThreads))
+    if (Error err = processInputStages(compileInfo, inputSpecs, ValidateSpirv, NumThreads, GlslCacheDir))
       return err;
   }
 
@@ -459,6 +878,7 @@ static Error processInputs(ICompiler *compiler, InputSpecGroup &inputSpecs) {
     dumpOptions->filterPipelineDumpByType = FilterPipelineDumpByType;
     dumpOptions->filterPipelineDumpByHash = FilterPipelineDumpByHash;
     dumpOptions->dumpDuplicatePipelines = DumpDuplicatePipelines;
+    dumpOptions->dumpPipelineInfoBinary = DumpPipelineInfoBinary;
   }
 
   std::unique_ptr<PipelineBuilder> builder =
@@ -466,7 +886,389 @@ static Error processInputs(ICompiler *compiler, InputSpecGroup &inputSpecs) {
   if (Error err = builder->build())
     return err;
 
-  return outputElf(&compileInfo, OutFile, firstInput.filename);
+  if (PrintCacheAccess)
+    printCacheAccess(compileInfo, reportOut);
+
+  if (SeedShaderCache) {
+    countSeededStages(compileInfo);
+    return Error::success();
+  }
+
+  if (pipelineElf) {
+    const BinaryData &pipelineBin = (compileInfo.stageMask & ShaderStageComputeBit)
+                                        ? compileInfo.compPipelineOut.pipelineBin
+                                        : compileInfo.gfxPipelineOut.pipelineBin;
+    pipelineElf->assign(static_cast<const char *>(pipelineBin.pCode), pipelineBin.codeSize);
+  }
+  if (!writeElf)
+    return Error::success();
+
+  return outputElf(&compileInfo, outFile, firstInput.filename);
+}
+
+// =====================================================================================================================
+// Process the pipelines of a list of input files, given in the same form as the command line inputs.
+//
+// When the pipelines are compiled on multiple threads, all of them are compiled even if some fail, and the reports and
+// errors of the pipelines are given in the order of the inputs, so that the results of a run do not depend on thread
+// timing.
+//
+// @param compiler : LLPC compiler
+// @param inputFiles : Input files
+// @param outFile : Output file, or empty to name it after the first input file of each pipeline
+// @param numThreads : Number of threads to compile the pipelines on, as for -num-threads
+// @param [out] compiledElfs : If not null, gets the pipeline ELFs, for -verify-deterministic-output
+// @returns : `ErrorSuccess` on success, `ResultError` on failure
+static Error processInputFiles(ICompiler *compiler, ArrayRef<std::string> inputFiles, const std::string &outFile,
+                               unsigned numThreads, CompiledElfs *compiledElfs) {
+  std::vector<std::string> pipelineFiles;
+  if (SeedShaderCache) {
+    if (Error err = expandPipelineDirectories(inputFiles, pipelineFiles))
+      return err;
+    inputFiles = pipelineFiles;
+  }
+
+  std::vector<std::string> expandedInputFiles;
+  Result result = expandInputFilenames(inputFiles, expandedInputFiles);
+  if (result != Result::Success)
+    return createResultError(result, "Failed to expand input files");
+
+  auto inputSpecsOrErr = parseAndCollectInputFileSpecs(expandedInputFiles);
+  if (Error err = inputSpecsOrErr.takeError())
+    return err;
+
+  auto inputGroupsOrErr = groupInputSpecs(*inputSpecsOrErr);
+  if (Error err = inputGroupsOrErr.takeError())
+    return err;
+
+  MutableArrayRef<InputSpecGroup> inputGroups = *inputGroupsOrErr;
+  if (compiledElfs) {
+    compiledElfs->inputFiles.clear();
+    for (const InputSpecGroup &inputGroup : inputGroups)
+      compiledElfs->inputFiles.push_back(inputGroup.front().filename);
+    compiledElfs->elfs.assign(inputGroups.size(), std::string());
+  }
+
+  const bool isParallel = numThreads != 1 && inputGroups.size() > 1;
+  OrderedReports reports(inputGroups.size());
+  std::vector<Optional<Error>> errors(inputGroups.size());
+  Error err = parallelFor(
+      numThreads, inputGroups,
+      [&](InputSpecGroup &inputGroup) -> Error {
+        const size_t pipelineIdx = &inputGroup - inputGroups.data();
+        std::string report;
+        raw_string_ostream reportOut(report);
+        std::string *pipelineElf = compiledElfs ? &compiledElfs->elfs[pipelineIdx] : nullptr;
+        Error buildErr = processInputs(compiler, inputGroup, outFile, reportOut, pipelineElf,
+                                       !compiledElfs || compiledElfs->writeFiles);
+        reports.finish(pipelineIdx, std::move(reportOut.str()));
+        if (buildErr && isParallel) {
+          errors[pipelineIdx].emplace(std::move(buildErr));
+          return Error::success();
+        }
+        return buildErr;
+      },
+      [](const InputSpecGroup &inputGroup) { return estimateInputsCost(inputGroup); });
+
+  for (Optional<Error> &pipelineErr : errors) {
+    if (pipelineErr)
+      err = joinErrors(std::move(err), std::move(*pipelineErr));
+  }
+  return err;
+}
+
+// =====================================================================================================================
+// Compiles the inputs a second time for -verify-deterministic-output, and checks that each pipeline ELF is
+// byte-identical to that of the first compile. The second compile is done on one thread, with a compiler of its own so
+// that no pipeline, shader stage or glue shader comes from the caches filled by the first compile, which was done with
+// -num-threads. This checks that the output depends neither on the order in which the pipelines, and the stages and
+// glue shaders in them, are compiled, nor on which of them were found in the caches.
+//
+// @param argc : Count of arguments, to create the compiler with
+// @param argv : List of arguments, to create the compiler with
+// @param firstElfs : Pipeline ELFs of the first compile
+// @returns : `ErrorSuccess` on success, `ResultError` on failure
+static Error verifyDeterministicOutput(int argc, char *argv[], const CompiledElfs &firstElfs) {
+  ICompiler *compiler = nullptr;
+  Result result = ICompiler::Create(ParsedGfxIp, argc, argv, &compiler);
+  if (result != Result::Success)
+    return createResultError(result, "Failed to create the compiler for -verify-deterministic-output");
+  auto onExit = make_scope_exit([compiler] { compiler->Destroy(); });
+
+  CompiledElfs secondElfs;
+  secondElfs.writeFiles = false;
+  if (Error err = processInputFiles(compiler, InFiles, OutFile, 1, &secondElfs))
+    return err;
+  assert(secondElfs.elfs.size() == firstElfs.elfs.size());
+
+  Error err = Error::success();
+  for (size_t pipelineIdx = 0; pipelineIdx != firstElfs.elfs.size(); ++pipelineIdx) {
+    StringRef firstElf = firstElfs.elfs[pipelineIdx];
+    StringRef secondElf = secondElfs.elfs[pipelineIdx];
+    if (firstElf == secondElf)
+      continue;
+    size_t offset = 0;
+    while (offset != firstElf.size() && offset != secondElf.size() && firstElf[offset] == secondElf[offset])
+      ++offset;
+    err = joinErrors(std::move(err), createResultError(Result::ErrorUnknown,
+                                                       Twine("Pipeline ELF of ") + firstElfs.inputFiles[pipelineIdx] +
+                                                           " is not deterministic: sizes " + Twine(firstElf.size()) +
+                                                           " and " + Twine(secondElf.size()) +
+                                                           ", first difference at offset " + Twine(offset)));
+  }
+  if (err)
+    return err;
+
+  outs() << "LLPC VerifyDeterministicOutput: pipelines=" << firstElfs.elfs.size() << " identical\n";
+  return Error::success();
+}
+
+// =====================================================================================================================
+// Gets a percentile of a sorted list of pipeline build times, by the nearest rank.
+//
+// @param sortedTimes : Build times, in ascending order
+// @param percentile : Percentile to get, from 0 to 100
+// @returns : The build time at the percentile
+static double getPercentile(ArrayRef<double> sortedTimes, unsigned percentile) {
+  assert(!sortedTimes.empty());
+  size_t rank = (sortedTimes.size() * percentile + 99) / 100;
+  return sortedTimes[std::max(rank, size_t(1)) - 1];
+}
+
+// =====================================================================================================================
+// Prints the latency percentiles of a list of pipeline build times.
+//
+// @param [in/out] times : Build times in milliseconds, which get sorted
+// @param [out] ostream : Stream to print to
+static void printLatencyPercentiles(MutableArrayRef<double> times, raw_ostream &ostream) {
+  llvm::sort(times);
+  ostream << format(" p50-ms=%.3f p90-ms=%.3f p99-ms=%.3f max-ms=%.3f", getPercentile(times, 50),
+                    getPercentile(times, 90), getPercentile(times, 99), times.back());
+}
+
+// =====================================================================================================================
+// Runs the replay benchmark: loads the input pipelines, and builds the shader modules of each, once, then builds all
+// the pipelines -replay-benchmark-iterations times for each thread count in -replay-benchmark-threads, with the one
+// compiler. Reports on stdout the throughput and build time percentiles of each iteration, and of each thread count
+// over all its iterations, along with the pipeline and shader stage cache hits of each iteration. As the compiler and
+// its caches stay warm, only the first iteration of the run is a cold compile.
+//
+// @param compiler : LLPC compiler
+// @returns : `ErrorSuccess` on success, `ResultError` on failure
+static Error runReplayBenchmark(ICompiler *compiler) {
+  std::vector<std::string> pipelineFiles;
+  if (Error err = expandPipelineDirectories(InFiles, pipelineFiles))
+    return err;
+  auto inputSpecsOrErr = parseAndCollectInputFileSpecs(pipelineFiles);
+  if (Error err = inputSpecsOrErr.takeError())
+    return err;
+
+  if (inputSpecsOrErr->empty())
+    return createResultError(Result::ErrorInvalidValue, "No pipelines to replay");
+  if (ReplayBenchmarkIterations == 0)
+    return createResultError(Result::ErrorInvalidValue, "-replay-benchmark-iterations must be at least 1");
+
+  std::vector<unsigned> threadCounts(ReplayBenchmarkThreads.begin(), ReplayBenchmarkThreads.end());
+  if (threadCounts.empty())
+    threadCounts.push_back(NumThreads);
+  if (EnableOuts() && any_of(threadCounts, [](unsigned threadCount) { return threadCount != 1; }))
+    return createResultError(Result::Unsupported,
+                             "Verbose output is not available when compiling with multiple threads");
+
+  std::vector<std::unique_ptr<CompileInfo>> pipelines;
+  auto onExit = make_scope_exit([&pipelines] {
+    for (std::unique_ptr<CompileInfo> &compileInfo : pipelines)
+      cleanupCompileInfo(compileInfo.get());
+  });
+  for (const InputSpec &inputSpec : *inputSpecsOrErr) {
+    if (!isPipelineInfoFile(inputSpec.filename))
+      return createResultError(Result::ErrorInvalidValue, "Not a pipeline info file: " + inputSpec.filename);
+    pipelines.push_back(std::make_unique<CompileInfo>());
+    CompileInfo &compileInfo = *pipelines.back();
+    Result result = initCompileInfo(&compileInfo);
+    if (result != Result::Success)
+      return createResultError(result);
+    if (Error err = processInputPipeline(compiler, compileInfo, inputSpec, Unlinked, IgnoreColorAttachmentFormats))
+      return err;
+    if (Error err = buildShaderModules(compiler, &compileInfo))
+      return err;
+  }
+
+  for (unsigned threadCount : threadCounts) {
+    std::vector<double> configTimes;
+    std::vector<double> throughputs;
+    for (unsigned iteration = 1; iteration <= ReplayBenchmarkIterations; ++iteration) {
+      std::vector<double> times(pipelines.size());
+      const auto startTime = std::chrono::steady_clock::now();
+      Error err = parallelFor(threadCount, pipelines, [&](std::unique_ptr<CompileInfo> &compileInfo) -> Error {
+        const auto buildStartTime = std::chrono::steady_clock::now();
+        std::unique_ptr<PipelineBuilder> builder = createPipelineBuilder(*compiler, *compileInfo, None, false);
+        Error buildErr = builder->build();
+        times[&compileInfo - pipelines.data()] =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStartTime).count();
+        // The pipeline binary is freed, so that the next build of the pipeline starts afresh.
+        free(compileInfo->pipelineBuf);
+        compileInfo->pipelineBuf = nullptr;
+        return buildErr;
+      });
+      if (err)
+        return err;
+      const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+      unsigned pipelineCacheHits = 0;
+      unsigned stageCacheHits = 0;
+      unsigned stageCacheChecks = 0;
+      auto countAccess = [](CacheAccessInfo cacheAccess, unsigned &hits, unsigned *checks) {
+        if (cacheAccess == CacheAccessInfo::CacheHit || cacheAccess == CacheAccessInfo::InternalCacheHit)
+          ++hits;
+        if (checks && cacheAccess != CacheAccessInfo::CacheNotChecked)
+          ++*checks;
+      };
+      for (const std::unique_ptr<CompileInfo> &compileInfo : pipelines) {
+        if (isGraphicsPipeline(compileInfo->stageMask)) {
+          countAccess(compileInfo->gfxPipelineOut.pipelineCacheAccess, pipelineCacheHits, nullptr);
+          for (CacheAccessInfo stageCacheAccess : compileInfo->gfxPipelineOut.stageCacheAccesses)
+            countAccess(stageCacheAccess, stageCacheHits, &stageCacheChecks);
+        } else {
+          countAccess(compileInfo->compPipelineOut.pipelineCacheAccess, pipelineCacheHits, nullptr);
+          countAccess(compileInfo->compPipelineOut.stageCacheAccess, stageCacheHits, &stageCacheChecks);
+        }
+      }
+
+      const double throughput = pipelines.size() / wallTime;
+      throughputs.push_back(throughput);
+      append_range(configTimes, times);
+      outs() << "LLPC ReplayBenchmark: threads=" << threadCount << " iteration=" << iteration
+             << " pipelines=" << pipelines.size() << format(" wall-ms=%.3f", wallTime * 1000)
+             << format(" pipelines-per-second=%.2f", throughput);
+      printLatencyPercentiles(times, outs());
+      outs() << " pipeline-cache-hits=" << pipelineCacheHits << " stage-cache-hits=" << stageCacheHits << "/"
+             << stageCacheChecks << "\n";
+    }
+
+    llvm::sort(throughputs);
+    outs() << "LLPC ReplayBenchmark summary: threads=" << threadCount << " iterations=" << ReplayBenchmarkIterations
+           << format(" median-pipelines-per-second=%.2f", throughputs[throughputs.size() / 2]);
+    printLatencyPercentiles(configTimes, outs());
+    outs() << "\n";
+    outs().flush();
+  }
+  return Error::success();
+}
+
+// =====================================================================================================================
+// Runs as a compile server: reads requests from stdin, one per line, until the end of the input. The compiler, and so
+// its context pool and shader cache, stay warm across the jobs, so each job avoids the cost of starting a new process.
+//
+// Other than jobs, the requests manage a content store of input files, so that a client on another machine can offload
+// its compiles to the server over any transport that connects it to the stdin and stdout of the server (e.g. ssh):
+//   have <hash>                    Replies "AMDLLPC HAVE <hash> yes" or "AMDLLPC HAVE <hash> no", so that the client
+//                                  only uploads the input files that the server does not have yet.
+//   put <hash> <extension> <size>  Followed by <size> bytes of content, whose lower case hex SHA-256 hash is <hash>.
+//                                  Replies "AMDLLPC PUT <hash> SUCCESS" or "AMDLLPC PUT <hash> FAILED".
+// An input file of a job given as "@<hash>[,entry_point]" refers to the stored file with that content. A job preceded
+// by "-return-elf" sends its output on stdout as "AMDLLPC ELF <size>" followed by <size> bytes of ELF, before the
+// result of the job.
+//
+// @param compiler : LLPC compiler
+// @returns : Result::Success if all the jobs succeeded, other status codes otherwise
+static Result runServer(ICompiler *compiler) {
+  Result result = Result::Success;
+  ServerContentStore store;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    SmallVector<StringRef, 4> args;
+    SplitString(line, args);
+    if (args.empty())
+      continue;
+
+    if (args[0] == "have" && args.size() == 2) {
+      outs() << "AMDLLPC HAVE " << args[1] << (store.contains(args[1]) ? " yes\n" : " no\n");
+      outs().flush();
+      continue;
+    }
+
+    if (args[0] == "put" && args.size() == 4) {
+      std::string hash = args[1].str();
+      std::string extension = args[2].str();
+      Error err = Error::success();
+      size_t size = 0;
+      if (to_integer(args[3], size)) {
+        std::string content(size, '\0');
+        if (std::cin.read(&content[0], size))
+          err = store.put(hash, extension, content);
+        else
+          err = createResultError(Result::ErrorInvalidValue, "Truncated upload of " + hash);
+      } else
+        err = createResultError(Result::ErrorInvalidValue, "Invalid upload request: " + line);
+
+      if (err) {
+        result = reportError(std::move(err));
+        outs() << "AMDLLPC PUT " << hash << " FAILED\n";
+      } else
+        outs() << "AMDLLPC PUT " << hash << " SUCCESS\n";
+      outs().flush();
+      if (std::cin.fail())
+        break;
+      continue;
+    }
+
+    std::string outFile;
+    bool returnElf = false;
+    while (!args.empty()) {
+      if (args.size() >= 2 && args[0] == "-o") {
+        outFile = args[1].str();
+        args.erase(args.begin(), args.begin() + 2);
+      } else if (args[0] == "-return-elf") {
+        returnElf = true;
+        args.erase(args.begin());
+      } else
+        break;
+    }
+
+    Error err = Error::success();
+    std::vector<std::string> inputFiles;
+    for (StringRef arg : args) {
+      if (!arg.startswith("@")) {
+        inputFiles.push_back(arg.str());
+        continue;
+      }
+      // Replace the hash with the path of the stored file, keeping any entry point.
+      std::pair<StringRef, StringRef> hashAndEntry = arg.drop_front().split(',');
+      StringRef path = store.getPath(hashAndEntry.first);
+      if (path.empty()) {
+        err = joinErrors(std::move(err),
+                         createResultError(Result::NotFound, "No stored input file with hash " + hashAndEntry.first));
+        continue;
+      }
+      inputFiles.push_back(hashAndEntry.second.empty() ? path.str() : (path + "," + hashAndEntry.second).str());
+    }
+    if (!err && inputFiles.empty())
+      err = createResultError(Result::ErrorInvalidValue, "No input files in job: " + line);
+    if (!err && returnElf)
+      err = store.getOutputPath(outFile);
+    if (!err)
+      err = processInputFiles(compiler, inputFiles, outFile, NumThreads, nullptr);
+
+    if (!err && returnElf) {
+      ErrorOr<std::unique_ptr<MemoryBuffer>> elfOrErr =
+          MemoryBuffer::getFile(outFile, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+      if (elfOrErr) {
+        outs() << "AMDLLPC ELF " << (*elfOrErr)->getBufferSize() << "\n";
+        outs() << (*elfOrErr)->getBuffer();
+        sys::fs::remove(outFile);
+      } else
+        err = createResultError(Result::ErrorUnavailable, "Failed to read the output of job: " + line);
+    }
+
+    if (err) {
+      result = reportError(std::move(err));
+      outs() << "AMDLLPC JOB FAILED\n";
+    } else
+      outs() << "AMDLLPC JOB SUCCESS\n";
+    outs().flush();
+  }
+  return result;
 }
 
 #ifdef WIN_OS
@@ -533,6 +1335,8 @@ int main(int argc, char *argv[]) {
 
   // Cleanup code that gets run automatically before returning.
   auto onExit = make_scope_exit([compiler, &result] {
+    if (compiler && PrintCacheStats)
+      printCacheStats(compiler, outs());
     if (compiler)
       compiler->Destroy();
 
@@ -545,29 +1349,52 @@ int main(int argc, char *argv[]) {
   if (result != Result::Success)
     return EXIT_FAILURE;
 
-  std::vector<std::string> expandedInputFiles;
-  result = expandInputFilenames(InFiles, expandedInputFiles);
-  if (result != Result::Success)
-    return EXIT_FAILURE;
+  if (ServerMode) {
+    result = runServer(compiler);
+    return result == Result::Success ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
 
-  auto inputSpecsOrErr = parseAndCollectInputFileSpecs(expandedInputFiles);
-  if (Error err = inputSpecsOrErr.takeError()) {
-    result = reportError(std::move(err));
+  if (InFiles.empty()) {
+    LLPC_ERRS("No input files\n");
+    result = Result::ErrorInvalidValue;
     return EXIT_FAILURE;
   }
 
-  auto inputGroupsOrErr = groupInputSpecs(*inputSpecsOrErr);
-  if (Error err = inputGroupsOrErr.takeError()) {
-    result = reportError(std::move(err));
+  if (ReplayBenchmark) {
+    if (Error err = runReplayBenchmark(compiler)) {
+      result = reportError(std::move(err));
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (VerifyDeterministicOutput && SeedShaderCache) {
+    LLPC_ERRS("-verify-deterministic-output is not available with -seed-shader-cache\n");
+    result = Result::Unsupported;
     return EXIT_FAILURE;
   }
 
-  if (Error err = parallelFor(NumThreads, *inputGroupsOrErr,
-                              [compiler](InputSpecGroup &inputGroup) { return processInputs(compiler, inputGroup); })) {
+  CompiledElfs compiledElfs;
+  CompiledElfs *compiledElfsToVerify = VerifyDeterministicOutput ? &compiledElfs : nullptr;
+  if (Error err = processInputFiles(compiler, InFiles, OutFile, NumThreads, compiledElfsToVerify)) {
     result = reportError(std::move(err));
     return EXIT_FAILURE;
   }
 
+  if (VerifyDeterministicOutput) {
+    if (Error err = verifyDeterministicOutput(argc, argv, compiledElfs)) {
+      result = reportError(std::move(err));
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (SeedShaderCache) {
+    outs() << "LLPC SeedShaderCache: pipelines=" << SeedShaderCacheStats.pipelines
+           << " compiled-stages=" << SeedShaderCacheStats.compiledStages
+           << " cached-stages=" << SeedShaderCacheStats.cachedStages
+           << " unseeded-pipelines=" << SeedShaderCacheStats.unseededPipelines << "\n";
+  }
+
   assert(result == Result::Success);
   return EXIT_SUCCESS;
 }
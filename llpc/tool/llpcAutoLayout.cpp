@@ -42,6 +42,7 @@
 #include "llpcDebug.h"
 #include "llpcUtil.h"
 #include "vfx.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Format.h"
 
 #define DEBUG_TYPE "llpc-auto-layout"
@@ -80,79 +81,68 @@ static unsigned getTypeDataSize(const SPIRVType *ty) {
   }
 }
 
+// Index from {set,binding} to the position of the first node with them in a node array
+typedef DenseMap<std::pair<unsigned, unsigned>, unsigned> ResourceNodeIndex;
+
 // =====================================================================================================================
-// Find VaPtr userDataNode with the specified set.
+// Build the index of the VaPtr userDataNodes by the set of their first inner node.
 //
 // @param resourceMapping : Resource mapping data, possibly containing user data nodes
-// @param set : According this set to find ResourceMappingNode
-// @returns : userDataNode with the specified set
-static const ResourceMappingRootNode *findDescriptorTableVaPtr(const ResourceMappingData *resourceMapping,
-                                                               unsigned set) {
-  const ResourceMappingRootNode *descriptorTableVaPtr = nullptr;
+// @returns : The first VaPtr userDataNode with each set
+static DenseMap<unsigned, const ResourceMappingRootNode *>
+buildDescriptorTableVaPtrIndex(const ResourceMappingData *resourceMapping) {
+  DenseMap<unsigned, const ResourceMappingRootNode *> descriptorTableVaPtrs;
 
   for (unsigned k = 0; k < resourceMapping->userDataNodeCount; ++k) {
     const ResourceMappingRootNode *userDataNode = &resourceMapping->pUserDataNodes[k];
 
-    if (userDataNode->node.type == Llpc::ResourceMappingNodeType::DescriptorTableVaPtr) {
-      if (userDataNode->node.tablePtr.pNext[0].srdRange.set == set) {
-        descriptorTableVaPtr = userDataNode;
-        break;
-      }
-    }
+    if (userDataNode->node.type == Llpc::ResourceMappingNodeType::DescriptorTableVaPtr)
+      descriptorTableVaPtrs.try_emplace(userDataNode->node.tablePtr.pNext[0].srdRange.set, userDataNode);
   }
 
-  return descriptorTableVaPtr;
+  return descriptorTableVaPtrs;
 }
 
 // =====================================================================================================================
-// Find userDataNode with specified set and binding. And return Node index.
+// Build the index of a node array by set and binding.
 //
 // @param userDataNode : ResourceMappingNode pointer
 // @param nodeCount : User data node count
-// @param set : Find same set in node array
-// @param binding : Find same binding in node array
-// @param [out] index : Return node position in node array
-static const ResourceMappingNode *findResourceNode(const ResourceMappingNode *userDataNode, unsigned nodeCount,
-                                                   unsigned set, unsigned binding, unsigned *index) {
-  const ResourceMappingNode *resourceNode = nullptr;
-
-  for (unsigned j = 0; j < nodeCount; ++j) {
-    const ResourceMappingNode *next = &userDataNode[j];
-
-    if (set == next->srdRange.set && binding == next->srdRange.binding) {
-      resourceNode = next;
-      *index = j;
-      break;
-    }
-  }
-
-  return resourceNode;
+// @returns : The position of the first node with each set and binding
+static ResourceNodeIndex buildResourceNodeIndex(const ResourceMappingNode *userDataNode, unsigned nodeCount) {
+  ResourceNodeIndex nodeIndex;
+  for (unsigned j = 0; j < nodeCount; ++j)
+    nodeIndex.try_emplace({userDataNode[j].srdRange.set, userDataNode[j].srdRange.binding}, j);
+  return nodeIndex;
 }
 
 // =====================================================================================================================
-// Find userDataNode with specified set and binding. And return Node index.
+// Build the index of a root node array by set and binding.
 //
 // @param userDataNode : ResourceMappingRootNode pointer
 // @param nodeCount : User data node count
+// @returns : The position of the first node with each set and binding
+static ResourceNodeIndex buildResourceNodeIndex(const ResourceMappingRootNode *userDataNode, unsigned nodeCount) {
+  ResourceNodeIndex nodeIndex;
+  for (unsigned j = 0; j < nodeCount; ++j)
+    nodeIndex.try_emplace({userDataNode[j].node.srdRange.set, userDataNode[j].node.srdRange.binding}, j);
+  return nodeIndex;
+}
+
+// =====================================================================================================================
+// Find userDataNode with specified set and binding. And return Node index.
+//
+// @param nodeIndex : Index of the node array by set and binding
 // @param set : Find same set in node array
 // @param binding : Find same binding in node array
 // @param [out] index : Return node position in node array
-// @returns : The Node index
-static const ResourceMappingRootNode *findResourceNode(const ResourceMappingRootNode *userDataNode, unsigned nodeCount,
-                                                       unsigned set, unsigned binding, unsigned *index) {
-  const ResourceMappingRootNode *resourceNode = nullptr;
-
-  for (unsigned j = 0; j < nodeCount; ++j) {
-    const ResourceMappingRootNode *next = &userDataNode[j];
-
-    if (set == next->node.srdRange.set && binding == next->node.srdRange.binding) {
-      resourceNode = next;
-      *index = j;
-      break;
-    }
-  }
-
-  return resourceNode;
+// @returns : Whether a node was found
+static bool findResourceNode(const ResourceNodeIndex &nodeIndex, unsigned set, unsigned binding, unsigned *index) {
+  auto it = nodeIndex.find({set, binding});
+  if (it == nodeIndex.end())
+    return false;
+  *index = it->second;
+  return true;
 }
 
 // =====================================================================================================================
@@ -171,23 +161,36 @@ bool checkResourceMappingCompatible(const ResourceMappingData *resourceMapping,
   else if (resourceMapping->pStaticDescriptorValues)
     hit = false;
   else if (resourceMapping->userDataNodeCount >= autoLayoutUserDataNodeCount) {
+    // Index the user data nodes once, rather than scanning them for each node of the auto layout.
+    auto descriptorTableVaPtrs = buildDescriptorTableVaPtrIndex(resourceMapping);
+    ResourceNodeIndex rootNodeIndex =
+        buildResourceNodeIndex(resourceMapping->pUserDataNodes, resourceMapping->userDataNodeCount);
+    DenseMap<const ResourceMappingRootNode *, ResourceNodeIndex> innerNodeIndices;
+
     for (unsigned n = 0; n < autoLayoutUserDataNodeCount; ++n) {
       const ResourceMappingRootNode *autoLayoutUserDataNode = &autoLayoutUserDataNodes[n];
 
       // Multiple levels
       if (autoLayoutUserDataNode->node.type == Llpc::ResourceMappingNodeType::DescriptorTableVaPtr) {
         unsigned set = autoLayoutUserDataNode->node.tablePtr.pNext[0].srdRange.set;
-        const ResourceMappingRootNode *userDataNode = findDescriptorTableVaPtr(resourceMapping, set);
+        auto tableIt = descriptorTableVaPtrs.find(set);
+        const ResourceMappingRootNode *userDataNode =
+            tableIt != descriptorTableVaPtrs.end() ? tableIt->second : nullptr;
 
         if (userDataNode) {
+          ResourceNodeIndex &innerNodeIndex = innerNodeIndices[userDataNode];
+          if (innerNodeIndex.empty())
+            innerNodeIndex =
+                buildResourceNodeIndex(userDataNode->node.tablePtr.pNext, userDataNode->node.tablePtr.nodeCount);
           bool hitNode = false;
           for (unsigned i = 0; i < autoLayoutUserDataNode->node.tablePtr.nodeCount; ++i) {
             const ResourceMappingNode *autoLayoutNext = &autoLayoutUserDataNode->node.tablePtr.pNext[i];
 
             unsigned index = 0;
-            const ResourceMappingNode *node =
-                findResourceNode(userDataNode->node.tablePtr.pNext, userDataNode->node.tablePtr.nodeCount,
-                                 autoLayoutNext->srdRange.set, autoLayoutNext->srdRange.binding, &index);
+            const ResourceMappingNode *node = nullptr;
+            if (findResourceNode(innerNodeIndex, autoLayoutNext->srdRange.set, autoLayoutNext->srdRange.binding,
+                                 &index))
+              node = &userDataNode->node.tablePtr.pNext[index];
 
             if (node) {
               if (autoLayoutNext->type == node->type && autoLayoutNext->sizeInDwords == node->sizeInDwords &&
@@ -227,9 +230,10 @@ bool checkResourceMappingCompatible(const ResourceMappingData *resourceMapping,
       // Single level
       else {
         unsigned index = 0;
-        const ResourceMappingRootNode *node = findResourceNode(
-            resourceMapping->pUserDataNodes, resourceMapping->userDataNodeCount,
-            autoLayoutUserDataNode->node.srdRange.set, autoLayoutUserDataNode->node.srdRange.binding, &index);
+        const ResourceMappingRootNode *node = nullptr;
+        if (findResourceNode(rootNodeIndex, autoLayoutUserDataNode->node.srdRange.set,
+                             autoLayoutUserDataNode->node.srdRange.binding, &index))
+          node = &resourceMapping->pUserDataNodes[index];
         if (node && autoLayoutUserDataNode->node.sizeInDwords == node->node.sizeInDwords) {
           hit = true;
           continue;
@@ -302,8 +306,7 @@ void doAutoLayoutDesc(ShaderStage shaderStage, BinaryData spirvBin, GraphicsPipe
                       PipelineShaderInfo *shaderInfo, ResourceMappingNodeMap &resNodeSets, unsigned &pushConstSize,
                       bool autoLayoutDesc) {
   // Read the SPIR-V.
-  std::string spirvCode(static_cast<const char *>(spirvBin.pCode), spirvBin.codeSize);
-  std::istringstream spirvStream(spirvCode);
+  SPIRVInputStream spirvStream(spirvBin.pCode, spirvBin.codeSize);
   std::unique_ptr<SPIRVModule> module(SPIRVModule::createSPIRVModule());
   spirvStream >> *module;
 
@@ -0,0 +1,120 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcCachePacker.cpp
+ * @brief LLPC source file: contains implementation of the tool that packs shader cache files for shipping.
+ *
+ * The tool verifies and merges shader cache files, such as the on-disk caches filled by amdllpc -seed-shader-cache,
+ * and writes them as one file with the entries sorted by key, identical shader data stored once, and optionally the
+ * shader data compressed. The packed file can be loaded by the on-disk cache of the same build of LLPC, including in
+ * read-only mode.
+ ***********************************************************************************************************************
+ */
+#include "llpcShaderCache.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib> // EXIT_FAILURE, EXIT_SUCCESS
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+using namespace Llpc;
+
+namespace {
+// -<input files>: shader cache files to pack
+cl::list<std::string> InFiles(cl::Positional, cl::OneOrMore, cl::desc("<shader cache files>"));
+
+// -o: output file
+cl::opt<std::string> OutFile("o", cl::desc("Output shader cache file"), cl::value_desc("filename"));
+
+// -compress: compress the shader data that is not compressed yet
+cl::opt<bool> Compress("compress", cl::desc("Compress the shader data with LZ4 (default: true)"), cl::init(true));
+
+// -verify: only verify the input files
+cl::opt<bool> VerifyOnly("verify", cl::desc("Only verify that the input files can be loaded, without writing a file"),
+                         cl::init(false));
+} // anonymous namespace
+
+// =====================================================================================================================
+// Main function of the shader cache packer, entry-point.
+//
+// @param argc : Count of arguments
+// @param argv : List of arguments
+// @returns : 0 if successful, other numeric values on failure
+int main(int argc, char *argv[]) {
+  InitLLVM initLlvm(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "LLPC shader cache packer\n");
+
+  if (!VerifyOnly && OutFile.empty()) {
+    errs() << "No output file, use -o\n";
+    return EXIT_FAILURE;
+  }
+
+  // The caches are created with the graphics IP and options hash of the first file, and a file that differs from it
+  // in those, or in the build of LLPC, fails to load.
+  BuildUniqueId buildId = {};
+  if (ShaderCache::readFileBuildId(InFiles.front().c_str(), &buildId) != Result::Success) {
+    errs() << "Failed to read shader cache file: " << InFiles.front() << "\n";
+    return EXIT_FAILURE;
+  }
+  ShaderCacheCreateInfo createInfo = {};
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = buildId.gfxIp;
+  auxCreateInfo.hash = buildId.hash;
+
+  std::vector<std::unique_ptr<ShaderCache>> srcCaches;
+  for (const std::string &inFile : InFiles) {
+    auto srcCache = std::make_unique<ShaderCache>();
+    if (srcCache->init(&createInfo, &auxCreateInfo) != Result::Success ||
+        srcCache->loadFile(inFile.c_str()) != Result::Success) {
+      errs() << "Shader cache file is corrupted or was not written by this build of LLPC: " << inFile << "\n";
+      return EXIT_FAILURE;
+    }
+    srcCaches.push_back(std::move(srcCache));
+  }
+  if (VerifyOnly) {
+    outs() << "Verified " << srcCaches.size() << " shader cache files\n";
+    return EXIT_SUCCESS;
+  }
+
+  ShaderCache packedCache;
+  std::vector<const IShaderCache *> mergedCaches;
+  for (const std::unique_ptr<ShaderCache> &srcCache : srcCaches)
+    mergedCaches.push_back(srcCache.get());
+  ShaderCachePackStats stats = {};
+  if (packedCache.init(&createInfo, &auxCreateInfo) != Result::Success ||
+      packedCache.Merge(mergedCaches.size(), mergedCaches.data()) != Result::Success ||
+      packedCache.writePackedFile(OutFile.c_str(), Compress, &stats) != Result::Success) {
+    errs() << "Failed to write shader cache file: " << OutFile << "\n";
+    return EXIT_FAILURE;
+  }
+
+  outs() << "Packed " << stats.shaderCount << " shaders (" << stats.referenceCount << " shared, "
+         << stats.compressedCount << " compressed) into " << OutFile << ", " << stats.fileSize << " bytes\n";
+  return EXIT_SUCCESS;
+}
@@ -67,11 +67,16 @@
 #include "llpcThreading.h"
 #include "llpcUtil.h"
 #include "vkgcElfReader.h"
+#include "vkgcPipelineDumper.h"
 #include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -90,6 +95,9 @@ using namespace Vkgc;
 namespace Llpc {
 namespace StandaloneCompiler {
 
+// Version of the GLSL cache entries, to be bumped when the way amdllpc compiles GLSL changes
+static constexpr int GlslCacheVersion = 1;
+
 // =====================================================================================================================
 // Callback function to allocate buffer for building shader module and building pipeline.
 //
@@ -115,8 +123,8 @@ void *VKAPI_CALL allocateBuffer(void *instance, void *userData, size_t size) {
 void cleanupCompileInfo(CompileInfo *compileInfo) {
   for (unsigned i = 0; i < compileInfo->shaderModuleDatas.size(); ++i) {
     // NOTE: We do not have to free SPIR-V binary for pipeline info file.
-    // It will be freed when we close the VFX doc.
-    if (!compileInfo->pipelineInfoFile)
+    // It will be freed when we close the VFX doc, or with the pipeline info binary.
+    if (!compileInfo->pipelineInfoFile && !compileInfo->pipelineInfoBinary)
       delete[] reinterpret_cast<const char *>(compileInfo->shaderModuleDatas[i].spirvBin.pCode);
 
     free(compileInfo->shaderModuleDatas[i].shaderBuf);
@@ -126,6 +134,7 @@ void cleanupCompileInfo(CompileInfo *compileInfo) {
 
   if (compileInfo->pipelineInfoFile)
     Vfx::vfxCloseDoc(compileInfo->pipelineInfoFile);
+  delete compileInfo->pipelineInfoBinary;
 }
 
 // =====================================================================================================================
@@ -152,15 +161,98 @@ static ShaderStage sourceLangToShaderStage(SpvGenStage sourceLang) {
   }
 }
 
+// =====================================================================================================================
+// Gets the path of the GLSL cache entry for the SPIR-V of a GLSL or HLSL source, which is named after a hash of
+// everything that SPVGEN's output depends on: the source text, its file name (which goes into the debug info), the
+// shader stage, the compile options, the entry point and the versions of SPVGEN and glslang.
+//
+// @param cacheDir : Directory of the GLSL cache
+// @param fileName : Name of the source file
+// @param source : Source text
+// @param lang : Shader stage of the source
+// @param compileOption : SPVGEN compile options
+// @param entryPoint : Entry point name
+// @returns : Path of the cache entry
+static std::string getGlslCachePath(StringRef cacheDir, StringRef fileName, StringRef source, SpvGenStage lang,
+                                    int compileOption, StringRef entryPoint) {
+  unsigned versions[4] = {};
+  spvGetVersion(SpvGenVersionSpvGen, &versions[0], &versions[1]);
+  spvGetVersion(SpvGenVersionGlslang, &versions[2], &versions[3]);
+  int params[] = {GlslCacheVersion, lang, compileOption};
+
+  SHA256 hasher;
+  hasher.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(versions), sizeof(versions)));
+  hasher.update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(params), sizeof(params)));
+  hasher.update(entryPoint);
+  hasher.update(StringRef("", 1));
+  hasher.update(fileName);
+  hasher.update(StringRef("", 1));
+  hasher.update(source);
+
+  SmallString<256> path(cacheDir);
+  sys::path::append(path, toHex(hasher.final(), /*LowerCase=*/true) + ".spv");
+  return path.str().str();
+}
+
+// =====================================================================================================================
+// Reads the SPIR-V of a GLSL cache entry. An entry that is missing, or is not a SPIR-V binary, is a cache miss.
+//
+// @param path : Path of the cache entry
+// @param [out] spirv : SPIR-V binary, allocated with new[] as by compileGlsl
+// @returns : True on a cache hit
+static bool readGlslCacheEntry(const std::string &path, BinaryData &spirv) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> bufferOrErr =
+      MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!bufferOrErr)
+    return false;
+  StringRef data = (*bufferOrErr)->getBuffer();
+  if (data.size() < sizeof(unsigned) || data.size() % sizeof(unsigned) != 0 ||
+      *reinterpret_cast<const unsigned *>(data.data()) != spv::MagicNumber)
+    return false;
+
+  char *bin = new char[data.size()];
+  memcpy(bin, data.data(), data.size());
+  spirv = {data.size(), bin};
+  return true;
+}
+
+// =====================================================================================================================
+// Writes the SPIR-V of a GLSL cache entry. The entry is written to a temporary file that is then renamed, so that an
+// amdllpc running at the same time never reads a partly written entry. A failure to write only loses the entry.
+//
+// @param path : Path of the cache entry
+// @param spirv : SPIR-V binary
+static void writeGlslCacheEntry(const std::string &path, const BinaryData &spirv) {
+  if (sys::fs::create_directories(sys::path::parent_path(path)))
+    return;
+  int fd = -1;
+  SmallString<256> tempPath;
+  if (sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tempPath))
+    return;
+  {
+    raw_fd_ostream tempFile(fd, /*shouldClose=*/true);
+    tempFile.write(static_cast<const char *>(spirv.pCode), spirv.codeSize);
+    tempFile.close();
+    if (tempFile.has_error()) {
+      tempFile.clear_error();
+      sys::fs::remove(tempPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(tempPath, path))
+    sys::fs::remove(tempPath);
+}
+
 // =====================================================================================================================
 // GLSL compiler, compiles GLSL source text file (input) to SPIR-V binary file (output).
 //
 // @param inFilename : Input filename, GLSL source text
 // @param [out] stage : Shader stage
 // @param defaultEntryTarget : Default shader entry point name
+// @param glslCacheDir : Directory of the on-disk cache of the SPIR-V compiled from GLSL, or empty for no cache
 // @returns : BinaryData object of the output SPIR-V binary on success, `ResultError` on failure
 Expected<BinaryData> compileGlsl(const std::string &inFilename, ShaderStage *stage,
-                                 const std::string &defaultEntryTarget) {
+                                 const std::string &defaultEntryTarget, StringRef glslCacheDir) {
   if (!InitSpvGen())
     return createResultError(Result::ErrorUnavailable, "Failed to load SPVGEN -- cannot compile GLSL");
 
@@ -197,42 +289,60 @@ Expected<BinaryData> compileGlsl(const std::string &inFilename, ShaderStage *sta
   LLPC_OUTS(glslText);
   LLPC_OUTS("\n\n");
 
-  int sourceStringCount = 1;
-  const char *const *sourceList[1] = {};
-  const char *fileName = inFilename.c_str();
-  const char *const *fileList[1] = {&fileName};
-  sourceList[0] = &glslText;
-
-  void *program = nullptr;
-  const char *log = nullptr;
   int compileOption = SpvGenOptionDefaultDesktop | SpvGenOptionVulkanRules | SpvGenOptionDebug;
   compileOption |= isHlsl ? SpvGenOptionReadHlsl : 0;
-  const char *entryPoints[] = {defaultEntryTarget.c_str()};
-  bool compileResult = spvCompileAndLinkProgramEx(1, &lang, &sourceStringCount, sourceList, fileList,
-                                                  isHlsl ? entryPoints : nullptr, &program, &log, compileOption);
 
-  LLPC_OUTS("// GLSL program compile/link log\n");
-
-  if (!compileResult)
-    return createResultError(Result::ErrorInvalidShader,
-                             Twine("Failed to compile GLSL input file:") + inFilename + "\n" + log);
-
-  const unsigned *spvBin = nullptr;
-  unsigned binSize = spvGetSpirvBinaryFromProgram(program, 0, &spvBin);
+  // The cache key does not cover the files that a source includes, so a source with #include is not cached.
+  std::string cachePath;
+  StringRef source(glslText, readSize);
+  if (!glslCacheDir.empty() && !source.contains("#include"))
+    cachePath = getGlslCachePath(glslCacheDir, inFilename, source, lang, compileOption, defaultEntryTarget);
 
   // We create / copy the binary blob to a new allocation. The caller is
   // responsible for calling delete[] (note: this will normally happen as part of
   // cleanupCompileInfo).
-  void *bin = new char[binSize]();
-  llvm::copy(llvm::make_range(spvBin, spvBin + binSize / sizeof(unsigned)), reinterpret_cast<unsigned *>(bin));
+  BinaryData spirv = {};
+  if (!cachePath.empty() && readGlslCacheEntry(cachePath, spirv)) {
+    LLPC_OUTS("// GLSL cache hit: " << cachePath << "\n");
+  } else {
+    int sourceStringCount = 1;
+    const char *const *sourceList[1] = {};
+    const char *fileName = inFilename.c_str();
+    const char *const *fileList[1] = {&fileName};
+    sourceList[0] = &glslText;
 
-  textSize = binSize * 10 + 1024;
-  std::vector<char> spvText(textSize, '\0');
-  LLPC_OUTS("\nSPIR-V disassembly:\n");
-  spvDisassembleSpirv(binSize, spvBin, textSize, spvText.data());
-  LLPC_OUTS(spvText.data() << "\n");
+    void *program = nullptr;
+    const char *log = nullptr;
+    const char *entryPoints[] = {defaultEntryTarget.c_str()};
+    bool compileResult = spvCompileAndLinkProgramEx(1, &lang, &sourceStringCount, sourceList, fileList,
+                                                    isHlsl ? entryPoints : nullptr, &program, &log, compileOption);
 
-  return BinaryData{static_cast<size_t>(binSize), bin};
+    LLPC_OUTS("// GLSL program compile/link log\n");
+
+    if (!compileResult)
+      return createResultError(Result::ErrorInvalidShader,
+                               Twine("Failed to compile GLSL input file:") + inFilename + "\n" + log);
+
+    const unsigned *spvBin = nullptr;
+    unsigned binSize = spvGetSpirvBinaryFromProgram(program, 0, &spvBin);
+
+    void *bin = new char[binSize]();
+    llvm::copy(llvm::make_range(spvBin, spvBin + binSize / sizeof(unsigned)), reinterpret_cast<unsigned *>(bin));
+    spirv = {static_cast<size_t>(binSize), bin};
+
+    if (!cachePath.empty())
+      writeGlslCacheEntry(cachePath, spirv);
+  }
+
+  if (EnableOuts()) {
+    textSize = spirv.codeSize * 10 + 1024;
+    std::vector<char> spvText(textSize, '\0');
+    LLPC_OUTS("\nSPIR-V disassembly:\n");
+    spvDisassembleSpirv(spirv.codeSize, static_cast<const unsigned *>(spirv.pCode), textSize, spvText.data());
+    LLPC_OUTS(spvText.data() << "\n");
+  }
+
+  return spirv;
 }
 
 // =====================================================================================================================
@@ -349,7 +459,32 @@ Error outputElf(CompileInfo *compileInfo, const std::string &suppliedOutFile, St
 }
 
 // =====================================================================================================================
-// Process one pipeline input file.
+// Reads a pipeline info binary file (.pipebin), and decodes it in place, without parsing it. The decoded pipeline
+// info points into the buffer of the file, which is kept in the compilation info.
+//
+// @param [in/out] compileInfo : Compilation info of LLPC standalone tool
+// @param inFile : Name of the pipeline info binary file
+// @param [out] infoBinary : Decoded pipeline info
+// @returns : `ErrorSuccess` on success, `ResultError` on failure
+static Error readPipelineInfoBinary(CompileInfo &compileInfo, const std::string &inFile,
+                                    PipelineInfoBinary &infoBinary) {
+  ErrorOr<std::unique_ptr<WritableMemoryBuffer>> bufferOrErr = WritableMemoryBuffer::getFile(inFile);
+  if (std::error_code errCode = bufferOrErr.getError())
+    return createResultError(Result::ErrorUnavailable, Twine("Failed to read input file: ") + inFile + ": " +
+                                                           errCode.message());
+  compileInfo.pipelineInfoBinary = bufferOrErr->release();
+
+  std::string errMsg;
+  if (!PipelineDumper::decodePipelineInfoBinary(compileInfo.pipelineInfoBinary->getBufferStart(),
+                                                compileInfo.pipelineInfoBinary->getBufferSize(), &infoBinary,
+                                                &errMsg))
+    return createResultError(Result::ErrorInvalidShader, Twine("Failed to decode input file: ") + inFile + "\n" +
+                                                             errMsg);
+  return Error::success();
+}
+
+// =====================================================================================================================
+// Process one pipeline input file (.pipe or .pipebin).
 //
 // @param compiler : LLPC compiler
 // @param inputSpec : Input specification
@@ -360,19 +495,26 @@ Error processInputPipeline(ICompiler *compiler, CompileInfo &compileInfo, const
                            bool ignoreColorAttachmentFormats) {
   const std::string &inFile = inputSpec.filename;
   const char *log = nullptr;
-  const bool vfxResult =
-      Vfx::vfxParseFile(inFile.c_str(), 0, nullptr, VfxDocTypePipeline, &compileInfo.pipelineInfoFile, &log);
-  if (!vfxResult)
-    return createResultError(Result::ErrorInvalidShader, Twine("Failed to parse input file: ") + inFile + "\n" + log);
-
   VfxPipelineStatePtr pipelineState = nullptr;
-  Vfx::vfxGetPipelineDoc(compileInfo.pipelineInfoFile, &pipelineState);
-
-  if (pipelineState->version != Vkgc::Version) {
-    std::string errMsg;
-    raw_string_ostream os(errMsg);
-    os << "Version incompatible, SPVGEN::Version = " << pipelineState->version << " LLPC::Version = " << Vkgc::Version;
-    return createResultError(Result::ErrorInvalidShader, os.str());
+  PipelineInfoBinary infoBinary = {};
+  if (isPipelineInfoBinaryFile(inFile)) {
+    if (Error err = readPipelineInfoBinary(compileInfo, inFile, infoBinary))
+      return err;
+  } else {
+    const bool vfxResult =
+        Vfx::vfxParseFile(inFile.c_str(), 0, nullptr, VfxDocTypePipeline, &compileInfo.pipelineInfoFile, &log);
+    if (!vfxResult)
+      return createResultError(Result::ErrorInvalidShader, Twine("Failed to parse input file: ") + inFile + "\n" + log);
+
+    Vfx::vfxGetPipelineDoc(compileInfo.pipelineInfoFile, &pipelineState);
+
+    if (pipelineState->version != Vkgc::Version) {
+      std::string errMsg;
+      raw_string_ostream os(errMsg);
+      os << "Version incompatible, SPVGEN::Version = " << pipelineState->version
+         << " LLPC::Version = " << Vkgc::Version;
+      return createResultError(Result::ErrorInvalidShader, os.str());
+    }
   }
 
   LLPC_OUTS("===============================================================================\n");
@@ -381,8 +523,26 @@ Error processInputPipeline(ICompiler *compiler, CompileInfo &compileInfo, const
   if (log && strlen(log) > 0)
     LLPC_OUTS("Pipeline file parse warning:\n" << log << "\n");
 
-  compileInfo.compPipelineInfo = pipelineState->compPipelineInfo;
-  compileInfo.gfxPipelineInfo = pipelineState->gfxPipelineInfo;
+  // The SPIR-V binary of each shader stage, by stage
+  SmallVector<std::pair<ShaderStage, BinaryData>, ShaderStageCount> stageSpirvBins;
+  if (pipelineState) {
+    compileInfo.compPipelineInfo = pipelineState->compPipelineInfo;
+    compileInfo.gfxPipelineInfo = pipelineState->gfxPipelineInfo;
+    for (unsigned stage = 0; stage < pipelineState->numStages; ++stage) {
+      if (pipelineState->stages[stage].dataSize > 0) {
+        BinaryData spirvBin = {pipelineState->stages[stage].dataSize, pipelineState->stages[stage].pData};
+        stageSpirvBins.push_back({pipelineState->stages[stage].stage, spirvBin});
+      }
+    }
+  } else {
+    if (infoBinary.pComputeInfo)
+      compileInfo.compPipelineInfo = *infoBinary.pComputeInfo;
+    else
+      compileInfo.gfxPipelineInfo = *infoBinary.pGraphicsInfo;
+    for (unsigned stage = 0; stage < infoBinary.stageCount; ++stage)
+      stageSpirvBins.push_back({infoBinary.stages[stage].stage, infoBinary.stages[stage].spirvBin});
+  }
+
   if (ignoreColorAttachmentFormats) {
     // NOTE: When this option is enabled, we set color attachment format to
     // R8G8B8A8_SRGB for color target 0. Also, for other color targets, if the
@@ -396,25 +556,21 @@ Error processInputPipeline(ICompiler *compiler, CompileInfo &compileInfo, const
   if (EnableOuts() && !InitSpvGen())
     LLPC_OUTS("Failed to load SPVGEN -- cannot disassemble and validate SPIR-V\n");
 
-  for (unsigned stage = 0; stage < pipelineState->numStages; ++stage) {
-    if (pipelineState->stages[stage].dataSize > 0) {
-      StandaloneCompiler::ShaderModuleData shaderModuleData = {};
-      shaderModuleData.spirvBin.codeSize = pipelineState->stages[stage].dataSize;
-      shaderModuleData.spirvBin.pCode = pipelineState->stages[stage].pData;
-      shaderModuleData.shaderStage = pipelineState->stages[stage].stage;
-
-      compileInfo.shaderModuleDatas.push_back(shaderModuleData);
-      compileInfo.stageMask |= shaderStageToMask(pipelineState->stages[stage].stage);
-
-      if (spvDisassembleSpirv) {
-        unsigned binSize = pipelineState->stages[stage].dataSize;
-        unsigned textSize = binSize * 10 + 1024;
-        LLPC_OUTS("\nSPIR-V disassembly for " << getShaderStageName(pipelineState->stages[stage].stage)
-                                              << " shader module:\n");
-        std::vector<char> spvText(textSize);
-        spvDisassembleSpirv(binSize, shaderModuleData.spirvBin.pCode, textSize, spvText.data());
-        LLPC_OUTS(spvText.data() << "\n");
-      }
+  for (const auto &stageSpirvBin : stageSpirvBins) {
+    StandaloneCompiler::ShaderModuleData shaderModuleData = {};
+    shaderModuleData.spirvBin = stageSpirvBin.second;
+    shaderModuleData.shaderStage = stageSpirvBin.first;
+
+    compileInfo.shaderModuleDatas.push_back(shaderModuleData);
+    compileInfo.stageMask |= shaderStageToMask(stageSpirvBin.first);
+
+    if (spvDisassembleSpirv) {
+      unsigned binSize = stageSpirvBin.second.codeSize;
+      unsigned textSize = binSize * 10 + 1024;
+      LLPC_OUTS("\nSPIR-V disassembly for " << getShaderStageName(stageSpirvBin.first) << " shader module:\n");
+      std::vector<char> spvText(textSize);
+      spvDisassembleSpirv(binSize, shaderModuleData.spirvBin.pCode, textSize, spvText.data());
+      LLPC_OUTS(spvText.data() << "\n");
     }
   }
 
@@ -550,13 +706,14 @@ static Expected<ShaderModuleData> processInputLlvmIrStage(const InputSpec &llvmI
 // Processes a single GLSL input file. Translates the source to a SPIR-V binary.
 //
 // @param glslInput : Input specification
+// @param glslCacheDir : Directory of the on-disk cache of the SPIR-V compiled from GLSL, or empty for no cache
 // @returns : `ShaderModuleData` on success, `ResultError` on failure
-static Expected<ShaderModuleData> processInputGlslStage(const InputSpec &glslInput) {
+static Expected<ShaderModuleData> processInputGlslStage(const InputSpec &glslInput, StringRef glslCacheDir) {
   assert(isGlslShaderTextFile(glslInput.filename));
   // Note: If the entry target is not specified, we set it to the GLSL default.
   const std::string entryPoint = glslInput.entryPoint.empty() ? "main" : glslInput.entryPoint;
   ShaderStage stage = ShaderStageInvalid;
-  auto spvBinOrErr = compileGlsl(glslInput.filename, &stage, entryPoint);
+  auto spvBinOrErr = compileGlsl(glslInput.filename, &stage, entryPoint, glslCacheDir);
   if (Error err = spvBinOrErr.takeError())
     return std::move(err);
 
@@ -574,8 +731,10 @@ static Expected<ShaderModuleData> processInputGlslStage(const InputSpec &glslInp
 //
 // @param inputSpec : Input specification
 // @param validateSpirv : Whether to run the validator on each final SPIR-V module
+// @param glslCacheDir : Directory of the on-disk cache of the SPIR-V compiled from GLSL, or empty for no cache
 // @returns : `ShaderModuleData` on success, `ResultError` on failure
-static Expected<ShaderModuleData> processInputStage(const InputSpec &inputSpec, bool validateSpirv) {
+static Expected<ShaderModuleData> processInputStage(const InputSpec &inputSpec, bool validateSpirv,
+                                                    StringRef glslCacheDir) {
   const std::string &inFile = inputSpec.filename;
 
   if (isSpirvTextFile(inFile) || isSpirvBinaryFile(inFile))
@@ -585,7 +744,7 @@ static Expected<ShaderModuleData> processInputStage(const InputSpec &inputSpec,
     return processInputLlvmIrStage(inputSpec);
 
   if (isGlslShaderTextFile(inFile))
-    return processInputGlslStage(inputSpec);
+    return processInputGlslStage(inputSpec, glslCacheDir);
 
   return createResultError(Result::ErrorInvalidShader,
                            Twine("File ") + inFile +
@@ -600,13 +759,14 @@ static Expected<ShaderModuleData> processInputStage(const InputSpec &inputSpec,
 // @param inputSpec : Input specifications
 // @param validateSpirv : Whether to run the validator on each final SPIR-V module
 // @param numThreads : Number of CPU threads to use to process stages, where 0 means all logical cores
+// @param glslCacheDir : Directory of the on-disk cache of the SPIR-V compiled from GLSL, or empty for no cache
 // @returns : `ErrorSuccess` on success, `ResultError` on failure
 Error processInputStages(CompileInfo &compileInfo, ArrayRef<InputSpec> inputSpecs, bool validateSpirv,
-                         unsigned numThreads) {
+                         unsigned numThreads, StringRef glslCacheDir) {
   std::mutex compileInfoMutex;
 
   return parallelFor(numThreads, inputSpecs, [&](const InputSpec &inputSpec) -> Error {
-    auto dataOrErr = processInputStage(inputSpec, validateSpirv);
+    auto dataOrErr = processInputStage(inputSpec, validateSpirv, glslCacheDir);
     if (Error err = dataOrErr.takeError())
       return err;
 
@@ -61,6 +61,10 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
 
+namespace llvm {
+class WritableMemoryBuffer;
+} // namespace llvm
+
 namespace Llpc {
 namespace StandaloneCompiler {
 
@@ -88,6 +92,7 @@ struct CompileInfo {
   Llpc::ComputePipelineBuildOut compPipelineOut;                             // Output of building compute pipeline
   void *pipelineBuf;                                                         // Allocation buffer of building pipeline
   void *pipelineInfoFile;                                                    // VFX-style file containing pipeline info
+  llvm::WritableMemoryBuffer *pipelineInfoBinary; // Decoded pipeline info binary that the pipeline info points into
   bool unlinked;                  // Whether to generate unlinked shader/part-pipeline ELF
   bool relocatableShaderElf;      // Whether to enable relocatable shader compilation
   bool scalarBlockLayout;         // Whether to enable scalar block layout
@@ -105,7 +110,7 @@ void cleanupCompileInfo(CompileInfo *compileInfo);
 
 // GLSL compiler, compiles GLSL source text file (input) to SPIR-V BinaryData object (output).
 llvm::Expected<BinaryData> compileGlsl(const std::string &inFilename, ShaderStage *stage,
-                                       const std::string &defaultEntryTarget);
+                                       const std::string &defaultEntryTarget, llvm::StringRef glslCacheDir);
 
 // SPIR-V assembler, converts SPIR-V assembly text file (input) to SPIR-V BinaryData object (output).
 llvm::Expected<BinaryData> assembleSpirv(const std::string &inFilename);
@@ -125,7 +130,7 @@ llvm::Error processInputPipeline(ICompiler *compiler, CompileInfo &compileInfo,
 
 // Processes and compiles multiple shader stage input files.
 llvm::Error processInputStages(CompileInfo &compileInfo, llvm::ArrayRef<InputSpec> inputSpecs, bool validateSpirv,
-                               unsigned numThreads);
+                               unsigned numThreads, llvm::StringRef glslCacheDir);
 
 } // namespace StandaloneCompiler
 } // namespace Llpc
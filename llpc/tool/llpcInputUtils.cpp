@@ -250,12 +250,23 @@ bool isLlvmIrFile(StringRef fileName) {
 }
 
 // =====================================================================================================================
-// Checks whether the specified file name represents an LLPC pipeline info file (.pipe).
+// Checks whether the specified file name represents an LLPC pipeline info file (.pipe), or the binary encoding of one
+// (.pipebin).
 //
 // @param fileName : File path to check
 // @returns : true when `fileName` is a pipeline info file
 bool isPipelineInfoFile(StringRef fileName) {
-  return fileName.endswith(Ext::PipelineInfo);
+  return fileName.endswith(Ext::PipelineInfo) || isPipelineInfoBinaryFile(fileName);
+}
+
+// =====================================================================================================================
+// Checks whether the specified file name represents an LLPC pipeline info binary file (.pipebin), as written by the
+// pipeline dumper with -dump-pipeline-info-binary.
+//
+// @param fileName : File path to check
+// @returns : true when `fileName` is a pipeline info binary file
+bool isPipelineInfoBinaryFile(StringRef fileName) {
+  return fileName.endswith(Ext::PipelineInfoBinary);
 }
 
 // =====================================================================================================================
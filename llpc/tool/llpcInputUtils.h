@@ -98,6 +98,7 @@ namespace Ext {
 constexpr llvm::StringLiteral SpirvBin = ".spv";
 constexpr llvm::StringLiteral SpirvText = ".spvasm";
 constexpr llvm::StringLiteral PipelineInfo = ".pipe";
+constexpr llvm::StringLiteral PipelineInfoBinary = ".pipebin";
 constexpr llvm::StringLiteral LlvmBitcode = ".bc";
 constexpr llvm::StringLiteral LlvmIr = ".ll";
 constexpr llvm::StringLiteral IsaText = ".s";
@@ -128,9 +129,12 @@ bool isGlslShaderTextFile(llvm::StringRef fileName);
 // Checks whether the specified file name represents an LLVM IR file (.ll).
 bool isLlvmIrFile(llvm::StringRef fileName);
 
-// Checks whether the specified file name represents an LLPC pipeline info file (.pipe).
+// Checks whether the specified file name represents an LLPC pipeline info file (.pipe or .pipebin).
 bool isPipelineInfoFile(llvm::StringRef fileName);
 
+// Checks whether the specified file name represents an LLPC pipeline info binary file (.pipebin).
+bool isPipelineInfoBinaryFile(llvm::StringRef fileName);
+
 // Tries to detect the format of binary data and creates a file extension from it.
 llvm::StringLiteral fileExtFromBinary(BinaryData pipelineBin);
 
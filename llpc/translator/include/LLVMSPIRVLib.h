@@ -112,12 +112,16 @@ class raw_pwrite_stream;
 /// @returns : True if succeeds.
 bool writeSpirv(llvm::Module *M, llvm::raw_ostream &OS, std::string &ErrMsg);
 
-/// \brief Load SPIRV from istream and translate to LLVM module.
+/// \brief Load SPIRV from the in-memory binary Spirv, without copying it, and translate to LLVM module.
+/// With SpecConstPlaceholders, the scalar specialization constants that have a SpecId are translated as placeholders
+/// (see gSPIRVMD::SpecConstPlaceholder) instead of with their values in SpecConstMap, for the module to be specialized
+/// later.
 /// @returns : True if succeeds.
 bool readSpirv(lgc::Builder *Builder, const Vkgc::ShaderModuleUsage *ModuleData,
-               const Vkgc::PipelineShaderOptions *ShaderOptions, std::istream &IS, spv::ExecutionModel EntryExecModel,
-               const char *EntryName, const SPIRV::SPIRVSpecConstMap &SpecConstMap,
-               llvm::ArrayRef<SPIRV::ConvertingSampler> ConvertingSamplers, llvm::Module *M, std::string &ErrMsg);
+               const Vkgc::PipelineShaderOptions *ShaderOptions, llvm::StringRef Spirv,
+               spv::ExecutionModel EntryExecModel, const char *EntryName, const SPIRV::SPIRVSpecConstMap &SpecConstMap,
+               llvm::ArrayRef<SPIRV::ConvertingSampler> ConvertingSamplers, llvm::Module *M, std::string &ErrMsg,
+               bool SpecConstPlaceholders = false);
 
 /// \brief Regularize LLVM module by removing entities not representable by
 /// SPIRV.
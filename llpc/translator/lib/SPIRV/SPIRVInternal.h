@@ -217,6 +217,15 @@ const static char Resource[] = "spirv.Resource";
 const static char ExecutionModel[] = "spirv.ExecutionModel";
 const static char ImageMemory[] = "spirv.ImageMemory";
 const static char NonUniform[] = "spirv.NonUniform";
+// Attached to the global whose address is the placeholder of a specialization constant, with the SpecId (i32) and the
+// default value (an integer of the bit width of the constant) as operands
+const static char SpecConstPlaceholder[] = "spirv.SpecConstPlaceholder";
+// Attached to the compare of a bounds check on a private or function array access, which SpirvLowerBoundsCheck removes
+// if it always passes
+const static char BoundsCheck[] = "spirv.BoundsCheck";
+// Attached to the condition of a branch or switch that is uniform in the subgroup. This is the name that LGC uses for
+// values it knows to be uniform.
+const static char Uniform[] = "amdgpu.uniform";
 } // namespace gSPIRVMD
 
 namespace gSPIRVName {
@@ -138,13 +138,16 @@ static void dumpLLVM(Module *m, const std::string &fName) {
 
 SPIRVToLLVM::SPIRVToLLVM(Module *llvmModule, SPIRVModule *theSpirvModule, const SPIRVSpecConstMap &theSpecConstMap,
                          ArrayRef<ConvertingSampler> convertingSamplers, lgc::Builder *builder,
-                         const Vkgc::ShaderModuleUsage *moduleUsage, const Vkgc::PipelineShaderOptions *shaderOptions)
+                         const Vkgc::ShaderModuleUsage *moduleUsage, const Vkgc::PipelineShaderOptions *shaderOptions,
+                         bool specConstPlaceholders)
     : m_m(llvmModule), m_builder(builder), m_bm(theSpirvModule), m_enableXfb(false), m_entryTarget(nullptr),
       m_specConstMap(theSpecConstMap), m_convertingSamplers(convertingSamplers), m_dbgTran(m_bm, m_m, this),
       m_moduleUsage(reinterpret_cast<const Vkgc::ShaderModuleUsage *>(moduleUsage)),
-      m_shaderOptions(reinterpret_cast<const Vkgc::PipelineShaderOptions *>(shaderOptions)) {
+      m_shaderOptions(reinterpret_cast<const Vkgc::PipelineShaderOptions *>(shaderOptions)),
+      m_specConstPlaceholders(specConstPlaceholders) {
   assert(m_m);
   m_context = &m_m->getContext();
+  m_typeCache = &static_cast<Llpc::Context *>(m_context)->getSpirvTypeCache();
   m_spirvOpMetaKindId = m_context->getMDKindID(MetaNameSpirvOp);
 }
 
@@ -194,6 +197,29 @@ unsigned SPIRVToLLVM::getBlockPredecessorCounts(BasicBlock *block, BasicBlock *p
   return 0;
 }
 
+// =====================================================================================================================
+// Mark the condition of a branch or switch as uniform if the SPIR-V asserts that it is the same in all active
+// invocations of the subgroup, which divergence analysis cannot always prove, such as for a value loaded from a storage
+// buffer at an index that the shader knows to be uniform. The metadata is on the condition rather than on the branch,
+// so that it is dropped along with the condition by any optimization that changes the condition of the branch.
+//
+// @param spvCondition : SPIR-V condition of the branch, or selector of the switch
+// @param condition : The translated condition
+void SPIRVToLLVM::setUniformConditionMetadata(SPIRVValue *spvCondition, Value *condition) {
+  auto conditionInst = dyn_cast<Instruction>(condition);
+  if (!conditionInst)
+    return;
+  bool isUniform = spvCondition->hasDecorate(DecorationUniform);
+  SPIRVWord scopeId = 0;
+  if (!isUniform && spvCondition->hasDecorate(DecorationUniformId, 0, &scopeId)) {
+    // Uniform in a larger scope than the subgroup implies uniform in the subgroup.
+    auto scope = static_cast<SPIRVConstant *>(m_bm->getValue(scopeId));
+    isUniform = scope->getOpCode() == OpConstant && scope->getZExtIntValue() <= ScopeSubgroup;
+  }
+  if (isUniform)
+    conditionInst->setMetadata(gSPIRVMD::Uniform, MDNode::get(*m_context, {}));
+}
+
 bool SPIRVToLLVM::isSPIRVBuiltinVariable(GlobalVariable *gv, SPIRVBuiltinVariableKind *kind) {
   auto loc = m_builtinGvMap.find(gv);
   if (loc == m_builtinGvMap.end())
@@ -538,6 +564,38 @@ Type *SPIRVToLLVM::transTypeWithOpcode<spv::OpTypeStruct>(SPIRVType *const spvTy
                                                           const bool isExplicitlyLaidOut) {
   SPIRVTypeStruct *const spvStructType = static_cast<SPIRVTypeStruct *>(spvType);
 
+  // Look for the struct type in the type cache, if the types of all of its members are supported there. This is not
+  // done while another struct type is being translated for the type cache.
+  std::string signature;
+  SmallVector<SPIRVType *, 16> signatureTypes;
+  bool useTypeCache = !m_typeTranslationsToCache;
+  if (useTypeCache) {
+    raw_string_ostream signatureStream(signature);
+    signatureStream << spvStructType->getName() << ';' << spvStructType->isLiteral() << isParentPointer
+                    << isExplicitlyLaidOut << ';';
+    signatureTypes.push_back(spvStructType);
+    for (SPIRVWord i = 0, memberCount = spvStructType->getMemberCount(); i < memberCount && useTypeCache; i++) {
+      SPIRVWord offset = 0;
+      SPIRVWord memberMatrixStride = 0;
+      const bool hasOffset = spvStructType->hasMemberDecorate(i, DecorationOffset, 0, &offset);
+      spvStructType->hasMemberDecorate(i, DecorationMatrixStride, 0, &memberMatrixStride);
+      signatureStream << hasOffset << ',' << offset << ',' << memberMatrixStride << ','
+                      << spvStructType->hasMemberDecorate(i, DecorationRowMajor) << ';';
+      useTypeCache = appendTypeCacheSignature(spvStructType->getMemberType(i), signatureStream, signatureTypes);
+    }
+  }
+  if (useTypeCache) {
+    if (const SPIRVTypeCache::Entry *entry = m_typeCache->find(signature)) {
+      if (applyTypeCacheEntry(*entry, signatureTypes))
+        return entry->type;
+      // The entry cannot be used for this translation; translate the struct type without the type cache.
+      useTypeCache = false;
+    }
+  }
+  SmallVector<std::pair<SPIRVType *, SPIRVTypeCache::TypeTranslation>, 16> typeTranslations;
+  if (useTypeCache)
+    m_typeTranslationsToCache = &typeTranslations;
+
   bool isPacked = false;
 
   bool hasMemberOffset = false;
@@ -649,7 +707,12 @@ Type *SPIRVToLLVM::transTypeWithOpcode<spv::OpTypeStruct>(SPIRVType *const spvTy
     structType->setBody(memberTypes, isPacked);
   }
 
-  return isExplicitlyLaidOut && hasMemberOffset ? recordTypeWithPad(structType) : structType;
+  Type *const newType = isExplicitlyLaidOut && hasMemberOffset ? recordTypeWithPad(structType) : structType;
+  if (useTypeCache) {
+    m_typeTranslationsToCache = nullptr;
+    addTypeCacheEntry(signature, signatureTypes, typeTranslations, newType);
+  }
+  return newType;
 }
 
 // =====================================================================================================================
@@ -680,14 +743,147 @@ Type *SPIRVToLLVM::transType(SPIRVType *t, unsigned matrixStride, bool columnMaj
                              bool explicitlyLaidOut) {
   SPIRVTypeContext ctx(t, matrixStride, columnMajor, parentIsPointer, explicitlyLaidOut);
   auto it = m_fullTypeMap.find(ctx.asTuple());
+  Type *res = nullptr;
   if (it != m_fullTypeMap.end())
-    return it->second;
+    res = it->second;
+  else {
+    res = transTypeImpl(t, matrixStride, columnMajor, parentIsPointer, explicitlyLaidOut);
+    m_fullTypeMap[ctx.asTuple()] = res;
+  }
 
-  auto res = transTypeImpl(t, matrixStride, columnMajor, parentIsPointer, explicitlyLaidOut);
-  m_fullTypeMap[ctx.asTuple()] = res;
+  // Record the translation if the struct type being translated is to be added to the type cache.
+  if (m_typeTranslationsToCache) {
+    m_typeTranslationsToCache->push_back(
+        {t, {0, matrixStride, columnMajor, parentIsPointer, explicitlyLaidOut, res}});
+  }
   return res;
 }
 
+// =====================================================================================================================
+// Appends the signature of a SPIR-V type inside a struct type to the type cache signature of the struct type. Only
+// the types whose translation does not depend on anything other than what goes into the signature are supported.
+//
+// @param spvType : The type
+// @param [in/out] signature : Stream of the signature
+// @param [in/out] types : The SPIR-V types visited so far, in the order that the signature visits them
+// @returns : False if the type is not supported
+bool SPIRVToLLVM::appendTypeCacheSignature(SPIRVType *spvType, raw_ostream &signature,
+                                           SmallVectorImpl<SPIRVType *> &types) {
+  // A type that has been visited already is referred to by its index.
+  auto it = llvm::find(types, spvType);
+  if (it != types.end()) {
+    signature << '#' << (it - types.begin()) << ';';
+    return true;
+  }
+  types.push_back(spvType);
+
+  SPIRVWord arrayStride = 0;
+  signature << spvType->getOpCode() << ':';
+  switch (spvType->getOpCode()) {
+  case OpTypeBool:
+    break;
+  case OpTypeInt:
+    signature << spvType->getIntegerBitWidth();
+    break;
+  case OpTypeFloat:
+    signature << spvType->getFloatBitWidth();
+    break;
+  case OpTypeVector:
+    signature << spvType->getVectorComponentCount() << ';';
+    return appendTypeCacheSignature(spvType->getVectorComponentType(), signature, types);
+  case OpTypeMatrix:
+    signature << spvType->getMatrixColumnCount() << ';';
+    return appendTypeCacheSignature(spvType->getMatrixColumnType(), signature, types);
+  case OpTypeArray:
+    spvType->hasDecorate(DecorationArrayStride, 0, &arrayStride);
+    signature << spvType->getArrayLength() << ',' << arrayStride << ';';
+    return appendTypeCacheSignature(spvType->getArrayElementType(), signature, types);
+  case OpTypeRuntimeArray:
+    spvType->hasDecorate(DecorationArrayStride, 0, &arrayStride);
+    signature << arrayStride << ';';
+    return appendTypeCacheSignature(spvType->getArrayElementType(), signature, types);
+  default:
+    return false;
+  }
+  signature << ';';
+  return true;
+}
+
+// =====================================================================================================================
+// Applies an entry of the type cache to the struct type being translated: adds the type translations of the types
+// inside it, and the side information recorded for them, to those of this translation.
+//
+// @param entry : The type cache entry
+// @param types : The SPIR-V types visited by the signature of the struct type, the struct type first
+// @returns : False if the entry conflicts with a type translation already done in this translation, in which case
+//            nothing is changed
+bool SPIRVToLLVM::applyTypeCacheEntry(const SPIRVTypeCache::Entry &entry, ArrayRef<SPIRVType *> types) {
+  for (const SPIRVTypeCache::TypeTranslation &translation : entry.typeTranslations) {
+    SPIRVTypeContext ctx(types[translation.typeIndex], translation.matrixStride, translation.columnMajor,
+                         translation.parentIsPointer, translation.explicitlyLaidOut);
+    auto it = m_fullTypeMap.find(ctx.asTuple());
+    if (it != m_fullTypeMap.end() && it->second != translation.type)
+      return false;
+  }
+
+  for (const SPIRVTypeCache::TypeTranslation &translation : entry.typeTranslations) {
+    SPIRVType *const spvType = types[translation.typeIndex];
+    SPIRVTypeContext ctx(spvType, translation.matrixStride, translation.columnMajor, translation.parentIsPointer,
+                         translation.explicitlyLaidOut);
+    m_fullTypeMap[ctx.asTuple()] = translation.type;
+    if (!translation.parentIsPointer)
+      m_typeMap.try_emplace(spvType, translation.type);
+  }
+  for (const auto &remapped : entry.remappedTypeElements)
+    m_remappedTypeElements[types[remapped.first]] = remapped.second;
+  for (const auto &typeWithPad : entry.typesWithPad)
+    recordTypeWithPad(typeWithPad.first, typeWithPad.second);
+  for (const auto &overlapped : entry.overlappedMembers)
+    m_overlappingStructTypeWorkaroundMap[std::make_pair(types[0], overlapped.first)] = overlapped.second;
+  return true;
+}
+
+// =====================================================================================================================
+// Adds the struct type just translated to the type cache, with the type translations of the types inside it and the
+// side information recorded for them.
+//
+// @param signature : The type cache signature of the struct type
+// @param types : The SPIR-V types visited by the signature, the struct type first
+// @param typeTranslations : The type translations done while translating the struct type
+// @param structType : The LLVM type of the struct type
+void SPIRVToLLVM::addTypeCacheEntry(StringRef signature, ArrayRef<SPIRVType *> types,
+                                    ArrayRef<std::pair<SPIRVType *, SPIRVTypeCache::TypeTranslation>> typeTranslations,
+                                    Type *structType) {
+  SPIRVTypeCache::Entry entry;
+  entry.type = structType;
+  for (const auto &typeTranslation : typeTranslations) {
+    auto it = llvm::find(types, typeTranslation.first);
+    if (it == types.end())
+      return; // A type the signature does not cover was translated, so the struct type cannot be cached.
+    entry.typeTranslations.push_back(typeTranslation.second);
+    entry.typeTranslations.back().typeIndex = it - types.begin();
+    if (isTypeWithPad(typeTranslation.second.type))
+      entry.typesWithPad.push_back(
+          {typeTranslation.second.type, isTypeWithPadRowMajorMatrix(typeTranslation.second.type)});
+  }
+  if (isTypeWithPad(structType))
+    entry.typesWithPad.push_back({structType, isTypeWithPadRowMajorMatrix(structType)});
+
+  for (unsigned i = 0; i != types.size(); ++i) {
+    auto it = m_remappedTypeElements.find(types[i]);
+    if (it != m_remappedTypeElements.end())
+      entry.remappedTypeElements.push_back({i, it->second});
+  }
+  SPIRVTypeStruct *const spvStructType = static_cast<SPIRVTypeStruct *>(types[0]);
+  for (unsigned i = 0, memberCount = spvStructType->getMemberCount(); i != memberCount; ++i) {
+    auto it = m_overlappingStructTypeWorkaroundMap.find(std::make_pair(types[0], i));
+    if (it != m_overlappingStructTypeWorkaroundMap.end())
+      entry.overlappedMembers.push_back({i, it->second});
+  }
+
+  m_typeCache->insert(signature, std::move(entry));
+}
+
 Type *SPIRVToLLVM::transTypeImpl(SPIRVType *t, unsigned matrixStride, bool columnMajor, bool parentIsPointer,
                                  bool explicitlyLaidOut) {
   // If the type is not a sub-part of a pointer or it is a forward pointer, we can look in the map.
@@ -3798,6 +3994,41 @@ template <> Value *SPIRVToLLVM::transValueWithOpcode<OpExtInst>(SPIRVValue *cons
   }
 }
 
+// =====================================================================================================================
+// Translate a scalar specialization constant as a placeholder, for the module to be specialized after translation and
+// lowering. The placeholder is the address of an extern_weak global, which nothing can assume a value of, cast to the
+// type of the constant. The global carries the SpecId and the default value of the constant in its
+// gSPIRVMD::SpecConstPlaceholder metadata, and specializing the module replaces it with the value to use.
+//
+// @param bv : The SPIR-V OpSpecConstant, OpSpecConstantTrue or OpSpecConstantFalse, decorated with a SpecId
+Constant *SPIRVToLLVM::transSpecConstantPlaceholder(SPIRVValue *bv) {
+  unsigned specId = SPIRVID_INVALID;
+  bv->hasDecorate(DecorationSpecId, 0, &specId);
+
+  Type *const type = transType(bv->getType());
+  IntegerType *const intType = IntegerType::get(*m_context, type->getPrimitiveSizeInBits());
+  uint64_t defaultValue = 0;
+  if (bv->getOpCode() == OpSpecConstant)
+    defaultValue = static_cast<SPIRVConstant *>(bv)->getZExtIntValue();
+  else if (bv->getOpCode() == OpSpecConstantTrue)
+    defaultValue = static_cast<SPIRVSpecConstantTrue *>(bv)->getBoolValue();
+  else
+    defaultValue = static_cast<SPIRVSpecConstantFalse *>(bv)->getBoolValue();
+
+  auto placeholder = new GlobalVariable(*m_m, Type::getInt8Ty(*m_context), true, GlobalValue::ExternalWeakLinkage,
+                                        nullptr, "spirv.SpecConst." + Twine(specId), nullptr,
+                                        GlobalValue::NotThreadLocal, SPIRAS_Global);
+  placeholder->setAlignment(MaybeAlign(1));
+  Metadata *placeholderMeta[] = {ConstantAsMetadata::get(ConstantInt::get(Type::getInt32Ty(*m_context), specId)),
+                                 ConstantAsMetadata::get(ConstantInt::get(intType, defaultValue))};
+  placeholder->setMetadata(gSPIRVMD::SpecConstPlaceholder, MDNode::get(*m_context, placeholderMeta));
+
+  Constant *value = ConstantExpr::getPtrToInt(placeholder, intType);
+  if (type != intType)
+    value = ConstantExpr::getBitCast(value, type);
+  return value;
+}
+
 // =====================================================================================================================
 // Translate an initializer. This has special handling for the case where the type to initialize to does not match the
 // type of the initializer, which is common when dealing with interface objects.
@@ -4107,6 +4338,10 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *bv, Function *f, Bas
   IntBoolOpMap::rfind(oc, &oc);
 
   // Translation of non-instruction values
+  if (m_specConstPlaceholders && (oc == OpSpecConstant || oc == OpSpecConstantTrue || oc == OpSpecConstantFalse) &&
+      bv->hasDecorate(DecorationSpecId))
+    return mapValue(bv, transSpecConstantPlaceholder(bv));
+
   switch (oc) {
   case OpConstant:
   case OpSpecConstant: {
@@ -4295,6 +4530,7 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *bv, Function *f, Bas
 
     auto trueSuccessor = cast<BasicBlock>(transValue(br->getTrueLabel(), f, bb));
     auto falseSuccessor = cast<BasicBlock>(transValue(br->getFalseLabel(), f, bb));
+    setUniformConditionMetadata(br->getCondition(), c);
     auto bc = BranchInst::Create(trueSuccessor, falseSuccessor, c, bb);
     auto lm = static_cast<SPIRVLoopMerge *>(br->getPrevious());
     if (lm && lm->getOpCode() == OpLoopMerge)
@@ -4366,6 +4602,31 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *bv, Function *f, Bas
   case OpSwitch: {
     auto bs = static_cast<SPIRVSwitch *>(bv);
     auto select = transValue(bs->getSelect(), f, bb);
+    if (auto constSelect = dyn_cast<ConstantInt>(select)) {
+      // A switch on a constant, such as a specialization constant choosing a path through an uber-shader, is translated
+      // as a branch, so that the lowering passes do not process the cases that are never taken. The edges to the other
+      // targets are recorded with a count of zero, for the phi nodes there to drop them.
+      SPIRVBasicBlock *target = bs->getDefault();
+      SmallVector<SPIRVBasicBlock *, 8> labels = {target};
+      bs->foreachPair([&](SPIRVSwitch::LiteralTy literals, SPIRVBasicBlock *label) {
+        uint64_t literal = uint64_t(literals.at(0));
+        if (literals.size() == 2)
+          literal += uint64_t(literals.at(1)) << 32;
+        if (literal == constSelect->getZExtValue() && target == bs->getDefault())
+          target = label;
+        labels.push_back(label);
+      });
+
+      auto successor = cast<BasicBlock>(transValue(target, f, bb));
+      for (SPIRVBasicBlock *label : labels) {
+        auto otherSuccessor = cast<BasicBlock>(transValue(label, f, bb));
+        if (otherSuccessor != successor)
+          m_blockPredecessorToCount.try_emplace({otherSuccessor, bb}, 0);
+      }
+      recordBlockPredecessor(successor, bb);
+      return mapValue(bv, BranchInst::Create(successor, bb));
+    }
+
     auto ls =
         SwitchInst::Create(select, dyn_cast<BasicBlock>(transValue(bs->getDefault(), f, bb)), bs->getNumPairs(), bb);
     bs->foreachPair([&](SPIRVSwitch::LiteralTy literals, SPIRVBasicBlock *label) {
@@ -4379,6 +4640,7 @@ Value *SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *bv, Function *f, Bas
       ls->addCase(ConstantInt::get(dyn_cast<IntegerType>(select->getType()), literal), successor);
       recordBlockPredecessor(successor, bb);
     });
+    setUniformConditionMetadata(bs->getSelect(), select);
     return mapValue(bv, ls);
   }
 
@@ -5217,6 +5479,11 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *bf) {
     }
   }
 
+  // This may be translating a callee in the middle of translating its caller, so set aside the predecessor counts
+  // recorded for the caller's blocks, and restore them when done.
+  auto callerBlockPredecessorToCount = std::move(m_blockPredecessorToCount);
+  m_blockPredecessorToCount.clear();
+
   // Creating all basic blocks before creating instructions.
   for (size_t i = 0, e = bf->getNumBasicBlock(); i != e; ++i)
     transValue(bf->getBasicBlock(i), f, nullptr);
@@ -5238,6 +5505,18 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *bf) {
   // This is necessary because LLVM's CFG is a multigraph, while SPIR-V's
   // CFG is not.
   for (BasicBlock &bb : *f) {
+    // Remove the incoming arcs of the edges of switches that were translated as branches.
+    for (PHINode &phi : make_early_inc_range(bb.phis())) {
+      for (unsigned i = phi.getNumIncomingValues(); i-- != 0;) {
+        auto it = m_blockPredecessorToCount.find({&bb, phi.getIncomingBlock(i)});
+        if (it != m_blockPredecessorToCount.end() && it->second == 0)
+          phi.removeIncomingValue(i, /*DeletePHIIfEmpty=*/false);
+      }
+      if (phi.getNumIncomingValues() == 0) {
+        phi.replaceAllUsesWith(UndefValue::get(phi.getType()));
+        phi.eraseFromParent();
+      }
+    }
 
     // Add missing incoming arcs to each phi node that requires fixups.
     for (PHINode &phi : bb.phis()) {
@@ -5253,7 +5532,7 @@ Function *SPIRVToLLVM::transFunction(SPIRVFunction *bf) {
     }
   }
 
-  m_blockPredecessorToCount.clear();
+  m_blockPredecessorToCount = std::move(callerBlockPredecessorToCount);
 
   return f;
 }
@@ -6544,6 +6823,11 @@ bool SPIRVToLLVM::translate(ExecutionModel entryExecModel, const char *entryName
 
   for (unsigned i = 0, e = m_bm->getNumFunctions(); i != e; ++i) {
     auto bf = m_bm->getFunction(i);
+    // With a targeted entry-point, only that is translated here. The functions it calls are translated along with
+    // their calls, so those that cannot be reached from the entry-point are never translated, unless unused
+    // functions are to be kept. Without one, all non entry-points are translated.
+    if (m_entryTarget && bf != m_entryTarget && !m_moduleUsage->keepUnusedFunctions)
+      continue;
     // Non entry-points and targeted entry-point should be translated.
     // Set DLLExport on targeted entry-point so we can find it later.
     if (!m_bm->getEntryPoint(bf->getId()) || bf == m_entryTarget) {
@@ -6598,6 +6882,9 @@ bool SPIRVToLLVM::transAddressingModel() {
 bool SPIRVToLLVM::transDecoration(SPIRVValue *bv, Value *v) {
   if (!transShaderDecoration(bv, v))
     return false;
+  // Mark 32-bit float arithmetic that only needs relaxed precision, so LGC can do it in 16-bit floats.
+  if (bv->hasDecorate(DecorationRelaxedPrecision) && isa<Instruction>(v) && v->getType()->getScalarType()->isFloatTy())
+    cast<Instruction>(v)->setMetadata(lgc::RelaxedPrecisionMetadataName, MDNode::get(*m_context, {}));
   m_dbgTran.transDbgInfo(bv, v);
   return true;
 }
@@ -7717,6 +8004,9 @@ Constant *SPIRVToLLVM::buildShaderBlockMetadata(SPIRVType *bt, ShaderBlockDecora
 Value *SPIRVToLLVM::transGLSLExtInst(SPIRVExtInst *extInst, BasicBlock *bb) {
   auto bArgs = extInst->getArguments();
   auto args = transValue(extInst->getValues(bArgs), bb->getParent(), bb);
+  if (Value *result = transRelaxedPrecisionGLSLExtInst(extInst, args))
+    return result;
+
   switch (static_cast<GLSLExtOpKind>(extInst->getExtOp())) {
 
   case GLSLstd450Round:
@@ -8177,6 +8467,75 @@ Value *SPIRVToLLVM::transGLSLExtInst(SPIRVExtInst *extInst, BasicBlock *bb) {
   }
 }
 
+// =============================================================================
+// Translate a transcendental GLSLstd450 extended instruction on 32-bit floats in 16-bit floats, if the instruction is
+// decorated RelaxedPrecision and the shader asks for the fast math precision tier. Returns nullptr otherwise.
+Value *SPIRVToLLVM::transRelaxedPrecisionGLSLExtInst(SPIRVExtInst *extInst, ArrayRef<Value *> args) {
+  if (m_shaderOptions->mathPrecision != Vkgc::MathPrecision::Fast ||
+      !extInst->hasDecorate(DecorationRelaxedPrecision) || args.empty())
+    return nullptr;
+
+  Type *floatTy = args[0]->getType();
+  if (!floatTy->getScalarType()->isFloatTy())
+    return nullptr;
+  Type *halfTy = getBuilder()->getHalfTy();
+  if (auto vecTy = dyn_cast<FixedVectorType>(floatTy))
+    halfTy = FixedVectorType::get(halfTy, vecTy->getNumElements());
+  auto getHalfArg = [&](unsigned index) { return getBuilder()->CreateFPTrunc(args[index], halfTy); };
+
+  Value *result = nullptr;
+  switch (static_cast<GLSLExtOpKind>(extInst->getExtOp())) {
+  case GLSLstd450Sin:
+    result = getBuilder()->CreateUnaryIntrinsic(Intrinsic::sin, getHalfArg(0));
+    break;
+  case GLSLstd450Cos:
+    result = getBuilder()->CreateUnaryIntrinsic(Intrinsic::cos, getHalfArg(0));
+    break;
+  case GLSLstd450Tan:
+    result = getBuilder()->CreateTan(getHalfArg(0));
+    break;
+  case GLSLstd450Asin:
+    result = getBuilder()->CreateASin(getHalfArg(0));
+    break;
+  case GLSLstd450Acos:
+    result = getBuilder()->CreateACos(getHalfArg(0));
+    break;
+  case GLSLstd450Atan:
+    result = getBuilder()->CreateATan(getHalfArg(0));
+    break;
+  case GLSLstd450Sinh:
+    result = getBuilder()->CreateSinh(getHalfArg(0));
+    break;
+  case GLSLstd450Cosh:
+    result = getBuilder()->CreateCosh(getHalfArg(0));
+    break;
+  case GLSLstd450Tanh:
+    result = getBuilder()->CreateTanh(getHalfArg(0));
+    break;
+  case GLSLstd450Atan2:
+    result = getBuilder()->CreateATan2(getHalfArg(0), getHalfArg(1));
+    break;
+  case GLSLstd450Pow:
+    result = getBuilder()->CreatePower(getHalfArg(0), getHalfArg(1));
+    break;
+  case GLSLstd450Exp:
+    result = getBuilder()->CreateExp(getHalfArg(0));
+    break;
+  case GLSLstd450Log:
+    result = getBuilder()->CreateLog(getHalfArg(0));
+    break;
+  case GLSLstd450Exp2:
+    result = getBuilder()->CreateUnaryIntrinsic(Intrinsic::exp2, getHalfArg(0));
+    break;
+  case GLSLstd450Log2:
+    result = getBuilder()->CreateUnaryIntrinsic(Intrinsic::log2, getHalfArg(0));
+    break;
+  default:
+    return nullptr;
+  }
+  return getBuilder()->CreateFPExt(result, floatTy);
+}
+
 // =============================================================================
 // Flush denorm to zero if DenormFlushToZero is set in the shader
 Value *SPIRVToLLVM::flushDenorm(Value *val) {
@@ -8600,6 +8959,8 @@ void SPIRVToLLVM::insertScratchBoundsChecks(SPIRVValue *memOp, const ScratchBoun
     Value *comparisonValue = transValue(accessChainIndex, checkBlock->getParent(), checkBlock);
     ConstantInt *arrayUpperBound = getBuilder()->getInt32(upperBound);
     auto cmpResult = getBuilder()->CreateICmpULT(comparisonValue, arrayUpperBound);
+    if (auto cmpInst = dyn_cast<Instruction>(cmpResult))
+      cmpInst->setMetadata(gSPIRVMD::BoundsCheck, MDNode::get(*m_context, {}));
 
     if (finalCmpResult)
       finalCmpResult = getBuilder()->CreateAnd(finalCmpResult, cmpResult);
@@ -8695,16 +9056,18 @@ void SPIRVToLLVM::insertScratchBoundsChecks(SPIRVValue *memOp, const ScratchBoun
 } // namespace SPIRV
 
 bool llvm::readSpirv(Builder *builder, const ShaderModuleUsage *shaderInfo, const PipelineShaderOptions *shaderOptions,
-                     std::istream &is, spv::ExecutionModel entryExecModel, const char *entryName,
+                     StringRef spirv, spv::ExecutionModel entryExecModel, const char *entryName,
                      const SPIRVSpecConstMap &specConstMap, ArrayRef<ConvertingSampler> convertingSamplers, Module *m,
-                     std::string &errMsg) {
+                     std::string &errMsg, bool specConstPlaceholders) {
   assert(entryExecModel != ExecutionModelKernel && "Not support ExecutionModelKernel");
 
   std::unique_ptr<SPIRVModule> bm(SPIRVModule::createSPIRVModule());
 
+  SPIRVInputStream is(spirv.data(), spirv.size());
   is >> *bm;
 
-  SPIRVToLLVM btl(m, bm.get(), specConstMap, convertingSamplers, builder, shaderInfo, shaderOptions);
+  SPIRVToLLVM btl(m, bm.get(), specConstMap, convertingSamplers, builder, shaderInfo, shaderOptions,
+                  specConstPlaceholders);
   bool succeed = true;
   if (!btl.translate(entryExecModel, entryName)) {
     bm->getError(errMsg);
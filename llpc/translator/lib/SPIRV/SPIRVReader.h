@@ -43,6 +43,7 @@
 #include "SPIRVInternal.h"
 #include "SPIRVModule.h"
 #include "SPIRVToLLVMDbgTran.h"
+#include "SPIRVTypeCache.h"
 #include "vkgcDefs.h"
 #include "lgc/Builder.h"
 
@@ -70,7 +71,8 @@ class SPIRVToLLVM {
 public:
   SPIRVToLLVM(Module *llvmModule, SPIRVModule *theSpirvModule, const SPIRVSpecConstMap &theSpecConstMap,
               llvm::ArrayRef<ConvertingSampler> convertingSamplers, lgc::Builder *builder,
-              const Vkgc::ShaderModuleUsage *moduleUsage, const Vkgc::PipelineShaderOptions *shaderOptions);
+              const Vkgc::ShaderModuleUsage *moduleUsage, const Vkgc::PipelineShaderOptions *shaderOptions,
+              bool specConstPlaceholders = false);
 
   DebugLoc getDebugLoc(SPIRVInstruction *bi, Function *f);
 
@@ -89,6 +91,7 @@ public:
   Value *transValueWithoutDecoration(SPIRVValue *, Function *f, BasicBlock *, bool createPlaceHolder = true);
   Value *transAtomicRMW(SPIRVValue *, const AtomicRMWInst::BinOp);
   Constant *transInitializer(SPIRVValue *, Type *);
+  Constant *transSpecConstantPlaceholder(SPIRVValue *bv);
   template <spv::Op> Value *transValueWithOpcode(SPIRVValue *);
   Value *transLoadImage(SPIRVValue *spvImageLoadPtr);
   Value *loadImageSampler(Type *elementTy, Value *base);
@@ -105,6 +108,7 @@ public:
   Constant *buildShaderBlockMetadata(SPIRVType *bt, ShaderBlockDecorate &blockDec, Type *&mdTy);
   unsigned calcShaderBlockSize(SPIRVType *bt, unsigned blockSize, unsigned matrixStride, bool isRowMajor);
   Value *transGLSLExtInst(SPIRVExtInst *extInst, BasicBlock *bb);
+  Value *transRelaxedPrecisionGLSLExtInst(SPIRVExtInst *extInst, ArrayRef<Value *> args);
   Value *flushDenorm(Value *val);
   Value *transTrinaryMinMaxExtInst(SPIRVExtInst *extInst, BasicBlock *bb);
   Value *transGLSLBuiltinFromExtInst(SPIRVExtInst *bc, BasicBlock *bb);
@@ -243,6 +247,10 @@ private:
   const Vkgc::ShaderModuleUsage *m_moduleUsage;
   const Vkgc::PipelineShaderOptions *m_shaderOptions;
   unsigned m_spirvOpMetaKindId;
+  bool m_specConstPlaceholders; // Whether to translate scalar specialization constants as placeholders
+  SPIRVTypeCache *m_typeCache;  // Cache of translated struct types shared with other translations into the context
+  // The type translations done while translating a struct type that is to be added to m_typeCache, if any
+  SmallVectorImpl<std::pair<SPIRVType *, SPIRVTypeCache::TypeTranslation>> *m_typeTranslationsToCache = nullptr;
   unsigned m_execModule;
 
   enum class LlvmMemOpType : uint8_t { IS_LOAD, IS_STORE };
@@ -265,6 +273,12 @@ private:
   Type *transTypeImpl(SPIRVType *bt, unsigned matrixStride, bool columnMajor, bool parentIsPointer,
                       bool explicitlyLaidOut);
 
+  bool appendTypeCacheSignature(SPIRVType *spvType, raw_ostream &signature, SmallVectorImpl<SPIRVType *> &types);
+  bool applyTypeCacheEntry(const SPIRVTypeCache::Entry &entry, ArrayRef<SPIRVType *> types);
+  void addTypeCacheEntry(StringRef signature, ArrayRef<SPIRVType *> types,
+                         ArrayRef<std::pair<SPIRVType *, SPIRVTypeCache::TypeTranslation>> typeTranslations,
+                         Type *structType);
+
   Type *mapType(SPIRVType *bt, Type *t) {
     m_typeMap[bt] = t;
     return t;
@@ -309,6 +323,7 @@ private:
   }
 
   unsigned getBlockPredecessorCounts(BasicBlock *block, BasicBlock *predecessor);
+  void setUniformConditionMetadata(SPIRVValue *spvCondition, Value *condition);
 
   bool isSPIRVBuiltinVariable(GlobalVariable *gv, SPIRVBuiltinVariableKind *kind = nullptr);
 
@@ -53,6 +53,7 @@ using namespace SPIRVDebug::Operand;
 namespace llvm {
 namespace cl {
 extern opt<bool> TrimDebugInfo;
+extern opt<bool> DebugInfoLineTablesOnly;
 } // namespace cl
 } // namespace llvm
 
@@ -61,6 +62,7 @@ namespace SPIRV {
 SPIRVToLLVMDbgTran::SPIRVToLLVMDbgTran(SPIRVModule *TBM, Module *TM, SPIRVToLLVM *Reader)
     : BM(TBM), M(TM), Builder(*M), SPIRVReader(Reader) {
   Enable = BM->hasDebugInfo() && !cl::TrimDebugInfo;
+  LineTablesOnly = cl::DebugInfoLineTablesOnly;
 }
 
 void SPIRVToLLVMDbgTran::createCompilationUnit() {
@@ -134,7 +136,8 @@ DICompileUnit *SPIRVToLLVMDbgTran::transCompileUnit(const SPIRVExtInst *DebugIns
   SPIRVId FileId = Source->getArguments()[SPIRVDebug::Operand::Source::FileIdx];
   std::string File = getString(FileId);
   unsigned SourceLang = Ops[LanguageIdx];
-  CU = Builder.createCompileUnit(SourceLang, getDIFile(File), "spirv", false, "", 0);
+  CU = Builder.createCompileUnit(SourceLang, getDIFile(File), "spirv", false, "", 0, "",
+                                 LineTablesOnly ? DICompileUnit::LineTablesOnly : DICompileUnit::FullDebug);
   return CU;
 }
 
@@ -870,6 +873,9 @@ Instruction *SPIRVToLLVMDbgTran::transDebugIntrinsic(const SPIRVExtInst *DebugIn
     return transDebugInst<DIExpression>(BM->get<SPIRVExtInst>(Id));
   };
   SPIRVWordVec Ops = DebugInst->getArguments();
+  // Line tables do not describe variables.
+  if (LineTablesOnly)
+    return nullptr;
   switch (DebugInst->getExtOp()) {
   case SPIRVDebug::Scope:
   case SPIRVDebug::NoScope:
@@ -915,7 +921,10 @@ DebugLoc SPIRVToLLVMDbgTran::transDebugScope(const SPIRVInstruction *SpirvInst,
     Line = LineInfo->getLine();
     Col = LineInfo->getColumn();
   }
-  if (SPIRVEntry *S = SpirvInst->getDebugScope()) {
+  // For line tables, the scope is always the function, so that the debug information of the lexical scopes, and the
+  // types of the functions they are in, need not be translated.
+  SPIRVEntry *S = LineTablesOnly ? nullptr : SpirvInst->getDebugScope();
+  if (S) {
     using namespace SPIRVDebug::Operand::Scope;
     SPIRVExtInst *DbgScope = static_cast<SPIRVExtInst *>(S);
     SPIRVWordVec Ops = DbgScope->getArguments();
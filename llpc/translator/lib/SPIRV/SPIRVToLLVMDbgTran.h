@@ -146,6 +146,7 @@ private:
   SPIRVToLLVM *SPIRVReader;
   DICompileUnit *CU;
   bool Enable;
+  bool LineTablesOnly; // Whether only the source line information is translated
   std::unordered_map<std::string, DIFile *> FileMap;
   std::unordered_map<SPIRVId, DISubprogram *> FuncMap;
   std::unordered_map<const SPIRVExtInst *, MDNode *> DebugInstCache;
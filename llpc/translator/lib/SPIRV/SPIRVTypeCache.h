@@ -0,0 +1,101 @@
+//===- SPIRVTypeCache.h - Cache of translated SPIR-V types ------*- C++ -*-===//
+//
+//                     The LLVM/SPIR-V Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file declares the cache of the LLVM types translated from SPIR-V struct types, which is kept across the
+/// translations of SPIR-V modules into the same LLVMContext.
+///
+//===----------------------------------------------------------------------===//
+#ifndef SPIRVTYPECACHE_H
+#define SPIRVTYPECACHE_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include <utility>
+
+namespace llvm {
+class Type;
+} // namespace llvm
+
+namespace SPIRV {
+
+// =====================================================================================================================
+// Cache of the LLVM types translated from SPIR-V struct types, such as the blocks that many shaders declare in the same
+// way. An entry is keyed by a signature of the structure and the layout decorations of the struct type, so a struct
+// type in another SPIR-V module with the same signature gets the same LLVM type, along with the side information that
+// the translator recorded when it translated the struct type. The SPIR-V types inside the struct type are referred to
+// by their index in the order that the signature visits them.
+//
+// The LLVM types belong to the LLVMContext that the translations are into, so the cache must not outlive it. The cache
+// is not thread-safe, in the same way as the LLVMContext.
+class SPIRVTypeCache {
+public:
+  // One type translation done while translating the struct type
+  struct TypeTranslation {
+    unsigned typeIndex;     // Index of the SPIR-V type
+    unsigned matrixStride;  // Matrix stride the type was translated with
+    bool columnMajor;       // Whether the type was translated as column major
+    bool parentIsPointer;   // Whether the type was translated as part of a pointer
+    bool explicitlyLaidOut; // Whether the type was translated as explicitly laid out
+    llvm::Type *type;       // The LLVM type
+  };
+
+  // The translation of a struct type
+  struct Entry {
+    llvm::Type *type = nullptr;                             // The LLVM type of the struct type
+    llvm::SmallVector<TypeTranslation, 8> typeTranslations; // The type translations of the types inside it
+    // Remapped element indices of the SPIR-V types, by SPIR-V type index
+    llvm::SmallVector<std::pair<unsigned, llvm::SmallVector<unsigned, 8>>, 2> remappedTypeElements;
+    // LLVM types with padding, and whether each is a row major matrix
+    llvm::SmallVector<std::pair<llvm::Type *, bool>, 4> typesWithPad;
+    // Original LLVM types of the struct members that were changed to pads because the next member overlaps them
+    llvm::SmallVector<std::pair<unsigned, llvm::Type *>, 1> overlappedMembers;
+  };
+
+  // Gets the entry for the given signature, or nullptr if there is none.
+  const Entry *find(llvm::StringRef signature) const {
+    auto it = m_entries.find(signature);
+    return it != m_entries.end() ? &it->second : nullptr;
+  }
+
+  // Adds an entry for the given signature.
+  void insert(llvm::StringRef signature, Entry entry) { m_entries.try_emplace(signature, std::move(entry)); }
+
+private:
+  llvm::StringMap<Entry> m_entries; // Entries, by signature
+};
+
+} // namespace SPIRV
+
+#endif // SPIRVTYPECACHE_H
@@ -58,7 +58,7 @@ public:
     setAttr();
   }
 
-  SPIRVDecoder getDecoder(std::istream &IS) override;
+  SPIRVDecoder getDecoder(SPIRVInputStream &IS) override;
   SPIRVFunction *getParent() const { return ParentF; }
   size_t getNumInst() const { return InstVec.size(); }
   SPIRVInstruction *getInst(size_t I) const { return InstVec[I]; }
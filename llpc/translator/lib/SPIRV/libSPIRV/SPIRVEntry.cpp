@@ -47,6 +47,7 @@
 #include "SPIRVType.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <map>
 #include <set>
 #include <sstream>
@@ -96,6 +97,44 @@ SPIRVEntry::createUnique(SPIRVExtInstSetKind Set, unsigned ExtOp) {
   return std::unique_ptr<SPIRVExtInst>(new SPIRVExtInst(Set, ExtOp));
 }
 
+namespace {
+// Header before the memory of each entry, recording whether it is in an
+// arena. It keeps the entry maximally aligned.
+struct alignas(alignof(std::max_align_t)) SPIRVEntryAllocHeader {
+  bool InArena;
+};
+
+// Arena of the SPIRVEntryArenaScope active on this thread, if any.
+thread_local llvm::BumpPtrAllocator *CurrentEntryArena = nullptr;
+} // namespace
+
+void *SPIRVEntry::operator new(size_t Size) {
+  size_t AllocSize = sizeof(SPIRVEntryAllocHeader) + Size;
+  void *Mem = CurrentEntryArena
+                  ? CurrentEntryArena->Allocate(
+                        AllocSize, alignof(SPIRVEntryAllocHeader))
+                  : ::operator new(AllocSize);
+  auto Header = new (Mem) SPIRVEntryAllocHeader{CurrentEntryArena != nullptr};
+  return Header + 1;
+}
+
+void SPIRVEntry::operator delete(void *Ptr) {
+  if (!Ptr)
+    return;
+  auto Header = static_cast<SPIRVEntryAllocHeader *>(Ptr) - 1;
+  if (!Header->InArena)
+    ::operator delete(Header);
+}
+
+SPIRVEntryArenaScope::SPIRVEntryArenaScope(llvm::BumpPtrAllocator &Arena)
+    : SavedArena(CurrentEntryArena) {
+  CurrentEntryArena = &Arena;
+}
+
+SPIRVEntryArenaScope::~SPIRVEntryArenaScope() {
+  CurrentEntryArena = SavedArena;
+}
+
 SPIRVErrorLog &SPIRVEntry::getErrorLog() const { return Module->getErrorLog(); }
 
 bool SPIRVEntry::exist(SPIRVId TheId) const { return Module->exist(TheId); }
@@ -116,7 +155,7 @@ SPIRVType *SPIRVEntry::getValueType(SPIRVId TheId) const {
   return get<SPIRVValue>(TheId)->getType();
 }
 
-SPIRVDecoder SPIRVEntry::getDecoder(std::istream &I) {
+SPIRVDecoder SPIRVEntry::getDecoder(SPIRVInputStream &I) {
   return SPIRVDecoder(I, *Module);
 }
 
@@ -155,7 +194,7 @@ bool SPIRVEntry::isEndOfBlock() const {
 // The word count and op code has already been read before calling this
 // function for creating the SPIRVEntry. Therefore the input stream only
 // contains the remaining part of the words for the SPIRVEntry.
-void SPIRVEntry::decode(std::istream &I) { assert(0 && "Not implemented"); }
+void SPIRVEntry::decode(SPIRVInputStream &I) { assert(0 && "Not implemented"); }
 
 std::vector<SPIRVValue *>
 SPIRVEntry::getValues(const std::vector<SPIRVId> &IdVec) const {
@@ -337,7 +376,7 @@ void SPIRVEntry::updateModuleVersion() const {
   Module->setMinSPIRVVersion(getRequiredSPIRVVersion());
 }
 
-std::istream &operator>>(std::istream &I, SPIRVEntry &E) {
+SPIRVInputStream &operator>>(SPIRVInputStream &I, SPIRVEntry &E) {
   E.decode(I);
   return I;
 }
@@ -349,10 +388,10 @@ SPIRVEntryPoint::SPIRVEntryPoint(SPIRVModule *TheModule,
                       getSizeInWords(TheName) + 3),
       ExecModel(TheExecModel), Name(TheName) {}
 
-void SPIRVEntryPoint::decode(std::istream &I) {
-  uint32_t Start = I.tellg();
+void SPIRVEntryPoint::decode(SPIRVInputStream &I) {
+  const char *Start = I.tell();
   getDecoder(I) >> ExecModel >> Target >> Name;
-  uint32_t Curr = I.tellg();
+  const char *Curr = I.tell();
   uint32_t NumInOuts = WordCount - (Curr - Start) / sizeof(uint32_t) - 1;
   InOuts.resize(NumInOuts);
   getDecoder(I) >> InOuts;
@@ -360,7 +399,7 @@ void SPIRVEntryPoint::decode(std::istream &I) {
   Module->addEntryPoint(this);
 }
 
-void SPIRVExecutionMode::decode(std::istream &I) {
+void SPIRVExecutionMode::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Target >> ExecMode;
   bool MergeEM = false;
   switch (ExecMode) {
@@ -390,7 +429,7 @@ void SPIRVExecutionMode::decode(std::istream &I) {
     getOrCreateTarget()->addExecutionMode(this);
 }
 
-void SPIRVExecutionModeId::decode(std::istream &I) {
+void SPIRVExecutionModeId::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Target >> ExecMode;
   switch (ExecMode) {
   case ExecutionModeLocalSizeId:
@@ -416,7 +455,7 @@ SPIRVForward *SPIRVAnnotationGeneric::getOrCreateTarget() const {
 SPIRVName::SPIRVName(const SPIRVEntry *TheTarget, const std::string &TheStr)
     : SPIRVAnnotation(TheTarget, getSizeInWords(TheStr) + 2), Str(TheStr) {}
 
-void SPIRVName::decode(std::istream &I) {
+void SPIRVName::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Target >> Str;
   Module->setName(getOrCreateTarget(), Str);
 }
@@ -428,7 +467,7 @@ void SPIRVName::validate() const {
 _SPIRV_IMP_ENCDEC2(SPIRVString, Id, Str)
 _SPIRV_IMP_DECODE3(SPIRVMemberName, Target, MemberNumber, Str)
 
-void SPIRVLine::decode(std::istream &I) {
+void SPIRVLine::decode(SPIRVInputStream &I) {
   getDecoder(I) >> FileName >> Line >> Column;
   std::shared_ptr<const SPIRVLine> L(this);
   Module->setCurrentLine(L);
@@ -457,7 +496,7 @@ SPIRVExtInstImport::SPIRVExtInstImport(SPIRVModule *TheModule, SPIRVId TheId,
   validate();
 }
 
-void SPIRVExtInstImport::decode(std::istream &I) {
+void SPIRVExtInstImport::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Id >> Str;
   Module->importBuiltinSetWithId(Str, Id);
 }
@@ -467,7 +506,7 @@ void SPIRVExtInstImport::validate() const {
   assert(!Str.empty() && "Invalid builtin set");
 }
 
-void SPIRVMemoryModel::decode(std::istream &I) {
+void SPIRVMemoryModel::decode(SPIRVInputStream &I) {
   SPIRVAddressingModelKind AddrModel;
   SPIRVMemoryModelKind MemModel;
   getDecoder(I) >> AddrModel >> MemModel;
@@ -483,7 +522,7 @@ void SPIRVMemoryModel::validate() const {
   SPIRVCK(isValid(MM), InvalidMemoryModel, "Actual is " + std::to_string(MM));
 }
 
-void SPIRVSource::decode(std::istream &I) {
+void SPIRVSource::decode(SPIRVInputStream &I) {
   SourceLanguage Lang = SourceLanguageUnknown;
   SPIRVWord Ver = SPIRVWORD_MAX;
   getDecoder(I) >> Lang >> Ver;
@@ -500,7 +539,7 @@ SPIRVSourceContinued::SPIRVSourceContinued(SPIRVModule *M,
     const std::string &SS)
   :SPIRVEntryNoId(M, 1 + getSizeInWords(SS)), Str(SS){}
 
-void SPIRVSourceContinued::decode(std::istream &I) {
+void SPIRVSourceContinued::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Str;
 }
 
@@ -508,7 +547,7 @@ SPIRVSourceExtension::SPIRVSourceExtension(SPIRVModule *M,
                                            const std::string &SS)
     : SPIRVEntryNoId(M, 1 + getSizeInWords(SS)), S(SS) {}
 
-void SPIRVSourceExtension::decode(std::istream &I) {
+void SPIRVSourceExtension::decode(SPIRVInputStream &I) {
   getDecoder(I) >> S;
   Module->getSourceExtension().insert(S);
 }
@@ -516,7 +555,7 @@ void SPIRVSourceExtension::decode(std::istream &I) {
 SPIRVExtension::SPIRVExtension(SPIRVModule *M, const std::string &SS)
     : SPIRVEntryNoId(M, 1 + getSizeInWords(SS)), S(SS) {}
 
-void SPIRVExtension::decode(std::istream &I) {
+void SPIRVExtension::decode(SPIRVInputStream &I) {
   getDecoder(I) >> S;
   Module->getExtension().insert(S);
 }
@@ -526,7 +565,7 @@ SPIRVCapability::SPIRVCapability(SPIRVModule *M, SPIRVCapabilityKind K)
   updateModuleVersion();
 }
 
-void SPIRVCapability::decode(std::istream &I) {
+void SPIRVCapability::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Kind;
   Module->addCapability(Kind);
 }
@@ -535,7 +574,7 @@ SPIRVModuleProcessed::SPIRVModuleProcessed(SPIRVModule *M,
     const std::string &SS)
   :SPIRVEntryNoId(M, 1 + getSizeInWords(SS)), Str(SS){}
 
-void SPIRVModuleProcessed::decode(std::istream &I) {
+void SPIRVModuleProcessed::decode(SPIRVInputStream &I) {
   getDecoder(I) >> Str;
 }
 
@@ -43,6 +43,7 @@
 #include "SPIRVEnum.h"
 #include "SPIRVError.h"
 #include "SPIRVIsValidEnum.h"
+#include "llvm/Support/Allocator.h"
 #include <cassert>
 #include <iostream>
 #include <map>
@@ -58,6 +59,7 @@ namespace SPIRV {
 class SPIRVModule;
 class SPIRVEncoder;
 class SPIRVDecoder;
+class SPIRVInputStream;
 class SPIRVType;
 class SPIRVValue;
 class SPIRVDecorate;
@@ -70,7 +72,7 @@ class SPIRVExtInst;
 // Add declaration of decode functions to a class.
 // Used inside class definition.
 #define _SPIRV_DCL_DECODE                                                      \
-  void decode(std::istream &I) override;
+  void decode(SPIRVInputStream &I) override;
 
 #define _REQ_SPIRV_VER(Version)                                                \
   SPIRVWord getRequiredSPIRVVersion() const override { return Version; }
@@ -78,35 +80,35 @@ class SPIRVExtInst;
 // Add implementation of decode functions to a class.
 // Used out side of class definition.
 #define _SPIRV_IMP_DECODE0(Ty)                                                 \
-  void Ty::decode(std::istream &I) {}
+  void Ty::decode(SPIRVInputStream &I) {}
 #define _SPIRV_IMP_DECODE1(Ty, x)                                              \
-  void Ty::decode(std::istream &I) { getDecoder(I) >> (x); }
+  void Ty::decode(SPIRVInputStream &I) { getDecoder(I) >> (x); }
 #define _SPIRV_IMP_ENCDEC2(Ty, x, y)                                           \
-  void Ty::decode(std::istream &I) { getDecoder(I) >> (x) >> (y); }
+  void Ty::decode(SPIRVInputStream &I) { getDecoder(I) >> (x) >> (y); }
 #define _SPIRV_IMP_DECODE3(Ty, x, y, z)                                        \
-  void Ty::decode(std::istream &I) { getDecoder(I) >> (x) >> (y) >> (z); }
+  void Ty::decode(SPIRVInputStream &I) { getDecoder(I) >> (x) >> (y) >> (z); }
 #define _SPIRV_IMP_DECODE4(Ty, x, y, z, u)                                     \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u);                                 \
   }
 #define _SPIRV_IMP_DECODE5(Ty, x, y, z, u, v)                                  \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v);                          \
   }
 #define _SPIRV_IMP_DECODE6(Ty, x, y, z, u, v, w)                               \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w);                   \
   }
 #define _SPIRV_IMP_DECODE7(Ty, x, y, z, u, v, w, r)                            \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r);            \
   }
 #define _SPIRV_IMP_DECODE8(Ty, x, y, z, u, v, w, r, s)                         \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r) >> (s);     \
   }
 #define _SPIRV_IMP_DECODE9(Ty, x, y, z, u, v, w, r, s, t)                      \
-  void Ty::decode(std::istream &I) {                                           \
+  void Ty::decode(SPIRVInputStream &I) {                                       \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r) >> (s) >>   \
         (t);                                                                   \
   }
@@ -114,35 +116,37 @@ class SPIRVExtInst;
 // Add definition of encode/decode functions to a class.
 // Used inside class definition.
 #define _SPIRV_DEF_DECODE0                                                     \
-  void decode(std::istream &I) override {}
+  void decode(SPIRVInputStream &I) override {}
 #define _SPIRV_DEF_DECODE1(x)                                                  \
-  void decode(std::istream &I) override { getDecoder(I) >> (x); }
+  void decode(SPIRVInputStream &I) override { getDecoder(I) >> (x); }
 #define _SPIRV_DEF_DECODE2(x, y)                                               \
-  void decode(std::istream &I) override { getDecoder(I) >> (x) >> (y); }
+  void decode(SPIRVInputStream &I) override { getDecoder(I) >> (x) >> (y); }
 #define _SPIRV_DEF_DECODE3(x, y, z)                                            \
-  void decode(std::istream &I) override { getDecoder(I) >> (x) >> (y) >> (z); }
+  void decode(SPIRVInputStream &I) override {                                  \
+    getDecoder(I) >> (x) >> (y) >> (z);                                        \
+  }
 #define _SPIRV_DEF_DECODE4(x, y, z, u)                                         \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u);                                 \
   }
 #define _SPIRV_DEF_DECODE5(x, y, z, u, v)                                      \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v);                          \
   }
 #define _SPIRV_DEF_DECODE6(x, y, z, u, v, w)                                   \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w);                   \
   }
 #define _SPIRV_DEF_DECODE7(x, y, z, u, v, w, r)                                \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r);            \
   }
 #define _SPIRV_DEF_DECODE8(x, y, z, u, v, w, r, s)                             \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r) >> (s);     \
   }
 #define _SPIRV_DEF_DECODE9(x, y, z, u, v, w, r, s, t)                          \
-  void decode(std::istream &I) override {                                      \
+  void decode(SPIRVInputStream &I) override {                                  \
     getDecoder(I) >> (x) >> (y) >> (z) >> (u) >> (v) >> (w) >> (r) >> (s) >>   \
         (t);                                                                   \
   }
@@ -160,7 +164,7 @@ class SPIRVExtInst;
 ///    It is usually called by SPIRVEntry::make(opcode) to create an incomplete
 ///    object which should not be validated. Then setWordCount(count) is
 ///    called to fix the size of the object if it is variable, and then the
-///    information is filled by the virtual function decode(istream).
+///    information is filled by the virtual function decode(SPIRVInputStream).
 ///    After that the object can be validated.
 ///
 /// To add a new SPIRV class:
@@ -215,6 +219,13 @@ public:
 
   virtual ~SPIRVEntry() {}
 
+  // Entries are allocated in the arena given to the SPIRVEntryArenaScope that
+  // is active on this thread, if any, and otherwise on the heap. Deleting an
+  // entry in an arena runs its destructor, but its memory is only freed with
+  // the arena.
+  static void *operator new(size_t Size);
+  static void operator delete(void *Ptr);
+
   bool exist(SPIRVId) const;
   template <class T> T *get(SPIRVId TheId) const {
     return static_cast<T *>(getEntry(TheId));
@@ -227,7 +238,7 @@ public:
   SPIRVType *getValueType(SPIRVId TheId) const;
   std::vector<SPIRVType *> getValueTypes(const std::vector<SPIRVId> &) const;
 
-  virtual SPIRVDecoder getDecoder(std::istream &);
+  virtual SPIRVDecoder getDecoder(SPIRVInputStream &);
   SPIRVErrorLog &getErrorLog() const;
   SPIRVId getId() const {
     assert(hasId());
@@ -301,8 +312,8 @@ public:
   static std::unique_ptr<SPIRVExtInst> createUnique(SPIRVExtInstSetKind Set,
                                                     unsigned ExtOp);
 
-  friend std::istream &operator>>(std::istream &I, SPIRVEntry &E);
-  virtual void decode(std::istream &I);
+  friend SPIRVInputStream &operator>>(SPIRVInputStream &I, SPIRVEntry &E);
+  virtual void decode(SPIRVInputStream &I);
 
   friend class SPIRVDecoder;
 
@@ -362,6 +373,19 @@ protected:
   std::shared_ptr<const SPIRVLine> Line;
 };
 
+/// While an object of this class exists, the SPIRVEntry objects created on
+/// this thread are allocated in the given arena, which must outlive them. This
+/// is used by a module to allocate the many small entries it decodes without
+/// a heap allocation each, and to free them in bulk.
+class SPIRVEntryArenaScope {
+public:
+  explicit SPIRVEntryArenaScope(llvm::BumpPtrAllocator &Arena);
+  ~SPIRVEntryArenaScope();
+
+private:
+  llvm::BumpPtrAllocator *SavedArena;
+};
+
 class SPIRVEntryNoIdGeneric : public SPIRVEntry {
 public:
   SPIRVEntryNoIdGeneric(SPIRVModule *M, unsigned TheWordCount, Op OC)
@@ -56,11 +56,11 @@ SPIRVFunctionParameter::SPIRVFunctionParameter(SPIRVType *TheType,
   validate();
 }
 
-SPIRVDecoder SPIRVFunction::getDecoder(std::istream &IS) {
+SPIRVDecoder SPIRVFunction::getDecoder(SPIRVInputStream &IS) {
   return SPIRVDecoder(IS, *this);
 }
 
-void SPIRVFunction::decode(std::istream &I) {
+void SPIRVFunction::decode(SPIRVInputStream &I) {
   SPIRVDecoder Decoder = getDecoder(I);
   Decoder >> Type >> Id >> FCtrlMask >> FuncType;
   Module->addFunction(this);
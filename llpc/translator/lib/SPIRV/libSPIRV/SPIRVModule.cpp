@@ -347,9 +347,13 @@ public:
                                                SPIRVBasicBlock *) override;
 
   // Input functions
-  friend std::istream &operator>>(std::istream &I, SPIRVModule &M);
+  friend SPIRVInputStream &operator>>(SPIRVInputStream &I, SPIRVModule &M);
 
 private:
+  // Arena for the entries decoded into this module. It is the first member, so
+  // that it is destroyed after the members that may still refer to entries,
+  // such as CurrentLine.
+  llvm::BumpPtrAllocator EntryArena;
   SPIRVErrorLog ErrLog;
   SPIRVId NextId;
   SPIRVWord SPIRVVersion;
@@ -364,7 +368,7 @@ private:
   SPIRVAddressingModelKind AddrModel;
   SPIRVMemoryModelKind MemoryModel;
 
-  typedef std::map<SPIRVId, SPIRVEntry *> SPIRVIdToEntryMap;
+  typedef std::vector<SPIRVEntry *> SPIRVIdToEntryVec;
   typedef std::vector<SPIRVEntry *> SPIRVEntryVector;
   typedef std::set<SPIRVId> SPIRVIdSet;
   typedef std::vector<SPIRVId> SPIRVIdVec;
@@ -378,15 +382,20 @@ private:
   typedef std::vector<SPIRVDecorationGroup *> SPIRVDecGroupVec;
   typedef std::vector<SPIRVGroupDecorateGeneric *> SPIRVGroupDecVec;
   typedef std::vector<SPIRVEntryPoint *> SPIRVEnetryPointVec;
-  typedef std::map<SPIRVId, SPIRVExtInstSetKind> SPIRVIdToBuiltinSetMap;
+  typedef std::unordered_map<SPIRVId, SPIRVExtInstSetKind>
+      SPIRVIdToBuiltinSetMap;
   typedef std::unordered_map<std::string, SPIRVString *> SPIRVStringMap;
-  typedef std::map<SPIRVTypeStruct *, std::vector<std::pair<unsigned, SPIRVId>>>
+  typedef std::unordered_map<SPIRVTypeStruct *,
+                             std::vector<std::pair<unsigned, SPIRVId>>>
       SPIRVUnknownStructFieldMap;
 
   SPIRVEntryVector ExecModeIdVec;
   SPIRVForwardPointerVec ForwardPointerVec;
   SPIRVTypeVec TypeVec;
-  SPIRVIdToEntryMap IdEntryMap;
+  // Entry of each id, indexed by id, or nullptr for an id that has no entry.
+  // SPIR-V ids are dense and below the bound in the module header, so this is
+  // sized from that bound when reading a module.
+  SPIRVIdToEntryVec IdEntryVec;
   SPIRVFunctionVector FuncVec;
   SPIRVConstantVector ConstVec;
   SPIRVVariableVec VariableVec;
@@ -403,17 +412,18 @@ private:
   SPIRVStringMap StrMap;
   SPIRVCapMap CapMap;
   SPIRVUnknownStructFieldMap UnknownStructFieldMap;
-  std::map<unsigned, SPIRVTypeInt *> IntTypeMap;
-  std::map<unsigned, SPIRVConstant *> LiteralMap;
+  std::unordered_map<unsigned, SPIRVTypeInt *> IntTypeMap;
+  std::unordered_map<unsigned, SPIRVConstant *> LiteralMap;
   std::vector<SPIRVExtInst *> DebugInstVec;
 
   void layoutEntry(SPIRVEntry *Entry);
+  void setIdEntry(SPIRVId Id, SPIRVEntry *Entry);
 };
 
 SPIRVModuleImpl::~SPIRVModuleImpl() {
 
-  for (auto I : IdEntryMap)
-    delete I.second;
+  for (auto I : IdEntryVec)
+    delete I;
 
   for (auto I : EntryNoId) {
     if (I->getOpCode() == OpLine)
@@ -592,7 +602,7 @@ SPIRVEntry *SPIRVModuleImpl::addEntry(SPIRVEntry *Entry) {
         assert(Mapped == Entry && "Id used twice");
       }
     } else
-      IdEntryMap[Id] = Entry;
+      setIdEntry(Id, Entry);
   } else {
     if (EntryNoId.empty() || Entry !=  EntryNoId.back())
       EntryNoId.push_back(Entry);
@@ -619,14 +629,20 @@ bool SPIRVModuleImpl::exist(SPIRVId Id) const { return exist(Id, nullptr); }
 
 bool SPIRVModuleImpl::exist(SPIRVId Id, SPIRVEntry **Entry) const {
   assert(Id != SPIRVID_INVALID && "Invalid Id");
-  SPIRVIdToEntryMap::const_iterator Loc = IdEntryMap.find(Id);
-  if (Loc == IdEntryMap.end())
+  if (Id >= IdEntryVec.size() || !IdEntryVec[Id])
     return false;
   if (Entry)
-    *Entry = Loc->second;
+    *Entry = IdEntryVec[Id];
   return true;
 }
 
+// Set the entry of an id, growing the id table if the id is beyond it.
+void SPIRVModuleImpl::setIdEntry(SPIRVId Id, SPIRVEntry *Entry) {
+  if (Id >= IdEntryVec.size())
+    IdEntryVec.resize(Id + 1);
+  IdEntryVec[Id] = Entry;
+}
+
 // If Id is invalid, returns the next available id.
 // Otherwise returns the given id and adjust the next available id by increment.
 SPIRVId SPIRVModuleImpl::getId(SPIRVId Id, unsigned Increment) {
@@ -640,9 +656,8 @@ SPIRVId SPIRVModuleImpl::getId(SPIRVId Id, unsigned Increment) {
 
 SPIRVEntry *SPIRVModuleImpl::getEntry(SPIRVId Id) const {
   assert(Id != SPIRVID_INVALID && "Invalid Id");
-  SPIRVIdToEntryMap::const_iterator Loc = IdEntryMap.find(Id);
-  assert(Loc != IdEntryMap.end() && "Id is not in map");
-  return Loc->second;
+  assert(Id < IdEntryVec.size() && IdEntryVec[Id] && "Id is not in map");
+  return IdEntryVec[Id];
 }
 
 SPIRVExtInstSetKind SPIRVModuleImpl::getBuiltinSet(SPIRVId SetId) const {
@@ -873,13 +888,12 @@ SPIRVEntry *SPIRVModuleImpl::replaceForward(SPIRVForward *Forward,
   SPIRVId Id = Entry->getId();
   SPIRVId ForwardId = Forward->getId();
   if (ForwardId == Id)
-    IdEntryMap[Id] = Entry;
+    setIdEntry(Id, Entry);
   else {
-    auto Loc = IdEntryMap.find(Id);
-    assert(Loc != IdEntryMap.end());
-    IdEntryMap.erase(Loc);
+    assert(Id < IdEntryVec.size() && IdEntryVec[Id]);
+    IdEntryVec[Id] = nullptr;
     Entry->setId(ForwardId);
-    IdEntryMap[ForwardId] = Entry;
+    setIdEntry(ForwardId, Entry);
   }
   // Annotations include name, decorations, execution modes
   Entry->takeAnnotations(Forward);
@@ -898,9 +912,8 @@ void SPIRVModuleImpl::eraseInstruction(SPIRVInstruction *I,
                                        SPIRVBasicBlock *BB) {
   SPIRVId Id = I->getId();
   BB->eraseInstruction(I);
-  auto Loc = IdEntryMap.find(Id);
-  assert(Loc != IdEntryMap.end());
-  IdEntryMap.erase(Loc);
+  assert(Id < IdEntryVec.size() && IdEntryVec[Id]);
+  IdEntryVec[Id] = nullptr;
   delete I;
 }
 
@@ -1292,9 +1305,11 @@ void SPIRVModuleImpl::addUnknownStructField(SPIRVTypeStruct *Struct, unsigned I,
   UnknownStructFieldMap[Struct].push_back(std::make_pair(I, ID));
 }
 
-std::istream &operator>>(std::istream &I, SPIRVModule &M) {
+SPIRVInputStream &operator>>(SPIRVInputStream &I, SPIRVModule &M) {
   SPIRVDecoder Decoder(I, M);
   SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl *>(&M);
+  // Allocate the decoded entries in the module's arena.
+  SPIRVEntryArenaScope ArenaScope(MI.EntryArena);
   // Disable automatic capability filling.
   MI.setAutoAddCapability(false);
 
@@ -1312,6 +1327,7 @@ std::istream &operator>>(std::istream &I, SPIRVModule &M) {
 
   // Bound for Id
   Decoder >> MI.NextId;
+  MI.IdEntryVec.resize(MI.NextId);
 
   Decoder >> MI.InstSchema;
   assert(MI.InstSchema == SPIRVISCH_Default &&
@@ -55,6 +55,7 @@ class SPIRVBasicBlock;
 class SPIRVConstant;
 class SPIRVEntry;
 class SPIRVFunction;
+class SPIRVInputStream;
 class SPIRVInstruction;
 class SPIRVType;
 class SPIRVTypeArray;
@@ -345,7 +346,7 @@ public:
                                                        SPIRVValue *,
                                                        SPIRVBasicBlock *) = 0;
   // Input functions
-  friend std::istream &operator>>(std::istream &I, SPIRVModule &M);
+  friend SPIRVInputStream &operator>>(SPIRVInputStream &I, SPIRVModule &M);
 
 protected:
   bool AutoAddCapability;
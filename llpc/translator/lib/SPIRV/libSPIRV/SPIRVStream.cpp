@@ -44,11 +44,11 @@
 
 namespace SPIRV {
 
-SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVFunction &F)
+SPIRVDecoder::SPIRVDecoder(SPIRVInputStream &InputStream, SPIRVFunction &F)
     : IS(InputStream), M(*F.getModule()), WordCount(0), OpCode(OpNop),
       Scope(&F) {}
 
-SPIRVDecoder::SPIRVDecoder(std::istream &InputStream, SPIRVBasicBlock &BB)
+SPIRVDecoder::SPIRVDecoder(SPIRVInputStream &InputStream, SPIRVBasicBlock &BB)
     : IS(InputStream), M(*BB.getModule()), WordCount(0), OpCode(OpNop),
       Scope(&BB) {}
 
@@ -75,20 +75,25 @@ SPIRV_DEF_ENCDEC(SPIRVDebugExtOpKind)
 SPIRV_DEF_ENCDEC(LinkageType)
 
 // Read a string with padded 0's at the end so that they form a stream of
-// words.
-const SPIRVDecoder &operator>>(const SPIRVDecoder &I, std::string &Str) {
-  uint64_t Count = 0;
-  char Ch;
-  while (I.IS.get(Ch) && Ch != '\0') {
-    Str += Ch;
-    ++Count;
-  }
-  Count = (Count + 1) % 4;
-  Count = Count ? 4 - Count : 0;
-  for (; Count; --Count) {
-    I.IS >> Ch;
-    assert(Ch == '\0' && "Invalid string in SPIRV");
+// words. The string is appended in one go, rather than character by
+// character.
+void SPIRVInputStream::readString(std::string &Str) {
+  const char *Nul = std::find(Cur, End, '\0');
+  Str.append(Cur, Nul);
+  if (Nul == End) {
+    Cur = End;
+    Failed = true;
+    return;
   }
+  size_t Size = (Nul - Cur + sizeof(SPIRVWord)) / sizeof(SPIRVWord) *
+                sizeof(SPIRVWord);
+  assert(std::all_of(Nul, Cur + Size, [](char Ch) { return Ch == '\0'; }) &&
+         "Invalid string in SPIRV");
+  Cur += Size;
+}
+
+const SPIRVDecoder &operator>>(const SPIRVDecoder &I, std::string &Str) {
+  I.IS.readString(Str);
   return I;
 }
 
@@ -102,7 +107,6 @@ bool SPIRVDecoder::getWordCountAndOpCode() {
   *this >> WordCountAndOpCode;
   WordCount = WordCountAndOpCode >> 16;
   OpCode = static_cast<Op>(WordCountAndOpCode & 0xFFFF);
-  assert(!IS.bad() && "SPIRV stream is bad");
   if (IS.fail()) {
     WordCount = 0;
     OpCode = OpNop;
@@ -125,7 +129,7 @@ SPIRVEntry *SPIRVDecoder::getEntry() {
   IS >> *Entry;
   if(Entry->isEndOfBlock() || OpCode == OpNoLine)
     M.setCurrentLine(nullptr);
-  assert(!IS.bad() && !IS.fail() && "SPIRV stream fails");
+  assert(!IS.fail() && "SPIRV stream fails");
   M.add(Entry);
   return Entry;
 }
@@ -133,7 +137,7 @@ SPIRVEntry *SPIRVDecoder::getEntry() {
 void SPIRVDecoder::validate() const {
   assert(OpCode != OpNop && "Invalid op code");
   assert(WordCount && "Invalid word count");
-  assert(!IS.bad() && "Bad iInput stream");
+  assert(!IS.fail() && "Bad iInput stream");
 }
 
 } // namespace SPIRV
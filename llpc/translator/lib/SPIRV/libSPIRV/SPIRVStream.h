@@ -45,7 +45,7 @@
 #include "SPIRVModule.h"
 #include <algorithm>
 #include <cstdint>
-#include <iostream>
+#include <cstring>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -55,19 +55,56 @@ namespace SPIRV {
 class SPIRVFunction;
 class SPIRVBasicBlock;
 
+// Input stream that reads a SPIR-V binary straight from the memory it is in,
+// without copying it.
+class SPIRVInputStream {
+public:
+  SPIRVInputStream(const void *Data, size_t Size)
+      : Cur(static_cast<const char *>(Data)),
+        End(Cur + Size / sizeof(SPIRVWord) * sizeof(SPIRVWord)) {}
+
+  // Whether all of the words have been read.
+  bool eof() const { return Cur == End; }
+  // Whether a read went past the end.
+  bool fail() const { return Failed; }
+  // Get the read position.
+  const char *tell() const { return Cur; }
+
+  // Read the next word, or 0 (setting fail()) if there are none left.
+  SPIRVWord readWord() {
+    SPIRVWord W = 0;
+    if (Cur == End) {
+      Failed = true;
+      return W;
+    }
+    memcpy(&W, Cur, sizeof(W));
+    Cur += sizeof(W);
+    return W;
+  }
+
+  // Read a literal string and the padding after it up to the next word
+  // boundary, appending the string to Str.
+  void readString(std::string &Str);
+
+private:
+  const char *Cur;
+  const char *End;
+  bool Failed = false;
+};
+
 class SPIRVDecoder {
 public:
-  SPIRVDecoder(std::istream &InputStream, SPIRVModule &Module)
+  SPIRVDecoder(SPIRVInputStream &InputStream, SPIRVModule &Module)
       : IS(InputStream), M(Module), WordCount(0), OpCode(OpNop), Scope(NULL) {}
-  SPIRVDecoder(std::istream &InputStream, SPIRVFunction &F);
-  SPIRVDecoder(std::istream &InputStream, SPIRVBasicBlock &BB);
+  SPIRVDecoder(SPIRVInputStream &InputStream, SPIRVFunction &F);
+  SPIRVDecoder(SPIRVInputStream &InputStream, SPIRVBasicBlock &BB);
 
   void setScope(SPIRVEntry *);
   bool getWordCountAndOpCode();
   SPIRVEntry *getEntry();
   void validate() const;
 
-  std::istream &IS;
+  SPIRVInputStream &IS;
   SPIRVModule &M;
   SPIRVWord WordCount;
   Op OpCode;
@@ -76,9 +113,7 @@ public:
 
 template <typename T>
 const SPIRVDecoder &decodeBinary(const SPIRVDecoder &I, T &V) {
-  uint32_t W;
-  I.IS.read(reinterpret_cast<char *>(&W), sizeof(W));
-  V = static_cast<T>(W);
+  V = static_cast<T>(I.IS.readWord());
   return I;
 }
 
@@ -290,7 +290,7 @@ SPIRVTypeRuntimeArray::validate()const {
 
 _SPIRV_IMP_ENCDEC2(SPIRVTypeRuntimeArray, Id, ElemType)
 
-void SPIRVTypeForwardPointer::decode(std::istream &I) {
+void SPIRVTypeForwardPointer::decode(SPIRVInputStream &I) {
   auto Decoder = getDecoder(I);
   Decoder >> Id >> SC;
 }
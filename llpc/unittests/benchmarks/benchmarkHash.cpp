@@ -0,0 +1,83 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcCrc.h"
+#include "vkgcMetroHash.h"
+#include "benchmark/benchmark.h"
+#include <vector>
+
+namespace Llpc {
+namespace {
+
+// Returns a buffer of pseudo-random bytes.
+std::vector<uint8_t> makeData(size_t size) {
+  std::vector<uint8_t> data(size);
+  uint32_t state = 12345;
+  for (uint8_t &byte : data) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(state >> 16);
+  }
+  return data;
+}
+
+// Sizes of the hashed data: from a small structure such as the options of a pipeline, through a SPIR-V module, to a
+// large cache entry.
+void hashSizes(benchmark::internal::Benchmark *bench) {
+  bench->RangeMultiplier(16)->Range(64, 4 << 20);
+}
+
+// Measure MetroHash64, as used for shader module and pipeline hashes.
+void metroHash64(benchmark::State &state) {
+  const std::vector<uint8_t> data = makeData(state.range(0));
+  MetroHash::Hash hash = {};
+  for (auto _ : state) {
+    MetroHash64::Hash(data.data(), data.size(), hash.bytes);
+    benchmark::DoNotOptimize(hash);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(metroHash64)->Apply(hashSizes);
+
+// Measure the CRC-32C of shader cache entries, with the implementation that the host uses.
+void crc32c(benchmark::State &state) {
+  const std::vector<uint8_t> data = makeData(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(calculateCrc32c(data.data(), data.size()));
+  state.SetBytesProcessed(state.iterations() * data.size());
+  state.SetLabel(hasHardwareCrc32c() ? "hardware" : "portable");
+}
+BENCHMARK(crc32c)->Apply(hashSizes);
+
+// Measure the portable CRC-32C, which is used where the host has no crc32 instruction.
+void crc32cPortable(benchmark::State &state) {
+  const std::vector<uint8_t> data = makeData(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(calculateCrc32cPortable(data.data(), data.size()));
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(crc32cPortable)->Apply(hashSizes);
+
+} // namespace
+} // namespace Llpc
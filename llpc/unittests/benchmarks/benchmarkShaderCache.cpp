@@ -0,0 +1,105 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcShaderCache.h"
+#include "vkgcMetroHash.h"
+#include "benchmark/benchmark.h"
+#include <cassert>
+#include <vector>
+
+namespace Llpc {
+namespace {
+
+// Number of distinct shader hashes that the lookups cycle through
+constexpr unsigned NumShaders = 4096;
+
+// Returns the runtime shader cache shared by the threads of the benchmarks, created on first use.
+ShaderCache &getSharedCache() {
+  static ShaderCache *const Cache = [] {
+    ShaderCache *cache = new ShaderCache();
+    ShaderCacheCreateInfo createInfo = {};
+    ShaderCacheAuxCreateInfo auxCreateInfo = {};
+    auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+    auxCreateInfo.gfxIp = {9, 0, 0};
+    Result result = cache->init(&createInfo, &auxCreateInfo);
+    (void)result;
+    assert(result == Result::Success);
+    return cache;
+  }();
+  return *Cache;
+}
+
+// Returns the hash of the shader with the given index.
+MetroHash::Hash getShaderHash(unsigned index) {
+  MetroHash::Hash hash = {};
+  hash.dwords[0] = index;
+  hash.dwords[1] = index * 0x9E3779B9u;
+  return hash;
+}
+
+// Measure the shader cache lookups of the threads compiling pipelines at the same time: each lookup finds a shader,
+// and the first thread to miss inserts it. After the first pass over the hashes, this is the contention of the cache
+// lock in the steady state of a running application.
+void shaderCacheFindOrInsert(benchmark::State &state) {
+  ShaderCache &cache = getSharedCache();
+  const std::vector<char> blob(state.range(0), 'x');
+  unsigned index = state.thread_index() * 97;
+  for (auto _ : state) {
+    CacheEntryHandle handle = nullptr;
+    ShaderEntryState entryState = cache.findShader(getShaderHash(index++ % NumShaders), true, &handle);
+    if (entryState == ShaderEntryState::Compiling)
+      cache.insertShader(handle, blob.data(), blob.size());
+    benchmark::DoNotOptimize(handle);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(shaderCacheFindOrInsert)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+
+// Measure the lookups and retrievals of shaders that are all in the cache.
+void shaderCacheRetrieve(benchmark::State &state) {
+  ShaderCache &cache = getSharedCache();
+  const std::vector<char> blob(state.range(0), 'x');
+  if (state.thread_index() == 0) {
+    for (unsigned index = 0; index != NumShaders; ++index) {
+      CacheEntryHandle handle = nullptr;
+      if (cache.findShader(getShaderHash(index), true, &handle) == ShaderEntryState::Compiling)
+        cache.insertShader(handle, blob.data(), blob.size());
+    }
+  }
+  unsigned index = state.thread_index() * 97;
+  for (auto _ : state) {
+    CacheEntryHandle handle = nullptr;
+    const void *data = nullptr;
+    size_t dataSize = 0;
+    if (cache.findShader(getShaderHash(index++ % NumShaders), false, &handle) == ShaderEntryState::Ready)
+      (void)cache.retrieveShader(handle, &data, &dataSize);
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(shaderCacheRetrieve)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+} // namespace Llpc
@@ -0,0 +1,59 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcThreading.h"
+#include "llvm/Support/Error.h"
+#include "benchmark/benchmark.h"
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+namespace Llpc {
+namespace {
+
+// Measure the overhead of parallelFor with short tasks, as when the shader stages of a pipeline are compiled in
+// parallel: each iteration runs a loop of 64 tasks that each do a small amount of work.
+void parallelForShortTasks(benchmark::State &state) {
+  const size_t numThreads = state.range(0);
+  std::vector<unsigned> inputs(64);
+  std::iota(inputs.begin(), inputs.end(), 0);
+  std::atomic<uint64_t> sum(0);
+  for (auto _ : state) {
+    llvm::Error err = parallelFor(numThreads, inputs, [&sum](unsigned input) {
+      uint64_t value = input;
+      for (unsigned i = 0; i != 256; ++i)
+        value = value * 6364136223846793005u + 1442695040888963407u;
+      sum += value;
+      return llvm::Error::success();
+    });
+    llvm::consumeError(std::move(err));
+  }
+  benchmark::DoNotOptimize(sum.load());
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(parallelForShortTasks)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+} // namespace
+} // namespace Llpc
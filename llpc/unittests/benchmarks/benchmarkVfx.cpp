@@ -0,0 +1,107 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "vfx.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "benchmark/benchmark.h"
+
+namespace Vfx {
+namespace {
+
+// Pipeline file with the state sections that every graphics pipeline file has; shader sections are left out, so that
+// only the parsing is measured and not the compilation of GLSL.
+constexpr const char PipelineText[] = R"([Version]
+version = 40
+
+[GraphicsPipelineState]
+topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+polygonMode = VK_POLYGON_MODE_FILL
+cullMode = VK_CULL_MODE_BACK_BIT
+frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE
+depthClipEnable = 1
+numSamples = 1
+colorBuffer[0].format = VK_FORMAT_R8G8B8A8_UNORM
+colorBuffer[0].channelWriteMask = 15
+colorBuffer[0].blendEnable = 1
+colorBuffer[0].blendSrcAlphaToColor = 1
+colorBuffer[1].format = VK_FORMAT_R16G16B16A16_SFLOAT
+colorBuffer[1].channelWriteMask = 15
+
+[VertexInputState]
+binding[0].binding = 0
+binding[0].stride = 32
+binding[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+binding[1].binding = 1
+binding[1].stride = 16
+binding[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+attribute[0].location = 0
+attribute[0].binding = 0
+attribute[0].format = VK_FORMAT_R32G32B32_SFLOAT
+attribute[0].offset = 0
+attribute[1].location = 1
+attribute[1].binding = 0
+attribute[1].format = VK_FORMAT_R32G32_SFLOAT
+attribute[1].offset = 12
+attribute[2].location = 2
+attribute[2].binding = 0
+attribute[2].format = VK_FORMAT_R8G8B8A8_UNORM
+attribute[2].offset = 20
+attribute[3].location = 3
+attribute[3].binding = 1
+attribute[3].format = VK_FORMAT_R32G32B32A32_SFLOAT
+attribute[3].offset = 0
+)";
+
+// Measure the parsing of a pipeline file, as done for each pipeline that amdllpc compiles.
+void vfxParsePipeline(benchmark::State &state) {
+  llvm::SmallString<128> fileName;
+  int fd = -1;
+  if (llvm::sys::fs::createTemporaryFile("benchmarkVfx", "pipe", fd, fileName)) {
+    state.SkipWithError("cannot create the pipeline file");
+    return;
+  }
+  {
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    out << PipelineText;
+  }
+
+  for (auto _ : state) {
+    void *doc = nullptr;
+    const char *errorMsg = nullptr;
+    if (!vfxParseFile(fileName.c_str(), 0, nullptr, VfxDocTypePipeline, &doc, &errorMsg)) {
+      state.SkipWithError(errorMsg ? errorMsg : "cannot parse the pipeline file");
+      break;
+    }
+    vfxCloseDoc(doc);
+  }
+  state.SetBytesProcessed(state.iterations() * (sizeof(PipelineText) - 1));
+  llvm::sys::fs::remove(fileName);
+}
+BENCHMARK(vfxParsePipeline);
+
+} // namespace
+} // namespace Vfx
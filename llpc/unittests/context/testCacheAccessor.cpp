@@ -0,0 +1,186 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcCacheAccessor.h"
+#include "vkgcDefs.h"
+#include "vkgcMetroHash.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace Llpc {
+namespace {
+
+// A simple in-memory ICache that counts how it is queried.
+class CountingCache : public Vkgc::ICache {
+public:
+  Result GetEntry(Vkgc::HashId hash, bool allocateOnMiss, Vkgc::EntryHandle *handle) override {
+    ++m_numGetEntryCalls;
+    std::string key(reinterpret_cast<const char *>(hash.bytes), sizeof(hash.bytes));
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->second.ready) {
+      *handle = Vkgc::EntryHandle(this, &it->second, false);
+      return Result::Success;
+    }
+    if (allocateOnMiss)
+      *handle = Vkgc::EntryHandle(this, &m_entries[key], true);
+    return Result::NotFound;
+  }
+
+  void GetEntries(const Vkgc::HashId *hashes, unsigned hashCount, bool allocateOnMiss, Vkgc::EntryHandle *handles,
+                  Result *results) override {
+    ++m_numGetEntriesCalls;
+    m_numBatchedHashes += hashCount;
+    ICache::GetEntries(hashes, hashCount, allocateOnMiss, handles, results);
+  }
+
+  void ReleaseEntry(Vkgc::RawEntryHandle) override {}
+
+  Result WaitForEntry(Vkgc::RawEntryHandle) override { return Result::Success; }
+
+  Result GetValue(Vkgc::RawEntryHandle rawHandle, void *data, size_t *dataLen) override {
+    const Entry *entry = static_cast<const Entry *>(rawHandle);
+    if (data)
+      memcpy(data, entry->value.data(), std::min(*dataLen, entry->value.size()));
+    *dataLen = entry->value.size();
+    return Result::Success;
+  }
+
+  Result GetValueZeroCopy(Vkgc::RawEntryHandle rawHandle, const void **data, size_t *dataLen) override {
+    const Entry *entry = static_cast<const Entry *>(rawHandle);
+    *data = entry->value.data();
+    *dataLen = entry->value.size();
+    return Result::Success;
+  }
+
+  Result SetValue(Vkgc::RawEntryHandle rawHandle, bool success, const void *data, size_t dataLen) override {
+    Entry *entry = static_cast<Entry *>(rawHandle);
+    if (success)
+      entry->value.assign(static_cast<const char *>(data), static_cast<const char *>(data) + dataLen);
+    entry->ready = success;
+    return Result::Success;
+  }
+
+  unsigned m_numGetEntryCalls = 0;
+  unsigned m_numGetEntriesCalls = 0;
+  unsigned m_numBatchedHashes = 0;
+
+private:
+  struct Entry {
+    std::vector<char> value;
+    bool ready = false;
+  };
+  std::map<std::string, Entry> m_entries;
+};
+
+// Creates a hash from a single dword.
+MetroHash::Hash hashFromDWord(unsigned value) {
+  MetroHash::Hash hash = {};
+  hash.dwords[0] = value;
+  return hash;
+}
+
+// Adds an entry with the given value to the caches of the build info.
+void addEntry(const ComputePipelineBuildInfo *buildInfo, CachePair internalCaches, MetroHash::Hash hash,
+              const std::string &value) {
+  CacheAccessor cacheAccessor(buildInfo, hash, internalCaches);
+  ASSERT_FALSE(cacheAccessor.isInCache());
+  cacheAccessor.setElfInCache({value.size(), value.data()});
+  EXPECT_TRUE(cacheAccessor.isInCache());
+}
+
+// Returns the ELF found by the cache accessor as a string.
+std::string getElf(const CacheAccessor &cacheAccessor) {
+  BinaryData elf = cacheAccessor.getElfFromCache();
+  return std::string(static_cast<const char *>(elf.pCode), elf.codeSize);
+}
+
+// cppcheck-suppress syntaxError
+TEST(CacheAccessorTest, LookUpAllBatchesApplicationCache) {
+  CountingCache applicationCache;
+  ComputePipelineBuildInfo buildInfo = {};
+  buildInfo.cache = &applicationCache;
+
+  addEntry(&buildInfo, {}, hashFromDWord(1), "first");
+  addEntry(&buildInfo, {}, hashFromDWord(2), "second");
+  applicationCache.m_numGetEntryCalls = 0;
+
+  MetroHash::Hash hashes[] = {hashFromDWord(1), hashFromDWord(3), hashFromDWord(2)};
+  std::vector<CacheAccessor> cacheAccessors = CacheAccessor::lookUpAll(&buildInfo, hashes, {});
+  ASSERT_EQ(cacheAccessors.size(), 3u);
+  EXPECT_EQ(applicationCache.m_numGetEntriesCalls, 1u);
+  EXPECT_EQ(applicationCache.m_numBatchedHashes, 3u);
+
+  EXPECT_TRUE(cacheAccessors[0].isInCache());
+  EXPECT_FALSE(cacheAccessors[0].hitInternalCache());
+  EXPECT_EQ(getElf(cacheAccessors[0]), "first");
+  EXPECT_FALSE(cacheAccessors[1].isInCache());
+  EXPECT_TRUE(cacheAccessors[2].isInCache());
+  EXPECT_EQ(getElf(cacheAccessors[2]), "second");
+
+  // The miss allocated an entry that can be populated as with a single lookup.
+  std::string third = "third";
+  cacheAccessors[1].setElfInCache({third.size(), third.data()});
+  CacheAccessor cacheAccessor(&buildInfo, hashes[1], {});
+  EXPECT_TRUE(cacheAccessor.isInCache());
+  EXPECT_EQ(getElf(cacheAccessor), "third");
+}
+
+TEST(CacheAccessorTest, LookUpAllChecksApplicationCacheForInternalMisses) {
+  CountingCache internalCache;
+  CountingCache applicationCache;
+  ComputePipelineBuildInfo buildInfo = {};
+  buildInfo.cache = &applicationCache;
+  CachePair internalCaches = {&internalCache, nullptr};
+
+  // With an application cache, new entries are allocated only there.
+  addEntry(&buildInfo, internalCaches, hashFromDWord(1), "application");
+  ComputePipelineBuildInfo internalOnlyInfo = {};
+  addEntry(&internalOnlyInfo, internalCaches, hashFromDWord(2), "internal");
+
+  MetroHash::Hash hashes[] = {hashFromDWord(1), hashFromDWord(2)};
+  std::vector<CacheAccessor> cacheAccessors = CacheAccessor::lookUpAll(&buildInfo, hashes, internalCaches);
+  ASSERT_EQ(cacheAccessors.size(), 2u);
+
+  EXPECT_EQ(internalCache.m_numGetEntriesCalls, 1u);
+  EXPECT_EQ(internalCache.m_numBatchedHashes, 2u);
+  EXPECT_EQ(applicationCache.m_numGetEntriesCalls, 1u);
+  EXPECT_EQ(applicationCache.m_numBatchedHashes, 1u);
+
+  EXPECT_TRUE(cacheAccessors[0].isInCache());
+  EXPECT_FALSE(cacheAccessors[0].hitInternalCache());
+  EXPECT_EQ(getElf(cacheAccessors[0]), "application");
+  EXPECT_TRUE(cacheAccessors[1].isInCache());
+  EXPECT_TRUE(cacheAccessors[1].hitInternalCache());
+  EXPECT_EQ(getElf(cacheAccessors[1]), "internal");
+}
+
+} // namespace
+} // namespace Llpc
@@ -0,0 +1,102 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  testInFlightBuildTable.cpp
+ * @brief LLPC source file: contains tests of class Llpc::InFlightBuildTable.
+ ***********************************************************************************************************************
+ */
+#include "llpcCompiler.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+namespace Llpc {
+namespace {
+
+MetroHash::Hash makeHash(uint64_t value) {
+  MetroHash::Hash hash = {};
+  hash.qwords[0] = value;
+  return hash;
+}
+
+// cppcheck-suppress syntaxError
+TEST(InFlightBuildTableTest, LaterRequestSharesFirstBuild) {
+  InFlightBuildTable table;
+  bool isOwner = false;
+  std::shared_ptr<InFlightBuildTable::Build> owned = table.join(makeHash(1), &isOwner);
+  EXPECT_TRUE(isOwner);
+
+  std::shared_ptr<InFlightBuildTable::Build> joined = table.join(makeHash(1), &isOwner);
+  EXPECT_FALSE(isOwner);
+  EXPECT_EQ(joined, owned);
+
+  // A different pipeline gets its own build.
+  table.join(makeHash(2), &isOwner);
+  EXPECT_TRUE(isOwner);
+
+  Result result = Result::ErrorUnknown;
+  ElfPackage elf;
+  bool shared = false;
+  std::thread waiter([&] { shared = InFlightBuildTable::wait(*joined, &result, &elf); });
+  table.complete(*owned, Result::Success, ElfPackage("elf"));
+  waiter.join();
+  EXPECT_TRUE(shared);
+  EXPECT_EQ(result, Result::Success);
+  EXPECT_EQ(elf.str(), "elf");
+
+  // Once the build has completed, the next request starts a new one.
+  table.join(makeHash(1), &isOwner);
+  EXPECT_TRUE(isOwner);
+}
+
+TEST(InFlightBuildTableTest, CancelledBuildIsNotShared) {
+  InFlightBuildTable table;
+  bool isOwner = false;
+  std::shared_ptr<InFlightBuildTable::Build> owned = table.join(makeHash(1), &isOwner);
+  std::shared_ptr<InFlightBuildTable::Build> joined = table.join(makeHash(1), &isOwner);
+  table.complete(*owned, Result::ErrorUnavailable, ElfPackage());
+
+  Result result = Result::ErrorUnknown;
+  ElfPackage elf;
+  EXPECT_FALSE(InFlightBuildTable::wait(*joined, &result, &elf));
+  EXPECT_EQ(result, Result::ErrorUnknown);
+}
+
+TEST(InFlightBuildTableTest, FailureIsShared) {
+  InFlightBuildTable table;
+  bool isOwner = false;
+  std::shared_ptr<InFlightBuildTable::Build> owned = table.join(makeHash(1), &isOwner);
+  std::shared_ptr<InFlightBuildTable::Build> joined = table.join(makeHash(1), &isOwner);
+  table.complete(*owned, Result::ErrorInvalidShader, ElfPackage());
+
+  Result result = Result::Success;
+  ElfPackage elf;
+  EXPECT_TRUE(InFlightBuildTable::wait(*joined, &result, &elf));
+  EXPECT_EQ(result, Result::ErrorInvalidShader);
+  EXPECT_TRUE(elf.empty());
+}
+
+} // namespace
+} // namespace Llpc
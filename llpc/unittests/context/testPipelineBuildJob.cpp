@@ -0,0 +1,114 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcPipelineBuildJob.h"
+#include "llpcThreading.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+
+namespace Llpc {
+namespace {
+
+// Completion callback that counts its calls and records the last result.
+struct CallbackRecord {
+  std::atomic<unsigned> numCalls{0};
+  std::atomic<Result> lastResult{Result::ErrorUnknown};
+};
+
+void VKAPI_CALL recordCompletion(void *userData, Result result) {
+  auto *record = static_cast<CallbackRecord *>(userData);
+  record->lastResult = result;
+  ++record->numCalls;
+}
+
+// cppcheck-suppress syntaxError
+TEST(PipelineBuildJobTest, RunsBuildAndCallsBack) {
+  CallbackRecord record;
+  auto build = [](const std::atomic<bool> *) { return Result::ErrorInvalidShader; };
+  std::shared_ptr<PipelineBuildJob> job = PipelineBuildJob::create(build, recordCompletion, &record);
+  EXPECT_FALSE(job->IsComplete());
+
+  ThreadPool::getGlobal().submit([job] { job->run(); });
+  EXPECT_EQ(job->Wait(), Result::ErrorInvalidShader);
+  EXPECT_TRUE(job->IsComplete());
+  EXPECT_EQ(record.numCalls, 1u);
+  EXPECT_EQ(record.lastResult, Result::ErrorInvalidShader);
+  job->Destroy();
+}
+
+TEST(PipelineBuildJobTest, CancelBeforeStart) {
+  CallbackRecord record;
+  std::atomic<bool> built(false);
+  std::shared_ptr<PipelineBuildJob> job = PipelineBuildJob::create(
+      [&built](const std::atomic<bool> *) {
+        built = true;
+        return Result::Success;
+      },
+      recordCompletion, &record);
+
+  job->Cancel();
+  EXPECT_TRUE(job->IsComplete());
+  EXPECT_EQ(job->Wait(), Result::ErrorUnavailable);
+
+  // Running a cancelled job does nothing.
+  job->run();
+  EXPECT_FALSE(built);
+  EXPECT_EQ(record.numCalls, 1u);
+  EXPECT_EQ(record.lastResult, Result::ErrorUnavailable);
+  job->Destroy();
+}
+
+TEST(PipelineBuildJobTest, CancelAfterCompletion) {
+  auto build = [](const std::atomic<bool> *) { return Result::Success; };
+  std::shared_ptr<PipelineBuildJob> job = PipelineBuildJob::create(build, nullptr, nullptr);
+  job->run();
+  job->Cancel();
+  EXPECT_EQ(job->Wait(), Result::Success);
+  job->Destroy();
+}
+
+TEST(PipelineBuildJobTest, CancelWhileRunning) {
+  std::atomic<bool> started(false);
+  std::shared_ptr<PipelineBuildJob> job = PipelineBuildJob::create(
+      [&started](const std::atomic<bool> *cancelFlag) {
+        started = true;
+        // Simulate a build that stops at a cancellation point and fails.
+        while (!*cancelFlag)
+          std::this_thread::yield();
+        return Result::ErrorInvalidShader;
+      },
+      nullptr, nullptr);
+
+  ThreadPool::getGlobal().submit([job] { job->run(); });
+  while (!started)
+    std::this_thread::yield();
+  job->Cancel();
+  EXPECT_EQ(job->Wait(), Result::ErrorUnavailable);
+  job->Destroy();
+}
+
+} // namespace
+} // namespace Llpc
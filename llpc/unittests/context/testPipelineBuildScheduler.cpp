@@ -0,0 +1,152 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  testPipelineBuildScheduler.cpp
+ * @brief LLPC source file: contains tests of class Llpc::PipelineBuildScheduler.
+ ***********************************************************************************************************************
+ */
+#include "llpcPipelineBuildScheduler.h"
+#include "llpcThreading.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Llpc {
+namespace {
+
+// Spins until the flag is raised.
+void waitFor(const std::atomic<bool> &flag) {
+  while (!flag)
+    std::this_thread::yield();
+}
+
+// cppcheck-suppress syntaxError
+TEST(PipelineBuildSchedulerTest, RunsMostUrgentFirst) {
+  auto pool = std::make_unique<ThreadPool>(1);
+  PipelineBuildScheduler scheduler(*pool);
+  std::atomic<bool> blockerStarted(false);
+  std::atomic<bool> releaseBlocker(false);
+  std::atomic<bool> allDone(false);
+  std::mutex orderMutex;
+  std::string order;
+  auto record = [&](char name) {
+    std::lock_guard<std::mutex> lock(orderMutex);
+    order += name;
+    if (order.size() == 3)
+      allDone = true;
+  };
+
+  // Keep the only worker busy while the other builds are submitted.
+  scheduler.submit(
+      [&] {
+        blockerStarted = true;
+        waitFor(releaseBlocker);
+      },
+      PipelineBuildPriority::Normal, 0);
+  waitFor(blockerStarted);
+
+  scheduler.submit([&] { record('b'); }, PipelineBuildPriority::Background, 0);
+  scheduler.submit([&] { record('f'); }, PipelineBuildPriority::Foreground, 0);
+  scheduler.submit([&] { record('n'); }, PipelineBuildPriority::Normal, 0);
+  releaseBlocker = true;
+  waitFor(allDone);
+  EXPECT_EQ(order, "fnb");
+  pool.reset();
+}
+
+TEST(PipelineBuildSchedulerTest, YieldRunsMoreUrgentBuilds) {
+  auto pool = std::make_unique<ThreadPool>(1);
+  PipelineBuildScheduler scheduler(*pool);
+  std::atomic<bool> backgroundStarted(false);
+  std::atomic<bool> foregroundSubmitted(false);
+  std::atomic<bool> foregroundDone(false);
+  std::atomic<bool> backgroundDone(false);
+  bool foregroundRanInYield = false;
+  std::thread::id backgroundThread;
+  std::thread::id foregroundThread;
+
+  scheduler.submit(
+      [&] {
+        backgroundThread = std::this_thread::get_id();
+        backgroundStarted = true;
+        waitFor(foregroundSubmitted);
+        // A pass boundary of the background build.
+        PipelineBuildScheduler::yield();
+        foregroundRanInYield = foregroundDone;
+        backgroundDone = true;
+      },
+      PipelineBuildPriority::Background, 0);
+  waitFor(backgroundStarted);
+
+  scheduler.submit(
+      [&] {
+        foregroundThread = std::this_thread::get_id();
+        // Nothing is more urgent than this build, so yielding does nothing.
+        PipelineBuildScheduler::yield();
+        foregroundDone = true;
+      },
+      PipelineBuildPriority::Foreground, 0);
+  foregroundSubmitted = true;
+  waitFor(backgroundDone);
+  EXPECT_TRUE(foregroundRanInYield);
+  EXPECT_EQ(foregroundThread, backgroundThread);
+  pool.reset();
+}
+
+TEST(PipelineBuildSchedulerTest, SameKeyDoesNotRunConcurrently) {
+  auto pool = std::make_unique<ThreadPool>(2);
+  PipelineBuildScheduler scheduler(*pool);
+  constexpr uint64_t Key = 0x1234;
+  constexpr unsigned NumBuilds = 4;
+  std::atomic<unsigned> numRunning(0);
+  std::atomic<unsigned> maxRunning(0);
+  std::atomic<unsigned> numDone(0);
+
+  for (unsigned i = 0; i != NumBuilds; ++i) {
+    scheduler.submit(
+        [&] {
+          unsigned running = ++numRunning;
+          unsigned prevMax = maxRunning;
+          while (running > prevMax && !maxRunning.compare_exchange_weak(prevMax, running))
+            ;
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+          --numRunning;
+          ++numDone;
+        },
+        i == NumBuilds - 1 ? PipelineBuildPriority::Foreground : PipelineBuildPriority::Background, Key);
+  }
+
+  while (numDone != NumBuilds)
+    std::this_thread::yield();
+  EXPECT_EQ(maxRunning, 1u);
+  pool.reset();
+}
+
+} // namespace
+} // namespace Llpc
@@ -30,15 +30,22 @@
 #include "vkgcDefs.h"
 #include "vkgcMetroHash.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Testing/Support/Error.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <map>
 #include <numeric>
 #include <random>
+#include <thread>
 
 using namespace llvm;
 using ::testing::ElementsAreArray;
@@ -169,7 +176,8 @@ TEST_F(ShaderCacheTest, InsertsShaders) {
   size_t cacheSize = 0;
   Result result = cache.Serialize(nullptr, &cacheSize);
   EXPECT_EQ(result, Result::Success);
-  EXPECT_GE(cacheSize, sizeof(ShaderCacheSerializedHeader) + (numShaders * cacheEntry.size()));
+  // The entries have identical shader data, which is only serialized once.
+  EXPECT_EQ(cacheSize, sizeof(ShaderCacheSerializedHeader) + cacheEntry.size() + (numShaders * sizeof(ShaderHeader)));
 }
 
 // This test tries to insert the same shader with N threads. We expect to see one insertion
@@ -232,7 +240,425 @@ TEST_F(ShaderCacheTest, InsertsShadersMultithreaded) {
   size_t cacheSize = 0;
   Result result = cache.Serialize(nullptr, &cacheSize);
   EXPECT_EQ(result, Result::Success);
-  EXPECT_GE(cacheSize, sizeof(ShaderCacheSerializedHeader) + (numShaders * cacheEntry.size()));
+  // The entries have identical shader data, which is only serialized once.
+  EXPECT_EQ(cacheSize, sizeof(ShaderCacheSerializedHeader) + cacheEntry.size() + (numShaders * sizeof(ShaderHeader)));
+}
+
+// This test checks that a thread waiting for an entry that is being compiled is not released by another entry being
+// inserted, and that it gets to compile the entry itself when the compilation of the entry fails.
+TEST_F(ShaderCacheTest, WaitsForEntryBeingCompiled) {
+  ShaderCache &cache = getCache();
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  const auto waitedHash = hashFromDWords(1, 2, 3, 4);
+  const auto otherHash = hashFromDWords(2, 2, 3, 4);
+
+  CacheEntryHandle waitedHandle = nullptr;
+  CacheEntryHandle otherHandle = nullptr;
+  EXPECT_EQ(cache.findShader(waitedHash, true, &waitedHandle), ShaderEntryState::Compiling);
+  EXPECT_EQ(cache.findShader(otherHash, true, &otherHandle), ShaderEntryState::Compiling);
+
+  std::atomic<bool> waitDone{false};
+  ShaderEntryState waiterState = ShaderEntryState::Unavailable;
+  std::thread waiter([&] {
+    CacheEntryHandle handle = nullptr;
+    waiterState = cache.findShader(waitedHash, true, &handle);
+    waitDone = true;
+    if (waiterState == ShaderEntryState::Compiling)
+      cache.insertShader(handle, cacheEntry.data(), cacheEntry.size());
+    cache.releaseShader(handle);
+  });
+
+  cache.insertShader(otherHandle, cacheEntry.data(), cacheEntry.size());
+  cache.releaseShader(otherHandle);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(waitDone);
+
+  cache.resetShader(waitedHandle);
+  cache.releaseShader(waitedHandle);
+  waiter.join();
+  EXPECT_EQ(waiterState, ShaderEntryState::Compiling);
+
+  CacheEntryHandle handle = nullptr;
+  EXPECT_EQ(cache.findShader(waitedHash, false, &handle), ShaderEntryState::Ready);
+  cache.releaseShader(handle);
+}
+
+// This test inserts shaders whose keys fall into different shards of the index map, then checks that they can all
+// be found and retrieved again.
+TEST_F(ShaderCacheTest, InsertsShadersAcrossShards) {
+  ShaderCache &cache = getCache();
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  constexpr size_t numShaders = 4 * ShaderIndexShardCount;
+
+  // The top bits of the compacted hash select the shard, so vary the top bits of dwords[2].
+  SmallVector<MetroHash::Hash, 0> hashes(numShaders);
+  for (auto &hashAndIndex : enumerate(hashes)) {
+    unsigned index = static_cast<unsigned>(hashAndIndex.index());
+    hashAndIndex.value() = hashFromDWords(0, index, index << (32 - ShaderIndexShardBits), 4);
+  }
+
+  for (auto &hash : hashes) {
+    CacheEntryHandle handle = nullptr;
+    ShaderEntryState state = cache.findShader(hash, true, &handle);
+    EXPECT_EQ(state, ShaderEntryState::Compiling);
+    EXPECT_NE(handle, nullptr);
+    cache.insertShader(handle, cacheEntry.data(), cacheEntry.size());
+  }
+
+  for (auto &hash : hashes) {
+    CacheEntryHandle handle = nullptr;
+    ShaderEntryState state = cache.findShader(hash, false, &handle);
+    EXPECT_EQ(state, ShaderEntryState::Ready);
+    EXPECT_NE(handle, nullptr);
+
+    const void *blob = nullptr;
+    size_t blobSize = 0;
+    Result result = cache.retrieveShader(handle, &blob, &blobSize);
+    EXPECT_EQ(result, Result::Success);
+    EXPECT_THAT(charArrayFromBlob(blob, blobSize), ElementsAreArray(cacheEntry));
+  }
+}
+
+TEST(ShaderCacheBudgetTest, EvictsLeastRecentlyUsed) {
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  constexpr unsigned numShaders = 5;
+
+  // The memory budget fits four entries.
+  ShaderCache cache;
+  ShaderCacheCreateInfo createInfo = {};
+  createInfo.maxMemorySize = 4 * (cacheEntry.size() + sizeof(ShaderHeader));
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = GfxIp;
+  EXPECT_EQ(cache.init(&createInfo, &auxCreateInfo), Result::Success);
+
+  SmallVector<MetroHash::Hash, 0> hashes(numShaders);
+  for (auto &hashAndIndex : enumerate(hashes)) {
+    unsigned index = static_cast<unsigned>(hashAndIndex.index());
+    hashAndIndex.value() = ShaderCacheTest::hashFromDWords(index, 1, 2, 3);
+  }
+
+  // Each entry gets different shader data, so that the entries do not share it.
+  auto insert = [&](const MetroHash::Hash &hash) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(cache.findShader(hash, true, &handle), ShaderEntryState::Compiling);
+    cacheEntry[0] = static_cast<char>(hash.dwords[0]);
+    cache.insertShader(handle, cacheEntry.data(), cacheEntry.size());
+    cache.releaseShader(handle);
+  };
+  auto isCached = [&](const MetroHash::Hash &hash) {
+    CacheEntryHandle handle = nullptr;
+    if (cache.findShader(hash, false, &handle) != ShaderEntryState::Ready)
+      return false;
+    cache.releaseShader(handle);
+    return true;
+  };
+
+  for (unsigned i = 0; i != numShaders - 1; ++i)
+    insert(hashes[i]);
+
+  // Use the first entry again, so that the second and third entries are the least recently used when the last entry
+  // exceeds the budget. The cache evicts down to three quarters of its budget.
+  EXPECT_TRUE(isCached(hashes[0]));
+  insert(hashes[numShaders - 1]);
+
+  EXPECT_TRUE(isCached(hashes[0]));
+  EXPECT_FALSE(isCached(hashes[1]));
+  EXPECT_FALSE(isCached(hashes[2]));
+  EXPECT_TRUE(isCached(hashes[3]));
+  EXPECT_TRUE(isCached(hashes[4]));
+
+  // Only the entries left in the cache are serialized.
+  size_t cacheSize = 0;
+  EXPECT_EQ(cache.Serialize(nullptr, &cacheSize), Result::Success);
+  EXPECT_EQ(cacheSize, sizeof(ShaderCacheSerializedHeader) + 3 * (cacheEntry.size() + sizeof(ShaderHeader)));
+}
+
+TEST_F(ShaderCacheTest, MergesWithoutCopying) {
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  const auto hash = hashFromDWords(1, 2, 3, 4);
+
+  auto srcCache = std::make_unique<ShaderCache>();
+  ShaderCacheCreateInfo createInfo = {};
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = GfxIp;
+  EXPECT_EQ(srcCache->init(&createInfo, &auxCreateInfo), Result::Success);
+
+  CacheEntryHandle handle = nullptr;
+  EXPECT_EQ(srcCache->findShader(hash, true, &handle), ShaderEntryState::Compiling);
+  srcCache->insertShader(handle, cacheEntry.data(), cacheEntry.size());
+  const void *srcBlob = nullptr;
+  size_t srcBlobSize = 0;
+  EXPECT_EQ(srcCache->retrieveShader(handle, &srcBlob, &srcBlobSize), Result::Success);
+  srcCache->releaseShader(handle);
+
+  // The merged entry shares the data of the source entry, which outlives the source cache.
+  ShaderCache &cache = getCache();
+  const IShaderCache *srcCaches[] = {srcCache.get()};
+  EXPECT_EQ(cache.Merge(1, srcCaches), Result::Success);
+  srcCache.reset();
+
+  EXPECT_EQ(cache.findShader(hash, false, &handle), ShaderEntryState::Ready);
+  const void *blob = nullptr;
+  size_t blobSize = 0;
+  EXPECT_EQ(cache.retrieveShader(handle, &blob, &blobSize), Result::Success);
+  EXPECT_EQ(blob, srcBlob);
+  EXPECT_THAT(charArrayFromBlob(blob, blobSize), ElementsAreArray(cacheEntry));
+  cache.releaseShader(handle);
+
+  // The pieces of the serialized cache refer to the shader data, and together are the same as the serialized blob.
+  ShaderCacheSerializedPieces pieces;
+  EXPECT_EQ(cache.serializePieces(&pieces), Result::Success);
+  ASSERT_EQ(pieces.pieces.size(), 1u);
+  EXPECT_EQ(pieces.pieces[0].data() + sizeof(ShaderHeader), blob);
+  EXPECT_EQ(pieces.header.shaderCount, 1u);
+
+  size_t cacheSize = 0;
+  EXPECT_EQ(cache.Serialize(nullptr, &cacheSize), Result::Success);
+  EXPECT_EQ(cacheSize, pieces.size);
+  std::vector<uint8_t> serialized(cacheSize);
+  EXPECT_EQ(cache.Serialize(serialized.data(), &cacheSize), Result::Success);
+  std::vector<uint8_t> gathered(reinterpret_cast<const uint8_t *>(&pieces.header),
+                                reinterpret_cast<const uint8_t *>(&pieces.header + 1));
+  gathered.insert(gathered.end(), pieces.pieces[0].begin(), pieces.pieces[0].end());
+  EXPECT_EQ(gathered, serialized);
+}
+
+// An external cache that counts its lookups.
+struct ExternalCache {
+  std::map<uint64_t, std::vector<uint8_t>> values;
+  std::atomic<unsigned> lookups{0};
+
+  static Result getValue(const void *clientData, uint64_t hash, void *value, size_t *valueLen) {
+    auto *cache = static_cast<ExternalCache *>(const_cast<void *>(clientData));
+    ++cache->lookups;
+    auto it = cache->values.find(hash);
+    if (it == cache->values.end())
+      return Result::NotFound;
+    if (value)
+      memcpy(value, it->second.data(), std::min(*valueLen, it->second.size()));
+    *valueLen = it->second.size();
+    return Result::Success;
+  }
+
+  static Result storeValue(const void *clientData, uint64_t hash, const void *value, size_t valueLen) {
+    auto *cache = static_cast<ExternalCache *>(const_cast<void *>(clientData));
+    const auto *bytes = static_cast<const uint8_t *>(value);
+    cache->values[hash].assign(bytes, bytes + valueLen);
+    return Result::Success;
+  }
+};
+
+TEST(ShaderCacheManifestTest, PrefetchesFromExternalCache) {
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  const MetroHash::Hash hashes[] = {ShaderCacheTest::hashFromDWords(1, 2, 3, 4),
+                                    ShaderCacheTest::hashFromDWords(5, 6, 7, 8)};
+
+  ExternalCache externalCache;
+  ShaderCacheCreateInfo createInfo = {};
+  createInfo.pClientData = &externalCache;
+  createInfo.pfnGetValueFunc = &ExternalCache::getValue;
+  createInfo.pfnStoreValueFunc = &ExternalCache::storeValue;
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = GfxIp;
+
+  // Record a run that compiles the second shader and then the first one.
+  std::vector<uint8_t> manifest;
+  {
+    ShaderCache cache;
+    EXPECT_EQ(cache.init(&createInfo, &auxCreateInfo), Result::Success);
+    for (const MetroHash::Hash &hash : {hashes[1], hashes[0], hashes[1]}) {
+      CacheEntryHandle handle = nullptr;
+      if (cache.findShader(hash, true, &handle) == ShaderEntryState::Compiling)
+        cache.insertShader(handle, cacheEntry.data(), cacheEntry.size());
+      cache.releaseShader(handle);
+    }
+
+    size_t manifestSize = 0;
+    EXPECT_EQ(cache.SerializeManifest(nullptr, &manifestSize), Result::Success);
+    EXPECT_EQ(manifestSize, sizeof(ShaderCacheManifestHeader) + 2 * sizeof(uint64_t));
+    manifest.resize(manifestSize);
+    EXPECT_EQ(cache.SerializeManifest(manifest.data(), &manifestSize), Result::Success);
+    const auto *keys = reinterpret_cast<const uint64_t *>(manifest.data() + sizeof(ShaderCacheManifestHeader));
+    EXPECT_EQ(keys[0], MetroHash::compact64(&hashes[1]));
+    EXPECT_EQ(keys[1], MetroHash::compact64(&hashes[0]));
+  }
+
+  // A new cache prefetches both shaders from the external cache, so that looking them up does not query it.
+  ShaderCache cache;
+  EXPECT_EQ(cache.init(&createInfo, &auxCreateInfo), Result::Success);
+  EXPECT_EQ(cache.Prefetch(manifest.data(), manifest.size() - 1), Result::ErrorInvalidValue);
+  EXPECT_EQ(cache.Prefetch(manifest.data(), manifest.size()), Result::Success);
+  cache.waitForPrefetch();
+
+  externalCache.lookups = 0;
+  for (const MetroHash::Hash &hash : hashes) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(cache.findShader(hash, false, &handle), ShaderEntryState::Ready);
+    const void *blob = nullptr;
+    size_t blobSize = 0;
+    EXPECT_EQ(cache.retrieveShader(handle, &blob, &blobSize), Result::Success);
+    EXPECT_THAT(ShaderCacheTest::charArrayFromBlob(blob, blobSize), ElementsAreArray(cacheEntry));
+    cache.releaseShader(handle);
+  }
+  EXPECT_EQ(externalCache.lookups, 0u);
+}
+
+TEST_F(ShaderCacheTest, DeduplicatesShaders) {
+  SmallVector<char> cacheEntry(64);
+  std::iota(cacheEntry.begin(), cacheEntry.end(), 0);
+  SmallVector<char> otherCacheEntry(cacheEntry.rbegin(), cacheEntry.rend());
+  const MetroHash::Hash hashes[] = {hashFromDWords(1, 2, 3, 4), hashFromDWords(2, 2, 3, 4),
+                                    hashFromDWords(3, 2, 3, 4)};
+  const SmallVector<char> *entries[] = {&cacheEntry, &otherCacheEntry, &cacheEntry};
+
+  ShaderCache &cache = getCache();
+  const void *blobs[3] = {};
+  for (unsigned i = 0; i != 3; ++i) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(cache.findShader(hashes[i], true, &handle), ShaderEntryState::Compiling);
+    cache.insertShader(handle, entries[i]->data(), entries[i]->size());
+    size_t blobSize = 0;
+    EXPECT_EQ(cache.retrieveShader(handle, &blobs[i], &blobSize), Result::Success);
+    EXPECT_THAT(charArrayFromBlob(blobs[i], blobSize), ElementsAreArray(*entries[i]));
+    cache.releaseShader(handle);
+  }
+  // The first and last entries share their shader data in memory.
+  EXPECT_EQ(blobs[0], blobs[2]);
+  EXPECT_NE(blobs[0], blobs[1]);
+
+  // The shared shader data is only serialized once, with a reference record for the other entry.
+  size_t cacheSize = 0;
+  EXPECT_EQ(cache.Serialize(nullptr, &cacheSize), Result::Success);
+  EXPECT_EQ(cacheSize, sizeof(ShaderCacheSerializedHeader) + 3 * sizeof(ShaderHeader) + 2 * cacheEntry.size());
+  std::vector<uint8_t> serialized(cacheSize);
+  EXPECT_EQ(cache.Serialize(serialized.data(), &cacheSize), Result::Success);
+
+  // A cache loaded from the serialized data has all of the entries, and shares the data of the reference record.
+  ShaderCache loadedCache;
+  ShaderCacheCreateInfo createInfo = {};
+  createInfo.pInitialData = serialized.data();
+  createInfo.initialDataSize = serialized.size();
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = GfxIp;
+  EXPECT_EQ(loadedCache.init(&createInfo, &auxCreateInfo), Result::Success);
+  for (unsigned i = 0; i != 3; ++i) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(loadedCache.findShader(hashes[i], false, &handle), ShaderEntryState::Ready);
+    size_t blobSize = 0;
+    EXPECT_EQ(loadedCache.retrieveShader(handle, &blobs[i], &blobSize), Result::Success);
+    EXPECT_THAT(charArrayFromBlob(blobs[i], blobSize), ElementsAreArray(*entries[i]));
+    loadedCache.releaseShader(handle);
+  }
+  EXPECT_EQ(blobs[0], blobs[2]);
+}
+
+TEST_F(ShaderCacheTest, CompressesShaders) {
+  auto *compressOption = static_cast<cl::opt<bool> *>(cl::getRegisteredOptions()["shader-cache-compress"]);
+  ASSERT_NE(compressOption, nullptr);
+  compressOption->setValue(true);
+
+  ShaderCache &cache = getCache();
+  const auto hash = hashFromDWords(1, 2, 3, 4);
+  SmallVector<char> cacheEntry(4096);
+  for (auto &byteAndIndex : enumerate(cacheEntry))
+    byteAndIndex.value() = static_cast<char>(byteAndIndex.index() % 16);
+
+  CacheEntryHandle handle = nullptr;
+  EXPECT_EQ(cache.findShader(hash, true, &handle), ShaderEntryState::Compiling);
+  cache.insertShader(handle, cacheEntry.data(), cacheEntry.size());
+  compressOption->setValue(false);
+
+  // The entry is decompressed into the given buffer when it is retrieved.
+  const void *blob = nullptr;
+  size_t blobSize = 0;
+  std::vector<uint8_t> buffer;
+  EXPECT_EQ(cache.retrieveShader(handle, &blob, &blobSize, &buffer), Result::Success);
+  EXPECT_EQ(blob, buffer.data());
+  EXPECT_THAT(charArrayFromBlob(blob, blobSize), ElementsAreArray(cacheEntry));
+  cache.releaseShader(handle);
+
+  // The entry is stored compressed.
+  size_t cacheSize = 0;
+  EXPECT_EQ(cache.Serialize(nullptr, &cacheSize), Result::Success);
+  EXPECT_LT(cacheSize, sizeof(ShaderCacheSerializedHeader) + sizeof(ShaderHeader) + cacheEntry.size() / 4);
+}
+
+TEST_F(ShaderCacheTest, PacksSortedFile) {
+  SmallVector<char> cacheEntry(4096);
+  for (auto &byteAndIndex : enumerate(cacheEntry))
+    byteAndIndex.value() = static_cast<char>(byteAndIndex.index() % 16);
+  SmallVector<char> otherCacheEntry(cacheEntry.rbegin(), cacheEntry.rend());
+  const MetroHash::Hash hashes[] = {hashFromDWords(7, 2, 3, 4), hashFromDWords(1, 2, 3, 4),
+                                    hashFromDWords(4, 2, 3, 4)};
+  const SmallVector<char> *entries[] = {&cacheEntry, &otherCacheEntry, &cacheEntry};
+
+  ShaderCache &cache = getCache();
+  for (unsigned i = 0; i != 3; ++i) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(cache.findShader(hashes[i], true, &handle), ShaderEntryState::Compiling);
+    cache.insertShader(handle, entries[i]->data(), entries[i]->size());
+  }
+
+  SmallString<128> filePath;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("llpc-shader-cache", "bin", filePath));
+  ShaderCachePackStats stats = {};
+  EXPECT_EQ(cache.writePackedFile(filePath.c_str(), /*compress=*/true, &stats), Result::Success);
+  EXPECT_EQ(stats.shaderCount, 3u);
+  EXPECT_EQ(stats.referenceCount, 1u);
+  EXPECT_EQ(stats.compressedCount, 2u);
+  EXPECT_LT(stats.fileSize, sizeof(ShaderCacheSerializedHeader) + 3 * sizeof(ShaderHeader) + cacheEntry.size() / 2);
+
+  // The records in the file are sorted by key.
+  auto fileOrErr = MemoryBuffer::getFile(filePath);
+  ASSERT_TRUE(bool(fileOrErr));
+  const char *record = (*fileOrErr)->getBufferStart() + sizeof(ShaderCacheSerializedHeader);
+  uint64_t lastKey = 0;
+  for (unsigned i = 0; i != 3; ++i) {
+    ShaderHeader header = {};
+    memcpy(&header, record, sizeof(header));
+    EXPECT_LT(lastKey, header.key);
+    lastKey = header.key;
+    record += header.recordSize;
+  }
+  EXPECT_EQ(record, (*fileOrErr)->getBufferEnd());
+
+  // A cache loaded from the file has all of the entries.
+  ShaderCache loadedCache;
+  ShaderCacheCreateInfo createInfo = {};
+  ShaderCacheAuxCreateInfo auxCreateInfo = {};
+  auxCreateInfo.shaderCacheMode = ShaderCacheMode::ShaderCacheEnableRuntime;
+  auxCreateInfo.gfxIp = GfxIp;
+  EXPECT_EQ(loadedCache.init(&createInfo, &auxCreateInfo), Result::Success);
+  EXPECT_EQ(loadedCache.loadFile(filePath.c_str()), Result::Success);
+  BuildUniqueId buildId = {};
+  EXPECT_EQ(ShaderCache::readFileBuildId(filePath.c_str(), &buildId), Result::Success);
+  EXPECT_EQ(buildId.formatVersion, ShaderCacheFormatVersion);
+  for (unsigned i = 0; i != 3; ++i) {
+    CacheEntryHandle handle = nullptr;
+    EXPECT_EQ(loadedCache.findShader(hashes[i], false, &handle), ShaderEntryState::Ready);
+    const void *blob = nullptr;
+    size_t blobSize = 0;
+    std::vector<uint8_t> buffer;
+    EXPECT_EQ(loadedCache.retrieveShader(handle, &blob, &blobSize, &buffer), Result::Success);
+    EXPECT_THAT(charArrayFromBlob(blob, blobSize), ElementsAreArray(*entries[i]));
+    loadedCache.releaseShader(handle);
+  }
+
+  // A cache for another graphics IP does not load the file.
+  ShaderCache otherCache;
+  auxCreateInfo.gfxIp = {10, 3, 0};
+  EXPECT_EQ(otherCache.init(&createInfo, &auxCreateInfo), Result::Success);
+  EXPECT_NE(otherCache.loadFile(filePath.c_str()), Result::Success);
+  sys::fs::remove(filePath);
 }
 
 } // namespace
@@ -0,0 +1,68 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcCacheStats.h"
+#include "gtest/gtest.h"
+
+using namespace std::chrono;
+
+namespace Llpc {
+namespace {
+
+TEST(CacheStatsTest, LatencyBuckets) {
+  EXPECT_EQ(CacheStatsCollector::getLatencyBucket(nanoseconds(999)), 0u);
+  EXPECT_EQ(CacheStatsCollector::getLatencyBucket(microseconds(1)), 1u);
+  EXPECT_EQ(CacheStatsCollector::getLatencyBucket(microseconds(3)), 2u);
+  EXPECT_EQ(CacheStatsCollector::getLatencyBucket(microseconds(4)), 3u);
+  EXPECT_EQ(CacheStatsCollector::getLatencyBucket(seconds(100)), CacheLatencyBucketCount - 1);
+}
+
+TEST(CacheStatsTest, RecordsLookupsAndWaits) {
+  CacheStatsCollector collector;
+  collector.recordLookup(CacheLayerInternalShaderCache, true, 100, microseconds(5));
+  collector.recordLookup(CacheLayerInternalShaderCache, false, 0, microseconds(1));
+  collector.recordWait(CacheLayerInternalShaderCache, microseconds(2));
+
+  CacheStats stats = {};
+  collector.query(&stats);
+  const CacheLayerStats &layerStats = stats.layers[CacheLayerInternalShaderCache];
+  EXPECT_EQ(layerStats.lookups, 2u);
+  EXPECT_EQ(layerStats.hits, 1u);
+  EXPECT_EQ(layerStats.bytesRead, 100u);
+  EXPECT_EQ(layerStats.waits, 1u);
+  EXPECT_EQ(layerStats.waitNs, 2000u);
+  EXPECT_EQ(layerStats.latencyNs, 6000u);
+  EXPECT_EQ(layerStats.latencyHistogram[1], 1u);
+  EXPECT_EQ(layerStats.latencyHistogram[3], 1u);
+  EXPECT_EQ(stats.layers[CacheLayerInternalCache].lookups, 0u);
+
+  collector.reset();
+  collector.query(&stats);
+  EXPECT_EQ(stats.layers[CacheLayerInternalShaderCache].lookups, 0u);
+  EXPECT_EQ(stats.layers[CacheLayerInternalShaderCache].latencyHistogram[3], 0u);
+}
+
+} // namespace
+} // namespace Llpc
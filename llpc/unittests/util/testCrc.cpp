@@ -0,0 +1,87 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcCrc.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <vector>
+
+namespace Llpc {
+namespace {
+
+// Returns a buffer of pseudo-random bytes.
+std::vector<uint8_t> makeData(size_t size) {
+  std::vector<uint8_t> data(size);
+  uint32_t state = 12345;
+  for (uint8_t &byte : data) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(state >> 16);
+  }
+  return data;
+}
+
+// Check the CRC-32C of the standard check input and of no data.
+TEST(CrcTest, CheckValue) {
+  const char input[] = "123456789";
+  EXPECT_EQ(calculateCrc32c(input, strlen(input)), 0xE3069283u);
+  EXPECT_EQ(calculateCrc32cPortable(input, strlen(input)), 0xE3069283u);
+  EXPECT_EQ(calculateCrc32c(input, 0), 0u);
+}
+
+// Check that the dispatched and the portable implementations agree for all sizes and alignments around the
+// eight-byte blocks they process.
+TEST(CrcTest, MatchesPortable) {
+  const std::vector<uint8_t> data = makeData(1024 + 8);
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (size_t size = 0; size <= 64; ++size)
+      EXPECT_EQ(calculateCrc32c(data.data() + offset, size), calculateCrc32cPortable(data.data() + offset, size));
+  }
+  EXPECT_EQ(calculateCrc32c(data.data(), 1024), calculateCrc32cPortable(data.data(), 1024));
+}
+
+// Check that a checksum can be continued over more data.
+TEST(CrcTest, Continue) {
+  const std::vector<uint8_t> data = makeData(100);
+  const uint32_t whole = calculateCrc32c(data.data(), data.size());
+  for (size_t split = 0; split <= data.size(); split += 7) {
+    const uint32_t first = calculateCrc32c(data.data(), split);
+    EXPECT_EQ(calculateCrc32c(data.data() + split, data.size() - split, first), whole);
+    EXPECT_EQ(calculateCrc32cPortable(data.data() + split, data.size() - split, first), whole);
+  }
+}
+
+// Check that corrupting any single byte changes the checksum.
+TEST(CrcTest, DetectsCorruption) {
+  std::vector<uint8_t> data = makeData(64);
+  const uint32_t crc = calculateCrc32c(data.data(), data.size());
+  for (uint8_t &byte : data) {
+    byte ^= 0x10;
+    EXPECT_NE(calculateCrc32c(data.data(), data.size()), crc);
+    byte ^= 0x10;
+  }
+}
+
+} // namespace
+} // namespace Llpc
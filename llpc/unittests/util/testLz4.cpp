@@ -0,0 +1,95 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcLz4.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace Llpc {
+namespace {
+
+// Returns a buffer of pseudo-random bytes, in which a run of repeated bytes starts at every repeatPeriod bytes.
+std::vector<uint8_t> makeData(size_t size, size_t repeatPeriod) {
+  std::vector<uint8_t> data(size);
+  uint32_t state = 12345;
+  for (size_t i = 0; i < size; ++i) {
+    state = state * 1103515245 + 12345;
+    data[i] = (repeatPeriod != 0 && i % repeatPeriod < repeatPeriod / 2 && i != 0) ? data[i - 1]
+                                                                                  : static_cast<uint8_t>(state >> 16);
+  }
+  return data;
+}
+
+// Compresses the data and decompresses it again.
+std::vector<uint8_t> roundTrip(const std::vector<uint8_t> &data, size_t *compressedSize = nullptr) {
+  std::vector<uint8_t> block(getLz4BlockBound(data.size()));
+  const size_t blockSize = compressLz4Block(data.data(), data.size(), block.data(), block.size());
+  EXPECT_NE(blockSize, 0u);
+  if (compressedSize)
+    *compressedSize = blockSize;
+  std::vector<uint8_t> result(data.size());
+  EXPECT_TRUE(decompressLz4Block(block.data(), blockSize, result.data(), result.size()));
+  return result;
+}
+
+// Check that data of all sizes around the limits of the block format round-trips, compressible or not.
+TEST(Lz4Test, RoundTrip) {
+  for (size_t size : {0, 1, 5, 11, 12, 13, 16, 100, 4096, 70000}) {
+    for (size_t repeatPeriod : {0, 8, 64}) {
+      const std::vector<uint8_t> data = makeData(size, repeatPeriod);
+      EXPECT_EQ(roundTrip(data), data) << "size " << size << ", repeat period " << repeatPeriod;
+    }
+  }
+}
+
+// Check that repetitive data gets smaller.
+TEST(Lz4Test, Compresses) {
+  const std::vector<uint8_t> data(10000, 0x5A);
+  size_t compressedSize = 0;
+  EXPECT_EQ(roundTrip(data, &compressedSize), data);
+  EXPECT_LT(compressedSize, data.size() / 50);
+}
+
+// Check that the compressor refuses a buffer smaller than the bound.
+TEST(Lz4Test, BufferTooSmall) {
+  const std::vector<uint8_t> data = makeData(100, 0);
+  std::vector<uint8_t> block(getLz4BlockBound(data.size()) - 1);
+  EXPECT_EQ(compressLz4Block(data.data(), data.size(), block.data(), block.size()), 0u);
+}
+
+// Check that a truncated block, or a decompressed size that does not match, is rejected.
+TEST(Lz4Test, RejectsMalformed) {
+  const std::vector<uint8_t> data = makeData(1000, 8);
+  std::vector<uint8_t> block(getLz4BlockBound(data.size()));
+  const size_t blockSize = compressLz4Block(data.data(), data.size(), block.data(), block.size());
+  std::vector<uint8_t> result(data.size() + 1);
+  for (size_t truncated = 0; truncated < blockSize; ++truncated)
+    EXPECT_FALSE(decompressLz4Block(block.data(), truncated, result.data(), data.size()));
+  EXPECT_FALSE(decompressLz4Block(block.data(), blockSize, result.data(), data.size() - 1));
+  EXPECT_FALSE(decompressLz4Block(block.data(), blockSize, result.data(), data.size() + 1));
+}
+
+} // namespace
+} // namespace Llpc
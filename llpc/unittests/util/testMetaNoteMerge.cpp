@@ -0,0 +1,246 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+
+#include "llpcElfWriter.h"
+#include "llpcUtil.h"
+#include "vkgcDefs.h"
+#include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <string>
+
+using namespace llvm;
+using namespace Vkgc;
+
+namespace Llpc {
+namespace {
+
+// Register numbers used by the tests.
+const unsigned mmSpiShaderPgmRsrc1Ps = 0x2C0A;
+const unsigned mmSpiShaderColFormat = 0xA1C5;
+const unsigned mmSpiPsInputCntl0 = 0xA191;
+const unsigned mmSpiShaderUserDataPs0 = 0x2C0C;
+const unsigned mmSpiShaderUserDataVs0 = 0x2C4C;
+const unsigned mmSpiShaderPgmRsrc1Vs = 0x2C4A;
+const unsigned mmVgtShaderStagesEn = 0xA2D6;
+
+// Builds the PAL metadata of a VS/FS pipeline, as encoded in an ELF note. The values depend on the seed, so that the
+// two halves being merged differ in every item.
+//
+// @param seed : Seed for the values
+// @param extraRegisterCount : Number of extra non-fragment registers, to make the metadata a realistic size
+// @param withNumInterpolants : Whether to include .num_interpolants
+std::string buildPalMetadata(unsigned seed, unsigned extraRegisterCount, bool withNumInterpolants) {
+  msgpack::Document document;
+  auto root = document.getRoot().getMap(true);
+  root["amdpal.version"].getArray(true).push_back(document.getNode(2U));
+  root["amdpal.version"].getArray(true).push_back(document.getNode(3U));
+  auto pipeline = root["amdpal.pipelines"].getArray(true)[0].getMap(true);
+
+  pipeline[".api"] = document.getNode("Vulkan");
+  pipeline[".spill_threshold"] = document.getNode(0xFFFF - seed);
+  pipeline[".user_data_limit"] = document.getNode(4 + seed);
+  if (withNumInterpolants)
+    pipeline[".num_interpolants"] = document.getNode(seed % 8);
+  auto hash = pipeline[".internal_pipeline_hash"].getArray(true);
+  hash.push_back(document.getNode(uint64_t(seed)));
+  hash.push_back(document.getNode(uint64_t(seed)));
+
+  for (const char *stageName : {".vs", ".ps"}) {
+    auto stage = pipeline[".hardware_stages"].getMap(true)[stageName].getMap(true);
+    stage[".entry_point"] = document.getNode(stageName[1] == 'v' ? "_amdgpu_vs_main" : "_amdgpu_ps_main");
+    stage[".sgpr_count"] = document.getNode(10 + seed);
+    stage[".vgpr_count"] = document.getNode(20 + seed);
+  }
+  for (const char *shaderName : {".vertex", ".pixel"}) {
+    auto shader = pipeline[".shaders"].getMap(true)[shaderName].getMap(true);
+    shader[".api_shader_hash"].getArray(true).push_back(document.getNode(uint64_t(seed) * 7));
+    shader[".hardware_mapping"].getArray(true).push_back(document.getNode(shaderName[1] == 'v' ? ".vs" : ".ps"));
+  }
+
+  auto registers = pipeline[".registers"].getMap(true);
+  registers[mmSpiShaderPgmRsrc1Ps] = document.getNode(0x1000 + seed);
+  registers[mmSpiShaderColFormat] = document.getNode(seed);
+  registers[mmSpiPsInputCntl0 + seed % 4] = document.getNode(seed);
+  registers[mmSpiShaderUserDataPs0 + seed % 2] = document.getNode(seed);
+  registers[mmSpiShaderPgmRsrc1Vs] = document.getNode(0x2000 + seed);
+  registers[mmVgtShaderStagesEn] = document.getNode(seed);
+  for (unsigned i = 0; i != extraRegisterCount; ++i)
+    registers[0xA000 + i] = document.getNode(seed * 3 + i);
+
+  std::string blob;
+  document.writeToBlob(blob);
+  return blob;
+}
+
+// Merges the fragment info of srcBlob into destBlob in a decoded document, as the merge did before mergeMetaBlob.
+//
+// @param mergeInfo : Pipeline-specific values for the merge
+// @param destBlob : PAL metadata blob to merge into
+// @param srcBlob : PAL metadata blob containing fragment shader info
+std::string mergeInDocument(const MetaNoteMergeInfo &mergeInfo, StringRef destBlob, StringRef srcBlob) {
+  msgpack::Document destDocument;
+  EXPECT_TRUE(destDocument.readFromBlob(destBlob, false));
+  std::string mergedBlob;
+  ElfWriter<Elf64>::mergeMetaDocument(mergeInfo, destDocument, srcBlob, &mergedBlob);
+  return mergedBlob;
+}
+
+// Builds a resource mapping with a descriptor table pointer for descriptor set 1 at the given user data offset.
+struct TestResourceMapping {
+  TestResourceMapping(unsigned offset) {
+    innerNode.type = ResourceMappingNodeType::DescriptorBuffer;
+    innerNode.sizeInDwords = 4;
+    innerNode.srdRange.set = 1;
+    rootNode.node.type = ResourceMappingNodeType::DescriptorTableVaPtr;
+    rootNode.node.sizeInDwords = 1;
+    rootNode.node.offsetInDwords = offset;
+    rootNode.node.tablePtr.nodeCount = 1;
+    rootNode.node.tablePtr.pNext = &innerNode;
+    rootNode.visibility = ShaderStageAllGraphicsBit;
+    mapping.pUserDataNodes = &rootNode;
+    mapping.userDataNodeCount = 1;
+  }
+
+  ResourceMappingNode innerNode = {};
+  ResourceMappingRootNode rootNode = {};
+  ResourceMappingData mapping = {};
+};
+
+// cppcheck-suppress syntaxError
+TEST(MetaNoteMergeTest, BlobMergeMatchesDocumentMerge) {
+  ResourceMappingData emptyMapping = {};
+  MetaNoteMergeInfo mergeInfo = {10, 0x123456789ABCDEF0, &emptyMapping};
+  for (bool destInterpolants : {false, true}) {
+    for (bool srcInterpolants : {false, true}) {
+      std::string destBlob = buildPalMetadata(1, 8, destInterpolants);
+      std::string srcBlob = buildPalMetadata(2, 4, srcInterpolants);
+      std::string mergedBlob;
+      ASSERT_TRUE(ElfWriter<Elf64>::mergeMetaBlob(mergeInfo, destBlob, srcBlob, &mergedBlob));
+      EXPECT_EQ(mergedBlob, mergeInDocument(mergeInfo, destBlob, srcBlob));
+    }
+  }
+}
+
+TEST(MetaNoteMergeTest, BlobMergeUpdatesDescriptorUserData) {
+  TestResourceMapping resourceMapping(9);
+  MetaNoteMergeInfo mergeInfo = {9, 1, &resourceMapping.mapping};
+
+  // Put an unlinked descriptor set 1 pointer in a VS user data register of the non-fragment half.
+  std::string baseBlob = buildPalMetadata(1, 0, true);
+  msgpack::Document document;
+  ASSERT_TRUE(document.readFromBlob(baseBlob, false));
+  auto pipeline = document.getRoot().getMap(true)["amdpal.pipelines"].getArray(true)[0].getMap(true);
+  pipeline[".registers"].getMap(true)[mmSpiShaderUserDataVs0 + 2] = document.getNode(DescRelocMagic | 1);
+  std::string destBlob;
+  document.writeToBlob(destBlob);
+  std::string srcBlob = buildPalMetadata(2, 0, true);
+
+  std::string mergedBlob;
+  ASSERT_TRUE(ElfWriter<Elf64>::mergeMetaBlob(mergeInfo, destBlob, srcBlob, &mergedBlob));
+  EXPECT_EQ(mergedBlob, mergeInDocument(mergeInfo, destBlob, srcBlob));
+
+  msgpack::Document merged;
+  ASSERT_TRUE(merged.readFromBlob(mergedBlob, false));
+  auto mergedPipeline = merged.getRoot().getMap(true)["amdpal.pipelines"].getArray(true)[0].getMap(true);
+  EXPECT_EQ(mergedPipeline[".registers"].getMap(true)[mmSpiShaderUserDataVs0 + 2].getUInt(), 9U);
+  EXPECT_EQ(mergedPipeline[".user_data_limit"].getUInt(), 10U);
+}
+
+TEST(MetaNoteMergeTest, BlobMergeRejectsUnexpectedLayout) {
+  ResourceMappingData emptyMapping = {};
+  MetaNoteMergeInfo mergeInfo = {10, 1, &emptyMapping};
+
+  // A non-fragment half without the items being merged is left to the document merge.
+  msgpack::Document document;
+  auto pipeline = document.getRoot().getMap(true)["amdpal.pipelines"].getArray(true)[0].getMap(true);
+  pipeline[".registers"].getMap(true)[mmVgtShaderStagesEn] = document.getNode(1U);
+  std::string destBlob;
+  document.writeToBlob(destBlob);
+
+  std::string mergedBlob;
+  EXPECT_FALSE(ElfWriter<Elf64>::mergeMetaBlob(mergeInfo, destBlob, buildPalMetadata(2, 0, true), &mergedBlob));
+  EXPECT_FALSE(ElfWriter<Elf64>::mergeMetaBlob(mergeInfo, StringRef("\xC1", 1), destBlob, &mergedBlob));
+}
+
+// Times the blob merge against the document merge, on metadata the size of a typical VS/FS pipeline. The timings are
+// recorded as test properties (in the --gtest_output XML), rather than checked, as they depend on the machine.
+TEST(MetaNoteMergeTest, CursorFindsMapItems) {
+  std::string blob = buildPalMetadata(3, 8, false);
+  MsgPackCursor cursor(blob);
+  uint64_t size = 0;
+  ASSERT_TRUE(cursor.findMapItem("amdpal.pipelines"));
+  ASSERT_TRUE(cursor.readArraySize(&size));
+  ASSERT_EQ(size, 1u);
+  MsgPackCursor pipelineCursor = cursor;
+
+  uint64_t value = 0;
+  ASSERT_TRUE(cursor.findMapItem(".registers"));
+  ASSERT_TRUE(cursor.findMapItem(uint64_t(mmSpiShaderPgmRsrc1Vs)));
+  ASSERT_TRUE(cursor.readUInt(&value));
+  EXPECT_EQ(value, 0x2003u);
+
+  StringRef api;
+  ASSERT_TRUE(pipelineCursor.findMapItem(".api"));
+  ASSERT_TRUE(pipelineCursor.readString(&api));
+  EXPECT_EQ(api, "Vulkan");
+
+  MsgPackCursor missingCursor(blob);
+  EXPECT_FALSE(missingCursor.findMapItem("amdpal.missing"));
+}
+
+TEST(MetaNoteMergeTest, BenchmarkBlobMergeAgainstDocumentMerge) {
+  const unsigned iterationCount = 2000;
+  ResourceMappingData emptyMapping = {};
+  MetaNoteMergeInfo mergeInfo = {10, 1, &emptyMapping};
+  std::string destBlob = buildPalMetadata(1, 200, true);
+  std::string srcBlob = buildPalMetadata(2, 200, true);
+
+  auto start = std::chrono::steady_clock::now();
+  size_t documentMergedSize = 0;
+  for (unsigned i = 0; i != iterationCount; ++i)
+    documentMergedSize += mergeInDocument(mergeInfo, destBlob, srcBlob).size();
+  auto documentTime = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  size_t blobMergedSize = 0;
+  std::string mergedBlob;
+  for (unsigned i = 0; i != iterationCount; ++i) {
+    ASSERT_TRUE(ElfWriter<Elf64>::mergeMetaBlob(mergeInfo, destBlob, srcBlob, &mergedBlob));
+    blobMergedSize += mergedBlob.size();
+  }
+  auto blobTime = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(blobMergedSize, documentMergedSize);
+  auto nsPerMerge = [](std::chrono::steady_clock::duration time) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() / iterationCount);
+  };
+  RecordProperty("metadataSize", static_cast<int>(destBlob.size()));
+  RecordProperty("documentMergeNs", nsPerMerge(documentTime));
+  RecordProperty("blobMergeNs", nsPerMerge(blobTime));
+}
+
+} // namespace
+} // namespace Llpc
@@ -154,5 +154,62 @@ TEST(ThreadingTest, SingleError) {
   }
 }
 
+TEST(ThreadingTest, NestedLoops) {
+  const auto data = seq(0u, 16u);
+
+  for (size_t numThreads : {0, 1, 2, 7}) {
+    std::atomic<unsigned> numExecutions(0);
+
+    Error err = parallelFor(numThreads, data, [&numExecutions, &data, numThreads](unsigned datum) {
+      (void)datum;
+      return parallelFor(numThreads, data, [&numExecutions](unsigned innerDatum) {
+        (void)innerDatum;
+        ++numExecutions;
+        return Error::success();
+      });
+    });
+    EXPECT_THAT_ERROR(std::move(err), Succeeded());
+    EXPECT_EQ(numExecutions, data.size() * data.size());
+  }
+}
+
+TEST(ThreadingTest, PriorityHints) {
+  const auto data = seq(0u, 32u);
+
+  for (size_t numThreads : {0, 1, 2, 7}) {
+    SmallVector<unsigned> seenNumbers;
+    std::mutex seenMutex;
+
+    Error err = parallelFor(
+        numThreads, data,
+        [&seenNumbers, &seenMutex](unsigned datum) {
+          std::lock_guard<std::mutex> lock(seenMutex);
+          seenNumbers.push_back(datum);
+          return Error::success();
+        },
+        [](unsigned datum) { return uint64_t(datum % 5); });
+
+    EXPECT_THAT_ERROR(std::move(err), Succeeded());
+    EXPECT_TRUE(std::is_permutation(seenNumbers.begin(), seenNumbers.end(), data.begin(), data.end()));
+  }
+}
+
+TEST(ThreadingTest, ThreadPoolRunsAllJobs) {
+  std::atomic<unsigned> numExecutions(0);
+  {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.getNumWorkers(), 3u);
+    for (unsigned i = 0; i < 100; ++i) {
+      pool.submit([&pool, &numExecutions] {
+        // Jobs submitted from a worker go to that worker's queue, and may be stolen by the others.
+        pool.submit([&numExecutions] { ++numExecutions; });
+        ++numExecutions;
+      });
+    }
+    // Destroying the pool waits for all queued jobs.
+  }
+  EXPECT_EQ(numExecutions, 200u);
+}
+
 } // namespace
 } // namespace Llpc
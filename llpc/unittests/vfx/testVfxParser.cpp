@@ -135,5 +135,40 @@ TEST_F(VfxParserTest, SplitMultipleFragmentsMultipleDelimiters) {
   EXPECT_THAT(fragments, ElementsAre(StrEq("a"), StrEq("bb"), StrEq("c"), StrEq("d"), StrEq("")));
 }
 
+TEST_F(VfxParserTest, SplitLinesEmpty) {
+  SmallStr empty = createStr("");
+
+  std::vector<char *> lines = splitLines(empty.data());
+  EXPECT_TRUE(lines.empty());
+}
+
+TEST_F(VfxParserTest, SplitLinesNoTrailingLineEnding) {
+  SmallStr str = createStr("abc\nd");
+
+  std::vector<char *> lines = splitLines(str.data());
+  EXPECT_THAT(str, ElementsAreArray("abc\0d"));
+  EXPECT_THAT(lines, ElementsAre(StrEq("abc"), StrEq("d")));
+}
+
+TEST_F(VfxParserTest, SplitLinesEmptyLines) {
+  SmallStr str = createStr("a\n\r\n\nbb\n");
+
+  std::vector<char *> lines = splitLines(str.data());
+  EXPECT_THAT(str, ElementsAreArray("a\0\r\0\0bb\0"));
+  EXPECT_THAT(lines, ElementsAre(StrEq("a"), StrEq("\r"), StrEq(""), StrEq("bb")));
+}
+
+TEST_F(VfxParserTest, ParseFilesMissing) {
+  const char *filenames[] = {"missing0.pipe", "missing1.pipe", "missing2.pipe"};
+  void *docs[3] = {};
+  const char *errorMsgs[3] = {};
+
+  EXPECT_FALSE(vfxParseFiles(3, filenames, 0, nullptr, VfxDocTypePipeline, 2, docs, errorMsgs));
+  for (void *doc : docs) {
+    EXPECT_NE(doc, nullptr);
+    vfxCloseDoc(doc);
+  }
+}
+
 } // namespace
 } // namespace Vfx
@@ -30,8 +30,10 @@
  ***********************************************************************************************************************
  */
 #include "llpcCacheAccessor.h"
+#include "llpcCacheStats.h"
 #include "llpcContext.h"
 #include "llpcError.h"
+#include "llvm/ADT/SmallVector.h"
 
 #define DEBUG_TYPE "llpc-cache-accessor"
 
@@ -62,6 +64,25 @@ CacheAccessor::CacheAccessor(Context *context, MetroHash::Hash &cacheHash, Cache
   }
 }
 
+// =====================================================================================================================
+// Checks the caches in the context and the internal caches for entries with each of the given hashes, asking each
+// ICache for all of the entries at once.
+//
+// @param context : The context that will give the caches from the application.
+// @param hashes : The hashes for the entries to access.
+// @param internalCaches : The internal caches to check.
+// @returns : One cache accessor per hash
+std::vector<CacheAccessor> CacheAccessor::lookUpAll(Context *context, ArrayRef<MetroHash::Hash> hashes,
+                                                    CachePair internalCaches) {
+  assert(context);
+  if (context->isGraphics()) {
+    const auto *pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(context->getPipelineBuildInfo());
+    return lookUpAll(pipelineInfo, hashes, internalCaches);
+  }
+  const auto *pipelineInfo = reinterpret_cast<const ComputePipelineBuildInfo *>(context->getPipelineBuildInfo());
+  return lookUpAll(pipelineInfo, hashes, internalCaches);
+}
+
 // =====================================================================================================================
 // Initializes the cache accessor to check the given caches.  The caches can be nullptr.
 //
@@ -104,11 +125,112 @@ void CacheAccessor::lookUpInCaches(const MetroHash::Hash &hash) {
 // @param allocateOnMiss : Will add an entry to the cache on a miss if true.
 // @param cache : The cache in which to look.
 Result CacheAccessor::lookUpInCache(Vkgc::ICache *cache, bool allocateOnMiss, const Vkgc::HashId &hashId) {
+  const CacheLayer layer = cache == getInternalCache() ? CacheLayerInternalCache : CacheLayerApplicationCache;
+  const auto start = CacheStatsCollector::Clock::now();
   Vkgc::EntryHandle currentEntry;
   Result cacheResult = cache->GetEntry(hashId, allocateOnMiss, &currentEntry);
+  cacheResult = takeCacheEntry(cacheResult, allocateOnMiss, std::move(currentEntry), layer);
+  recordLookup(layer, cacheResult == Result::Success, CacheStatsCollector::Clock::now() - start);
+  return cacheResult;
+}
+
+// =====================================================================================================================
+// Records a lookup of the ELF in the cache statistics.
+//
+// @param layer : The cache layer that was looked up.
+// @param hit : Whether the lookup found the ELF.
+// @param latency : Time the lookup took.
+void CacheAccessor::recordLookup(CacheLayer layer, bool hit, CacheStatsCollector::Clock::duration latency) const {
+  CacheStatsCollector::get().recordLookup(layer, hit, hit ? m_elf.codeSize : 0, latency);
+}
+
+// =====================================================================================================================
+// Looks for each of the given hashes in the ICaches and sets the state of the corresponding cache accessor with the
+// results. This is the batched equivalent of lookUpInCaches: each cache is asked for all of the hashes that have not
+// been found yet in one GetEntries call.
+//
+// @param [in/out] accessors : The cache accessors, all of which check the same caches
+// @param hashes : The hash to look up for each cache accessor
+void CacheAccessor::lookUpAllInCaches(MutableArrayRef<CacheAccessor> accessors, ArrayRef<MetroHash::Hash> hashes) {
+  assert(accessors.size() == hashes.size());
+  if (accessors.empty())
+    return;
+
+  Vkgc::ICache *internalCache = accessors.front().getInternalCache();
+  Vkgc::ICache *applicationCache = accessors.front().getApplicationCache();
+
+  SmallVector<unsigned, 4> indices;
+  for (unsigned i = 0; i < accessors.size(); ++i) {
+    accessors[i].m_cacheResult = Result::Unsupported;
+    indices.push_back(i);
+  }
 
-  if (cacheResult == Result::NotReady)
+  if (internalCache) {
+    lookUpAllInCache(internalCache, !applicationCache, accessors, hashes, indices);
+    for (unsigned i : indices) {
+      if (accessors[i].m_cacheResult == Result::Success)
+        accessors[i].m_internalCacheHit = true;
+    }
+  }
+
+  if (applicationCache) {
+    indices.erase(remove_if(indices, [&](unsigned i) { return accessors[i].m_cacheResult == Result::Success; }),
+                  indices.end());
+    if (!indices.empty())
+      lookUpAllInCache(applicationCache, true, accessors, hashes, indices);
+  }
+}
+
+// =====================================================================================================================
+// Looks for a subset of the given hashes in the given cache with a single GetEntries call, and sets the state of the
+// corresponding cache accessors with the results. New entries will be allocated on a miss if allocateOnMiss is true.
+//
+// @param cache : The cache in which to look.
+// @param allocateOnMiss : Will add an entry to the cache on a miss if true.
+// @param [in/out] accessors : The cache accessors
+// @param hashes : The hash to look up for each cache accessor
+// @param indices : The indices of the cache accessors to look up
+void CacheAccessor::lookUpAllInCache(Vkgc::ICache *cache, bool allocateOnMiss, MutableArrayRef<CacheAccessor> accessors,
+                                     ArrayRef<MetroHash::Hash> hashes, ArrayRef<unsigned> indices) {
+  SmallVector<Vkgc::HashId, 4> hashIds(indices.size());
+  for (unsigned i = 0; i < indices.size(); ++i)
+    memcpy(&hashIds[i].bytes, &hashes[indices[i]].bytes, sizeof(MetroHash::Hash));
+
+  const CacheLayer layer =
+      cache == accessors.front().getInternalCache() ? CacheLayerInternalCache : CacheLayerApplicationCache;
+  const auto start = CacheStatsCollector::Clock::now();
+  std::vector<Vkgc::EntryHandle> entries(indices.size());
+  SmallVector<Result, 4> cacheResults(indices.size(), Result::ErrorUnknown);
+  cache->GetEntries(hashIds.data(), hashIds.size(), allocateOnMiss, entries.data(), cacheResults.data());
+  const auto batchLatency = CacheStatsCollector::Clock::now() - start;
+
+  // Entries that are still being populated by another thread are waited for in order, as separate lookups would. The
+  // latency of each lookup is that of the whole request plus its own wait.
+  for (unsigned i = 0; i < indices.size(); ++i) {
+    CacheAccessor &accessor = accessors[indices[i]];
+    const auto takeStart = CacheStatsCollector::Clock::now();
+    accessor.m_cacheResult = accessor.takeCacheEntry(cacheResults[i], allocateOnMiss, std::move(entries[i]), layer);
+    accessor.recordLookup(layer, accessor.m_cacheResult == Result::Success,
+                          batchLatency + (CacheStatsCollector::Clock::now() - takeStart));
+  }
+}
+
+// =====================================================================================================================
+// Takes the entry returned by an ICache lookup, waiting for it if it is not ready yet, and retrieves its ELF on a hit.
+// The entry is kept on a hit, and on a miss if a new entry was allocated for it.
+//
+// @param cacheResult : The result of the lookup.
+// @param allocateOnMiss : Whether the lookup was allowed to allocate an entry on a miss.
+// @param entry : The entry returned by the lookup.
+// @param layer : The cache layer of the lookup, for the cache statistics.
+Result CacheAccessor::takeCacheEntry(Result cacheResult, bool allocateOnMiss, Vkgc::EntryHandle &&entry,
+                                     CacheLayer layer) {
+  Vkgc::EntryHandle currentEntry = std::move(entry);
+  if (cacheResult == Result::NotReady) {
+    const auto waitStart = CacheStatsCollector::Clock::now();
     cacheResult = currentEntry.WaitForEntry();
+    CacheStatsCollector::get().recordWait(layer, CacheStatsCollector::Clock::now() - waitStart);
+  }
 
   if (cacheResult == Result::Success) {
     cacheResult = currentEntry.GetValueZeroCopy(&m_elf.pCode, &m_elf.codeSize);
@@ -123,7 +245,7 @@ Result CacheAccessor::lookUpInCache(Vkgc::ICache *cache, bool allocateOnMiss, co
 // Looks for the given hash in the shader caches and sets the cache accessor state with the results.
 //
 // @param hash : The hash to look up.
-void CacheAccessor::lookUpInShaderCaches(MetroHash::Hash &hash) {
+void CacheAccessor::lookUpInShaderCaches(const MetroHash::Hash &hash) {
   ShaderCache *applicationCache = static_cast<ShaderCache *>(getApplicationShaderCache());
   ShaderCache *internalCache = static_cast<ShaderCache *>(getInternalShaderCache());
   bool usingApplicationCache = applicationCache && cl::ShaderCacheMode != ShaderCacheForceInternalCacheOnDisk;
@@ -154,15 +276,27 @@ void CacheAccessor::resetShaderCacheTrackingData() {
 // @param allocateOnMiss : Will add an entry to the cache on a miss if true.
 // @param cache : The cache in with to look.
 bool CacheAccessor::lookUpInShaderCache(const MetroHash::Hash &hash, bool allocateOnMiss, ShaderCache *cache) {
+  const CacheLayer layer =
+      cache == getInternalShaderCache() ? CacheLayerInternalShaderCache : CacheLayerApplicationShaderCache;
+  const auto start = CacheStatsCollector::Clock::now();
   CacheEntryHandle currentEntry;
   ShaderEntryState cacheEntryState = cache->findShader(hash, allocateOnMiss, &currentEntry);
   if (cacheEntryState == ShaderEntryState::Ready) {
-    Result result = cache->retrieveShader(currentEntry, &m_elf.pCode, &m_elf.codeSize);
+    Result result = cache->retrieveShader(currentEntry, &m_elf.pCode, &m_elf.codeSize, &m_decompressedElf);
+    recordLookup(layer, result == Result::Success, CacheStatsCollector::Clock::now() - start);
     if (result == Result::Success) {
+      m_usedShaderCache = cache;
+      m_usedShaderCacheEntry = currentEntry;
       m_shaderCacheEntryState = ShaderEntryState::Ready;
       return true;
     }
-  } else if (cacheEntryState == ShaderEntryState::Compiling) {
+    cache->releaseShader(currentEntry);
+    return false;
+  }
+  recordLookup(layer, false, CacheStatsCollector::Clock::now() - start);
+  if (cacheEntryState == ShaderEntryState::Compiling) {
+    m_usedShaderCache = cache;
+    m_usedShaderCacheEntry = currentEntry;
     m_shaderCache = cache;
     m_shaderCacheEntry = currentEntry;
     m_shaderCacheEntryState = ShaderEntryState::Compiling;
@@ -171,6 +305,15 @@ bool CacheAccessor::lookUpInShaderCache(const MetroHash::Hash &hash, bool alloca
   return false;
 }
 
+// =====================================================================================================================
+// Releases the shader cache entry that the ELF is in, so that the shader cache can evict it again.
+void CacheAccessor::releaseShaderCacheEntry() {
+  if (m_usedShaderCacheEntry)
+    m_usedShaderCache->releaseShader(m_usedShaderCacheEntry);
+  m_usedShaderCache = nullptr;
+  m_usedShaderCacheEntry = nullptr;
+}
+
 // =====================================================================================================================
 // Sets the ELF entry for the hash on a cache miss.  Does nothing if there was a cache hit or the ELF has already been
 // set.
@@ -179,7 +322,7 @@ bool CacheAccessor::lookUpInShaderCache(const MetroHash::Hash &hash, bool alloca
 void CacheAccessor::setElfInCache(BinaryData elf) {
   if (m_shaderCacheEntryState == ShaderEntryState::Compiling && m_shaderCacheEntry) {
     updateShaderCache(elf);
-    mustSucceed(m_shaderCache->retrieveShader(m_shaderCacheEntry, &m_elf.pCode, &m_elf.codeSize),
+    mustSucceed(m_shaderCache->retrieveShader(m_shaderCacheEntry, &m_elf.pCode, &m_elf.codeSize, &m_decompressedElf),
                 "Failed to retrieve shader");
     m_shaderCacheEntryState = ShaderEntryState::Ready;
   }
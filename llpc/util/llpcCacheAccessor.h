@@ -32,9 +32,12 @@
 #pragma once
 
 #include "llpc.h"
+#include "llpcCacheStats.h"
 #include "llpcShaderCache.h"
 #include "vkgcMetroHash.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/CommandLine.h"
+#include <vector>
 
 namespace Llpc {
 
@@ -56,17 +59,51 @@ public:
     initializeUsingBuildInfo(buildInfo, cacheHash, internalCaches);
   }
 
+  // Checks the caches in the build info and the internal caches for entries with each of the given hashes. Each ICache
+  // is asked for all of the entries in a single request, so a cache that is backed by a slow store does not pay a
+  // round trip per entry. The entries are then waited for in the order of the hashes.
+  //
+  // @param buildInfo : The build information that will give the caches from the application.
+  // @param hashes : The hashes for the entries to access.
+  // @param internalCaches : The internal caches to check.
+  // @returns : One cache accessor per hash
+  template <class BuildInfo>
+  static std::vector<CacheAccessor> lookUpAll(BuildInfo *buildInfo, llvm::ArrayRef<MetroHash::Hash> hashes,
+                                              CachePair internalCaches) {
+    assert(buildInfo);
+    std::vector<CacheAccessor> accessors;
+    accessors.reserve(hashes.size());
+    for (unsigned i = 0; i < hashes.size(); ++i)
+      accessors.push_back(CacheAccessor(getApplicationCaches(buildInfo), internalCaches));
+    lookUpAllInCaches(accessors, hashes);
+    for (unsigned i = 0; i < hashes.size(); ++i) {
+      if (accessors[i].m_cacheResult != Result::Success)
+        accessors[i].lookUpInShaderCaches(hashes[i]);
+    }
+    return accessors;
+  }
+
+  static std::vector<CacheAccessor> lookUpAll(Context *context, llvm::ArrayRef<MetroHash::Hash> hashes,
+                                              CachePair internalCaches);
+
   CacheAccessor(CacheAccessor &&ca) { *this = std::move(ca); }
 
   CacheAccessor &operator=(CacheAccessor &&ca) {
+    releaseShaderCacheEntry();
     m_applicationCaches = ca.m_applicationCaches;
     m_internalCaches = ca.m_internalCaches;
     m_shaderCacheEntryState = ca.m_shaderCacheEntryState;
     m_shaderCacheEntry = ca.m_shaderCacheEntry;
     m_shaderCache = ca.m_shaderCache;
     m_cacheResult = ca.m_cacheResult;
+    m_internalCacheHit = ca.m_internalCacheHit;
     m_cacheEntry = std::move(ca.m_cacheEntry);
     m_elf = ca.m_elf;
+    m_decompressedElf = std::move(ca.m_decompressedElf);
+    m_usedShaderCache = ca.m_usedShaderCache;
+    m_usedShaderCacheEntry = ca.m_usedShaderCacheEntry;
+    ca.m_usedShaderCache = nullptr;
+    ca.m_usedShaderCacheEntry = nullptr;
 
     // Reinitialize ca with not caches.  It needs to be in an appropriate state for the destructor.
     ca.initialize(nullptr, nullptr, {nullptr, nullptr});
@@ -76,7 +113,10 @@ public:
   CacheAccessor(Context *context, MetroHash::Hash &cacheHash, CachePair internalCaches);
 
   // Finalizes the cache access by releasing any handles that need to be released.
-  ~CacheAccessor() { setElfInCache({0, nullptr}); }
+  ~CacheAccessor() {
+    setElfInCache({0, nullptr});
+    releaseShaderCacheEntry();
+  }
 
   // Returns true of the entry was in at least on of the caches or has been added to the cache.
   bool isInCache() const {
@@ -103,6 +143,11 @@ private:
   CacheAccessor(const CacheAccessor &) = delete;
   CacheAccessor &operator=(const CacheAccessor &) = delete;
 
+  // Creates a cache accessor for the given caches that has not looked up any entry yet.
+  CacheAccessor(CachePair applicationCaches, CachePair internalCaches) {
+    initialize(applicationCaches.cache, applicationCaches.shaderCache, internalCaches);
+  }
+
   const Vkgc::ICache *getApplicationCache() const { return m_applicationCaches.cache; }
   const IShaderCache *getApplicationShaderCache() const { return m_applicationCaches.shaderCache; }
   const Vkgc::ICache *getInternalCache() const { return m_internalCaches.cache; }
@@ -120,28 +165,40 @@ private:
   template <class BuildInfo>
   void initializeUsingBuildInfo(const BuildInfo *buildInfo, MetroHash::Hash &hash, CachePair internalCaches) {
     assert(buildInfo);
-    Vkgc::ICache *userCache = buildInfo->cache;
-
-    IShaderCache *userShaderCache = nullptr;
-#if LLPC_ENABLE_SHADER_CACHE
-    userShaderCache = reinterpret_cast<IShaderCache *>(buildInfo->pShaderCache);
-#endif
-
-    initialize(userCache, userShaderCache, internalCaches);
+    CachePair applicationCaches = getApplicationCaches(buildInfo);
+    initialize(applicationCaches.cache, applicationCaches.shaderCache, internalCaches);
     lookUpInCaches(hash);
     if (m_cacheResult != Result::Success)
       lookUpInShaderCaches(hash);
   }
 
+  // Returns the caches from the application given in the build info.
+  //
+  // @param buildInfo : The build info object that gives the caches from the application.
+  template <class BuildInfo> static CachePair getApplicationCaches(const BuildInfo *buildInfo) {
+    CachePair applicationCaches = {buildInfo->cache, nullptr};
+#if LLPC_ENABLE_SHADER_CACHE
+    applicationCaches.shaderCache = reinterpret_cast<IShaderCache *>(buildInfo->pShaderCache);
+#endif
+    return applicationCaches;
+  }
+
   void initialize(Vkgc::ICache *userCache, IShaderCache *userShaderCache, CachePair internalCaches);
 
   void lookUpInCaches(const MetroHash::Hash &hash);
   Result lookUpInCache(Vkgc::ICache *cache, bool allocateOnMiss, const Vkgc::HashId &hashId);
-
-  void lookUpInShaderCaches(MetroHash::Hash &hash);
+  static void lookUpAllInCaches(llvm::MutableArrayRef<CacheAccessor> accessors,
+                                llvm::ArrayRef<MetroHash::Hash> hashes);
+  static void lookUpAllInCache(Vkgc::ICache *cache, bool allocateOnMiss, llvm::MutableArrayRef<CacheAccessor> accessors,
+                               llvm::ArrayRef<MetroHash::Hash> hashes, llvm::ArrayRef<unsigned> indices);
+  Result takeCacheEntry(Result cacheResult, bool allocateOnMiss, Vkgc::EntryHandle &&entry, CacheLayer layer);
+  void recordLookup(CacheLayer layer, bool hit, CacheStatsCollector::Clock::duration latency) const;
+
+  void lookUpInShaderCaches(const MetroHash::Hash &hash);
   bool lookUpInShaderCache(const MetroHash::Hash &hash, bool allocateOnMiss, ShaderCache *cache);
   void updateShaderCache(BinaryData &elf);
   void resetShaderCacheTrackingData();
+  void releaseShaderCacheEntry();
 
   CachePair m_applicationCaches;
   CachePair m_internalCaches;
@@ -166,6 +223,13 @@ private:
 
   // The ELF corresponding to the entry.
   BinaryData m_elf = {0, nullptr};
+
+  // The buffer that the ELF is decompressed into if it is compressed in the shader cache.
+  std::vector<uint8_t> m_decompressedElf;
+
+  // The shader cache entry that the ELF is in, which must not be evicted until it is released.
+  ShaderCache *m_usedShaderCache = nullptr;
+  CacheEntryHandle m_usedShaderCacheEntry = nullptr;
 };
 
 } // namespace Llpc
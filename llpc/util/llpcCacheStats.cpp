@@ -0,0 +1,124 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcCacheStats.cpp
+ * @brief LLPC source file: contains the implementation of the collector of the cache lookup statistics
+ ***********************************************************************************************************************
+ */
+#include "llpcCacheStats.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+
+namespace Llpc {
+
+// =====================================================================================================================
+// Gets the collector of the process.
+//
+// @returns : The collector
+CacheStatsCollector &CacheStatsCollector::get() {
+  static CacheStatsCollector collector;
+  return collector;
+}
+
+// =====================================================================================================================
+// Records a lookup in a cache layer.
+//
+// @param layer : The cache layer
+// @param hit : Whether the lookup found the entry
+// @param bytesRead : Size of the entry found
+// @param latency : Time the lookup took, including any wait
+void CacheStatsCollector::recordLookup(CacheLayer layer, bool hit, size_t bytesRead, Clock::duration latency) {
+  LayerCounters &counters = m_layers[layer];
+  counters.lookups.fetch_add(1, std::memory_order_relaxed);
+  if (hit) {
+    counters.hits.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesRead.fetch_add(bytesRead, std::memory_order_relaxed);
+  }
+  const uint64_t latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+  counters.latencyNs.fetch_add(latencyNs, std::memory_order_relaxed);
+  counters.latencyHistogram[getLatencyBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+// Records a wait of a lookup in a cache layer for another thread to finish populating the entry.
+//
+// @param layer : The cache layer
+// @param waitTime : Time the lookup waited
+void CacheStatsCollector::recordWait(CacheLayer layer, Clock::duration waitTime) {
+  LayerCounters &counters = m_layers[layer];
+  counters.waits.fetch_add(1, std::memory_order_relaxed);
+  counters.waitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitTime).count(),
+                            std::memory_order_relaxed);
+}
+
+// =====================================================================================================================
+// Gets the statistics collected since the last reset.
+//
+// @param [out] stats : The statistics
+void CacheStatsCollector::query(CacheStats *stats) const {
+  for (unsigned layer = 0; layer < CacheLayerCount; ++layer) {
+    const LayerCounters &counters = m_layers[layer];
+    CacheLayerStats &layerStats = stats->layers[layer];
+    layerStats.lookups = counters.lookups.load(std::memory_order_relaxed);
+    layerStats.hits = counters.hits.load(std::memory_order_relaxed);
+    layerStats.bytesRead = counters.bytesRead.load(std::memory_order_relaxed);
+    layerStats.waits = counters.waits.load(std::memory_order_relaxed);
+    layerStats.waitNs = counters.waitNs.load(std::memory_order_relaxed);
+    layerStats.latencyNs = counters.latencyNs.load(std::memory_order_relaxed);
+    for (unsigned bucket = 0; bucket < CacheLatencyBucketCount; ++bucket)
+      layerStats.latencyHistogram[bucket] = counters.latencyHistogram[bucket].load(std::memory_order_relaxed);
+  }
+}
+
+// =====================================================================================================================
+// Resets all of the statistics to zero.
+void CacheStatsCollector::reset() {
+  for (LayerCounters &counters : m_layers) {
+    counters.lookups = 0;
+    counters.hits = 0;
+    counters.bytesRead = 0;
+    counters.waits = 0;
+    counters.waitNs = 0;
+    counters.latencyNs = 0;
+    for (std::atomic<uint64_t> &bucket : counters.latencyHistogram)
+      bucket = 0;
+  }
+}
+
+// =====================================================================================================================
+// Gets the bucket of the latency histogram that a lookup latency falls into: bucket 0 for less than 1 microsecond,
+// bucket i for 2^(i-1) up to 2^i microseconds, and the last bucket for all longer latencies.
+//
+// @param latency : The latency
+// @returns : Index of the bucket
+unsigned CacheStatsCollector::getLatencyBucket(Clock::duration latency) {
+  const uint64_t latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  if (latencyUs == 0)
+    return 0;
+  return std::min(llvm::Log2_64(latencyUs) + 1, CacheLatencyBucketCount - 1);
+}
+
+} // namespace Llpc
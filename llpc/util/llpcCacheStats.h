@@ -0,0 +1,73 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcCacheStats.h
+ * @brief LLPC header file: contains the declaration of the collector of the cache lookup statistics
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include "llpc.h"
+#include <atomic>
+#include <chrono>
+
+namespace Llpc {
+
+// =====================================================================================================================
+// Collects the statistics of the cache lookups of all compilers in the process. The counters are atomic, so that any
+// thread can record a lookup without taking a lock; a query while lookups are recorded may see some of the counters of
+// a lookup but not others.
+class CacheStatsCollector {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Gets the collector of the process.
+  static CacheStatsCollector &get();
+
+  void recordLookup(CacheLayer layer, bool hit, size_t bytesRead, Clock::duration latency);
+  void recordWait(CacheLayer layer, Clock::duration waitTime);
+
+  void query(CacheStats *stats) const;
+  void reset();
+
+  static unsigned getLatencyBucket(Clock::duration latency);
+
+private:
+  // Counters of one cache layer, matching CacheLayerStats
+  struct LayerCounters {
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> waits{0};
+    std::atomic<uint64_t> waitNs{0};
+    std::atomic<uint64_t> latencyNs{0};
+    std::atomic<uint64_t> latencyHistogram[CacheLatencyBucketCount] = {};
+  };
+
+  LayerCounters m_layers[CacheLayerCount]; // Counters of each cache layer
+};
+
+} // namespace Llpc
@@ -0,0 +1,177 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcCrc.cpp
+ * @brief LLPC source file: contains the implementation of the CRC-32C checksum used to validate cached data
+ ***********************************************************************************************************************
+ */
+#include "llpcCrc.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LLPC_HAS_X86_CRC32 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <nmmintrin.h>
+#endif
+
+#if defined(LLPC_HAS_X86_CRC32) && !defined(_MSC_VER)
+// GCC and Clang only generate the crc32 instruction in functions that target SSE4.2.
+#define LLPC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define LLPC_TARGET_SSE42
+#endif
+
+namespace Llpc {
+
+namespace {
+
+// Reflected CRC-32C polynomial
+constexpr uint32_t Crc32cPolynomial = 0x82F63B78;
+
+// =====================================================================================================================
+// Lookup tables for the slicing-by-8 CRC: table[0] advances the CRC by one byte, and table[k] by one byte followed by
+// k zero bytes, so that eight bytes are folded in with eight independent lookups.
+struct Crc32cTables {
+  uint32_t table[8][256];
+
+  Crc32cTables() {
+    for (unsigned i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (unsigned bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ ((crc & 1) ? Crc32cPolynomial : 0);
+      table[0][i] = crc;
+    }
+    for (unsigned k = 1; k < 8; ++k) {
+      for (unsigned i = 0; i < 256; ++i)
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+    }
+  }
+};
+
+// =====================================================================================================================
+// Gets the lookup tables, which are built on first use.
+const Crc32cTables &getCrc32cTables() {
+  static const Crc32cTables tables;
+  return tables;
+}
+
+#ifdef LLPC_HAS_X86_CRC32
+// =====================================================================================================================
+// Returns true if the host CPU supports SSE4.2, which has the crc32 instruction.
+bool isSse42Supported() {
+#if defined(_MSC_VER)
+  int cpuInfo[4] = {};
+  __cpuid(cpuInfo, 1);
+  return (cpuInfo[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+// =====================================================================================================================
+// Calculates the CRC-32C of the data with the crc32 instruction, eight bytes at a time.
+//
+// @param data : Data to calculate the CRC of
+// @param numBytes : Data size in bytes
+// @param crc : Inverted CRC of the preceding data
+// @returns : Inverted CRC including the data
+LLPC_TARGET_SSE42 uint32_t updateCrc32cSse42(const uint8_t *data, size_t numBytes, uint32_t crc) {
+  uint64_t crc64 = crc;
+  for (; numBytes >= sizeof(uint64_t); numBytes -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    crc64 = _mm_crc32_u64(crc64, value);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; numBytes > 0; --numBytes, ++data)
+    crc = _mm_crc32_u8(crc, *data);
+  return crc;
+}
+#endif
+
+// =====================================================================================================================
+// Calculates the CRC-32C of the data with the slicing-by-8 lookup tables. The bytes are combined explicitly, so the
+// result does not depend on the endianness of the host.
+//
+// @param data : Data to calculate the CRC of
+// @param numBytes : Data size in bytes
+// @param crc : Inverted CRC of the preceding data
+// @returns : Inverted CRC including the data
+uint32_t updateCrc32cPortable(const uint8_t *data, size_t numBytes, uint32_t crc) {
+  const auto &table = getCrc32cTables().table;
+  for (; numBytes >= 8; numBytes -= 8, data += 8) {
+    const uint32_t low = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 |
+                                uint32_t(data[3]) << 24);
+    crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+          table[3][data[4]] ^ table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+  }
+  for (; numBytes > 0; --numBytes, ++data)
+    crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+  return crc;
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Calculates the CRC-32C checksum of the data, using the crc32 instruction when the host CPU supports it.
+//
+// @param data : Data to calculate the CRC of
+// @param numBytes : Data size in bytes
+// @param crc : CRC of the preceding data, or 0 to start a new checksum
+// @returns : CRC of the preceding data and the data
+uint32_t calculateCrc32c(const void *data, size_t numBytes, uint32_t crc) {
+#ifdef LLPC_HAS_X86_CRC32
+  if (hasHardwareCrc32c())
+    return ~updateCrc32cSse42(static_cast<const uint8_t *>(data), numBytes, ~crc);
+#endif
+  return calculateCrc32cPortable(data, numBytes, crc);
+}
+
+// =====================================================================================================================
+// Calculates the CRC-32C checksum of the data with the portable table-driven implementation.
+//
+// @param data : Data to calculate the CRC of
+// @param numBytes : Data size in bytes
+// @param crc : CRC of the preceding data, or 0 to start a new checksum
+// @returns : CRC of the preceding data and the data
+uint32_t calculateCrc32cPortable(const void *data, size_t numBytes, uint32_t crc) {
+  return ~updateCrc32cPortable(static_cast<const uint8_t *>(data), numBytes, ~crc);
+}
+
+// =====================================================================================================================
+// Returns true if calculateCrc32c uses the crc32 instruction of the host CPU. The CPU is checked once.
+bool hasHardwareCrc32c() {
+#ifdef LLPC_HAS_X86_CRC32
+  static const bool supported = isSse42Supported();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+} // namespace Llpc
@@ -0,0 +1,48 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcCrc.h
+ * @brief LLPC header file: contains the declaration of the CRC-32C checksum used to validate cached data
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Llpc {
+
+// Calculates the CRC-32C (Castagnoli) checksum of the data, using the SSE4.2 crc32 instruction when the host CPU
+// supports it. Passing the result of a previous call as crc continues the checksum over more data.
+uint32_t calculateCrc32c(const void *data, size_t numBytes, uint32_t crc = 0);
+
+// Calculates the same checksum as calculateCrc32c, always with the portable table-driven implementation.
+uint32_t calculateCrc32cPortable(const void *data, size_t numBytes, uint32_t crc = 0);
+
+// Returns true if calculateCrc32c uses the crc32 instruction of the host CPU.
+bool hasHardwareCrc32c();
+
+} // namespace Llpc
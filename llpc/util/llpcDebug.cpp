@@ -39,6 +39,11 @@
 
 #define DEBUG_TYPE "llpc-debug"
 
+namespace Llpc {
+static void updateOutsEnabled();
+static void updateErrsEnabled();
+} // namespace Llpc
+
 namespace llvm {
 
 namespace cl {
@@ -46,15 +51,15 @@ namespace cl {
 // -enable-outs: enable general message output (to stdout or external file).
 opt<bool> EnableOuts("enable-outs",
                      desc("Enable LLPC-specific debug dump output (to stdout or external file) (default: false)"),
-                     init(false));
+                     init(false), callback([](const bool &) { Llpc::updateOutsEnabled(); }));
 
 // -v: alias for -enable-outs
 opt<bool> Verbose("v", desc("Enable LLPC-specific debug dump output (to stdout or external file) (default: false)"),
-                  init(false));
+                  init(false), callback([](const bool &) { Llpc::updateOutsEnabled(); }));
 
 // -enable-errs: enable error message output (to stderr or external file).
 opt<bool> EnableErrs("enable-errs", desc("Enable error message output (to stdout or external file) (default: true)"),
-                     init(true));
+                     init(true), callback([](const bool &) { Llpc::updateErrsEnabled(); }));
 
 // -log-file-dbgs: name of the file to log info from dbg()
 opt<std::string> LogFileDbgs("log-file-dbgs", desc("Name of the file to log info from dbgs()"), value_desc("filename"),
@@ -72,16 +77,21 @@ using namespace llvm;
 
 namespace Llpc {
 
+namespace detail {
+bool OutsEnabled = false;
+bool ErrsEnabled = true;
+} // namespace detail
+
 // =====================================================================================================================
-// Gets the value of option "allow-out".
-bool EnableOuts() {
-  return cl::EnableOuts || cl::Verbose;
+// Updates the cached value of options "enable-outs" and "v", after one of them is parsed.
+static void updateOutsEnabled() {
+  detail::OutsEnabled = cl::EnableOuts || cl::Verbose;
 }
 
 // =====================================================================================================================
-// Gets the value of option "allow-err".
-bool EnableErrs() {
-  return cl::EnableErrs;
+// Updates the cached value of option "enable-errs", after it is parsed.
+static void updateErrsEnabled() {
+  detail::ErrsEnabled = cl::EnableErrs;
 }
 
 // =====================================================================================================================
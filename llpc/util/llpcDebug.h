@@ -54,11 +54,27 @@ struct Hash;
 } // namespace MetroHash
 namespace Llpc {
 
-// Gets the value of option "enable-outs"
-bool EnableOuts();
+namespace detail {
+// Cached values of options "enable-outs" (or "v") and "enable-errs", updated whenever the options are parsed, so that
+// the checks in LLPC_OUTS and LLPC_ERRS are a load of a flag.
+extern bool OutsEnabled;
+extern bool ErrsEnabled;
+} // namespace detail
+
+// Gets the value of option "enable-outs". Building with LLPC_DISABLE_OUTS strips the LLPC_OUTS output, and the
+// formatting of its arguments, from the library.
+inline bool EnableOuts() {
+#if LLPC_DISABLE_OUTS
+  return false;
+#else
+  return detail::OutsEnabled;
+#endif
+}
 
 // Gets the value of option "enable-errs"
-bool EnableErrs();
+inline bool EnableErrs() {
+  return detail::ErrsEnabled;
+}
 
 // Redirects the output of logs, It affects the behavior of llvm::outs(), dbgs() and errs().
 void redirectLogOutput(bool restoreToDefault, unsigned optionCount, const char *const *options);
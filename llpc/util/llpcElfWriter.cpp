@@ -33,6 +33,7 @@
 #include "llpcError.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/BinaryFormat/MsgPackDocument.h"
+#include "llvm/BinaryFormat/MsgPackWriter.h"
 #include <algorithm>
 #include <string.h>
 
@@ -66,11 +67,11 @@ ElfWriter<Elf>::ElfWriter(GfxIpVersion gfxIp)
 // =====================================================================================================================
 template <class Elf> ElfWriter<Elf>::~ElfWriter() {
   for (auto &section : m_sections)
-    delete[] section.data;
+    freeData(section.data);
   m_sections.clear();
 
   for (auto &note : m_notes)
-    delete[] note.data;
+    freeData(note.data);
   m_notes.clear();
 
   for (auto &sym : m_symbols) {
@@ -78,6 +79,7 @@ template <class Elf> ElfWriter<Elf>::~ElfWriter() {
       delete[] sym.pSymName;
   }
   m_symbols.clear();
+  resetSymbolIndex();
 }
 
 // =====================================================================================================================
@@ -187,80 +189,196 @@ void ElfWriter<Elf>::mergeMapItem(msgpack::MapDocNode &destMap, msgpack::MapDocN
   }
 }
 
+// =====================================================================================================================
+// Gets the user data offset of the descriptor table pointer for a descriptor set, from the resource mapping.
+//
+// @param resourceMapping : Resource mapping of the pipeline
+// @param set : Descriptor set
+// @param [out] offset : User data offset in dwords of the descriptor table pointer
+// @returns : True if the set has a descriptor table pointer in the root user data
+static bool getDescriptorTableUserDataOffset(const ResourceMappingData *resourceMapping, unsigned set,
+                                             unsigned *offset) {
+  for (unsigned j = 0; j < resourceMapping->userDataNodeCount; ++j) {
+    auto userDataNode = &resourceMapping->pUserDataNodes[j].node;
+    if (userDataNode->type == ResourceMappingNodeType::DescriptorTableVaPtr &&
+        set == userDataNode->tablePtr.pNext[0].srdRange.set) {
+      *offset = userDataNode->offsetInDwords;
+      return true;
+    }
+  }
+  return false;
+}
+
+// =====================================================================================================================
+// Returns whether a register is one of the USER_DATA registers of the VS, PS or CS, which may hold a reloc descriptor
+// user data value.
+//
+// @param gfxIpMajor : Major version of the graphics IP
+// @param regNumber : Register number
+static bool isRootDescriptorRegister(unsigned gfxIpMajor, uint64_t regNumber) {
+  const unsigned mmSpiShaderUserDataVs0 = 0x2C4C;
+  const unsigned mmSpiShaderUserDataPs0 = 0x2c0c;
+  const unsigned mmComputeUserData0 = 0x2E40;
+  const unsigned vsPsUserDataCount = gfxIpMajor < 9 ? 16 : 32;
+  return (regNumber >= mmSpiShaderUserDataVs0 && regNumber < mmSpiShaderUserDataVs0 + vsPsUserDataCount) ||
+         (regNumber >= mmSpiShaderUserDataPs0 && regNumber < mmSpiShaderUserDataPs0 + vsPsUserDataCount) ||
+         (regNumber >= mmComputeUserData0 && regNumber < mmComputeUserData0 + 16);
+}
+
+// =====================================================================================================================
+// Returns the descriptor offset that a register value is to be updated to, if it is a reloc descriptor user data value.
+//
+// @param resourceMapping : Resource mapping of the pipeline
+// @param regValue : Register value
+// @param [out] offset : The descriptor offset
+static bool getRootDescriptorOffset(const ResourceMappingData *resourceMapping, uint64_t regValue, unsigned *offset) {
+  // Reloc Descriptor user data value is consisted by DescRelocMagic | set.
+  return DescRelocMagic == (regValue & DescRelocMagicMask) &&
+         getDescriptorTableUserDataOffset(resourceMapping, regValue & DescSetMask, offset);
+}
+
+// =====================================================================================================================
+// Returns whether any register in a PAL metadata blob needs updateRootDescriptorRegisters, looking the registers up
+// without decoding the blob. Metadata that is not laid out as expected is reported as needing the update, for the
+// decoded document to deal with.
+//
+// @param gfxIpMajor : Major version of the graphics IP
+// @param resourceMapping : Resource mapping of the pipeline
+// @param blob : PAL metadata blob
+static bool hasRootDescriptorRegisters(unsigned gfxIpMajor, const ResourceMappingData *resourceMapping,
+                                       StringRef blob) {
+  MsgPackCursor cursor(blob);
+  uint64_t size = 0;
+  if (!cursor.findMapItem(PalAbi::CodeObjectMetadataKey::Pipelines) || !cursor.readArraySize(&size) || size == 0 ||
+      !cursor.findMapItem(PalAbi::PipelineMetadataKey::Registers) || !cursor.readMapSize(&size))
+    return true;
+  for (uint64_t i = 0; i != size; ++i) {
+    uint64_t regNumber = 0;
+    if (!cursor.readUInt(&regNumber))
+      return true;
+    uint64_t regValue = 0;
+    unsigned offset = 0;
+    if (!isRootDescriptorRegister(gfxIpMajor, regNumber)) {
+      if (!cursor.skipValue())
+        return true;
+    } else if (!cursor.readUInt(&regValue) || getRootDescriptorOffset(resourceMapping, regValue, &offset))
+      return true;
+  }
+  return false;
+}
+
 // =====================================================================================================================
 // Update descriptor offset to USER_DATA in metaNote, in place in the messagepack document.
 //
-// @param context : Context related to ElfNote
+// @param gfxIpMajor : Major version of the graphics IP
+// @param resourceMapping : Resource mapping of the pipeline
 // @param [in/out] document : The parsed message pack document of the metadata note.
-static void updateRootDescriptorRegisters(Context *context, msgpack::Document &document) {
+static void updateRootDescriptorRegisters(unsigned gfxIpMajor, const ResourceMappingData *resourceMapping,
+                                          msgpack::Document &document) {
   auto pipeline = document.getRoot().getMap(true)[PalAbi::CodeObjectMetadataKey::Pipelines].getArray(true)[0];
   auto registers = pipeline.getMap(true)[PalAbi::PipelineMetadataKey::Registers].getMap(true);
-  const unsigned mmSpiShaderUserDataVs0 = 0x2C4C;
-  const unsigned mmSpiShaderUserDataPs0 = 0x2c0c;
-  const unsigned mmComputeUserData0 = 0x2E40;
-  unsigned userDataBaseRegisters[] = {mmSpiShaderUserDataVs0, mmSpiShaderUserDataPs0, mmComputeUserData0};
-  const unsigned vsPsUserDataCount = context->getGfxIpVersion().major < 9 ? 16 : 32;
-  unsigned userDataCount[] = {vsPsUserDataCount, vsPsUserDataCount, 16};
-  for (auto stage = 0; stage < sizeof(userDataBaseRegisters) / sizeof(unsigned); ++stage) {
-    unsigned baseRegister = userDataBaseRegisters[stage];
-    unsigned registerCount = userDataCount[stage];
-    for (unsigned i = 0; i < registerCount; ++i) {
-      unsigned key = baseRegister + i;
-      auto keyNode = registers.getDocument()->getNode(key);
-      auto keyIt = registers.find(keyNode);
-      if (keyIt != registers.end()) {
-        assert(keyIt->first.getUInt() == key);
-        // Reloc Descriptor user data value is consisted by DescRelocMagic | set.
-        unsigned regValue = keyIt->second.getUInt();
-        if (DescRelocMagic == (regValue & DescRelocMagicMask)) {
-          const ResourceMappingData *resourceMapping = nullptr;
-          if (baseRegister == mmComputeUserData0) {
-            auto pipelineInfo = reinterpret_cast<const ComputePipelineBuildInfo *>(context->getPipelineBuildInfo());
-            resourceMapping = &pipelineInfo->resourceMapping;
-          } else {
-            auto pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(context->getPipelineBuildInfo());
-            resourceMapping = &pipelineInfo->resourceMapping;
-          }
-          unsigned set = regValue & DescSetMask;
-          for (unsigned j = 0; j < resourceMapping->userDataNodeCount; ++j) {
-            auto userDataNode = &resourceMapping->pUserDataNodes[j].node;
-            if (userDataNode->type == ResourceMappingNodeType::DescriptorTableVaPtr &&
-                set == userDataNode->tablePtr.pNext[0].srdRange.set) {
-              // If it's descriptor user data, then update its offset to it.
-              unsigned value = userDataNode->offsetInDwords;
-              keyIt->second = registers.getDocument()->getNode(value);
-              // Update userDataLimit if necessary
-              unsigned userDataLimit = pipeline.getMap(true)[PalAbi::PipelineMetadataKey::UserDataLimit].getUInt();
-              pipeline.getMap(true)[PalAbi::PipelineMetadataKey::UserDataLimit] =
-                  document.getNode(std::max(userDataLimit, value + 1));
-
-              break;
-            }
-          }
-        }
-      }
+  for (auto &item : registers) {
+    if (item.first.getKind() != msgpack::Type::UInt || !isRootDescriptorRegister(gfxIpMajor, item.first.getUInt()))
+      continue;
+    unsigned value = 0;
+    if (getRootDescriptorOffset(resourceMapping, static_cast<unsigned>(item.second.getUInt()), &value)) {
+      // If it's descriptor user data, then update its offset to it.
+      item.second = document.getNode(value);
+      // Update userDataLimit if necessary
+      unsigned userDataLimit = pipeline.getMap(true)[PalAbi::PipelineMetadataKey::UserDataLimit].getUInt();
+      pipeline.getMap(true)[PalAbi::PipelineMetadataKey::UserDataLimit] =
+          document.getNode(std::max(userDataLimit, value + 1));
     }
   }
 }
 
+// List of fragment shader related registers.
+static const unsigned PsRegNumbers[] = {
+    0x2C0A, // mmSPI_SHADER_PGM_RSRC1_PS
+    0x2C0B, // mmSPI_SHADER_PGM_RSRC2_PS
+    0xA1C4, // mmSPI_SHADER_Z_FORMAT
+    0xA1C5, // mmSPI_SHADER_COL_FORMAT
+    0xA1B8, // mmSPI_BARYC_CNTL
+    0xA1B6, // mmSPI_PS_IN_CONTROL
+    0xA1B3, // mmSPI_PS_INPUT_ENA
+    0xA1B4, // mmSPI_PS_INPUT_ADDR
+    0xA1B5, // mmSPI_INTERP_CONTROL_0
+    0xA293, // mmPA_SC_MODE_CNTL_1
+    0xA203, // mmDB_SHADER_CONTROL
+    0xA08F, // mmCB_SHADER_MASK
+    0xA2F8, // mmPA_SC_AA_CONFIG
+    // The following ones are GFX9+ only, but we don't need to handle them specially as those register
+    // numbers are not used at all on earlier chips.
+    0xA310, // mmPA_SC_SHADER_CONTROL
+    0xA210, // mmPA_STEREO_CNTL
+    0xC25F, // mmGE_STEREO_CNTL
+    0xC262, // mmGE_USER_VGPR_EN
+    0x2C06, // mmSPI_SHADER_PGM_CHKSUM_PS
+    0x2C32, // mmSPI_SHADER_USER_ACCUM_PS_0
+    0x2C33, // mmSPI_SHADER_USER_ACCUM_PS_1
+    0x2C34, // mmSPI_SHADER_USER_ACCUM_PS_2
+    0x2C35, // mmSPI_SHADER_USER_ACCUM_PS_3
+};
+
+static const unsigned mmSpiPsInputCntl0 = 0xa191;
+static const unsigned mmSpiPsInputCntl31 = 0xa1b0;
+static const unsigned mmSpiShaderUserDataPs0 = 0x2c0c;
+
 // =====================================================================================================================
 // Merges fragment shader related info for meta notes.
 //
-// @param pContext : The first note section to merge
-// @param pNote1 : The second note section to merge (contain fragment shader info)
+// @param pContext : Pipeline context
+// @param pNote1 : The first note section to merge
 // @param pNote2 : Note section contains fragment shader info
 // @param [out] pNewNote : Merged note section
+// @param getNote1Document : If set, gets the already decoded PAL metadata of the first note, for the case that it
+//                           needs to be decoded
 template <class Elf>
-void ElfWriter<Elf>::mergeMetaNote(Context *pContext, const ElfNote *pNote1, const ElfNote *pNote2, ElfNote *pNewNote) {
-  msgpack::Document destDocument;
-  msgpack::Document srcDocument;
+void ElfWriter<Elf>::mergeMetaNote(Context *pContext, const ElfNote *pNote1, const ElfNote *pNote2, ElfNote *pNewNote,
+                                   function_ref<msgpack::Document *()> getNote1Document) {
+  auto pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(pContext->getPipelineBuildInfo());
+  MetaNoteMergeInfo mergeInfo = {pContext->getGfxIpVersion().major, pContext->getPipelineHashCode(),
+                                 &pipelineInfo->resourceMapping};
+  StringRef destBlob(reinterpret_cast<const char *>(pNote1->data), pNote1->hdr.descSize);
+  StringRef srcBlob(reinterpret_cast<const char *>(pNote2->data), pNote2->hdr.descSize);
+
+  // Merge without decoding either note, falling back to merging in a decoded document if the metadata is not laid
+  // out as that expects.
+  std::string mergedBlob;
+  if (!mergeMetaBlob(mergeInfo, destBlob, srcBlob, &mergedBlob)) {
+    msgpack::Document localDocument;
+    msgpack::Document *destDocument = getNote1Document ? getNote1Document() : nullptr;
+    if (!destDocument) {
+      auto success = localDocument.readFromBlob(destBlob, false);
+      assert(success);
+      (void(success)); // unused
+      destDocument = &localDocument;
+    }
+    mergeMetaDocument(mergeInfo, *destDocument, srcBlob, &mergedBlob);
+  }
 
-  auto success =
-      destDocument.readFromBlob(StringRef(reinterpret_cast<const char *>(pNote1->data), pNote1->hdr.descSize), false);
-  assert(success);
+  *pNewNote = *pNote1;
+  auto data = new uint8_t[mergedBlob.size() + 4]; // 4 is for additional alignment spece
+  memcpy(data, mergedBlob.data(), mergedBlob.size());
+  pNewNote->hdr.descSize = mergedBlob.size();
+  pNewNote->data = data;
+}
+
+// =====================================================================================================================
+// Merges fragment shader related info from a PAL metadata blob into a decoded PAL metadata document, and encodes the
+// result. The merged document refers to nodes of the fragment shader info document, which only lives until the
+// result is encoded, so it must only be reused by merging again.
+//
+// @param mergeInfo : Pipeline-specific values for the merge
+// @param [in/out] destDocument : PAL metadata to merge into
+// @param srcBlob : PAL metadata blob containing fragment shader info
+// @param [out] mergedBlob : Merged PAL metadata blob
+template <class Elf>
+void ElfWriter<Elf>::mergeMetaDocument(const MetaNoteMergeInfo &mergeInfo, msgpack::Document &destDocument,
+                                       StringRef srcBlob, std::string *mergedBlob) {
+  msgpack::Document srcDocument;
 
-  success =
-      srcDocument.readFromBlob(StringRef(reinterpret_cast<const char *>(pNote2->data), pNote2->hdr.descSize), false);
+  auto success = srcDocument.readFromBlob(srcBlob, false);
   assert(success);
   (void(success)); // unused
 
@@ -299,36 +417,8 @@ void ElfWriter<Elf>::mergeMetaNote(Context *pContext, const ElfNote *pNote1, con
 
   // Update pipeline hash
   auto pipelineHash = destPipeline.getMap(true)[PalAbi::PipelineMetadataKey::InternalPipelineHash].getArray(true);
-  pipelineHash[0] = destDocument.getNode(pContext->getPipelineHashCode());
-  pipelineHash[1] = destDocument.getNode(pContext->getPipelineHashCode());
-
-  // List of fragment shader related registers.
-  static const unsigned PsRegNumbers[] = {
-      0x2C0A, // mmSPI_SHADER_PGM_RSRC1_PS
-      0x2C0B, // mmSPI_SHADER_PGM_RSRC2_PS
-      0xA1C4, // mmSPI_SHADER_Z_FORMAT
-      0xA1C5, // mmSPI_SHADER_COL_FORMAT
-      0xA1B8, // mmSPI_BARYC_CNTL
-      0xA1B6, // mmSPI_PS_IN_CONTROL
-      0xA1B3, // mmSPI_PS_INPUT_ENA
-      0xA1B4, // mmSPI_PS_INPUT_ADDR
-      0xA1B5, // mmSPI_INTERP_CONTROL_0
-      0xA293, // mmPA_SC_MODE_CNTL_1
-      0xA203, // mmDB_SHADER_CONTROL
-      0xA08F, // mmCB_SHADER_MASK
-      0xA2F8, // mmPA_SC_AA_CONFIG
-      // The following ones are GFX9+ only, but we don't need to handle them specially as those register
-      // numbers are not used at all on earlier chips.
-      0xA310, // mmPA_SC_SHADER_CONTROL
-      0xA210, // mmPA_STEREO_CNTL
-      0xC25F, // mmGE_STEREO_CNTL
-      0xC262, // mmGE_USER_VGPR_EN
-      0x2C06, // mmSPI_SHADER_PGM_CHKSUM_PS
-      0x2C32, // mmSPI_SHADER_USER_ACCUM_PS_0
-      0x2C33, // mmSPI_SHADER_USER_ACCUM_PS_1
-      0x2C34, // mmSPI_SHADER_USER_ACCUM_PS_2
-      0x2C35, // mmSPI_SHADER_USER_ACCUM_PS_3
-  };
+  pipelineHash[0] = destDocument.getNode(mergeInfo.pipelineHash);
+  pipelineHash[1] = destDocument.getNode(mergeInfo.pipelineHash);
 
   // Merge fragment shader related registers. For each of the registers listed above, plus the input
   // control registers and the user data registers, copy the value from srcRegisters to destRegisters.
@@ -339,36 +429,364 @@ void ElfWriter<Elf>::mergeMetaNote(Context *pContext, const ElfNote *pNote1, con
   for (unsigned regNumber : ArrayRef<unsigned>(PsRegNumbers))
     mergeMapItem(destRegisters, srcRegisters, regNumber);
 
-  const unsigned mmSpiPsInputCntl0 = 0xa191;
-  const unsigned mmSpiPsInputCntl31 = 0xa1b0;
   for (unsigned regNumber = mmSpiPsInputCntl0; regNumber != mmSpiPsInputCntl31 + 1; ++regNumber)
     mergeMapItem(destRegisters, srcRegisters, regNumber);
 
-  const unsigned mmSpiShaderUserDataPs0 = 0x2c0c;
-  unsigned psUserDataCount = pContext->getGfxIpVersion().major < 9 ? 16 : 32;
+  unsigned psUserDataCount = mergeInfo.gfxIpMajor < 9 ? 16 : 32;
   for (unsigned regNumber = mmSpiShaderUserDataPs0; regNumber != mmSpiShaderUserDataPs0 + psUserDataCount; ++regNumber)
     mergeMapItem(destRegisters, srcRegisters, regNumber);
 
-  updateRootDescriptorRegisters(pContext, destDocument);
+  updateRootDescriptorRegisters(mergeInfo.gfxIpMajor, mergeInfo.resourceMapping, destDocument);
 
-  std::string destBlob;
-  destDocument.writeToBlob(destBlob);
-  *pNewNote = *pNote1;
-  auto data = new uint8_t[destBlob.size() + 4]; // 4 is for additional alignment spece
-  memcpy(data, destBlob.data(), destBlob.size());
-  pNewNote->hdr.descSize = destBlob.size();
-  pNewNote->data = data;
+  mergedBlob->clear();
+  destDocument.writeToBlob(*mergedBlob);
+}
+
+namespace {
+
+// An item of a string-keyed map being merged. Its value is either the encoded bytes from one of the blobs, or newly
+// encoded.
+struct MetaMapItem {
+  StringRef key;        // Key
+  StringRef rawValue;   // Encoded value from a blob, if newValue is empty
+  std::string newValue; // Newly encoded value
+};
+
+// An item of the register map being merged.
+struct MetaRegisterItem {
+  uint64_t regNumber; // Register number
+  StringRef rawValue; // Encoded value from a blob, if hasNewValue is false
+  uint64_t newValue;  // New value
+  bool hasNewValue;   // Whether newValue is set
+};
+
+// =====================================================================================================================
+// Reads the items of a string-keyed map.
+//
+// @param blob : Encoded map
+// @param [out] items : The items
+static bool readMetaMap(StringRef blob, std::vector<MetaMapItem> &items) {
+  MsgPackCursor cursor(blob);
+  uint64_t size = 0;
+  if (!cursor.readMapSize(&size))
+    return false;
+  items.resize(size);
+  for (MetaMapItem &item : items) {
+    if (!cursor.readString(&item.key) || !cursor.readValue(&item.rawValue))
+      return false;
+  }
+  return true;
 }
 
 // =====================================================================================================================
-// Gets symbol according to symbol name, and creates a new one if it doesn't exist.
+// Finds the item with the given key in a string-keyed map.
+//
+// @param items : The items of the map
+// @param key : Key to find
+static MetaMapItem *findMetaMapItem(std::vector<MetaMapItem> &items, StringRef key) {
+  for (MetaMapItem &item : items) {
+    if (item.key == key)
+      return &item;
+  }
+  return nullptr;
+}
+
+// =====================================================================================================================
+// Sets the value of the item with the given key in a string-keyed map, adding the item if it is not there.
+//
+// @param [in/out] items : The items of the map
+// @param key : Key of the item
+// @param rawValue : Encoded value
+static void setMetaMapItem(std::vector<MetaMapItem> &items, StringRef key, StringRef rawValue) {
+  MetaMapItem *item = findMetaMapItem(items, key);
+  if (!item) {
+    items.push_back({key, {}, {}});
+    item = &items.back();
+  }
+  item->rawValue = rawValue;
+  item->newValue.clear();
+}
+
+// =====================================================================================================================
+// Encodes an unsigned integer.
+//
+// @param value : The integer
+static std::string encodeUInt(uint64_t value) {
+  std::string encoded;
+  raw_string_ostream stream(encoded);
+  msgpack::Writer(stream).write(value);
+  return stream.str();
+}
+
+// =====================================================================================================================
+// Encodes a string-keyed map, with its items sorted by key as msgpack::Document does.
+//
+// @param [in/out] items : The items of the map, sorted on return
+// @param [out] writer : Writer to encode the map with
+// @param [out] stream : Stream of the writer
+static void writeMetaMap(std::vector<MetaMapItem> &items, msgpack::Writer &writer, raw_ostream &stream) {
+  std::sort(items.begin(), items.end(),
+            [](const MetaMapItem &lhs, const MetaMapItem &rhs) { return lhs.key < rhs.key; });
+  writer.writeMapSize(items.size());
+  for (const MetaMapItem &item : items) {
+    writer.write(item.key);
+    if (!item.newValue.empty())
+      stream << item.newValue;
+    else
+      stream << item.rawValue;
+  }
+}
+
+// =====================================================================================================================
+// Encodes a string-keyed map, with its items sorted by key, as a new value.
+//
+// @param [in/out] items : The items of the map, sorted on return
+static std::string encodeMetaMap(std::vector<MetaMapItem> &items) {
+  std::string encoded;
+  raw_string_ostream stream(encoded);
+  msgpack::Writer writer(stream);
+  writeMetaMap(items, writer, stream);
+  return stream.str();
+}
+
+// =====================================================================================================================
+// Reads the items of the register map.
+//
+// @param blob : Encoded map
+// @param [out] items : The items
+static bool readMetaRegisters(StringRef blob, std::vector<MetaRegisterItem> &items) {
+  MsgPackCursor cursor(blob);
+  uint64_t size = 0;
+  if (!cursor.readMapSize(&size))
+    return false;
+  items.reserve(items.size() + size);
+  for (uint64_t i = 0; i != size; ++i) {
+    MetaRegisterItem item = {};
+    if (!cursor.readUInt(&item.regNumber) || !cursor.readValue(&item.rawValue))
+      return false;
+    items.push_back(item);
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Checks whether a register is one that ElfWriter::mergeMetaDocument takes from the fragment half.
+//
+// @param regNumber : Register number
+// @param psUserDataCount : Number of PS user data registers
+static bool isFragmentRegister(uint64_t regNumber, unsigned psUserDataCount) {
+  return (regNumber >= mmSpiPsInputCntl0 && regNumber <= mmSpiPsInputCntl31) ||
+         (regNumber >= mmSpiShaderUserDataPs0 && regNumber < mmSpiShaderUserDataPs0 + psUserDataCount) ||
+         is_contained(PsRegNumbers, regNumber);
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Merges fragment shader related info from one PAL metadata blob into another, giving the same result as
+// mergeMetaDocument but without decoding either blob into a document. It walks the known layout of the metadata,
+// copying the encoded bytes of everything it does not change. It fails if the metadata is not laid out as expected,
+// in which case the caller falls back to mergeMetaDocument.
+//
+// @param mergeInfo : Pipeline-specific values for the merge
+// @param destBlob : PAL metadata blob to merge into
+// @param srcBlob : PAL metadata blob containing fragment shader info
+// @param [out] mergedBlob : Merged PAL metadata blob
+// @returns : True if successful
+template <class Elf>
+bool ElfWriter<Elf>::mergeMetaBlob(const MetaNoteMergeInfo &mergeInfo, StringRef destBlob, StringRef srcBlob,
+                                   std::string *mergedBlob) {
+  // Find the pipeline in each blob.
+  std::vector<MetaMapItem> destRoot;
+  std::vector<MetaMapItem> srcRoot;
+  if (!readMetaMap(destBlob, destRoot) || !readMetaMap(srcBlob, srcRoot))
+    return false;
+  MetaMapItem *destPipelines = findMetaMapItem(destRoot, PalAbi::CodeObjectMetadataKey::Pipelines);
+  MetaMapItem *srcPipelines = findMetaMapItem(srcRoot, PalAbi::CodeObjectMetadataKey::Pipelines);
+  if (!destPipelines || !srcPipelines)
+    return false;
+
+  MsgPackCursor destPipelinesCursor(destPipelines->rawValue);
+  MsgPackCursor srcPipelinesCursor(srcPipelines->rawValue);
+  uint64_t destPipelineCount = 0;
+  uint64_t srcPipelineCount = 0;
+  StringRef destPipelineBlob;
+  StringRef srcPipelineBlob;
+  if (!destPipelinesCursor.readArraySize(&destPipelineCount) || destPipelineCount == 0 ||
+      !destPipelinesCursor.readValue(&destPipelineBlob) || !srcPipelinesCursor.readArraySize(&srcPipelineCount) ||
+      srcPipelineCount == 0 || !srcPipelinesCursor.readValue(&srcPipelineBlob))
+    return false;
+
+  std::vector<MetaMapItem> destPipeline;
+  std::vector<MetaMapItem> srcPipeline;
+  if (!readMetaMap(destPipelineBlob, destPipeline) || !readMetaMap(srcPipelineBlob, srcPipeline))
+    return false;
+
+  // Find the items that are merged.
+  MetaMapItem *destSpillThreshold = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::SpillThreshold);
+  MetaMapItem *destUserDataLimit = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::UserDataLimit);
+  MetaMapItem *destHwStages = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::HardwareStages);
+  MetaMapItem *destShaders = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::Shaders);
+  MetaMapItem *destPipelineHash = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::InternalPipelineHash);
+  MetaMapItem *destRegisters = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::Registers);
+  MetaMapItem *srcNumInterpolants = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::NumInterpolants);
+  MetaMapItem *srcSpillThreshold = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::SpillThreshold);
+  MetaMapItem *srcUserDataLimit = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::UserDataLimit);
+  MetaMapItem *srcHwStages = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::HardwareStages);
+  MetaMapItem *srcShaders = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::Shaders);
+  MetaMapItem *srcRegisters = findMetaMapItem(srcPipeline, PalAbi::PipelineMetadataKey::Registers);
+  if (!destSpillThreshold || !destUserDataLimit || !destHwStages || !destShaders || !destPipelineHash ||
+      !destRegisters || !srcSpillThreshold || !srcUserDataLimit || !srcHwStages || !srcShaders || !srcRegisters)
+    return false;
+
+  uint64_t destSpillThresholdValue = 0;
+  uint64_t srcSpillThresholdValue = 0;
+  uint64_t destUserDataLimitValue = 0;
+  uint64_t srcUserDataLimitValue = 0;
+  if (!MsgPackCursor(destSpillThreshold->rawValue).readUInt(&destSpillThresholdValue) ||
+      !MsgPackCursor(srcSpillThreshold->rawValue).readUInt(&srcSpillThresholdValue) ||
+      !MsgPackCursor(destUserDataLimit->rawValue).readUInt(&destUserDataLimitValue) ||
+      !MsgPackCursor(srcUserDataLimit->rawValue).readUInt(&srcUserDataLimitValue))
+    return false;
+
+  // Copy the whole .ps hardware stage and .pixel shader.
+  std::vector<MetaMapItem> destHwStageItems;
+  std::vector<MetaMapItem> srcHwStageItems;
+  std::vector<MetaMapItem> destShaderItems;
+  std::vector<MetaMapItem> srcShaderItems;
+  if (!readMetaMap(destHwStages->rawValue, destHwStageItems) || !readMetaMap(srcHwStages->rawValue, srcHwStageItems) ||
+      !readMetaMap(destShaders->rawValue, destShaderItems) || !readMetaMap(srcShaders->rawValue, srcShaderItems))
+    return false;
+  auto hwPsStageName = HwStageNames[static_cast<unsigned>(Util::Abi::HardwareStage::Ps)];
+  MetaMapItem *srcHwPsStage = findMetaMapItem(srcHwStageItems, hwPsStageName);
+  MetaMapItem *srcPixelShader = findMetaMapItem(srcShaderItems, ApiStageNames[ShaderStageFragment]);
+  if (!srcHwPsStage || !srcPixelShader)
+    return false;
+  setMetaMapItem(destHwStageItems, hwPsStageName, srcHwPsStage->rawValue);
+  setMetaMapItem(destShaderItems, ApiStageNames[ShaderStageFragment], srcPixelShader->rawValue);
+
+  // Update the pipeline hash, keeping any further elements of the array.
+  MsgPackCursor pipelineHashCursor(destPipelineHash->rawValue);
+  uint64_t pipelineHashSize = 0;
+  StringRef pipelineHashElement;
+  if (!pipelineHashCursor.readArraySize(&pipelineHashSize) || pipelineHashSize < 2 ||
+      !pipelineHashCursor.readValue(&pipelineHashElement) || !pipelineHashCursor.readValue(&pipelineHashElement))
+    return false;
+
+  // Merge the registers: the fragment shader related ones come from the fragment half, and the rest from the
+  // non-fragment half.
+  unsigned psUserDataCount = mergeInfo.gfxIpMajor < 9 ? 16 : 32;
+  std::vector<MetaRegisterItem> registers;
+  if (!readMetaRegisters(destRegisters->rawValue, registers))
+    return false;
+  registers.erase(std::remove_if(registers.begin(), registers.end(),
+                                 [psUserDataCount](const MetaRegisterItem &item) {
+                                   return isFragmentRegister(item.regNumber, psUserDataCount);
+                                 }),
+                  registers.end());
+  size_t destRegisterCount = registers.size();
+  if (!readMetaRegisters(srcRegisters->rawValue, registers))
+    return false;
+  registers.erase(std::remove_if(registers.begin() + destRegisterCount, registers.end(),
+                                 [psUserDataCount](const MetaRegisterItem &item) {
+                                   return !isFragmentRegister(item.regNumber, psUserDataCount);
+                                 }),
+                  registers.end());
+  std::sort(registers.begin(), registers.end(), [](const MetaRegisterItem &lhs, const MetaRegisterItem &rhs) {
+    return lhs.regNumber < rhs.regNumber;
+  });
+
+  // Update descriptor user data registers to the offsets in the resource mapping, as updateRootDescriptorRegisters
+  // does. A compute one would need the compute resource mapping, so leave that to the fallback.
+  const unsigned mmSpiShaderUserDataVs0 = 0x2C4C;
+  const unsigned mmComputeUserData0 = 0x2E40;
+  uint64_t userDataLimit = std::max(destUserDataLimitValue, srcUserDataLimitValue);
+  for (MetaRegisterItem &item : registers) {
+    bool isCompute = item.regNumber >= mmComputeUserData0 && item.regNumber < mmComputeUserData0 + 16;
+    if (!isCompute &&
+        !(item.regNumber >= mmSpiShaderUserDataVs0 && item.regNumber < mmSpiShaderUserDataVs0 + psUserDataCount) &&
+        !(item.regNumber >= mmSpiShaderUserDataPs0 && item.regNumber < mmSpiShaderUserDataPs0 + psUserDataCount))
+      continue;
+    uint64_t regValue = 0;
+    if (!MsgPackCursor(item.rawValue).readUInt(&regValue))
+      return false;
+    unsigned offset = 0;
+    if (DescRelocMagic != (regValue & DescRelocMagicMask) ||
+        !getDescriptorTableUserDataOffset(mergeInfo.resourceMapping, regValue & DescSetMask, &offset))
+      continue;
+    if (isCompute)
+      return false;
+    item.newValue = offset;
+    item.hasNewValue = true;
+    userDataLimit = std::max<uint64_t>(userDataLimit, offset + 1);
+  }
+
+  // Encode the merged items of the pipeline.
+  if (srcNumInterpolants)
+    setMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::NumInterpolants, srcNumInterpolants->rawValue);
+  // Adding an item may have moved the others.
+  destSpillThreshold = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::SpillThreshold);
+  destUserDataLimit = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::UserDataLimit);
+  destHwStages = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::HardwareStages);
+  destShaders = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::Shaders);
+  destPipelineHash = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::InternalPipelineHash);
+  destRegisters = findMetaMapItem(destPipeline, PalAbi::PipelineMetadataKey::Registers);
+
+  destSpillThreshold->newValue = encodeUInt(std::min(destSpillThresholdValue, srcSpillThresholdValue));
+  destUserDataLimit->newValue = encodeUInt(userDataLimit);
+  destHwStages->newValue = encodeMetaMap(destHwStageItems);
+  destShaders->newValue = encodeMetaMap(destShaderItems);
+
+  {
+    raw_string_ostream stream(destPipelineHash->newValue);
+    msgpack::Writer writer(stream);
+    writer.writeArraySize(pipelineHashSize);
+    writer.write(mergeInfo.pipelineHash);
+    writer.write(mergeInfo.pipelineHash);
+    stream << pipelineHashCursor.getRest();
+  }
+
+  {
+    raw_string_ostream stream(destRegisters->newValue);
+    msgpack::Writer writer(stream);
+    writer.writeMapSize(registers.size());
+    for (const MetaRegisterItem &item : registers) {
+      writer.write(item.regNumber);
+      if (item.hasNewValue)
+        writer.write(item.newValue);
+      else
+        stream << item.rawValue;
+    }
+  }
+
+  // Encode the pipelines array, with the merged pipeline first, then the root map.
+  {
+    raw_string_ostream stream(destPipelines->newValue);
+    msgpack::Writer writer(stream);
+    writer.writeArraySize(destPipelineCount);
+    writeMetaMap(destPipeline, writer, stream);
+    stream << destPipelinesCursor.getRest();
+  }
+
+  mergedBlob->clear();
+  raw_string_ostream stream(*mergedBlob);
+  msgpack::Writer writer(stream);
+  writeMetaMap(destRoot, writer, stream);
+  stream.flush();
+  return true;
+}
+
+// =====================================================================================================================
+// Gets symbol according to symbol name, and creates a new one if it doesn't exist. The symbols are looked up by a
+// name index, which is extended with the symbols added since the last lookup.
 //
 // @param pSymbolName : Symbol name
 template <class Elf> ElfSymbol *ElfWriter<Elf>::getSymbol(const char *pSymbolName) {
-  for (auto &symbol : m_symbols) {
-    if (strcmp(pSymbolName, symbol.pSymName) == 0)
-      return &symbol;
-  }
+  for (; m_indexedSymbols < m_symbols.size(); ++m_indexedSymbols)
+    m_symbolIndex.try_emplace(m_symbols[m_indexedSymbols].pSymName, m_indexedSymbols);
+  auto it = m_symbolIndex.find(pSymbolName);
+  if (it != m_symbolIndex.end())
+    return &m_symbols[it->second];
 
   // Create new symbol
   ElfSymbol newSymbol = {};
@@ -407,7 +825,7 @@ template <class Elf> void ElfWriter<Elf>::setNote(ElfNote *pNote) {
   for (auto &note : m_notes) {
     if (note.hdr.type == pNote->hdr.type) {
       assert(note.data != pNote->data);
-      delete[] note.data;
+      freeData(note.data);
       note = *pNote;
       return;
     }
@@ -426,7 +844,7 @@ template <class Elf> void ElfWriter<Elf>::setSection(unsigned secIndex, SectionB
   assert(pSection->name == m_sections[secIndex].name);
   assert(pSection->data != m_sections[secIndex].data);
 
-  delete[] m_sections[secIndex].data;
+  freeData(m_sections[secIndex].data);
   m_sections[secIndex] = *pSection;
 }
 
@@ -461,7 +879,7 @@ template <class Elf> void ElfWriter<Elf>::assembleNotes() {
     noteSize += noteHeaderSize + noteNameSize + alignTo(note.hdr.descSize, sizeof(unsigned));
   }
 
-  delete[] noteSection->data;
+  freeData(noteSection->data);
   uint8_t *data = new uint8_t[std::max(noteSize, noteHeaderSize)];
   assert(data);
   memset(data, 0, std::max(noteSize, noteHeaderSize));
@@ -500,7 +918,7 @@ template <class Elf> void ElfWriter<Elf>::assembleSymbols() {
     unsigned strTabOffset = strTabSection->secHead.sh_size;
     auto strTabBuffer = new uint8_t[strTabSection->secHead.sh_size + newStrTabSize];
     memcpy(strTabBuffer, strTabSection->data, strTabSection->secHead.sh_size);
-    delete[] strTabSection->data;
+    freeData(strTabSection->data);
 
     strTabSection->data = strTabBuffer;
     strTabSection->secHead.sh_size += newStrTabSize;
@@ -520,10 +938,11 @@ template <class Elf> void ElfWriter<Elf>::assembleSymbols() {
   auto symSectionSize = sizeof(typename Elf::Symbol) * symbolCount;
   auto symbolSection = &m_sections[m_symSecIdx];
 
+  // The symbols are written in place, so a symbol table that refers to the input ELF is replaced rather than reused.
   if (!symbolSection->data)
     symbolSection->data = new uint8_t[symSectionSize];
-  else if (symSectionSize > symbolSection->secHead.sh_size) {
-    delete[] symbolSection->data;
+  else if (symSectionSize > symbolSection->secHead.sh_size || isBorrowed(symbolSection->data)) {
+    freeData(symbolSection->data);
     symbolSection->data = new uint8_t[symSectionSize];
   }
   symbolSection->secHead.sh_size = symSectionSize;
@@ -569,8 +988,42 @@ template <class Elf> void ElfWriter<Elf>::calcSectionHeaderOffset() {
 }
 
 // =====================================================================================================================
-// Writes the data out to the given buffer in ELF format. Assumes the buffer has been pre-allocated with adequate
-// space, which can be determined with a call to "GetRequireBufferSizeBytes()".
+// Frees the data of a section or note, unless it refers to the input ELF.
+//
+// @param data : Data to free
+template <class Elf> void ElfWriter<Elf>::freeData(const uint8_t *data) {
+  if (!isBorrowed(data))
+    delete[] data;
+}
+
+// =====================================================================================================================
+// Copies the data of the sections and notes that refer to the input ELF, so that the input ELF can be overwritten.
+template <class Elf> void ElfWriter<Elf>::takeOwnershipOfBorrowedData() {
+  for (auto &section : m_sections) {
+    if (!isBorrowed(section.data))
+      continue;
+    auto data = new uint8_t[section.secHead.sh_size + 1];
+    memcpy(data, section.data, section.secHead.sh_size);
+    data[section.secHead.sh_size] = 0;
+    section.data = data;
+  }
+
+  for (auto &note : m_notes) {
+    if (!isBorrowed(note.data))
+      continue;
+    const unsigned noteDescSize = alignTo(note.hdr.descSize, 4);
+    auto data = new uint8_t[noteDescSize];
+    memcpy(data, note.data, noteDescSize);
+    note.data = data;
+  }
+
+  m_borrowedBegin = 0;
+  m_borrowedEnd = 0;
+}
+
+// =====================================================================================================================
+// Writes the data out to the given buffer in ELF format, in a single pass over the sections. The buffer is sized up
+// front with "getRequiredBufferSizeBytes()", and only the alignment padding is cleared rather than the whole buffer.
 //
 // @param pElf : Output buffer to write ELF data
 template <class Elf> void ElfWriter<Elf>::writeToBuffer(ElfPackage *pElf) {
@@ -580,10 +1033,15 @@ template <class Elf> void ElfWriter<Elf>::writeToBuffer(ElfPackage *pElf) {
   assembleNotes();
   assembleSymbols();
 
+  // The output buffer may be the input ELF, such as when an ELF is updated in place, so the data that refers to it has
+  // to be copied before it is overwritten or reallocated.
+  const auto outputBegin = reinterpret_cast<uintptr_t>(pElf->data());
+  if (m_borrowedBegin < outputBegin + pElf->capacity() && outputBegin < m_borrowedEnd)
+    takeOwnershipOfBorrowedData();
+
   const size_t reqSize = getRequiredBufferSizeBytes();
   pElf->resize(reqSize);
   auto data = pElf->data();
-  memset(data, 0, reqSize);
 
   char *buffer = static_cast<char *>(data);
 
@@ -598,9 +1056,11 @@ template <class Elf> void ElfWriter<Elf>::writeToBuffer(ElfPackage *pElf) {
   for (auto &section : m_sections) {
     section.secHead.sh_offset = static_cast<unsigned>(buffer - data);
     const unsigned sizeBytes = section.secHead.sh_size;
+    const unsigned alignedSizeBytes = alignTo(sizeBytes, sizeof(unsigned));
     if (sizeBytes > 0)
       memcpy(buffer, section.data, sizeBytes);
-    buffer += alignTo(sizeBytes, sizeof(unsigned));
+    memset(buffer + sizeBytes, 0, alignedSizeBytes - sizeBytes);
+    buffer += alignedSizeBytes;
   }
 
   const unsigned secHdrSize = sizeof(typename Elf::SectionHeader);
@@ -613,21 +1073,39 @@ template <class Elf> void ElfWriter<Elf>::writeToBuffer(ElfPackage *pElf) {
 }
 
 // =====================================================================================================================
-// Copies ELF content from a ElfReader.
+// Copies ELF content from a ElfReader. The sections and notes that are not changed refer to the reader's input buffer
+// rather than being copied, so that buffer must outlive the writer, or be the buffer that writeToBuffer writes into.
+// Each borrowed section or note is copied only when the writer changes it in place.
 //
 // @param reader : The ElfReader to copy from.
 template <class Elf> Result ElfWriter<Elf>::copyFromReader(const ElfReader<Elf> &reader) {
   Result result = Result::Success;
   m_header = reader.getHeader();
   m_sections.resize(reader.getSections().size());
+  m_borrowedBegin = 0;
+  m_borrowedEnd = 0;
   for (size_t i = 0; i < reader.getSections().size(); ++i) {
     auto section = reader.getSections()[i];
     m_sections[i].secHead = section->secHead;
     m_sections[i].name = section->name;
-    auto data = new uint8_t[section->secHead.sh_size + 1];
-    memcpy(data, section->data, section->secHead.sh_size);
-    data[section->secHead.sh_size] = 0;
-    m_sections[i].data = data;
+
+    // The disassembly sections are searched as text, which needs the null terminator added to a copy. Empty sections
+    // are copied too, so that every borrowed section lies within the range of the input buffer that it spans.
+    const bool isText = strcmp(section->name, Util::Abi::AmdGpuDisassemblyName) == 0 ||
+                        strcmp(section->name, Util::Abi::AmdGpuCommentLlvmIrName) == 0;
+    if (isText || section->secHead.sh_size == 0) {
+      auto data = new uint8_t[section->secHead.sh_size + 1];
+      memcpy(data, section->data, section->secHead.sh_size);
+      data[section->secHead.sh_size] = 0;
+      m_sections[i].data = data;
+      continue;
+    }
+
+    const auto begin = reinterpret_cast<uintptr_t>(section->data);
+    const auto end = begin + section->secHead.sh_size;
+    m_borrowedBegin = m_borrowedEnd == 0 ? begin : std::min(m_borrowedBegin, begin);
+    m_borrowedEnd = std::max(m_borrowedEnd, end);
+    m_sections[i].data = section->data;
   }
 
   m_map = reader.getMap();
@@ -657,10 +1135,11 @@ template <class Elf> Result ElfWriter<Elf>::copyFromReader(const ElfReader<Elf>
     memcpy(&noteNode.hdr, note, noteHeaderSize);
     memcpy(noteNode.hdr.name, note->name, noteNameSize);
 
+    // The descriptor refers to the input buffer along with the note section, unless it is empty.
     const unsigned noteDescSize = alignTo(note->descSize, 4);
-    auto data = new uint8_t[noteDescSize];
-    memcpy(data, noteSection->data + offset + noteHeaderSize + noteNameSize, noteDescSize);
-    noteNode.data = data;
+    noteNode.data = noteSection->data + offset + noteHeaderSize + noteNameSize;
+    if (noteDescSize == 0)
+      noteNode.data = new uint8_t[1];
 
     offset += noteHeaderSize + noteNameSize + noteDescSize;
     m_notes.push_back(noteNode);
@@ -723,17 +1202,29 @@ Result ElfWriter<Elf>::getSectionDataBySectionIndex(unsigned secIdx, const Secti
 // @param pNote : Note section to update
 // @param [out] pNewNote : New note section
 template <class Elf> void ElfWriter<Elf>::updateMetaNote(Context *pContext, const ElfNote *pNote, ElfNote *pNewNote) {
-  msgpack::Document document;
-
-  auto success =
-      document.readFromBlob(StringRef(reinterpret_cast<const char *>(pNote->data), pNote->hdr.descSize), false);
-  assert(success);
-  (void(success)); // unused
-
-  updateRootDescriptorRegisters(pContext, document);
+  const ResourceMappingData *resourceMapping = nullptr;
+  if (pContext->isGraphics()) {
+    auto pipelineInfo = reinterpret_cast<const GraphicsPipelineBuildInfo *>(pContext->getPipelineBuildInfo());
+    resourceMapping = &pipelineInfo->resourceMapping;
+  } else {
+    auto pipelineInfo = reinterpret_cast<const ComputePipelineBuildInfo *>(pContext->getPipelineBuildInfo());
+    resourceMapping = &pipelineInfo->resourceMapping;
+  }
+  const unsigned gfxIpMajor = pContext->getGfxIpVersion().major;
+  StringRef blob(reinterpret_cast<const char *>(pNote->data), pNote->hdr.descSize);
+
+  // Most pipelines have no reloc descriptor user data, and then the note is copied without being decoded.
+  std::string updatedBlob;
+  if (hasRootDescriptorRegisters(gfxIpMajor, resourceMapping, blob)) {
+    msgpack::Document document;
+    auto success = document.readFromBlob(blob, false);
+    assert(success);
+    (void(success)); // unused
+    updateRootDescriptorRegisters(gfxIpMajor, resourceMapping, document);
+    document.writeToBlob(updatedBlob);
+    blob = updatedBlob;
+  }
 
-  std::string blob;
-  document.writeToBlob(blob);
   *pNewNote = *pNote;
   auto data = new uint8_t[blob.size()];
   memcpy(data, blob.data(), blob.size());
@@ -800,7 +1291,7 @@ typename ElfWriter<Elf>::SectionBuffer ElfWriter<Elf>::createNewSection(const ch
   memcpy(strTabData, m_sections[m_strtabSecIdx].data, strTabSize);
   memcpy(strTabData + strTabSize, sectionName, secNameSize);
 
-  delete[] m_sections[m_strtabSecIdx].data;
+  freeData(m_sections[m_strtabSecIdx].data);
 
   m_sections[m_strtabSecIdx].data = strTabData;
   m_sections[m_strtabSecIdx].secHead.sh_size = strTabSize + secNameSize;
@@ -876,30 +1367,27 @@ template <class Elf> void ElfWriter<Elf>::addRelocSymbols(const ElfReader<Elf> &
 }
 
 // =====================================================================================================================
-// Get the reloc symbol index based on the input reloc symbol
+// Get the reloc symbol index based on the input reloc symbol. The index of a symbol is the number of symbols before
+// it that go into the symbol table. The indices of the symbols added since the last call are collected first.
 //
 // @param inputSymbolName : The input reloc symbol name
+// @param [in/out] relocSymbolIndices : Indices of the reloc symbols collected so far for this reloc section
 // @returns : Reloc symbol index
-template <class Elf> uint32_t ElfWriter<Elf>::getRelocSymbolIndex(const char *inputSymbolName) {
-  const size_t inputSymbolNameLen = strlen(inputSymbolName);
-  const size_t newSymSize = inputSymbolNameLen + strlen(CachedRodataSymbolSuffix) + 1;
-  char *newSymName = new char[newSymSize];
-  memset(newSymName, 0, newSymSize);
-  memcpy(newSymName, inputSymbolName, inputSymbolNameLen);
-  memcpy(newSymName + inputSymbolNameLen, CachedRodataSymbolSuffix, newSymSize - inputSymbolNameLen);
-
-  uint32_t index = 0;
-  for (auto symbol : m_symbols) {
+template <class Elf>
+uint32_t ElfWriter<Elf>::getRelocSymbolIndex(const char *inputSymbolName, RelocSymbolIndices &relocSymbolIndices) {
+  for (; relocSymbolIndices.scannedSymbols < m_symbols.size(); ++relocSymbolIndices.scannedSymbols) {
+    const ElfSymbol &symbol = m_symbols[relocSymbolIndices.scannedSymbols];
     if (symbol.secIdx == InvalidValue)
       continue;
-    if (symbol.nameOffset == InvalidValue && strcmp(newSymName, symbol.pSymName) == 0)
-      break;
-    ++index;
+    if (symbol.nameOffset == InvalidValue)
+      relocSymbolIndices.indices.try_emplace(symbol.pSymName, relocSymbolIndices.tableSymbols);
+    ++relocSymbolIndices.tableSymbols;
   }
 
-  delete[] newSymName;
-
-  return index;
+  SmallString<64> newSymName(inputSymbolName);
+  newSymName += CachedRodataSymbolSuffix;
+  auto it = relocSymbolIndices.indices.find(newSymName);
+  return it != relocSymbolIndices.indices.end() ? it->second : relocSymbolIndices.tableSymbols;
 }
 
 // =====================================================================================================================
@@ -957,6 +1445,7 @@ ElfWriter<Elf>::mergeRelocSection(const ElfReader<Elf> &reader, const SectionBuf
     auto section2Relocs = reinterpret_cast<typename Elf::Reloc *>(const_cast<uint8_t *>(section2->data));
     size_t section2RelocsCount = numRelocs(section2);
     size_t relocSize = section2->secHead.sh_entsize;
+    RelocSymbolIndices relocSymbolIndices;
 
     for (auto i = section2RelocsOffset; i < section2RelocsCount; ++i) {
       addRelocSymbols(reader, section2Relocs[i]);
@@ -967,7 +1456,7 @@ ElfWriter<Elf>::mergeRelocSection(const ElfReader<Elf> &reader, const SectionBuf
       reloc.r_type = section2Relocs[i].r_type;
       ElfSymbol section2RelocSymbol = {};
       reader.getSymbol(section2Relocs[i].r_symbol, &section2RelocSymbol);
-      reloc.r_symbol = getRelocSymbolIndex(section2RelocSymbol.pSymName);
+      reloc.r_symbol = getRelocSymbolIndex(section2RelocSymbol.pSymName, relocSymbolIndices);
       memcpy(data, &reloc, relocSize);
       data += relocSize;
     }
@@ -1084,6 +1573,7 @@ void ElfWriter<Elf>::updateSymbolsBySectionIndex(unsigned secIdx, std::vector<El
   auto newEnd =
       std::remove_if(m_symbols.begin(), m_symbols.end(), [&secIdx](ElfSymbol &sym) { return sym.secIdx == secIdx; });
   m_symbols.erase(newEnd, m_symbols.end());
+  resetSymbolIndex();
   for (auto &secSymbol : secSymbols)
     m_symbols.push_back(secSymbol);
 }
@@ -1135,8 +1625,11 @@ template <class Elf> void ElfWriter<Elf>::updateElfBinary(Context *pContext, Elf
 // @param pContext : Pipeline context
 // @param pFragmentElf : ELF binary of fragment shader
 // @param [out] pPipelineElf : Final ELF binary
+// @param getNonFragmentMetadata : If set, gets the already decoded PAL metadata of this ELF, for the case that it
+//                                 needs to be decoded to merge the fragment shader info into it
 template <class Elf>
-void ElfWriter<Elf>::mergeElfBinary(Context *pContext, const BinaryData *pFragmentElf, ElfPackage *pPipelineElf) {
+void ElfWriter<Elf>::mergeElfBinary(Context *pContext, const BinaryData *pFragmentElf, ElfPackage *pPipelineElf,
+                                    function_ref<msgpack::Document *()> getNonFragmentMetadata) {
   auto fragmentIsaSymbolName =
       Util::Abi::PipelineAbiSymbolNameStrings[static_cast<unsigned>(Util::Abi::PipelineSymbolType::PsMainEntry)];
   auto fragmentIntrlTblSymbolName =
@@ -1311,7 +1804,7 @@ void ElfWriter<Elf>::mergeElfBinary(Context *pContext, const BinaryData *pFragme
   ElfNote fragmentMetaNote = {};
   ElfNote newMetaNote = {};
   fragmentMetaNote = reader.getNote(Util::Abi::MetadataNoteType);
-  mergeMetaNote(pContext, &nonFragmentMetaNote, &fragmentMetaNote, &newMetaNote);
+  mergeMetaNote(pContext, &nonFragmentMetaNote, &fragmentMetaNote, &newMetaNote, getNonFragmentMetadata);
   setNote(&newMetaNote);
 
   // Process reloc Section.
@@ -1326,6 +1819,7 @@ template <class Elf> void ElfWriter<Elf>::reinitialize() {
   m_map.clear();
   m_notes.clear();
   m_symbols.clear();
+  resetSymbolIndex();
 
   m_sections.push_back({});
 
@@ -1352,4 +1846,82 @@ template <class Elf> void ElfWriter<Elf>::reinitialize() {
 
 template class ElfWriter<Elf64>;
 
+// =====================================================================================================================
+//
+// @param gfxIp : Graphics IP version info
+// @param elf : ELF of the non-fragment half of a graphics pipeline
+NonFragmentElf::NonFragmentElf(GfxIpVersion gfxIp, const BinaryData &elf)
+    : m_gfxIp(gfxIp), m_elf(static_cast<const char *>(elf.pCode), elf.codeSize) {
+}
+
+// =====================================================================================================================
+// Gets the decoded PAL metadata, for a merge that needs it. The first time, it is decoded from the ELF. After that, the
+// items that the previous merge changed are restored.
+msgpack::Document *NonFragmentElf::getMetadata() {
+  if (m_metadataDecoded) {
+    for (SavedItem &item : m_savedItems) {
+      if (!item.value.isEmpty()) {
+        item.map[item.key] = item.value;
+        continue;
+      }
+      auto it = item.map.find(item.key);
+      if (it != item.map.end())
+        static_cast<MapDocNode &>(item.map).erase(it);
+    }
+    return &m_metadata;
+  }
+
+  // Decode the metadata from our own copy of the ELF, as the decoded strings refer to it.
+  ElfReader<Elf64> reader(m_gfxIp);
+  size_t codeSize = m_elf.size();
+  mustSucceed(reader.ReadFromBuffer(m_elf.data(), &codeSize));
+  ElfNote metaNote = reader.getNote(Util::Abi::MetadataNoteType);
+  assert(metaNote.data);
+  auto success =
+      m_metadata.readFromBlob(StringRef(reinterpret_cast<const char *>(metaNote.data), metaNote.hdr.descSize), false);
+  assert(success);
+  (void(success)); // unused
+  m_metadataDecoded = true;
+
+  // Save the items that ElfWriter::mergeMetaDocument changes based on their existing value, or only sets for some
+  // fragment halves. Everything else it changes is replaced outright by each merge.
+  auto pipeline = m_metadata.getRoot().getMap(true)[PalAbi::CodeObjectMetadataKey::Pipelines].getArray(true)[0];
+  auto pipelineMap = pipeline.getMap(true);
+  saveItem(pipelineMap, m_metadata.getNode(PalAbi::PipelineMetadataKey::NumInterpolants));
+  saveItem(pipelineMap, m_metadata.getNode(PalAbi::PipelineMetadataKey::SpillThreshold));
+  saveItem(pipelineMap, m_metadata.getNode(PalAbi::PipelineMetadataKey::UserDataLimit));
+
+  // Descriptor user data registers are updated from the resource mapping of the pipeline being merged.
+  auto registers = pipelineMap[PalAbi::PipelineMetadataKey::Registers].getMap(true);
+  for (auto &item : registers) {
+    if (item.second.getKind() == msgpack::Type::UInt &&
+        (item.second.getUInt() & DescRelocMagicMask) == DescRelocMagic)
+      m_savedItems.push_back({registers, item.first, item.second});
+  }
+  return &m_metadata;
+}
+
+// =====================================================================================================================
+// Save the decoded value of a metadata map item, so it can be restored before each merge.
+//
+// @param map : Map containing the item
+// @param key : Key of the item
+void NonFragmentElf::saveItem(msgpack::MapDocNode map, msgpack::DocNode key) {
+  auto it = map.find(key);
+  m_savedItems.push_back({map, key, it != map.end() ? it->second : msgpack::DocNode()});
+}
+
+// =====================================================================================================================
+// Merges a fragment half into this non-fragment half, giving the pipeline ELF. If the metadata has to be merged in
+// decoded form, rather than by ElfWriter::mergeMetaBlob, the decoded metadata kept here is used.
+//
+// @param context : Pipeline context
+// @param fragmentElf : ELF whose fragment shader is merged
+// @param [out] pipelineElf : Merged pipeline ELF
+void NonFragmentElf::mergeFragmentElf(Context *context, const BinaryData *fragmentElf, ElfPackage *pipelineElf) {
+  ElfWriter<Elf64> writer(m_gfxIp);
+  mustSucceed(writer.ReadFromBuffer(m_elf.data(), m_elf.size()));
+  writer.mergeElfBinary(context, fragmentElf, pipelineElf, [this]() { return getMetadata(); });
+}
+
 } // namespace Llpc
@@ -32,13 +32,10 @@
 
 #include "llpcUtil.h"
 #include "vkgcElfReader.h"
-
-// Forward declaration
-namespace llvm {
-namespace msgpack {
-class MapDocNode;
-}
-} // namespace llvm
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/MsgPackDocument.h"
+#include <memory>
 
 namespace Llpc {
 
@@ -55,6 +52,14 @@ using Vkgc::Result;
 // Forward declaration
 class Context;
 
+// Pipeline-specific values used when merging the PAL metadata of the fragment half of a graphics pipeline into that of
+// the non-fragment half.
+struct MetaNoteMergeInfo {
+  unsigned gfxIpMajor;                        // Major version of the graphics IP
+  uint64_t pipelineHash;                      // Internal pipeline hash of the merged pipeline
+  const ResourceMappingData *resourceMapping; // Resource mapping, for updating descriptor set user data registers
+};
+
 // =====================================================================================================================
 // Represents a writer for storing data to an ELF buffer.
 //
@@ -72,7 +77,14 @@ public:
                            const SectionBuffer *section2, size_t section2Offset, const char *prefixString2,
                            SectionBuffer *newSection);
 
-  static void mergeMetaNote(Context *context, const ElfNote *note1, const ElfNote *note2, ElfNote *newNote);
+  static void mergeMetaNote(Context *context, const ElfNote *note1, const ElfNote *note2, ElfNote *newNote,
+                            llvm::function_ref<llvm::msgpack::Document *()> getNote1Document = nullptr);
+
+  static void mergeMetaDocument(const MetaNoteMergeInfo &mergeInfo, llvm::msgpack::Document &destDocument,
+                                llvm::StringRef srcBlob, std::string *mergedBlob);
+
+  LLPC_NODISCARD static bool mergeMetaBlob(const MetaNoteMergeInfo &mergeInfo, llvm::StringRef destBlob,
+                                           llvm::StringRef srcBlob, std::string *mergedBlob);
 
   static void updateMetaNote(Context *context, const ElfNote *note, ElfNote *newNote);
 
@@ -88,7 +100,15 @@ public:
 
   void addRelocSymbols(const ElfReader<Elf> &reader, ElfReloc inputRelocs);
 
-  LLPC_NODISCARD uint32_t getRelocSymbolIndex(const char *inputSymbolName);
+  // Symbol table indices of the cached rodata symbols that relocations refer to. They are collected while a reloc
+  // section is merged; the symbols added meanwhile only ever go after the ones collected.
+  struct RelocSymbolIndices {
+    llvm::StringMap<uint32_t> indices; // Symbol table index of each cached rodata symbol, by name
+    size_t scannedSymbols = 0;         // Number of symbols of m_symbols collected so far
+    uint32_t tableSymbols = 0;         // Number of the collected symbols that go into the symbol table
+  };
+
+  LLPC_NODISCARD uint32_t getRelocSymbolIndex(const char *inputSymbolName, RelocSymbolIndices &relocSymbolIndices);
 
   void processRelocSection(const ElfReader<Elf> &reader, size_t nonFragmentPsIsaOffset, size_t fragmentPsIsaOffset);
 
@@ -97,7 +117,8 @@ public:
 
   void updateElfBinary(Context *context, ElfPackage *pipelineElf);
 
-  void mergeElfBinary(Context *context, const BinaryData *fragmentElf, ElfPackage *pipelineElf);
+  void mergeElfBinary(Context *context, const BinaryData *fragmentElf, ElfPackage *pipelineElf,
+                      llvm::function_ref<llvm::msgpack::Document *()> getNonFragmentMetadata = nullptr);
 
   // Gets the section index for the specified section name.
   LLPC_NODISCARD int GetSectionIndex(const char *name) const {
@@ -141,13 +162,36 @@ private:
 
   void reinitialize();
 
+  // Checks whether the data of a section or note refers to the input ELF, rather than being owned by the writer
+  bool isBorrowed(const void *data) const {
+    auto address = reinterpret_cast<uintptr_t>(data);
+    return address >= m_borrowedBegin && address < m_borrowedEnd;
+  }
+
+  void freeData(const uint8_t *data);
+
+  void takeOwnershipOfBorrowedData();
+
+  // Forgets the symbol name index, after symbols have been removed from m_symbols
+  void resetSymbolIndex() {
+    m_symbolIndex.clear();
+    m_indexedSymbols = 0;
+  }
+
   GfxIpVersion m_gfxIp;                  // Graphics IP version info (used by ELF dump only)
   typename Elf::FormatHeader m_header;   // ELF header
-  std::map<std::string, unsigned> m_map; // Map between section name and section index
+  llvm::StringMap<unsigned> m_map;       // Map between section name and section index
 
   std::vector<SectionBuffer> m_sections; // List of section data and headers
   std::vector<ElfNote> m_notes;          // List of Elf notes
   std::vector<ElfSymbol> m_symbols;      // List of Elf symbols
+  // Index of the first symbol in m_symbols with each name, which getSymbol extends to the symbols added since
+  llvm::StringMap<unsigned> m_symbolIndex;
+  size_t m_indexedSymbols = 0; // Number of symbols of m_symbols in m_symbolIndex
+  // Address range of the input ELF that the unchanged sections and notes refer to, between ReadFromBuffer and the
+  // point where the writer has to copy them
+  uintptr_t m_borrowedBegin = 0;
+  uintptr_t m_borrowedEnd = 0;
 
   int m_textSecIdx;   // Section index of .text section
   int m_noteSecIdx;   // Section index of .note section
@@ -156,4 +200,35 @@ private:
   int m_strtabSecIdx; // Section index of string table section
 };
 
+// =====================================================================================================================
+// The non-fragment half of a graphics pipeline ELF, kept with its PAL metadata decoded (when a merge needs that), so
+// that a succession of fragment halves can be merged into it without decoding its metadata note each time.
+class NonFragmentElf {
+public:
+  NonFragmentElf(GfxIpVersion gfxIp, const BinaryData &elf);
+
+  // Merges a fragment half into this one, giving the pipeline ELF
+  void mergeFragmentElf(Context *context, const BinaryData *fragmentElf, ElfPackage *pipelineElf);
+
+private:
+  NonFragmentElf(const NonFragmentElf &) = delete;
+  NonFragmentElf &operator=(const NonFragmentElf &) = delete;
+
+  llvm::msgpack::Document *getMetadata();
+  void saveItem(llvm::msgpack::MapDocNode map, llvm::msgpack::DocNode key);
+
+  // An item in the decoded metadata that a merge changes, other than by replacing it with fragment shader info
+  struct SavedItem {
+    llvm::msgpack::MapDocNode map; // Map containing the item
+    llvm::msgpack::DocNode key;    // Key of the item
+    llvm::msgpack::DocNode value;  // Value as decoded from the ELF, or empty if the item was not there
+  };
+
+  GfxIpVersion m_gfxIp;                // Graphics IP version info
+  std::string m_elf;                   // The ELF
+  llvm::msgpack::Document m_metadata;  // PAL metadata of the ELF, as left by the last merge
+  bool m_metadataDecoded = false;      // Whether m_metadata has been decoded
+  std::vector<SavedItem> m_savedItems; // Items to restore before each merge
+};
+
 } // namespace Llpc
@@ -0,0 +1,259 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcLz4.cpp
+ * @brief LLPC source file: contains the implementation of the LZ4 block compression used to compress cached data
+ ***********************************************************************************************************************
+ */
+#include "llpcLz4.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Llpc {
+
+namespace {
+
+// Length of the shortest match that a sequence can copy
+constexpr size_t MinMatch = 4;
+// Number of bytes at the end of a block that are always literals
+constexpr size_t LastLiterals = 5;
+// The last match must start at least this many bytes before the end of the block
+constexpr size_t MatchFindLimit = 12;
+// Largest distance from a match back to the data it copies
+constexpr size_t MaxOffset = 65535;
+// Length that is stored in a nibble of a sequence token, beyond which extra length bytes follow
+constexpr size_t TokenLengthLimit = 15;
+// Number of bits of the hash of four bytes used to look up earlier occurrences of them
+constexpr unsigned HashBits = 12;
+
+// =====================================================================================================================
+// Reads four unaligned bytes.
+//
+// @param ptr : Pointer to the bytes
+// @returns : The bytes as an integer
+uint32_t read32(const uint8_t *ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+// =====================================================================================================================
+// Hashes four bytes to an index of the match finder table.
+//
+// @param value : The bytes as an integer
+// @returns : Index in the table
+unsigned hashSequence(uint32_t value) {
+  return (value * 2654435761U) >> (32 - HashBits);
+}
+
+// =====================================================================================================================
+// Writes the extra length bytes of a literal or match length that does not fit in its nibble of the token.
+//
+// @param out : Where to write the bytes
+// @param length : Length minus TokenLengthLimit
+// @returns : Pointer past the written bytes
+uint8_t *writeExtraLength(uint8_t *out, size_t length) {
+  for (; length >= 255; length -= 255)
+    *out++ = 255;
+  *out++ = static_cast<uint8_t>(length);
+  return out;
+}
+
+// =====================================================================================================================
+// Reads the extra length bytes of a literal or match length, adding them to the length.
+//
+// @param [in/out] in : Pointer to the bytes, advanced past them
+// @param inEnd : End of the block
+// @param [in/out] length : The length
+// @returns : False if the block ends before the length does
+bool readExtraLength(const uint8_t *&in, const uint8_t *inEnd, size_t &length) {
+  uint8_t byte = 0;
+  do {
+    if (in == inEnd)
+      return false;
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// =====================================================================================================================
+// Writes a sequence, which is a token followed by literals and then, unless it is the last sequence, a match.
+//
+// @param out : Where to write the sequence
+// @param literals : The literals
+// @param literalLength : Number of literals
+// @param matchLength : Length of the match, or 0 for the last sequence
+// @param offset : Distance back from the match to the data it copies
+// @returns : Pointer past the written sequence
+uint8_t *writeSequence(uint8_t *out, const uint8_t *literals, size_t literalLength, size_t matchLength,
+                       size_t offset) {
+  uint8_t *const token = out++;
+  const size_t matchCode = matchLength != 0 ? matchLength - MinMatch : 0;
+  *token =
+      static_cast<uint8_t>((std::min(literalLength, TokenLengthLimit) << 4) | std::min(matchCode, TokenLengthLimit));
+  if (literalLength >= TokenLengthLimit)
+    out = writeExtraLength(out, literalLength - TokenLengthLimit);
+  if (literalLength != 0)
+    memcpy(out, literals, literalLength);
+  out += literalLength;
+  if (matchLength == 0)
+    return out;
+  *out++ = static_cast<uint8_t>(offset);
+  *out++ = static_cast<uint8_t>(offset >> 8);
+  if (matchCode >= TokenLengthLimit)
+    out = writeExtraLength(out, matchCode - TokenLengthLimit);
+  return out;
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Returns the largest size of the LZ4 block that compressLz4Block can produce from the given amount of data, which is
+// when the data is stored as literals.
+//
+// @param numBytes : Size of the data in bytes
+// @returns : Size of the block in bytes
+size_t getLz4BlockBound(size_t numBytes) {
+  return numBytes + numBytes / 255 + 16;
+}
+
+// =====================================================================================================================
+// Compresses the data into an LZ4 block. This is a greedy single-pass compressor: a hash table of the positions of
+// earlier four-byte sequences finds a match, which is extended as far as it goes. Positions that find no match are
+// skipped over faster the longer the literals get, so that incompressible data does not cost much time.
+//
+// @param src : Data to compress
+// @param srcSize : Size of the data in bytes
+// @param [out] dst : Buffer for the block
+// @param dstCapacity : Size of the buffer in bytes
+// @returns : Size of the block in bytes, or 0 if the buffer is too small
+size_t compressLz4Block(const void *src, size_t srcSize, void *dst, size_t dstCapacity) {
+  if (dstCapacity < getLz4BlockBound(srcSize) || srcSize > UINT32_MAX)
+    return 0;
+
+  const uint8_t *const base = static_cast<const uint8_t *>(src);
+  const uint8_t *const end = base + srcSize;
+  const uint8_t *anchor = base;
+  uint8_t *out = static_cast<uint8_t *>(dst);
+
+  if (srcSize >= MatchFindLimit) {
+    const uint8_t *const matchLimit = end - LastLiterals;
+    const uint8_t *const searchLimit = end - MatchFindLimit;
+    std::vector<uint32_t> table(1U << HashBits, 0);
+
+    const uint8_t *in = base;
+    while (in <= searchLimit) {
+      const uint32_t sequence = read32(in);
+      uint32_t &entry = table[hashSequence(sequence)];
+      const uint8_t *const match = base + entry;
+      entry = static_cast<uint32_t>(in - base);
+      if (match >= in || static_cast<size_t>(in - match) > MaxOffset || read32(match) != sequence) {
+        in += 1 + ((in - anchor) >> 6);
+        continue;
+      }
+
+      const uint8_t *matchEnd = in + MinMatch;
+      const uint8_t *copied = match + MinMatch;
+      while (matchEnd < matchLimit && *matchEnd == *copied) {
+        ++matchEnd;
+        ++copied;
+      }
+
+      out = writeSequence(out, anchor, in - anchor, matchEnd - in, in - match);
+      table[hashSequence(read32(matchEnd - 2))] = static_cast<uint32_t>(matchEnd - 2 - base);
+      in = matchEnd;
+      anchor = in;
+    }
+  }
+
+  out = writeSequence(out, anchor, end - anchor, 0, 0);
+  return out - static_cast<uint8_t *>(dst);
+}
+
+// =====================================================================================================================
+// Decompresses an LZ4 block, checking every length and offset against the bounds of the block and the data.
+//
+// @param src : The block
+// @param srcSize : Size of the block in bytes
+// @param [out] dst : Buffer for the data
+// @param dstSize : Size of the data in bytes
+// @returns : True if the block decompressed to exactly dstSize bytes
+bool decompressLz4Block(const void *src, size_t srcSize, void *dst, size_t dstSize) {
+  const uint8_t *in = static_cast<const uint8_t *>(src);
+  const uint8_t *const inEnd = in + srcSize;
+  uint8_t *const outBase = static_cast<uint8_t *>(dst);
+  uint8_t *out = outBase;
+  uint8_t *const outEnd = outBase + dstSize;
+
+  while (in < inEnd) {
+    const uint8_t token = *in++;
+
+    size_t literalLength = token >> 4;
+    if (literalLength == TokenLengthLimit && !readExtraLength(in, inEnd, literalLength))
+      return false;
+    if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out))
+      return false;
+    if (literalLength != 0)
+      memcpy(out, in, literalLength);
+    in += literalLength;
+    out += literalLength;
+
+    // The last sequence has no match.
+    if (in == inEnd)
+      break;
+
+    if (inEnd - in < 2)
+      return false;
+    const size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    if (offset == 0 || offset > static_cast<size_t>(out - outBase))
+      return false;
+
+    size_t matchLength = token & 0xF;
+    if (matchLength == TokenLengthLimit && !readExtraLength(in, inEnd, matchLength))
+      return false;
+    matchLength += MinMatch;
+    if (matchLength > static_cast<size_t>(outEnd - out))
+      return false;
+
+    // A match may overlap the data it produces, which repeats the last offset bytes.
+    const uint8_t *copied = out - offset;
+    if (offset >= matchLength)
+      memcpy(out, copied, matchLength);
+    else {
+      for (size_t i = 0; i < matchLength; ++i)
+        out[i] = copied[i];
+    }
+    out += matchLength;
+  }
+
+  return out == outEnd;
+}
+
+} // namespace Llpc
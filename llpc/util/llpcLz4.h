@@ -0,0 +1,48 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcLz4.h
+ * @brief LLPC header file: contains the declaration of the LZ4 block compression used to compress cached data
+ ***********************************************************************************************************************
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace Llpc {
+
+// Returns the largest size of the LZ4 block that compressLz4Block can produce from numBytes of data.
+size_t getLz4BlockBound(size_t numBytes);
+
+// Compresses the data into an LZ4 block (the LZ4 block format, without a frame). Returns the size of the block, or 0 if
+// dstCapacity is less than getLz4BlockBound(srcSize).
+size_t compressLz4Block(const void *src, size_t srcSize, void *dst, size_t dstCapacity);
+
+// Decompresses an LZ4 block into dstSize bytes of data. Returns false if the block is malformed or does not decompress
+// to exactly dstSize bytes; the block is never read or written out of bounds.
+bool decompressLz4Block(const void *src, size_t srcSize, void *dst, size_t dstSize);
+
+} // namespace Llpc
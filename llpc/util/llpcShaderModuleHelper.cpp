@@ -36,33 +36,55 @@
 #include "llvm/Support/raw_ostream.h"
 #include <set>
 #include <unordered_set>
+
+#ifdef LLPC_ENABLE_SPIRV_OPT
+#include "spvgen.h"
+#endif
 using namespace llvm;
 
 using namespace spv;
 
+using Vkgc::MaxSpirvSummaryEntryPoints;
+using Vkgc::ShaderModuleDataEx;
+using Vkgc::SpirvEntryPointSummary;
 using Vkgc::SpirvHeader;
+using Vkgc::SpirvModuleSummary;
 
 namespace Llpc {
 // =====================================================================================================================
-// Collect information from SPIR-V binary
+// Verifies the SPIR-V binary, and collects information from it, in a single scan of the binary. This gets the usage
+// info and the module summary (entry-points, stage mask, debug info size, id bound and size counts) that are kept in
+// the shader module data, so that pipeline builds using the module do not need to scan the binary again.
 //
 // @param spvBinCode : SPIR-V binary data
+// @param trimDebugInfo : Whether the debug instructions are going to be removed from the binary kept in the shader
+//                        module data; the entry name offsets in the summary are for that binary
 // @param [out] shaderModuleUsage : Shader module usage info
-// @param [out] shaderEntryNames : Entry names for this shader module
-// @param debugInfoSize : Debug info size
-Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCode,
+// @param [out] summary : SPIR-V module summary
+// @returns : Result::Unsupported if there is an instruction that is not supported, Result::ErrorInvalidShader if the
+//            binary is malformed, otherwise Result::Success
+Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCode, bool trimDebugInfo,
                                                       ShaderModuleUsage *shaderModuleUsage,
-                                                      std::vector<ShaderEntryName> &shaderEntryNames,
-                                                      unsigned *debugInfoSize) {
+                                                      SpirvModuleSummary *summary) {
   Result result = Result::Success;
 
+#define _SPIRV_OP(x, ...) Op##x,
+  static const std::set<Op> OpSet{{
+#include "SPIRVOpCodeEnum.h"
+  }};
+#undef _SPIRV_OP
+
   const unsigned *code = reinterpret_cast<const unsigned *>(spvBinCode->pCode);
   const unsigned *end = code + spvBinCode->codeSize / sizeof(unsigned);
 
   const unsigned *codePos = code + sizeof(SpirvHeader) / sizeof(unsigned);
 
+  *summary = {};
+  summary->idBound = reinterpret_cast<const SpirvHeader *>(code)->idBound;
+
   // Parse SPIR-V instructions
   std::unordered_set<unsigned> capabilities;
+  bool inFunction = false;
 
   while (codePos < end) {
     unsigned opCode = (codePos[0] & OpCodeMask);
@@ -74,6 +96,15 @@ Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCo
       break;
     }
 
+    if (OpSet.find(static_cast<Op>(opCode)) == OpSet.end()) {
+      LLPC_ERRS("Unsupported SPIR-V instructions are found!\n");
+      result = Result::Unsupported;
+      break;
+    }
+
+    if (inFunction)
+      ++summary->instructionCount;
+
     // Parse each instruction and find those we are interested in
     switch (opCode) {
     case OpCapability: {
@@ -95,6 +126,12 @@ Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCo
           (opCode == OpDecorate) ? static_cast<Decoration>(codePos[2]) : static_cast<Decoration>(codePos[3]);
       if (decoration == DecorationInvariant) {
         shaderModuleUsage->useInvariant = true;
+      } else if (decoration == DecorationBuiltIn) {
+        auto builtIn = (opCode == OpDecorate) ? static_cast<BuiltIn>(codePos[3]) : static_cast<BuiltIn>(codePos[4]);
+        if (builtIn == BuiltInDeviceIndex)
+          shaderModuleUsage->useDeviceIndex = true;
+      } else if (decoration == DecorationDescriptorSet && opCode == OpDecorate && codePos[3] < 64) {
+        summary->descriptorSetMask |= uint64_t(1) << codePos[3];
       }
       break;
     }
@@ -123,7 +160,7 @@ Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCo
     case OpNop:
     case OpNoLine:
     case OpModuleProcessed: {
-      *debugInfoSize += wordCount * sizeof(unsigned);
+      summary->debugInfoSize += wordCount * sizeof(unsigned);
       break;
     }
     case OpSpecConstantTrue:
@@ -138,12 +175,31 @@ Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCo
       shaderModuleUsage->useIsNan = true;
       break;
     }
+    case OpFunction: {
+      ++summary->functionCount;
+      inFunction = true;
+      break;
+    }
+    case OpFunctionEnd: {
+      inFunction = false;
+      break;
+    }
+    case OpLoopMerge: {
+      ++summary->loopCount;
+      break;
+    }
     case OpEntryPoint: {
-      ShaderEntryName entry = {};
-      // The fourth word is start of the name string of the entry-point
-      entry.name = reinterpret_cast<const char *>(&codePos[3]);
-      entry.stage = convertToShaderStage(codePos[1]);
-      shaderEntryNames.push_back(entry);
+      ShaderStage stage = convertToShaderStage(codePos[1]);
+      summary->stageMask |= shaderStageToMask(stage);
+      if (summary->entryPointCount < MaxSpirvSummaryEntryPoints) {
+        // The fourth word is start of the name string of the entry-point. If the debug instructions are going to be
+        // removed, its offset is reduced by the size of those before it.
+        unsigned nameOffset = (codePos + 3 - code) * sizeof(unsigned);
+        if (trimDebugInfo)
+          nameOffset -= summary->debugInfoSize;
+        summary->entryPoints[summary->entryPointCount++] = {stage, nameOffset};
+      } else
+        summary->entryPointCount = UINT32_MAX;
       break;
     }
     default: {
@@ -172,6 +228,11 @@ Result ShaderModuleHelper::collectInfoFromSpirvBinary(const BinaryData *spvBinCo
     shaderModuleUsage->useSubgroupSize = true;
   }
 
+  summary->isLibrary = capabilities.count(CapabilityLinkage) > 0 && summary->stageMask == 0;
+
+  if (result != Result::Success)
+    summary->idBound = 0;
+
   return result;
 }
 
@@ -261,14 +322,50 @@ Result ShaderModuleHelper::optimizeSpirv(const BinaryData *spirvBinIn, BinaryDat
   return success ? Result::Success : Result::ErrorInvalidShader;
 }
 
+// =====================================================================================================================
+// Optimizes the SPIR-V binary of a shader module, when the shader module is built, with a fixed set of passes that
+// make it smaller: dead function and dead code elimination, and constant folding, including of the specialization
+// constant operations that only use constants. The optimized binary is freed with cleanOptimizedSpirv().
+//
+// @param spirvBinIn : Input SPIR-V binary
+// @param [out] spirvBinOut : Optimized SPIR-V binary
+// @returns : Result::ErrorUnavailable if LLPC is built without the SPIR-V optimizer, Result::ErrorInvalidShader if the
+//            optimization fails, otherwise Result::Success
+Result ShaderModuleHelper::optimizeModuleSpirv(const BinaryData *spirvBinIn, BinaryData *spirvBinOut) {
+  spirvBinOut->codeSize = 0;
+  spirvBinOut->pCode = nullptr;
+
+#ifdef LLPC_ENABLE_SPIRV_OPT
+  if (!InitSpvGen())
+    return Result::ErrorUnavailable;
+
+  static const char *Passes[] = {"--eliminate-dead-functions", "--fold-spec-const-op-composite", "--ccp",
+                                 "--eliminate-dead-code-aggressive", "--eliminate-dead-const"};
+  unsigned optBinSize = 0;
+  void *optBin = nullptr;
+  char logBuf[4096] = {};
+  if (!spvOptimizeSpirv(spirvBinIn->codeSize, spirvBinIn->pCode, sizeof(Passes) / sizeof(Passes[0]), Passes,
+                        &optBinSize, &optBin, sizeof(logBuf), logBuf)) {
+    LLPC_ERRS("Failed to optimize SPIR-V of shader module: " << logBuf << "\n");
+    return Result::ErrorInvalidShader;
+  }
+  spirvBinOut->codeSize = optBinSize;
+  spirvBinOut->pCode = optBin;
+  return Result::Success;
+#else
+  return Result::ErrorUnavailable;
+#endif
+}
+
 // =====================================================================================================================
 // Cleanup work for SPIR-V binary, freeing the allocated buffer by OptimizeSpirv()
 //
 // @param spirvBin : Optimized SPIR-V binary
 void ShaderModuleHelper::cleanOptimizedSpirv(BinaryData *spirvBin) {
 #ifdef LLPC_ENABLE_SPIRV_OPT
-  if (pSpirvBin->pCode) {
-    spvFreeBuffer(const_cast<void *>(pSpirvBin->pCode));
+  if (spirvBin->pCode) {
+    spvFreeBuffer(const_cast<void *>(spirvBin->pCode));
+    spirvBin->pCode = nullptr;
   }
 #endif
 }
@@ -325,42 +422,190 @@ unsigned ShaderModuleHelper::getStageMaskFromSpirvBinary(const BinaryData *spvBi
 }
 
 // =====================================================================================================================
-// Verifies if the SPIR-V binary is valid and is supported
+// Returns true if a SPIR-V shader module is a library of functions for other shaders to call, from the module summary
+// collected when the shader module was built. Without a summary, the module is not taken as a library.
 //
-// @param spvBin : SPIR-V binary
-Result ShaderModuleHelper::verifySpirvBinary(const BinaryData *spvBin) {
-  Result result = Result::Success;
+// @param moduleData : Shader module data, of a SPIR-V shader module
+bool ShaderModuleHelper::isLibraryModuleData(const ShaderModuleData *moduleData) {
+  const SpirvModuleSummary &summary = reinterpret_cast<const ShaderModuleDataEx *>(moduleData)->spirvSummary;
+  return summary.idBound != 0 && summary.isLibrary;
+}
 
-#define _SPIRV_OP(x, ...) Op##x,
-  static const std::set<Op> OpSet{{
-#include "SPIRVOpCodeEnum.h"
-  }};
-#undef _SPIRV_OP
+// =====================================================================================================================
+// Gets the shader stage mask of the given entry-point of a SPIR-V shader module, from the module summary collected when
+// the shader module was built. Falls back to scanning the SPIR-V binary if there is no summary.
+//
+// @param moduleData : Shader module data, of a SPIR-V shader module
+// @param entryName : Name of the entry-point
+unsigned ShaderModuleHelper::getStageMaskFromModuleData(const ShaderModuleData *moduleData, const char *entryName) {
+  const SpirvModuleSummary &summary = reinterpret_cast<const ShaderModuleDataEx *>(moduleData)->spirvSummary;
+  if (summary.idBound == 0 || summary.entryPointCount == UINT32_MAX)
+    return getStageMaskFromSpirvBinary(&moduleData->binCode, entryName);
+
+  unsigned stageMask = 0;
+  const char *code = static_cast<const char *>(moduleData->binCode.pCode);
+  for (unsigned i = 0; i < summary.entryPointCount; ++i) {
+    const SpirvEntryPointSummary &entryPoint = summary.entryPoints[i];
+    if (strcmp(entryName, code + entryPoint.nameOffset) == 0)
+      stageMask |= shaderStageToMask(entryPoint.stage);
+  }
+  return stageMask;
+}
+
+// =====================================================================================================================
+// Checks whether the specialization constants of the SPIR-V binary can be translated as placeholders (see readSpirv),
+// so that the translated module is shared by all specializations of the shader. This is the case when the binary has
+// scalar specialization constants, and each of them is only used by instructions in function bodies that take any
+// value as that operand. Specialization constants that are used in types (array sizes), in other specialization
+// constants, in execution modes or as constant operands (such as memory scopes) need their values at translation time.
+//
+// NOTE: A word of an instruction that is not known to only take placeholder-safe operands is taken as a use when it
+// has the same value as a specialization constant ID, even if it is a literal. This may miss some shaders that could
+// use placeholders, but never accepts one that cannot.
+//
+// @param spvBin : SPIR-V binary
+bool ShaderModuleHelper::canUseSpecConstantPlaceholders(const BinaryData *spvBin) {
+  if (!isSpirvBinary(spvBin))
+    return false;
 
   const unsigned *code = reinterpret_cast<const unsigned *>(spvBin->pCode);
   const unsigned *end = code + spvBin->codeSize / sizeof(unsigned);
+  const unsigned *begin = code + sizeof(SpirvHeader) / sizeof(unsigned);
 
-  // Skip SPIR-V header
-  const unsigned *codePos = code + sizeof(SpirvHeader) / sizeof(unsigned);
-
-  while (codePos < end) {
-    Op opCode = static_cast<Op>(codePos[0] & OpCodeMask);
+  // Collect the IDs of the scalar specialization constants and of the GLSL.std.450 instruction set.
+  std::unordered_set<unsigned> specConstIds;
+  unsigned glslExtInstSetId = InvalidValue;
+  for (const unsigned *codePos = begin; codePos < end;) {
+    unsigned opCode = (codePos[0] & OpCodeMask);
     unsigned wordCount = (codePos[0] >> WordCountShift);
+    if (wordCount == 0 || codePos + wordCount > end)
+      return false;
 
-    if (wordCount == 0 || codePos + wordCount > end) {
-      result = Result::ErrorInvalidShader;
+    switch (opCode) {
+    case OpSpecConstantTrue:
+    case OpSpecConstantFalse:
+    case OpSpecConstant:
+      specConstIds.insert(codePos[2]);
+      break;
+    case OpSpecConstantComposite:
+    case OpSpecConstantOp:
+    case OpExecutionModeId:
+      return false;
+    case OpExtInstImport:
+      if (strcmp(reinterpret_cast<const char *>(&codePos[2]), "GLSL.std.450") == 0)
+        glslExtInstSetId = codePos[1];
+      break;
+    default:
       break;
     }
+    codePos += wordCount;
+  }
+  if (specConstIds.empty())
+    return false;
 
-    if (OpSet.find(opCode) == OpSet.end()) {
-      result = Result::ErrorInvalidShader;
+  for (const unsigned *codePos = begin; codePos < end;) {
+    const unsigned *inst = codePos;
+    unsigned opCode = (inst[0] & OpCodeMask);
+    unsigned wordCount = (inst[0] >> WordCountShift);
+    codePos += wordCount;
+
+    switch (opCode) {
+    // Definitions and annotations of the specialization constants
+    case OpSpecConstantTrue:
+    case OpSpecConstantFalse:
+    case OpSpecConstant:
+    case OpName:
+    case OpDecorate:
+    // Arithmetic, bitwise, logical, relational and conversion instructions
+    case OpSNegate:
+    case OpFNegate:
+    case OpIAdd:
+    case OpFAdd:
+    case OpISub:
+    case OpFSub:
+    case OpIMul:
+    case OpFMul:
+    case OpUDiv:
+    case OpSDiv:
+    case OpFDiv:
+    case OpUMod:
+    case OpSRem:
+    case OpSMod:
+    case OpFRem:
+    case OpFMod:
+    case OpVectorTimesScalar:
+    case OpMatrixTimesScalar:
+    case OpShiftRightLogical:
+    case OpShiftRightArithmetic:
+    case OpShiftLeftLogical:
+    case OpBitwiseOr:
+    case OpBitwiseXor:
+    case OpBitwiseAnd:
+    case OpNot:
+    case OpLogicalEqual:
+    case OpLogicalNotEqual:
+    case OpLogicalOr:
+    case OpLogicalAnd:
+    case OpLogicalNot:
+    case OpSelect:
+    case OpIEqual:
+    case OpINotEqual:
+    case OpUGreaterThan:
+    case OpSGreaterThan:
+    case OpUGreaterThanEqual:
+    case OpSGreaterThanEqual:
+    case OpULessThan:
+    case OpSLessThan:
+    case OpULessThanEqual:
+    case OpSLessThanEqual:
+    case OpFOrdEqual:
+    case OpFUnordEqual:
+    case OpFOrdNotEqual:
+    case OpFUnordNotEqual:
+    case OpFOrdLessThan:
+    case OpFUnordLessThan:
+    case OpFOrdGreaterThan:
+    case OpFUnordGreaterThan:
+    case OpFOrdLessThanEqual:
+    case OpFUnordLessThanEqual:
+    case OpFOrdGreaterThanEqual:
+    case OpFUnordGreaterThanEqual:
+    case OpIsNan:
+    case OpIsInf:
+    case OpConvertFToU:
+    case OpConvertFToS:
+    case OpConvertSToF:
+    case OpConvertUToF:
+    case OpUConvert:
+    case OpSConvert:
+    case OpFConvert:
+    case OpBitcast:
+    // Composite, memory and control flow instructions that take the operand as a value
+    case OpCompositeConstruct:
+    case OpCompositeInsert:
+    case OpCopyObject:
+    case OpStore:
+    case OpPhi:
+    case OpBranchConditional:
+    case OpSwitch:
+    case OpReturnValue:
+    case OpFunctionCall:
+      continue;
+    case OpExtInst:
+      if (inst[3] == glslExtInstSetId)
+        continue;
+      break;
+    default:
       break;
     }
 
-    codePos += wordCount;
+    for (const unsigned *operand = inst + 1; operand != codePos; ++operand) {
+      if (specConstIds.count(*operand) != 0)
+        return false;
+    }
   }
 
-  return result;
+  return true;
 }
 
 // =====================================================================================================================
@@ -43,28 +43,28 @@ struct ShaderModuleEntry {
   unsigned passIndex;        // Indices of passes, It is only for internal debug.
 };
 
-// Represents the name map <stage, name> of shader entry-point
-struct ShaderEntryName {
-  ShaderStage stage; // Shader stage
-  const char *name;  // Entry name
-};
-
 // =====================================================================================================================
 // Represents LLPC shader module helper class
 class ShaderModuleHelper {
 public:
-  static Result collectInfoFromSpirvBinary(const BinaryData *spvBinCode, ShaderModuleUsage *shaderModuleUsage,
-                                           std::vector<ShaderEntryName> &shaderEntryNames, unsigned *debugInfoSize);
+  static Result collectInfoFromSpirvBinary(const BinaryData *spvBinCode, bool trimDebugInfo,
+                                           ShaderModuleUsage *shaderModuleUsage, Vkgc::SpirvModuleSummary *summary);
 
   static void trimSpirvDebugInfo(const BinaryData *spvBin, unsigned bufferSize, void *trimSpvBin);
 
   static Result optimizeSpirv(const BinaryData *spirvBinIn, BinaryData *spirvBinOut);
 
+  static Result optimizeModuleSpirv(const BinaryData *spirvBinIn, BinaryData *spirvBinOut);
+
   static void cleanOptimizedSpirv(BinaryData *spirvBin);
 
   static unsigned getStageMaskFromSpirvBinary(const BinaryData *spvBin, const char *entryName);
 
-  static Result verifySpirvBinary(const BinaryData *spvBin);
+  static unsigned getStageMaskFromModuleData(const ShaderModuleData *moduleData, const char *entryName);
+
+  static bool isLibraryModuleData(const ShaderModuleData *moduleData);
+
+  static bool canUseSpecConstantPlaceholders(const BinaryData *spvBin);
 
   static bool isLlvmBitcode(const BinaryData *shaderBin);
 };
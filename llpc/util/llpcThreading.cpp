@@ -0,0 +1,223 @@
+/*
+ ***********************************************************************************************************************
+ *
+ *  Copyright (c) 2021 Google LLC. All Rights Reserved.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ **********************************************************************************************************************/
+/**
+ ***********************************************************************************************************************
+ * @file  llpcThreading.cpp
+ * @brief LLPC source file: contains the implementation of LLPC multi-threading utilities
+ ***********************************************************************************************************************
+ */
+#include "llpcThreading.h"
+#include <atomic>
+#include <cassert>
+
+using namespace llvm;
+
+namespace Llpc {
+
+namespace {
+// The pool and queue index of the worker running on this thread, if any.
+thread_local ThreadPool *CurrentPool = nullptr;
+thread_local unsigned CurrentWorkerIdx = 0;
+
+// The state of one `parallelFor` loop, shared between the calling thread and its helper jobs. A helper job may start
+// running after the loop has finished, so the state is reference counted, and only the parts of it that are valid
+// after the loop finishes are touched before a task is claimed.
+struct ParallelTasksState {
+  std::atomic<size_t> nextTask{0};           // Position in the task order of the next task to claim
+  std::atomic<unsigned> numActiveHelpers{0}; // Number of helper jobs that may still be running a task
+  std::mutex mutex;                          // Guards firstErr, and is used to wait for the active helpers
+  std::condition_variable helpersDone;       // Signalled when numActiveHelpers drops to 0
+  Error firstErr = Error::success();         // Errors returned by the tasks
+};
+
+// =====================================================================================================================
+// Claims and runs tasks until there are no more tasks to claim.
+//
+// @param state : State of the loop
+// @param taskOrder : Task indices in the order to hand them out
+// @param runTask : Function that runs the task with the given index
+void runClaimedTasks(ParallelTasksState &state, ArrayRef<size_t> taskOrder, function_ref<Error(size_t)> runTask) {
+  const size_t numTasks = taskOrder.size();
+  for (size_t pos = state.nextTask++; pos < numTasks; pos = state.nextTask++) {
+    if (Error err = runTask(taskOrder[pos])) {
+      state.nextTask = numTasks; // Make the other threads finish without picking up any remaining tasks.
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.firstErr = joinErrors(std::move(state.firstErr), std::move(err));
+      break;
+    }
+  }
+}
+
+} // anonymous namespace
+
+// =====================================================================================================================
+// Creates the pool and starts its worker threads.
+//
+// @param numWorkers : Number of worker threads. Pass 0 to create one thread per available processor.
+ThreadPool::ThreadPool(unsigned numWorkers) {
+  if (numWorkers == 0)
+    numWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+
+  m_queues.reserve(numWorkers);
+  for (unsigned workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+    m_queues.push_back(std::make_unique<WorkerQueue>());
+
+  m_workers.reserve(numWorkers);
+  for (unsigned workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+    m_workers.emplace_back([this, workerIdx] { runWorker(workerIdx); });
+}
+
+// =====================================================================================================================
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stopping = true;
+  }
+  m_wakeCondition.notify_all();
+
+  for (std::thread &worker : m_workers)
+    worker.join();
+}
+
+// =====================================================================================================================
+// Get the pool shared by the whole process.
+ThreadPool &ThreadPool::getGlobal() {
+  static ThreadPool GlobalPool(0);
+  return GlobalPool;
+}
+
+// =====================================================================================================================
+// Queues a job to be run on one of the worker threads.
+//
+// @param job : Job to run
+void ThreadPool::submit(Job job) {
+  unsigned queueIdx = 0;
+  {
+    // Count the job before it becomes visible in a queue, so that taking it never makes the count drop below 0.
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    ++m_pendingJobs;
+    if (CurrentPool == this)
+      queueIdx = CurrentWorkerIdx;
+    else
+      queueIdx = m_nextQueue++ % m_queues.size();
+  }
+
+  {
+    WorkerQueue &queue = *m_queues[queueIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+  }
+  m_wakeCondition.notify_one();
+}
+
+// =====================================================================================================================
+// Takes a job for the given worker: the newest job of its own queue, otherwise the oldest job of another queue.
+//
+// @param workerIdx : Index of the worker
+// @param [out] job : The job taken
+// @returns : True if a job was taken
+bool ThreadPool::takeJob(unsigned workerIdx, Job &job) {
+  const unsigned numQueues = m_queues.size();
+  bool found = false;
+  for (unsigned i = 0; i < numQueues && !found; ++i) {
+    WorkerQueue &queue = *m_queues[(workerIdx + i) % numQueues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+      continue;
+    if (i == 0) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    } else {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+    found = true;
+  }
+
+  if (found) {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    assert(m_pendingJobs != 0);
+    --m_pendingJobs;
+  }
+  return found;
+}
+
+// =====================================================================================================================
+// Runs jobs on a worker thread until the pool is destroyed.
+//
+// @param workerIdx : Index of the worker
+void ThreadPool::runWorker(unsigned workerIdx) {
+  CurrentPool = this;
+  CurrentWorkerIdx = workerIdx;
+
+  for (;;) {
+    Job job;
+    if (takeJob(workerIdx, job)) {
+      job();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wakeCondition.wait(lock, [this] { return m_stopping || m_pendingJobs != 0; });
+    if (m_stopping && m_pendingJobs == 0)
+      break;
+  }
+}
+
+namespace detail {
+// =====================================================================================================================
+// Runs `runTask` on each task index in `taskOrder`, on the calling thread and `numWorkers - 1` jobs of the global
+// thread pool. Returns once every claimed task has finished; helper jobs that start later find no task to claim.
+//
+// @param numWorkers : Number of threads to run the tasks on, including the calling thread
+// @param taskOrder : Task indices in the order to hand them out
+// @param runTask : Function that runs the task with the given index
+// @returns : `llvm::ErrorSuccess` on success, an error or combination on errors from `runTask` on failure.
+Error runParallelTasks(unsigned numWorkers, ArrayRef<size_t> taskOrder, function_ref<Error(size_t)> runTask) {
+  auto state = std::make_shared<ParallelTasksState>();
+  ThreadPool &pool = ThreadPool::getGlobal();
+
+  for (unsigned helperIdx = 1; helperIdx < numWorkers; ++helperIdx) {
+    pool.submit([state, taskOrder, runTask] {
+      // Register before claiming a task, so that the calling thread cannot miss a helper that is running a task.
+      ++state->numActiveHelpers;
+      runClaimedTasks(*state, taskOrder, runTask);
+
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (--state->numActiveHelpers == 0)
+        state->helpersDone.notify_all();
+    });
+  }
+
+  runClaimedTasks(*state, taskOrder, runTask);
+
+  // Wait for the helpers that are still running a task.
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->helpersDone.wait(lock, [&state] { return state->numActiveHelpers == 0; });
+  return std::move(state->firstErr);
+}
+} // namespace detail
+
+} // namespace Llpc
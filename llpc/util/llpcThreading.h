@@ -30,15 +30,70 @@
  */
 #pragma once
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Error.h"
-#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <numeric>
 #include <thread>
 #include <vector>
 
 namespace Llpc {
 
+// =====================================================================================================================
+// A persistent pool of worker threads. Each worker owns a queue of jobs: it runs the most recently queued job of its
+// own queue first, and steals the oldest job from the other workers' queues when its own queue is empty. Jobs
+// submitted from a worker thread go to that worker's queue; jobs submitted from other threads are distributed over
+// the queues in round-robin order.
+//
+// The pool never waits for the jobs it runs, so a job may itself submit more jobs.
+class ThreadPool {
+public:
+  using Job = std::function<void()>;
+
+  // Creates a pool with `numWorkers` threads. Passing 0 creates one thread per available processor.
+  explicit ThreadPool(unsigned numWorkers);
+
+  // Waits for all queued jobs to finish, then joins the worker threads.
+  ~ThreadPool();
+
+  // Get the pool shared by the whole process. It is created on first use, with one thread per available processor.
+  static ThreadPool &getGlobal();
+
+  // Gets the number of worker threads.
+  unsigned getNumWorkers() const { return m_workers.size(); }
+
+  // Queues a job to be run on one of the worker threads.
+  void submit(Job job);
+
+private:
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // The queue of jobs owned by one worker thread.
+  struct WorkerQueue {
+    std::mutex mutex;     // Guards jobs
+    std::deque<Job> jobs; // Queued jobs, oldest first
+  };
+
+  void runWorker(unsigned workerIdx);
+  bool takeJob(unsigned workerIdx, Job &job);
+
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues; // Per-worker job queues
+  std::vector<std::thread> m_workers;                 // Worker threads
+  std::mutex m_wakeMutex;                             // Guards m_pendingJobs and m_stopping
+  std::condition_variable m_wakeCondition;            // Signalled when a job is queued or the pool stops
+  size_t m_pendingJobs = 0;                           // Number of jobs queued but not yet taken by a worker
+  bool m_stopping = false;                            // Whether the pool is being destroyed
+  unsigned m_nextQueue = 0;                           // Next queue for jobs submitted from outside the pool
+};
+
 namespace detail {
 // =====================================================================================================================
 // Decides how many concurrent threads to use, taking into the requested number of threads, the number of tasks
@@ -62,29 +117,39 @@ inline unsigned decideNumConcurrentThreads(size_t numThreadsRequested, size_t nu
 
   return std::min(numThreadsRequested, numTasks);
 }
+
+// Runs `runTask` on each task index in `taskOrder`, on the calling thread and `numWorkers - 1` jobs of the global
+// thread pool, handing out the tasks in the given order. This is an implementation detail of `parallelFor`.
+llvm::Error runParallelTasks(unsigned numWorkers, llvm::ArrayRef<size_t> taskOrder,
+                             llvm::function_ref<llvm::Error(size_t)> runTask);
 } // namespace detail
 
 // =====================================================================================================================
-// A parallel for loop implementation using a simple worker thread pool. Unlike `llvm::parallel*` algorithms, does not
-// depend on a global thread pool strategy.
+// A parallel for loop implementation using the global work-stealing thread pool. Unlike `llvm::parallel*` algorithms,
+// does not depend on a global thread pool strategy. The calling thread takes part in the loop, so `parallelFor` may be
+// nested, e.g. called from inside a `function` of another `parallelFor`.
 //
 // Applies the provided `function` to each input in `inputs`. This may happen parallel, depending on the number of
-// threads used. Stops as soon as it encounters an error.
+// threads used. When run in parallel, inputs are handed out in order of decreasing `priority`, so that giving the most
+// expensive inputs the highest priority keeps a long input from starting last and holding up the whole loop. Stops as
+// soon as it encounters an error.
 //
 // @param numThreads : Number of requested threads. Pass 0 to indicate that all available cores are preferred.
-//                     The implementation may spawn a different number of threads than requested to avoid unutilized
+//                     The implementation may use a different number of threads than requested to avoid unutilized
 //                     threads.
 // @param inputs : Random-access range with inputs that will be passed to `function`.
 // @param function : Function object that will be applied to each input. Must return `llvm::Error`.
+// @param priority : Function object that returns the priority hint (e.g. estimated cost) of an input as `uint64_t`.
 // @returns : `llvm::ErrorSuccess` on success, an error or combination on errors from `function` on failure.
-template <typename RangeT, typename FuncT> llvm::Error parallelFor(size_t numThreads, RangeT &&inputs, FuncT function) {
+template <typename RangeT, typename FuncT, typename PriorityFuncT>
+llvm::Error parallelFor(size_t numThreads, RangeT &&inputs, FuncT function, PriorityFuncT priority) {
   const auto inputsBegin = llvm::adl_begin(inputs);
   const auto inputsEnd = llvm::adl_end(inputs);
   const size_t numTasks = std::distance(inputsBegin, inputsEnd);
   const size_t numWorkers =
       detail::decideNumConcurrentThreads(numThreads, numTasks, std::thread::hardware_concurrency());
 
-  // No need to spawn any threads if the work requires only one worker. This makes stack traces nicer.
+  // Run in order on the calling thread if the work requires only one worker. This makes stack traces nicer.
   if (numWorkers == 1) {
     for (auto &&input : inputs)
       if (llvm::Error err = function(std::forward<decltype(input)>(input)))
@@ -93,32 +158,30 @@ template <typename RangeT, typename FuncT> llvm::Error parallelFor(size_t numThr
     return llvm::Error::success();
   }
 
-  llvm::Error firstErr = llvm::Error::success();
-  std::mutex failureMutex;
-
-  std::vector<std::thread> workers(numWorkers);
-  std::atomic<size_t> nextTaskIdx(0);
-
-  for (std::thread &worker : workers) {
-    worker = std::thread([&function, &firstErr, &failureMutex, &nextTaskIdx, numTasks, inputsBegin] {
-      for (size_t pos = ++nextTaskIdx; pos <= numTasks; pos = ++nextTaskIdx) {
-        const size_t idx = pos - 1;
-        auto inputIt = inputsBegin + idx;
-        if (llvm::Error err = function(*inputIt)) {
-          nextTaskIdx = numTasks + 1; // Make the other threads finish without picking up any remaining tasks.
-          std::lock_guard<std::mutex> lock(failureMutex);
-          firstErr = llvm::joinErrors(std::move(firstErr), std::move(err));
-          break;
-        }
-      }
-    });
-  }
+  std::vector<uint64_t> priorities;
+  priorities.reserve(numTasks);
+  for (auto inputIt = inputsBegin; inputIt != inputsEnd; ++inputIt)
+    priorities.push_back(priority(*inputIt));
 
-  // Wait for all workers to finish.
-  for (std::thread &worker : workers)
-    worker.join();
+  std::vector<size_t> taskOrder(numTasks);
+  std::iota(taskOrder.begin(), taskOrder.end(), 0);
+  std::stable_sort(taskOrder.begin(), taskOrder.end(),
+                   [&priorities](size_t lhs, size_t rhs) { return priorities[lhs] > priorities[rhs]; });
 
-  return firstErr;
+  return detail::runParallelTasks(numWorkers, taskOrder,
+                                  [&function, inputsBegin](size_t idx) { return function(*(inputsBegin + idx)); });
+}
+
+// =====================================================================================================================
+// A parallel for loop over inputs of equal priority; see above. Inputs are handed out in their order in `inputs`.
+//
+// @param numThreads : Number of requested threads. Pass 0 to indicate that all available cores are preferred.
+// @param inputs : Random-access range with inputs that will be passed to `function`.
+// @param function : Function object that will be applied to each input. Must return `llvm::Error`.
+// @returns : `llvm::ErrorSuccess` on success, an error or combination on errors from `function` on failure.
+template <typename RangeT, typename FuncT> llvm::Error parallelFor(size_t numThreads, RangeT &&inputs, FuncT function) {
+  using InputT = decltype(*llvm::adl_begin(inputs));
+  return parallelFor(numThreads, std::forward<RangeT>(inputs), std::move(function), [](InputT) { return uint64_t(0); });
 }
 
 } // namespace Llpc
@@ -31,12 +31,15 @@
 
 #include "llpcTimerProfiler.h"
 #include "llpc.h"
+#include "llpcDebug.h"
 #include "lgc/LgcContext.h"
 #include "lgc/PassManager.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -48,12 +51,33 @@ namespace cl {
 // -enable-time-profile : profile the compile time of pipeline
 opt<bool> EnableTimerProfile("enable-timer-profile", desc("profile the compile time of pipeline"), init(false));
 
+// -timer-profile-trace-file : write the compile time profile of all pipelines as a Chrome trace to the given file
+opt<std::string> TimerProfileTraceFile("timer-profile-trace-file",
+                                       desc("Write the compile phase and pass timings of all pipelines and shader "
+                                            "modules as a Chrome trace (JSON) to the given file"),
+                                       value_desc("filename"), init(""));
+
+extern opt<unsigned> SlowPipelineDumpThreshold;
+
 } // namespace cl
 
 } // namespace llvm
 
 namespace Llpc {
 
+// =====================================================================================================================
+// Checks whether compile-time trace events are recorded.
+static bool isTimeTraceEnabled() {
+  return !cl::TimerProfileTraceFile.empty();
+}
+
+// =====================================================================================================================
+// Checks whether the compile time is profiled, either for the text report, for the trace, or for the phase timings
+// of a pipeline dumped by -slow-pipeline-dump-threshold.
+static bool isTimerProfileEnabled() {
+  return TimePassesIsEnabled || cl::EnableTimerProfile || isTimeTraceEnabled() || cl::SlowPipelineDumpThreshold != 0;
+}
+
 // =====================================================================================================================
 //
 // @param hash64 : Hash code
@@ -61,12 +85,24 @@ namespace Llpc {
 // @param enableMask : Mask of enabled phase timers
 TimerProfiler::TimerProfiler(uint64_t hash64, const char *descriptionPrefix, unsigned enableMask)
     : m_total("", "", getDummyTimeRecords()), m_phases("", "", getDummyTimeRecords()) {
-  if (TimePassesIsEnabled || cl::EnableTimerProfile) {
+  m_startMallocUsage = m_peakMallocUsage = sys::Process::GetMallocUsage();
+  if (isTimerProfileEnabled()) {
     std::string hashString;
     raw_string_ostream ostream(hashString);
     ostream << format("0x%016" PRIX64, hash64);
     ostream.flush();
 
+    if (isTimeTraceEnabled()) {
+      // Each thread records into its own trace profiler, which is handed over to the trace when this profiler is
+      // destroyed. A trace profiler that is already active on this thread belongs to an enclosing TimerProfiler.
+      if (!timeTraceProfilerEnabled()) {
+        timeTraceProfilerInitialize(0, "llpc");
+        m_ownsTimeTrace = true;
+      }
+      m_hashString = hashString;
+      timeTraceProfilerBegin(descriptionPrefix, hashString);
+    }
+
     // Init whole timer
     m_total.setName("llpc", (Twine(descriptionPrefix) + Twine(" ") + hashString).str());
     m_wholeTimer.init("llpc-total", (Twine(descriptionPrefix) + Twine(" Total ") + hashString).str(), m_total);
@@ -107,10 +143,31 @@ TimerProfiler::TimerProfiler(uint64_t hash64, const char *descriptionPrefix, uns
 
 // =====================================================================================================================
 TimerProfiler::~TimerProfiler() {
-  if (TimePassesIsEnabled || cl::EnableTimerProfile) {
+  if (isTimerProfileEnabled()) {
     // Stop whole timer
     m_wholeTimer.stopTimer();
   }
+
+  if (isTimeTraceEnabled()) {
+    // Record the memory usage as an event of its own, as trace events only carry the details given at their start.
+    sampleMallocUsage();
+    timeTraceProfilerBegin("Memory", [this] {
+      return (Twine(m_hashString) + " peak-malloc-usage=" + Twine(m_peakMallocUsage) +
+              " peak-malloc-growth=" + Twine(m_peakMallocUsage - m_startMallocUsage))
+          .str();
+    });
+    timeTraceProfilerEnd();
+    timeTraceProfilerEnd();
+    if (m_ownsTimeTrace)
+      timeTraceProfilerFinishThread();
+  }
+
+  // Only the trace or the slow pipeline dump was requested, not the text report that the timer groups print when they
+  // are destroyed.
+  if (isTimerProfileEnabled() && !TimePassesIsEnabled && !cl::EnableTimerProfile) {
+    m_total.clear();
+    m_phases.clear();
+  }
 }
 
 // =====================================================================================================================
@@ -120,7 +177,7 @@ TimerProfiler::~TimerProfiler() {
 // @param timerKind : Kind of phase timer
 // @param start : Start or  stop timer
 void TimerProfiler::addTimerStartStopPass(lgc::LegacyPassManager *passMgr, TimerKind timerKind, bool start) {
-  if (TimePassesIsEnabled || cl::EnableTimerProfile)
+  if (isTimerProfileEnabled())
     passMgr->add(lgc::LgcContext::createStartStopTimer(&m_phaseTimers[timerKind], start));
 }
 
@@ -131,7 +188,7 @@ void TimerProfiler::addTimerStartStopPass(lgc::LegacyPassManager *passMgr, Timer
 // @param timerKind : Kind of phase timer
 // @param start : Start or  stop timer
 void TimerProfiler::addTimerStartStopPass(lgc::PassManager &passMgr, TimerKind timerKind, bool start) {
-  if (TimePassesIsEnabled || cl::EnableTimerProfile)
+  if (isTimerProfileEnabled())
     lgc::LgcContext::createAndAddStartStopTimer(passMgr, &m_phaseTimers[timerKind], start);
 }
 
@@ -141,12 +198,50 @@ void TimerProfiler::addTimerStartStopPass(lgc::PassManager &passMgr, TimerKind t
 // @param timerKind : Kind of phase timer
 // @param start : Start or  stop timer
 void TimerProfiler::startStopTimer(TimerKind timerKind, bool start) {
-  if (TimePassesIsEnabled || cl::EnableTimerProfile) {
+  sampleMallocUsage();
+  if (isTimerProfileEnabled()) {
     if (start)
       m_phaseTimers[timerKind].startTimer();
     else
       m_phaseTimers[timerKind].stopTimer();
   }
+
+  if (isTimeTraceEnabled() && m_phaseTimers[timerKind].isInitialized()) {
+    if (start)
+      timeTraceProfilerBegin(m_phaseTimers[timerKind].getName(), m_hashString);
+    else
+      timeTraceProfilerEnd();
+  }
+}
+
+// =====================================================================================================================
+// Updates the peak memory usage of this compile with the current usage. The usage is sampled at the start and end of
+// phases, so short-lived peaks inside a phase are not seen.
+void TimerProfiler::sampleMallocUsage() {
+  m_peakMallocUsage = std::max(m_peakMallocUsage, sys::Process::GetMallocUsage());
+}
+
+// =====================================================================================================================
+// Gets how much the heap usage has grown at its peak since this profiler was created, in bytes. The usage is that of
+// the whole process, so other compiles running at the same time are included.
+size_t TimerProfiler::getPeakMallocGrowth() {
+  sampleMallocUsage();
+  return m_peakMallocUsage - m_startMallocUsage;
+}
+
+// =====================================================================================================================
+// Writes the trace recorded by all threads to the file given by -timer-profile-trace-file, and discards it. This is
+// called when the last compiler instance is destroyed.
+void TimerProfiler::writeTimeTrace() {
+  if (!isTimeTraceEnabled())
+    return;
+
+  // The trace is written through the trace profiler of the calling thread.
+  if (!timeTraceProfilerEnabled())
+    timeTraceProfilerInitialize(0, "llpc");
+  if (Error err = timeTraceProfilerWrite(cl::TimerProfileTraceFile, cl::TimerProfileTraceFile))
+    LLPC_ERRS("Failed to write the timer profile trace: " << toString(std::move(err)) << "\n");
+  timeTraceProfilerCleanup();
 }
 
 // =====================================================================================================================
@@ -154,14 +249,29 @@ void TimerProfiler::startStopTimer(TimerKind timerKind, bool start) {
 //
 // @param timerKind : Kind of phase timer
 Timer *TimerProfiler::getTimer(TimerKind timerKind) {
-  return TimePassesIsEnabled || cl::EnableTimerProfile ? &m_phaseTimers[timerKind] : nullptr;
+  return isTimerProfileEnabled() ? &m_phaseTimers[timerKind] : nullptr;
+}
+
+// =====================================================================================================================
+// Gets the wall time of each phase that has been timed, as text such as " llpc-patch=1.234ms llpc-opt=5.678ms".
+std::string TimerProfiler::getPhaseTimes() const {
+  std::string phaseTimes;
+  raw_string_ostream ostream(phaseTimes);
+  for (const Timer &phaseTimer : m_phaseTimers) {
+    if (phaseTimer.isInitialized() && phaseTimer.hasTriggered()) {
+      ostream << " " << phaseTimer.getName() << "=" << format("%.3f", phaseTimer.getTotalTime().getWallTime() * 1000)
+              << "ms";
+    }
+  }
+  ostream.flush();
+  return phaseTimes;
 }
 
 // =====================================================================================================================
 // Gets dummy TimeRecords.
 const StringMap<TimeRecord> &TimerProfiler::getDummyTimeRecords() {
   static StringMap<TimeRecord> DummyTimeRecords;
-  if ((TimePassesIsEnabled || cl::EnableTimerProfile) && DummyTimeRecords.empty()) {
+  if (isTimerProfileEnabled() && DummyTimeRecords.empty()) {
     // NOTE: It is a workaround to get fixed layout in timer reports. Please remove it if we find a better solution.
     // LLVM timer skips the field if it is zero in all timers, it causes the layout of the report isn't stable when
     // compile multiple pipelines. so we add a dummy record to force all fields is shown.
@@ -72,8 +72,14 @@ public:
 
   llvm::Timer *getTimer(TimerKind timerKind);
 
+  std::string getPhaseTimes() const;
+
+  size_t getPeakMallocGrowth();
+
   static const llvm::StringMap<llvm::TimeRecord> &getDummyTimeRecords();
 
+  static void writeTimeTrace();
+
   static const unsigned PipelineTimerEnableMask = ((1 << TimerCount) - 1);
   static const unsigned ShaderModuleTimerEnableMask = ((1 << TimerTranslate) | (1 << TimerLower));
 
@@ -81,10 +87,16 @@ private:
   TimerProfiler(const TimerProfiler &) = delete;
   TimerProfiler &operator=(const TimerProfiler &) = delete;
 
+  void sampleMallocUsage();
+
   llvm::TimerGroup m_total;              // TimeGroup for total time
   llvm::TimerGroup m_phases;             // TimeGroup for each phase
   llvm::Timer m_wholeTimer;              // Whole timer
   llvm::Timer m_phaseTimers[TimerCount]; // Phase timer
+  std::string m_hashString;              // Hash code as text, the detail of trace events
+  size_t m_startMallocUsage = 0;         // Memory usage when this profiler was created
+  size_t m_peakMallocUsage = 0;          // Peak memory usage seen since this profiler was created
+  bool m_ownsTimeTrace = false;          // Whether this profiler started the trace profiler of its thread
 };
 
 } // namespace Llpc
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+
+"""
+amdllpc-remote.py -- Script to offload pipeline compiles to a remote amdllpc compile server.
+
+Starts an amdllpc compile server (amdllpc -server) with the given command, which may run it on another machine, e.g.
+through ssh, and compiles each input pipeline on it, writing the returned pipeline ELFs to the output directory. The
+inputs are uploaded to the server by the SHA-256 hash of their content, and only when the server does not have that
+content yet, so inputs shared by pipelines, such as the SPIR-V modules of shader inputs, are uploaded once per server.
+As the server keeps one warm compiler for all the pipelines, its shader cache is shared by them too.
+
+Each .pipe input is one pipeline. All the other inputs (.spv, .spvasm and GLSL shaders) are compiled together as one
+pipeline, in the same way as amdllpc does. A returned ELF is named after the first input file of its pipeline. The
+returned ELFs can be used to populate a local cache, e.g. with the pipeline ELF cache of the driver, in place of
+compiling the pipelines locally.
+
+Sample use:
+1. Compile the pipelines on a build machine, with the server options after the server command:
+  script/amdllpc-remote.py --server "ssh build-host /opt/llpc/amdllpc -server -gfxip=10.3" \
+    -o elfs llpc/test/shaderdb/general/*.pipe
+
+2. Compile the pipelines with a local server, e.g. to test the protocol:
+  script/amdllpc-remote.py --server "build/llpc/amdllpc -server -gfxip=10.3 -spvgen-dir=build/spvgen" \
+    -o elfs llpc/test/shaderdb/general/PipelineCs_TestFetch.pipe
+"""
+
+import hashlib
+import os
+import shlex
+import subprocess
+import sys
+from argparse import ArgumentParser
+
+def parse_input(arg):
+  """Splits an input file argument into the path and the optional entry point."""
+  path, sep, entry = arg.partition(',')
+  return path, sep + entry
+
+class RemoteServer:
+  """An amdllpc compile server, talking to it over the stdin and stdout of the server command."""
+
+  def __init__(self, command, verbose):
+    self.process = subprocess.Popen(shlex.split(command), stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    self.verbose = verbose
+    self.known = set()
+    self.uploaded = 0
+
+  def send(self, request, content=b''):
+    self.process.stdin.write(request.encode() + b'\n' + content)
+    self.process.stdin.flush()
+
+  def read_reply(self, prefix):
+    """Reads the output of the server up to the next line starting with the prefix, and returns that line. Other
+    lines are compiler output, which is written to stderr with --verbose."""
+    while True:
+      line = self.process.stdout.readline()
+      if not line:
+        raise RuntimeError('Compile server exited unexpectedly')
+      line = line.decode(errors='replace').rstrip('\n')
+      if line.startswith(prefix):
+        return line
+      if self.verbose:
+        print(line, file=sys.stderr)
+
+  def upload(self, path):
+    """Uploads the content of the file if the server does not have it yet, and returns its hash."""
+    with open(path, 'rb') as file:
+      content = file.read()
+    content_hash = hashlib.sha256(content).hexdigest()
+    if content_hash in self.known:
+      return content_hash
+    self.send(f'have {content_hash}')
+    if self.read_reply('AMDLLPC HAVE ').endswith(' no'):
+      extension = os.path.splitext(path)[1]
+      self.send(f'put {content_hash} {extension} {len(content)}', content)
+      reply = self.read_reply('AMDLLPC PUT ')
+      if not reply.endswith(' SUCCESS'):
+        raise RuntimeError(f'Failed to upload {path}')
+      self.uploaded += 1
+    self.known.add(content_hash)
+    return content_hash
+
+  def compile(self, inputs):
+    """Compiles a pipeline from the input file arguments, returning its ELF, or None if the compile failed."""
+    job = ['-return-elf']
+    for arg in inputs:
+      path, entry = parse_input(arg)
+      job.append(f'@{self.upload(path)}{entry}')
+    self.send(' '.join(job))
+    elf = None
+    while True:
+      line = self.read_reply('AMDLLPC ')
+      if line.startswith('AMDLLPC ELF '):
+        elf = self.process.stdout.read(int(line[len('AMDLLPC ELF '):]))
+      elif line == 'AMDLLPC JOB SUCCESS':
+        return elf
+      elif line == 'AMDLLPC JOB FAILED':
+        return None
+      elif self.verbose:
+        print(line, file=sys.stderr)
+
+  def close(self):
+    self.process.stdin.close()
+    for line in self.process.stdout:
+      if self.verbose:
+        sys.stderr.write(line.decode(errors='replace'))
+    return self.process.wait()
+
+def group_inputs(inputs):
+  # amdllpc compiles all .pipe inputs as separate pipelines, but takes all shader inputs as one pipeline.
+  groups = [[arg] for arg in inputs if parse_input(arg)[0].endswith('.pipe')]
+  shader_inputs = [arg for arg in inputs if not parse_input(arg)[0].endswith('.pipe')]
+  if shader_inputs:
+    groups.append(shader_inputs)
+  return groups
+
+def main():
+  parser = ArgumentParser(description='Offload pipeline compiles to a remote amdllpc compile server.')
+  parser.add_argument('--server', required=True,
+                      help='Command running the compile server, e.g. "ssh host amdllpc -server -gfxip=10.3"')
+  parser.add_argument('-o', '--output-dir', default='.', help='Directory to write the pipeline ELFs to')
+  parser.add_argument('-v', '--verbose', action='store_true', help='Write the output of the compiler to stderr')
+  parser.add_argument('inputs', nargs='+', help='Input files, in the same form as the inputs of amdllpc')
+  args = parser.parse_args()
+
+  os.makedirs(args.output_dir, exist_ok=True)
+  server = RemoteServer(args.server, args.verbose)
+  failed = 0
+  for group in group_inputs(args.inputs):
+    name = os.path.splitext(os.path.basename(parse_input(group[0])[0]))[0]
+    elf = server.compile(group)
+    if elf is None:
+      print(f'Failed to compile {name}', file=sys.stderr)
+      failed += 1
+      continue
+    with open(os.path.join(args.output_dir, name + '.elf'), 'wb') as file:
+      file.write(elf)
+  if server.close() != 0 and not failed:
+    failed = 1
+  print(f'Uploaded {server.uploaded} of {len(server.known)} unique input files', file=sys.stderr)
+  return 1 if failed else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+
+"""
+llpc-compile-benchmark.py -- Script to benchmark pipeline compile times of amdllpc over shaderdb inputs.
+
+Compiles the chosen .pipe and .spvasm inputs a number of times, with a cold (empty) and a warm (pre-populated)
+on-disk shader cache, and for each of the given -num-threads values. Reports the percentiles of the wall time of
+each iteration and of the per-phase compile times recorded by the LLPC timer profiler (-timer-profile-trace-file),
+the peak RSS of the amdllpc processes and the pipeline and shader stage cache hit rates (-print-cache-access), as
+JSON.
+
+All .pipe inputs are compiled by one amdllpc process per iteration, so -num-threads applies to them. Each .spvasm
+input is a pipeline of its own and is compiled by its own process. Inputs that fail to compile with the given
+options (e.g. shaderdb tests expecting an error, or needing options from their RUN lines) are skipped.
+
+With --baseline, the report is compared with that of an earlier run (a report written with -o), and the script exits
+with status 1 if the median of a compared time of any configuration is slower than in the baseline by more than
+--tolerance. The compared times are the wall time of each iteration and the total compile time of each pipeline. Only
+the configurations that both runs have are compared. The baseline should come from the same machine.
+
+Sample use:
+1. Benchmark all general shaderdb tests:
+  script/llpc-compile-benchmark.py --amdllpc build/llpc/amdllpc --gfxip 10.3 \
+    --spvgen-dir build/spvgen llpc/test/shaderdb/general -o general.json
+
+2. Compare thread counts, with more iterations and extra amdllpc options:
+  script/llpc-compile-benchmark.py --amdllpc build/llpc/amdllpc --gfxip 10.3 \
+    --iterations 10 --num-threads 1,4,0 --amdllpc-args="-enable-relocatable-shader-elf" \
+    llpc/test/shaderdb/relocatable_shaders/*.pipe
+
+3. Fail if compiles got more than 10% slower than in a stored baseline:
+  script/llpc-compile-benchmark.py --amdllpc build/llpc/amdllpc --gfxip 10.3 \
+    --spvgen-dir build/spvgen llpc/test/shaderdb/general --baseline general.json --tolerance 0.1
+"""
+
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from argparse import ArgumentParser
+
+input_extensions = ['.pipe', '.spvasm']
+
+# Names of the trace events of the LLPC compile phases (the names of the TimerProfiler phase timers), and of the
+# events covering the whole compile of a pipeline and of a shader module.
+phase_event_names = ['llpc-translate', 'llpc-lower', 'llpc-load', 'llpc-patch', 'llpc-opt', 'llpc-codegen']
+total_event_names = {'LLPC': 'pipeline-total', 'LLPC ShaderModule': 'shader-module-total'}
+
+cache_access_prefix = 'LLPC CacheAccess:'
+
+def collect_inputs(paths):
+  inputs = []
+  for path in paths:
+    if os.path.isdir(path):
+      for root, dirs, files in os.walk(path):
+        dirs.sort()
+        inputs += [os.path.join(root, name) for name in sorted(files)
+                   if os.path.splitext(name)[1] in input_extensions]
+    elif os.path.splitext(path)[1] in input_extensions:
+      inputs.append(path)
+    else:
+      print(f'Ignoring unsupported input: {path}', file=sys.stderr)
+  return inputs
+
+def group_inputs(inputs):
+  # amdllpc compiles all .pipe inputs as separate pipelines, but takes all shader inputs as one pipeline.
+  pipe_inputs = [path for path in inputs if path.endswith('.pipe')]
+  groups = [[path] for path in inputs if not path.endswith('.pipe')]
+  if pipe_inputs:
+    groups.insert(0, pipe_inputs)
+  return groups
+
+def run_amdllpc(args, inputs, extra_args, work_dir):
+  """Runs amdllpc on the inputs, returning its exit code, wall time in seconds, peak RSS in KiB, stdout and the
+  parsed timer profile trace."""
+  trace_file = os.path.join(work_dir, 'trace.json')
+  if os.path.exists(trace_file):
+    os.remove(trace_file)
+  command = [args.amdllpc, f'-gfxip={args.gfxip}', '-print-cache-access', f'-timer-profile-trace-file={trace_file}',
+             '-o', os.path.join(work_dir, 'out.elf')]
+  if args.spvgen_dir:
+    command.append(f'-spvgen-dir={args.spvgen_dir}')
+  command += args.amdllpc_args.split() + extra_args + inputs
+
+  with open(os.path.join(work_dir, 'stdout.txt'), 'w+') as stdout, \
+       open(os.path.join(work_dir, 'stderr.txt'), 'w+') as stderr:
+    start = time.perf_counter()
+    process = subprocess.Popen(command, stdout=stdout, stderr=stderr)
+    # Wait with wait4 to get the resource usage of this process alone.
+    _, status, usage = os.wait4(process.pid, 0)
+    wall_time = time.perf_counter() - start
+    process.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+    stdout.seek(0)
+    output = stdout.read()
+
+  trace = None
+  if process.returncode == 0 and os.path.exists(trace_file):
+    with open(trace_file) as file:
+      trace = json.load(file)
+  return process.returncode, wall_time, usage.ru_maxrss, output, trace
+
+def percentiles(values):
+  if not values:
+    return None
+  values = sorted(values)
+  def percentile(fraction):
+    # Nearest-rank percentile.
+    return values[min(len(values) - 1, max(0, int(fraction * len(values) + 0.5) - 1))]
+  return {'count': len(values), 'min': values[0], 'p50': percentile(0.5), 'p90': percentile(0.9),
+          'p99': percentile(0.99), 'max': values[-1], 'mean': sum(values) / len(values)}
+
+class ConfigurationResult:
+  def __init__(self, num_threads, cache):
+    self.num_threads = num_threads
+    self.cache = cache
+    self.wall_times_ms = []
+    self.peak_rss_kib = 0
+    self.phase_times_ms = {}
+    self.cache_accesses = {'pipeline': {}, 'stage': {}}
+    self.failures = 0
+
+  def add_run(self, wall_time, peak_rss, output, trace):
+    self.peak_rss_kib = max(self.peak_rss_kib, peak_rss)
+    for line in output.splitlines():
+      if not line.startswith(cache_access_prefix):
+        continue
+      results = line[len(cache_access_prefix):].split(' Files:')[0].split()
+      for result in results:
+        name, access = result.split('=')
+        counts = self.cache_accesses['pipeline' if name == 'pipeline' else 'stage']
+        counts[access] = counts.get(access, 0) + 1
+    if not trace:
+      return
+    for event in trace.get('traceEvents', []):
+      if event.get('ph') != 'X':
+        continue
+      name = total_event_names.get(event['name'], event['name'])
+      if name in phase_event_names or name in total_event_names.values():
+        # Trace times are in microseconds.
+        self.phase_times_ms.setdefault(name, []).append(event['dur'] / 1000.0)
+
+  def to_json(self):
+    cache = {}
+    for kind, counts in self.cache_accesses.items():
+      hits = counts.get('hit', 0) + counts.get('internal-hit', 0)
+      checked = hits + counts.get('miss', 0)
+      cache[kind] = dict(counts, hit_rate=(hits / checked if checked else None))
+    return {
+      'num_threads': self.num_threads,
+      'cache': self.cache,
+      'failed_runs': self.failures,
+      'iteration_wall_time_ms': percentiles(self.wall_times_ms),
+      'peak_rss_kib': self.peak_rss_kib,
+      'phase_time_ms': {name: percentiles(times) for name, times in sorted(self.phase_times_ms.items())},
+      'cache_accesses': cache,
+    }
+
+def compare_with_baseline(report, baseline, tolerance):
+  """Returns the messages describing the times of the report that are slower than in the baseline by more than the
+  given fraction."""
+  if sorted(report['inputs']) != sorted(baseline.get('inputs', [])):
+    print('Warning: the inputs differ from those of the baseline', file=sys.stderr)
+  baseline_configurations = {(configuration['num_threads'], configuration['cache']): configuration
+                             for configuration in baseline.get('configurations', [])}
+  regressions = []
+  for configuration in report['configurations']:
+    num_threads, cache = configuration['num_threads'], configuration['cache']
+    baseline_configuration = baseline_configurations.get((num_threads, cache))
+    if not baseline_configuration:
+      print(f'Warning: no baseline for -num-threads={num_threads} with a {cache} shader cache', file=sys.stderr)
+      continue
+    compared = [('iteration wall time', configuration['iteration_wall_time_ms'],
+                 baseline_configuration['iteration_wall_time_ms']),
+                ('pipeline compile time', configuration['phase_time_ms'].get('pipeline-total'),
+                 baseline_configuration['phase_time_ms'].get('pipeline-total'))]
+    for name, times, baseline_times in compared:
+      if not times or not baseline_times or baseline_times['p50'] <= 0:
+        continue
+      median, baseline_median = times['p50'], baseline_times['p50']
+      change = median / baseline_median - 1
+      message = (f'-num-threads={num_threads}, {cache} cache: median {name} {median:.2f} ms, '
+                 f'baseline {baseline_median:.2f} ms ({change * 100:+.1f}%)')
+      print(message, file=sys.stderr)
+      if change > tolerance:
+        regressions.append(message)
+  return regressions
+
+def find_compilable_groups(args, groups, work_dir):
+  compilable = []
+  for group in groups:
+    # Probe the inputs of the group one by one, so that one failing .pipe input does not drop the others.
+    probes = [[path] for path in group] if group[0].endswith('.pipe') else [group]
+    passing = []
+    for probe in probes:
+      returncode, _, _, _, _ = run_amdllpc(args, probe, [], work_dir)
+      if returncode == 0:
+        passing += probe
+      else:
+        print(f'Skipping input that fails to compile: {" ".join(probe)}', file=sys.stderr)
+    if passing:
+      compilable.append(passing)
+  return compilable
+
+def run_configuration(args, groups, num_threads, cache, work_dir):
+  result = ConfigurationResult(num_threads, cache)
+  cache_dir = os.path.join(work_dir, 'cache')
+  thread_args = [f'-num-threads={num_threads}']
+
+  if cache == 'warm':
+    # Populate the on-disk cache once, then only read it in the measured runs.
+    shutil.rmtree(cache_dir, ignore_errors=True)
+    os.makedirs(cache_dir)
+    for group in groups:
+      run_amdllpc(args, group, thread_args + ['-shader-cache-mode=2', f'-shader-cache-file-dir={cache_dir}'], work_dir)
+    cache_args = ['-shader-cache-mode=4', f'-shader-cache-file-dir={cache_dir}']
+
+  for iteration in range(args.iterations):
+    if cache == 'cold':
+      shutil.rmtree(cache_dir, ignore_errors=True)
+      os.makedirs(cache_dir)
+      cache_args = ['-shader-cache-mode=2', f'-shader-cache-file-dir={cache_dir}']
+
+    iteration_time = 0.0
+    for group in groups:
+      returncode, wall_time, peak_rss, output, trace = run_amdllpc(args, group, thread_args + cache_args, work_dir)
+      if returncode != 0:
+        result.failures += 1
+        continue
+      iteration_time += wall_time
+      result.add_run(wall_time, peak_rss, output, trace)
+    result.wall_times_ms.append(iteration_time * 1000.0)
+  return result
+
+def main():
+  parser = ArgumentParser()
+  parser.add_argument('inputs', nargs='+', help='Input .pipe/.spvasm files, or directories to search for them')
+  parser.add_argument('--amdllpc', default='amdllpc', help='Path to the amdllpc executable')
+  parser.add_argument('--gfxip', default='10.3', help='Graphics IP version to compile for')
+  parser.add_argument('--spvgen-dir', type=str, help='Directory to load the SPVGEN library from')
+  parser.add_argument('--iterations', type=int, default=5, help='Number of times to compile the inputs')
+  parser.add_argument('--num-threads', type=str, default='1',
+                      help='Comma-separated list of -num-threads values to benchmark (0: all logical CPUs)')
+  parser.add_argument('--cache', type=str, default='cold,warm',
+                      help='Comma-separated list of shader cache states to benchmark: cold, warm')
+  parser.add_argument('--amdllpc-args', type=str, default='', help='Extra options to pass to amdllpc')
+  parser.add_argument('-o', '--output', type=str, help='Output JSON file path (default: stdout)')
+  parser.add_argument('--baseline', type=str, help='JSON report of an earlier run to check for regressions against')
+  parser.add_argument('--tolerance', type=float, default=0.1,
+                      help='Fraction by which a median time may exceed that of the baseline (default: 0.1)')
+  args = parser.parse_args()
+
+  baseline = None
+  if args.baseline:
+    with open(args.baseline) as file:
+      baseline = json.load(file)
+
+  caches = args.cache.split(',')
+  for cache in caches:
+    if cache not in ['cold', 'warm']:
+      print(f'Unknown shader cache state: {cache}', file=sys.stderr)
+      exit(2)
+
+  inputs = collect_inputs(args.inputs)
+  if not inputs:
+    print('No inputs to benchmark', file=sys.stderr)
+    exit(2)
+
+  work_dir = tempfile.mkdtemp()
+  try:
+    groups = find_compilable_groups(args, group_inputs(inputs), work_dir)
+    configurations = []
+    for num_threads in [int(value) for value in args.num_threads.split(',')]:
+      for cache in caches:
+        print(f'Benchmarking -num-threads={num_threads} with a {cache} shader cache', file=sys.stderr)
+        configurations.append(run_configuration(args, groups, num_threads, cache, work_dir).to_json())
+  finally:
+    shutil.rmtree(work_dir)
+
+  report = {
+    'amdllpc': args.amdllpc,
+    'gfxip': args.gfxip,
+    'amdllpc_args': args.amdllpc_args,
+    'iterations': args.iterations,
+    'inputs': [path for group in groups for path in group],
+    'configurations': configurations,
+  }
+  if args.output:
+    with open(args.output, 'w') as file:
+      json.dump(report, file, indent=2)
+      file.write('\n')
+  else:
+    json.dump(report, sys.stdout, indent=2)
+    print()
+
+  if baseline:
+    regressions = compare_with_baseline(report, baseline, args.tolerance)
+    if regressions:
+      print(f'Compile time regressions of more than {args.tolerance * 100:.0f}%:', file=sys.stderr)
+      for regression in regressions:
+        print(f'  {regression}', file=sys.stderr)
+      exit(1)
+
+if __name__ == '__main__':
+  main()
@@ -34,9 +34,15 @@
 #include "vkgcElfReader.h"
 #include "vkgcPipelineDumper.h"
 #include "vkgcUtil.h"
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <sys/stat.h>
+#include <thread>
 #include <unordered_set>
 
 #define DEBUG_TYPE "vkgc-pipeline-dumper"
@@ -61,8 +67,10 @@ std::ostream &operator<<(std::ostream &out, ResourceMappingNodeType type);
 std::ostream &operator<<(std::ostream &out, NggSubgroupSizingType subgroupSizing);
 std::ostream &operator<<(std::ostream &out, NggCompactMode compactMode);
 std::ostream &operator<<(std::ostream &out, DenormalMode denormalMode);
+std::ostream &operator<<(std::ostream &out, MathPrecision mathPrecision);
 std::ostream &operator<<(std::ostream &out, WaveBreakSize waveBreakSize);
 std::ostream &operator<<(std::ostream &out, ShadowDescriptorTableUsage shadowDescriptorTableUsage);
+std::ostream &operator<<(std::ostream &out, WaveSizeHeuristic waveSizeHeuristic);
 
 template std::ostream &operator<<(std::ostream &out, ElfReader<Elf64> &reader);
 template raw_ostream &operator<<(raw_ostream &out, ElfReader<Elf64> &reader);
@@ -86,16 +94,112 @@ private:
 // Mutex for pipeline dump
 static Mutex SDumpMutex;
 
+// Maximum number of bytes of dump files queued for the dump writer; a dump that would go over it is dropped
+static constexpr size_t MaxQueuedDumpBytes = 64 * 1024 * 1024;
+
+// =====================================================================================================================
+// Writes the pipeline dump files on a background thread, so that the compile does not wait for the file system. The
+// writes are done in the order they are queued. The memory held by the queued writes is bounded by
+// MaxQueuedDumpBytes; a write that does not fit is dropped rather than making the compile wait. The writes still
+// queued when the process exits are done before it does.
+class DumpWriter {
+public:
+  ~DumpWriter();
+
+  static DumpWriter &get();
+
+  bool queue(size_t size, std::function<void()> write);
+
+private:
+  DumpWriter() = default;
+
+  void run();
+
+  std::mutex m_mutex;                                            // Mutex for the members below
+  std::condition_variable m_condition;                           // Signalled when a write is queued, or on stopping
+  std::deque<std::pair<size_t, std::function<void()>>> m_writes; // Queued writes, with the bytes each holds
+  size_t m_queuedBytes = 0;                                      // Bytes held by the queued writes
+  bool m_stopping = false;                                       // Whether the writer thread is to stop
+  std::thread m_thread;                                          // Writer thread, started by the first write
+};
+
+// =====================================================================================================================
+// Finishes the queued writes and stops the writer thread.
+DumpWriter::~DumpWriter() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_condition.notify_one();
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
 // =====================================================================================================================
-// Represents the file objects for pipeline dump
+// Gets the dump writer of the process.
+DumpWriter &DumpWriter::get() {
+  static DumpWriter Writer;
+  return Writer;
+}
+
+// =====================================================================================================================
+// Queues a write for the writer thread.
+//
+// @param size : Number of bytes that the write holds until it is done
+// @param write : Function that does the write
+// @returns : False if the write was dropped, as it would go over the bound of the queued bytes
+bool DumpWriter::queue(size_t size, std::function<void()> write) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queuedBytes + size > MaxQueuedDumpBytes && !m_writes.empty())
+      return false;
+    m_queuedBytes += size;
+    m_writes.emplace_back(size, std::move(write));
+    if (!m_thread.joinable())
+      m_thread = std::thread([this] { run(); });
+  }
+  m_condition.notify_one();
+  return true;
+}
+
+// =====================================================================================================================
+// Does the queued writes, until stopping with no writes left.
+void DumpWriter::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_condition.wait(lock, [this] { return m_stopping || !m_writes.empty(); });
+    if (m_writes.empty())
+      return;
+    auto write = std::move(m_writes.front());
+    m_writes.pop_front();
+    lock.unlock();
+    write.second();
+    lock.lock();
+    m_queuedBytes -= write.first;
+  }
+}
+
+// =====================================================================================================================
+// Represents a pipeline dump being collected during a compile. Nothing is written until the dump ends, when the dump
+// writer is given the whole of it; so the .pipe text is kept here, along with each pipeline binary, whose disassembly
+// goes into the .pipe file where the binary was dumped.
 struct PipelineDumpFile {
-  PipelineDumpFile(const char *dumpFileName, const char *binaryFileName)
-      : dumpFile(dumpFileName), binaryIndex(0), binaryFileName(binaryFileName) {}
+  PipelineDumpFile(const char *dumpDir, const std::string &fileName, bool dumpDuplicates)
+      : dumpDir(dumpDir), fileName(fileName), dumpDuplicates(dumpDuplicates) {}
+
+  // Text of the .pipe file up to a pipeline binary, and the binary
+  struct Segment {
+    std::string text;   // Text of the .pipe file before the disassembly of the binary
+    std::string binary; // Pipeline binary (ELF)
+    GfxIpVersion gfxIp; // Graphics IP version of the binary
+  };
 
-  std::ofstream dumpFile;     // File object for .pipe file
-  std::ofstream binaryFile;   // File object for ELF binary
-  unsigned binaryIndex;       // ELF Binary index
-  std::string binaryFileName; // File name of binary file
+  std::ostringstream dumpFile;   // Text of the .pipe file since the last pipeline binary
+  std::vector<Segment> segments; // Text of the .pipe file and the pipeline binaries before that
+  std::string infoBinary;        // Pipeline info binary (.pipebin) of the build info, if it is dumped
+  std::string dumpDir;           // Directory of pipeline dump
+  std::string fileName;          // File name of the dump, without the index of a duplicate or the extension
+  bool dumpDuplicates;           // Whether a duplicate pipeline is dumped with an index added to its file name
 };
 
 // =====================================================================================================================
@@ -305,8 +409,6 @@ PipelineDumpFile *PipelineDumper::BeginPipelineDump(const PipelineDumpOptions *d
                                                     PipelineBuildInfo pipelineInfo, const uint64_t hash64) {
   bool disableLog = false;
   std::string dumpFileName;
-  std::string dumpPathName;
-  std::string dumpBinaryName;
   PipelineDumpFile *dumpFile = nullptr;
 
   // Filter pipeline hash
@@ -338,54 +440,18 @@ PipelineDumpFile *PipelineDumper::BeginPipelineDump(const PipelineDumpOptions *d
 
   if (!disableLog) {
     bool enableDump = true;
-    SDumpMutex.lock();
-
-    // Create the dump directory
-    createDirectory(dumpOptions->pDumpDir);
-
-    // Build dump file name
-    if (dumpOptions->dumpDuplicatePipelines) {
-      unsigned index = 0;
-      int result = 0;
-      while (result != -1) {
-        dumpPathName = dumpOptions->pDumpDir;
-        dumpPathName += "/";
-        dumpPathName += dumpFileName;
-        if (index > 0) {
-          dumpPathName += "-[";
-          dumpPathName += std::to_string(index);
-          dumpPathName += "]";
-        }
-        dumpBinaryName = dumpPathName + ".elf";
-        dumpPathName += ".pipe";
-        struct FILE_STAT fileStatus = {};
-        result = FILE_STAT(dumpPathName.c_str(), &fileStatus);
-        ++index;
-      };
-    } else {
-      static std::unordered_set<std::string> FileNames;
-
-      if (FileNames.find(dumpFileName) == FileNames.end()) {
-        dumpPathName = dumpOptions->pDumpDir;
-        dumpPathName += "/";
-        dumpPathName += dumpFileName;
-        dumpBinaryName = dumpPathName + ".elf";
-        dumpPathName += ".pipe";
-        FileNames.insert(dumpFileName);
-      } else
-        enableDump = false;
-    }
 
-    // Open dump file
-    if (enableDump) {
-      dumpFile = new PipelineDumpFile(dumpPathName.c_str(), dumpBinaryName.c_str());
-      if (dumpFile->dumpFile.bad()) {
-        delete dumpFile;
-        dumpFile = nullptr;
-      }
+    // A pipeline already dumped is skipped, unless duplicates are dumped. The dump writer finds the file name for a
+    // duplicate, and creates the dump directory.
+    if (!dumpOptions->dumpDuplicatePipelines) {
+      static std::unordered_set<std::string> FileNames;
+      SDumpMutex.lock();
+      enableDump = FileNames.insert(dumpFileName).second;
+      SDumpMutex.unlock();
     }
 
-    SDumpMutex.unlock();
+    if (enableDump)
+      dumpFile = new PipelineDumpFile(dumpOptions->pDumpDir, dumpFileName, dumpOptions->dumpDuplicatePipelines);
 
     // Dump pipeline input info
     if (dumpFile) {
@@ -395,6 +461,9 @@ PipelineDumpFile *PipelineDumper::BeginPipelineDump(const PipelineDumpOptions *d
       if (pipelineInfo.pGraphicsInfo)
         dumpGraphicsPipelineInfo(&dumpFile->dumpFile, dumpOptions->pDumpDir, pipelineInfo.pGraphicsInfo);
 
+      // A build info whose shader modules have no SPIR-V binary has no pipeline info binary.
+      if (dumpOptions->dumpPipelineInfoBinary && !encodePipelineInfoBinary(pipelineInfo, dumpFile->infoBinary))
+        dumpFile->infoBinary.clear();
     }
   }
 
@@ -406,7 +475,17 @@ PipelineDumpFile *PipelineDumper::BeginPipelineDump(const PipelineDumpOptions *d
 //
 // @param dumpFile : Dump file
 void PipelineDumper::EndPipelineDump(PipelineDumpFile *dumpFile) {
-  delete dumpFile;
+  if (!dumpFile)
+    return;
+
+  // Give the dump to the dump writer, or drop it if too many bytes of dumps are queued. The std::function the dump
+  // writer takes has to be copyable, so the dump is shared with it.
+  size_t size = dumpFile->dumpFile.tellp();
+  size += dumpFile->infoBinary.size();
+  for (const PipelineDumpFile::Segment &segment : dumpFile->segments)
+    size += segment.text.size() + segment.binary.size();
+  std::shared_ptr<PipelineDumpFile> dump(dumpFile);
+  DumpWriter::get().queue(size, [dump] { writePipelineDump(&*dump); });
 }
 
 // =====================================================================================================================
@@ -536,6 +615,7 @@ void PipelineDumper::dumpPipelineShaderInfo(const PipelineShaderInfo *shaderInfo
   dumpFile << "options.disableLicmThreshold = " << shaderInfo->options.disableLicmThreshold << "\n";
   dumpFile << "options.unrollHintThreshold = " << shaderInfo->options.unrollHintThreshold << "\n";
   dumpFile << "options.dontUnrollHintThreshold = " << shaderInfo->options.dontUnrollHintThreshold << "\n";
+  dumpFile << "options.mathPrecision = " << shaderInfo->options.mathPrecision << "\n";
   dumpFile << "\n";
 }
 
@@ -591,17 +671,19 @@ void PipelineDumper::dumpResourceMappingInfo(const ResourceMappingData* resource
 // @param spirvBin : SPIR-V binary
 // @param hash : Pipeline hash code
 void PipelineDumper::DumpSpirvBinary(const char *dumpDir, const BinaryData *spirvBin, MetroHash::Hash *hash) {
-  std::string pathName = dumpDir;
-  pathName += "/";
-  pathName += getSpirvBinaryFileName(hash);
-
-  // Make sure directory exists
-  createDirectory(dumpDir);
-
-  // Open dumpfile
-  std::ofstream dumpFile(pathName.c_str(), std::ios_base::binary | std::ios_base::out);
-  if (!dumpFile.bad())
-    dumpFile.write(reinterpret_cast<const char *>(spirvBin->pCode), spirvBin->codeSize);
+  std::string directory = dumpDir;
+  std::string pathName = directory + "/" + getSpirvBinaryFileName(hash);
+  std::string spirv(static_cast<const char *>(spirvBin->pCode), spirvBin->codeSize);
+
+  DumpWriter::get().queue(spirv.size(), [directory, pathName, spirv] {
+    // Make sure directory exists
+    createDirectory(directory.c_str());
+
+    // Open dumpfile
+    std::ofstream dumpFile(pathName.c_str(), std::ios_base::binary | std::ios_base::out);
+    if (!dumpFile.bad())
+      dumpFile.write(spirv.data(), spirv.size());
+  });
 }
 
 // =====================================================================================================================
@@ -617,27 +699,83 @@ void PipelineDumper::DumpPipelineBinary(PipelineDumpFile *dumpFile, GfxIpVersion
   if (!pipelineBin->pCode || pipelineBin->codeSize == 0)
     return;
 
-  ElfReader<Elf64> reader(gfxIp);
-  size_t codeSize = pipelineBin->codeSize;
-  auto result = reader.ReadFromBuffer(pipelineBin->pCode, &codeSize);
-  assert(result == Result::Success);
-  (void(result)); // unused
+  // The binary is disassembled into the .pipe file by the dump writer.
+  PipelineDumpFile::Segment segment;
+  segment.text = dumpFile->dumpFile.str();
+  segment.binary.assign(static_cast<const char *>(pipelineBin->pCode), pipelineBin->codeSize);
+  segment.gfxIp = gfxIp;
+  dumpFile->segments.push_back(std::move(segment));
+  dumpFile->dumpFile.str("");
+}
 
-  dumpFile->dumpFile << "\n[CompileLog]\n";
-  dumpFile->dumpFile << reader;
+// =====================================================================================================================
+// Writes the files of a pipeline dump. This is run by the dump writer, as is the search for a free file name for a
+// duplicate pipeline, so that it sees the files of the dumps queued before.
+//
+// @param dumpFile : Pipeline dump
+void PipelineDumper::writePipelineDump(PipelineDumpFile *dumpFile) {
+  createDirectory(dumpFile->dumpDir.c_str());
 
-  std::string binaryFileName = dumpFile->binaryFileName;
-  if (dumpFile->binaryIndex > 0) {
-    char suffixBuffer[32] = {};
-    snprintf(suffixBuffer, sizeof(suffixBuffer), ".%u", dumpFile->binaryIndex);
-    binaryFileName += suffixBuffer;
+  // Build dump file name
+  std::string dumpPathName;
+  std::string dumpBinaryName;
+  std::string dumpInfoBinaryName;
+  unsigned index = 0;
+  int result = 0;
+  while (result != -1) {
+    dumpPathName = dumpFile->dumpDir;
+    dumpPathName += "/";
+    dumpPathName += dumpFile->fileName;
+    if (index > 0) {
+      dumpPathName += "-[";
+      dumpPathName += std::to_string(index);
+      dumpPathName += "]";
+    }
+    dumpBinaryName = dumpPathName + ".elf";
+    dumpInfoBinaryName = dumpPathName + ".pipebin";
+    dumpPathName += ".pipe";
+    if (!dumpFile->dumpDuplicates)
+      break;
+    struct FILE_STAT fileStatus = {};
+    result = FILE_STAT(dumpPathName.c_str(), &fileStatus);
+    ++index;
   }
 
-  dumpFile->binaryIndex++;
-  dumpFile->binaryFile.open(binaryFileName.c_str(), std::ostream::out | std::ostream::binary);
-  if (!dumpFile->binaryFile.bad()) {
-    dumpFile->binaryFile.write(reinterpret_cast<const char *>(pipelineBin->pCode), pipelineBin->codeSize);
-    dumpFile->binaryFile.close();
+  std::ofstream pipeFile(dumpPathName.c_str());
+  if (pipeFile.bad())
+    return;
+
+  unsigned binaryIndex = 0;
+  for (const PipelineDumpFile::Segment &segment : dumpFile->segments) {
+    pipeFile << segment.text;
+
+    ElfReader<Elf64> reader(segment.gfxIp);
+    size_t codeSize = segment.binary.size();
+    auto result = reader.ReadFromBuffer(segment.binary.data(), &codeSize);
+    assert(result == Result::Success);
+    (void(result)); // unused
+
+    pipeFile << "\n[CompileLog]\n";
+    pipeFile << reader;
+
+    std::string binaryFileName = dumpBinaryName;
+    if (binaryIndex > 0) {
+      char suffixBuffer[32] = {};
+      snprintf(suffixBuffer, sizeof(suffixBuffer), ".%u", binaryIndex);
+      binaryFileName += suffixBuffer;
+    }
+
+    binaryIndex++;
+    std::ofstream binaryFile(binaryFileName.c_str(), std::ostream::out | std::ostream::binary);
+    if (!binaryFile.bad())
+      binaryFile.write(segment.binary.data(), segment.binary.size());
+  }
+  pipeFile << dumpFile->dumpFile.str();
+
+  if (!dumpFile->infoBinary.empty()) {
+    std::ofstream infoBinaryFile(dumpInfoBinaryName.c_str(), std::ostream::out | std::ostream::binary);
+    if (!infoBinaryFile.bad())
+      infoBinaryFile.write(dumpFile->infoBinary.data(), dumpFile->infoBinary.size());
   }
 }
 
@@ -651,6 +789,487 @@ void PipelineDumper::DumpPipelineExtraInfo(PipelineDumpFile *dumpFile, const std
     dumpFile->dumpFile << *str;
 }
 
+// Magic number at the start of a pipeline info binary ("LPIB")
+static constexpr uint32_t PipelineInfoBinaryMagic = 0x4249504C;
+
+// Version of the encoding of a pipeline info binary. Bump it on any change to the encoding.
+static constexpr uint32_t PipelineInfoBinaryFormatVersion = 1;
+
+// Alignment of the data in a pipeline info binary, which suits all the structures in it
+static constexpr size_t PipelineInfoBinaryAlignment = 8;
+
+// =====================================================================================================================
+// Header at the start of a pipeline info binary.
+//
+// The build info structure follows the header in its in-memory layout, with each pointer in it replaced by the offset
+// from the start of the binary of what it points to (0 for a null pointer), and the same for the structures that it
+// points to. So decoding is just a bounds-checked relocation of the pointers in place, with no parsing, and a binary
+// read (or privately mapped) into memory can be used as it is once decoded. As the layout of the structures is that of
+// the compiler that built the dumper, a binary is only accepted by a build with the same Vkgc::Version and size of the
+// build info structure; the .pipe text file remains the portable form of the dump.
+struct PipelineInfoBinaryHeader {
+  uint32_t magic;            // PipelineInfoBinaryMagic
+  uint32_t formatVersion;    // PipelineInfoBinaryFormatVersion
+  uint32_t interfaceVersion; // Vkgc::Version of the build info
+  uint32_t buildInfoSize;    // Size of the build info structure
+  uint32_t isGraphics;       // Whether the build info is a GraphicsPipelineBuildInfo, rather than compute
+  uint32_t stageCount;       // Number of shader stages
+  uint64_t dataSize;         // Size of the whole binary
+  uint64_t buildInfoOffset;  // Offset of the build info structure
+  struct {
+    uint32_t stage;      // Shader stage
+    uint32_t codeSize;   // Size of the SPIR-V binary
+    uint64_t codeOffset; // Offset of the SPIR-V binary
+  } stages[ShaderStageCount]; // Shader stages
+};
+
+// =====================================================================================================================
+// Gets the encoded form of a pointer to data at the given offset of a pipeline info binary.
+//
+// @param offset : Offset of the data, or 0 for none
+template <class T> static T *offsetToPointer(uint64_t offset) {
+  return reinterpret_cast<T *>(static_cast<uintptr_t>(offset));
+}
+
+// =====================================================================================================================
+// Builds a pipeline info binary, appending the structures and arrays that the build info points to.
+class PipelineInfoBinaryWriter {
+public:
+  PipelineInfoBinaryWriter() : m_data(sizeof(PipelineInfoBinaryHeader), '\0') {}
+
+  // Appends data, returning its offset, or 0 if there is no data.
+  //
+  // @param data : Data to append
+  // @param size : Size of the data in bytes
+  uint64_t append(const void *data, size_t size) {
+    if (!data || size == 0)
+      return 0;
+    m_data.resize(alignTo(m_data.size(), PipelineInfoBinaryAlignment), '\0');
+    uint64_t offset = m_data.size();
+    m_data.append(static_cast<const char *>(data), size);
+    return offset;
+  }
+
+  // Appends an array, returning its offset, or 0 if it is empty.
+  //
+  // @param data : Array to append
+  // @param count : Number of elements of the array
+  template <class T> uint64_t appendArray(const T *data, size_t count) { return append(data, sizeof(T) * count); }
+
+  // Gets the binary, with the header at its start.
+  //
+  // @param header : Header of the binary
+  std::string &finish(PipelineInfoBinaryHeader &header) {
+    m_data.resize(alignTo(m_data.size(), PipelineInfoBinaryAlignment), '\0');
+    header.dataSize = m_data.size();
+    memcpy(&m_data[0], &header, sizeof(header));
+    return m_data;
+  }
+
+private:
+  std::string m_data; // The binary so far
+};
+
+// =====================================================================================================================
+// Relocates the pointers of a pipeline info binary in place, checking that each points to data inside the binary.
+class PipelineInfoBinaryReader {
+public:
+  PipelineInfoBinaryReader(void *data, size_t dataSize) : m_data(static_cast<char *>(data)), m_dataSize(dataSize) {}
+
+  // Relocates an encoded pointer to an array, returning false if the array is not inside the binary.
+  //
+  // @param [in/out] pointer : Pointer to relocate
+  // @param count : Number of elements of the array
+  template <class T> bool relocate(T *&pointer, size_t count) {
+    const void *data = pointer;
+    if (!relocateBytes(data, sizeof(T) * count, alignof(T)))
+      return false;
+    pointer = static_cast<T *>(const_cast<void *>(data));
+    return true;
+  }
+
+  // Relocates an encoded pointer to data, returning false if the data is not inside the binary.
+  //
+  // @param [in/out] pointer : Pointer to relocate
+  // @param size : Size of the data in bytes
+  // @param align : Alignment that the data needs
+  bool relocateBytes(const void *&pointer, size_t size, size_t align = 1) {
+    uint64_t offset = reinterpret_cast<uintptr_t>(pointer);
+    if (offset == 0)
+      return true;
+    if (offset % align != 0 || offset >= m_dataSize || size > m_dataSize - offset)
+      return false;
+    pointer = m_data + offset;
+    return true;
+  }
+
+  // Relocates an encoded pointer to a string, returning false if the string is not inside the binary.
+  //
+  // @param [in/out] str : Pointer to relocate
+  bool relocateString(const char *&str) {
+    if (!relocate(str, 1))
+      return false;
+    return !str || memchr(str, '\0', m_data + m_dataSize - str);
+  }
+
+private:
+  char *m_data;      // Start of the binary
+  size_t m_dataSize; // Size of the binary
+};
+
+// =====================================================================================================================
+// Appends resource mapping nodes, and the tables that they point to, to a pipeline info binary.
+//
+// @param writer : Writer of the binary
+// @param nodes : Resource mapping nodes
+// @param nodeCount : Number of the nodes
+// @returns : Offset of the nodes
+static uint64_t encodeResourceMappingNodes(PipelineInfoBinaryWriter &writer, const ResourceMappingNode *nodes,
+                                           unsigned nodeCount) {
+  std::vector<ResourceMappingNode> encodedNodes(nodes, nodes + nodeCount);
+  for (ResourceMappingNode &node : encodedNodes) {
+    if (node.type == ResourceMappingNodeType::DescriptorTableVaPtr) {
+      node.tablePtr.pNext = offsetToPointer<const ResourceMappingNode>(
+          encodeResourceMappingNodes(writer, node.tablePtr.pNext, node.tablePtr.nodeCount));
+    }
+  }
+  return writer.appendArray(encodedNodes.data(), encodedNodes.size());
+}
+
+// =====================================================================================================================
+// Appends resource mapping data to a pipeline info binary, and encodes the pointers in it.
+//
+// @param writer : Writer of the binary
+// @param [in/out] resourceMapping : Resource mapping data, whose pointers are replaced by offsets
+static void encodeResourceMapping(PipelineInfoBinaryWriter &writer, ResourceMappingData &resourceMapping) {
+  std::vector<ResourceMappingRootNode> rootNodes(resourceMapping.pUserDataNodes,
+                                                 resourceMapping.pUserDataNodes + resourceMapping.userDataNodeCount);
+  for (ResourceMappingRootNode &rootNode : rootNodes) {
+    if (rootNode.node.type == ResourceMappingNodeType::DescriptorTableVaPtr) {
+      rootNode.node.tablePtr.pNext = offsetToPointer<const ResourceMappingNode>(
+          encodeResourceMappingNodes(writer, rootNode.node.tablePtr.pNext, rootNode.node.tablePtr.nodeCount));
+    }
+  }
+  resourceMapping.pUserDataNodes =
+      offsetToPointer<const ResourceMappingRootNode>(writer.appendArray(rootNodes.data(), rootNodes.size()));
+
+  std::vector<StaticDescriptorValue> staticValues(resourceMapping.pStaticDescriptorValues,
+                                                  resourceMapping.pStaticDescriptorValues +
+                                                      resourceMapping.staticDescriptorValueCount);
+  for (StaticDescriptorValue &staticValue : staticValues) {
+    const unsigned descriptorSize =
+        16 + (staticValue.type != ResourceMappingNodeType::DescriptorYCbCrSampler
+                  ? 0
+                  : sizeof(SamplerYCbCrConversionMetaData));
+    staticValue.pValue =
+        offsetToPointer<const unsigned>(writer.append(staticValue.pValue, staticValue.arraySize * descriptorSize));
+  }
+  resourceMapping.pStaticDescriptorValues =
+      offsetToPointer<const StaticDescriptorValue>(writer.appendArray(staticValues.data(), staticValues.size()));
+}
+
+// =====================================================================================================================
+// Appends the data of a pipeline shader info to a pipeline info binary, and encodes the pointers in it. The SPIR-V
+// binary of the shader module is added to the stages of the header.
+//
+// @param writer : Writer of the binary
+// @param stage : Shader stage of the shader info
+// @param [in/out] shaderInfo : Shader info, whose pointers are replaced by offsets
+// @param [in/out] header : Header of the binary
+// @returns : False if the shader module has no SPIR-V binary
+static bool encodePipelineShaderInfo(PipelineInfoBinaryWriter &writer, ShaderStage stage,
+                                     PipelineShaderInfo &shaderInfo, PipelineInfoBinaryHeader &header) {
+  if (!shaderInfo.pModuleData)
+    return true;
+  const ShaderModuleData *moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo.pModuleData);
+  if (moduleData->binType != BinaryType::Spirv)
+    return false;
+
+  auto &encodedStage = header.stages[header.stageCount++];
+  encodedStage.stage = stage;
+  encodedStage.codeSize = moduleData->binCode.codeSize;
+  encodedStage.codeOffset = writer.append(moduleData->binCode.pCode, moduleData->binCode.codeSize);
+  shaderInfo.pModuleData = nullptr;
+
+  if (shaderInfo.pSpecializationInfo) {
+    VkSpecializationInfo specializationInfo = *shaderInfo.pSpecializationInfo;
+    specializationInfo.pMapEntries = offsetToPointer<const VkSpecializationMapEntry>(
+        writer.appendArray(specializationInfo.pMapEntries, specializationInfo.mapEntryCount));
+    specializationInfo.pData = offsetToPointer<const void>(writer.append(specializationInfo.pData,
+                                                                         specializationInfo.dataSize));
+    shaderInfo.pSpecializationInfo =
+        offsetToPointer<const VkSpecializationInfo>(writer.append(&specializationInfo, sizeof(specializationInfo)));
+  }
+
+  if (shaderInfo.pEntryTarget) {
+    shaderInfo.pEntryTarget =
+        offsetToPointer<const char>(writer.append(shaderInfo.pEntryTarget, strlen(shaderInfo.pEntryTarget) + 1));
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Appends a vertex input state to a pipeline info binary. Of the structures chained to it, only the vertex input
+// divisor state is kept.
+//
+// @param writer : Writer of the binary
+// @param vertexInput : Vertex input state
+// @returns : Offset of the vertex input state
+static uint64_t encodeVertexInputState(PipelineInfoBinaryWriter &writer,
+                                       const VkPipelineVertexInputStateCreateInfo *vertexInput) {
+  if (!vertexInput)
+    return 0;
+
+  VkPipelineVertexInputStateCreateInfo encodedVertexInput = *vertexInput;
+  encodedVertexInput.pVertexBindingDescriptions = offsetToPointer<const VkVertexInputBindingDescription>(
+      writer.appendArray(vertexInput->pVertexBindingDescriptions, vertexInput->vertexBindingDescriptionCount));
+  encodedVertexInput.pVertexAttributeDescriptions = offsetToPointer<const VkVertexInputAttributeDescription>(
+      writer.appendArray(vertexInput->pVertexAttributeDescriptions, vertexInput->vertexAttributeDescriptionCount));
+
+  encodedVertexInput.pNext = nullptr;
+  auto divisorState = findVkStructInChain<VkPipelineVertexInputDivisorStateCreateInfoEXT>(
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT, vertexInput->pNext);
+  if (divisorState) {
+    VkPipelineVertexInputDivisorStateCreateInfoEXT encodedDivisorState = *divisorState;
+    encodedDivisorState.pNext = nullptr;
+    encodedDivisorState.pVertexBindingDivisors = offsetToPointer<const VkVertexInputBindingDivisorDescriptionEXT>(
+        writer.appendArray(divisorState->pVertexBindingDivisors, divisorState->vertexBindingDivisorCount));
+    encodedVertexInput.pNext =
+        offsetToPointer<const void>(writer.append(&encodedDivisorState, sizeof(encodedDivisorState)));
+  }
+  return writer.append(&encodedVertexInput, sizeof(encodedVertexInput));
+}
+
+// =====================================================================================================================
+// Encodes a pipeline build info, with the SPIR-V binaries of its shader modules, as a pipeline info binary. See
+// PipelineInfoBinaryHeader for the encoding.
+//
+// @param pipelineInfo : Info of the pipeline to be built
+// @param [out] data : The pipeline info binary
+// @returns : False if the build info cannot be encoded, as a shader module has no SPIR-V binary
+bool PipelineDumper::encodePipelineInfoBinary(PipelineBuildInfo pipelineInfo, std::string &data) {
+  PipelineInfoBinaryWriter writer;
+  PipelineInfoBinaryHeader header = {};
+  header.magic = PipelineInfoBinaryMagic;
+  header.formatVersion = PipelineInfoBinaryFormatVersion;
+  header.interfaceVersion = Version;
+
+  if (pipelineInfo.pComputeInfo) {
+    // The callbacks and caches of the build info belong to the process that dumps it, so they are not kept.
+    ComputePipelineBuildInfo buildInfo = *pipelineInfo.pComputeInfo;
+    buildInfo.pInstance = nullptr;
+    buildInfo.pUserData = nullptr;
+    buildInfo.pfnOutputAlloc = nullptr;
+    buildInfo.cache = nullptr;
+#if LLPC_ENABLE_SHADER_CACHE
+    buildInfo.pShaderCache = nullptr;
+#endif
+    if (!encodePipelineShaderInfo(writer, ShaderStageCompute, buildInfo.cs, header))
+      return false;
+    encodeResourceMapping(writer, buildInfo.resourceMapping);
+    header.buildInfoSize = sizeof(buildInfo);
+    header.buildInfoOffset = writer.append(&buildInfo, sizeof(buildInfo));
+  } else {
+    GraphicsPipelineBuildInfo buildInfo = *pipelineInfo.pGraphicsInfo;
+    buildInfo.pInstance = nullptr;
+    buildInfo.pUserData = nullptr;
+    buildInfo.pfnOutputAlloc = nullptr;
+    buildInfo.cache = nullptr;
+#if LLPC_ENABLE_SHADER_CACHE
+    buildInfo.pShaderCache = nullptr;
+#endif
+    PipelineShaderInfo *shaderInfos[ShaderStageGfxCount] = {&buildInfo.vs, &buildInfo.tcs, &buildInfo.tes,
+                                                            &buildInfo.gs, &buildInfo.fs};
+    for (unsigned stage = 0; stage < ShaderStageGfxCount; ++stage) {
+      if (!encodePipelineShaderInfo(writer, static_cast<ShaderStage>(stage), *shaderInfos[stage], header))
+        return false;
+    }
+    encodeResourceMapping(writer, buildInfo.resourceMapping);
+    buildInfo.pVertexInput = offsetToPointer<const VkPipelineVertexInputStateCreateInfo>(
+        encodeVertexInputState(writer, buildInfo.pVertexInput));
+    header.isGraphics = true;
+    header.buildInfoSize = sizeof(buildInfo);
+    header.buildInfoOffset = writer.append(&buildInfo, sizeof(buildInfo));
+  }
+
+  data = std::move(writer.finish(header));
+  return true;
+}
+
+// =====================================================================================================================
+// Relocates the pointers of resource mapping nodes of a pipeline info binary, and those of the tables they point to.
+//
+// @param reader : Reader of the binary
+// @param nodes : Resource mapping nodes, whose pointers are relocated
+// @param nodeCount : Number of the nodes
+// @param depth : Depth of the nodes in the resource mapping graph
+// @returns : False if a pointer is not inside the binary, or the tables nest too deeply
+static bool decodeResourceMappingNodes(PipelineInfoBinaryReader &reader, const ResourceMappingNode *nodes,
+                                       unsigned nodeCount, unsigned depth) {
+  // Tables do not nest this deeply in a valid binary, so this stops a binary whose tables form a loop.
+  static constexpr unsigned MaxTableDepth = 16;
+  for (unsigned i = 0; i < nodeCount; ++i) {
+    ResourceMappingNode &node = const_cast<ResourceMappingNode &>(nodes[i]);
+    if (node.type != ResourceMappingNodeType::DescriptorTableVaPtr)
+      continue;
+    if (depth == MaxTableDepth || !reader.relocate(node.tablePtr.pNext, node.tablePtr.nodeCount) ||
+        !decodeResourceMappingNodes(reader, node.tablePtr.pNext, node.tablePtr.nodeCount, depth + 1))
+      return false;
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Relocates the pointers of resource mapping data of a pipeline info binary.
+//
+// @param reader : Reader of the binary
+// @param [in/out] resourceMapping : Resource mapping data, whose pointers are relocated
+// @returns : False if a pointer is not inside the binary
+static bool decodeResourceMapping(PipelineInfoBinaryReader &reader, ResourceMappingData &resourceMapping) {
+  if (!reader.relocate(resourceMapping.pUserDataNodes, resourceMapping.userDataNodeCount))
+    return false;
+  for (unsigned i = 0; i < resourceMapping.userDataNodeCount; ++i) {
+    const ResourceMappingNode &node = resourceMapping.pUserDataNodes[i].node;
+    if (!decodeResourceMappingNodes(reader, &node, 1, 0))
+      return false;
+  }
+
+  if (!reader.relocate(resourceMapping.pStaticDescriptorValues, resourceMapping.staticDescriptorValueCount))
+    return false;
+  for (unsigned i = 0; i < resourceMapping.staticDescriptorValueCount; ++i) {
+    auto &staticValue = const_cast<StaticDescriptorValue &>(resourceMapping.pStaticDescriptorValues[i]);
+    const unsigned descriptorSize =
+        16 + (staticValue.type != ResourceMappingNodeType::DescriptorYCbCrSampler
+                  ? 0
+                  : sizeof(SamplerYCbCrConversionMetaData));
+    if (!reader.relocate(staticValue.pValue, staticValue.arraySize * descriptorSize / sizeof(unsigned)))
+      return false;
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Relocates the pointers of a pipeline shader info of a pipeline info binary.
+//
+// @param reader : Reader of the binary
+// @param [in/out] shaderInfo : Shader info, whose pointers are relocated
+// @returns : False if a pointer is not inside the binary
+static bool decodePipelineShaderInfo(PipelineInfoBinaryReader &reader, PipelineShaderInfo &shaderInfo) {
+  shaderInfo.pModuleData = nullptr;
+  if (!reader.relocate(shaderInfo.pSpecializationInfo, 1) || !reader.relocateString(shaderInfo.pEntryTarget))
+    return false;
+  if (!shaderInfo.pSpecializationInfo)
+    return true;
+  VkSpecializationInfo &specializationInfo = const_cast<VkSpecializationInfo &>(*shaderInfo.pSpecializationInfo);
+  return reader.relocate(specializationInfo.pMapEntries, specializationInfo.mapEntryCount) &&
+         reader.relocateBytes(specializationInfo.pData, specializationInfo.dataSize);
+}
+
+// =====================================================================================================================
+// Relocates the pointers of a vertex input state of a pipeline info binary.
+//
+// @param reader : Reader of the binary
+// @param [in/out] vertexInput : Vertex input state, whose pointers are relocated
+// @returns : False if a pointer is not inside the binary
+static bool decodeVertexInputState(PipelineInfoBinaryReader &reader,
+                                   VkPipelineVertexInputStateCreateInfo &vertexInput) {
+  if (!reader.relocate(vertexInput.pVertexBindingDescriptions, vertexInput.vertexBindingDescriptionCount) ||
+      !reader.relocate(vertexInput.pVertexAttributeDescriptions, vertexInput.vertexAttributeDescriptionCount))
+    return false;
+
+  // The only structure chained to the vertex input state is the vertex input divisor state.
+  if (!reader.relocateBytes(vertexInput.pNext, sizeof(VkPipelineVertexInputDivisorStateCreateInfoEXT),
+                            alignof(VkPipelineVertexInputDivisorStateCreateInfoEXT)))
+    return false;
+  if (!vertexInput.pNext)
+    return true;
+  auto &divisorState =
+      *const_cast<VkPipelineVertexInputDivisorStateCreateInfoEXT *>(
+          static_cast<const VkPipelineVertexInputDivisorStateCreateInfoEXT *>(vertexInput.pNext));
+  if (divisorState.sType != VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_DIVISOR_STATE_CREATE_INFO_EXT)
+    return false;
+  divisorState.pNext = nullptr;
+  return reader.relocate(divisorState.pVertexBindingDivisors, divisorState.vertexBindingDivisorCount);
+}
+
+// =====================================================================================================================
+// Decodes a pipeline info binary in place, by relocating the pointers in it. See PipelineInfoBinaryHeader for the
+// encoding.
+//
+// @param [in/out] data : The pipeline info binary, aligned to 8 bytes, which becomes the decoded build info
+// @param dataSize : Size of the binary in bytes
+// @param [out] pipelineInfo : Decoded build info, pointing into the binary
+// @param [out] errorMsg : Why the binary cannot be decoded, on failure
+// @returns : False if the binary cannot be decoded
+bool PipelineDumper::decodePipelineInfoBinary(void *data, size_t dataSize, PipelineInfoBinary *pipelineInfo,
+                                              std::string *errorMsg) {
+  *pipelineInfo = {};
+  if (dataSize < sizeof(PipelineInfoBinaryHeader) ||
+      reinterpret_cast<uintptr_t>(data) % PipelineInfoBinaryAlignment != 0) {
+    *errorMsg = "Truncated or misaligned pipeline info binary";
+    return false;
+  }
+
+  const PipelineInfoBinaryHeader &header = *static_cast<const PipelineInfoBinaryHeader *>(data);
+  if (header.magic != PipelineInfoBinaryMagic || header.formatVersion != PipelineInfoBinaryFormatVersion) {
+    *errorMsg = "Not a pipeline info binary of format version " + std::to_string(PipelineInfoBinaryFormatVersion);
+    return false;
+  }
+  const size_t buildInfoSize = header.isGraphics ? sizeof(GraphicsPipelineBuildInfo) : sizeof(ComputePipelineBuildInfo);
+  if (header.interfaceVersion != Version || header.buildInfoSize != buildInfoSize) {
+    *errorMsg = "Version incompatible, binary Version = " + std::to_string(header.interfaceVersion) +
+                " LLPC::Version = " + std::to_string(Version);
+    return false;
+  }
+  if (header.dataSize != dataSize || header.stageCount > ShaderStageCount) {
+    *errorMsg = "Corrupt pipeline info binary";
+    return false;
+  }
+
+  PipelineInfoBinaryReader reader(data, dataSize);
+  bool valid = true;
+  for (unsigned i = 0; i < header.stageCount; ++i) {
+    const void *code = offsetToPointer<const void>(header.stages[i].codeOffset);
+    valid = valid && header.stages[i].stage < ShaderStageCount && code &&
+            reader.relocateBytes(code, header.stages[i].codeSize, sizeof(unsigned));
+    pipelineInfo->stages[i].stage = static_cast<ShaderStage>(header.stages[i].stage);
+    pipelineInfo->stages[i].spirvBin.codeSize = header.stages[i].codeSize;
+    pipelineInfo->stages[i].spirvBin.pCode = code;
+  }
+  pipelineInfo->stageCount = header.stageCount;
+
+  if (header.isGraphics) {
+    GraphicsPipelineBuildInfo *buildInfo = offsetToPointer<GraphicsPipelineBuildInfo>(header.buildInfoOffset);
+    valid = valid && buildInfo && reader.relocate(buildInfo, 1);
+    if (valid) {
+      PipelineShaderInfo *shaderInfos[ShaderStageGfxCount] = {&buildInfo->vs, &buildInfo->tcs, &buildInfo->tes,
+                                                              &buildInfo->gs, &buildInfo->fs};
+      for (PipelineShaderInfo *shaderInfo : shaderInfos)
+        valid = valid && decodePipelineShaderInfo(reader, *shaderInfo);
+      valid = valid && decodeResourceMapping(reader, buildInfo->resourceMapping) &&
+              reader.relocate(buildInfo->pVertexInput, 1) &&
+              (!buildInfo->pVertexInput ||
+               decodeVertexInputState(reader,
+                                      const_cast<VkPipelineVertexInputStateCreateInfo &>(*buildInfo->pVertexInput)));
+      pipelineInfo->pGraphicsInfo = buildInfo;
+    }
+  } else {
+    ComputePipelineBuildInfo *buildInfo = offsetToPointer<ComputePipelineBuildInfo>(header.buildInfoOffset);
+    valid = valid && buildInfo && reader.relocate(buildInfo, 1);
+    if (valid) {
+      valid = decodePipelineShaderInfo(reader, buildInfo->cs) &&
+              decodeResourceMapping(reader, buildInfo->resourceMapping);
+      pipelineInfo->pComputeInfo = buildInfo;
+    }
+  }
+
+  if (!valid) {
+    *pipelineInfo = {};
+    *errorMsg = "Corrupt pipeline info binary";
+  }
+  return valid;
+}
+
 // =====================================================================================================================
 // Dumps LLPC version info to file
 //
@@ -693,6 +1312,9 @@ void PipelineDumper::dumpPipelineOptions(const PipelineOptions *options, std::os
   dumpFile << "options.extendedRobustness.robustImageAccess = " << options->extendedRobustness.robustImageAccess
            << "\n";
   dumpFile << "options.extendedRobustness.nullDescriptor = " << options->extendedRobustness.nullDescriptor << "\n";
+  dumpFile << "options.waveSizeHeuristic = " << options->waveSizeHeuristic << "\n";
+  dumpFile << "options.groupWaterfallLoops = " << options->groupWaterfallLoops << "\n";
+  dumpFile << "options.fastCompile = " << options->fastCompile << "\n";
 }
 
 // =====================================================================================================================
@@ -768,6 +1390,10 @@ void PipelineDumper::dumpGraphicsStateInfo(const GraphicsPipelineBuildInfo *pipe
   dumpFile << "nggState.subgroupSizing = " << pipelineInfo->nggState.subgroupSizing << "\n";
   dumpFile << "nggState.primsPerSubgroup = " << pipelineInfo->nggState.primsPerSubgroup << "\n";
   dumpFile << "nggState.vertsPerSubgroup = " << pipelineInfo->nggState.vertsPerSubgroup << "\n";
+  dumpFile << "nggState.enableCullingHints = " << pipelineInfo->nggState.enableCullingHints << "\n";
+  dumpFile << "nggState.primsPerDrawHint = " << pipelineInfo->nggState.primsPerDrawHint << "\n";
+  dumpFile << "nggState.culledPrimPercentHint = " << pipelineInfo->nggState.culledPrimPercentHint << "\n";
+  dumpFile << "nggState.vertsPerPrimHint = " << pipelineInfo->nggState.vertsPerPrimHint << "\n";
   dumpFile << "dynamicVertexStride = " << pipelineInfo->dynamicVertexStride << "\n";
   dumpFile << "enableUberFetchShader = " << pipelineInfo->enableUberFetchShader << "\n";
   dumpFile << "enableEarlyCompile = " << pipelineInfo->enableEarlyCompile << "\n";
@@ -847,27 +1473,36 @@ void PipelineDumper::dumpGraphicsPipelineInfo(std::ostream *dumpFile, const char
 // @param isCacheHash : TRUE if the hash is used by shader cache
 // @param isRelocatableShader : TRUE if we are building relocatable shader
 // @param stage : The stage for which we are building the hash. ShaderStageInvalid if building for the entire pipeline.
+// @param [in/out] hashContext : Hashes of the parts of the build info memoized for this build, or nullptr
 MetroHash::Hash PipelineDumper::generateHashForGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline,
                                                                 bool isCacheHash, bool isRelocatableShader,
-                                                                UnlinkedShaderStage unlinkedShaderType) {
+                                                                UnlinkedShaderStage unlinkedShaderType,
+                                                                PipelineHashContext *hashContext) {
+  PipelineHashContext localHashContext;
+  if (!hashContext)
+    hashContext = &localHashContext;
   MetroHash64 hasher;
 
+  auto updateHashForStage = [&](ShaderStage stage, const PipelineShaderInfo *shaderInfo) {
+    hasher.Update(hashContext->getShaderInfoHash(stage, shaderInfo, isCacheHash, isRelocatableShader));
+  };
+
   switch (unlinkedShaderType) {
   case UnlinkedStageVertexProcess:
-    updateHashForPipelineShaderInfo(ShaderStageVertex, &pipeline->vs, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageTessControl, &pipeline->tcs, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageTessEval, &pipeline->tes, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageGeometry, &pipeline->gs, isCacheHash, &hasher, isRelocatableShader);
+    updateHashForStage(ShaderStageVertex, &pipeline->vs);
+    updateHashForStage(ShaderStageTessControl, &pipeline->tcs);
+    updateHashForStage(ShaderStageTessEval, &pipeline->tes);
+    updateHashForStage(ShaderStageGeometry, &pipeline->gs);
     break;
   case UnlinkedStageFragment:
-    updateHashForPipelineShaderInfo(ShaderStageFragment, &pipeline->fs, isCacheHash, &hasher, isRelocatableShader);
+    updateHashForStage(ShaderStageFragment, &pipeline->fs);
     break;
   case UnlinkedStageCount:
-    updateHashForPipelineShaderInfo(ShaderStageVertex, &pipeline->vs, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageTessControl, &pipeline->tcs, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageTessEval, &pipeline->tes, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageGeometry, &pipeline->gs, isCacheHash, &hasher, isRelocatableShader);
-    updateHashForPipelineShaderInfo(ShaderStageFragment, &pipeline->fs, isCacheHash, &hasher, isRelocatableShader);
+    updateHashForStage(ShaderStageVertex, &pipeline->vs);
+    updateHashForStage(ShaderStageTessControl, &pipeline->tcs);
+    updateHashForStage(ShaderStageTessEval, &pipeline->tes);
+    updateHashForStage(ShaderStageGeometry, &pipeline->gs);
+    updateHashForStage(ShaderStageFragment, &pipeline->fs);
     break;
   default:
     llvm_unreachable("Should never be called!");
@@ -875,9 +1510,17 @@ MetroHash::Hash PipelineDumper::generateHashForGraphicsPipeline(const GraphicsPi
   }
 
   if (!isRelocatableShader)
-    updateHashForResourceMappingInfo(&pipeline->resourceMapping, &hasher);
-
-  hasher.Update(pipeline->iaState.deviceIndex);
+    hasher.Update(hashContext->getResourceMappingHash(&pipeline->resourceMapping));
+
+  // The device index only makes a difference to the code of the shaders that read it, and none at all to relocatable
+  // shaders, which read it through a relocation. Leaving it out of the cache hash otherwise lets the devices of a
+  // device group share one cache entry for the pipeline.
+  bool deviceIndexUsed = false;
+  for (const PipelineShaderInfo *shaderInfo :
+       {&pipeline->vs, &pipeline->tcs, &pipeline->tes, &pipeline->gs, &pipeline->fs})
+    deviceIndexUsed |= isDeviceIndexUsed(shaderInfo);
+  if (!isCacheHash || (deviceIndexUsed && !isRelocatableShader))
+    hasher.Update(pipeline->iaState.deviceIndex);
 
   // Relocatable shaders force an unlinked compilation.
   hasher.Update(pipeline->unlinked || isRelocatableShader);
@@ -885,7 +1528,7 @@ MetroHash::Hash PipelineDumper::generateHashForGraphicsPipeline(const GraphicsPi
 
   if (unlinkedShaderType != UnlinkedStageFragment) {
     if (!isRelocatableShader && !pipeline->enableUberFetchShader)
-      updateHashForVertexInputState(pipeline->pVertexInput, pipeline->dynamicVertexStride, &hasher);
+      hasher.Update(hashContext->getVertexInputHash(pipeline->pVertexInput, pipeline->dynamicVertexStride));
     updateHashForNonFragmentState(pipeline, isCacheHash, &hasher, isRelocatableShader);
   }
 
@@ -904,16 +1547,23 @@ MetroHash::Hash PipelineDumper::generateHashForGraphicsPipeline(const GraphicsPi
 // @param pipeline : Info to build a compute pipeline
 // @param isCacheHash : TRUE if the hash is used by shader cache
 // @param isRelocatableShader : TRUE if we are building relocatable shader
+// @param [in/out] hashContext : Hashes of the parts of the build info memoized for this build, or nullptr
 MetroHash::Hash PipelineDumper::generateHashForComputePipeline(const ComputePipelineBuildInfo *pipeline,
-                                                               bool isCacheHash, bool isRelocatableShader) {
+                                                               bool isCacheHash, bool isRelocatableShader,
+                                                               PipelineHashContext *hashContext) {
+  PipelineHashContext localHashContext;
+  if (!hashContext)
+    hashContext = &localHashContext;
   MetroHash64 hasher;
 
-  updateHashForPipelineShaderInfo(ShaderStageCompute, &pipeline->cs, isCacheHash, &hasher, isRelocatableShader);
+  hasher.Update(hashContext->getShaderInfoHash(ShaderStageCompute, &pipeline->cs, isCacheHash, isRelocatableShader));
 
   if (!isRelocatableShader)
-    updateHashForResourceMappingInfo(&pipeline->resourceMapping, &hasher);
+    hasher.Update(hashContext->getResourceMappingHash(&pipeline->resourceMapping));
 
-  hasher.Update(pipeline->deviceIndex);
+  // As for a graphics pipeline, the cache hash only includes the device index if the shader reads it.
+  if (!isCacheHash || (isDeviceIndexUsed(&pipeline->cs) && !isRelocatableShader))
+    hasher.Update(pipeline->deviceIndex);
 
   updateHashForPipelineOptions(&pipeline->options, &hasher, isRelocatableShader);
 
@@ -926,6 +1576,59 @@ MetroHash::Hash PipelineDumper::generateHashForComputePipeline(const ComputePipe
   return hash;
 }
 
+// =====================================================================================================================
+// Gets the hash of the whole resource mapping of the pipeline, hashing it on the first call.
+//
+// @param resourceMapping : Pipeline resource mapping data
+// @returns : Hash of the resource mapping
+const MetroHash::Hash &PipelineHashContext::getResourceMappingHash(const ResourceMappingData *resourceMapping) {
+  if (!m_resourceMappingHash.valid) {
+    PipelineDumper::MetroHash64 hasher;
+    PipelineDumper::updateHashForResourceMappingInfo(resourceMapping, &hasher);
+    hasher.Finalize(m_resourceMappingHash.hash.bytes);
+    m_resourceMappingHash.valid = true;
+  }
+  return m_resourceMappingHash.hash;
+}
+
+// =====================================================================================================================
+// Gets the hash of the vertex input state of the pipeline, hashing it on the first call.
+//
+// @param vertexInput : Vertex input state
+// @param dynamicVertexStride : Whether the vertex strides are dynamic
+// @returns : Hash of the vertex input state
+const MetroHash::Hash &PipelineHashContext::getVertexInputHash(const VkPipelineVertexInputStateCreateInfo *vertexInput,
+                                                               bool dynamicVertexStride) {
+  if (!m_vertexInputHash.valid) {
+    PipelineDumper::MetroHash64 hasher;
+    PipelineDumper::updateHashForVertexInputState(vertexInput, dynamicVertexStride, &hasher);
+    hasher.Finalize(m_vertexInputHash.hash.bytes);
+    m_vertexInputHash.valid = true;
+  }
+  return m_vertexInputHash.hash;
+}
+
+// =====================================================================================================================
+// Gets the hash of the shader info of a stage of the pipeline, hashing it on the first call for the stage and flags.
+//
+// @param stage : Shader stage
+// @param shaderInfo : Shader info in specified shader stage
+// @param isCacheHash : TRUE if the hash is used by shader cache
+// @param isRelocatableShader : TRUE if we are building relocatable shader
+// @returns : Hash of the shader info
+const MetroHash::Hash &PipelineHashContext::getShaderInfoHash(ShaderStage stage, const PipelineShaderInfo *shaderInfo,
+                                                              bool isCacheHash, bool isRelocatableShader) {
+  assert(stage < ShaderStageCount);
+  MemoizedHash &memoizedHash = m_shaderInfoHashes[stage][isCacheHash][isRelocatableShader];
+  if (!memoizedHash.valid) {
+    PipelineDumper::MetroHash64 hasher;
+    PipelineDumper::updateHashForPipelineShaderInfo(stage, shaderInfo, isCacheHash, &hasher, isRelocatableShader);
+    hasher.Finalize(memoizedHash.hash.bytes);
+    memoizedHash.valid = true;
+  }
+  return memoizedHash.hash;
+}
+
 // =====================================================================================================================
 // Updates hash code context for vertex input state
 //
@@ -1024,6 +1727,13 @@ void PipelineDumper::updateHashForNonFragmentState(const GraphicsPipelineBuildIn
       hasher->Update(nggState->subgroupSizing);
       hasher->Update(nggState->primsPerSubgroup);
       hasher->Update(nggState->vertsPerSubgroup);
+      hasher->Update(nggState->enableCullingHints);
+      if (nggState->enableCullingHints) {
+        hasher->Update(nggState->primsPerDrawHint);
+        hasher->Update(nggState->culledPrimPercentHint);
+      }
+      if (nggState->subgroupSizing == NggSubgroupSizingType::Adaptive)
+        hasher->Update(nggState->vertsPerPrimHint);
     }
 
     updateHashForPipelineOptions(&pipeline->options, hasher, isRelocatableShader);
@@ -1081,6 +1791,12 @@ void PipelineDumper::updateHashForPipelineOptions(const PipelineOptions *options
   hasher->Update(options->extendedRobustness.robustBufferAccess);
   hasher->Update(options->extendedRobustness.robustImageAccess);
   hasher->Update(options->extendedRobustness.nullDescriptor);
+  if (options->waveSizeHeuristic != WaveSizeHeuristic::Disable)
+    hasher->Update(options->waveSizeHeuristic);
+  if (options->groupWaterfallLoops)
+    hasher->Update(options->groupWaterfallLoops);
+  if (options->fastCompile)
+    hasher->Update(options->fastCompile);
 }
 
 // =====================================================================================================================
@@ -1149,22 +1865,42 @@ void PipelineDumper::updateHashForPipelineShaderInfo(ShaderStage stage, const Pi
       hasher->Update(options.disableLicmThreshold);
       hasher->Update(options.unrollHintThreshold);
       hasher->Update(options.dontUnrollHintThreshold);
+      if (options.mathPrecision != MathPrecision::Strict)
+        hasher->Update(options.mathPrecision);
     }
   }
 }
 
+// =====================================================================================================================
+// Checks whether the shader may read the device index. A shader whose module is not SPIR-V is assumed to read it, as
+// its module usage is not scanned.
+//
+// @param shaderInfo : Shader info of the pipeline stage
+bool PipelineDumper::isDeviceIndexUsed(const PipelineShaderInfo *shaderInfo) {
+  auto moduleData = reinterpret_cast<const ShaderModuleData *>(shaderInfo->pModuleData);
+  if (!moduleData)
+    return false;
+  return moduleData->binType != BinaryType::Spirv || moduleData->usage.useDeviceIndex;
+}
+
 // =====================================================================================================================
 // Updates hash code context for resource node and static descriptor value data.
 //
 // @param resourceMapping : Pipeline resource mapping data.
 // @param [in,out] hasher : Haher to generate hash code.
 // @param stage : The stage for which we are building the hash. ShaderStageInvalid if building for the entire pipeline.
+// @param descriptorSetMask : Mask of the descriptor sets below 64 that the stage may use. The nodes and static
+//                            descriptor values of the other sets below 64 are left out of the hash.
 void PipelineDumper::updateHashForResourceMappingInfo(const ResourceMappingData *pResourceMapping, MetroHash64 *hasher,
-                                                      ShaderStage stage) {
-  hasher->Update(pResourceMapping->staticDescriptorValueCount);
+                                                      ShaderStage stage, uint64_t descriptorSetMask) {
+  // The counts would change with the nodes that are left out, so they are only hashed if none is.
+  if (descriptorSetMask == UINT64_MAX)
+    hasher->Update(pResourceMapping->staticDescriptorValueCount);
   if (pResourceMapping->staticDescriptorValueCount > 0) {
       for (unsigned i = 0; i < pResourceMapping->staticDescriptorValueCount; ++i) {
           auto staticDescriptorValue = &pResourceMapping->pStaticDescriptorValues[i];
+          if (staticDescriptorValue->set < 64 && (descriptorSetMask & (uint64_t(1) << staticDescriptorValue->set)) == 0)
+            continue;
           if (stage == ShaderStageInvalid || (staticDescriptorValue->visibility & shaderStageToMask(stage))) {
             if (stage == ShaderStageInvalid)
               hasher->Update(staticDescriptorValue->visibility);
@@ -1189,11 +1925,13 @@ void PipelineDumper::updateHashForResourceMappingInfo(const ResourceMappingData
       }
   }
 
-    hasher->Update(pResourceMapping->userDataNodeCount);
+    if (descriptorSetMask == UINT64_MAX)
+      hasher->Update(pResourceMapping->userDataNodeCount);
     if (pResourceMapping->userDataNodeCount > 0) {
       for (unsigned i = 0; i < pResourceMapping->userDataNodeCount; ++i) {
         auto userDataNode = &pResourceMapping->pUserDataNodes[i];
-        if (stage == ShaderStageInvalid || (userDataNode->visibility & shaderStageToMask(stage))) {
+        if ((stage == ShaderStageInvalid || (userDataNode->visibility & shaderStageToMask(stage))) &&
+            isResourceMappingNodeUsed(&userDataNode->node, descriptorSetMask)) {
           if (stage == ShaderStageInvalid)
             hasher->Update(userDataNode->visibility);
           updateHashForResourceMappingNode(&userDataNode->node, true, hasher);
@@ -1202,6 +1940,44 @@ void PipelineDumper::updateHashForResourceMappingInfo(const ResourceMappingData
     }
 }
 
+// =====================================================================================================================
+// Returns whether a resource mapping node may be used by a shader that only uses the given descriptor sets below 64: a
+// table of descriptors is used if any node in it is, and a node that is not a descriptor in a set below 64 always is.
+//
+// @param userDataNode : Resource mapping node
+// @param descriptorSetMask : Mask of the descriptor sets below 64 that may be used
+bool PipelineDumper::isResourceMappingNodeUsed(const ResourceMappingNode *userDataNode, uint64_t descriptorSetMask) {
+  switch (userDataNode->type) {
+  case ResourceMappingNodeType::DescriptorResource:
+  case ResourceMappingNodeType::DescriptorSampler:
+  case ResourceMappingNodeType::DescriptorYCbCrSampler:
+  case ResourceMappingNodeType::DescriptorCombinedTexture:
+  case ResourceMappingNodeType::DescriptorTexelBuffer:
+  case ResourceMappingNodeType::DescriptorBuffer:
+  case ResourceMappingNodeType::DescriptorFmask:
+  case ResourceMappingNodeType::DescriptorBufferCompact:
+  case ResourceMappingNodeType::DescriptorConstBuffer:
+  case ResourceMappingNodeType::DescriptorConstBufferCompact:
+  case ResourceMappingNodeType::DescriptorImage:
+  case ResourceMappingNodeType::DescriptorConstTexelBuffer:
+// clang-format off
+#if  (LLPC_CLIENT_INTERFACE_MAJOR_VERSION>= 50)
+  case ResourceMappingNodeType::InlineBuffer:
+#endif
+    // clang-format on
+    return userDataNode->srdRange.set >= 64 || (descriptorSetMask & (uint64_t(1) << userDataNode->srdRange.set)) != 0;
+  case ResourceMappingNodeType::DescriptorTableVaPtr: {
+    for (unsigned i = 0; i < userDataNode->tablePtr.nodeCount; ++i) {
+      if (isResourceMappingNodeUsed(&userDataNode->tablePtr.pNext[i], descriptorSetMask))
+        return true;
+    }
+    return userDataNode->tablePtr.nodeCount == 0;
+  }
+  default:
+    return true;
+  }
+}
+
 // =====================================================================================================================
 // Updates hash code context for resource mapping node.
 //
@@ -1653,6 +2429,7 @@ std::ostream &operator<<(std::ostream &out, NggSubgroupSizingType subgroupSizing
     CASE_CLASSENUM_TO_STRING(NggSubgroupSizingType, OptimizeForVerts)
     CASE_CLASSENUM_TO_STRING(NggSubgroupSizingType, OptimizeForPrims)
     CASE_CLASSENUM_TO_STRING(NggSubgroupSizingType, Explicit)
+    CASE_CLASSENUM_TO_STRING(NggSubgroupSizingType, Adaptive)
     break;
   default:
     llvm_unreachable("Should never be called!");
@@ -1701,6 +2478,26 @@ std::ostream &operator<<(std::ostream &out, DenormalMode denormalMode) {
   return out << string;
 }
 
+// =====================================================================================================================
+// Translates enum "MathPrecision" to string and output to ostream.
+//
+// @param [out] out : Output stream
+// @param mathPrecision : Precision tier of transcendental operations
+std::ostream &operator<<(std::ostream &out, MathPrecision mathPrecision) {
+  const char *string = nullptr;
+  switch (mathPrecision) {
+    CASE_CLASSENUM_TO_STRING(MathPrecision, Strict)
+    CASE_CLASSENUM_TO_STRING(MathPrecision, Relaxed)
+    CASE_CLASSENUM_TO_STRING(MathPrecision, Fast)
+    break;
+  default:
+    llvm_unreachable("Should never be called!");
+    break;
+  }
+
+  return out << string;
+}
+
 // =====================================================================================================================
 // Translates enum "WaveBreakSize" to string and output to ostream.
 //
@@ -1742,6 +2539,27 @@ std::ostream &operator<<(std::ostream &out, ShadowDescriptorTableUsage shadowDes
   return out << string;
 }
 
+// =====================================================================================================================
+// Translates enum "WaveSizeHeuristic" to string and output to ostream.
+//
+// @param [out] out : Output stream
+// @param waveSizeHeuristic : Wave size heuristic setting
+std::ostream &operator<<(std::ostream &out, WaveSizeHeuristic waveSizeHeuristic) {
+  const char *string = nullptr;
+  switch (waveSizeHeuristic) {
+    CASE_CLASSENUM_TO_STRING(WaveSizeHeuristic, Disable)
+    CASE_CLASSENUM_TO_STRING(WaveSizeHeuristic, Auto)
+    CASE_CLASSENUM_TO_STRING(WaveSizeHeuristic, Gfx10)
+    CASE_CLASSENUM_TO_STRING(WaveSizeHeuristic, Gfx103)
+    break;
+  default:
+    llvm_unreachable("Should never be called!");
+    break;
+  }
+
+  return out << string;
+}
+
 // =====================================================================================================================
 // Translates enum "VkPrimitiveTopology" to string and output to ostream.
 //
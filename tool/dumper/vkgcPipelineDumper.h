@@ -51,6 +51,49 @@ enum PipelineDumpFilters : unsigned {
   PipelineDumpFilterVsPs = 0x10, // Disable pipeline dump for VsPs
 };
 
+// =====================================================================================================================
+// Memoizes the hashes of the parts of a pipeline build info (the resource mapping, the vertex input state and the
+// shader info of each stage), so that the hashes generated for several queries on the same build info hash each part
+// only once. A context is meant to live for one pipeline build. It must not outlive the build info, and it is not
+// thread-safe.
+class PipelineHashContext {
+public:
+  PipelineHashContext() = default;
+
+  const MetroHash::Hash &getResourceMappingHash(const ResourceMappingData *resourceMapping);
+  const MetroHash::Hash &getVertexInputHash(const VkPipelineVertexInputStateCreateInfo *vertexInput,
+                                            bool dynamicVertexStride);
+  const MetroHash::Hash &getShaderInfoHash(ShaderStage stage, const PipelineShaderInfo *shaderInfo, bool isCacheHash,
+                                           bool isRelocatableShader);
+
+private:
+  // A memoized hash
+  struct MemoizedHash {
+    bool valid = false;
+    MetroHash::Hash hash = {};
+  };
+
+  MemoizedHash m_resourceMappingHash; // Hash of the whole resource mapping
+  MemoizedHash m_vertexInputHash;     // Hash of the vertex input state
+  // Hash of the shader info of each stage, by stage, isCacheHash and isRelocatableShader
+  MemoizedHash m_shaderInfoHashes[ShaderStageCount][2][2];
+};
+
+// =====================================================================================================================
+// A pipeline build info decoded from its binary encoding (a .pipebin file), which the pipeline dumper writes along with
+// the .pipe file if PipelineDumpOptions::dumpPipelineInfoBinary is set. The pointers in the build info point into the
+// buffer that was decoded, which must outlive it. The shader infos have no module data; the SPIR-V binary of each
+// stage is given in stages, to build the shader modules from.
+struct PipelineInfoBinary {
+  const ComputePipelineBuildInfo *pComputeInfo;   // Compute pipeline build info, or nullptr
+  const GraphicsPipelineBuildInfo *pGraphicsInfo; // Graphics pipeline build info, or nullptr
+  unsigned stageCount;                            // Number of shader stages
+  struct {
+    ShaderStage stage;   // Shader stage
+    BinaryData spirvBin; // SPIR-V binary
+  } stages[ShaderStageCount];                     // Shader stages
+};
+
 class PipelineDumper {
 public:
   typedef Util::MetroHash64 MetroHash64;
@@ -68,18 +111,23 @@ public:
 
   static MetroHash::Hash generateHashForGraphicsPipeline(const GraphicsPipelineBuildInfo *pipeline, bool isCacheHash,
                                                          bool isRelocatableShader,
-                                                         UnlinkedShaderStage unlinkedShaderType = UnlinkedStageCount);
+                                                         UnlinkedShaderStage unlinkedShaderType = UnlinkedStageCount,
+                                                         PipelineHashContext *hashContext = nullptr);
 
   static MetroHash::Hash generateHashForComputePipeline(const ComputePipelineBuildInfo *pipeline, bool isCacheHash,
-                                                        bool isRelocatableShader);
+                                                        bool isRelocatableShader,
+                                                        PipelineHashContext *hashContext = nullptr);
 
   static std::string getPipelineInfoFileName(PipelineBuildInfo pipelineInfo, const uint64_t hashCode64);
 
   static void updateHashForPipelineShaderInfo(ShaderStage stage, const PipelineShaderInfo *shaderInfo, bool isCacheHash,
                                               MetroHash64 *hasher, bool isRelocatableShader);
 
+  static bool isDeviceIndexUsed(const PipelineShaderInfo *shaderInfo);
+
   static void updateHashForResourceMappingInfo(const ResourceMappingData *pResourceMapping, MetroHash64 *hasher,
-                                               ShaderStage stage = ShaderStageInvalid);
+                                               ShaderStage stage = ShaderStageInvalid,
+                                               uint64_t descriptorSetMask = UINT64_MAX);
 
   static void updateHashForVertexInputState(const VkPipelineVertexInputStateCreateInfo *vertexInput,
                                             bool dynamicVertexStride, MetroHash64 *hasher);
@@ -108,9 +156,16 @@ public:
   // Returns the hash for the glue shader that corresponds to the given glue shader string.
   static const MetroHash::Hash generateHashForGlueShader(BinaryData glueShaderString);
 
+  static bool encodePipelineInfoBinary(PipelineBuildInfo pipelineInfo, std::string &data);
+
+  static bool decodePipelineInfoBinary(void *data, size_t dataSize, PipelineInfoBinary *pipelineInfo,
+                                       std::string *errorMsg);
+
 private:
   static std::string getSpirvBinaryFileName(const MetroHash::Hash *hash);
 
+  static void writePipelineDump(PipelineDumpFile *dumpFile);
+
   static void dumpComputePipelineInfo(std::ostream *dumpFile, const char *dumpDir,
                                       const ComputePipelineBuildInfo *pipelineInfo);
   static void dumpGraphicsPipelineInfo(std::ostream *dumpFile, const char *dumpDir,
@@ -129,6 +184,7 @@ private:
 
   static void updateHashForResourceMappingNode(const ResourceMappingNode *userDataNode, bool isRootNode,
                                                MetroHash64 *hasher);
+  static bool isResourceMappingNodeUsed(const ResourceMappingNode *userDataNode, uint64_t descriptorSetMask);
 };
 
 } // namespace Vkgc
@@ -589,6 +589,10 @@ namespace Vfx {
 bool VFXAPI vfxParseFile(const char *pFilename, unsigned int numMacro, const char *pMacros[], VfxDocType type,
                          void **ppDoc, const char **ppErrorMsg);
 
+bool VFXAPI vfxParseFiles(unsigned fileCount, const char *const pFilenames[], unsigned int numMacro,
+                          const char *pMacros[], VfxDocType type, unsigned numThreads, void *pDocs[],
+                          const char *pErrorMsgs[]);
+
 void VFXAPI vfxCloseDoc(void *pDoc);
 
 #if VFX_SUPPORT_RENDER_DOCOUMENT
@@ -42,10 +42,13 @@
 #include "vfxRenderDoc.h"
 #endif
 
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 #include <vector>
 
 namespace Vfx {
@@ -138,6 +141,35 @@ std::vector<char *> split(char *str, const char *delimiters) {
   return fragments;
 }
 
+// =====================================================================================================================
+// Splits the input buffer into lines by modifying it in place. The line ending ('\n') of each line is replaced with
+// a null terminator, so the lines can be parsed in place without copying them out. A '\r' before the '\n' is kept.
+// There is no empty line after the final line ending.
+//
+// Example:
+// ```c++
+//   char str[] = "a\n\nbb\n";
+//   std::vector<char *> lines = splitLines(str); // Contains: {"a", "", "bb"}.
+// ```
+//
+// @param [in/out] buffer : Null-terminated buffer to scan and modify.
+// @returns : Vector of null-terminated lines.
+std::vector<char *> splitLines(char *buffer) {
+  VFX_ASSERT(buffer);
+  std::vector<char *> lines;
+
+  while (*buffer != '\0') {
+    lines.push_back(buffer);
+    buffer = strchr(buffer, '\n');
+    if (!buffer)
+      break;
+    *buffer = '\0';
+    ++buffer;
+  }
+
+  return lines;
+}
+
 // =====================================================================================================================
 Document::~Document() {
   for (unsigned i = 0; i < SectionTypeNameNum; ++i) {
@@ -233,7 +265,7 @@ bool Document::parseLine(char *line) {
     if (result)
       result = beginSection(line);
   } else
-    m_currentSectionStringBuffer << line;
+    m_currentSectionLines.push_back(line);
 
   return result;
 }
@@ -262,8 +294,7 @@ bool Document::beginSection(char *line) {
     if (m_currentSection) {
       // Next line is the first line of section content.
       m_currentSectionLineNum = m_currentLineNum + 1;
-      m_currentSectionStringBuffer.str("");
-      m_currentSectionStringBuffer.clear();
+      m_currentSectionLines.clear();
       m_currentSection->setLineNum(m_currentLineNum);
     }
   }
@@ -303,15 +334,8 @@ bool Document::parseSectionKeyValues() {
 
   // Set line number variable which is used in error report.
   unsigned lineNum = m_currentSectionLineNum;
-  char lineBuffer[MaxLineBufSize];
-  while (true) {
-    m_currentSectionStringBuffer.getline(lineBuffer, MaxLineBufSize);
-
-    size_t readCount = static_cast<size_t>(m_currentSectionStringBuffer.gcount());
-    VFX_ASSERT(readCount < MaxLineBufSize);
-    if (readCount == 0)
-      break;
-    if (lineBuffer[0] == '\0' || memcmp(lineBuffer, "\r", 2) == 0) {
+  for (char *line : m_currentSectionLines) {
+    if (line[0] == '\0' || strcmp(line, "\r") == 0) {
       // Skip empty line
       continue;
     }
@@ -319,7 +343,7 @@ bool Document::parseSectionKeyValues() {
     char *key = nullptr;
     char *value = nullptr;
 
-    result = extractKeyAndValue(lineBuffer, lineNum, '=', &key, &value, &m_errorMsg);
+    result = extractKeyAndValue(line, lineNum, '=', &key, &value, &m_errorMsg);
 
     if (!result)
       break;
@@ -558,20 +582,10 @@ bool Document::parseKeyValue(char *key, char *valueStr, unsigned lineNum, Sectio
 // =====================================================================================================================
 // Parses shader source section.
 void Document::parseSectionShaderSource() {
-  char lineBuffer[MaxLineBufSize];
-
-  while (true) {
-    m_currentSectionStringBuffer.getline(lineBuffer, MaxLineBufSize);
-
-    size_t readCount = static_cast<size_t>(m_currentSectionStringBuffer.gcount());
-    VFX_ASSERT(readCount < MaxLineBufSize);
-    if (readCount == 0)
-      break;
-
-    // Line ending is not returned by getline(), so append them manually.
-    lineBuffer[readCount - 1] = '\n';
-    lineBuffer[readCount] = '\0';
-    m_currentSection->addLine(lineBuffer);
+  for (const char *line : m_currentSectionLines) {
+    // Line ending is not kept by splitLines(), so append them manually.
+    m_currentSection->addLine(line);
+    m_currentSection->addLine("\n");
   }
 }
 
@@ -586,27 +600,45 @@ bool Document::parse(const TestCaseInfo &info) {
   FILE *configFile = fopen(info.vfxFile.c_str(), "r");
   if (configFile) {
     setFileName(info.vfxFile);
-    char lineBuf[MaxLineBufSize];
-    char *linePtr = nullptr;
 
-    while (true) {
-      linePtr = fgets(lineBuf, MaxLineBufSize, configFile);
+    // Read the whole file in one go, and parse its lines in place.
+    fseek(configFile, 0, SEEK_END);
+    long fileSize = ftell(configFile);
+    fseek(configFile, 0, SEEK_SET);
+    m_fileBuffer.resize(std::max(fileSize, 0L) + 1);
+    size_t readSize = fread(m_fileBuffer.data(), 1, m_fileBuffer.size() - 1, configFile);
+    m_fileBuffer[readSize] = '\0';
+    fclose(configFile);
 
-      if (!linePtr) {
-        result = endSection();
-        break;
-      } else {
-        result = macroSubstituteLine(linePtr, m_currentLineNum + 1, &info.macros, MaxLineBufSize);
-        if (!result)
+    std::vector<char> lineBuf;
+    for (char *linePtr : splitLines(m_fileBuffer.data())) {
+      // Only lines that contain a macro are copied, so that they can be substituted.
+      bool hasMacro = false;
+      for (const auto &macro : info.macros)
+        hasMacro = hasMacro || strstr(linePtr, macro.first.c_str());
+
+      if (hasMacro) {
+        if (strlen(linePtr) >= MaxLineBufSize) {
+          PARSE_ERROR(m_errorMsg, m_currentLineNum + 1, "Line length exceeds MaxLineBufSize.");
+          result = false;
           break;
-
-        result = parseLine(linePtr);
+        }
+        lineBuf.resize(MaxLineBufSize);
+        strcpy(lineBuf.data(), linePtr);
+        result = macroSubstituteLine(lineBuf.data(), m_currentLineNum + 1, &info.macros, MaxLineBufSize);
         if (!result)
           break;
+        m_substitutedLines.emplace_back(lineBuf.data());
+        linePtr = &m_substitutedLines.back()[0];
       }
+
+      result = parseLine(linePtr);
+      if (!result)
+        break;
     }
 
-    fclose(configFile);
+    if (result)
+      result = endSection();
 
     if (result)
       result = validate();
@@ -1418,6 +1450,48 @@ bool VFXAPI vfxParseFile(const char *filename, unsigned int numMacro, const char
   return ret;
 }
 
+// =====================================================================================================================
+// Parses many input files in parallel. A document handle is returned for every input file, whether or not it was
+// parsed successfully, and each one must be closed with vfxCloseDoc.
+//
+// @param fileCount : Number of input files
+// @param filenames : Input file names
+// @param numMacro : Number of macros
+// @param macros : Marco list, Two strings are a macro, and macro will be extract before parse
+// @param type : Document type
+// @param numThreads : Number of threads to parse with, or 0 to use all the hardware threads
+// @param [out] docs : Document handles, one for each input file
+// @param [out] errorMsgs : Error messages, one for each input file
+// @returns : True if all input files were parsed successfully
+bool VFXAPI vfxParseFiles(unsigned fileCount, const char *const filenames[], unsigned int numMacro,
+                          const char *macros[], VfxDocType type, unsigned numThreads, void *docs[],
+                          const char *errorMsgs[]) {
+  if (numThreads == 0)
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  numThreads = std::min(numThreads, fileCount);
+
+  std::atomic<unsigned> nextFile(0);
+  std::atomic<bool> allSucceeded(true);
+  auto parseFiles = [&]() {
+    for (unsigned i = nextFile++; i < fileCount; i = nextFile++) {
+      if (!vfxParseFile(filenames[i], numMacro, macros, type, &docs[i], &errorMsgs[i]))
+        allSucceeded = false;
+    }
+  };
+
+  if (numThreads <= 1)
+    parseFiles();
+  else {
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < numThreads; ++i)
+      threads.emplace_back(parseFiles);
+    for (std::thread &thread : threads)
+      thread.join();
+  }
+
+  return allSucceeded;
+}
+
 // =====================================================================================================================
 // Closes document handle
 //
@@ -32,8 +32,8 @@
 #pragma once
 
 #include "vfxSection.h"
+#include <deque>
 #include <map>
-#include <sstream>
 #include <stddef.h>
 #include <string.h>
 #include <vector>
@@ -101,15 +101,20 @@ protected:
   std::string m_errorMsg;                                // Error message
   std::string m_fileName;                                // Name of source file
 
-  bool m_isValidVfxFile;                          // If VFX file is valid
-  Section *m_currentSection;                      // Current section
-  unsigned m_currentLineNum;                      // Current line number
-  std::stringstream m_currentSectionStringBuffer; // Current section string buffer
-  unsigned m_currentSectionLineNum;               // Current section line number
+  bool m_isValidVfxFile;                      // If VFX file is valid
+  Section *m_currentSection;                  // Current section
+  unsigned m_currentLineNum;                  // Current line number
+  std::vector<char> m_fileBuffer;             // Contents of the source file, tokenized into lines in place
+  std::deque<std::string> m_substitutedLines; // Lines of the source file after macro substitution
+  std::vector<char *> m_currentSectionLines;  // Lines of the current section
+  unsigned m_currentSectionLineNum;           // Current section line number
 };
 
 // Splits the input string by modifying it in place. Returns a vector of (inner) fragment strings. This can be used
 // thread-safe replacement for `strtok`, although the semantics are not identical.
 std::vector<char *> split(char *str, const char *delimiters);
 
+// Splits the input buffer into lines by modifying it in place. Returns a vector of the lines, without line endings.
+std::vector<char *> splitLines(char *buffer);
+
 } // namespace Vfx
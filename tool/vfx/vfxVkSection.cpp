@@ -78,6 +78,7 @@ public:
     ADD_CLASS_ENUM_MAP(NggSubgroupSizingType, OptimizeForVerts)
     ADD_CLASS_ENUM_MAP(NggSubgroupSizingType, OptimizeForPrims)
     ADD_CLASS_ENUM_MAP(NggSubgroupSizingType, Explicit)
+    ADD_CLASS_ENUM_MAP(NggSubgroupSizingType, Adaptive)
 
     ADD_ENUM_MAP(NggCompactMode, NggCompactDisable)
     ADD_ENUM_MAP(NggCompactMode, NggCompactVertices)
@@ -91,9 +92,18 @@ public:
     ADD_CLASS_ENUM_MAP(ShadowDescriptorTableUsage, Enable)
     ADD_CLASS_ENUM_MAP(ShadowDescriptorTableUsage, Disable)
 
+    ADD_CLASS_ENUM_MAP(WaveSizeHeuristic, Disable)
+    ADD_CLASS_ENUM_MAP(WaveSizeHeuristic, Auto)
+    ADD_CLASS_ENUM_MAP(WaveSizeHeuristic, Gfx10)
+    ADD_CLASS_ENUM_MAP(WaveSizeHeuristic, Gfx103)
+
     ADD_CLASS_ENUM_MAP(DenormalMode, Auto)
     ADD_CLASS_ENUM_MAP(DenormalMode, FlushToZero)
     ADD_CLASS_ENUM_MAP(DenormalMode, Preserve)
+
+    ADD_CLASS_ENUM_MAP(MathPrecision, Strict)
+    ADD_CLASS_ENUM_MAP(MathPrecision, Relaxed)
+    ADD_CLASS_ENUM_MAP(MathPrecision, Fast)
   }
 };
 
@@ -150,6 +150,7 @@ public:
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionShaderOption, disableLicmThreshold, MemberTypeInt, false);
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionShaderOption, unrollHintThreshold, MemberTypeInt, false);
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionShaderOption, dontUnrollHintThreshold, MemberTypeInt, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionShaderOption, mathPrecision, MemberTypeEnum, false);
 
     VFX_ASSERT(tableItem - &m_addrTable[0] <= MemberCount);
   }
@@ -158,7 +159,7 @@ public:
   SubState &getSubStateRef() { return m_state; };
 
 private:
-  static const unsigned MemberCount = 24;
+  static const unsigned MemberCount = 25;
   static StrToMemberAddr m_addrTable[MemberCount];
 
   SubState m_state;
@@ -344,6 +345,9 @@ public:
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionPipelineOption, shadowDescriptorTableUsage, MemberTypeEnum, false);
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionPipelineOption, shadowDescriptorTablePtrHigh, MemberTypeInt, false);
     INIT_MEMBER_NAME_TO_ADDR(SectionPipelineOption, m_extendedRobustness, MemberTypeExtendedRobustness, true);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionPipelineOption, waveSizeHeuristic, MemberTypeEnum, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionPipelineOption, groupWaterfallLoops, MemberTypeBool, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionPipelineOption, fastCompile, MemberTypeBool, false);
     VFX_ASSERT(tableItem - &m_addrTable[0] <= MemberCount);
   }
 
@@ -354,7 +358,7 @@ public:
   SubState &getSubStateRef() { return m_state; };
 
 private:
-  static const unsigned MemberCount = 9;
+  static const unsigned MemberCount = 12;
   static StrToMemberAddr m_addrTable[MemberCount];
 
   SubState m_state;
@@ -388,6 +392,10 @@ public:
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, subgroupSizing, MemberTypeEnum, false);
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, primsPerSubgroup, MemberTypeInt, false);
     INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, vertsPerSubgroup, MemberTypeInt, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, enableCullingHints, MemberTypeBool, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, primsPerDrawHint, MemberTypeInt, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, culledPrimPercentHint, MemberTypeInt, false);
+    INIT_STATE_MEMBER_NAME_TO_ADDR(SectionNggState, vertsPerPrimHint, MemberTypeInt, false);
 
     VFX_ASSERT(tableItem - &m_addrTable[0] <= MemberCount);
   }
@@ -396,7 +404,7 @@ public:
   SubState &getSubStateRef() { return m_state; };
 
 private:
-  static const unsigned MemberCount = 17;
+  static const unsigned MemberCount = 20;
   static StrToMemberAddr m_addrTable[MemberCount];
 
   SubState m_state;
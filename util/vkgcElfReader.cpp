@@ -39,6 +39,228 @@ using namespace llvm;
 
 namespace Vkgc {
 
+
+// =====================================================================================================================
+// Reads a big-endian unsigned integer of the given size.
+//
+// @param byteCount : Size in bytes
+// @param [out] value : The integer
+bool MsgPackCursor::readBigEndian(unsigned byteCount, uint64_t *value) {
+  if (static_cast<size_t>(m_end - m_pos) < byteCount)
+    return false;
+  *value = 0;
+  for (unsigned i = 0; i != byteCount; ++i)
+    *value = (*value << 8) | *m_pos++;
+  return true;
+}
+
+// =====================================================================================================================
+// Skips the given number of bytes.
+//
+// @param byteCount : Number of bytes
+bool MsgPackCursor::skip(uint64_t byteCount) {
+  if (static_cast<uint64_t>(m_end - m_pos) < byteCount)
+    return false;
+  m_pos += byteCount;
+  return true;
+}
+
+// =====================================================================================================================
+// Reads a map or array header.
+//
+// @param fixFormat : Format byte of the fixmap or fixarray form, with a zero size
+// @param format16 : Format byte of the map16 or array16 form; the 32-bit form is the one after it
+// @param [out] size : Number of items or elements
+bool MsgPackCursor::readContainerSize(uint8_t fixFormat, uint8_t format16, uint64_t *size) {
+  if (m_pos == m_end)
+    return false;
+  uint8_t format = *m_pos;
+  if ((format & 0xF0) == fixFormat) {
+    ++m_pos;
+    *size = format & 0x0F;
+    return true;
+  }
+  if (format != format16 && format != format16 + 1)
+    return false;
+  ++m_pos;
+  return readBigEndian(format == format16 ? 2 : 4, size);
+}
+
+// =====================================================================================================================
+// Reads a string.
+//
+// @param [out] str : The string, pointing into the blob
+bool MsgPackCursor::readString(StringRef *str) {
+  if (m_pos == m_end)
+    return false;
+  uint8_t format = *m_pos;
+  uint64_t length = 0;
+  if ((format & 0xE0) == 0xA0) {
+    ++m_pos;
+    length = format & 0x1F;
+  } else if (format >= 0xD9 && format <= 0xDB) {
+    ++m_pos;
+    if (!readBigEndian(1 << (format - 0xD9), &length))
+      return false;
+  } else
+    return false;
+  const uint8_t *start = m_pos;
+  if (!skip(length))
+    return false;
+  *str = StringRef(reinterpret_cast<const char *>(start), length);
+  return true;
+}
+
+// =====================================================================================================================
+// Reads an unsigned integer, in any of the forms that msgpack::Document decodes as unsigned.
+//
+// @param [out] value : The integer
+bool MsgPackCursor::readUInt(uint64_t *value) {
+  if (m_pos == m_end)
+    return false;
+  uint8_t format = *m_pos;
+  if (format <= 0x7F) {
+    ++m_pos;
+    *value = format;
+    return true;
+  }
+  if (format < 0xCC || format > 0xCF)
+    return false;
+  ++m_pos;
+  return readBigEndian(1 << (format - 0xCC), value);
+}
+
+// =====================================================================================================================
+// Reads a value of any type, giving its encoded bytes.
+//
+// @param [out] raw : The encoded value, pointing into the blob
+bool MsgPackCursor::readValue(StringRef *raw) {
+  const uint8_t *start = m_pos;
+  if (!skipValue())
+    return false;
+  *raw = StringRef(reinterpret_cast<const char *>(start), m_pos - start);
+  return true;
+}
+
+// =====================================================================================================================
+// Skips a value of any type, including all the items of a map or elements of an array.
+bool MsgPackCursor::skipValue() {
+  if (m_pos == m_end)
+    return false;
+  uint8_t format = *m_pos;
+  uint64_t size = 0;
+  StringRef str;
+
+  // Positive and negative fixint, nil, false and true.
+  if (format <= 0x7F || format >= 0xE0 || format == 0xC0 || format == 0xC2 || format == 0xC3)
+    return skip(1);
+  // Maps and arrays.
+  if ((format & 0xF0) == 0x80 || format == 0xDE || format == 0xDF) {
+    if (!readMapSize(&size))
+      return false;
+    size *= 2;
+  } else if ((format & 0xF0) == 0x90 || format == 0xDC || format == 0xDD) {
+    if (!readArraySize(&size))
+      return false;
+  } else if ((format & 0xE0) == 0xA0 || (format >= 0xD9 && format <= 0xDB))
+    return readString(&str);
+  else {
+    ++m_pos;
+    switch (format) {
+    case 0xC4: // bin 8, 16, 32
+    case 0xC5:
+    case 0xC6:
+      return readBigEndian(1 << (format - 0xC4), &size) && skip(size);
+    case 0xC7: // ext 8, 16, 32
+    case 0xC8:
+    case 0xC9:
+      return readBigEndian(1 << (format - 0xC7), &size) && skip(size + 1);
+    case 0xCA: // float 32, 64
+      return skip(4);
+    case 0xCB:
+      return skip(8);
+    case 0xCC: // uint 8, 16, 32, 64
+    case 0xCD:
+    case 0xCE:
+    case 0xCF:
+      return skip(1 << (format - 0xCC));
+    case 0xD0: // int 8, 16, 32, 64
+    case 0xD1:
+    case 0xD2:
+    case 0xD3:
+      return skip(1 << (format - 0xD0));
+    case 0xD4: // fixext 1, 2, 4, 8, 16
+    case 0xD5:
+    case 0xD6:
+    case 0xD7:
+    case 0xD8:
+      return skip(1 + (1 << (format - 0xD4)));
+    default:
+      return false;
+    }
+  }
+
+  for (uint64_t i = 0; i != size; ++i) {
+    if (!skipValue())
+      return false;
+  }
+  return true;
+}
+
+// =====================================================================================================================
+// Reads the header of a map, and the items up to the one whose key the given function accepts. On success, the cursor
+// is at the value of that item, and the rest of the map is unread.
+//
+// @param readKey : Function that reads a key, returning 1 if it is the one to find, 0 if not, and -1 on failure
+template <typename KeyReader> bool MsgPackCursor::findMapItemIf(KeyReader readKey) {
+  uint64_t size = 0;
+  if (!readMapSize(&size))
+    return false;
+  for (uint64_t i = 0; i != size; ++i) {
+    const uint8_t *keyPos = m_pos;
+    int found = readKey();
+    if (found > 0)
+      return true;
+    if (found < 0) {
+      // The key is of another type; skip it.
+      m_pos = keyPos;
+      if (!skipValue())
+        return false;
+    }
+    if (!skipValue())
+      return false;
+  }
+  return false;
+}
+
+// =====================================================================================================================
+// Reads the header of a string-keyed map, and the items up to the one with the given key. On success, the cursor is at
+// the value of that item.
+//
+// @param key : Key to find
+bool MsgPackCursor::findMapItem(StringRef key) {
+  return findMapItemIf([this, key]() {
+    StringRef itemKey;
+    if (!readString(&itemKey))
+      return -1;
+    return itemKey == key ? 1 : 0;
+  });
+}
+
+// =====================================================================================================================
+// Reads the header of a map with unsigned integer keys, such as the registers in PAL metadata, and the items up to the
+// one with the given key. On success, the cursor is at the value of that item.
+//
+// @param key : Key to find
+bool MsgPackCursor::findMapItem(uint64_t key) {
+  return findMapItemIf([this, key]() {
+    uint64_t itemKey = 0;
+    if (!readUInt(&itemKey))
+      return -1;
+    return itemKey == key ? 1 : 0;
+  });
+}
+
 // =====================================================================================================================
 //
 // @param gfxIp : Graphics IP version info
@@ -131,6 +353,17 @@ template <class Elf> Result ElfReader<Elf>::ReadFromBuffer(const void *buffer, s
       }
     }
 
+    // Sort the sections by name once, for getSectionDataBySortingIndex.
+    std::vector<const llvm::StringMapEntry<uint32_t> *> sortedEntries;
+    sortedEntries.reserve(m_map.size());
+    for (const auto &entry : m_map)
+      sortedEntries.push_back(&entry);
+    std::sort(sortedEntries.begin(), sortedEntries.end(),
+              [](const auto *lhs, const auto *rhs) { return lhs->getKey() < rhs->getKey(); });
+    m_sortedSections.clear();
+    for (const auto *entry : sortedEntries)
+      m_sortedSections.push_back(entry->getValue());
+
     *bufSize = readSize;
   }
 
@@ -242,7 +475,7 @@ Result ElfReader<Elf>::getSectionDataBySectionIndex(unsigned secIdx, SectionBuff
 }
 
 // =====================================================================================================================
-// Gets section data by sorting index (ordered map).
+// Gets section data by sorting index (the index of the section in the order of section names).
 //
 // @param sortIdx : Sorting index
 // @param [out] secIdx : Section index
@@ -251,12 +484,9 @@ template <class Elf>
 Result ElfReader<Elf>::getSectionDataBySortingIndex(unsigned sortIdx, unsigned *secIdx,
                                                     SectionBuffer **ppSectionData) const {
   Result result = Result::ErrorInvalidValue;
-  if (sortIdx < m_sections.size()) {
-    auto it = m_map.begin();
-    for (unsigned i = 0; i < sortIdx; ++i)
-      ++it;
-    *secIdx = it->second;
-    *ppSectionData = m_sections[it->second];
+  if (sortIdx < m_sortedSections.size()) {
+    *secIdx = m_sortedSections[sortIdx];
+    *ppSectionData = m_sections[*secIdx];
     result = Result::Success;
   }
   return result;
@@ -321,7 +551,7 @@ template <class Elf> bool ElfReader<Elf>::isValidSymbol(const char *symbolName)
 //
 // @param noteType : Note type
 template <class Elf> ElfNote ElfReader<Elf>::getNote(uint32_t noteType) const {
-  unsigned noteSecIdx = m_map.at(NoteName);
+  unsigned noteSecIdx = m_map.lookup(NoteName);
   assert(noteSecIdx > 0);
 
   auto noteSection = m_sections[noteSecIdx];
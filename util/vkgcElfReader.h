@@ -34,6 +34,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include "llvm/ADT/StringMap.h"
 #include "llvm/BinaryFormat/MsgPackDocument.h"
 
 #include "g_palPipelineAbiMetadata.h"
@@ -391,6 +392,41 @@ struct MsgPackIterator {
   llvm::msgpack::DocNode *node;                            // Current node
 };
 
+// =====================================================================================================================
+// Streaming reader of a msgpack blob, for querying PAL metadata without decoding it into a msgpack::Document. It does
+// not allocate: it finds the extent of each value, and only decodes the map and array sizes, strings and unsigned
+// integers that are asked for. Strings and raw values point into the blob.
+class MsgPackCursor {
+public:
+  MsgPackCursor(llvm::StringRef blob) : m_pos(blob.bytes_begin()), m_end(blob.bytes_end()) {}
+
+  // Reads a map header, giving the number of items
+  bool readMapSize(uint64_t *size) { return readContainerSize(0x80, 0xDE, size); }
+
+  // Reads an array header, giving the number of elements
+  bool readArraySize(uint64_t *size) { return readContainerSize(0x90, 0xDC, size); }
+
+  bool readString(llvm::StringRef *str);
+  bool readUInt(uint64_t *value);
+  bool readValue(llvm::StringRef *raw);
+  bool skipValue();
+
+  bool findMapItem(llvm::StringRef key);
+  bool findMapItem(uint64_t key);
+
+  // Gets the rest of the blob
+  llvm::StringRef getRest() const { return llvm::StringRef(reinterpret_cast<const char *>(m_pos), m_end - m_pos); }
+
+private:
+  bool readContainerSize(uint8_t fixFormat, uint8_t format16, uint64_t *size);
+  bool readBigEndian(unsigned byteCount, uint64_t *value);
+  bool skip(uint64_t byteCount);
+  template <typename KeyReader> bool findMapItemIf(KeyReader readKey);
+
+  const uint8_t *m_pos; // Current position
+  const uint8_t *m_end; // End of the blob
+};
+
 // =====================================================================================================================
 // Represents a reader for loading data from an [Executable and Linkable Format (ELF)] buffer.
 //
@@ -435,6 +471,13 @@ public:
 
   ElfNote getNote(uint32_t noteType) const;
 
+  // Gets a cursor on the PAL metadata, for looking up a few of its values without decoding it
+  MsgPackCursor getPalMetadataCursor() const {
+    ElfNote note = getNote(Util::Abi::MetadataNoteType);
+    return MsgPackCursor(
+        llvm::StringRef(reinterpret_cast<const char *>(note.data), note.data ? note.hdr.descSize : 0));
+  }
+
   // Gets all associated symbols by section index.
   // NOTE: Do not change the name or API of this method as it is used by AMD internal code and we need to
   // maintain compatibility.
@@ -463,7 +506,7 @@ public:
 
   const typename Elf::FormatHeader &getHeader() const { return m_header; }
 
-  const std::map<std::string, uint32_t> &getMap() const { return m_map; }
+  const llvm::StringMap<uint32_t> &getMap() const { return m_map; }
 
   const std::vector<SectionBuffer *> &getSections() const { return m_sections; }
 
@@ -482,7 +525,8 @@ private:
   GfxIpVersion m_gfxIp; // Graphics IP version info (used by ELF dump only)
 
   typename Elf::FormatHeader m_header;     // ELF header
-  std::map<std::string, uint32_t> m_map;   // Map between section name and section index
+  llvm::StringMap<uint32_t> m_map;         // Map between section name and section index
+  std::vector<uint32_t> m_sortedSections;  // Indices of the sections in m_map, sorted by section name
   std::vector<SectionBuffer *> m_sections; // List of section data and headers
 
   int32_t m_symSecIdx;    // Index of symbol section